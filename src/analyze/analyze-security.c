@@ -28,6 +28,9 @@
 #include "unit-def.h"
 #include "unit-name.h"
 
+/* How many GetAll() requests to have in flight at the same time when analyzing all units */
+#define SECURITY_INFO_PIPELINE_MAX 32U
+
 struct security_info {
         char *id;
         char *type;
@@ -1951,7 +1954,12 @@ static int property_read_device_allow(
         return sd_bus_message_exit_container(m);
 }
 
-static int acquire_security_info(sd_bus *bus, const char *name, struct security_info *info, AnalyzeSecurityFlags flags) {
+static int acquire_security_info(
+                sd_bus *bus,
+                const char *name,
+                sd_bus_message *reply, /* GetAll() reply for the unit if already acquired, NULL otherwise */
+                struct security_info *info,
+                AnalyzeSecurityFlags flags) {
 
         static const struct bus_properties_map security_map[] = {
                 { "AmbientCapabilities",     "t",       NULL,                                    offsetof(struct security_info, ambient_capabilities)      },
@@ -2014,19 +2022,29 @@ static int acquire_security_info(sd_bus *bus, const char *name, struct security_
         assert(name);
         assert(info);
 
-        path = unit_dbus_path_from_name(name);
-        if (!path)
-                return log_oom();
+        if (reply) {
+                if (sd_bus_message_is_method_error(reply, NULL)) {
+                        (void) sd_bus_error_copy(&error, sd_bus_message_get_error(reply));
+                        r = -sd_bus_message_get_errno(reply);
+                } else
+                        r = bus_message_map_all_properties(reply, security_map,
+                                                           BUS_MAP_STRDUP | BUS_MAP_BOOLEAN_AS_BOOL,
+                                                           &error, info);
+        } else {
+                path = unit_dbus_path_from_name(name);
+                if (!path)
+                        return log_oom();
 
-        r = bus_map_all_properties(
-                        bus,
-                        "org.freedesktop.systemd1",
-                        path,
-                        security_map,
-                        BUS_MAP_STRDUP | BUS_MAP_BOOLEAN_AS_BOOL,
-                        &error,
-                        NULL,
-                        info);
+                r = bus_map_all_properties(
+                                bus,
+                                "org.freedesktop.systemd1",
+                                path,
+                                security_map,
+                                BUS_MAP_STRDUP | BUS_MAP_BOOLEAN_AS_BOOL,
+                                &error,
+                                NULL,
+                                info);
+        }
         if (r < 0)
                 return log_error_errno(r, "Failed to get unit properties: %s", bus_error_message(&error, r));
 
@@ -2075,7 +2093,13 @@ static int acquire_security_info(sd_bus *bus, const char *name, struct security_
         return 0;
 }
 
-static int analyze_security_one(sd_bus *bus, const char *name, Table *overview_table, AnalyzeSecurityFlags flags) {
+static int analyze_security_one(
+                sd_bus *bus,
+                const char *name,
+                sd_bus_message *reply,
+                Table *overview_table,
+                AnalyzeSecurityFlags flags) {
+
         _cleanup_(security_info_free) struct security_info info = {
                 .default_dependencies = true,
                 .capability_bounding_set = UINT64_MAX,
@@ -2087,7 +2111,7 @@ static int analyze_security_one(sd_bus *bus, const char *name, Table *overview_t
         assert(bus);
         assert(name);
 
-        r = acquire_security_info(bus, name, &info, flags);
+        r = acquire_security_info(bus, name, reply, &info, flags);
         if (r == -EMEDIUMTYPE) /* Ignore this one because not loaded or Type is oneshot */
                 return 0;
         if (r < 0)
@@ -2100,6 +2124,100 @@ static int analyze_security_one(sd_bus *bus, const char *name, Table *overview_t
         return 0;
 }
 
+static int on_security_info_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        sd_bus_message **reply = userdata;
+
+        assert(m);
+        assert(reply);
+
+        *reply = sd_bus_message_ref(m);
+        return 0;
+}
+
+static int analyze_security_list(sd_bus *bus, char **units, Table *overview_table, AnalyzeSecurityFlags flags) {
+        _cleanup_free_ sd_bus_message **replies = NULL;
+        _cleanup_free_ sd_bus_slot **slots = NULL;
+        size_t n, next_send = 0, next_done = 0;
+        int r, ret = 0;
+
+        assert(bus);
+
+        /* Analyzes all specified units, but unlike calling analyze_security_one() for each, keeps up to
+         * SECURITY_INFO_PIPELINE_MAX GetAll() requests in flight at any time, so that we don't pay a full
+         * bus round trip per unit. The units are still assessed, and hence shown, in order. Returns the
+         * first error encountered. */
+
+        n = strv_length(units);
+        replies = new0(sd_bus_message*, n);
+        slots = new0(sd_bus_slot*, n);
+        if (!replies || !slots)
+                return log_oom();
+
+        while (next_done < n) {
+                while (next_send < n && next_send - next_done < SECURITY_INFO_PIPELINE_MAX) {
+                        _cleanup_free_ char *path = NULL;
+
+                        path = unit_dbus_path_from_name(units[next_send]);
+                        if (!path) {
+                                r = log_oom();
+                                goto finish;
+                        }
+
+                        r = sd_bus_call_method_async(
+                                        bus,
+                                        slots + next_send,
+                                        "org.freedesktop.systemd1",
+                                        path,
+                                        "org.freedesktop.DBus.Properties",
+                                        "GetAll",
+                                        on_security_info_reply,
+                                        replies + next_send,
+                                        "s", "");
+                        if (r < 0) {
+                                log_error_errno(r, "Failed to issue GetAll() call for %s: %m", units[next_send]);
+                                goto finish;
+                        }
+
+                        next_send++;
+                }
+
+                if (replies[next_done]) {
+                        r = analyze_security_one(bus, units[next_done], replies[next_done], overview_table, flags);
+                        if (r < 0 && ret >= 0)
+                                ret = r;
+
+                        replies[next_done] = sd_bus_message_unref(replies[next_done]);
+                        slots[next_done] = sd_bus_slot_unref(slots[next_done]);
+                        next_done++;
+                        continue;
+                }
+
+                r = sd_bus_process(bus, NULL);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to process bus: %m");
+                        goto finish;
+                }
+                if (r > 0)
+                        continue;
+
+                r = sd_bus_wait(bus, UINT64_MAX);
+                if (r < 0) {
+                        log_error_errno(r, "Failed to wait for bus: %m");
+                        goto finish;
+                }
+        }
+
+        r = ret;
+
+finish:
+        for (size_t i = 0; i < n; i++) {
+                sd_bus_slot_unref(slots[i]);
+                sd_bus_message_unref(replies[i]);
+        }
+
+        return r;
+}
+
 int analyze_security(sd_bus *bus, char **units, AnalyzeSecurityFlags flags) {
         _cleanup_(table_unrefp) Table *overview_table = NULL;
         int ret = 0, r;
@@ -2117,7 +2235,6 @@ int analyze_security(sd_bus *bus, char **units, AnalyzeSecurityFlags flags) {
                 _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
                 _cleanup_strv_free_ char **list = NULL;
                 size_t n = 0;
-                char **i;
 
                 r = sd_bus_call_method(
                                 bus,
@@ -2163,11 +2280,7 @@ int analyze_security(sd_bus *bus, char **units, AnalyzeSecurityFlags flags) {
 
                 flags |= ANALYZE_SECURITY_SHORT|ANALYZE_SECURITY_ONLY_LOADED|ANALYZE_SECURITY_ONLY_LONG_RUNNING;
 
-                STRV_FOREACH(i, list) {
-                        r = analyze_security_one(bus, *i, overview_table, flags);
-                        if (r < 0 && ret >= 0)
-                                ret = r;
-                }
+                ret = analyze_security_list(bus, list, overview_table, flags);
 
         } else {
                 char **i;
@@ -2199,7 +2312,7 @@ int analyze_security(sd_bus *bus, char **units, AnalyzeSecurityFlags flags) {
                         } else
                                 name = mangled;
 
-                        r = analyze_security_one(bus, name, overview_table, flags);
+                        r = analyze_security_one(bus, name, NULL, overview_table, flags);
                         if (r < 0 && ret >= 0)
                                 ret = r;
                 }
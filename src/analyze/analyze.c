@@ -31,6 +31,7 @@
 #include "format-table.h"
 #include "glob-util.h"
 #include "hashmap.h"
+#include "json.h"
 #include "locale-util.h"
 #include "log.h"
 #include "main-func.h"
@@ -590,6 +591,23 @@ static void svg_graph_box(double height, double begin, double end) {
         }
 }
 
+static void unit_times_clamp(UnitTimes *u, usec_t finish_time) {
+        assert(u);
+
+        /* Fill in the timestamps a unit didn't reach, and cut off everything after the end of the boot */
+
+        if (u->deactivated > u->activating &&
+            u->deactivated <= finish_time &&
+            u->activated == 0 && u->deactivating == 0)
+                u->activated = u->deactivating = u->deactivated;
+        if (u->activated < u->activating || u->activated > finish_time)
+                u->activated = finish_time;
+        if (u->deactivating < u->activated || u->deactivating > finish_time)
+                u->deactivating = finish_time;
+        if (u->deactivated < u->deactivating || u->deactivated > finish_time)
+                u->deactivated = finish_time;
+}
+
 static int plot_unit_times(UnitTimes *u, double width, int y) {
         char ts[FORMAT_TIMESPAN_MAX];
         bool b;
@@ -679,16 +697,7 @@ static int analyze_plot(int argc, char *argv[], void *userdata) {
                 if (text_width > text_start && text_width + text_start > width)
                         width = text_width + text_start;
 
-                if (u->deactivated > u->activating &&
-                    u->deactivated <= boot->finish_time &&
-                    u->activated == 0 && u->deactivating == 0)
-                        u->activated = u->deactivating = u->deactivated;
-                if (u->activated < u->activating || u->activated > boot->finish_time)
-                        u->activated = boot->finish_time;
-                if (u->deactivating < u->activated || u->deactivating > boot->finish_time)
-                        u->deactivating = boot->finish_time;
-                if (u->deactivated < u->deactivating || u->deactivated > boot->finish_time)
-                        u->deactivated = boot->finish_time;
+                unit_times_clamp(u, boot->finish_time);
                 m++;
         }
 
@@ -828,6 +837,177 @@ static int analyze_plot(int argc, char *argv[], void *userdata) {
         return 0;
 }
 
+static int trace_add_row(JsonVariant **events, uint64_t tid, const char *name) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        int r;
+
+        assert(events);
+        assert(name);
+
+        r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("name", JSON_BUILD_STRING("thread_name")),
+                                       JSON_BUILD_PAIR("ph", JSON_BUILD_STRING("M")),
+                                       JSON_BUILD_PAIR("pid", JSON_BUILD_UNSIGNED(1)),
+                                       JSON_BUILD_PAIR("tid", JSON_BUILD_UNSIGNED(tid)),
+                                       JSON_BUILD_PAIR("args", JSON_BUILD_OBJECT(
+                                                                       JSON_BUILD_PAIR("name", JSON_BUILD_STRING(name))))));
+        if (r < 0)
+                return r;
+
+        return json_variant_append_array(events, v);
+}
+
+static int trace_add_event(
+                JsonVariant **events,
+                uint64_t tid,
+                const char *name,
+                const char *category,
+                usec_t start,
+                usec_t end) {
+
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        int r;
+
+        assert(events);
+        assert(name);
+        assert(category);
+
+        if (end <= start)
+                return 0;
+
+        r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("name", JSON_BUILD_STRING(name)),
+                                       JSON_BUILD_PAIR("cat", JSON_BUILD_STRING(category)),
+                                       JSON_BUILD_PAIR("ph", JSON_BUILD_STRING("X")),
+                                       JSON_BUILD_PAIR("ts", JSON_BUILD_UNSIGNED(start)),
+                                       JSON_BUILD_PAIR("dur", JSON_BUILD_UNSIGNED(end - start)),
+                                       JSON_BUILD_PAIR("pid", JSON_BUILD_UNSIGNED(1)),
+                                       JSON_BUILD_PAIR("tid", JSON_BUILD_UNSIGNED(tid))));
+        if (r < 0)
+                return r;
+
+        return json_variant_append_array(events, v);
+}
+
+static int analyze_trace(int argc, char *argv[], void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *events = NULL, *v = NULL;
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
+        _cleanup_(unit_times_free_arrayp) UnitTimes *times = NULL;
+        bool use_full_bus = arg_scope == UNIT_FILE_SYSTEM;
+        uint64_t tid = 2;
+        BootTimes *boot;
+        usec_t o;
+        int n, r;
+
+        /* Like "plot", but in the Trace Event Format understood by chrome://tracing and similar tools: the
+         * boot phases and the manager's own phases on the first row, each unit on a row of its own. */
+
+        r = acquire_bus(&bus, &use_full_bus);
+        if (r < 0)
+                return bus_log_connect_error(r);
+
+        n = acquire_boot_times(bus, &boot);
+        if (n < 0)
+                return n;
+
+        n = acquire_time_data(bus, &times);
+        if (n <= 0)
+                return n;
+
+        typesafe_qsort(times, n, compare_unit_start);
+
+        /* The firmware and loader timestamps count backwards from the kernel start. Shift everything, so
+         * that the first event starts at 0. */
+        o = MAX(boot->firmware_time, boot->loader_time);
+
+        r = trace_add_row(&events, 1, "boot");
+        if (r < 0)
+                return log_oom();
+
+        if (boot->firmware_time > boot->loader_time) {
+                r = trace_add_event(&events, 1, "firmware", "boot", o - boot->firmware_time, o - boot->loader_time);
+                if (r < 0)
+                        return log_oom();
+        }
+        if (boot->loader_time > 0) {
+                r = trace_add_event(&events, 1, "loader", "boot", o - boot->loader_time, o);
+                if (r < 0)
+                        return log_oom();
+        }
+        if (boot->kernel_done_time > 0) {
+                r = trace_add_event(&events, 1, "kernel", "boot", o, o + boot->kernel_done_time);
+                if (r < 0)
+                        return log_oom();
+        }
+        if (boot->initrd_time > 0) {
+                r = trace_add_event(&events, 1, "initrd", "boot", o + boot->initrd_time, o + boot->userspace_time);
+                if (r < 0)
+                        return log_oom();
+                r = trace_add_event(&events, 1, "security", "manager",
+                                    o + boot->initrd_security_start_time, o + boot->initrd_security_finish_time);
+                if (r < 0)
+                        return log_oom();
+                r = trace_add_event(&events, 1, "generators", "manager",
+                                    o + boot->initrd_generators_start_time, o + boot->initrd_generators_finish_time);
+                if (r < 0)
+                        return log_oom();
+                r = trace_add_event(&events, 1, "unitsload", "manager",
+                                    o + boot->initrd_unitsload_start_time, o + boot->initrd_unitsload_finish_time);
+                if (r < 0)
+                        return log_oom();
+        }
+
+        r = trace_add_event(&events, 1, "systemd", "boot", o + boot->userspace_time, o + boot->finish_time);
+        if (r < 0)
+                return log_oom();
+        if (boot->security_start_time > 0) {
+                r = trace_add_event(&events, 1, "security", "manager",
+                                    o + boot->security_start_time, o + boot->security_finish_time);
+                if (r < 0)
+                        return log_oom();
+        }
+        r = trace_add_event(&events, 1, "generators", "manager",
+                            o + boot->generators_start_time, o + boot->generators_finish_time);
+        if (r < 0)
+                return log_oom();
+        r = trace_add_event(&events, 1, "unitsload", "manager",
+                            o + boot->unitsload_start_time, o + boot->unitsload_finish_time);
+        if (r < 0)
+                return log_oom();
+
+        for (UnitTimes *u = times; u->has_data; u++) {
+                if (u->activating > boot->finish_time)
+                        continue;
+
+                unit_times_clamp(u, boot->finish_time);
+
+                r = trace_add_row(&events, tid, u->name);
+                if (r < 0)
+                        return log_oom();
+
+                r = trace_add_event(&events, tid, "activating", "unit", o + u->activating, o + u->activated);
+                if (r < 0)
+                        return log_oom();
+                r = trace_add_event(&events, tid, "active", "unit", o + u->activated, o + u->deactivating);
+                if (r < 0)
+                        return log_oom();
+                r = trace_add_event(&events, tid, "deactivating", "unit", o + u->deactivating, o + u->deactivated);
+                if (r < 0)
+                        return log_oom();
+
+                tid++;
+        }
+
+        r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("traceEvents", JSON_BUILD_VARIANT(events)),
+                                       JSON_BUILD_PAIR("displayTimeUnit", JSON_BUILD_STRING("ms"))));
+        if (r < 0)
+                return log_oom();
+
+        json_variant_dump(v, JSON_FORMAT_NEWLINE, stdout, NULL);
+        return 0;
+}
+
 static int list_dependencies_print(
                 const char *name,
                 unsigned level,
@@ -2183,6 +2363,7 @@ static int help(int argc, char *argv[], void *userdata) {
                "  blame                    Print list of running units ordered by time to init\n"
                "  critical-chain [UNIT...] Print a tree of the time critical chain of units\n"
                "  plot                     Output SVG graphic showing service initialization\n"
+               "  trace                    Output service initialization in Trace Event Format\n"
                "  dot [UNIT...]            Output dependency graph in %s format\n"
                "  dump                     Output state serialization of service manager\n"
                "  cat-config               Show configuration file and drop-ins\n"
@@ -2397,6 +2578,7 @@ static int run(int argc, char *argv[]) {
                 { "blame",             VERB_ANY, 1,        0,            analyze_blame          },
                 { "critical-chain",    VERB_ANY, VERB_ANY, 0,            analyze_critical_chain },
                 { "plot",              VERB_ANY, 1,        0,            analyze_plot           },
+                { "trace",             VERB_ANY, 1,        0,            analyze_trace          },
                 { "dot",               VERB_ANY, VERB_ANY, 0,            dot                    },
                 /* The following seven verbs are deprecated */
                 { "log-level",         VERB_ANY, 2,        0,            get_or_set_log_level   },
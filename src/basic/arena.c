@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "memory-util.h"
+
+/* Allocations larger than this get a block of their own, so that they don't waste the rest of the
+ * current block */
+#define ARENA_BLOCK_SIZE (16U*1024U)
+#define ARENA_LARGE_SIZE (ARENA_BLOCK_SIZE / 4U)
+
+/* max_align_t is C11, hence approximate it */
+typedef union ArenaAlign {
+        long double ld;
+        uint64_t u;
+        void *p;
+} ArenaAlign;
+
+struct ArenaBlock {
+        ArenaBlock *next;
+        size_t size;
+        size_t used;
+        _alignas_(ArenaAlign) uint8_t data[];
+};
+
+static ArenaBlock* arena_block_new(size_t size) {
+        ArenaBlock *b;
+
+        if (size > SIZE_MAX - sizeof(ArenaBlock))
+                return NULL;
+
+        b = malloc(sizeof(ArenaBlock) + size);
+        if (!b)
+                return NULL;
+
+        *b = (ArenaBlock) {
+                .size = size,
+        };
+
+        return b;
+}
+
+void* arena_alloc(Arena *a, size_t size) {
+        ArenaBlock *b;
+
+        assert(a);
+
+        size = ALIGN_TO(MAX(size, 1U), __alignof(ArenaAlign));
+        if (size == 0) /* overflow */
+                return NULL;
+
+        b = a->blocks;
+        if (b && b->size - b->used >= size) {
+                void *p = b->data + b->used;
+
+                b->used += size;
+                return p;
+        }
+
+        if (size > ARENA_LARGE_SIZE) {
+                b = arena_block_new(size);
+                if (!b)
+                        return NULL;
+
+                b->used = size;
+
+                /* Put it behind the current block, so that the space left in that one can still be used */
+                if (a->blocks) {
+                        b->next = a->blocks->next;
+                        a->blocks->next = b;
+                } else
+                        a->blocks = b;
+
+                return b->data;
+        }
+
+        b = arena_block_new(ARENA_BLOCK_SIZE);
+        if (!b)
+                return NULL;
+
+        b->used = size;
+        b->next = a->blocks;
+        a->blocks = b;
+
+        return b->data;
+}
+
+void* arena_alloc0(Arena *a, size_t size) {
+        void *p;
+
+        p = arena_alloc(a, size);
+        if (!p)
+                return NULL;
+
+        memzero(p, size);
+        return p;
+}
+
+void* arena_memdup(Arena *a, const void *p, size_t l) {
+        void *q;
+
+        assert(p || l == 0);
+
+        q = arena_alloc(a, l);
+        if (!q)
+                return NULL;
+
+        return memcpy_safe(q, p, l);
+}
+
+char* arena_strndup(Arena *a, const char *s, size_t l) {
+        char *t;
+
+        assert(s);
+
+        l = strnlen(s, l);
+
+        t = arena_alloc(a, l + 1);
+        if (!t)
+                return NULL;
+
+        memcpy(t, s, l);
+        t[l] = 0;
+
+        return t;
+}
+
+static void arena_block_free_all(ArenaBlock *b) {
+        while (b) {
+                ArenaBlock *next = b->next;
+
+                free(b);
+                b = next;
+        }
+}
+
+void arena_reset(Arena *a) {
+        ArenaBlock *b;
+
+        assert(a);
+
+        b = a->blocks;
+        if (!b)
+                return;
+
+        /* Keep the current block for reuse, unless it is one of the oversized ones */
+        if (b->size > ARENA_BLOCK_SIZE) {
+                arena_done(a);
+                return;
+        }
+
+        arena_block_free_all(b->next);
+        b->next = NULL;
+        b->used = 0;
+}
+
+void arena_done(Arena *a) {
+        assert(a);
+
+        arena_block_free_all(a->blocks);
+        a->blocks = NULL;
+}
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+
+#include "macro.h"
+
+/* A simple region allocator, for many small allocations that all share the same lifetime. Memory is handed
+ * out from larger blocks, and is only released all at once, via arena_reset() or arena_done(). The first
+ * block is kept around by arena_reset(), so that an arena that is reset after each request doesn't need
+ * to call malloc() at all in the common case. Allocations are suitably aligned for any type. */
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+        ArenaBlock *blocks;
+} Arena;
+
+void* arena_alloc(Arena *a, size_t size);
+void* arena_alloc0(Arena *a, size_t size);
+void* arena_memdup(Arena *a, const void *p, size_t l);
+char* arena_strndup(Arena *a, const char *s, size_t l);
+
+static inline char* arena_strdup(Arena *a, const char *s) {
+        return arena_strndup(a, s, strlen(s));
+}
+
+void arena_reset(Arena *a);
+void arena_done(Arena *a);
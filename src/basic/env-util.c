@@ -10,15 +10,20 @@
 #include "env-util.h"
 #include "escape.h"
 #include "extract-word.h"
+#include "hashmap.h"
 #include "macro.h"
 #include "parse-util.h"
 #include "path-util.h"
 #include "process-util.h"
+#include "siphash24.h"
 #include "stdio-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "utf8.h"
 
+/* From how many entries on strv_env_merge() looks up variables via a hash table rather than by scanning */
+#define ENV_MERGE_INDEX_MIN 64U
+
 /* We follow bash for the character set. Different shells have different rules. */
 #define VALID_BASH_ENV_NAME_CHARS               \
         DIGITS LETTERS                          \
@@ -141,7 +146,28 @@ bool strv_env_name_or_assignment_is_valid(char **l) {
         return true;
 }
 
-static int env_append(char **r, char ***k, char **a) {
+/* Hashes and compares environment assignments by the variable name only, i.e. the part before the '=' */
+static void env_name_hash_func(const char *s, struct siphash *state) {
+        siphash24_compress(s, strcspn(s, "="), state);
+}
+
+static int env_name_compare_func(const char *a, const char *b) {
+        size_t n, m;
+        int r;
+
+        n = strcspn(a, "=");
+        m = strcspn(b, "=");
+
+        r = CMP(n, m);
+        if (r != 0)
+                return r;
+
+        return memcmp(a, b, n);
+}
+
+DEFINE_PRIVATE_HASH_OPS(env_name_hash_ops, char, env_name_hash_func, env_name_compare_func);
+
+static int env_append(char **r, char ***k, char **a, Hashmap *index) {
         assert(r);
         assert(k);
         assert(*k >= r);
@@ -154,19 +180,27 @@ static int env_append(char **r, char ***k, char **a) {
          *
          * This call adds every entry of 'a' to 'r', either overriding an existing matching entry, or appending to it.
          *
-         * This call assumes 'r' has enough pre-allocated space to grow by all of 'a''s items. */
+         * This call assumes 'r' has enough pre-allocated space to grow by all of 'a''s items.
+         *
+         * If 'index' is specified, it maps the entries of 'r' (by variable name) to their position in 'r',
+         * and is used and updated instead of scanning 'r' for each entry. This requires all entries to be
+         * proper assignments, i.e. to contain a '='. */
 
         for (; *a; a++) {
                 char **j, *c;
                 size_t n;
 
-                n = strcspn(*a, "=");
-                if ((*a)[n] == '=')
-                        n++;
+                if (index)
+                        j = hashmap_get(index, *a) ?: *k;
+                else {
+                        n = strcspn(*a, "=");
+                        if ((*a)[n] == '=')
+                                n++;
 
-                for (j = r; j < *k; j++)
-                        if (strneq(*j, *a, n))
-                                break;
+                        for (j = r; j < *k; j++)
+                                if (strneq(*j, *a, n))
+                                        break;
+                }
 
                 c = strdup(*a);
                 if (!c)
@@ -176,15 +210,29 @@ static int env_append(char **r, char ***k, char **a) {
                         (*k)[0] = c;
                         (*k)[1] = NULL;
                         (*k)++;
-                } else
+                } else {
+                        if (index)
+                                assert_se(hashmap_remove(index, *j) == j);
+
                         free_and_replace(*j, c); /* Override existing item */
+                }
+
+                if (index) {
+                        int q;
+
+                        q = hashmap_put(index, *j, j);
+                        if (q < 0)
+                                return q;
+                }
         }
 
         return 0;
 }
 
 char **strv_env_merge(size_t n_lists, ...) {
+        _cleanup_hashmap_free_ Hashmap *index = NULL;
         _cleanup_strv_free_ char **ret = NULL;
+        bool all_assignments = true;
         size_t n = 0;
         char **l, **k;
         va_list ap;
@@ -193,11 +241,28 @@ char **strv_env_merge(size_t n_lists, ...) {
 
         va_start(ap, n_lists);
         for (size_t i = 0; i < n_lists; i++) {
+                char **e;
+
                 l = va_arg(ap, char**);
                 n += strv_length(l);
+
+                STRV_FOREACH(e, l)
+                        if (!strchr(*e, '=')) {
+                                all_assignments = false;
+                                break;
+                        }
         }
         va_end(ap);
 
+        /* For large environments, scanning all entries collected so far for each entry to add gets
+         * expensive, i.e. O(n²). Use a hash table keyed by variable name then, which is possible as long as
+         * all entries are proper assignments (which is practically always the case). */
+        if (n >= ENV_MERGE_INDEX_MIN && all_assignments) {
+                index = hashmap_new(&env_name_hash_ops);
+                if (!index)
+                        return NULL;
+        }
+
         ret = new(char*, n+1);
         if (!ret)
                 return NULL;
@@ -208,7 +273,7 @@ char **strv_env_merge(size_t n_lists, ...) {
         va_start(ap, n_lists);
         for (size_t i = 0; i < n_lists; i++) {
                 l = va_arg(ap, char**);
-                if (env_append(ret, &k, l) < 0) {
+                if (env_append(ret, &k, l, index) < 0) {
                         va_end(ap);
                         return NULL;
                 }
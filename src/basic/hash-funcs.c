@@ -4,6 +4,38 @@
 
 #include "hash-funcs.h"
 #include "path-util.h"
+#include "unaligned.h"
+
+static uint64_t mum(uint64_t a, uint64_t b, uint64_t *ret_high) {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 r = (unsigned __int128) a * b;
+
+        *ret_high = (uint64_t) (r >> 64);
+        return (uint64_t) r;
+#else
+        uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t, lo;
+
+        t = rl + (rm0 << 32);
+        lo = t + (rm1 << 32);
+        *ret_high = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+        return lo;
+#endif
+}
+
+static uint64_t trusted_hash_u64(uint64_t v, const uint8_t k[static 16]) {
+        uint64_t a, b;
+
+        /* The 64bit integer mixing of wyhash: two full 64x64→128 multiplications, each folded back to 64
+         * bits. That's a couple of cycles, compared to the eight rounds SipHash needs for the same input.
+         * The table's key is mixed in, so that bucket layouts are still not predictable from the outside. */
+
+        a = mum(v ^ unaligned_read_le64(k) ^ UINT64_C(0xa0761d6478bd642f),
+                unaligned_read_le64(k + 8) ^ UINT64_C(0xe7037ed1a0b428db), &b);
+        a = mum(a ^ UINT64_C(0xa0761d6478bd642f), b ^ UINT64_C(0xe7037ed1a0b428db), &b);
+
+        return a ^ b;
+}
 
 void string_hash_func(const char *p, struct siphash *state) {
         siphash24_compress(p, strlen(p) + 1, state);
@@ -88,6 +120,16 @@ const struct hash_ops trivial_hash_ops_free_free = {
         .free_value = free,
 };
 
+uint64_t trivial_trusted_hash_func(const void *p, const uint8_t k[static 16]) {
+        return trusted_hash_u64((uint64_t) (uintptr_t) p, k);
+}
+
+const struct hash_ops trivial_hash_ops_trusted = {
+        .hash = trivial_hash_func,
+        .compare = trivial_compare_func,
+        .trusted_hash = trivial_trusted_hash_func,
+};
+
 void uint64_hash_func(const uint64_t *p, struct siphash *state) {
         siphash24_compress(p, sizeof(uint64_t), state);
 }
@@ -98,6 +140,16 @@ int uint64_compare_func(const uint64_t *a, const uint64_t *b) {
 
 DEFINE_HASH_OPS(uint64_hash_ops, uint64_t, uint64_hash_func, uint64_compare_func);
 
+uint64_t uint64_trusted_hash_func(const uint64_t *p, const uint8_t k[static 16]) {
+        return trusted_hash_u64(*p, k);
+}
+
+const struct hash_ops uint64_hash_ops_trusted = {
+        .hash = (hash_func_t) uint64_hash_func,
+        .compare = (compare_func_t) uint64_compare_func,
+        .trusted_hash = (trusted_hash_func_t) uint64_trusted_hash_func,
+};
+
 #if SIZEOF_DEV_T != 8
 void devt_hash_func(const dev_t *p, struct siphash *state) {
         siphash24_compress(p, sizeof(dev_t), state);
@@ -7,12 +7,19 @@
 
 typedef void (*hash_func_t)(const void *p, struct siphash *state);
 typedef int (*compare_func_t)(const void *a, const void *b);
+typedef uint64_t (*trusted_hash_func_t)(const void *p, const uint8_t k[static 16]);
 
 struct hash_ops {
         hash_func_t hash;
         compare_func_t compare;
         free_func_t free_key;
         free_func_t free_value;
+
+        /* If set, this is used instead of hash. It is a lot cheaper than SipHash, but provides no protection
+         * against collisions crafted by whoever picks the keys. Hence, only use this for tables whose keys
+         * we generate ourselves, e.g. serial numbers or our own object pointers, never for names, paths or
+         * anything else that may come from the outside. */
+        trusted_hash_func_t trusted_hash;
 };
 
 #define _DEFINE_HASH_OPS(uq, name, type, hash_func, compare_func, free_key_func, free_value_func, scope) \
@@ -92,11 +99,17 @@ extern const struct hash_ops trivial_hash_ops;
 extern const struct hash_ops trivial_hash_ops_free;
 extern const struct hash_ops trivial_hash_ops_free_free;
 
+/* Same as above, but using trusted_hash_func() for keys we picked ourselves, see above */
+uint64_t trivial_trusted_hash_func(const void *p, const uint8_t k[static 16]) _pure_;
+extern const struct hash_ops trivial_hash_ops_trusted;
+
 /* 32bit values we can always just embed in the pointer itself, but in order to support 32bit archs we need store 64bit
  * values indirectly, since they don't fit in a pointer. */
 void uint64_hash_func(const uint64_t *p, struct siphash *state);
 int uint64_compare_func(const uint64_t *a, const uint64_t *b) _pure_;
 extern const struct hash_ops uint64_hash_ops;
+uint64_t uint64_trusted_hash_func(const uint64_t *p, const uint8_t k[static 16]) _pure_;
+extern const struct hash_ops uint64_hash_ops_trusted;
 
 /* On some archs dev_t is 32bit, and on others 64bit. And sometimes it's 64bit on 32bit archs, and sometimes 32bit on
  * 64bit archs. Yuck! */
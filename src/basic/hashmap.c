@@ -336,11 +336,15 @@ static unsigned base_bucket_hash(HashmapBase *h, const void *p) {
         struct siphash state;
         uint64_t hash;
 
-        siphash24_init(&state, hash_key(h));
+        if (h->hash_ops->trusted_hash)
+                hash = h->hash_ops->trusted_hash(p, hash_key(h));
+        else {
+                siphash24_init(&state, hash_key(h));
 
-        h->hash_ops->hash(p, &state);
+                h->hash_ops->hash(p, &state);
 
-        hash = siphash24_finalize(&state);
+                hash = siphash24_finalize(&state);
+        }
 
         return (unsigned) (hash % n_buckets(h));
 }
@@ -494,12 +498,13 @@ static void bucket_move_entry(HashmapBase *h, struct swap_entries *swap,
         }
 }
 
+/* These are called for every bucket probed, hence avoid the division a modulo would need */
 static unsigned next_idx(HashmapBase *h, unsigned idx) {
-        return (idx + 1U) % n_buckets(h);
+        return idx + 1U < n_buckets(h) ? idx + 1U : 0;
 }
 
 static unsigned prev_idx(HashmapBase *h, unsigned idx) {
-        return (n_buckets(h) + idx - 1U) % n_buckets(h);
+        return idx > 0 ? idx - 1U : n_buckets(h) - 1U;
 }
 
 static void* entry_value(HashmapBase *h, struct hashmap_base_entry *e) {
@@ -1201,10 +1206,11 @@ static int resize_buckets(HashmapBase *h, unsigned entries_add) {
  */
 static unsigned base_bucket_scan(HashmapBase *h, unsigned idx, const void *key) {
         struct hashmap_base_entry *e;
-        unsigned dib, distance;
+        unsigned dib, distance, n = n_buckets(h);
         dib_raw_t *dibs = dib_raw_ptr(h);
+        compare_func_t compare = h->hash_ops->compare;
 
-        assert(idx < n_buckets(h));
+        assert(idx < n);
 
         for (distance = 0; ; distance++) {
                 if (dibs[idx] == DIB_RAW_FREE)
@@ -1215,12 +1221,14 @@ static unsigned base_bucket_scan(HashmapBase *h, unsigned idx, const void *key)
                 if (dib < distance)
                         return IDX_NIL;
                 if (dib == distance) {
+                        /* Callers commonly look up with the very pointer that was inserted, in which
+                         * case the key comparison can be skipped */
                         e = bucket_at(h, idx);
-                        if (h->hash_ops->compare(e->key, key) == 0)
+                        if (e->key == key || compare(e->key, key) == 0)
                                 return idx;
                 }
 
-                idx = next_idx(h, idx);
+                idx = idx + 1U < n ? idx + 1U : 0;
         }
 }
 #define bucket_scan(h, idx, key) base_bucket_scan(HASHMAP_BASE(h), idx, key)
@@ -595,27 +595,13 @@ static int log_do_header(
         return 0;
 }
 
-static int write_to_journal(
-                int level,
-                int error,
-                const char *file,
-                int line,
-                const char *func,
-                const char *object_field,
-                const char *object,
-                const char *extra_field,
-                const char *extra,
-                const char *buffer) {
-
-        char header[LINE_MAX];
+static int write_to_journal(const char *header, const char *buffer) {
         struct iovec iovec[4] = {};
         struct msghdr mh = {};
 
         if (journal_fd < 0)
                 return 0;
 
-        log_do_header(header, sizeof(header), level, error, file, line, func, object_field, object, extra_field, extra);
-
         iovec[0] = IOVEC_MAKE_STRING(header);
         iovec[1] = IOVEC_MAKE_STRING("MESSAGE=");
         iovec[2] = IOVEC_MAKE_STRING(buffer);
@@ -642,11 +628,17 @@ int log_dispatch_internal(
                 const char *extra,
                 char *buffer) {
 
+        char header[LINE_MAX];
+
         assert_raw(buffer);
 
         if (log_target == LOG_TARGET_NULL)
                 return -ERRNO_VALUE(error);
 
+        /* The journal header is the same for every line of a multi-line message, hence it is formatted
+         * lazily, and only once. */
+        header[0] = 0;
+
         /* Patch in LOG_DAEMON facility if necessary */
         if ((level & LOG_FACMASK) == 0)
                 level |= log_facility;
@@ -670,7 +662,11 @@ int log_dispatch_internal(
                                        LOG_TARGET_JOURNAL_OR_KMSG,
                                        LOG_TARGET_JOURNAL)) {
 
-                        k = write_to_journal(level, error, file, line, func, object_field, object, extra_field, extra, buffer);
+                        if (journal_fd >= 0 && header[0] == 0)
+                                log_do_header(header, sizeof(header), level, error, file, line, func,
+                                              object_field, object, extra_field, extra);
+
+                        k = write_to_journal(header, buffer);
                         if (k < 0 && k != -EAGAIN)
                                 log_close_journal();
                 }
@@ -7,7 +7,7 @@
  * priority. Insertion and removal are Θ(log n). Optionally, the caller can
  * provide a pointer to an index which will be kept up-to-date by the prioq.
  *
- * The underlying algorithm used in this implementation is a Heap.
+ * The underlying algorithm used in this implementation is a 4-ary Heap.
  */
 
 #include <errno.h>
@@ -64,83 +64,90 @@ int prioq_ensure_allocated(Prioq **q, compare_func_t compare_func) {
         return 0;
 }
 
-static void swap(Prioq *q, unsigned j, unsigned k) {
+/* Each node has this many children. Compared to a binary heap this halves the depth of the tree, and the
+ * children of a node are next to each other in memory, which is a lot more cache-friendly. */
+#define PRIOQ_ARITY 4U
+
+static void set_item(Prioq *q, unsigned k, const struct prioq_item *i) {
         assert(q);
-        assert(j < q->n_items);
         assert(k < q->n_items);
 
-        assert(!q->items[j].idx || *(q->items[j].idx) == j);
-        assert(!q->items[k].idx || *(q->items[k].idx) == k);
-
-        SWAP_TWO(q->items[j].data, q->items[k].data);
-        SWAP_TWO(q->items[j].idx, q->items[k].idx);
-
-        if (q->items[j].idx)
-                *q->items[j].idx = j;
-
-        if (q->items[k].idx)
-                *q->items[k].idx = k;
+        q->items[k] = *i;
+        if (i->idx)
+                *i->idx = k;
 }
 
+/* Both of the following move the item at idx to its place. Rather than swapping it with its parent or child
+ * on each level, the items in the way are moved by one level, and the item is only written once at the end. */
+
 static unsigned shuffle_up(Prioq *q, unsigned idx) {
+        struct prioq_item i;
+
         assert(q);
         assert(idx < q->n_items);
 
+        i = q->items[idx];
+
         while (idx > 0) {
                 unsigned k;
 
-                k = (idx-1)/2;
+                k = (idx - 1) / PRIOQ_ARITY;
 
-                if (q->compare_func(q->items[k].data, q->items[idx].data) <= 0)
+                if (q->compare_func(q->items[k].data, i.data) <= 0)
                         break;
 
-                swap(q, idx, k);
+                set_item(q, idx, q->items + k);
                 idx = k;
         }
 
+        set_item(q, idx, &i);
         return idx;
 }
 
 static unsigned shuffle_down(Prioq *q, unsigned idx) {
+        struct prioq_item i;
+
         assert(q);
+        assert(idx < q->n_items);
 
-        for (;;) {
-                unsigned j, k, s;
+        i = q->items[idx];
 
-                k = (idx+1)*2; /* right child */
-                j = k-1;       /* left child */
+        for (;;) {
+                unsigned j, s, end;
 
+                j = idx * PRIOQ_ARITY + 1; /* first child */
                 if (j >= q->n_items)
                         break;
 
-                if (q->compare_func(q->items[j].data, q->items[idx].data) < 0)
+                end = MIN(j + PRIOQ_ARITY, q->n_items);
 
-                        /* So our left child is smaller than we are, let's
-                         * remember this fact */
-                        s = j;
-                else
-                        s = idx;
+                /* Find the smallest child, and move it up if it is smaller than we are */
+                for (s = j++; j < end; j++)
+                        if (q->compare_func(q->items[j].data, q->items[s].data) < 0)
+                                s = j;
 
-                if (k < q->n_items &&
-                    q->compare_func(q->items[k].data, q->items[s].data) < 0)
-
-                        /* So our right child is smaller than we are, let's
-                         * remember this fact */
-                        s = k;
-
-                /* s now points to the smallest of the three items */
-
-                if (s == idx)
-                        /* No swap necessary, we're done */
+                if (q->compare_func(q->items[s].data, i.data) >= 0)
                         break;
 
-                swap(q, idx, s);
+                set_item(q, idx, q->items + s);
                 idx = s;
         }
 
+        set_item(q, idx, &i);
         return idx;
 }
 
+static void reshuffle_item(Prioq *q, unsigned idx) {
+        assert(q);
+        assert(idx < q->n_items);
+
+        /* An item either has to move up or down, or stays where it is. Only check the parent once. */
+        if (idx > 0 && q->compare_func(q->items[(idx - 1) / PRIOQ_ARITY].data, q->items[idx].data) > 0)
+                shuffle_up(q, idx);
+        else
+                shuffle_down(q, idx);
+}
+
 int prioq_put(Prioq *q, void *data, unsigned *idx) {
         struct prioq_item *i;
         unsigned k;
@@ -191,15 +198,10 @@ static void remove_item(Prioq *q, struct prioq_item *i) {
                  * this one, and reshuffle */
 
                 k = i - q->items;
-
-                i->data = l->data;
-                i->idx = l->idx;
-                if (i->idx)
-                        *i->idx = k;
                 q->n_items--;
 
-                k = shuffle_down(q, k);
-                shuffle_up(q, k);
+                set_item(q, k, l);
+                reshuffle_item(q, k);
         }
 }
 
@@ -245,7 +247,6 @@ int prioq_remove(Prioq *q, void *data, unsigned *idx) {
 
 int prioq_reshuffle(Prioq *q, void *data, unsigned *idx) {
         struct prioq_item *i;
-        unsigned k;
 
         assert(q);
 
@@ -253,9 +254,7 @@ int prioq_reshuffle(Prioq *q, void *data, unsigned *idx) {
         if (!i)
                 return 0;
 
-        k = i - q->items;
-        k = shuffle_down(q, k);
-        shuffle_up(q, k);
+        reshuffle_item(q, i - q->items);
         return 1;
 }
 
@@ -9,8 +9,6 @@
 #include "memory-util.h"
 #include "sigbus.h"
 
-#define SIGBUS_QUEUE_MAX 64
-
 static struct sigaction old_sigaction;
 static unsigned n_installed = 0;
 
@@ -22,7 +20,7 @@ static unsigned n_installed = 0;
 static void* volatile sigbus_queue[SIGBUS_QUEUE_MAX];
 static volatile sig_atomic_t n_sigbus_queue = 0;
 
-static void sigbus_push(void *addr) {
+void sigbus_push(void *addr) {
         assert(addr);
 
         /* Find a free place, increase the number of entries and leave, if we can */
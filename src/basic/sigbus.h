@@ -4,4 +4,7 @@
 void sigbus_install(void);
 void sigbus_reset(void);
 
+#define SIGBUS_QUEUE_MAX 64
+
 int sigbus_pop(void **ret);
+void sigbus_push(void *addr);
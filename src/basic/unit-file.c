@@ -235,6 +235,48 @@ bool lookup_paths_timestamp_hash_same(const LookupPaths *lp, uint64_t timestamp_
         return updated == timestamp_hash;
 }
 
+/* The values of the ids map are paths or unit names, and the key is usually the last component of the
+ * value. Hence, store key and value in a single allocation, with the key pointing into the value if
+ * possible, and placed right behind the value otherwise. Only the value is freed. On systems with many
+ * unit files this saves one allocation per name. */
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(unit_ids_hash_ops, char, string_hash_func, string_compare_func,
+                                              char, free);
+
+static int unit_ids_map_put(Hashmap **ids, const char *name, const char *dst) {
+        char *v, *e;
+        int r;
+
+        assert(ids);
+        assert(name);
+        assert(dst);
+
+        e = endswith(dst, name);
+        if (e && (e == dst || e[-1] == '/')) {
+                v = strdup(dst);
+                if (!v)
+                        return -ENOMEM;
+
+                e = v + (e - dst);
+        } else {
+                size_t n = strlen(dst), k = strlen(name);
+
+                v = new(char, n + 1 + k + 1);
+                if (!v)
+                        return -ENOMEM;
+
+                memcpy(v, dst, n + 1);
+                e = memcpy(v + n + 1, name, k + 1);
+        }
+
+        r = hashmap_ensure_put(ids, &unit_ids_hash_ops, e, v);
+        if (r < 0) {
+                free(v);
+                return r;
+        }
+
+        return 0;
+}
+
 int unit_file_build_name_map(
                 const LookupPaths *lp,
                 uint64_t *cache_timestamp_hash,
@@ -392,7 +434,7 @@ int unit_file_build_name_map(
                                 log_debug("%s: normal unit file: %s", __func__, dst);
                         }
 
-                        r = hashmap_put_strdup(&ids, de->d_name, dst);
+                        r = unit_ids_map_put(&ids, de->d_name, dst);
                         if (r < 0)
                                 return log_warning_errno(r, "Failed to add entry to hashmap (%s→%s): %m",
                                                          de->d_name, dst);
@@ -156,14 +156,21 @@ char *utf8_is_valid_n(const char *str, size_t len_bytes) {
 
         assert(str);
 
-        for (const char *p = str; len_bytes != SIZE_MAX ? (size_t) (p - str) < len_bytes : *p != '\0'; ) {
+        if (len_bytes == SIZE_MAX)
+                len_bytes = strlen(str);
+
+        for (const char *p = str, *e = str + len_bytes; p < e; ) {
                 int len;
 
-                if (_unlikely_(*p == '\0') && len_bytes != SIZE_MAX)
+                /* Skip over runs of plain ASCII quickly, they are always valid */
+                p += ascii_printable_span(p, e - p, 0, 0);
+                if (p >= e)
+                        break;
+
+                if (_unlikely_(*p == '\0'))
                         return NULL; /* embedded NUL */
 
-                len = utf8_encoded_valid_unichar(p,
-                                                 len_bytes != SIZE_MAX ? len_bytes - (p - str) : SIZE_MAX);
+                len = utf8_encoded_valid_unichar(p, e - p);
                 if (_unlikely_(len < 0))
                         return NULL; /* invalid character */
 
@@ -316,6 +323,43 @@ char *ascii_is_valid_n(const char *str, size_t len) {
         return (char*) str;
 }
 
+#define BYTES_ONES UINT64_C(0x0101010101010101)
+#define BYTES_HIGH UINT64_C(0x8080808080808080)
+
+/* Whether any of the bytes in x is zero, see "Bit Twiddling Hacks" */
+#define BYTES_HAS_ZERO(x) ((((x) - BYTES_ONES) & ~(x) & BYTES_HIGH) != 0)
+/* Whether any of the bytes in x is below n, for n <= 128 */
+#define BYTES_HAS_LESS(x, n) ((((x) - BYTES_ONES * (n)) & ~(x) & BYTES_HIGH) != 0)
+#define BYTES_HAS(x, c) BYTES_HAS_ZERO((x) ^ (BYTES_ONES * (uint8_t) (c)))
+
+size_t ascii_printable_span(const char *s, size_t n, char a, char b) {
+        const char *p = s, *e = s + n;
+
+        assert(s || n == 0);
+
+        /* Returns the length of the prefix of the first n bytes of s that consists of printable ASCII
+         * characters only, i.e. 0x20…0x7e, excluding a and b. Checks eight bytes at a time. */
+
+        for (; (size_t) (e - p) >= sizeof(uint64_t); p += sizeof(uint64_t)) {
+                uint64_t x;
+
+                memcpy(&x, p, sizeof(x));
+
+                if ((x & BYTES_HIGH) != 0 ||
+                    BYTES_HAS_LESS(x, ' ') ||
+                    BYTES_HAS(x, 0x7f) ||
+                    BYTES_HAS(x, a) ||
+                    BYTES_HAS(x, b))
+                        break;
+        }
+
+        for (; p < e; p++)
+                if ((unsigned char) *p < ' ' || (unsigned char) *p >= 0x7f || *p == a || *p == b)
+                        break;
+
+        return p - s;
+}
+
 /**
  * utf8_encode_unichar() - Encode single UCS-4 character as UTF-8
  * @out_utf8: output buffer of at least 4 bytes or NULL
@@ -1315,7 +1315,6 @@ static int monitor(int argc, char **argv, int (*dump)(sd_bus_message *m, FILE *f
 
                 if (m) {
                         dump(m, stdout);
-                        fflush(stdout);
 
                         if (sd_bus_message_is_signal(m, "org.freedesktop.DBus.Local", "Disconnected") > 0) {
                                 log_info("Connection terminated, exiting.");
@@ -1328,6 +1327,10 @@ static int monitor(int argc, char **argv, int (*dump)(sd_bus_message *m, FILE *f
                 if (r > 0)
                         continue;
 
+                /* Only flush once the queue is drained, so that bursts of messages are written in one go
+                 * instead of with one write() each. */
+                fflush(stdout);
+
                 r = sd_bus_wait(bus, UINT64_MAX);
                 if (r < 0)
                         return log_error_errno(r, "Failed to wait for bus: %m");
@@ -18,9 +18,12 @@
 #include "bpf-firewall.h"
 #include "bpf-program.h"
 #include "fd-util.h"
+#include "hashmap.h"
+#include "in-addr-util.h"
 #include "ip-address-access.h"
 #include "memory-util.h"
 #include "missing_syscall.h"
+#include "string-util.h"
 #include "unit.h"
 #include "strv.h"
 #include "virt.h"
@@ -35,6 +38,36 @@ enum {
         ACCESS_DENIED  = 2,
 };
 
+/* The LPM trie maps for one verdict. Units with identical address lists (typically many instances of the
+ * same template) share the maps, which are looked up by their contents. */
+struct BPFAccessMaps {
+        unsigned n_ref;
+        char *key;
+        int ipv4_map_fd;
+        int ipv6_map_fd;
+};
+
+static Hashmap *access_maps_by_key = NULL;
+
+static BPFAccessMaps* bpf_access_maps_free(BPFAccessMaps *m) {
+        if (!m)
+                return NULL;
+
+        if (m->key) {
+                (void) hashmap_remove_value(access_maps_by_key, m->key, m);
+                if (hashmap_isempty(access_maps_by_key))
+                        access_maps_by_key = hashmap_free(access_maps_by_key);
+        }
+
+        free(m->key);
+        safe_close(m->ipv4_map_fd);
+        safe_close(m->ipv6_map_fd);
+        return mfree(m);
+}
+
+DEFINE_PRIVATE_TRIVIAL_REF_UNREF_FUNC(BPFAccessMaps, bpf_access_maps, bpf_access_maps_free);
+DEFINE_TRIVIAL_CLEANUP_FUNC(BPFAccessMaps*, bpf_access_maps_unref);
+
 /* Compile instructions for one list of addresses, one direction and one specific verdict on matches. */
 
 static int add_lookup_instructions(
@@ -204,10 +237,8 @@ static int bpf_firewall_compile_bpf(
                 u->ip_accounting_egress_map_fd;
 
         access_enabled =
-                u->ipv4_allow_map_fd >= 0 ||
-                u->ipv6_allow_map_fd >= 0 ||
-                u->ipv4_deny_map_fd >= 0 ||
-                u->ipv6_deny_map_fd >= 0 ||
+                u->ip_allow_maps ||
+                u->ip_deny_maps ||
                 ip_allow_any ||
                 ip_deny_any;
 
@@ -233,26 +264,26 @@ static int bpf_firewall_compile_bpf(
                  * - Otherwise, access will be granted
                  */
 
-                if (u->ipv4_deny_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv4_deny_map_fd, ETH_P_IP, is_ingress, ACCESS_DENIED);
+                if (u->ip_deny_maps && u->ip_deny_maps->ipv4_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_deny_maps->ipv4_map_fd, ETH_P_IP, is_ingress, ACCESS_DENIED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv6_deny_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv6_deny_map_fd, ETH_P_IPV6, is_ingress, ACCESS_DENIED);
+                if (u->ip_deny_maps && u->ip_deny_maps->ipv6_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_deny_maps->ipv6_map_fd, ETH_P_IPV6, is_ingress, ACCESS_DENIED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv4_allow_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv4_allow_map_fd, ETH_P_IP, is_ingress, ACCESS_ALLOWED);
+                if (u->ip_allow_maps && u->ip_allow_maps->ipv4_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_allow_maps->ipv4_map_fd, ETH_P_IP, is_ingress, ACCESS_ALLOWED);
                         if (r < 0)
                                 return r;
                 }
 
-                if (u->ipv6_allow_map_fd >= 0) {
-                        r = add_lookup_instructions(p, u->ipv6_allow_map_fd, ETH_P_IPV6, is_ingress, ACCESS_ALLOWED);
+                if (u->ip_allow_maps && u->ip_allow_maps->ipv6_map_fd >= 0) {
+                        r = add_lookup_instructions(p, u->ip_allow_maps->ipv6_map_fd, ETH_P_IPV6, is_ingress, ACCESS_ALLOWED);
                         if (r < 0)
                                 return r;
                 }
@@ -405,21 +436,59 @@ static int bpf_firewall_add_access_items(
         return 0;
 }
 
+static int bpf_firewall_access_maps_key(Unit *u, int verdict, char **ret) {
+        _cleanup_free_ char *key = NULL;
+        IPAddressAccessItem *a;
+        Unit *p;
+        int r;
+
+        assert(ret);
+
+        /* The maps are filled with the lists of the unit and all its slices, hence that's what the key is
+         * made of. */
+
+        key = strdup(verdict == ACCESS_ALLOWED ? "allow" : "deny");
+        if (!key)
+                return -ENOMEM;
+
+        for (p = u; p; p = UNIT_GET_SLICE(p)) {
+                CGroupContext *cc;
+
+                cc = unit_get_cgroup_context(p);
+                if (!cc)
+                        continue;
+
+                LIST_FOREACH(items, a, verdict == ACCESS_ALLOWED ? cc->ip_address_allow : cc->ip_address_deny) {
+                        _cleanup_free_ char *s = NULL;
+
+                        r = in_addr_prefix_to_string(a->family, &a->address, a->prefixlen, &s);
+                        if (r < 0)
+                                return r;
+
+                        if (!strextend(&key, " ", s))
+                                return -ENOMEM;
+                }
+        }
+
+        *ret = TAKE_PTR(key);
+        return 0;
+}
+
 static int bpf_firewall_prepare_access_maps(
                 Unit *u,
                 int verdict,
-                int *ret_ipv4_map_fd,
-                int *ret_ipv6_map_fd,
+                BPFAccessMaps **ret_maps,
                 bool *ret_has_any) {
 
+        _cleanup_(bpf_access_maps_unrefp) BPFAccessMaps *m = NULL;
         _cleanup_close_ int ipv4_map_fd = -1, ipv6_map_fd = -1;
+        _cleanup_free_ char *key = NULL;
         size_t n_ipv4 = 0, n_ipv6 = 0;
         IPAddressAccessItem *list;
         Unit *p;
         int r;
 
-        assert(ret_ipv4_map_fd);
-        assert(ret_ipv6_map_fd);
+        assert(ret_maps);
         assert(ret_has_any);
 
         for (p = u; p; p = UNIT_GET_SLICE(p)) {
@@ -441,6 +510,23 @@ static int bpf_firewall_prepare_access_maps(
                 }
         }
 
+        if (n_ipv4 == 0 && n_ipv6 == 0) {
+                *ret_maps = NULL;
+                *ret_has_any = false;
+                return 0;
+        }
+
+        r = bpf_firewall_access_maps_key(u, verdict, &key);
+        if (r < 0)
+                return r;
+
+        m = hashmap_get(access_maps_by_key, key);
+        if (m) {
+                *ret_maps = bpf_access_maps_ref(TAKE_PTR(m));
+                *ret_has_any = false;
+                return 0;
+        }
+
         if (n_ipv4 > 0) {
                 ipv4_map_fd = bpf_map_new(
                                 BPF_MAP_TYPE_LPM_TRIE,
@@ -476,8 +562,23 @@ static int bpf_firewall_prepare_access_maps(
                         return r;
         }
 
-        *ret_ipv4_map_fd = TAKE_FD(ipv4_map_fd);
-        *ret_ipv6_map_fd = TAKE_FD(ipv6_map_fd);
+        m = new(BPFAccessMaps, 1);
+        if (!m)
+                return -ENOMEM;
+
+        *m = (BPFAccessMaps) {
+                .n_ref = 1,
+                .ipv4_map_fd = TAKE_FD(ipv4_map_fd),
+                .ipv6_map_fd = TAKE_FD(ipv6_map_fd),
+        };
+
+        r = hashmap_ensure_put(&access_maps_by_key, &string_hash_ops, key, m);
+        if (r < 0)
+                return r;
+
+        m->key = TAKE_PTR(key);
+
+        *ret_maps = TAKE_PTR(m);
         *ret_has_any = false;
         return 0;
 }
@@ -550,11 +651,8 @@ int bpf_firewall_compile(Unit *u) {
         u->ip_bpf_ingress = bpf_program_unref(u->ip_bpf_ingress);
         u->ip_bpf_egress = bpf_program_unref(u->ip_bpf_egress);
 
-        u->ipv4_allow_map_fd = safe_close(u->ipv4_allow_map_fd);
-        u->ipv4_deny_map_fd = safe_close(u->ipv4_deny_map_fd);
-
-        u->ipv6_allow_map_fd = safe_close(u->ipv6_allow_map_fd);
-        u->ipv6_deny_map_fd = safe_close(u->ipv6_deny_map_fd);
+        u->ip_allow_maps = bpf_access_maps_unref(u->ip_allow_maps);
+        u->ip_deny_maps = bpf_access_maps_unref(u->ip_deny_maps);
 
         if (u->type != UNIT_SLICE) {
                 /* In inner nodes we only do accounting, we do not actually bother with access control. However, leaf
@@ -563,11 +661,11 @@ int bpf_firewall_compile(Unit *u) {
                  * means that all configure IP access rules *will* take effect on processes, even though we never
                  * compile them for inner nodes. */
 
-                r = bpf_firewall_prepare_access_maps(u, ACCESS_ALLOWED, &u->ipv4_allow_map_fd, &u->ipv6_allow_map_fd, &ip_allow_any);
+                r = bpf_firewall_prepare_access_maps(u, ACCESS_ALLOWED, &u->ip_allow_maps, &ip_allow_any);
                 if (r < 0)
                         return log_unit_error_errno(u, r, "Preparation of eBPF allow maps failed: %m");
 
-                r = bpf_firewall_prepare_access_maps(u, ACCESS_DENIED, &u->ipv4_deny_map_fd, &u->ipv6_deny_map_fd, &ip_deny_any);
+                r = bpf_firewall_prepare_access_maps(u, ACCESS_DENIED, &u->ip_deny_maps, &ip_deny_any);
                 if (r < 0)
                         return log_unit_error_errno(u, r, "Preparation of eBPF deny maps failed: %m");
         }
@@ -923,10 +1021,8 @@ void bpf_firewall_close(Unit *u) {
         u->ip_accounting_ingress_map_fd = safe_close(u->ip_accounting_ingress_map_fd);
         u->ip_accounting_egress_map_fd = safe_close(u->ip_accounting_egress_map_fd);
 
-        u->ipv4_allow_map_fd = safe_close(u->ipv4_allow_map_fd);
-        u->ipv6_allow_map_fd = safe_close(u->ipv6_allow_map_fd);
-        u->ipv4_deny_map_fd = safe_close(u->ipv4_deny_map_fd);
-        u->ipv6_deny_map_fd = safe_close(u->ipv6_deny_map_fd);
+        u->ip_allow_maps = bpf_access_maps_unref(u->ip_allow_maps);
+        u->ip_deny_maps = bpf_access_maps_unref(u->ip_deny_maps);
 
         u->ip_bpf_ingress = bpf_program_unref(u->ip_bpf_ingress);
         u->ip_bpf_ingress_installed = bpf_program_unref(u->ip_bpf_ingress_installed);
@@ -78,14 +78,69 @@ bool unit_has_host_root_cgroup(Unit *u) {
         return unit_has_name(u, SPECIAL_ROOT_SLICE);
 }
 
+static void unit_forget_cgroup_attribute(Unit *u, const char *attribute) {
+        _cleanup_free_ char *key = NULL;
+
+        assert(u);
+        assert(attribute);
+
+        free(hashmap_remove2(u->cgroup_attributes, attribute, (void**) &key));
+}
+
+static void unit_remember_cgroup_attribute(Unit *u, const char *attribute, const char *value) {
+        _cleanup_free_ char *a = NULL, *v = NULL;
+
+        assert(u);
+        assert(attribute);
+        assert(value);
+
+        unit_forget_cgroup_attribute(u, attribute);
+
+        /* If we can't remember the value, we'll just write it again next time. */
+        a = strdup(attribute);
+        v = strdup(value);
+        if (!a || !v)
+                return;
+
+        if (hashmap_ensure_put(&u->cgroup_attributes, &string_hash_ops_free_free, a, v) < 0)
+                return;
+
+        TAKE_PTR(a);
+        TAKE_PTR(v);
+}
+
+static bool cgroup_attribute_value_is_per_device(const char *value) {
+        size_t n;
+
+        assert(value);
+
+        /* Lines written to io.max, io.latency, io.weight and friends for a specific device start with its
+         * major:minor. The kernel drops them when the device goes away, and a replugged device comes back
+         * with default settings, hence we can never assume such a line to still be in effect. */
+        n = strspn(value, DIGITS);
+        return n > 0 && value[n] == ':';
+}
+
 static int set_attribute_and_warn(Unit *u, const char *controller, const char *attribute, const char *value) {
+        bool cacheable;
         int r;
 
+        /* Writing the same value again is a noop as far as the kernel is concerned, but still means an
+         * open/write/close cycle on cgroupfs each time, for each unit whenever we re-realize cgroups. */
+        cacheable = !cgroup_attribute_value_is_per_device(value);
+        if (cacheable && streq_ptr(hashmap_get(u->cgroup_attributes, attribute), value))
+                return 0;
+
         r = cg_set_attribute(controller, u->cgroup_path, attribute, value);
-        if (r < 0)
+        if (r < 0) {
                 log_unit_full_errno(u, LOG_LEVEL_CGROUP_WRITE(r), r, "Failed to set '%s' attribute on '%s' to '%.*s': %m",
                                     strna(attribute), isempty(u->cgroup_path) ? "/" : u->cgroup_path, (int) strcspn(value, NEWLINE), value);
+                unit_forget_cgroup_attribute(u, attribute);
+                return r;
+        }
 
+        if (cacheable)
+                unit_remember_cgroup_attribute(u, attribute, value);
         return r;
 }
 
@@ -2045,6 +2100,10 @@ static int unit_update_cgroup(
                 return log_unit_error_errno(u, r, "Failed to create cgroup %s: %m", u->cgroup_path);
         created = r;
 
+        /* A fresh cgroup, or one whose set of controllers changes, comes with default attribute values. */
+        if (created || target_mask != u->cgroup_realized_mask)
+                u->cgroup_attributes = hashmap_free(u->cgroup_attributes);
+
         /* Start watching it */
         (void) unit_watch_cgroup(u);
         (void) unit_watch_cgroup_memory(u);
@@ -2481,12 +2540,14 @@ static int unit_realize_cgroup_now(Unit *u, ManagerState state) {
 unsigned manager_dispatch_cgroup_realize_queue(Manager *m) {
         ManagerState state;
         unsigned n = 0;
+        usec_t start;
         Unit *i;
         int r;
 
         assert(m);
 
         state = manager_state(m);
+        start = now(CLOCK_MONOTONIC);
 
         while ((i = m->cgroup_realize_queue)) {
                 assert(i->in_cgroup_realize_queue);
@@ -2504,6 +2565,13 @@ unsigned manager_dispatch_cgroup_realize_queue(Manager *m) {
                 n++;
         }
 
+        if (n > 0) {
+                char buf[FORMAT_TIMESPAN_MAX];
+
+                log_debug("Realized cgroups of %u units in %s.",
+                          n, format_timespan(buf, sizeof(buf), usec_sub_unsigned(now(CLOCK_MONOTONIC), start), USEC_PER_MSEC));
+        }
+
         return n;
 }
 
@@ -2594,6 +2662,8 @@ void unit_release_cgroup(Unit *u) {
                 u->cgroup_path = mfree(u->cgroup_path);
         }
 
+        u->cgroup_attributes = hashmap_free(u->cgroup_attributes);
+
         if (u->cgroup_control_inotify_wd >= 0) {
                 if (inotify_rm_watch(u->manager->cgroup_inotify_fd, u->cgroup_control_inotify_wd) < 0)
                         log_unit_debug_errno(u, errno, "Failed to remove cgroup control inotify watch %i for %s, ignoring: %m", u->cgroup_control_inotify_wd, u->id);
@@ -3069,12 +3139,18 @@ static int unit_check_cgroup_events(Unit *u) {
 }
 
 static int on_cgroup_inotify_event(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        _cleanup_set_free_ Set *units = NULL;
         Manager *m = userdata;
+        Unit *u;
+        int r = 0;
 
         assert(s);
         assert(fd >= 0);
         assert(m);
 
+        /* Drain the inotify queue first and only then look at the cgroups that had events, so that each
+         * cgroup.events file is read once per batch, regardless of how many events were queued for it. */
+
         for (;;) {
                 union inotify_event_buffer buffer;
                 struct inotify_event *e;
@@ -3082,15 +3158,12 @@ static int on_cgroup_inotify_event(sd_event_source *s, int fd, uint32_t revents,
 
                 l = read(fd, &buffer, sizeof(buffer));
                 if (l < 0) {
-                        if (IN_SET(errno, EINTR, EAGAIN))
-                                return 0;
-
-                        return log_error_errno(errno, "Failed to read control group inotify events: %m");
+                        if (!IN_SET(errno, EINTR, EAGAIN))
+                                r = log_error_errno(errno, "Failed to read control group inotify events: %m");
+                        break;
                 }
 
                 FOREACH_INOTIFY_EVENT(e, buffer, l) {
-                        Unit *u;
-
                         if (e->wd < 0)
                                 /* Queue overflow has no watch descriptor */
                                 continue;
@@ -3103,14 +3176,20 @@ static int on_cgroup_inotify_event(sd_event_source *s, int fd, uint32_t revents,
                          * because it was queued before the removal. Let's ignore this here safely. */
 
                         u = hashmap_get(m->cgroup_control_inotify_wd_unit, INT_TO_PTR(e->wd));
-                        if (u)
-                                unit_check_cgroup_events(u);
+                        if (u && set_ensure_put(&units, NULL, u) < 0)
+                                /* Can't remember it for later? Then check right-away. */
+                                (void) unit_check_cgroup_events(u);
 
                         u = hashmap_get(m->cgroup_memory_inotify_wd_unit, INT_TO_PTR(e->wd));
                         if (u)
                                 unit_add_to_cgroup_oom_queue(u);
                 }
         }
+
+        SET_FOREACH(u, units)
+                (void) unit_check_cgroup_events(u);
+
+        return r;
 }
 
 static int cg_bpf_mask_supported(CGroupMask *ret) {
@@ -3845,6 +3924,10 @@ void unit_invalidate_cgroup(Unit *u, CGroupMask m) {
         if (FLAGS_SET(u->cgroup_invalidated_mask, m)) /* NOP? */
                 return;
 
+        /* Whoever invalidates wants the attributes written for real, e.g. because a device they refer to
+         * showed up again, hence don't trust the values we remember. */
+        u->cgroup_attributes = hashmap_free(u->cgroup_attributes);
+
         u->cgroup_invalidated_mask |= m;
         unit_add_to_cgroup_realize_queue(u);
 }
@@ -828,6 +828,116 @@ static int method_list_units_by_names(sd_bus_message *message, void *userdata, s
         return sd_bus_send(NULL, reply, NULL);
 }
 
+static int reply_unit_accounting(sd_bus_message *reply, Unit *u) {
+        uint64_t cpu = NSEC_INFINITY, memory = UINT64_MAX, tasks = UINT64_MAX,
+                ip[_CGROUP_IP_ACCOUNTING_METRIC_MAX], io[_CGROUP_IO_ACCOUNTING_METRIC_MAX];
+
+        assert(reply);
+        assert(u);
+
+        /* Same values as the CPUUsageNSec, MemoryCurrent, TasksCurrent, IP… and IO… properties, with
+         * UINT64_MAX for anything that is not available. */
+
+        (void) unit_get_cpu_usage(u, &cpu);
+        (void) unit_get_memory_current(u, &memory);
+        (void) unit_get_tasks_current(u, &tasks);
+
+        for (CGroupIPAccountingMetric i = 0; i < _CGROUP_IP_ACCOUNTING_METRIC_MAX; i++) {
+                ip[i] = UINT64_MAX;
+                (void) unit_get_ip_accounting(u, i, ip + i);
+        }
+
+        /* A single read of io.stat refreshes all IO counters, pick up the others from the cache then */
+        for (CGroupIOAccountingMetric i = 0; i < _CGROUP_IO_ACCOUNTING_METRIC_MAX; i++)
+                io[i] = UINT64_MAX;
+        if (unit_get_io_accounting(u, 0, false, NULL) >= 0)
+                for (CGroupIOAccountingMetric i = 0; i < _CGROUP_IO_ACCOUNTING_METRIC_MAX; i++)
+                        (void) unit_get_io_accounting(u, i, true, io + i);
+
+        return sd_bus_message_append(
+                        reply, "(sttttttttttt)",
+                        u->id,
+                        cpu,
+                        memory,
+                        tasks,
+                        ip[CGROUP_IP_INGRESS_BYTES],
+                        ip[CGROUP_IP_INGRESS_PACKETS],
+                        ip[CGROUP_IP_EGRESS_BYTES],
+                        ip[CGROUP_IP_EGRESS_PACKETS],
+                        io[CGROUP_IO_READ_BYTES],
+                        io[CGROUP_IO_WRITE_BYTES],
+                        io[CGROUP_IO_READ_OPERATIONS],
+                        io[CGROUP_IO_WRITE_OPERATIONS]);
+}
+
+static int method_get_units_accounting(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_strv_free_ char **names = NULL;
+        Manager *m = userdata;
+        char **name;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Returns the resource counters of many units in one go, so that monitoring tools don't have to
+         * issue a GetAll() call for each unit. Doesn't load any units: units that aren't loaded have no
+         * cgroup, and hence nothing to account either. */
+
+        r = sd_bus_message_read_strv(message, &names);
+        if (r < 0)
+                return r;
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_open_container(reply, 'a', "(sttttttttttt)");
+        if (r < 0)
+                return r;
+
+        if (strv_isempty(names)) {
+                const char *k;
+                Unit *u;
+
+                HASHMAP_FOREACH_KEY(u, k, m->units) {
+                        if (k != u->id)
+                                continue;
+
+                        if (!u->cgroup_realized)
+                                continue;
+
+                        r = reply_unit_accounting(reply, u);
+                        if (r < 0)
+                                return r;
+                }
+        } else {
+                STRV_FOREACH(name, names) {
+                        Unit *u;
+
+                        u = manager_get_unit(m, *name);
+                        if (!u)
+                                continue;
+
+                        r = reply_unit_accounting(reply, u);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        r = sd_bus_message_close_container(reply);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(NULL, reply, NULL);
+}
+
 static int method_get_unit_processes(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         /* Don't load a unit (since it won't have any processes if it's not loaded), but don't insist on the
          * unit being loaded (because even improperly loaded units might still have processes around */
@@ -1076,26 +1186,14 @@ static int method_reset_failed(sd_bus_message *message, void *userdata, sd_bus_e
         return sd_bus_reply_method_return(message, NULL);
 }
 
-static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_error *error, char **states, char **patterns) {
-        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        Manager *m = userdata;
+static int append_unit_infos(sd_bus_message *reply, Manager *m, char **states, char **patterns, uint64_t since) {
         const char *k;
         Unit *u;
         int r;
 
-        assert(message);
+        assert(reply);
         assert(m);
 
-        /* Anyone can call this method */
-
-        r = mac_selinux_access_check(message, "status", error);
-        if (r < 0)
-                return r;
-
-        r = sd_bus_message_new_method_return(message, &reply);
-        if (r < 0)
-                return r;
-
         r = sd_bus_message_open_container(reply, 'a', "(ssssssouso)");
         if (r < 0)
                 return r;
@@ -1104,6 +1202,9 @@ static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_e
                 if (k != u->id)
                         continue;
 
+                if (!unit_changed_since(u, since))
+                        continue;
+
                 if (!strv_isempty(states) &&
                     !strv_contains(states, unit_load_state_to_string(u->load_state)) &&
                     !strv_contains(states, unit_active_state_to_string(unit_active_state(u))) &&
@@ -1119,7 +1220,28 @@ static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_e
                         return r;
         }
 
-        r = sd_bus_message_close_container(reply);
+        return sd_bus_message_close_container(reply);
+}
+
+static int list_units_filtered(sd_bus_message *message, void *userdata, sd_bus_error *error, char **states, char **patterns) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        Manager *m = userdata;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = append_unit_infos(reply, m, states, patterns, 0);
         if (r < 0)
                 return r;
 
@@ -1157,6 +1279,54 @@ static int method_list_units_by_patterns(sd_bus_message *message, void *userdata
         return list_units_filtered(message, userdata, error, states, patterns);
 }
 
+static int method_list_units_changed_since(sd_bus_message *message, void *userdata, sd_bus_error *error) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_strv_free_ char **states = NULL, **patterns = NULL;
+        Manager *m = userdata;
+        uint64_t since;
+        bool complete;
+        int r;
+
+        assert(message);
+        assert(m);
+
+        r = sd_bus_message_read_strv(message, &states);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(message, &patterns);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(message, "t", &since);
+        if (r < 0)
+                return r;
+
+        /* Anyone can call this method */
+
+        r = mac_selinux_access_check(message, "status", error);
+        if (r < 0)
+                return r;
+
+        complete = manager_unit_generation_is_stale(m, since);
+        if (complete)
+                since = 0;
+
+        r = sd_bus_message_new_method_return(message, &reply);
+        if (r < 0)
+                return r;
+
+        r = append_unit_infos(reply, m, states, patterns, since);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_append(reply, "tb", m->unit_change_generation, complete);
+        if (r < 0)
+                return r;
+
+        return sd_bus_send(NULL, reply, NULL);
+}
+
 static int method_list_jobs(sd_bus_message *message, void *userdata, sd_bus_error *error) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         Manager *m = userdata;
@@ -3011,6 +3181,17 @@ const sd_bus_vtable bus_manager_vtable[] = {
                                  SD_BUS_PARAM(units),
                                  method_list_units_by_patterns,
                                  SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD_WITH_NAMES("ListUnitsChangedSince",
+                                 "asast",
+                                 SD_BUS_PARAM(states)
+                                 SD_BUS_PARAM(patterns)
+                                 SD_BUS_PARAM(generation),
+                                 "a(ssssssouso)tb",
+                                 SD_BUS_PARAM(units)
+                                 SD_BUS_PARAM(generation)
+                                 SD_BUS_PARAM(complete),
+                                 method_list_units_changed_since,
+                                 SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD_WITH_NAMES("ListUnitsByNames",
                                  "as",
                                  SD_BUS_PARAM(names),
@@ -3018,6 +3199,13 @@ const sd_bus_vtable bus_manager_vtable[] = {
                                  SD_BUS_PARAM(units),
                                  method_list_units_by_names,
                                  SD_BUS_VTABLE_UNPRIVILEGED),
+        SD_BUS_METHOD_WITH_NAMES("GetUnitsAccounting",
+                                 "as",
+                                 SD_BUS_PARAM(names),
+                                 "a(sttttttttttt)",
+                                 SD_BUS_PARAM(accounting),
+                                 method_get_units_accounting,
+                                 SD_BUS_VTABLE_UNPRIVILEGED),
         SD_BUS_METHOD_WITH_NAMES("ListJobs",
                                  NULL,,
                                  "a(usssoo)",
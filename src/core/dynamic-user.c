@@ -31,9 +31,13 @@ static DynamicUser* dynamic_user_free(DynamicUser *d) {
         if (!d)
                 return NULL;
 
-        if (d->manager)
+        if (d->manager) {
                 (void) hashmap_remove(d->manager->dynamic_users, d->name);
 
+                if (uid_is_valid(d->indexed_uid))
+                        (void) hashmap_remove_value(d->manager->dynamic_users_by_uid, UID_TO_PTR(d->indexed_uid), d);
+        }
+
         safe_close_pair(d->storage_socket);
         return mfree(d);
 }
@@ -58,6 +62,7 @@ static int dynamic_user_add(Manager *m, const char *name, int storage_socket[sta
 
         d->storage_socket[0] = storage_socket[0];
         d->storage_socket[1] = storage_socket[1];
+        d->indexed_uid = UID_INVALID;
 
         r = hashmap_put(m->dynamic_users, d->name, d);
         if (r < 0) {
@@ -694,6 +699,53 @@ void dynamic_user_vacuum(Manager *m, bool close_user) {
         }
 }
 
+static void dynamic_user_index(DynamicUser *d, uid_t uid) {
+        Manager *m;
+
+        assert(d);
+        assert(uid_is_valid(uid));
+
+        m = d->manager;
+        if (!m || d->indexed_uid == uid)
+                return;
+
+        if (uid_is_valid(d->indexed_uid))
+                (void) hashmap_remove_value(m->dynamic_users_by_uid, UID_TO_PTR(d->indexed_uid), d);
+        d->indexed_uid = UID_INVALID;
+
+        /* The index is only a cache, hence failing to update it is not fatal */
+        if (hashmap_ensure_allocated(&m->dynamic_users_by_uid, NULL) < 0)
+                return;
+        if (hashmap_replace(m->dynamic_users_by_uid, UID_TO_PTR(uid), d) < 0)
+                return;
+
+        d->indexed_uid = uid;
+}
+
+static int dynamic_user_lookup_uid_indexed(Manager *m, uid_t uid, char **ret) {
+        DynamicUser *d;
+        uid_t check_uid;
+        char *name;
+
+        assert(m);
+        assert(ret);
+
+        d = hashmap_get(m->dynamic_users_by_uid, UID_TO_PTR(uid));
+        if (!d)
+                return -ESRCH;
+
+        /* The UID might have been released or handed to somebody else since we indexed it */
+        if (dynamic_user_current(d, &check_uid) < 0 || check_uid != uid)
+                return -ESRCH;
+
+        name = strdup(d->name);
+        if (!name)
+                return -ENOMEM;
+
+        *ret = name;
+        return 0;
+}
+
 int dynamic_user_lookup_uid(Manager *m, uid_t uid, char **ret) {
         char lock_path[STRLEN("/run/systemd/dynamic-uid/") + DECIMAL_STR_MAX(uid_t) + 1];
         _cleanup_free_ char *user = NULL;
@@ -707,6 +759,11 @@ int dynamic_user_lookup_uid(Manager *m, uid_t uid, char **ret) {
         if (!uid_is_dynamic(uid))
                 return -ESRCH;
 
+        /* Try the index first, which avoids reading the lock file for users we already resolved once */
+        r = dynamic_user_lookup_uid_indexed(m, uid, ret);
+        if (r != -ESRCH)
+                return r;
+
         xsprintf(lock_path, "/run/systemd/dynamic-uid/" UID_FMT, uid);
         r = read_one_line_file(lock_path, &user);
         if (IN_SET(r, -ENOENT, 0))
@@ -728,6 +785,7 @@ int dynamic_user_lookup_uid(Manager *m, uid_t uid, char **ret) {
 
 int dynamic_user_lookup_name(Manager *m, const char *name, uid_t *ret) {
         DynamicUser *d;
+        uid_t uid;
         int r;
 
         assert(m);
@@ -739,11 +797,19 @@ int dynamic_user_lookup_name(Manager *m, const char *name, uid_t *ret) {
         if (!d)
                 return -ESRCH;
 
-        r = dynamic_user_current(d, ret);
+        r = dynamic_user_current(d, &uid);
         if (r == -EAGAIN) /* not realized yet? */
                 return -ESRCH;
+        if (r < 0)
+                return r;
 
-        return r;
+        if (uid_is_dynamic(uid))
+                dynamic_user_index(d, uid);
+
+        if (ret)
+                *ret = uid;
+
+        return 0;
 }
 
 int dynamic_creds_acquire(DynamicCreds *creds, Manager *m, const char *user, const char *group) {
@@ -22,6 +22,9 @@ struct DynamicUser {
          * file fd locking the user ID we picked. */
         int storage_socket[2];
 
+        /* The UID under which this user is indexed in Manager.dynamic_users_by_uid, or UID_INVALID */
+        uid_t indexed_uid;
+
         char name[];
 };
 
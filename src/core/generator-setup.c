@@ -1,11 +1,25 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <fcntl.h>
 #include <unistd.h>
 
+#include "sd-id128.h"
+
+#include "alloc-util.h"
+#include "dirent-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "fs-util.h"
 #include "generator-setup.h"
 #include "macro.h"
 #include "mkdir.h"
+#include "path-util.h"
 #include "rm-rf.h"
+#include "siphash24.h"
+#include "strv.h"
+
+#define GENERATOR_HASH_KEY SD_ID128_MAKE(b1,62,2f,0e,9c,34,4d,7b,a4,4e,6f,93,1d,c8,0a,57)
+#define GENERATOR_HASH_DEPTH_MAX 8U
 
 int lookup_paths_mkdir_generator(LookupPaths *p) {
         int r, q;
@@ -56,3 +70,167 @@ void lookup_paths_flush_generator(LookupPaths *p) {
         if (p->temporary_dir)
                 (void) rm_rf(p->temporary_dir, REMOVE_ROOT|REMOVE_PHYSICAL);
 }
+
+static int hash_tree(const char *path, unsigned depth, struct siphash *state) {
+        _cleanup_strv_free_ char **names = NULL;
+        _cleanup_closedir_ DIR *d = NULL;
+        struct dirent *de;
+        char **n;
+        int r;
+
+        assert(path);
+        assert(state);
+
+        if (depth > GENERATOR_HASH_DEPTH_MAX)
+                return -ELOOP;
+
+        d = opendir(path);
+        if (!d) {
+                if (errno == ENOENT)
+                        return 0;
+
+                return -errno;
+        }
+
+        FOREACH_DIRENT_ALL(de, d, return -errno) {
+                if (dot_or_dot_dot(de->d_name))
+                        continue;
+
+                r = strv_extend(&names, de->d_name);
+                if (r < 0)
+                        return r;
+        }
+
+        /* The directory order is not stable across regenerations, the contents is what matters */
+        strv_sort(names);
+
+        STRV_FOREACH(n, names) {
+                _cleanup_free_ char *p = NULL, *contents = NULL;
+                struct stat st;
+                size_t size;
+
+                p = path_join(path, *n);
+                if (!p)
+                        return -ENOMEM;
+
+                if (lstat(p, &st) < 0)
+                        return -errno;
+
+                siphash24_compress(*n, strlen(*n) + 1, state);
+                siphash24_compress(&st.st_mode, sizeof(st.st_mode), state);
+
+                if (S_ISLNK(st.st_mode)) {
+                        r = readlink_malloc(p, &contents);
+                        if (r < 0)
+                                return r;
+
+                        siphash24_compress(contents, strlen(contents) + 1, state);
+
+                } else if (S_ISDIR(st.st_mode)) {
+                        r = hash_tree(p, depth + 1, state);
+                        if (r < 0)
+                                return r;
+
+                } else if (S_ISREG(st.st_mode)) {
+                        r = read_full_file(p, &contents, &size);
+                        if (r < 0)
+                                return r;
+
+                        siphash24_compress(&size, sizeof(size), state);
+                        siphash24_compress(contents, size, state);
+                }
+        }
+
+        /* Terminate the listing, so that entries can't move between directory levels unnoticed */
+        siphash24_compress("", 1, state);
+        return 0;
+}
+
+int lookup_paths_hash_generator(const LookupPaths *p, uint64_t *ret) {
+        struct siphash state;
+        const char *dir;
+        int r;
+
+        assert(p);
+        assert(ret);
+
+        /* Hashes the complete output of the generators: names, file types, symlink targets and contents. The
+         * files themselves are recreated on every run, hence their timestamps tell nothing. */
+
+        siphash24_init(&state, GENERATOR_HASH_KEY.bytes);
+
+        FOREACH_STRING(dir, p->generator, p->generator_early, p->generator_late) {
+                siphash24_compress(dir, strlen(dir) + 1, &state);
+
+                r = hash_tree(dir, 0, &state);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = siphash24_finalize(&state);
+        return 0;
+}
+
+int lookup_paths_hash_dependency_dirs(const LookupPaths *p, uint64_t *ret) {
+        struct siphash state;
+        char **dir;
+        int r;
+
+        assert(p);
+        assert(ret);
+
+        /* Hashes the symlinks in all .wants/ and .requires/ directories in the search path. Adding one (e.g.
+         * through "systemctl enable") changes neither the unit files nor the timestamp of the search path
+         * directory itself. */
+
+        siphash24_init(&state, GENERATOR_HASH_KEY.bytes);
+
+        STRV_FOREACH(dir, p->search_path) {
+                _cleanup_strv_free_ char **names = NULL;
+                _cleanup_closedir_ DIR *d = NULL;
+                struct dirent *de;
+                char **n;
+
+                d = opendir(*dir);
+                if (!d) {
+                        if (errno == ENOENT)
+                                continue;
+
+                        return -errno;
+                }
+
+                FOREACH_DIRENT(de, d, return -errno) {
+                        if (!ENDSWITH_SET(de->d_name, ".wants", ".requires"))
+                                continue;
+
+                        r = strv_extend(&names, de->d_name);
+                        if (r < 0)
+                                return r;
+                }
+
+                strv_sort(names);
+
+                siphash24_compress(*dir, strlen(*dir) + 1, &state);
+
+                STRV_FOREACH(n, names) {
+                        _cleanup_free_ char *q = NULL;
+
+                        q = path_join(*dir, *n);
+                        if (!q)
+                                return -ENOMEM;
+
+                        siphash24_compress(*n, strlen(*n) + 1, &state);
+
+                        r = hash_tree(q, 0, &state);
+                        if (r == -ENOTDIR)
+                                continue;
+                        if (r < 0)
+                                return r;
+                }
+
+                siphash24_compress("", 1, &state);
+        }
+
+        *ret = siphash24_finalize(&state);
+        return 0;
+}
@@ -6,3 +6,5 @@
 int lookup_paths_mkdir_generator(LookupPaths *p);
 void lookup_paths_trim_generator(LookupPaths *p);
 void lookup_paths_flush_generator(LookupPaths *p);
+int lookup_paths_hash_generator(const LookupPaths *p, uint64_t *ret);
+int lookup_paths_hash_dependency_dirs(const LookupPaths *p, uint64_t *ret);
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "conf-parser.h"
+#include "env-util.h"
+#include "fs-util.h"
+#include "hashmap.h"
+#include "load-cache.h"
+#include "load-fragment.h"
+#include "log.h"
+#include "path-util.h"
+#include "time-util.h"
+
+typedef struct LoadCacheEntry {
+        char *path;
+
+        dev_t dev;
+        ino_t ino;
+        nsec_t mtime;
+        nsec_t ctime;
+        off_t size;
+
+        unsigned generation;
+        ConfigParseRecording *recording;
+} LoadCacheEntry;
+
+static LoadCacheEntry* load_cache_entry_free(LoadCacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        config_parse_recording_free(e->recording);
+        free(e->path);
+        return mfree(e);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(LoadCacheEntry*, load_cache_entry_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(load_cache_hash_ops, char, path_hash_func, path_compare,
+                                              LoadCacheEntry, load_cache_entry_free);
+
+static bool load_cache_enabled(void) {
+        static int cached = -1;
+        int r;
+
+        if (cached >= 0)
+                return cached;
+
+        r = getenv_bool("SYSTEMD_UNIT_PARSE_CACHE");
+        if (r < 0 && r != -ENXIO)
+                log_debug_errno(r, "Failed to parse $SYSTEMD_UNIT_PARSE_CACHE, ignoring: %m");
+
+        return (cached = r != 0);
+}
+
+static bool load_cache_entry_matches(const LoadCacheEntry *e, const struct stat *st) {
+        assert(e);
+        assert(st);
+
+        /* The ctime is checked too, so that a file rewritten with its old mtime restored is noticed. */
+        return e->dev == st->st_dev &&
+                e->ino == st->st_ino &&
+                e->mtime == timespec_load_nsec(&st->st_mtim) &&
+                e->ctime == timespec_load_nsec(&st->st_ctim) &&
+                e->size == st->st_size;
+}
+
+static int load_cache_put(Manager *m, const char *path, const struct stat *st, ConfigParseRecording *rec) {
+        _cleanup_(load_cache_entry_freep) LoadCacheEntry *e = NULL;
+        int r;
+
+        assert(m);
+        assert(path);
+        assert(st);
+        assert(rec);
+
+        e = new(LoadCacheEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (LoadCacheEntry) {
+                .path = strdup(path),
+                .dev = st->st_dev,
+                .ino = st->st_ino,
+                .mtime = timespec_load_nsec(&st->st_mtim),
+                .ctime = timespec_load_nsec(&st->st_ctim),
+                .size = st->st_size,
+                .generation = m->load_cache_generation,
+        };
+        if (!e->path)
+                return -ENOMEM;
+
+        r = hashmap_ensure_allocated(&m->load_cache, &load_cache_hash_ops);
+        if (r < 0)
+                return r;
+
+        load_cache_entry_free(hashmap_remove(m->load_cache, path));
+
+        r = hashmap_put(m->load_cache, e->path, e);
+        if (r < 0)
+                return r;
+
+        /* Only take possession once nothing can fail anymore, the caller frees it otherwise */
+        TAKE_PTR(e)->recording = rec;
+        return 0;
+}
+
+int unit_config_parse(Unit *u, const char *path, FILE *f, const struct stat *st, usec_t *latest_mtime) {
+        _cleanup_(config_parse_recording_freep) ConfigParseRecording *rec = NULL;
+        LoadCacheEntry *e;
+        int r;
+
+        assert(u);
+        assert(path);
+        assert(f);
+        assert(st);
+
+        if (!load_cache_enabled())
+                return config_parse(u->id, path, f,
+                                    UNIT_VTABLE(u)->sections,
+                                    config_item_perf_lookup, load_fragment_gperf_lookup,
+                                    0,
+                                    u,
+                                    latest_mtime);
+
+        e = hashmap_get(u->manager->load_cache, path);
+        if (e && load_cache_entry_matches(e, st)) {
+                e->generation = u->manager->load_cache_generation;
+
+                /* config_parse() would warn about this, keep doing so. Streams without an fd were read
+                 * ahead, and the caller checked them already. */
+                if (fileno(f) >= 0)
+                        (void) stat_warn_permissions(path, st);
+
+                r = config_parse_replay(u->id, path, e->recording,
+                                        config_item_perf_lookup, load_fragment_gperf_lookup,
+                                        u);
+                if (r >= 0 && latest_mtime)
+                        *latest_mtime = MAX(*latest_mtime, timespec_load(&st->st_mtim));
+
+                return r;
+        }
+
+        r = config_parse_record(u->id, path, f,
+                                UNIT_VTABLE(u)->sections,
+                                config_item_perf_lookup, load_fragment_gperf_lookup,
+                                0,
+                                u,
+                                latest_mtime,
+                                &rec);
+        if (r < 0)
+                return r;
+
+        if (rec) {
+                r = load_cache_put(u->manager, path, st, rec);
+                if (r < 0)
+                        log_unit_debug_errno(u, r, "Failed to cache parsed assignments of %s, ignoring: %m", path);
+                else
+                        TAKE_PTR(rec);
+        } else
+                /* Don't keep a stale entry around for a file we couldn't record */
+                load_cache_entry_free(hashmap_remove(u->manager->load_cache, path));
+
+        return r;
+}
+
+void manager_load_cache_trim(Manager *m) {
+        LoadCacheEntry *e;
+
+        assert(m);
+
+        HASHMAP_FOREACH(e, m->load_cache)
+                if (e->generation != m->load_cache_generation)
+                        load_cache_entry_free(hashmap_remove(m->load_cache, e->path));
+}
@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <sys/stat.h>
+
+#include "manager.h"
+#include "unit.h"
+
+/* The parsed assignments of unit files and drop-ins, kept across daemon-reload. As long as a file's stat
+ * data doesn't change, its assignments are replayed to the parsers instead of reading and tokenizing the
+ * file again. */
+
+int unit_config_parse(Unit *u, const char *path, FILE *f, const struct stat *st, usec_t *latest_mtime);
+
+/* Drops everything that wasn't used since the cache generation was last bumped */
+void manager_load_cache_trim(Manager *m);
@@ -2,6 +2,7 @@
 
 #include "conf-parser.h"
 #include "fs-util.h"
+#include "load-cache.h"
 #include "load-dropin.h"
 #include "load-fragment.h"
 #include "log.h"
@@ -83,6 +84,23 @@ static int process_deps(Unit *u, UnitDependency dependency, const char *dir_suff
         return 0;
 }
 
+static void load_dropin_file(Unit *u, const char *path) {
+        _cleanup_fclose_ FILE *f = NULL;
+        struct stat st;
+
+        assert(u);
+        assert(path);
+
+        f = fopen(path, "re");
+        if (!f)
+                return (void) log_unit_debug_errno(u, errno, "Failed to open drop-in %s, ignoring: %m", path);
+
+        if (fstat(fileno(f), &st) < 0)
+                return (void) log_unit_debug_errno(u, errno, "Failed to fstat(%s), ignoring: %m", path);
+
+        (void) unit_config_parse(u, path, f, &st, &u->dropin_mtime);
+}
+
 int unit_load_dropin(Unit *u) {
         _cleanup_strv_free_ char **l = NULL;
         char **f;
@@ -114,13 +132,7 @@ int unit_load_dropin(Unit *u) {
 
         u->dropin_mtime = 0;
         STRV_FOREACH(f, u->dropin_paths)
-                (void) config_parse(
-                                u->id, *f, NULL,
-                                UNIT_VTABLE(u)->sections,
-                                config_item_perf_lookup, load_fragment_gperf_lookup,
-                                0,
-                                u,
-                                &u->dropin_mtime);
+                load_dropin_file(u, *f);
 
         return 0;
 }
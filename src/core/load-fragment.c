@@ -43,7 +43,9 @@
 #include "ip-protocol-list.h"
 #include "journal-file.h"
 #include "limits-util.h"
+#include "load-cache.h"
 #include "load-fragment.h"
+#include "load-prefetch.h"
 #include "log.h"
 #include "mountpoint-util.h"
 #include "nulstr-util.h"
@@ -2090,7 +2092,6 @@ int config_parse_path_spec(const char *unit,
         s->unit = UNIT(p);
         s->path = TAKE_PTR(k);
         s->type = b;
-        s->inotify_fd = -1;
 
         LIST_PREPEND(spec, p->specs, s);
 
@@ -5737,18 +5738,35 @@ int unit_load_fragment(Unit *u) {
 
         if (fragment) {
                 /* Open the file, check if this is a mask, otherwise read. */
+                _cleanup_(prefetched_fragment_freep) PrefetchedFragment *prefetched = NULL;
                 _cleanup_fclose_ FILE *f = NULL;
                 struct stat st;
 
-                /* Try to open the file name. A symlink is OK, for example for linked files or masks. We
-                 * expect that all symlinks within the lookup paths have been already resolved, but we don't
-                 * verify this here. */
-                f = fopen(fragment, "re");
-                if (!f)
-                        return log_unit_notice_errno(u, errno, "Failed to open %s: %m", fragment);
+                /* If the file was read ahead already, take it from there. Anything that went wrong while
+                 * doing so is simply retried below, so that it is reported the usual way. */
+                prefetched = hashmap_remove(u->manager->prefetched_fragments, fragment);
+                if (prefetched && prefetched->error >= 0) {
+                        st = prefetched->st;
 
-                if (fstat(fileno(f), &st) < 0)
-                        return -errno;
+                        if (!null_or_empty(&st)) {
+                                f = fmemopen_unlocked(prefetched->data, prefetched->size, "r");
+                                if (!f)
+                                        return log_oom();
+
+                                /* The stream has no fd, hence config_parse() can't check this itself */
+                                (void) stat_warn_permissions(fragment, &st);
+                        }
+                } else {
+                        /* Try to open the file name. A symlink is OK, for example for linked files or masks.
+                         * We expect that all symlinks within the lookup paths have been already resolved, but
+                         * we don't verify this here. */
+                        f = fopen(fragment, "re");
+                        if (!f)
+                                return log_unit_notice_errno(u, errno, "Failed to open %s: %m", fragment);
+
+                        if (fstat(fileno(f), &st) < 0)
+                                return -errno;
+                }
 
                 r = free_and_strdup(&u->fragment_path, fragment);
                 if (r < 0)
@@ -5764,12 +5782,7 @@ int unit_load_fragment(Unit *u) {
                         u->fragment_mtime = timespec_load(&st.st_mtim);
 
                         /* Now, parse the file contents */
-                        r = config_parse(u->id, fragment, f,
-                                         UNIT_VTABLE(u)->sections,
-                                         config_item_perf_lookup, load_fragment_gperf_lookup,
-                                         0,
-                                         u,
-                                         NULL);
+                        r = unit_config_parse(u, fragment, f, &st, NULL);
                         if (r == -ENOEXEC)
                                 log_unit_notice_errno(u, r, "Unit configuration has fatal error, unit will not be started.");
                         if (r < 0)
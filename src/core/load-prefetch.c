@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "load-prefetch.h"
+#include "log.h"
+#include "path-util.h"
+#include "stat-util.h"
+#include "strv.h"
+
+#define PREFETCH_THREADS_MAX 16U
+
+typedef struct PrefetchContext {
+        PrefetchedFragment **items;
+        size_t n_items;
+        size_t next; /* accessed atomically */
+} PrefetchContext;
+
+PrefetchedFragment* prefetched_fragment_free(PrefetchedFragment *p) {
+        if (!p)
+                return NULL;
+
+        free(p->path);
+        free(p->data);
+        return mfree(p);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(prefetched_fragment_hash_ops, char, path_hash_func, path_compare,
+                                              PrefetchedFragment, prefetched_fragment_free);
+
+static int fragment_read(PrefetchedFragment *p) {
+        _cleanup_close_ int fd = -1;
+        _cleanup_fclose_ FILE *f = NULL;
+
+        assert(p);
+
+        /* Called from the worker threads: no logging, no hashmaps, nothing but plain file system access and
+         * malloc(). Symlinks are followed, like unit_load_fragment() does. */
+
+        fd = open(p->path, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return -errno;
+
+        if (fstat(fd, &p->st) < 0)
+                return -errno;
+
+        /* Masks are decided on from the stat data alone, and anything else that is not a regular file is
+         * left to the regular code path. */
+        if (null_or_empty(&p->st))
+                return 0;
+        if (!S_ISREG(p->st.st_mode))
+                return -EBADFD;
+
+        f = take_fdopen(&fd, "r");
+        if (!f)
+                return -errno;
+
+        return read_full_stream(f, &p->data, &p->size);
+}
+
+static void* prefetch_thread(void *userdata) {
+        PrefetchContext *c = userdata;
+
+        for (;;) {
+                size_t i;
+
+                i = __sync_fetch_and_add(&c->next, 1);
+                if (i >= c->n_items)
+                        break;
+
+                c->items[i]->error = fragment_read(c->items[i]);
+        }
+
+        return NULL;
+}
+
+static unsigned prefetch_start_threads(PrefetchContext *c, pthread_t *threads, unsigned n_threads) {
+        sigset_t ss, saved_ss;
+        unsigned n = 0;
+
+        assert(c);
+        assert(threads);
+
+        /* Same as asynchronous_job(): start the threads with all signals blocked, so that they don't
+         * interfere with the signal handling of the manager. */
+        assert_se(sigfillset(&ss) >= 0);
+        if (pthread_sigmask(SIG_BLOCK, &ss, &saved_ss) > 0)
+                return 0;
+
+        for (; n < n_threads; n++)
+                if (pthread_create(threads + n, NULL, prefetch_thread, c) > 0)
+                        break;
+
+        assert_se(pthread_sigmask(SIG_SETMASK, &saved_ss, NULL) == 0);
+
+        return n;
+}
+
+int fragment_prefetch(char **paths, unsigned n_threads, Hashmap **fragments) {
+        _cleanup_free_ PrefetchedFragment **items = NULL;
+        _cleanup_free_ pthread_t *threads = NULL;
+        PrefetchContext c = {};
+        size_t n_items = 0;
+        unsigned n_started;
+        char **p;
+        int r;
+
+        assert(fragments);
+
+        items = new(PrefetchedFragment*, strv_length(paths));
+        if (!items)
+                return -ENOMEM;
+
+        r = hashmap_ensure_allocated(fragments, &prefetched_fragment_hash_ops);
+        if (r < 0)
+                return r;
+
+        /* Register all entries first, so that the workers never need to touch the hashmap. */
+        STRV_FOREACH(p, paths) {
+                _cleanup_(prefetched_fragment_freep) PrefetchedFragment *pf = NULL;
+
+                if (hashmap_contains(*fragments, *p))
+                        continue;
+
+                pf = new(PrefetchedFragment, 1);
+                if (!pf)
+                        return -ENOMEM;
+
+                *pf = (PrefetchedFragment) {
+                        .path = strdup(*p),
+                        .error = -EAGAIN,
+                };
+                if (!pf->path)
+                        return -ENOMEM;
+
+                r = hashmap_put(*fragments, pf->path, pf);
+                if (r < 0)
+                        return r;
+
+                items[n_items++] = TAKE_PTR(pf);
+        }
+
+        if (n_items == 0)
+                return 0;
+
+        n_threads = CLAMP(n_threads, 1U, MIN(PREFETCH_THREADS_MAX, (unsigned) n_items));
+
+        c = (PrefetchContext) {
+                .items = items,
+                .n_items = n_items,
+        };
+
+        /* The calling thread is one of the readers, too. This also covers the case where no other thread
+         * could be started at all. */
+        threads = new(pthread_t, n_threads);
+        if (!threads)
+                return -ENOMEM;
+
+        n_started = prefetch_start_threads(&c, threads, n_threads - 1);
+        if (n_started < n_threads - 1)
+                log_debug("Failed to start all unit file prefetch threads, continuing with %u.", n_started + 1);
+
+        (void) prefetch_thread(&c);
+
+        for (unsigned i = 0; i < n_started; i++)
+                assert_se(pthread_join(threads[i], NULL) == 0);
+
+        return 0;
+}
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <sys/stat.h>
+
+#include "hashmap.h"
+
+/* Unit fragments read ahead of time by a set of worker threads, so that the load queue can be dispatched
+ * without blocking on the file system for each unit in turn. Only the reading happens off the main thread,
+ * parsing and everything that touches the unit state stays where it was. */
+
+typedef struct PrefetchedFragment {
+        char *path;
+        struct stat st;
+        char *data;     /* only set for non-empty regular files */
+        size_t size;
+        int error;
+} PrefetchedFragment;
+
+PrefetchedFragment* prefetched_fragment_free(PrefetchedFragment *p);
+DEFINE_TRIVIAL_CLEANUP_FUNC(PrefetchedFragment*, prefetched_fragment_free);
+
+/* Reads the specified files with up to n_threads threads, and adds the results to *fragments, keyed by
+ * path. Paths already in *fragments are skipped. */
+int fragment_prefetch(char **paths, unsigned n_threads, Hashmap **fragments);
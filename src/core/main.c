@@ -27,6 +27,7 @@
 #include "capability-util.h"
 #include "cgroup-util.h"
 #include "clock-util.h"
+#include "conf-files.h"
 #include "conf-parser.h"
 #include "cpu-set-util.h"
 #include "dbus-manager.h"
@@ -74,6 +75,7 @@
 #include "selinux-setup.h"
 #include "selinux-util.h"
 #include "signal-util.h"
+#include "siphash24.h"
 #include "smack-setup.h"
 #include "special.h"
 #include "stat-util.h"
@@ -106,6 +108,8 @@ static enum {
 
 static const char *arg_bus_introspect = NULL;
 
+#define CONFIG_FILES_HASH_KEY SD_ID128_MAKE(6a,d1,90,3e,57,c2,48,0f,8b,13,a9,e4,22,7d,c5,b6)
+
 /* Those variables are initialized to 0 automatically, so we avoid uninitialized memory access.  Real
  * defaults are assigned in reset_arguments() below. */
 static char *arg_default_unit;
@@ -158,10 +162,14 @@ static NUMAPolicy arg_numa_policy;
 static usec_t arg_clock_usec;
 static void *arg_random_seed;
 static size_t arg_random_seed_size;
+static bool arg_incremental_reload;
 
 /* A copy of the original environment block */
 static char **saved_env = NULL;
 
+/* Identifies the state of the configuration files when they were last parsed */
+static uint64_t config_files_hash = 0;
+
 static int parse_configuration(const struct rlimit *saved_rlimit_nofile,
                                const struct rlimit *saved_rlimit_memlock);
 
@@ -631,6 +639,66 @@ static int config_parse_default_timeout_abort(
         return 0;
 }
 
+static int config_file_paths(char ***ret_files, char ***ret_dirs, const char **ret_suffix) {
+        _cleanup_strv_free_ char **files = NULL, **dirs = NULL;
+        int r;
+
+        if (arg_system) {
+                files = strv_new(PKGSYSCONFDIR "/system.conf");
+                dirs = strv_copy(CONF_PATHS_STRV("systemd"));
+                if (!files || !dirs)
+                        return -ENOMEM;
+        } else {
+                r = manager_find_user_config_paths(&files, &dirs);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret_files = TAKE_PTR(files);
+        *ret_dirs = TAKE_PTR(dirs);
+        *ret_suffix = arg_system ? "system.conf.d" : "user.conf.d";
+        return 0;
+}
+
+static void config_file_hash_one(const char *path, struct siphash *state) {
+        struct stat st;
+
+        siphash24_compress(path, strlen(path) + 1, state);
+        if (stat(path, &st) < 0)
+                return;
+
+        siphash24_compress(&st.st_ino, sizeof(st.st_ino), state);
+        siphash24_compress_usec_t(timespec_load(&st.st_mtim), state);
+        siphash24_compress(&st.st_size, sizeof(st.st_size), state);
+}
+
+static int config_files_hash_compute(char **files, char **dirs, const char *suffix, uint64_t *ret) {
+        _cleanup_strv_free_ char **dropin_dirs = NULL, **dropins = NULL;
+        struct siphash state;
+        char **f;
+        int r;
+
+        assert(ret);
+
+        r = strv_extend_strv_concat(&dropin_dirs, dirs, strjoina("/", suffix));
+        if (r < 0)
+                return r;
+
+        r = conf_files_list_strv(&dropins, ".conf", NULL, 0, (const char* const*) dropin_dirs);
+        if (r < 0)
+                return r;
+
+        siphash24_init(&state, CONFIG_FILES_HASH_KEY.bytes);
+
+        STRV_FOREACH(f, files)
+                config_file_hash_one(*f, &state);
+        STRV_FOREACH(f, dropins)
+                config_file_hash_one(*f, &state);
+
+        *ret = siphash24_finalize(&state);
+        return 0;
+}
+
 static int parse_config_file(void) {
         const ConfigTableItem items[] = {
                 { "Manager", "LogLevel",                     config_parse_level2,                0, NULL                                   },
@@ -697,6 +765,7 @@ static int parse_config_file(void) {
                 { "Manager", "DefaultTasksMax",              config_parse_tasks_max,             0, &arg_default_tasks_max                 },
                 { "Manager", "CtrlAltDelBurstAction",        config_parse_emergency_action,      0, &arg_cad_burst_action                  },
                 { "Manager", "DefaultOOMPolicy",             config_parse_oom_policy,            0, &arg_default_oom_policy                },
+                { "Manager", "IncrementalReload",            config_parse_bool,                  0, &arg_incremental_reload                },
                 {}
         };
 
@@ -704,19 +773,20 @@ static int parse_config_file(void) {
         const char *suffix;
         int r;
 
-        if (arg_system)
-                suffix = "system.conf.d";
-        else {
-                r = manager_find_user_config_paths(&files, &dirs);
-                if (r < 0)
-                        return log_error_errno(r, "Failed to determine config file paths: %m");
+        r = config_file_paths(&files, &dirs, &suffix);
+        if (r < 0)
+                return log_error_errno(r, "Failed to determine config file paths: %m");
 
-                suffix = "user.conf.d";
+        /* Do this before parsing, so that changes made in between are noticed on the next reload */
+        r = config_files_hash_compute(files, dirs, suffix, &config_files_hash);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to hash configuration files, ignoring: %m");
+                config_files_hash = 0;
         }
 
         (void) config_parse_many(
-                        (const char* const*) (files ?: STRV_MAKE(PKGSYSCONFDIR "/system.conf")),
-                        (const char* const*) (dirs ?: CONF_PATHS_STRV("systemd")),
+                        (const char* const*) files,
+                        (const char* const*) dirs,
                         suffix,
                         "Manager\0",
                         config_item_table_lookup, items,
@@ -785,6 +855,7 @@ static void set_manager_settings(Manager *m) {
         m->confirm_spawn = arg_confirm_spawn;
         m->service_watchdogs = arg_service_watchdogs;
         m->cad_burst_action = arg_cad_burst_action;
+        m->incremental_reload = arg_incremental_reload;
 
         manager_set_watchdog(m, WATCHDOG_RUNTIME, arg_runtime_watchdog);
         manager_set_watchdog(m, WATCHDOG_REBOOT, arg_reboot_watchdog);
@@ -1879,6 +1950,7 @@ static int invoke_main_loop(
                 switch ((ManagerObjective) r) {
 
                 case MANAGER_RELOAD: {
+                        uint64_t old_config_files_hash;
                         LogTarget saved_log_target;
                         int saved_log_level;
 
@@ -1890,6 +1962,7 @@ static int invoke_main_loop(
                         saved_log_level = m->log_level_overridden ? log_get_max_level() : -1;
                         saved_log_target = m->log_target_overridden ? log_get_target() : _LOG_TARGET_INVALID;
 
+                        old_config_files_hash = config_files_hash;
                         (void) parse_configuration(saved_rlimit_nofile, saved_rlimit_memlock);
 
                         set_manager_defaults(m);
@@ -1903,7 +1976,14 @@ static int invoke_main_loop(
                         if (saved_log_target >= 0)
                                 manager_override_log_target(m, saved_log_target);
 
-                        r = manager_reload(m);
+                        /* The configuration supplies the defaults of all units, if it changed they all have to
+                         * be loaded again */
+                        if (arg_incremental_reload &&
+                            old_config_files_hash != 0 &&
+                            old_config_files_hash == config_files_hash)
+                                r = manager_reload_incremental(m);
+                        else
+                                r = manager_reload(m);
                         if (r < 0)
                                 /* Reloading failed before the point of no return. Let's continue running as if nothing happened. */
                                 m->objective = MANAGER_OK;
@@ -2368,6 +2448,7 @@ static void reset_arguments(void) {
         arg_machine_id = (sd_id128_t) {};
         arg_cad_burst_action = EMERGENCY_ACTION_REBOOT_FORCE;
         arg_default_oom_policy = OOM_STOP;
+        arg_incremental_reload = false;
 
         cpu_set_reset(&arg_cpu_affinity);
         numa_policy_reset(&arg_numa_policy);
@@ -30,6 +30,8 @@ void manager_dump_units(Manager *s, FILE *f, const char *prefix) {
 }
 
 void manager_dump(Manager *m, FILE *f, const char *prefix) {
+        char span[FORMAT_TIMESPAN_MAX];
+
         assert(m);
         assert(f);
 
@@ -48,6 +50,11 @@ void manager_dump(Manager *m, FILE *f, const char *prefix) {
                                                                 format_timespan(buf, sizeof buf, t->monotonic, 1));
         }
 
+        fprintf(f, "%sGC Runs: %" PRIu64 "\n", strempty(prefix), m->n_gc_runs);
+        fprintf(f, "%sGC Units Swept: %" PRIu64 "\n", strempty(prefix), m->n_gc_units_swept);
+        fprintf(f, "%sGC Time: %s\n", strempty(prefix), format_timespan(span, sizeof span, m->gc_usec, USEC_PER_MSEC));
+        fprintf(f, "%sUnits Freed: %" PRIu64 "\n", strempty(prefix), m->n_units_freed);
+
         manager_dump_units(m, f, prefix);
         manager_dump_jobs(m, f, prefix);
 }
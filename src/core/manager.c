@@ -30,6 +30,7 @@
 #include "clean-ipc.h"
 #include "clock-util.h"
 #include "core-varlink.h"
+#include "cpu-set-util.h"
 #include "creds-util.h"
 #include "dbus-job.h"
 #include "dbus-manager.h"
@@ -50,7 +51,9 @@
 #include "install.h"
 #include "io-util.h"
 #include "label.h"
+#include "load-cache.h"
 #include "load-fragment.h"
+#include "load-prefetch.h"
 #include "locale-setup.h"
 #include "log.h"
 #include "macro.h"
@@ -62,6 +65,7 @@
 #include "path-lookup.h"
 #include "path-util.h"
 #include "process-util.h"
+#include "random-util.h"
 #include "ratelimit.h"
 #include "rlimit-util.h"
 #include "rm-rf.h"
@@ -88,6 +92,7 @@
 #include "watchdog.h"
 
 #define NOTIFY_RCVBUF_SIZE (8*1024*1024)
+#define NOTIFY_BATCH_MAX 64U
 #define CGROUPS_AGENT_RCVBUF_SIZE (8*1024*1024)
 
 /* Initial delay and the interval for printing status messages about running jobs */
@@ -103,6 +108,9 @@
 /* How many units and jobs to process of the bus queue before returning to the event loop. */
 #define MANAGER_BUS_MESSAGE_BUDGET 100U
 
+/* Read unit files ahead on worker threads only if at least this many are waiting in the load queue */
+#define PREFETCH_BATCH_MIN 32U
+
 static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
 static int manager_dispatch_cgroups_agent_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
 static int manager_dispatch_signal_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata);
@@ -799,6 +807,7 @@ int manager_new(UnitFileScope scope, ManagerTestRunFlags test_run_flags, Manager
                 .private_listen_fd = -1,
                 .dev_autofs_fd = -1,
                 .cgroup_inotify_fd = -1,
+                .path_inotify_fd = -1,
                 .pin_cgroupfs_fd = -1,
                 .ask_password_inotify_fd = -1,
                 .idle_pipe = { -1, -1, -1, -1},
@@ -813,6 +822,12 @@ int manager_new(UnitFileScope scope, ManagerTestRunFlags test_run_flags, Manager
                 .default_oom_policy = OOM_STOP,
         };
 
+        /* Every manager instance counts unit changes from a random starting point, so that a generation
+         * handed out by a previous instance (i.e. before we were reexecuted or restarted) lies outside of
+         * the range this instance uses, and is not mistaken for one of ours. See
+         * method_list_units_changed_since(). Leave plenty of room for counting up. */
+        m->unit_change_generation = m->unit_remove_generation = random_u64() >> 1;
+
 #if ENABLE_EFI
         if (MANAGER_IS_SYSTEM(m) && detect_container() <= 0)
                 boot_timestamps(m->timestamps + MANAGER_TIMESTAMP_USERSPACE,
@@ -1136,6 +1151,8 @@ static unsigned manager_dispatch_cleanup_queue(Manager *m) {
                 n++;
         }
 
+        m->n_units_freed += n;
+
         return n;
 }
 
@@ -1221,12 +1238,18 @@ good:
 
 static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
         unsigned n = 0, gc_marker;
+        usec_t start;
         Unit *u;
 
         assert(m);
 
+        if (!m->gc_unit_queue)
+                return 0;
+
         /* log_debug("Running GC..."); */
 
+        start = now(CLOCK_MONOTONIC);
+
         m->gc_marker += _GC_OFFSET_MAX;
         if (m->gc_marker + _GC_OFFSET_MAX <= _GC_OFFSET_MAX)
                 m->gc_marker = 1;
@@ -1252,6 +1275,10 @@ static unsigned manager_dispatch_gc_unit_queue(Manager *m) {
                 }
         }
 
+        m->n_gc_runs++;
+        m->n_gc_units_swept += n;
+        m->gc_usec += usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+
         return n;
 }
 
@@ -1446,6 +1473,7 @@ Manager* manager_free(Manager *m) {
 
         dynamic_user_vacuum(m, false);
         hashmap_free(m->dynamic_users);
+        hashmap_free(m->dynamic_users_by_uid);
 
         hashmap_free(m->units);
         hashmap_free(m->units_by_invocation_id);
@@ -1488,6 +1516,7 @@ Manager* manager_free(Manager *m) {
 
         hashmap_free(m->cgroup_unit);
         manager_free_unit_name_maps(m);
+        hashmap_free(m->load_cache);
 
         free(m->switch_root);
         free(m->switch_root_init);
@@ -1700,6 +1729,23 @@ static void manager_reloading_stopp(Manager **m) {
         }
 }
 
+static void manager_hash_dependency_dirs(Manager *m) {
+        int r;
+
+        assert(m);
+
+        m->dependency_dirs_hash = 0;
+
+        if (!m->incremental_reload)
+                return;
+
+        r = lookup_paths_hash_dependency_dirs(&m->lookup_paths, &m->dependency_dirs_hash);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to hash unit dependency directories, ignoring: %m");
+                m->dependency_dirs_hash = 0;
+        }
+}
+
 int manager_startup(Manager *m, FILE *serialization, FDSet *fds) {
         int r;
 
@@ -1725,6 +1771,8 @@ int manager_startup(Manager *m, FILE *serialization, FDSet *fds) {
 
         lookup_paths_log(&m->lookup_paths);
 
+        manager_hash_dependency_dirs(m);
+
         {
                 /* This block is (optionally) done with the reloading counter bumped */
                 _cleanup_(manager_reloading_stopp) Manager *reloading = NULL;
@@ -1982,6 +2030,60 @@ static int manager_dispatch_target_deps_queue(Manager *m) {
         return r;
 }
 
+static void manager_prefetch_load_queue(Manager *m) {
+        _cleanup_strv_free_ char **paths = NULL;
+        size_t n = 0, n_paths = 0;
+        int r;
+
+        assert(m);
+
+        /* Units are prepended to the load queue, hence the ones we haven't looked at yet are always at the
+         * front. Don't bother with small batches, they are typically dependencies trickling in one by one
+         * while the queue is processed, and starting threads for them is not worth it. */
+        for (Unit *u = m->load_queue; u && !u->load_prefetched; u = u->load_queue_next)
+                n++;
+        if (n < PREFETCH_BATCH_MIN) {
+                for (Unit *u = m->load_queue; u && !u->load_prefetched; u = u->load_queue_next)
+                        u->load_prefetched = true;
+                return;
+        }
+
+        r = unit_file_build_name_map(&m->lookup_paths,
+                                     &m->unit_cache_timestamp_hash,
+                                     &m->unit_id_map,
+                                     &m->unit_name_map,
+                                     &m->unit_path_cache);
+        if (r < 0)
+                return (void) log_debug_errno(r, "Failed to rebuild name map, not prefetching unit files: %m");
+
+        paths = new0(char*, n + 1);
+        if (!paths)
+                return (void) log_oom_debug();
+
+        for (Unit *u = m->load_queue; u && !u->load_prefetched; u = u->load_queue_next) {
+                _cleanup_set_free_free_ Set *names = NULL;
+                const char *fragment;
+
+                u->load_prefetched = true;
+
+                if (u->transient || u->load_state != UNIT_STUB)
+                        continue;
+
+                r = unit_file_find_fragment(m->unit_id_map, m->unit_name_map, u->id, &fragment, &names);
+                if (r < 0 || !fragment)
+                        continue;
+
+                paths[n_paths] = strdup(fragment);
+                if (!paths[n_paths])
+                        return (void) log_oom_debug();
+                n_paths++;
+        }
+
+        r = fragment_prefetch(paths, MAX(cpus_in_affinity_mask(), 1), &m->prefetched_fragments);
+        if (r < 0)
+                log_debug_errno(r, "Failed to prefetch unit files, ignoring: %m");
+}
+
 unsigned manager_dispatch_load_queue(Manager *m) {
         Unit *u;
         unsigned n = 0;
@@ -2000,10 +2102,14 @@ unsigned manager_dispatch_load_queue(Manager *m) {
         while ((u = m->load_queue)) {
                 assert(u->in_load_queue);
 
+                if (!u->load_prefetched)
+                        manager_prefetch_load_queue(m);
+
                 unit_load(u);
                 n++;
         }
 
+        m->prefetched_fragments = hashmap_free(m->prefetched_fragments);
         m->dispatching_load_queue = false;
 
         /* Dispatch the units waiting for their target dependencies to be added now, as all targets that we know about
@@ -2353,10 +2459,9 @@ static void manager_invoke_notify_message(
         }
 }
 
-static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+static int manager_receive_notify_message(Manager *m, Set **watchdog_pids) {
 
         _cleanup_fdset_free_ FDSet *fds = NULL;
-        Manager *m = userdata;
         char buf[NOTIFY_BUFFER_MAX+1];
         struct iovec iovec = {
                 .iov_base = buf,
@@ -2382,19 +2487,14 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         ssize_t n;
 
         assert(m);
-        assert(m->notify_fd == fd);
-
-        if (revents != EPOLLIN) {
-                log_warning("Got unexpected poll event for notify fd.");
-                return 0;
-        }
+        assert(watchdog_pids);
 
         n = recvmsg_safe(m->notify_fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC|MSG_TRUNC);
         if (IN_SET(n, -EAGAIN, -EINTR))
-                return 0; /* Spurious wakeup, try again */
+                return 0; /* Spurious wakeup or nothing left, try again */
         if (n == -EXFULL) {
                 log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
-                return 0;
+                return 1;
         }
         if (n < 0)
                 /* If this is any other, real error, then let's stop processing this socket. This of course
@@ -2426,25 +2526,25 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
                 if (r < 0) {
                         close_many(fd_array, n_fds);
                         log_oom();
-                        return 0;
+                        return 1;
                 }
         }
 
         if (!ucred || !pid_is_valid(ucred->pid)) {
                 log_warning("Received notify message without valid credentials. Ignoring.");
-                return 0;
+                return 1;
         }
 
         if ((size_t) n >= sizeof(buf) || (msghdr.msg_flags & MSG_TRUNC)) {
                 log_warning("Received notify message exceeded maximum size. Ignoring.");
-                return 0;
+                return 1;
         }
 
         /* As extra safety check, let's make sure the string we get doesn't contain embedded NUL bytes. We permit one
          * trailing NUL byte in the message, but don't expect it. */
         if (n > 1 && memchr(buf, 0, n-1)) {
                 log_warning("Received notify message with embedded NUL bytes. Ignoring.");
-                return 0;
+                return 1;
         }
 
         /* Make sure it's NUL-terminated, then parse it to obtain the tags list */
@@ -2452,12 +2552,21 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         tags = strv_split_newlines(buf);
         if (!tags) {
                 log_oom();
-                return 0;
+                return 1;
         }
 
         /* possibly a barrier fd, let's see */
         if (manager_process_barrier_fd(tags, fds))
-                return 0;
+                return 1;
+
+        /* Services with short watchdog intervals might queue up several keep-alive pings before we get to
+         * process them. Handling one of them per batch is enough, the others wouldn't change anything. */
+        if (strv_equal(tags, STRV_MAKE("WATCHDOG=1")) && fdset_isempty(fds)) {
+                if (set_contains(*watchdog_pids, PID_TO_PTR(ucred->pid)))
+                        return 1;
+
+                (void) set_ensure_put(watchdog_pids, NULL, PID_TO_PTR(ucred->pid));
+        }
 
         /* Increase the generation counter used for filtering out duplicate unit invocations. */
         m->notifygen++;
@@ -2498,6 +2607,31 @@ static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t
         if (fdset_size(fds) > 0)
                 log_warning("Got extra auxiliary fds with notification message, closing them.");
 
+        return 1;
+}
+
+static int manager_dispatch_notify_fd(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+        _cleanup_set_free_ Set *watchdog_pids = NULL;
+        Manager *m = userdata;
+        int r;
+
+        assert(m);
+        assert(m->notify_fd == fd);
+
+        if (revents != EPOLLIN) {
+                log_warning("Got unexpected poll event for notify fd.");
+                return 0;
+        }
+
+        /* Process a batch of messages per wakeup rather than a single one, so that busy notification
+         * sockets don't cost us an event loop iteration per datagram. The limit ensures that other event
+         * sources still get their turn. */
+        for (unsigned i = 0; i < NOTIFY_BATCH_MAX; i++) {
+                r = manager_receive_notify_message(m, &watchdog_pids);
+                if (r <= 0)
+                        return r;
+        }
+
         return 0;
 }
 
@@ -2546,18 +2680,23 @@ static int manager_dispatch_sigchld(sd_event_source *source, void *userdata) {
 
         if (IN_SET(si.si_code, CLD_EXITED, CLD_KILLED, CLD_DUMPED)) {
                 _cleanup_free_ Unit **array_copy = NULL;
-                _cleanup_free_ char *name = NULL;
                 Unit *u1, *u2, **array;
 
-                (void) get_process_comm(si.si_pid, &name);
+                /* Reading the process name from /proc is not free, and we might be reaping a lot of
+                 * processes at once, hence only do so if we'll actually log it. */
+                if (DEBUG_LOGGING) {
+                        _cleanup_free_ char *name = NULL;
 
-                log_debug("Child "PID_FMT" (%s) died (code=%s, status=%i/%s)",
-                          si.si_pid, strna(name),
-                          sigchld_code_to_string(si.si_code),
-                          si.si_status,
-                          strna(si.si_code == CLD_EXITED
-                                ? exit_status_to_string(si.si_status, EXIT_STATUS_FULL)
-                                : signal_to_string(si.si_status)));
+                        (void) get_process_comm(si.si_pid, &name);
+
+                        log_debug("Child "PID_FMT" (%s) died (code=%s, status=%i/%s)",
+                                  si.si_pid, strna(name),
+                                  sigchld_code_to_string(si.si_code),
+                                  si.si_status,
+                                  strna(si.si_code == CLD_EXITED
+                                        ? exit_status_to_string(si.si_status, EXIT_STATUS_FULL)
+                                        : signal_to_string(si.si_status)));
+                }
 
                 /* Increase the generation counter used for filtering out duplicate unit invocations */
                 m->sigchldgen++;
@@ -3765,7 +3904,7 @@ int manager_deserialize(Manager *m, FILE *f, FDSet *fds) {
         return manager_deserialize_units(m, f, fds);
 }
 
-int manager_reload(Manager *m) {
+static int manager_reload_internal(Manager *m, bool generators_done) {
         _cleanup_(manager_reloading_stopp) Manager *reloading = NULL;
         _cleanup_fdset_free_ FDSet *fds = NULL;
         _cleanup_fclose_ FILE *f = NULL;
@@ -3801,7 +3940,9 @@ int manager_reload(Manager *m) {
          * it. */
 
         manager_clear_jobs_and_units(m);
-        lookup_paths_flush_generator(&m->lookup_paths);
+        m->load_cache_generation++;
+        if (!generators_done)
+                lookup_paths_flush_generator(&m->lookup_paths);
         lookup_paths_free(&m->lookup_paths);
         exec_runtime_vacuum(m);
         dynamic_user_vacuum(m, false);
@@ -3812,11 +3953,15 @@ int manager_reload(Manager *m) {
         if (r < 0)
                 log_warning_errno(r, "Failed to initialize path lookup table, ignoring: %m");
 
-        (void) manager_run_environment_generators(m);
-        (void) manager_run_generators(m);
+        if (!generators_done) {
+                (void) manager_run_environment_generators(m);
+                (void) manager_run_generators(m);
+        }
 
         lookup_paths_log(&m->lookup_paths);
 
+        manager_hash_dependency_dirs(m);
+
         /* We flushed out generated files, for which we don't watch mtime, so we should flush the old map. */
         manager_free_unit_name_maps(m);
 
@@ -3843,6 +3988,9 @@ int manager_reload(Manager *m) {
         /* Clean up runtime objects no longer referenced */
         manager_vacuum(m);
 
+        /* Forget about unit files that weren't looked at during this reload */
+        manager_load_cache_trim(m);
+
         /* Clean up deserialized tracked clients */
         m->deserialized_subscribed = strv_free(m->deserialized_subscribed);
 
@@ -3861,6 +4009,150 @@ int manager_reload(Manager *m) {
         return 0;
 }
 
+int manager_reload(Manager *m) {
+        return manager_reload_internal(m, false);
+}
+
+static bool manager_unit_id_maps_equal(Hashmap *a, Hashmap *b) {
+        const char *k, *v;
+
+        if (hashmap_size(a) != hashmap_size(b))
+                return false;
+
+        HASHMAP_FOREACH_KEY(v, k, a)
+                if (!streq_ptr(v, hashmap_get(b, k)))
+                        return false;
+
+        return true;
+}
+
+static bool manager_units_changed(Manager *m, char **generated) {
+        _cleanup_hashmap_free_ Hashmap *old_id_map = NULL;
+        uint64_t old_timestamp_hash, h;
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(m);
+
+        /* Returns true unless it can be shown that nothing the units were loaded from changed */
+
+        /* Dependencies from .wants/ and .requires/ symlinks are not recorded anywhere in the units */
+        if (m->dependency_dirs_hash == 0) {
+                log_debug("State of unit dependency directories unknown.");
+                return true;
+        }
+
+        r = lookup_paths_hash_dependency_dirs(&m->lookup_paths, &h);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to hash unit dependency directories: %m");
+                return true;
+        }
+        if (h != m->dependency_dirs_hash) {
+                log_debug("Unit dependency directories changed.");
+                return true;
+        }
+
+        /* Rebuild the name maps from scratch, any new, removed or re-linked unit file shows up there */
+        old_timestamp_hash = m->unit_cache_timestamp_hash;
+        old_id_map = TAKE_PTR(m->unit_id_map);
+        manager_free_unit_name_maps(m);
+
+        r = unit_file_build_name_map(&m->lookup_paths,
+                                     &m->unit_cache_timestamp_hash,
+                                     &m->unit_id_map,
+                                     &m->unit_name_map,
+                                     &m->unit_path_cache);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to rebuild unit name map: %m");
+                return true;
+        }
+
+        if (old_timestamp_hash == 0 || old_timestamp_hash != m->unit_cache_timestamp_hash) {
+                log_debug("Unit search path directories changed.");
+                return true;
+        }
+
+        if (!manager_unit_id_maps_equal(old_id_map, m->unit_id_map)) {
+                log_debug("Set of unit files changed.");
+                return true;
+        }
+
+        HASHMAP_FOREACH_KEY(u, k, m->units) {
+                if (k != u->id)
+                        continue;
+
+                if (unit_need_daemon_reload_full(u, generated)) {
+                        log_unit_debug(u, "Unit files changed.");
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+int manager_reload_incremental(Manager *m) {
+        _cleanup_strv_free_ char **env = NULL;
+        char **generated;
+        uint64_t before, after;
+        const char *k;
+        Unit *u;
+        int r;
+
+        assert(m);
+
+        /* Reruns the generators, and then only does a full reload if anything the units were loaded from
+         * changed: the generator output or environment, the set of unit files, or any file a loaded unit
+         * was read from. Otherwise the units and jobs stay as they are. The caller has to make sure that
+         * the manager configuration itself didn't change, since it supplies the unit defaults. */
+
+        r = lookup_paths_hash_generator(&m->lookup_paths, &before);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to hash generator output, doing full reload: %m");
+                return manager_reload(m);
+        }
+
+        env = strv_copy(m->transient_environment);
+        if (!env)
+                return log_oom();
+
+        (void) manager_run_environment_generators(m);
+        lookup_paths_flush_generator(&m->lookup_paths);
+        (void) manager_run_generators(m);
+
+        if (!strv_equal(env, m->transient_environment)) {
+                log_debug("Environment generator output changed, doing full reload.");
+                return manager_reload_internal(m, true);
+        }
+
+        r = lookup_paths_hash_generator(&m->lookup_paths, &after);
+        if (r < 0 || before != after) {
+                log_debug("Generator output changed, doing full reload.");
+                return manager_reload_internal(m, true);
+        }
+
+        generated = STRV_MAKE(m->lookup_paths.generator,
+                              m->lookup_paths.generator_early,
+                              m->lookup_paths.generator_late);
+
+        if (manager_units_changed(m, generated))
+                return manager_reload_internal(m, true);
+
+        /* The generated files were recreated with the same contents, make sure the units don't claim they
+         * need a reload because of that. */
+        HASHMAP_FOREACH_KEY(u, k, m->units)
+                if (k == u->id)
+                        unit_refresh_file_mtimes(u, generated);
+
+        log_info("No unit files changed, skipping full reload.");
+
+        /* Tell clients about this as if it was a full reload, some wait for the Reloading signal */
+        bus_manager_send_reloading(m, true);
+        m->send_reloading_done = true;
+
+        return 0;
+}
+
 void manager_reset_failed(Manager *m) {
         Unit *u;
 
@@ -4114,6 +4406,25 @@ static int manager_run_environment_generators(Manager *m) {
         return r;
 }
 
+static unsigned generators_max_parallel(void) {
+        const char *e;
+        unsigned n;
+
+        /* By default all generators are run at the same time. On systems with many expensive generators
+         * this might be more than the machine can handle well during early boot, hence allow limiting it. */
+
+        e = secure_getenv("SYSTEMD_GENERATORS_MAX_PARALLEL");
+        if (!e)
+                return 0;
+
+        if (safe_atou(e, &n) < 0) {
+                log_warning("Failed to parse $SYSTEMD_GENERATORS_MAX_PARALLEL value, ignoring: %s", e);
+                return 0;
+        }
+
+        return n;
+}
+
 static int manager_run_generators(Manager *m) {
         _cleanup_strv_free_ char **paths = NULL;
         const char *argv[5];
@@ -4144,9 +4455,10 @@ static int manager_run_generators(Manager *m) {
         argv[4] = NULL;
 
         RUN_WITH_UMASK(0022)
-                (void) execute_directories((const char* const*) paths, DEFAULT_TIMEOUT_USEC, NULL, NULL,
-                                           (char**) argv, m->transient_environment,
-                                           EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID);
+                (void) execute_directories_full((const char* const*) paths, DEFAULT_TIMEOUT_USEC, NULL, NULL,
+                                                (char**) argv, m->transient_environment,
+                                                EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS | EXEC_DIR_SET_SYSTEMD_EXEC_PID,
+                                                generators_max_parallel());
 
         r = 0;
 
@@ -241,6 +241,17 @@ struct Manager {
         Set *unit_path_cache;
         uint64_t unit_cache_timestamp_hash;
 
+        /* Identifies the contents of the .wants/ and .requires/ directories the units were loaded with, only
+         * maintained if incremental_reload is set. 0 if unknown. */
+        uint64_t dependency_dirs_hash;
+
+        /* Unit fragments read ahead while dispatching the load queue, see load-prefetch.h */
+        Hashmap *prefetched_fragments;
+
+        /* Parsed unit files and drop-ins, kept across reloads, see load-cache.h */
+        Hashmap *load_cache;
+        unsigned load_cache_generation;
+
         char **transient_environment;  /* The environment, as determined from config files, kernel cmdline and environment generators */
         char **client_environment;     /* Environment variables created by clients through the bus API */
 
@@ -305,6 +316,12 @@ struct Manager {
         Hashmap *cgroup_control_inotify_wd_unit;
         Hashmap *cgroup_memory_inotify_wd_unit;
 
+        /* The inotify fd shared by the PathSpecs of all path units and PID file watches, and a map from
+         * each watch descriptor to the Set of PathSpecs interested in it. */
+        int path_inotify_fd;
+        sd_event_source *path_inotify_event_source;
+        Hashmap *path_inotify_wd_specs;
+
         /* A defer event for handling cgroup empty events and processing them after SIGCHLD in all cases. */
         sd_event_source *cgroup_empty_event_source;
         sd_event_source *cgroup_oom_event_source;
@@ -315,6 +332,12 @@ struct Manager {
 
         unsigned gc_marker;
 
+        /* Statistics about unit garbage collection, shown by "systemd-analyze dump" */
+        uint64_t n_gc_runs;
+        uint64_t n_gc_units_swept;
+        uint64_t n_units_freed;
+        usec_t gc_usec;
+
         /* The stat() data the last time we saw /etc/localtime */
         usec_t etc_localtime_mtime;
         bool etc_localtime_accessible;
@@ -348,6 +371,7 @@ struct Manager {
         char *confirm_spawn;
         bool no_console_output;
         bool service_watchdogs;
+        bool incremental_reload;
 
         ExecOutput default_std_output, default_std_error;
 
@@ -410,6 +434,9 @@ struct Manager {
 
         /* Dynamic users/groups, indexed by their name */
         Hashmap *dynamic_users;
+        /* The same, indexed by the UID they were last seen with. Filled in by lookups, and verified against
+         * the storage socket on each use, since allocation happens in forked children we never hear from. */
+        Hashmap *dynamic_users_by_uid;
 
         /* Keep track of all UIDs and GIDs any of our services currently use. This is useful for the RemoveIPC= logic. */
         Hashmap *uid_refs;
@@ -439,6 +466,13 @@ struct Manager {
         unsigned sigchldgen;
         unsigned notifygen;
 
+        /* Bumped whenever a unit changes in a way that is visible on the bus, and stamped into the unit
+         * (see Unit.change_generation), so that clients can ask for the units changed since a previous
+         * query. The second one is the value of the counter when a unit was last removed. Both start out
+         * at the same random value. */
+        uint64_t unit_change_generation;
+        uint64_t unit_remove_generation;
+
         bool honor_device_enumeration;
 
         VarlinkServer *varlink_server;
@@ -451,6 +485,17 @@ static inline usec_t manager_default_timeout_abort_usec(Manager *m) {
         return m->default_timeout_abort_set ? m->default_timeout_abort_usec : m->default_timeout_stop_usec;
 }
 
+static inline bool manager_unit_generation_is_stale(Manager *m, uint64_t since) {
+        assert(m);
+
+        /* If units were removed after 'since', or it is not a generation of this instance of the manager
+         * (e.g. because we were reexecuted), a client cannot just be told about the units changed since
+         * then, it needs to start over with a full list. Each instance starts counting at a random value,
+         * hence a generation of another instance is below unit_remove_generation or above
+         * unit_change_generation. */
+        return since == 0 || since < m->unit_remove_generation || since > m->unit_change_generation;
+}
+
 #define MANAGER_IS_SYSTEM(m) ((m)->unit_file_scope == UNIT_FILE_SYSTEM)
 #define MANAGER_IS_USER(m) ((m)->unit_file_scope != UNIT_FILE_SYSTEM)
 
@@ -506,6 +551,7 @@ int manager_serialize(Manager *m, FILE *f, FDSet *fds, bool switching_root);
 int manager_deserialize(Manager *m, FILE *f, FDSet *fds);
 
 int manager_reload(Manager *m);
+int manager_reload_incremental(Manager *m);
 
 void manager_reset_failed(Manager *m);
 
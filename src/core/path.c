@@ -32,9 +32,118 @@ static const UnitActiveState state_translation_table[_PATH_STATE_MAX] = {
         [PATH_FAILED] = UNIT_FAILED,
 };
 
-static int path_dispatch_io(sd_event_source *source, int fd, uint32_t revents, void *userdata);
+static int path_dispatch_io(PathSpec *s, bool changed);
+static int path_dispatch_inotify(sd_event_source *source, int fd, uint32_t revents, void *userdata);
 
-int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler) {
+static int path_inotify_setup(Manager *m) {
+        _cleanup_close_ int fd = -1;
+        int r;
+
+        assert(m);
+
+        if (m->path_inotify_fd >= 0)
+                return 0;
+
+        /* All PathSpecs of all units share one inotify fd, so that watches of the same inode are installed
+         * only once, and the number of inotify instances doesn't grow with the number of path units. */
+
+        fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+        if (fd < 0)
+                return log_error_errno(errno, "Failed to allocate inotify fd: %m");
+
+        r = sd_event_add_io(m->event, &m->path_inotify_event_source, fd, EPOLLIN, path_dispatch_inotify, m);
+        if (r < 0)
+                return log_error_errno(r, "Failed to add inotify fd to event loop: %m");
+
+        (void) sd_event_source_set_description(m->path_inotify_event_source, "path-inotify");
+
+        m->path_inotify_fd = TAKE_FD(fd);
+        return 0;
+}
+
+static int path_spec_add_watch(PathSpec *s, int wd, uint32_t mask) {
+        Manager *m;
+        Set *specs;
+        int r;
+
+        assert(s);
+        assert(wd >= 0);
+
+        m = s->unit->manager;
+
+        mask &= IN_ALL_EVENTS;
+
+        for (size_t i = 0; i < s->n_watches; i++)
+                if (s->watches[i].wd == wd) {
+                        s->watches[i].mask |= mask;
+                        return 0;
+                }
+
+        if (!GREEDY_REALLOC(s->watches, s->n_watches + 1))
+                return log_oom();
+
+        specs = hashmap_get(m->path_inotify_wd_specs, INT_TO_PTR(wd));
+        if (!specs) {
+                _cleanup_set_free_ Set *n = NULL;
+
+                n = set_new(NULL);
+                if (!n)
+                        return log_oom();
+
+                r = hashmap_ensure_put(&m->path_inotify_wd_specs, NULL, INT_TO_PTR(wd), n);
+                if (r < 0)
+                        return log_oom();
+
+                specs = TAKE_PTR(n);
+        }
+
+        r = set_put(specs, s);
+        if (r < 0) {
+                if (set_isempty(specs))
+                        set_free(hashmap_remove(m->path_inotify_wd_specs, INT_TO_PTR(wd)));
+                return log_oom();
+        }
+
+        s->watches[s->n_watches++] = (PathSpecWatch) {
+                .wd = wd,
+                .mask = mask,
+        };
+        return 0;
+}
+
+static uint32_t path_spec_watch_mask(PathSpec *s, int wd) {
+        assert(s);
+
+        for (size_t i = 0; i < s->n_watches; i++)
+                if (s->watches[i].wd == wd)
+                        return s->watches[i].mask;
+
+        return 0;
+}
+
+static int path_spec_inotify_add_watch(PathSpec *s, const char *path, uint32_t mask) {
+        int wd, r;
+
+        assert(s);
+        assert(path);
+
+        /* Other PathSpecs might watch the same inode already, hence never replace the mask, extend it */
+        wd = inotify_add_watch(s->unit->manager->path_inotify_fd, path, mask|IN_MASK_ADD);
+        if (wd < 0)
+                return -errno;
+
+        r = path_spec_add_watch(s, wd, mask);
+        if (r < 0) {
+                /* Don't leave the watch behind if nobody else uses it */
+                if (!hashmap_contains(s->unit->manager->path_inotify_wd_specs, INT_TO_PTR(wd)))
+                        (void) inotify_rm_watch(s->unit->manager->path_inotify_fd, wd);
+                return r;
+        }
+
+        return wd;
+}
+
+int path_spec_watch(PathSpec *s, PathSpecHandler handler) {
         static const int flags_table[_PATH_TYPE_MAX] = {
                 [PATH_EXISTS]              = IN_DELETE_SELF|IN_MOVE_SELF|IN_ATTRIB,
                 [PATH_EXISTS_GLOB]         = IN_DELETE_SELF|IN_MOVE_SELF|IN_ATTRIB,
@@ -53,19 +162,11 @@ int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler) {
 
         path_spec_unwatch(s);
 
-        s->inotify_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
-        if (s->inotify_fd < 0) {
-                r = log_error_errno(errno, "Failed to allocate inotify fd: %m");
-                goto fail;
-        }
-
-        r = sd_event_add_io(s->unit->manager->event, &s->event_source, s->inotify_fd, EPOLLIN, handler, s);
-        if (r < 0) {
-                log_error_errno(r, "Failed to add inotify fd to event loop: %m");
-                goto fail;
-        }
+        r = path_inotify_setup(s->unit->manager);
+        if (r < 0)
+                return r;
 
-        (void) sd_event_source_set_description(s->event_source, "path");
+        s->handler = handler;
 
         /* This function assumes the path was passed through path_simplify()! */
         assert(!strstr(s->path, "//"));
@@ -94,23 +195,27 @@ int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler) {
 
                         SET_FLAG(f, IN_DONT_FOLLOW, !follow_symlink);
 
-                        wd = inotify_add_watch(s->inotify_fd, s->path, f);
+                        wd = path_spec_inotify_add_watch(s, s->path, f);
                         if (wd < 0) {
-                                if (IN_SET(errno, EACCES, ENOENT)) {
+                                if (IN_SET(wd, -EACCES, -ENOENT)) {
                                         incomplete = true; /* This is an expected error, let's accept this
                                                             * quietly: we have an incomplete watch for
                                                             * now. */
+                                        r = wd;
                                         break;
                                 }
 
                                 /* This second call to inotify_add_watch() should fail like the previous one
                                  * and is done for logging the error in a comprehensive way. */
-                                wd = inotify_add_watch_and_warn(s->inotify_fd, s->path, f);
-                                if (wd < 0) {
+                                wd = inotify_add_watch_and_warn(s->unit->manager->path_inotify_fd, s->path, f|IN_MASK_ADD);
+                                if (wd >= 0)
+                                        r = path_spec_add_watch(s, wd, f);
+                                else
+                                        r = wd;
+                                if (r < 0) {
                                         if (cut)
                                                 *cut = tmp;
 
-                                        r = wd;
                                         goto fail;
                                 }
 
@@ -133,7 +238,7 @@ int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler) {
                         char tmp2 = *cut2;
                         *cut2 = '\0';
 
-                        (void) inotify_add_watch(s->inotify_fd, s->path, IN_MOVE_SELF);
+                        (void) path_spec_inotify_add_watch(s, s->path, IN_MOVE_SELF);
                         /* Error is ignored, the worst can happen is we get spurious events. */
 
                         *cut2 = tmp2;
@@ -152,8 +257,8 @@ int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler) {
         }
 
         if (!exists) {
-                r = log_error_errno(errno, "Failed to add watch on any of the components of %s: %m", s->path);
                 /* either EACCESS or ENOENT */
+                r = log_error_errno(r, "Failed to add watch on any of the components of %s: %m", s->path);
                 goto fail;
         }
 
@@ -165,39 +270,118 @@ fail:
 }
 
 void path_spec_unwatch(PathSpec *s) {
+        Manager *m;
+
         assert(s);
 
-        s->event_source = sd_event_source_disable_unref(s->event_source);
-        s->inotify_fd = safe_close(s->inotify_fd);
+        m = s->unit->manager;
+
+        /* Drop our reference to each watch descriptor, and remove the watch only when no other PathSpec
+         * is interested in it anymore. */
+        for (size_t i = 0; i < s->n_watches; i++) {
+                int wd = s->watches[i].wd;
+                Set *specs;
+
+                specs = hashmap_get(m->path_inotify_wd_specs, INT_TO_PTR(wd));
+                if (!specs)
+                        continue;
+
+                set_remove(specs, s);
+                if (!set_isempty(specs))
+                        continue;
+
+                assert_se(hashmap_remove(m->path_inotify_wd_specs, INT_TO_PTR(wd)) == specs);
+                set_free(specs);
+
+                /* Fails with EINVAL if the watch was removed by the kernel already */
+                (void) inotify_rm_watch(m->path_inotify_fd, wd);
+        }
+
+        s->watches = mfree(s->watches);
+        s->n_watches = 0;
+        s->handler = NULL;
 }
 
-int path_spec_fd_event(PathSpec *s, uint32_t revents) {
-        union inotify_event_buffer buffer;
-        struct inotify_event *e;
-        ssize_t l;
+static int path_dispatch_inotify(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
+        _cleanup_hashmap_free_ Hashmap *pending = NULL;
+        Manager *m = userdata;
+        bool overflow = false;
+        void *changed;
+        PathSpec *s;
+        Set *specs;
 
-        assert(s);
+        assert(m);
+        assert(fd >= 0);
 
-        if (revents != EPOLLIN)
-                return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
-                                       "Got invalid poll event on inotify.");
+        if (revents != EPOLLIN) {
+                log_error("Got invalid poll event on inotify.");
+                return 0;
+        }
 
-        l = read(s->inotify_fd, &buffer, sizeof(buffer));
-        if (l < 0) {
-                if (IN_SET(errno, EAGAIN, EINTR))
-                        return 0;
+        /* First drain the queue and collect the PathSpecs that had events, so that each is dispatched only
+         * once per batch, however many of its watches were hit. */
+
+        for (;;) {
+                union inotify_event_buffer buffer;
+                struct inotify_event *e;
+                ssize_t l;
+
+                l = read(fd, &buffer, sizeof(buffer));
+                if (l < 0) {
+                        if (!IN_SET(errno, EAGAIN, EINTR))
+                                log_error_errno(errno, "Failed to read inotify event: %m");
+                        break;
+                }
 
-                return log_error_errno(errno, "Failed to read inotify event: %m");
+                FOREACH_INOTIFY_EVENT(e, buffer, l) {
+                        if (e->wd < 0) {
+                                /* Queue overflow, we lost events. Let everybody recheck. */
+                                overflow = true;
+                                continue;
+                        }
+
+                        specs = hashmap_get(m->path_inotify_wd_specs, INT_TO_PTR(e->wd));
+                        SET_FOREACH(s, specs) {
+                                bool c;
+
+                                /* The mask of a shared watch is the union of what all PathSpecs asked for,
+                                 * skip events this one didn't ask for. */
+                                if (!(e->mask & (path_spec_watch_mask(s, e->wd) | IN_IGNORED | IN_UNMOUNT)))
+                                        continue;
+
+                                c = IN_SET(s->type, PATH_CHANGED, PATH_MODIFIED) && s->primary_wd == e->wd;
+
+                                if (hashmap_ensure_put(&pending, NULL, s, INT_TO_PTR(c)) == -EEXIST && c)
+                                        (void) hashmap_update(pending, s, INT_TO_PTR(true));
+                        }
+                }
         }
 
-        if (IN_SET(s->type, PATH_CHANGED, PATH_MODIFIED))
-                FOREACH_INOTIFY_EVENT(e, buffer, l)
-                        if (s->primary_wd == e->wd)
-                                return 1;
+        if (overflow)
+                HASHMAP_FOREACH(specs, m->path_inotify_wd_specs)
+                        SET_FOREACH(s, specs)
+                                (void) hashmap_ensure_put(&pending, NULL, s, INT_TO_PTR(false));
+
+        /* Handlers rewatch or unwatch PathSpecs, but only ever free their own one. Skip those that are
+         * not watched anymore by the time we get to them. */
+        HASHMAP_FOREACH_KEY(changed, s, pending) {
+                if (!s->handler)
+                        continue;
+
+                (void) s->handler(s, PTR_TO_INT(changed));
+        }
 
         return 0;
 }
 
+static void path_shutdown(Manager *m) {
+        assert(m);
+
+        m->path_inotify_event_source = sd_event_source_disable_unref(m->path_inotify_event_source);
+        m->path_inotify_fd = safe_close(m->path_inotify_fd);
+        m->path_inotify_wd_specs = hashmap_free_with_destructor(m->path_inotify_wd_specs, set_free);
+}
+
 static bool path_spec_check_good(PathSpec *s, bool initial, bool from_trigger_notify) {
         bool b, good = false;
 
@@ -253,7 +437,8 @@ static void path_spec_dump(PathSpec *s, FILE *f, const char *prefix) {
 
 void path_spec_done(PathSpec *s) {
         assert(s);
-        assert(s->inotify_fd == -1);
+        assert(!s->handler);
+        assert(s->n_watches == 0);
 
         free(s->path);
 }
@@ -723,14 +908,11 @@ _pure_ static const char *path_sub_state_to_string(Unit *u) {
         return path_state_to_string(PATH(u)->state);
 }
 
-static int path_dispatch_io(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
-        PathSpec *s = userdata;
+static int path_dispatch_io(PathSpec *s, bool changed) {
         Path *p;
-        int changed;
 
         assert(s);
         assert(s->unit);
-        assert(fd >= 0);
 
         p = PATH(s->unit);
 
@@ -739,29 +921,12 @@ static int path_dispatch_io(sd_event_source *source, int fd, uint32_t revents, v
 
         /* log_debug("inotify wakeup on %s.", UNIT(p)->id); */
 
-        LIST_FOREACH(spec, s, p->specs)
-                if (path_spec_owns_inotify_fd(s, fd))
-                        break;
-
-        if (!s) {
-                log_error("Got event on unknown fd.");
-                goto fail;
-        }
-
-        changed = path_spec_fd_event(s, revents);
-        if (changed < 0)
-                goto fail;
-
         if (changed)
                 path_enter_running(p);
         else
                 path_enter_waiting(p, false, false);
 
         return 0;
-
-fail:
-        path_enter_dead(p, PATH_FAILURE_RESOURCES);
-        return 0;
 }
 
 static void path_trigger_notify(Unit *u, Unit *other) {
@@ -847,6 +1012,8 @@ const UnitVTable path_vtable = {
         .done = path_done,
         .load = path_load,
 
+        .shutdown = path_shutdown,
+
         .coldplug = path_coldplug,
 
         .dump = path_dump,
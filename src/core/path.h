@@ -16,31 +16,41 @@ typedef enum PathType {
         _PATH_TYPE_INVALID = -EINVAL,
 } PathType;
 
+typedef struct PathSpecWatch {
+        int wd;
+        uint32_t mask;
+} PathSpecWatch;
+
+/* Called when an inotify event arrived for one of the watches of the PathSpec. 'changed' is true if the
+ * event was for the path itself, and the PathSpec is of a type that triggers on changes to it. */
+typedef int (*PathSpecHandler)(PathSpec *s, bool changed);
+
 typedef struct PathSpec {
         Unit *unit;
 
         char *path;
 
-        sd_event_source *event_source;
+        /* Set while the PathSpec is watched */
+        PathSpecHandler handler;
 
         LIST_FIELDS(struct PathSpec, spec);
 
         PathType type;
-        int inotify_fd;
+
+        /* The watches on the manager's shared path inotify fd this PathSpec holds a reference to, and the
+         * events it is interested in on each. Watches of the same inode by different PathSpecs share the
+         * watch descriptor. */
+        PathSpecWatch *watches;
+        size_t n_watches;
         int primary_wd;
 
         bool previous_exists;
 } PathSpec;
 
-int path_spec_watch(PathSpec *s, sd_event_io_handler_t handler);
+int path_spec_watch(PathSpec *s, PathSpecHandler handler);
 void path_spec_unwatch(PathSpec *s);
-int path_spec_fd_event(PathSpec *s, uint32_t events);
 void path_spec_done(PathSpec *s);
 
-static inline bool path_spec_owns_inotify_fd(PathSpec *s, int fd) {
-        return s->inotify_fd == fd;
-}
-
 typedef enum PathResult {
         PATH_SUCCESS,
         PATH_FAILURE_RESOURCES,
@@ -88,7 +88,7 @@ static const UnitActiveState state_translation_table_idle[_SERVICE_STATE_MAX] =
         [SERVICE_CLEANING] = UNIT_MAINTENANCE,
 };
 
-static int service_dispatch_inotify_io(sd_event_source *source, int fd, uint32_t events, void *userdata);
+static int service_dispatch_inotify_io(PathSpec *p, bool changed);
 static int service_dispatch_timer(sd_event_source *source, usec_t usec, void *userdata);
 static int service_dispatch_watchdog(sd_event_source *source, usec_t usec, void *userdata);
 static int service_dispatch_exec_io(sd_event_source *source, int fd, uint32_t events, void *userdata);
@@ -3147,15 +3147,13 @@ static int service_demand_pid_file(Service *s) {
         /* PATH_CHANGED would not be enough. There are daemons (sendmail) that
          * keep their PID file open all the time. */
         ps->type = PATH_MODIFIED;
-        ps->inotify_fd = -1;
 
         s->pid_file_pathspec = ps;
 
         return service_watch_pid_file(s);
 }
 
-static int service_dispatch_inotify_io(sd_event_source *source, int fd, uint32_t events, void *userdata) {
-        PathSpec *p = userdata;
+static int service_dispatch_inotify_io(PathSpec *p, bool changed) {
         Service *s;
 
         assert(p);
@@ -3163,16 +3161,11 @@ static int service_dispatch_inotify_io(sd_event_source *source, int fd, uint32_t
         s = SERVICE(p->unit);
 
         assert(s);
-        assert(fd >= 0);
         assert(IN_SET(s->state, SERVICE_START, SERVICE_START_POST));
-        assert(s->pid_file_pathspec);
-        assert(path_spec_owns_inotify_fd(s->pid_file_pathspec, fd));
+        assert(s->pid_file_pathspec == p);
 
         log_unit_debug(UNIT(s), "inotify event");
 
-        if (path_spec_fd_event(p, events) < 0)
-                goto fail;
-
         if (service_retry_pid_file(s) == 0)
                 return 0;
 
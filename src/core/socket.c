@@ -46,6 +46,9 @@
 #include "unit.h"
 #include "user-util.h"
 
+/* How many connections to accept on an Accept=yes socket per event loop iteration */
+#define SOCKET_ACCEPT_BATCH_MAX 16U
+
 struct SocketPeer {
         unsigned n_ref;
 
@@ -3013,7 +3016,7 @@ shortcut:
 
 static int socket_dispatch_io(sd_event_source *source, int fd, uint32_t revents, void *userdata) {
         SocketPort *p = userdata;
-        int cfd = -1;
+        int cfd = -1, r;
 
         assert(p);
         assert(fd >= 0);
@@ -3035,13 +3038,33 @@ static int socket_dispatch_io(sd_event_source *source, int fd, uint32_t revents,
             p->type == SOCKET_SOCKET &&
             socket_address_can_accept(&p->address)) {
 
-                cfd = socket_accept_in_cgroup(p->socket, p, fd);
-                if (cfd == -EAGAIN) /* Spurious accept() */
-                        return 0;
-                if (cfd < 0)
-                        goto fail;
+                /* Take more than one connection per wakeup, so that a burst of connections doesn't cost
+                 * one event loop iteration each. Stop early if the socket is not listening anymore, for
+                 * example because the connection limit or the trigger limit was hit. Before each further
+                 * connection check that one is actually queued: accepting may mean forking off a helper
+                 * (see socket_accept_in_cgroup()), which we don't want to do just to learn that the queue
+                 * is drained. */
+                for (unsigned i = 0; i < SOCKET_ACCEPT_BATCH_MAX && p->socket->state == SOCKET_LISTENING; i++) {
+                        if (i > 0) {
+                                r = fd_wait_for_event(fd, POLLIN, 0);
+                                if (r <= 0) {
+                                        if (r < 0)
+                                                log_unit_debug_errno(UNIT(p->socket), r, "Failed to poll listening socket, ignoring: %m");
+                                        return 0;
+                                }
+                        }
 
-                socket_apply_socket_options(p->socket, p, cfd);
+                        cfd = socket_accept_in_cgroup(p->socket, p, fd);
+                        if (cfd == -EAGAIN) /* Spurious accept(), or queue drained */
+                                return 0;
+                        if (cfd < 0)
+                                goto fail;
+
+                        socket_apply_socket_options(p->socket, p, cfd);
+                        socket_enter_running(p->socket, cfd);
+                }
+
+                return 0;
         }
 
         socket_enter_running(p->socket, cfd);
@@ -45,29 +45,46 @@ void transaction_abort(Transaction *tr) {
         assert(hashmap_isempty(tr->jobs));
 }
 
-static void transaction_find_jobs_that_matter_to_anchor(Job *j, unsigned generation) {
-        JobDependency *l;
+static int transaction_find_jobs_that_matter_to_anchor(Job *anchor, unsigned generation) {
+        _cleanup_free_ Job **stack = NULL;
+        size_t n_stack = 0;
 
-        /* A recursive sweep through the graph that marks all units
-         * that matter to the anchor job, i.e. are directly or
-         * indirectly a dependency of the anchor job via paths that
-         * are fully marked as mattering. */
+        assert(anchor);
 
-        j->matters_to_anchor = true;
-        j->generation = generation;
+        /* A sweep through the graph that marks all units that matter to the anchor job, i.e. are directly
+         * or indirectly a dependency of the anchor job via paths that are fully marked as mattering. */
 
-        LIST_FOREACH(subject, l, j->subject_list) {
+        anchor->matters_to_anchor = true;
+        anchor->generation = generation;
 
-                /* This link does not matter */
-                if (!l->matters)
-                        continue;
+        if (!GREEDY_REALLOC(stack, 1))
+                return -ENOMEM;
+        stack[n_stack++] = anchor;
 
-                /* This unit has already been marked */
-                if (l->object->generation == generation)
-                        continue;
+        while (n_stack > 0) {
+                Job *j = stack[--n_stack];
+                JobDependency *l;
+
+                LIST_FOREACH(subject, l, j->subject_list) {
+
+                        /* This link does not matter */
+                        if (!l->matters)
+                                continue;
+
+                        /* This unit has already been marked */
+                        if (l->object->generation == generation)
+                                continue;
 
-                transaction_find_jobs_that_matter_to_anchor(l->object, generation);
+                        l->object->matters_to_anchor = true;
+                        l->object->generation = generation;
+
+                        if (!GREEDY_REALLOC(stack, n_stack + 1))
+                                return -ENOMEM;
+                        stack[n_stack++] = l->object;
+                }
         }
+
+        return 0;
 }
 
 static void transaction_merge_and_delete_job(Transaction *tr, Job *j, Job *other, JobType t) {
@@ -346,136 +363,212 @@ static char* merge_unit_ids(const char* unit_log_field, char **pairs) {
         return ans;
 }
 
-static int transaction_verify_order_one(Transaction *tr, Job *j, Job *from, unsigned generation, sd_bus_error *e) {
-
-        static const UnitDependencyAtom directions[] = {
-                UNIT_ATOM_BEFORE,
-                UNIT_ATOM_AFTER,
-        };
-
-        int r;
+static int transaction_break_order_cycle(Transaction *tr, Job *j, Job *from, unsigned generation, sd_bus_error *e) {
+        Job *k, *delete = NULL;
+        _cleanup_free_ char **array = NULL, *unit_ids = NULL;
+        char **unit_id, **job_type;
 
         assert(tr);
         assert(j);
-        assert(!j->transaction_prev);
+        assert(j->marker);
 
-        /* Does a recursive sweep through the ordering graph, looking for a cycle. If we find a cycle we try
-         * to break it. */
+        /* So, the marker is not NULL and we already have been here. We have a cycle. Let's try to break
+         * it. We go backwards in our path and try to find a suitable job to remove. We use the marker to
+         * find our way back, since smart how we are we stored our way back in there. */
+        for (k = from; k; k = ((k->generation == generation && k->marker != k) ? k->marker : NULL)) {
 
-        /* Have we seen this before? */
-        if (j->generation == generation) {
-                Job *k, *delete = NULL;
-                _cleanup_free_ char **array = NULL, *unit_ids = NULL;
-                char **unit_id, **job_type;
+                /* For logging below */
+                if (strv_push_pair(&array, k->unit->id, (char*) job_type_to_string(k->type)) < 0)
+                        log_oom();
 
-                /* If the marker is NULL we have been here already and decided the job was loop-free from
-                 * here. Hence shortcut things and return right-away. */
-                if (!j->marker)
-                        return 0;
+                if (!delete && hashmap_get(tr->jobs, k->unit) && !unit_matters_to_anchor(k->unit, k))
+                        /* Ok, we can drop this one, so let's do so. */
+                        delete = k;
 
-                /* So, the marker is not NULL and we already have been here. We have a cycle. Let's try to
-                 * break it. We go backwards in our path and try to find a suitable job to remove. We use the
-                 * marker to find our way back, since smart how we are we stored our way back in there. */
-                for (k = from; k; k = ((k->generation == generation && k->marker != k) ? k->marker : NULL)) {
-
-                        /* For logging below */
-                        if (strv_push_pair(&array, k->unit->id, (char*) job_type_to_string(k->type)) < 0)
-                                log_oom();
-
-                        if (!delete && hashmap_get(tr->jobs, k->unit) && !unit_matters_to_anchor(k->unit, k))
-                                /* Ok, we can drop this one, so let's do so. */
-                                delete = k;
+                /* Check if this in fact was the beginning of the cycle */
+                if (k == j)
+                        break;
+        }
 
-                        /* Check if this in fact was the beginning of the cycle */
-                        if (k == j)
-                                break;
-                }
+        unit_ids = merge_unit_ids(j->manager->unit_log_field, array); /* ignore error */
 
-                unit_ids = merge_unit_ids(j->manager->unit_log_field, array); /* ignore error */
-
-                STRV_FOREACH_PAIR(unit_id, job_type, array)
-                        /* logging for j not k here to provide a consistent narrative */
-                        log_struct(LOG_WARNING,
-                                   "MESSAGE=%s: Found %s on %s/%s",
-                                   j->unit->id,
-                                   unit_id == array ? "ordering cycle" : "dependency",
-                                   *unit_id, *job_type,
-                                   "%s", unit_ids);
-
-                if (delete) {
-                        const char *status;
-                        /* logging for j not k here to provide a consistent narrative */
-                        log_struct(LOG_ERR,
-                                   "MESSAGE=%s: Job %s/%s deleted to break ordering cycle starting with %s/%s",
-                                   j->unit->id, delete->unit->id, job_type_to_string(delete->type),
-                                   j->unit->id, job_type_to_string(j->type),
-                                   "%s", unit_ids);
-
-                        if (log_get_show_color())
-                                status = ANSI_HIGHLIGHT_RED " SKIP " ANSI_NORMAL;
-                        else
-                                status = " SKIP ";
-
-                        unit_status_printf(delete->unit,
-                                           STATUS_TYPE_NOTICE,
-                                           status,
-                                           "Ordering cycle found, skipping %s",
-                                           unit_status_string(delete->unit, NULL));
-                        transaction_delete_unit(tr, delete->unit);
-                        return -EAGAIN;
-                }
+        STRV_FOREACH_PAIR(unit_id, job_type, array)
+                /* logging for j not k here to provide a consistent narrative */
+                log_struct(LOG_WARNING,
+                           "MESSAGE=%s: Found %s on %s/%s",
+                           j->unit->id,
+                           unit_id == array ? "ordering cycle" : "dependency",
+                           *unit_id, *job_type,
+                           "%s", unit_ids);
 
+        if (delete) {
+                const char *status;
+                /* logging for j not k here to provide a consistent narrative */
                 log_struct(LOG_ERR,
-                           "MESSAGE=%s: Unable to break cycle starting with %s/%s",
-                           j->unit->id, j->unit->id, job_type_to_string(j->type),
+                           "MESSAGE=%s: Job %s/%s deleted to break ordering cycle starting with %s/%s",
+                           j->unit->id, delete->unit->id, job_type_to_string(delete->type),
+                           j->unit->id, job_type_to_string(j->type),
                            "%s", unit_ids);
 
-                return sd_bus_error_setf(e, BUS_ERROR_TRANSACTION_ORDER_IS_CYCLIC,
-                                         "Transaction order is cyclic. See system logs for details.");
+                if (log_get_show_color())
+                        status = ANSI_HIGHLIGHT_RED " SKIP " ANSI_NORMAL;
+                else
+                        status = " SKIP ";
+
+                unit_status_printf(delete->unit,
+                                   STATUS_TYPE_NOTICE,
+                                   status,
+                                   "Ordering cycle found, skipping %s",
+                                   unit_status_string(delete->unit, NULL));
+                transaction_delete_unit(tr, delete->unit);
+                return -EAGAIN;
+        }
+
+        log_struct(LOG_ERR,
+                   "MESSAGE=%s: Unable to break cycle starting with %s/%s",
+                   j->unit->id, j->unit->id, job_type_to_string(j->type),
+                   "%s", unit_ids);
+
+        return sd_bus_error_setf(e, BUS_ERROR_TRANSACTION_ORDER_IS_CYCLIC,
+                                 "Transaction order is cyclic. See system logs for details.");
+}
+
+typedef struct OrderFrame {
+        Job *job;
+        Unit **deps;     /* First the units we are ordered before, then those we are ordered after */
+        size_t n_before, n_deps, index;
+} OrderFrame;
+
+static void order_frame_done(OrderFrame *f) {
+        assert(f);
+
+        f->deps = mfree(f->deps);
+}
+
+static int order_frame_push(OrderFrame **stack, size_t *n_stack, Job *j, Job *from, unsigned generation) {
+        Hashmap *before, *after;
+        OrderFrame *f;
+        Unit *other;
+        size_t k = 0;
+        void *v;
+
+        assert(stack);
+        assert(n_stack);
+        assert(j);
+
+        if (!GREEDY_REALLOC(*stack, *n_stack + 1))
+                return -ENOMEM;
+
+        f = *stack + *n_stack;
+        *f = (OrderFrame) {
+                .job = j,
+        };
+
+        /* Take a snapshot of the ordering dependencies in both directions now, in a single array, so that
+         * we don't have to keep the hashmap iterators of every unit on the path around. */
+        before = unit_get_dependencies(j->unit, UNIT_BEFORE);
+        after = unit_get_dependencies(j->unit, UNIT_AFTER);
+
+        f->n_deps = hashmap_size(before) + hashmap_size(after);
+        if (f->n_deps > 0) {
+                f->deps = new(Unit*, f->n_deps);
+                if (!f->deps)
+                        return -ENOMEM;
         }
 
-        /* Make the marker point to where we come from, so that we can
-         * find our way backwards if we want to break a cycle. We use
-         * a special marker for the beginning: we point to
-         * ourselves. */
-        j->marker = from ? from : j;
+        HASHMAP_FOREACH_KEY(v, other, before)
+                f->deps[k++] = other;
+        f->n_before = k;
+        HASHMAP_FOREACH_KEY(v, other, after)
+                f->deps[k++] = other;
+        assert(k == f->n_deps);
+
+        (*n_stack)++;
+
+        /* Make the marker point to where we come from, so that we can find our way backwards if we want to
+         * break a cycle. We use a special marker for the beginning: we point to ourselves. */
+        j->marker = from ?: j;
         j->generation = generation;
 
-        /* Actual ordering of jobs depends on the unit ordering dependency and job types. We need to traverse
-         * the graph over 'before' edges in the actual job execution order. We traverse over both unit
-         * ordering dependencies and we test with job_compare() whether it is the 'before' edge in the job
-         * execution ordering. */
-        for (size_t d = 0; d < ELEMENTSOF(directions); d++) {
+        return 0;
+}
+
+static int transaction_verify_order_one(Transaction *tr, Job *start, unsigned generation, sd_bus_error *e) {
+        _cleanup_free_ OrderFrame *stack = NULL;
+        size_t n_stack = 0;
+        int r;
+
+        assert(tr);
+        assert(start);
+        assert(!start->transaction_prev);
+
+        /* Does a depth-first sweep through the ordering graph, looking for a cycle. If we find a cycle we
+         * try to break it. The path is kept on an explicit stack rather than the C stack, so that long
+         * ordering chains on systems with many units don't run us out of stack space. */
+
+        /* If the marker is NULL we have been here already and decided the job was loop-free from here. */
+        if (start->generation == generation) {
+                assert(!start->marker);
+                return 0;
+        }
+
+        r = order_frame_push(&stack, &n_stack, start, NULL, generation);
+        if (r < 0)
+                return r;
+
+        while (n_stack > 0) {
+                OrderFrame *f = stack + n_stack - 1;
+                UnitDependencyAtom atom;
                 Unit *u;
+                Job *o;
 
-                UNIT_FOREACH_DEPENDENCY(u, j->unit, directions[d]) {
-                        Job *o;
+                if (f->index >= f->n_deps) {
+                        /* Ok, let's backtrack, and remember that this entry is not on our path anymore. */
+                        f->job->marker = NULL;
+                        order_frame_done(f);
+                        n_stack--;
+                        continue;
+                }
 
-                        /* Is there a job for this unit? */
-                        o = hashmap_get(tr->jobs, u);
-                        if (!o) {
-                                /* Ok, there is no job for this in the transaction, but maybe there is
-                                 * already one running? */
-                                o = u->job;
-                                if (!o)
-                                        continue;
-                        }
+                atom = f->index < f->n_before ? UNIT_ATOM_BEFORE : UNIT_ATOM_AFTER;
+                u = f->deps[f->index++];
 
-                        /* Cut traversing if the job j is not really *before* o. */
-                        if (job_compare(j, o, directions[d]) >= 0)
+                /* Is there a job for this unit? */
+                o = hashmap_get(tr->jobs, u);
+                if (!o) {
+                        /* Ok, there is no job for this in the transaction, but maybe there is already one
+                         * running? */
+                        o = u->job;
+                        if (!o)
                                 continue;
+                }
 
-                        r = transaction_verify_order_one(tr, o, j, generation, e);
-                        if (r < 0)
-                                return r;
+                /* Actual ordering of jobs depends on the unit ordering dependency and job types. We need to
+                 * traverse the graph over 'before' edges in the actual job execution order. We traverse
+                 * over both unit ordering dependencies and we test with job_compare() whether it is the
+                 * 'before' edge in the job execution ordering. Cut traversing if the job is not really
+                 * *before* o. */
+                if (job_compare(f->job, o, atom) >= 0)
+                        continue;
+
+                /* Have we seen this before? */
+                if (o->generation == generation) {
+                        if (!o->marker)
+                                continue;
+
+                        r = transaction_break_order_cycle(tr, o, f->job, generation, e);
+                        break;
                 }
+
+                r = order_frame_push(&stack, &n_stack, o, f->job, generation);
+                if (r < 0)
+                        break;
         }
 
-        /* Ok, let's backtrack, and remember that this entry is not on
-         * our path anymore. */
-        j->marker = NULL;
+        for (size_t i = 0; i < n_stack; i++)
+                order_frame_done(stack + i);
 
-        return 0;
+        return r;
 }
 
 static int transaction_verify_order(Transaction *tr, unsigned *generation, sd_bus_error *e) {
@@ -492,7 +585,7 @@ static int transaction_verify_order(Transaction *tr, unsigned *generation, sd_bu
         g = (*generation)++;
 
         HASHMAP_FOREACH(j, tr->jobs) {
-                r = transaction_verify_order_one(tr, j, NULL, g, e);
+                r = transaction_verify_order_one(tr, j, g, e);
                 if (r < 0)
                         return r;
         }
@@ -645,7 +738,7 @@ static int transaction_apply(
                 assert(!j->transaction_prev);
                 assert(!j->transaction_next);
 
-                r = hashmap_ensure_put(&m->jobs, NULL, UINT32_TO_PTR(j->id), j);
+                r = hashmap_ensure_put(&m->jobs, &trivial_hash_ops_trusted, UINT32_TO_PTR(j->id), j);
                 if (r < 0)
                         goto rollback;
         }
@@ -710,7 +803,9 @@ int transaction_activate(
                 j->generation = 0;
 
         /* First step: figure out which jobs matter */
-        transaction_find_jobs_that_matter_to_anchor(tr->anchor_job, generation++);
+        r = transaction_find_jobs_that_matter_to_anchor(tr->anchor_job, generation++);
+        if (r < 0)
+                return log_oom();
 
         /* Second step: Try not to stop any running services if
          * we don't have to. Don't try to reverse running
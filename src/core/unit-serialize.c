@@ -8,6 +8,7 @@
 #include "format-util.h"
 #include "parse-util.h"
 #include "serialize.h"
+#include "sort-util.h"
 #include "string-table.h"
 #include "unit-serialize.h"
 #include "user-util.h"
@@ -260,6 +261,102 @@ static int unit_deserialize_job(Unit *u, FILE *f) {
                 _deserialize_matched;                                   \
         })
 
+typedef enum UnitDeserializeType {
+        UNIT_DESERIALIZE_DUAL_TIMESTAMP,
+        UNIT_DESERIALIZE_UINT64,
+        UNIT_DESERIALIZE_CGROUP_MASK,
+} UnitDeserializeType;
+
+typedef struct UnitDeserializeField {
+        const char *key;
+        UnitDeserializeType type;
+        size_t offset;
+} UnitDeserializeField;
+
+/* The plain, fixed-offset fields, which make up the bulk of every serialized unit. They are looked up with a
+ * binary search instead of walking the whole chain of string comparisons below. Keep this sorted by key. */
+static const UnitDeserializeField unit_deserialize_fields[] = {
+        { "active-enter-timestamp",              UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, active_enter_timestamp) },
+        { "active-exit-timestamp",               UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, active_exit_timestamp) },
+        { "assert-timestamp",                    UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, assert_timestamp) },
+        { "cgroup-enabled-mask",                 UNIT_DESERIALIZE_CGROUP_MASK,    offsetof(Unit, cgroup_enabled_mask) },
+        { "cgroup-invalidated-mask",             UNIT_DESERIALIZE_CGROUP_MASK,    offsetof(Unit, cgroup_invalidated_mask) },
+        { "cgroup-realized-mask",                UNIT_DESERIALIZE_CGROUP_MASK,    offsetof(Unit, cgroup_realized_mask) },
+        { "condition-timestamp",                 UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, condition_timestamp) },
+        { "cpu-usage-base",                      UNIT_DESERIALIZE_UINT64,         offsetof(Unit, cpu_usage_base) },
+        { "cpu-usage-last",                      UNIT_DESERIALIZE_UINT64,         offsetof(Unit, cpu_usage_last) },
+        { "cpuacct-usage-base",                  UNIT_DESERIALIZE_UINT64,         offsetof(Unit, cpu_usage_base) },
+        { "inactive-enter-timestamp",            UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, inactive_enter_timestamp) },
+        { "inactive-exit-timestamp",             UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, inactive_exit_timestamp) },
+        { "io-accounting-read-bytes-base",       UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_base[CGROUP_IO_READ_BYTES]) },
+        { "io-accounting-read-bytes-last",       UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_last[CGROUP_IO_READ_BYTES]) },
+        { "io-accounting-read-operations-base",  UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_base[CGROUP_IO_READ_OPERATIONS]) },
+        { "io-accounting-read-operations-last",  UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_last[CGROUP_IO_READ_OPERATIONS]) },
+        { "io-accounting-write-bytes-base",      UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_base[CGROUP_IO_WRITE_BYTES]) },
+        { "io-accounting-write-bytes-last",      UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_last[CGROUP_IO_WRITE_BYTES]) },
+        { "io-accounting-write-operations-base", UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_base[CGROUP_IO_WRITE_OPERATIONS]) },
+        { "io-accounting-write-operations-last", UNIT_DESERIALIZE_UINT64,         offsetof(Unit, io_accounting_last[CGROUP_IO_WRITE_OPERATIONS]) },
+        { "ip-accounting-egress-bytes",          UNIT_DESERIALIZE_UINT64,         offsetof(Unit, ip_accounting_extra[CGROUP_IP_EGRESS_BYTES]) },
+        { "ip-accounting-egress-packets",        UNIT_DESERIALIZE_UINT64,         offsetof(Unit, ip_accounting_extra[CGROUP_IP_EGRESS_PACKETS]) },
+        { "ip-accounting-ingress-bytes",         UNIT_DESERIALIZE_UINT64,         offsetof(Unit, ip_accounting_extra[CGROUP_IP_INGRESS_BYTES]) },
+        { "ip-accounting-ingress-packets",       UNIT_DESERIALIZE_UINT64,         offsetof(Unit, ip_accounting_extra[CGROUP_IP_INGRESS_PACKETS]) },
+        { "managed-oom-kill-last",               UNIT_DESERIALIZE_UINT64,         offsetof(Unit, managed_oom_kill_last) },
+        { "oom-kill-last",                       UNIT_DESERIALIZE_UINT64,         offsetof(Unit, oom_kill_last) },
+        { "state-change-timestamp",              UNIT_DESERIALIZE_DUAL_TIMESTAMP, offsetof(Unit, state_change_timestamp) },
+};
+
+static int unit_deserialize_field_compare(const UnitDeserializeField *a, const UnitDeserializeField *b) {
+        return strcmp(a->key, b->key);
+}
+
+bool unit_deserialize_fields_sorted(void) {
+        for (size_t i = 1; i < ELEMENTSOF(unit_deserialize_fields); i++)
+                if (unit_deserialize_field_compare(unit_deserialize_fields + i - 1, unit_deserialize_fields + i) >= 0)
+                        return false;
+
+        return true;
+}
+
+static bool unit_deserialize_field(Unit *u, const char *key, const char *value) {
+        const UnitDeserializeField *field;
+        uint8_t *p;
+        int r;
+
+        assert(u);
+        assert(key);
+        assert(value);
+
+        field = typesafe_bsearch(&(const UnitDeserializeField) { .key = key },
+                                 unit_deserialize_fields, ELEMENTSOF(unit_deserialize_fields),
+                                 unit_deserialize_field_compare);
+        if (!field)
+                return false;
+
+        p = (uint8_t*) u + field->offset;
+
+        switch (field->type) {
+
+        case UNIT_DESERIALIZE_DUAL_TIMESTAMP:
+                r = deserialize_dual_timestamp(value, (dual_timestamp*) p);
+                break;
+
+        case UNIT_DESERIALIZE_UINT64:
+                r = safe_atou64(value, (uint64_t*) p);
+                break;
+
+        case UNIT_DESERIALIZE_CGROUP_MASK:
+                r = cg_mask_from_string(value, (CGroupMask*) p);
+                break;
+
+        default:
+                assert_not_reached("Unknown deserialization field type");
+        }
+        if (r < 0)
+                log_unit_debug_errno(u, r, "Failed to parse \"%s=%s\", ignoring.", key, value);
+
+        return true;
+}
+
 int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
         int r;
 
@@ -270,7 +367,6 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
         for (;;) {
                 _cleanup_free_ char *line = NULL;
                 char *l, *v;
-                ssize_t m;
                 size_t k;
 
                 r = read_line(f, LONG_LINE_MAX, &line);
@@ -291,6 +387,9 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
                 } else
                         v = l+k;
 
+                if (unit_deserialize_field(u, l, v))
+                        continue;
+
                 if (streq(l, "job")) {
                         if (v[0] == '\0') {
                                 /* New-style serialized job */
@@ -300,28 +399,6 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
                         } else  /* Legacy for pre-44 */
                                 log_unit_warning(u, "Update from too old systemd versions are unsupported, cannot deserialize job: %s", v);
                         continue;
-                } else if (streq(l, "state-change-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->state_change_timestamp);
-                        continue;
-                } else if (streq(l, "inactive-exit-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->inactive_exit_timestamp);
-                        continue;
-                } else if (streq(l, "active-enter-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->active_enter_timestamp);
-                        continue;
-                } else if (streq(l, "active-exit-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->active_exit_timestamp);
-                        continue;
-                } else if (streq(l, "inactive-enter-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->inactive_enter_timestamp);
-                        continue;
-                } else if (streq(l, "condition-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->condition_timestamp);
-                        continue;
-                } else if (streq(l, "assert-timestamp")) {
-                        (void) deserialize_dual_timestamp(v, &u->assert_timestamp);
-                        continue;
-
                 } else if (MATCH_DESERIALIZE("condition-result", l, v, parse_boolean, u->condition_result))
                         continue;
 
@@ -349,19 +426,6 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
                 else if (MATCH_DESERIALIZE("exported-log-rate-limit-burst", l, v, parse_boolean, u->exported_log_ratelimit_burst))
                         continue;
 
-                else if (MATCH_DESERIALIZE_IMMEDIATE("cpu-usage-base", l, v, safe_atou64, u->cpu_usage_base) ||
-                         MATCH_DESERIALIZE_IMMEDIATE("cpuacct-usage-base", l, v, safe_atou64, u->cpu_usage_base))
-                        continue;
-
-                else if (MATCH_DESERIALIZE_IMMEDIATE("cpu-usage-last", l, v, safe_atou64, u->cpu_usage_last))
-                        continue;
-
-                else if (MATCH_DESERIALIZE_IMMEDIATE("managed-oom-kill-last", l, v, safe_atou64, u->managed_oom_kill_last))
-                        continue;
-
-                else if (MATCH_DESERIALIZE_IMMEDIATE("oom-kill-last", l, v, safe_atou64, u->oom_kill_last))
-                        continue;
-
                 else if (streq(l, "cgroup")) {
                         r = unit_set_cgroup_path(u, v);
                         if (r < 0)
@@ -375,15 +439,6 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
                 } else if (MATCH_DESERIALIZE("cgroup-realized", l, v, parse_boolean, u->cgroup_realized))
                         continue;
 
-                else if (MATCH_DESERIALIZE_IMMEDIATE("cgroup-realized-mask", l, v, cg_mask_from_string, u->cgroup_realized_mask))
-                        continue;
-
-                else if (MATCH_DESERIALIZE_IMMEDIATE("cgroup-enabled-mask", l, v, cg_mask_from_string, u->cgroup_enabled_mask))
-                        continue;
-
-                else if (MATCH_DESERIALIZE_IMMEDIATE("cgroup-invalidated-mask", l, v, cg_mask_from_string, u->cgroup_invalidated_mask))
-                        continue;
-
                 else if (STR_IN_SET(l, "ipv4-socket-bind-bpf-link-fd", "ipv6-socket-bind-bpf-link-fd")) {
                         int fd;
 
@@ -463,43 +518,6 @@ int unit_deserialize(Unit *u, FILE *f, FDSet *fds) {
                         continue;
                 }
 
-                /* Check if this is an IP accounting metric serialization field */
-                m = string_table_lookup(ip_accounting_metric_field, ELEMENTSOF(ip_accounting_metric_field), l);
-                if (m >= 0) {
-                        uint64_t c;
-
-                        r = safe_atou64(v, &c);
-                        if (r < 0)
-                                log_unit_debug(u, "Failed to parse IP accounting value %s, ignoring.", v);
-                        else
-                                u->ip_accounting_extra[m] = c;
-                        continue;
-                }
-
-                m = string_table_lookup(io_accounting_metric_field_base, ELEMENTSOF(io_accounting_metric_field_base), l);
-                if (m >= 0) {
-                        uint64_t c;
-
-                        r = safe_atou64(v, &c);
-                        if (r < 0)
-                                log_unit_debug(u, "Failed to parse IO accounting base value %s, ignoring.", v);
-                        else
-                                u->io_accounting_base[m] = c;
-                        continue;
-                }
-
-                m = string_table_lookup(io_accounting_metric_field_last, ELEMENTSOF(io_accounting_metric_field_last), l);
-                if (m >= 0) {
-                        uint64_t c;
-
-                        r = safe_atou64(v, &c);
-                        if (r < 0)
-                                log_unit_debug(u, "Failed to parse IO accounting last value %s, ignoring.", v);
-                        else
-                                u->io_accounting_last[m] = c;
-                        continue;
-                }
-
                 r = exec_runtime_deserialize_compat(u, l, v, fds);
                 if (r < 0) {
                         log_unit_warning(u, "Failed to deserialize runtime parameter '%s', ignoring.", l);
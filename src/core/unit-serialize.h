@@ -10,4 +10,7 @@ int unit_serialize(Unit *u, FILE *f, FDSet *fds, bool serialize_jobs);
 int unit_deserialize(Unit *u, FILE *f, FDSet *fds);
 int unit_deserialize_skip(FILE *f);
 
+/* Only exported for unit tests */
+bool unit_deserialize_fields_sorted(void);
+
 void unit_dump(Unit *u, FILE *f, const char *prefix);
@@ -96,6 +96,7 @@ Unit* unit_new(Manager *m, size_t size) {
                 return NULL;
 
         u->manager = m;
+        u->change_generation = ++m->unit_change_generation;
         u->type = _UNIT_TYPE_INVALID;
         u->default_dependencies = true;
         u->unit_file_state = _UNIT_FILE_STATE_INVALID;
@@ -117,11 +118,6 @@ Unit* unit_new(Manager *m, size_t size) {
         for (CGroupIOAccountingMetric i = 0; i < _CGROUP_IO_ACCOUNTING_METRIC_MAX; i++)
                 u->io_accounting_last[i] = UINT64_MAX;
 
-        u->ipv4_allow_map_fd = -1;
-        u->ipv6_allow_map_fd = -1;
-        u->ipv4_deny_map_fd = -1;
-        u->ipv6_deny_map_fd = -1;
-
         u->last_section_private = -1;
 
         u->start_ratelimit = (RateLimit) { m->default_start_limit_interval, m->default_start_limit_burst };
@@ -447,6 +443,7 @@ void unit_add_to_load_queue(Unit *u) {
 
         LIST_PREPEND(load_queue, u->manager->load_queue, u);
         u->in_load_queue = true;
+        u->load_prefetched = false;
 }
 
 void unit_add_to_cleanup_queue(Unit *u) {
@@ -476,7 +473,14 @@ void unit_add_to_dbus_queue(Unit *u) {
         assert(u);
         assert(u->type != _UNIT_TYPE_INVALID);
 
-        if (u->load_state == UNIT_STUB || u->in_dbus_queue)
+        if (u->load_state == UNIT_STUB)
+                return;
+
+        /* Note the change for ListUnitsChangedSince(), even if the unit is already queued for sending out
+         * a signal, as there might have been a query in between. */
+        u->change_generation = ++u->manager->unit_change_generation;
+
+        if (u->in_dbus_queue)
                 return;
 
         /* Shortcut things if nobody cares */
@@ -559,6 +563,7 @@ static void unit_clear_dependencies(Unit *u) {
         }
 
         u->dependencies = hashmap_free(u->dependencies);
+        u->dependency_atoms = 0;
 }
 
 static void unit_remove_transient(Unit *u) {
@@ -661,6 +666,8 @@ Unit* unit_free(Unit *u) {
 
         bus_unit_send_removed_signal(u);
 
+        u->manager->unit_remove_generation = ++u->manager->unit_change_generation;
+
         unit_done(u);
 
         unit_dequeue_rewatch_pids(u);
@@ -974,7 +981,7 @@ static int unit_per_dependency_type_hashmap_update(
 }
 
 static int unit_add_dependency_hashmap(
-                Hashmap **dependencies,
+                Unit *u,
                 UnitDependency d,
                 Unit *other,
                 UnitDependencyMask origin_mask,
@@ -983,7 +990,7 @@ static int unit_add_dependency_hashmap(
         Hashmap *per_type;
         int r;
 
-        assert(dependencies);
+        assert(u);
         assert(other);
         assert(origin_mask < _UNIT_DEPENDENCY_MASK_FULL);
         assert(destination_mask < _UNIT_DEPENDENCY_MASK_FULL);
@@ -991,23 +998,25 @@ static int unit_add_dependency_hashmap(
 
         /* Ensure the top-level dependency hashmap exists that maps UnitDependency → Hashmap(Unit* →
          * UnitDependencyInfo) */
-        r = hashmap_ensure_allocated(dependencies, NULL);
+        r = hashmap_ensure_allocated(&u->dependencies, NULL);
         if (r < 0)
                 return r;
 
         /* Acquire the inner hashmap, that maps Unit* → UnitDependencyInfo, for the specified dependency
          * type, and if it's missing allocate it and insert it. */
-        per_type = hashmap_get(*dependencies, UNIT_DEPENDENCY_TO_PTR(d));
+        per_type = hashmap_get(u->dependencies, UNIT_DEPENDENCY_TO_PTR(d));
         if (!per_type) {
                 per_type = hashmap_new(NULL);
                 if (!per_type)
                         return -ENOMEM;
 
-                r = hashmap_put(*dependencies, UNIT_DEPENDENCY_TO_PTR(d), per_type);
+                r = hashmap_put(u->dependencies, UNIT_DEPENDENCY_TO_PTR(d), per_type);
                 if (r < 0) {
                         hashmap_free(per_type);
                         return r;
                 }
+
+                u->dependency_atoms |= unit_dependency_to_atom(d);
         }
 
         return unit_per_dependency_type_hashmap_update(per_type, other, origin_mask, destination_mask);
@@ -1070,6 +1079,7 @@ static void unit_merge_dependencies(
                 /* Now all references towards 'other' of the current type 'dt' are corrected to point to
                  * 'u'. Lets's now move the deps of type 'dt' from 'other' to 'u'. First, let's try to move
                  * them per type wholesale. */
+                u->dependency_atoms |= unit_dependency_to_atom(UNIT_DEPENDENCY_FROM_PTR(dt));
                 r = hashmap_put(u->dependencies, dt, other_deps);
                 if (r == -EEXIST) {
                         Hashmap *deps;
@@ -1103,6 +1113,7 @@ static void unit_merge_dependencies(
         }
 
         other->dependencies = hashmap_free(other->dependencies);
+        other->dependency_atoms = 0;
 }
 
 int unit_merge(Unit *u, Unit *other) {
@@ -3089,13 +3100,13 @@ int unit_add_dependency(
                 return log_unit_error_errno(u, SYNTHETIC_ERRNO(EINVAL),
                                             "Requested dependency SliceOf=%s refused (%s is not a cgroup unit).", other->id, other->id);
 
-        r = unit_add_dependency_hashmap(&u->dependencies, d, other, mask, 0);
+        r = unit_add_dependency_hashmap(u, d, other, mask, 0);
         if (r < 0)
                 return r;
         noop = !r;
 
         if (inverse_table[d] != _UNIT_DEPENDENCY_INVALID && inverse_table[d] != d) {
-                r = unit_add_dependency_hashmap(&other->dependencies, inverse_table[d], u, 0, mask);
+                r = unit_add_dependency_hashmap(other, inverse_table[d], u, 0, mask);
                 if (r < 0)
                         return r;
                 if (r)
@@ -3103,13 +3114,13 @@ int unit_add_dependency(
         }
 
         if (add_reference) {
-                r = unit_add_dependency_hashmap(&u->dependencies, UNIT_REFERENCES, other, mask, 0);
+                r = unit_add_dependency_hashmap(u, UNIT_REFERENCES, other, mask, 0);
                 if (r < 0)
                         return r;
                 if (r)
                         noop = false;
 
-                r = unit_add_dependency_hashmap(&other->dependencies, UNIT_REFERENCED_BY, u, 0, mask);
+                r = unit_add_dependency_hashmap(other, UNIT_REFERENCED_BY, u, 0, mask);
                 if (r < 0)
                         return r;
                 if (r)
@@ -3643,19 +3654,35 @@ static bool fragment_mtime_newer(const char *path, usec_t mtime, bool path_maske
         return false;
 }
 
-bool unit_need_daemon_reload(Unit *u) {
+static bool path_startswith_any(const char *path, char **prefixes) {
+        char **p;
+
+        STRV_FOREACH(p, prefixes)
+                if (path_startswith(path, *p))
+                        return true;
+
+        return false;
+}
+
+bool unit_need_daemon_reload_full(Unit *u, char **unchanged_prefixes) {
         _cleanup_strv_free_ char **t = NULL;
         char **path;
 
         assert(u);
 
+        /* Files below unchanged_prefixes are assumed to have the same contents as when the unit was loaded,
+         * even if their timestamps say otherwise. This is used for the generator output, which is recreated
+         * on every run. */
+
         /* For unit files, we allow masking… */
-        if (fragment_mtime_newer(u->fragment_path, u->fragment_mtime,
+        if (!(u->fragment_path && path_startswith_any(u->fragment_path, unchanged_prefixes)) &&
+            fragment_mtime_newer(u->fragment_path, u->fragment_mtime,
                                  u->load_state == UNIT_MASKED))
                 return true;
 
         /* Source paths should not be masked… */
-        if (fragment_mtime_newer(u->source_path, u->source_mtime, false))
+        if (!(u->source_path && path_startswith_any(u->source_path, unchanged_prefixes)) &&
+            fragment_mtime_newer(u->source_path, u->source_mtime, false))
                 return true;
 
         if (u->load_state == UNIT_LOADED)
@@ -3665,12 +3692,35 @@ bool unit_need_daemon_reload(Unit *u) {
 
         /* … any drop-ins that are masked are simply omitted from the list. */
         STRV_FOREACH(path, u->dropin_paths)
-                if (fragment_mtime_newer(*path, u->dropin_mtime, false))
+                if (!path_startswith_any(*path, unchanged_prefixes) &&
+                    fragment_mtime_newer(*path, u->dropin_mtime, false))
                         return true;
 
         return false;
 }
 
+void unit_refresh_file_mtimes(Unit *u, char **prefixes) {
+        struct stat st;
+        char **path;
+
+        assert(u);
+
+        /* Updates the recorded timestamps of the files below the specified prefixes, after the caller made
+         * sure they still have the contents they had when the unit was loaded. */
+
+        if (u->fragment_path && u->fragment_mtime > 0 && path_startswith_any(u->fragment_path, prefixes) &&
+            stat(u->fragment_path, &st) >= 0 && !null_or_empty(&st))
+                u->fragment_mtime = timespec_load(&st.st_mtim);
+
+        if (u->source_path && path_startswith_any(u->source_path, prefixes) &&
+            stat(u->source_path, &st) >= 0)
+                u->source_mtime = timespec_load(&st.st_mtim);
+
+        STRV_FOREACH(path, u->dropin_paths)
+                if (path_startswith_any(*path, prefixes) && stat(*path, &st) >= 0)
+                        u->dropin_mtime = MAX(u->dropin_mtime, timespec_load(&st.st_mtim));
+}
+
 void unit_reset_failed(Unit *u) {
         assert(u);
 
@@ -5064,6 +5114,21 @@ static void unit_update_dependency_mask(Hashmap *deps, Unit *other, UnitDependen
                 assert_se(hashmap_update(deps, other, di.data) == 0);
 }
 
+static void unit_update_dependency_atoms(Unit *u) {
+        Hashmap *deps;
+        void *dt;
+
+        assert(u);
+
+        /* Recalculates the set of atoms u has dependencies for from scratch, so that types that became empty
+         * no longer count. */
+
+        u->dependency_atoms = 0;
+        HASHMAP_FOREACH_KEY(deps, dt, u->dependencies)
+                if (!hashmap_isempty(deps))
+                        u->dependency_atoms |= unit_dependency_to_atom(UNIT_DEPENDENCY_FROM_PTR(dt));
+}
+
 void unit_remove_dependencies(Unit *u, UnitDependencyMask mask) {
         Hashmap *deps;
         assert(u);
@@ -5115,6 +5180,8 @@ void unit_remove_dependencies(Unit *u, UnitDependencyMask mask) {
 
                 } while (!done);
         }
+
+        unit_update_dependency_atoms(u);
 }
 
 static int unit_get_invocation_path(Unit *u, char **ret) {
@@ -17,6 +17,7 @@
 #include "cgroup.h"
 
 typedef struct UnitRef UnitRef;
+typedef struct BPFAccessMaps BPFAccessMaps;
 
 typedef enum KillOperation {
         KILL_TERMINATE,
@@ -140,6 +141,11 @@ typedef struct Unit {
          * Hashmap(UnitDependency → Hashmap(Unit* → UnitDependencyInfo)) */
         Hashmap *dependencies;
 
+        /* All atoms of the dependency types above, OR'ed together. This may contain stale bits for types
+         * whose entries got removed again, hence it's only useful to quickly rule out that there is a
+         * dependency with a specific atom, without looking into the hashmaps. */
+        UnitDependencyAtom dependency_atoms;
+
         /* Similar, for RequiresMountsFor= path dependencies. The key is the path, the value the
          * UnitDependencyInfo type */
         Hashmap *requires_mounts_for;
@@ -248,6 +254,9 @@ typedef struct Unit {
         unsigned sigchldgen;
         unsigned notifygen;
 
+        /* The value of Manager.unit_change_generation when this unit last changed */
+        uint64_t change_generation;
+
         /* Used during GC sweeps */
         unsigned gc_marker;
 
@@ -298,6 +307,10 @@ typedef struct Unit {
         CGroupMask cgroup_invalidated_mask;        /* A mask specifying controllers which shall be considered invalidated, and require re-realization */
         CGroupMask cgroup_members_mask;            /* A cache for the controllers required by all children of this cgroup (only relevant for slice units) */
 
+        /* The values last written to the attributes of our cgroup, by attribute name, so that we can skip
+         * writes that wouldn't change anything */
+        Hashmap *cgroup_attributes;
+
         /* Inotify watch descriptors for watching cgroup.events and memory.events on cgroupv2 */
         int cgroup_control_inotify_wd;
         int cgroup_memory_inotify_wd;
@@ -310,10 +323,9 @@ typedef struct Unit {
         int ip_accounting_egress_map_fd;
         uint64_t ip_accounting_extra[_CGROUP_IP_ACCOUNTING_METRIC_MAX];
 
-        int ipv4_allow_map_fd;
-        int ipv6_allow_map_fd;
-        int ipv4_deny_map_fd;
-        int ipv6_deny_map_fd;
+        /* LPM trie maps for IPAddressAllow=/IPAddressDeny=, shared between all units with the same lists */
+        BPFAccessMaps *ip_allow_maps;
+        BPFAccessMaps *ip_deny_maps;
         BPFProgram *ip_bpf_ingress, *ip_bpf_ingress_installed;
         BPFProgram *ip_bpf_egress, *ip_bpf_egress_installed;
 
@@ -391,6 +403,9 @@ typedef struct Unit {
         bool in_start_when_upheld_queue:1;
         bool in_stop_when_bound_queue:1;
 
+        /* Whether the fragment was looked at by the load queue prefetching since the unit was queued */
+        bool load_prefetched:1;
+
         bool sent_dbus_new_signal:1;
 
         bool job_running_timeout_set:1;
@@ -822,7 +837,11 @@ void unit_catchup(Unit *u);
 
 void unit_status_printf(Unit *u, StatusType status_type, const char *status, const char *format, const char *ident) _printf_(4, 0);
 
-bool unit_need_daemon_reload(Unit *u);
+bool unit_need_daemon_reload_full(Unit *u, char **unchanged_prefixes);
+static inline bool unit_need_daemon_reload(Unit *u) {
+        return unit_need_daemon_reload_full(u, NULL);
+}
+void unit_refresh_file_mtimes(Unit *u, char **prefixes);
 
 void unit_reset_failed(Unit *u);
 
@@ -926,6 +945,10 @@ static inline bool unit_has_job_type(Unit *u, JobType type) {
         return u && u->job && u->job->type == type;
 }
 
+static inline bool unit_changed_since(const Unit *u, uint64_t since) {
+        return u->change_generation > since;
+}
+
 static inline bool unit_log_level_test(const Unit *u, int level) {
         ExecContext *ec = unit_get_exec_context(u);
         return !ec || ec->log_level_max < 0 || ec->log_level_max >= LOG_PRI(level);
@@ -1036,12 +1059,13 @@ typedef struct UnitForEachDependencyData {
 } UnitForEachDependencyData;
 
 /* Iterates through all dependencies that have a specific atom in the dependency type set. This tries to be
- * smart: if the atom is unique, we'll directly go to right entry. Otherwise we'll iterate through the
- * per-dependency type hashmap and match all dep that have the right atom set. */
+ * smart: if the unit has no dependency type with the atom at all, we'll skip the hashmaps entirely. If the
+ * atom is unique, we'll directly go to right entry. Otherwise we'll iterate through the per-dependency type
+ * hashmap and match all dep that have the right atom set. */
 #define _UNIT_FOREACH_DEPENDENCY(other, u, ma, data)                    \
         for (UnitForEachDependencyData data = {                         \
                         .match_atom = (ma),                             \
-                        .by_type = (u)->dependencies,                   \
+                        .by_type = ((u)->dependency_atoms & (ma)) ? (u)->dependencies : NULL, \
                         .by_type_iterator = ITERATOR_FIRST,             \
                         .current_unit = &(other),                       \
                 };                                                      \
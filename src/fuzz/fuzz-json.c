@@ -10,7 +10,8 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
         _cleanup_free_ char *out = NULL; /* out should be freed after g */
         size_t out_size;
         _cleanup_fclose_ FILE *f = NULL, *g = NULL;
-        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *w = NULL;
+        _cleanup_free_ char *formatted = NULL;
 
         if (size == 0)
                 return 0;
@@ -27,5 +28,9 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
         json_variant_dump(v, 0, g, NULL);
         json_variant_dump(v, JSON_FORMAT_PRETTY|JSON_FORMAT_COLOR|JSON_FORMAT_SOURCE, g, NULL);
 
+        /* Whatever we format must be accepted by the parser again */
+        assert_se(json_variant_format(v, 0, &formatted) >= 0);
+        assert_se(json_parse(formatted, 0, &w, NULL, NULL) >= 0);
+
         return 0;
 }
@@ -82,9 +82,8 @@ int bus_home_get_record_json(
                 char **ret,
                 bool *ret_incomplete) {
 
-        _cleanup_(user_record_unrefp) UserRecord *augmented = NULL;
         UserRecordLoadFlags flags;
-        int r, trusted;
+        int trusted;
 
         assert(h);
         assert(ret);
@@ -101,18 +100,7 @@ int bus_home_get_record_json(
         else
                 flags |= USER_RECORD_STRIP_PRIVILEGED;
 
-        r = home_augment_status(h, flags, &augmented);
-        if (r < 0)
-                return r;
-
-        r = json_variant_format(augmented->json, 0, ret);
-        if (r < 0)
-                return r;
-
-        if (ret_incomplete)
-                *ret_incomplete = augmented->incomplete;
-
-        return 0;
+        return home_augment_status_format(h, flags, ret, ret_incomplete);
 }
 
 static int property_get_user_record(
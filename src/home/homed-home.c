@@ -161,6 +161,16 @@ int home_new(Manager *m, UserRecord *hr, const char *sysfs, Home **ret) {
         return 0;
 }
 
+static void home_augmented_clear(Home *h) {
+        assert(h);
+
+        for (size_t i = 0; i < ELEMENTSOF(h->augmented); i++) {
+                h->augmented[i].status = json_variant_unref(h->augmented[i].status);
+                h->augmented[i].record = user_record_unref(h->augmented[i].record);
+                h->augmented[i].text = mfree(h->augmented[i].text);
+        }
+}
+
 Home *home_free(Home *h) {
 
         if (!h)
@@ -188,6 +198,7 @@ Home *home_free(Home *h) {
 
         user_record_unref(h->record);
         user_record_unref(h->secret);
+        home_augmented_clear(h);
 
         h->worker_event_source = sd_event_source_disable_unref(h->worker_event_source);
         safe_close(h->worker_stdout_fd);
@@ -263,6 +274,7 @@ int home_set_record(Home *h, UserRecord *hr) {
 
         user_record_unref(h->record);
         h->record = user_record_ref(hr);
+        home_augmented_clear(h);
         h->uid = h->record->uid;
 
         /* The updated record might have a different autologin setting, trigger a PropertiesChanged event for it */
@@ -2155,15 +2167,16 @@ finish:
         return 0;
 }
 
-int home_augment_status(
+static int home_augment_status_cached(
                 Home *h,
                 UserRecordLoadFlags flags,
-                UserRecord **ret) {
+                HomeAugmented **ret) {
 
         uint64_t disk_size = UINT64_MAX, disk_usage = UINT64_MAX, disk_free = UINT64_MAX, disk_ceiling = UINT64_MAX, disk_floor = UINT64_MAX;
         _cleanup_(json_variant_unrefp) JsonVariant *j = NULL, *v = NULL, *m = NULL, *status = NULL;
         _cleanup_(user_record_unrefp) UserRecord *ur = NULL;
         char ids[SD_ID128_STRING_MAX];
+        HomeAugmented *a;
         HomeState state;
         sd_id128_t id;
         int r;
@@ -2225,6 +2238,12 @@ int home_augment_status(
         if (r < 0)
                 return r;
 
+        a = h->augmented + FLAGS_SET(flags, USER_RECORD_ALLOW_PRIVILEGED);
+        if (a->record && a->flags == flags && json_variant_equal(a->status, status)) {
+                *ret = a;
+                return 0;
+        }
+
         j = json_variant_ref(h->record->json);
         v = json_variant_ref(json_variant_by_key(j, "status"));
         m = json_variant_ref(json_variant_by_key(v, sd_id128_to_string(id, ids)));
@@ -2257,7 +2276,70 @@ int home_augment_status(
                 FLAGS_SET(h->record->mask, USER_RECORD_PRIVILEGED) &&
                 !FLAGS_SET(ur->mask, USER_RECORD_PRIVILEGED);
 
-        *ret = TAKE_PTR(ur);
+        json_variant_unref(a->status);
+        user_record_unref(a->record);
+        free(a->text);
+
+        *a = (HomeAugmented) {
+                .flags = flags,
+                .status = TAKE_PTR(status),
+                .record = TAKE_PTR(ur),
+        };
+
+        *ret = a;
+        return 0;
+}
+
+int home_augment_status(
+                Home *h,
+                UserRecordLoadFlags flags,
+                UserRecord **ret) {
+
+        HomeAugmented *a;
+        int r;
+
+        assert(h);
+        assert(ret);
+
+        r = home_augment_status_cached(h, flags, &a);
+        if (r < 0)
+                return r;
+
+        *ret = user_record_ref(a->record);
+        return 0;
+}
+
+int home_augment_status_format(
+                Home *h,
+                UserRecordLoadFlags flags,
+                char **ret,
+                bool *ret_incomplete) {
+
+        HomeAugmented *a;
+        char *text;
+        int r;
+
+        assert(h);
+        assert(ret);
+
+        r = home_augment_status_cached(h, flags, &a);
+        if (r < 0)
+                return r;
+
+        if (!a->text) {
+                r = json_variant_format(a->record->json, 0, &a->text);
+                if (r < 0)
+                        return r;
+        }
+
+        text = strdup(a->text);
+        if (!text)
+                return -ENOMEM;
+
+        *ret = text;
+        if (ret_incomplete)
+                *ret_incomplete = a->record->incomplete;
+
         return 0;
 }
 
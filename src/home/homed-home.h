@@ -2,6 +2,7 @@
 #pragma once
 
 typedef struct Home Home;
+typedef struct HomeAugmented HomeAugmented;
 
 #include "homed-manager.h"
 #include "homed-operation.h"
@@ -74,6 +75,16 @@ static inline bool HOME_STATE_IS_EXECUTING_OPERATION(HomeState state) {
                       HOME_AUTHENTICATING_FOR_ACQUIRE);
 }
 
+/* A record as handed out to clients, with the current status merged in. Building these is not cheap, and
+ * clients tend to ask for the same thing over and over again, hence we keep the last one around for each
+ * trust level, and reuse it for as long as the record and the status it was built from stay the same. */
+struct HomeAugmented {
+        UserRecordLoadFlags flags;
+        JsonVariant *status;
+        UserRecord *record;
+        char *text; /* formatted ->record->json, generated on first use */
+};
+
 struct Home {
         Manager *manager;
         char *user_name;
@@ -126,6 +137,9 @@ struct Home {
 
         /* Used to coalesce bus PropertiesChanged events */
         sd_event_source *deferred_change_event_source;
+
+        /* Indexed by whether the privileged section is included */
+        HomeAugmented augmented[2];
 };
 
 int home_new(Manager *m, UserRecord *hr, const char *sysfs, Home **ret);
@@ -157,6 +171,7 @@ void home_process_notify(Home *h, char **l);
 int home_killall(Home *h);
 
 int home_augment_status(Home *h, UserRecordLoadFlags flags, UserRecord **ret);
+int home_augment_status_format(Home *h, UserRecordLoadFlags flags, char **ret, bool *ret_incomplete);
 
 int home_create_fifo(Home *h, bool please_suspend);
 int home_schedule_operation(Home *h, Operation *o, sd_bus_error *error);
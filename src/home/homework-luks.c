@@ -1842,6 +1842,7 @@ static int home_truncate(
                 const char *path,
                 uint64_t size) {
 
+        struct stat st;
         bool trunc;
         int r;
 
@@ -1851,7 +1852,17 @@ static int home_truncate(
 
         trunc = user_record_luks_discard(h);
         if (!trunc) {
-                r = fallocate(fd, 0, 0, size);
+                /* When growing an existing image, only allocate the newly added range, the rest has been
+                 * allocated before already. This matters for big homes, where allocating the whole image
+                 * again means walking all of its extents. */
+                if (fstat(fd, &st) < 0)
+                        return log_error_errno(errno, "Failed to stat home image %s: %m", path);
+
+                if (S_ISREG(st.st_mode) && (uint64_t) st.st_size < size &&
+                    st.st_blocks >= DIV_ROUND_UP(st.st_size, 512))
+                        r = fallocate(fd, 0, st.st_size, size - st.st_size);
+                else
+                        r = fallocate(fd, 0, 0, size);
                 if (r < 0 && ERRNO_IS_NOT_SUPPORTED(errno)) {
                         /* Some file systems do not support fallocate(), let's gracefully degrade
                          * (ZFS, reiserfs, …) and fall back to truncation */
@@ -19,6 +19,8 @@
 #include "strv.h"
 #include "xattr-util.h"
 
+#define PULL_JOB_BUFFER_SIZE (512L * 1024L)
+
 PullJob* pull_job_unref(PullJob *j) {
         if (!j)
                 return NULL;
@@ -663,6 +665,11 @@ int pull_job_begin(PullJob *j) {
         if (curl_easy_setopt(j->curl, CURLOPT_WRITEDATA, j) != CURLE_OK)
                 return -EIO;
 
+        /* Ask for the data in larger chunks than the 16K default, so that checksumming, decompressing and
+         * writing it out happens in fewer, larger steps. This is only a hint, which curl clamps to what it
+         * supports, hence ignore failures. */
+        (void) curl_easy_setopt(j->curl, CURLOPT_BUFFERSIZE, PULL_JOB_BUFFER_SIZE);
+
         if (curl_easy_setopt(j->curl, CURLOPT_HEADERFUNCTION, pull_job_header_callback) != CURLE_OK)
                 return -EIO;
 
@@ -4,6 +4,8 @@
 
 #include "alloc-util.h"
 #include "btrfs-util.h"
+#include "errno-util.h"
+#include "memory-util.h"
 #include "qcow2-util.h"
 #include "sparse-endian.h"
 #include "util.h"
@@ -61,32 +63,54 @@ static uint32_t HEADER_HEADER_LENGTH(const Header *h) {
         return be32toh(h->header_length);
 }
 
-static int copy_cluster(
-                int sfd, uint64_t soffset,
+static int write_cluster(
                 int dfd, uint64_t doffset,
                 uint64_t cluster_size,
-                void *buffer) {
+                const void *buffer) {
 
         ssize_t l;
-        int r;
 
-        r = btrfs_clone_range(sfd, soffset, dfd, doffset, cluster_size);
-        if (r >= 0)
-                return r;
+        /* The output file starts out empty, hence clusters that are allocated in the image but only
+         * contain zeroes are left as holes, rather than written out. */
+        if (memeqzero(buffer, cluster_size))
+                return 0;
 
-        l = pread(sfd, buffer, cluster_size, soffset);
+        l = pwrite(dfd, buffer, cluster_size, doffset);
         if (l < 0)
                 return -errno;
         if ((uint64_t) l != cluster_size)
                 return -EIO;
 
-        l = pwrite(dfd, buffer, cluster_size, doffset);
+        return 0;
+}
+
+static int copy_cluster(
+                int sfd, uint64_t soffset,
+                int dfd, uint64_t doffset,
+                uint64_t cluster_size,
+                void *buffer,
+                bool *try_reflink) {
+
+        ssize_t l;
+        int r;
+
+        if (*try_reflink) {
+                r = btrfs_clone_range(sfd, soffset, dfd, doffset, cluster_size);
+                if (r >= 0)
+                        return r;
+
+                /* Don't try again for each following cluster if the file system can't do it at all */
+                if (ERRNO_IS_NOT_SUPPORTED(r) || r == -EXDEV)
+                        *try_reflink = false;
+        }
+
+        l = pread(sfd, buffer, cluster_size, soffset);
         if (l < 0)
                 return -errno;
         if ((uint64_t) l != cluster_size)
                 return -EIO;
 
-        return 0;
+        return write_cluster(dfd, doffset, cluster_size, buffer);
 }
 
 static int decompress_cluster(
@@ -135,13 +159,7 @@ static int decompress_cluster(
         if (r != Z_STREAM_END || sz != cluster_size)
                 return -EIO;
 
-        l = pwrite(dfd, buffer2, cluster_size, doffset);
-        if (l < 0)
-                return -errno;
-        if ((uint64_t) l != cluster_size)
-                return -EIO;
-
-        return 0;
+        return write_cluster(dfd, doffset, cluster_size, buffer2);
 }
 
 static int normalize_offset(
@@ -229,6 +247,7 @@ static int verify_header(const Header *header) {
 int qcow2_convert(int qcow2_fd, int raw_fd) {
         _cleanup_free_ void *buffer1 = NULL, *buffer2 = NULL;
         _cleanup_free_ be64_t *l1_table = NULL, *l2_table = NULL;
+        bool try_reflink = true;
         uint64_t sz, i;
         Header header;
         ssize_t l;
@@ -311,7 +330,8 @@ int qcow2_convert(int qcow2_fd, int raw_fd) {
                                 r = copy_cluster(
                                                 qcow2_fd, data_begin,
                                                 raw_fd, p,
-                                                HEADER_CLUSTER_SIZE(&header), buffer1);
+                                                HEADER_CLUSTER_SIZE(&header), buffer1,
+                                                &try_reflink);
                         if (r < 0)
                                 return r;
                 }
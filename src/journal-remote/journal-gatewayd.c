@@ -15,7 +15,9 @@
 
 #include "alloc-util.h"
 #include "bus-util.h"
+#include "compress.h"
 #include "errno-util.h"
+#include "extract-word.h"
 #include "fd-util.h"
 #include "fileio.h"
 #include "glob-util.h"
@@ -29,11 +31,15 @@
 #include "parse-util.h"
 #include "pretty-print.h"
 #include "sigbus.h"
+#include "strv.h"
 #include "tmpfile-util.h"
 #include "util.h"
 
 #define JOURNAL_WAIT_TIMEOUT (10*USEC_PER_SEC)
 
+/* The size of the chunks we try to hand to microhttpd when serving entries */
+#define ENTRIES_BLOCK_SIZE (64U*1024U)
+
 static char *arg_key_pem = NULL;
 static char *arg_cert_pem = NULL;
 static char *arg_trust_pem = NULL;
@@ -50,6 +56,7 @@ typedef struct RequestMeta {
         sd_journal *journal;
 
         OutputMode mode;
+        char **output_fields;
 
         char *cursor;
         int64_t n_skip;
@@ -59,6 +66,10 @@ typedef struct RequestMeta {
         FILE *tmp;
         uint64_t delta, size;
 
+        /* When the client accepts zstd, every chunk of serialized entries is sent as its own zstd frame */
+        bool compress;
+        uint8_t *chunk, *compressed;
+
         int argument_parse_error;
 
         bool follow;
@@ -104,6 +115,9 @@ static void request_meta_free(
         safe_fclose(m->tmp);
 
         free(m->cursor);
+        strv_free(m->output_fields);
+        free(m->chunk);
+        free(m->compressed);
         free(m);
 }
 
@@ -141,6 +155,55 @@ static int request_meta_ensure_tmp(RequestMeta *m) {
         return 0;
 }
 
+static int request_meta_serialize_entry(RequestMeta *m) {
+        off_t sz;
+        int r;
+
+        assert(m);
+        assert(m->tmp);
+
+        r = show_journal_entry(m->tmp, m->journal, m->mode, 0, OUTPUT_FULL_WIDTH,
+                               m->output_fields, NULL, NULL);
+        if (r < 0)
+                return log_error_errno(r, "Failed to serialize item: %m");
+
+        sz = ftello(m->tmp);
+        if (sz == (off_t) -1)
+                return log_error_errno(errno, "Failed to retrieve file position: %m");
+
+        m->size = (uint64_t) sz;
+        return 0;
+}
+
+static int request_meta_compress_chunk(RequestMeta *m) {
+        size_t sz;
+        int r;
+
+        assert(m);
+        assert(m->tmp);
+        assert(m->size > 0);
+
+        if (!GREEDY_REALLOC(m->chunk, m->size))
+                return log_oom();
+
+        rewind(m->tmp);
+
+        errno = 0;
+        if (fread(m->chunk, 1, m->size, m->tmp) != m->size)
+                return log_error_errno(errno_or_else(EIO), "Failed to read from file: %m");
+
+        /* Leave room for the worst case, i.e. incompressible data plus the frame overhead */
+        if (!GREEDY_REALLOC(m->compressed, m->size + m->size / 8 + 1024))
+                return log_oom();
+
+        r = compress_blob_zstd(m->chunk, m->size, m->compressed, MALLOC_SIZEOF_SAFE(m->compressed), &sz);
+        if (r < 0)
+                return log_error_errno(r, "Failed to compress entries: %m");
+
+        m->size = sz;
+        return 0;
+}
+
 static ssize_t request_reader_entries(
                 void *cls,
                 uint64_t pos,
@@ -159,10 +222,8 @@ static ssize_t request_reader_entries(
         pos -= m->delta;
 
         while (pos >= m->size) {
-                off_t sz;
-
-                /* End of this entry, so let's serialize the next
-                 * one */
+                /* End of this chunk, so let's serialize the next
+                 * entries */
 
                 if (m->n_entries_set &&
                     m->n_entries <= 0)
@@ -222,36 +283,55 @@ static ssize_t request_reader_entries(
                         return MHD_CONTENT_READER_END_WITH_ERROR;
                 }
 
-                r = show_journal_entry(m->tmp, m->journal, m->mode, 0, OUTPUT_FULL_WIDTH,
-                                   NULL, NULL, NULL);
-                if (r < 0) {
-                        log_error_errno(r, "Failed to serialize item: %m");
+                r = request_meta_serialize_entry(m);
+                if (r < 0)
                         return MHD_CONTENT_READER_END_WITH_ERROR;
-                }
 
-                sz = ftello(m->tmp);
-                if (sz == (off_t) -1) {
-                        log_error_errno(errno, "Failed to retrieve file position: %m");
-                        return MHD_CONTENT_READER_END_WITH_ERROR;
+                /* Append the entries that are already available to the same chunk, until it fills the
+                 * buffer microhttpd handed us, so that we aren't called back for every single entry. */
+                while (m->size < max && !(m->n_entries_set && m->n_entries <= 0)) {
+                        r = sd_journal_next(m->journal);
+                        if (r < 0) {
+                                log_error_errno(r, "Failed to advance journal pointer: %m");
+                                return MHD_CONTENT_READER_END_WITH_ERROR;
+                        }
+                        if (r == 0)
+                                break;
+
+                        if (m->n_entries_set)
+                                m->n_entries -= 1;
+
+                        r = request_meta_serialize_entry(m);
+                        if (r < 0)
+                                return MHD_CONTENT_READER_END_WITH_ERROR;
                 }
 
-                m->size = (uint64_t) sz;
+                if (m->compress) {
+                        r = request_meta_compress_chunk(m);
+                        if (r < 0)
+                                return MHD_CONTENT_READER_END_WITH_ERROR;
+                }
         }
 
         if (m->tmp == NULL && m->follow)
                 return 0;
 
-        if (fseeko(m->tmp, pos, SEEK_SET) < 0) {
-                log_error_errno(errno, "Failed to seek to position: %m");
-                return MHD_CONTENT_READER_END_WITH_ERROR;
-        }
-
         n = m->size - pos;
         if (n < 1)
                 return 0;
         if (n > max)
                 n = max;
 
+        if (m->compress) {
+                memcpy(buf, m->compressed + pos, n);
+                return (ssize_t) n;
+        }
+
+        if (fseeko(m->tmp, pos, SEEK_SET) < 0) {
+                log_error_errno(errno, "Failed to seek to position: %m");
+                return MHD_CONTENT_READER_END_WITH_ERROR;
+        }
+
         errno = 0;
         k = fread(buf, 1, n, m->tmp);
         if (k != n) {
@@ -289,6 +369,48 @@ static int request_parse_accept(
         return 0;
 }
 
+static int request_parse_accept_encoding(
+                RequestMeta *m,
+                struct MHD_Connection *connection) {
+
+        const char *header;
+        int r;
+
+        assert(m);
+        assert(connection);
+
+        header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Accept-Encoding");
+        if (!header)
+                return 0;
+
+        for (const char *p = header;;) {
+                _cleanup_free_ char *word = NULL;
+                char *params;
+
+                r = extract_first_word(&p, &word, ",", 0);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        return 0;
+
+                params = strchr(word, ';');
+                if (params)
+                        *params++ = 0;
+
+                if (!streq(strstrip(word), "zstd"))
+                        continue;
+
+                /* "zstd;q=0" explicitly refuses the encoding */
+                if (params && STR_IN_SET(strstrip(params), "q=0", "q=0.0", "q=0.00", "q=0.000"))
+                        return 0;
+
+#if HAVE_ZSTD
+                m->compress = true;
+#endif
+                return 0;
+        }
+}
+
 static int request_parse_range(
                 RequestMeta *m,
                 struct MHD_Connection *connection) {
@@ -402,6 +524,29 @@ static mhd_result request_parse_arguments_iterator(
                 return MHD_YES;
         }
 
+        if (streq(key, "fields")) {
+                _cleanup_strv_free_ char **v = NULL;
+
+                if (isempty(value)) {
+                        m->argument_parse_error = -EINVAL;
+                        return MHD_NO;
+                }
+
+                v = strv_split(value, ",");
+                if (!v) {
+                        m->argument_parse_error = log_oom();
+                        return MHD_NO;
+                }
+
+                r = strv_extend_strv(&m->output_fields, v, true);
+                if (r < 0) {
+                        m->argument_parse_error = log_oom();
+                        return MHD_NO;
+                }
+
+                return MHD_YES;
+        }
+
         if (streq(key, "boot")) {
                 if (isempty(value))
                         r = true;
@@ -480,6 +625,9 @@ static int request_handler_entries(
         if (request_parse_accept(m, connection) < 0)
                 return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to parse Accept header.");
 
+        if (request_parse_accept_encoding(m, connection) < 0)
+                return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to parse Accept-Encoding header.");
+
         if (request_parse_range(m, connection) < 0)
                 return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to parse Range header.");
 
@@ -503,11 +651,16 @@ static int request_handler_entries(
         if (r < 0)
                 return mhd_respond(connection, MHD_HTTP_BAD_REQUEST, "Failed to seek in journal.");
 
-        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 4*1024, request_reader_entries, m, NULL);
+        response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, ENTRIES_BLOCK_SIZE, request_reader_entries, m, NULL);
         if (!response)
                 return respond_oom(connection);
 
-        if (MHD_add_response_header(response, "Content-Type", mime_types[m->mode]) == MHD_NO)
+        if (MHD_add_response_header(response, "Content-Type", mime_types[m->mode]) == MHD_NO ||
+            MHD_add_response_header(response, "Vary", "Accept-Encoding") == MHD_NO)
+                return respond_oom(connection);
+
+        if (m->compress &&
+            MHD_add_response_header(response, "Content-Encoding", "zstd") == MHD_NO)
                 return respond_oom(connection);
 
         return MHD_queue_response(connection, MHD_HTTP_OK, response);
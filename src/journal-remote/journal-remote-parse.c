@@ -53,7 +53,11 @@ int process_source(RemoteSource *source, bool compress, bool seal) {
         assert(source);
         assert(source->writer);
 
-        r = journal_importer_process_data(&source->importer);
+        /* The importer consumes one field per call. Keep feeding it until the entry is complete or we
+         * run out of buffered data, instead of going through the event loop once for every field. */
+        do
+                r = journal_importer_process_data(&source->importer);
+        while (r == 0 && !journal_importer_eof(&source->importer));
         if (r <= 0)
                 return r;
 
@@ -57,6 +57,8 @@ static ssize_t write_entry(char *buf, size_t size, Uploader *u) {
                         if (r < 0)
                                 return log_error_errno(r, "Failed to get realtime timestamp: %m");
 
+                        u->current_realtime = realtime;
+
                         r = snprintf(buf + pos, size - pos,
                                      "__REALTIME_TIMESTAMP="USEC_FMT"\n", realtime);
                         assert(r >= 0);
@@ -303,6 +305,7 @@ static size_t journal_input_callback(void *buf, size_t size, size_t nmemb, void
                           u->entries_sent, u->current_cursor);
         }
 
+        u->bytes_sent += filled;
         return filled;
 }
 
@@ -59,6 +59,10 @@ static void close_fd_input(Uploader *u);
 
 #define SERVER_ANSWER_KEEP 2048
 
+/* How much curl asks us for at once. Its default is rather small, and every read callback turns into a
+ * separate chunk on the wire. */
+#define UPLOAD_BUFFER_SIZE (256U*1024U)
+
 #define STATE_FILE "/var/lib/systemd/journal-upload/state"
 
 #define easy_setopt(curl, opt, value, level, cmd)                       \
@@ -243,6 +247,12 @@ int start_upload(Uploader *u,
                 easy_setopt(curl, CURLOPT_HTTPHEADER, u->header,
                             LOG_ERR, return -EXFULL);
 
+#if LIBCURL_VERSION_NUM >= 0x073e00
+                /* CURLOPT_UPLOAD_BUFFERSIZE was added in curl 7.62.0 */
+                easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, (long) UPLOAD_BUFFER_SIZE,
+                            LOG_DEBUG, );
+#endif
+
                 if (DEBUG_LOGGING)
                         /* enable verbose for easier tracing */
                         easy_setopt(curl, CURLOPT_VERBOSE, 1L, LOG_WARNING, );
@@ -304,8 +314,10 @@ static size_t fd_input_callback(void *buf, size_t size, size_t nmemb, void *user
 
         n = read(u->input, buf, size * nmemb);
         log_debug("%s: allowed %zu, read %zd", __func__, size*nmemb, n);
-        if (n > 0)
+        if (n > 0) {
+                u->bytes_sent += n;
                 return n;
+        }
 
         u->uploading = false;
         if (n < 0) {
@@ -485,13 +497,37 @@ static void destroy_uploader(Uploader *u) {
         sd_event_unref(u->events);
 }
 
+static void log_upload_progress(Uploader *u, uint64_t bytes, usec_t duration) {
+        char ts[FORMAT_TIMESPAN_MAX];
+
+        assert(u);
+
+        log_debug("Uploaded %" PRIu64 " bytes in %s.",
+                  bytes, format_timespan(ts, sizeof(ts), duration, USEC_PER_MSEC));
+
+        /* How far behind the journal we are, i.e. whether we keep up with the rate at which entries are
+         * logged. Only known when uploading from the journal. */
+        if (u->last_realtime <= 0)
+                return;
+
+        (void) sd_notifyf(false,
+                          "STATUS=Processing input, %zu entries uploaded, %s behind the journal.",
+                          u->entries_sent,
+                          format_timespan(ts, sizeof(ts),
+                                          usec_sub_unsigned(now(CLOCK_REALTIME), u->last_realtime),
+                                          USEC_PER_SEC));
+}
+
 static int perform_upload(Uploader *u) {
+        uint64_t bytes_before;
+        usec_t start;
         CURLcode code;
         long status;
 
         assert(u);
 
-        u->watchdog_timestamp = now(CLOCK_MONOTONIC);
+        bytes_before = u->bytes_sent;
+        u->watchdog_timestamp = start = now(CLOCK_MONOTONIC);
         code = curl_easy_perform(u->easy);
         if (code) {
                 if (u->error[0])
@@ -522,6 +558,10 @@ static int perform_upload(Uploader *u) {
                           status, strna(u->answer));
 
         free_and_replace(u->last_cursor, u->current_cursor);
+        u->last_realtime = u->current_realtime;
+
+        log_upload_progress(u, u->bytes_sent - bytes_before,
+                            usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
 
         return update_cursor_state(u);
 }
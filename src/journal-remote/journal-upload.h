@@ -51,7 +51,9 @@ typedef struct Uploader {
         const char *state_file;
 
         size_t entries_sent;
+        uint64_t bytes_sent;
         char *last_cursor, *current_cursor;
+        usec_t last_realtime, current_realtime; /* of the last acknowledged entry, and the one being sent */
         usec_t watchdog_timestamp;
         usec_t watchdog_usec;
 } Uploader;
@@ -28,6 +28,7 @@
 #include "bus-util.h"
 #include "catalog.h"
 #include "chattr-util.h"
+#include "cpu-set-util.h"
 #include "def.h"
 #include "dissect-image.h"
 #include "fd-util.h"
@@ -58,6 +59,7 @@
 #include "path-util.h"
 #include "pcre2-dlopen.h"
 #include "pretty-print.h"
+#include "process-util.h"
 #include "qrcode-util.h"
 #include "random-util.h"
 #include "rlimit-util.h"
@@ -156,13 +158,6 @@ static enum {
         ACTION_LIST_FIELD_NAMES,
 } arg_action = ACTION_SHOW;
 
-typedef struct BootId {
-        sd_id128_t id;
-        uint64_t first;
-        uint64_t last;
-        LIST_FIELDS(struct BootId, boot_list);
-} BootId;
-
 #if HAVE_PCRE2
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(pcre2_match_data*, sym_pcre2_match_data_free, NULL);
 DEFINE_TRIVIAL_CLEANUP_FUNC_FULL(pcre2_code*, sym_pcre2_code_free, NULL);
@@ -1124,6 +1119,13 @@ static int parse_argv(int argc, char *argv[]) {
                 r = pattern_compile(arg_pattern, flags, &arg_compiled_pattern);
                 if (r < 0)
                         return r;
+
+                /* The pattern is matched against the message of every entry we look at, so let's have it
+                 * compiled to machine code. This isn't supported on all architectures, in which case the
+                 * interpreter is used. */
+                r = sym_pcre2_jit_compile(arg_compiled_pattern, PCRE2_JIT_COMPLETE);
+                if (r < 0)
+                        log_debug("Failed to JIT compile pattern, ignoring: %i", r);
         }
 #endif
 
@@ -1212,257 +1214,74 @@ static int add_matches(sd_journal *j, char **args) {
         return 0;
 }
 
-static void boot_id_free_all(BootId *l) {
-
-        while (l) {
-                BootId *i = l;
-                LIST_REMOVE(boot_list, l, i);
-                free(i);
-        }
-}
-
-static int discover_next_boot(sd_journal *j,
-                sd_id128_t previous_boot_id,
-                bool advance_older,
-                BootId **ret) {
-
-        _cleanup_free_ BootId *next_boot = NULL;
-        char match[9+32+1] = "_BOOT_ID=";
-        sd_id128_t boot_id;
-        int r;
-
-        assert(j);
-        assert(ret);
-
-        /* We expect the journal to be on the last position of a boot
-         * (in relation to the direction we are going), so that the next
-         * invocation of sd_journal_next/previous will be from a different
-         * boot. We then collect any information we desire and then jump
-         * to the last location of the new boot by using a _BOOT_ID match
-         * coming from the other journal direction. */
-
-        /* Make sure we aren't restricted by any _BOOT_ID matches, so that
-         * we can actually advance to a *different* boot. */
-        sd_journal_flush_matches(j);
-
-        do {
-                if (advance_older)
-                        r = sd_journal_previous(j);
-                else
-                        r = sd_journal_next(j);
-                if (r < 0)
-                        return r;
-                else if (r == 0)
-                        return 0; /* End of journal, yay. */
-
-                r = sd_journal_get_monotonic_usec(j, NULL, &boot_id);
-                if (r < 0)
-                        return r;
-
-                /* We iterate through this in a loop, until the boot ID differs from the previous one. Note that
-                 * normally, this will only require a single iteration, as we seeked to the last entry of the previous
-                 * boot entry already. However, it might happen that the per-journal-field entry arrays are less
-                 * complete than the main entry array, and hence might reference an entry that's not actually the last
-                 * one of the boot ID as last one. Let's hence use the per-field array is initial seek position to
-                 * speed things up, but let's not trust that it is complete, and hence, manually advance as
-                 * necessary. */
-
-        } while (sd_id128_equal(boot_id, previous_boot_id));
-
-        next_boot = new0(BootId, 1);
-        if (!next_boot)
-                return -ENOMEM;
-
-        next_boot->id = boot_id;
-
-        r = sd_journal_get_realtime_usec(j, &next_boot->first);
-        if (r < 0)
-                return r;
-
-        /* Now seek to the last occurrence of this boot ID. */
-        sd_id128_to_string(next_boot->id, match + 9);
-        r = sd_journal_add_match(j, match, sizeof(match) - 1);
-        if (r < 0)
-                return r;
-
-        if (advance_older)
-                r = sd_journal_seek_head(j);
-        else
-                r = sd_journal_seek_tail(j);
-        if (r < 0)
-                return r;
-
-        if (advance_older)
-                r = sd_journal_next(j);
-        else
-                r = sd_journal_previous(j);
-        if (r < 0)
-                return r;
-        else if (r == 0)
-                return log_debug_errno(SYNTHETIC_ERRNO(ENODATA),
-                                       "Whoopsie! We found a boot ID but can't read its last entry."); /* This shouldn't happen. We just came from this very boot ID. */
-
-        r = sd_journal_get_realtime_usec(j, &next_boot->last);
-        if (r < 0)
-                return r;
-
-        *ret = TAKE_PTR(next_boot);
-
-        return 0;
-}
-
 static int get_boots(
                 sd_journal *j,
-                BootId **boots,
                 sd_id128_t *boot_id,
                 int offset) {
 
-        bool skip_once;
-        int r, count = 0;
-        BootId *head = NULL, *tail = NULL, *id;
-        const bool advance_older = boot_id && offset <= 0;
-        sd_id128_t previous_boot_id;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        size_t n_boots;
+        ssize_t i;
+        int r;
 
         assert(j);
+        assert(boot_id);
 
-        /* Adjust for the asymmetry that offset 0 is
-         * the last (and current) boot, while 1 is considered the
-         * (chronological) first boot in the journal. */
-        skip_once = boot_id && sd_id128_is_null(*boot_id) && offset <= 0;
-
-        /* Advance to the earliest/latest occurrence of our reference
-         * boot ID (taking our lookup direction into account), so that
-         * discover_next_boot() can do its job.
-         * If no reference is given, the journal head/tail will do,
-         * they're "virtual" boots after all. */
-        if (boot_id && !sd_id128_is_null(*boot_id)) {
-                char match[9+32+1] = "_BOOT_ID=";
-
-                sd_journal_flush_matches(j);
-
-                sd_id128_to_string(*boot_id, match + 9);
-                r = sd_journal_add_match(j, match, sizeof(match) - 1);
-                if (r < 0)
-                        return r;
+        /* Looks up the boot at the specified offset relative to the reference boot ID. If no reference is
+         * given, offset 0 is the last (and current) boot, while 1 is considered the (chronological) first
+         * boot in the journal. Returns 1 and updates *boot_id if found, 0 otherwise. */
 
-                if (advance_older)
-                        r = sd_journal_seek_head(j); /* seek to oldest */
-                else
-                        r = sd_journal_seek_tail(j); /* seek to newest */
-                if (r < 0)
-                        return r;
-
-                if (advance_older)
-                        r = sd_journal_next(j);     /* read the oldest entry */
-                else
-                        r = sd_journal_previous(j); /* read the most recently added entry */
-                if (r < 0)
-                        return r;
-                else if (r == 0)
-                        goto finish;
-                else if (offset == 0) {
-                        count = 1;
-                        goto finish;
-                }
-
-                /* At this point the read pointer is positioned at the oldest/newest occurrence of the reference boot
-                 * ID. After flushing the matches, one more invocation of _previous()/_next() will hence place us at
-                 * the following entry, which must then have an older/newer boot ID */
-        } else {
-
-                if (advance_older)
-                        r = sd_journal_seek_tail(j); /* seek to newest */
-                else
-                        r = sd_journal_seek_head(j); /* seek to oldest */
-                if (r < 0)
-                        return r;
-
-                /* No sd_journal_next()/_previous() here.
-                 *
-                 * At this point the read pointer is positioned after the newest/before the oldest entry in the whole
-                 * journal. The next invocation of _previous()/_next() will hence position us at the newest/oldest
-                 * entry we have. */
-        }
-
-        previous_boot_id = SD_ID128_NULL;
-        for (;;) {
-                _cleanup_free_ BootId *current = NULL;
-
-                r = discover_next_boot(j, previous_boot_id, advance_older, &current);
-                if (r < 0) {
-                        boot_id_free_all(head);
-                        return r;
-                }
-
-                if (!current)
-                        break;
-
-                previous_boot_id = current->id;
-
-                if (boot_id) {
-                        if (!skip_once)
-                                offset += advance_older ? 1 : -1;
-                        skip_once = false;
+        r = journal_get_boots(j, &boots, &n_boots);
+        if (r < 0)
+                return r;
 
-                        if (offset == 0) {
-                                count = 1;
-                                *boot_id = current->id;
+        if (sd_id128_is_null(*boot_id))
+                i = offset <= 0 ? (ssize_t) n_boots - 1 + offset : offset - 1;
+        else {
+                for (i = 0; i < (ssize_t) n_boots; i++)
+                        if (sd_id128_equal(boots[i].id, *boot_id))
                                 break;
-                        }
-                } else {
-                        LIST_FOREACH(boot_list, id, head) {
-                                if (sd_id128_equal(id->id, current->id)) {
-                                        /* boot id already stored, something wrong with the journal files */
-                                        /* exiting as otherwise this problem would cause forever loop */
-                                        goto finish;
-                                }
-                        }
-                        LIST_INSERT_AFTER(boot_list, head, tail, current);
-                        tail = TAKE_PTR(current);
-                        count++;
-                }
-        }
+                if (i >= (ssize_t) n_boots)
+                        return 0;
 
-finish:
-        if (boots)
-                *boots = head;
+                i += offset;
+        }
 
-        sd_journal_flush_matches(j);
+        if (i < 0 || i >= (ssize_t) n_boots)
+                return 0;
 
-        return count;
+        *boot_id = boots[i].id;
+        return 1;
 }
 
 static int list_boots(sd_journal *j) {
-        int w, i, count;
-        BootId *id, *all_ids;
+        _cleanup_free_ JournalBoot *boots = NULL;
+        size_t n_boots;
+        int w, r;
 
         assert(j);
 
-        count = get_boots(j, &all_ids, NULL, 0);
-        if (count < 0)
-                return log_error_errno(count, "Failed to determine boots: %m");
-        if (count == 0)
-                return count;
+        r = journal_get_boots(j, &boots, &n_boots);
+        if (r < 0)
+                return log_error_errno(r, "Failed to determine boots: %m");
+        if (n_boots == 0)
+                return 0;
 
         (void) pager_open(arg_pager_flags);
 
         /* numbers are one less, but we need an extra char for the sign */
-        w = DECIMAL_STR_WIDTH(count - 1) + 1;
+        w = DECIMAL_STR_WIDTH(n_boots - 1) + 1;
 
-        i = 0;
-        LIST_FOREACH(boot_list, id, all_ids) {
+        for (size_t i = 0; i < n_boots; i++) {
                 char a[FORMAT_TIMESTAMP_MAX], b[FORMAT_TIMESTAMP_MAX];
 
-                printf("% *i " SD_ID128_FORMAT_STR " %s—%s\n",
-                       w, i - count + 1,
-                       SD_ID128_FORMAT_VAL(id->id),
-                       format_timestamp_maybe_utc(a, sizeof(a), id->first),
-                       format_timestamp_maybe_utc(b, sizeof(b), id->last));
-                i++;
+                printf("% *zi " SD_ID128_FORMAT_STR " %s—%s\n",
+                       w, (ssize_t) i - (ssize_t) n_boots + 1,
+                       SD_ID128_FORMAT_VAL(boots[i].id),
+                       format_timestamp_maybe_utc(a, sizeof(a), boots[i].first),
+                       format_timestamp_maybe_utc(b, sizeof(b), boots[i].last));
         }
 
-        boot_id_free_all(all_ids);
-
         return 0;
 }
 
@@ -1484,7 +1303,7 @@ static int add_boot(sd_journal *j) {
                 return add_match_this_boot(j, arg_machine);
 
         boot_id = arg_boot_id;
-        r = get_boots(j, NULL, &boot_id, arg_boot_offset);
+        r = get_boots(j, &boot_id, arg_boot_offset);
         assert(r <= 1);
         if (r <= 0) {
                 const char *reason = (r == 0) ? "No such boot ID in journal" : strerror_safe(r);
@@ -1999,49 +1818,177 @@ static int setup_keys(void) {
 #endif
 }
 
+static int verify_one(JournalFile *f, bool show_progress) {
+        usec_t first = 0, validated = 0, last = 0;
+        int r;
+
+        assert(f);
+
+#if HAVE_GCRYPT
+        if (!arg_verify_key && JOURNAL_HEADER_SEALED(f->header))
+                log_notice("Journal file %s has sealing enabled but verification key has not been passed using --verify-key=.", f->path);
+#endif
+
+        r = journal_file_verify(f, arg_verify_key, &first, &validated, &last, show_progress);
+        if (r == -EINVAL)
+                /* If the key was invalid give up right-away. */
+                return r;
+        if (r < 0)
+                return log_warning_errno(r, "FAIL: %s (%m)", f->path);
+
+        char a[FORMAT_TIMESTAMP_MAX], b[FORMAT_TIMESTAMP_MAX], c[FORMAT_TIMESPAN_MAX];
+        log_info("PASS: %s", f->path);
+
+        if (arg_verify_key && JOURNAL_HEADER_SEALED(f->header)) {
+                if (validated > 0) {
+                        log_info("=> Validated from %s to %s, final %s entries not sealed.",
+                                 format_timestamp_maybe_utc(a, sizeof(a), first),
+                                 format_timestamp_maybe_utc(b, sizeof(b), validated),
+                                 format_timespan(c, sizeof(c), last > validated ? last - validated : 0, 0));
+                } else if (last > 0)
+                        log_info("=> No sealing yet, %s of entries not sealed.",
+                                 format_timespan(c, sizeof(c), last - first, 0));
+                else
+                        log_info("=> No sealing yet, no entries in file.");
+        }
+
+        return 0;
+}
+
+static int verify_wait(pid_t *pids, size_t *n_pids, int *ret_error) {
+        siginfo_t si = {};
+        size_t i;
+        int r;
+
+        assert(pids);
+        assert(n_pids);
+        assert(*n_pids > 0);
+        assert(ret_error);
+
+        /* Waits for one of our verification workers to exit, and returns the error it encountered in
+         * ret_error. We only ever wait for our own workers by PID, so that we don't reap the pager. Pick up
+         * any worker that already finished, and otherwise block on the oldest one. */
+
+        for (i = 0; i < *n_pids; i++) {
+                si = (siginfo_t) {};
+
+                if (waitid(P_PID, pids[i], &si, WEXITED|WNOHANG) < 0)
+                        return log_error_errno(errno, "Failed to wait for verification worker: %m");
+                if (si.si_pid != 0)
+                        break;
+        }
+
+        if (i >= *n_pids) {
+                i = 0;
+
+                r = wait_for_terminate(pids[i], &si);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to wait for verification worker: %m");
+        }
+
+        memmove(pids + i, pids + i + 1, (*n_pids - i - 1) * sizeof(pid_t));
+        (*n_pids)--;
+
+        if (si.si_code != CLD_EXITED)
+                *ret_error = log_error_errno(SYNTHETIC_ERRNO(EPROTO), "Verification worker died abnormally.");
+        else
+                /* The worker passes the (positive) errno value as exit status */
+                *ret_error = -si.si_status;
+
+        return 0;
+}
+
+static void verify_kill_workers(const pid_t *pids, size_t n_pids) {
+        for (size_t i = 0; i < n_pids; i++)
+                (void) kill_and_sigcont(pids[i], SIGTERM);
+
+        /* Don't leave zombies behind */
+        for (size_t i = 0; i < n_pids; i++)
+                (void) wait_for_terminate(pids[i], NULL);
+}
+
 static int verify(sd_journal *j) {
-        int r = 0;
+        _cleanup_free_ pid_t *pids = NULL;
+        size_t n_pids = 0, n_workers;
         JournalFile *f;
+        int r = 0, k;
 
         assert(j);
 
         log_show_color(true);
 
+        /* Files are independent of each other, hence verify them in parallel, one worker process per file,
+         * with at most as many workers as we have CPUs. We use processes rather than threads, since the
+         * mmap cache is not thread-safe and SIGBUS handling is process-global. */
+        k = cpus_in_affinity_mask();
+        n_workers = MIN((size_t) MAX(k, 1), ordered_hashmap_size(j->files));
+
+        if (n_workers <= 1) {
+                ORDERED_HASHMAP_FOREACH(f, j->files) {
+                        k = verify_one(f, true);
+                        if (k == -EINVAL)
+                                return k;
+                        if (k < 0)
+                                r = k;
+                }
+
+                return r;
+        }
+
+        pids = new(pid_t, n_workers);
+        if (!pids)
+                return log_oom();
+
         ORDERED_HASHMAP_FOREACH(f, j->files) {
-                int k;
-                usec_t first = 0, validated = 0, last = 0;
+                pid_t pid;
 
-#if HAVE_GCRYPT
-                if (!arg_verify_key && JOURNAL_HEADER_SEALED(f->header))
-                        log_notice("Journal file %s has sealing enabled but verification key has not been passed using --verify-key=.", f->path);
-#endif
+                if (n_pids >= n_workers) {
+                        int error;
 
-                k = journal_file_verify(f, arg_verify_key, &first, &validated, &last, true);
-                if (k == -EINVAL)
-                        /* If the key was invalid give up right-away. */
-                        return k;
-                else if (k < 0)
-                        r = log_warning_errno(k, "FAIL: %s (%m)", f->path);
-                else {
-                        char a[FORMAT_TIMESTAMP_MAX], b[FORMAT_TIMESTAMP_MAX], c[FORMAT_TIMESPAN_MAX];
-                        log_info("PASS: %s", f->path);
-
-                        if (arg_verify_key && JOURNAL_HEADER_SEALED(f->header)) {
-                                if (validated > 0) {
-                                        log_info("=> Validated from %s to %s, final %s entries not sealed.",
-                                                 format_timestamp_maybe_utc(a, sizeof(a), first),
-                                                 format_timestamp_maybe_utc(b, sizeof(b), validated),
-                                                 format_timespan(c, sizeof(c), last > validated ? last - validated : 0, 0));
-                                } else if (last > 0)
-                                        log_info("=> No sealing yet, %s of entries not sealed.",
-                                                 format_timespan(c, sizeof(c), last - first, 0));
-                                else
-                                        log_info("=> No sealing yet, no entries in file.");
+                        k = verify_wait(pids, &n_pids, &error);
+                        if (k < 0)
+                                goto fail;
+                        if (error == -EINVAL) {
+                                k = error;
+                                goto fail;
                         }
+                        if (error < 0)
+                                r = error;
+                }
+
+                k = safe_fork("(journal-verify)", FORK_DEATHSIG|FORK_LOG, &pid);
+                if (k < 0)
+                        goto fail;
+                if (k == 0) {
+                        /* Child */
+                        k = verify_one(f, false);
+                        _exit(k < 0 ? -k : EXIT_SUCCESS);
+                }
+
+                pids[n_pids++] = pid;
+        }
+
+        while (n_pids > 0) {
+                int error;
+
+                k = verify_wait(pids, &n_pids, &error);
+                if (k < 0)
+                        goto fail;
+                if (error == -EINVAL) {
+                        k = error;
+                        goto fail;
                 }
+                if (error < 0)
+                        r = error;
         }
 
         return r;
+
+fail:
+        /* If the key was invalid there's no point in continuing with the other files, and if we can't
+         * track our workers anymore we shouldn't leave them behind either. */
+        verify_kill_workers(pids, n_pids);
+        return k;
 }
 
 static int simple_varlink_call(const char *option, const char *method) {
@@ -2131,6 +2078,9 @@ int main(int argc, char *argv[]) {
         bool previous_boot_id_valid = false, first_line = true, ellipsized = false, need_seek = false;
         bool use_cursor = false, after_cursor = false;
         _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+#if HAVE_PCRE2
+        _cleanup_(sym_pcre2_match_data_freep) pcre2_match_data *md = NULL;
+#endif
         sd_id128_t previous_boot_id;
         int n_shown = 0, r, poll_fd = -1;
 
@@ -2673,14 +2623,15 @@ int main(int argc, char *argv[]) {
 
 #if HAVE_PCRE2
                         if (arg_compiled_pattern) {
-                                _cleanup_(sym_pcre2_match_data_freep) pcre2_match_data *md = NULL;
                                 const void *message;
                                 size_t len;
                                 PCRE2_SIZE *ovec;
 
-                                md = sym_pcre2_match_data_create(1, NULL);
-                                if (!md)
-                                        return log_oom();
+                                if (!md) {
+                                        md = sym_pcre2_match_data_create(1, NULL);
+                                        if (!md)
+                                                return log_oom();
+                                }
 
                                 r = sd_journal_get_data(j, "MESSAGE", &message, &len);
                                 if (r < 0) {
@@ -432,6 +432,8 @@ void server_process_audit_message(
 
         assert(s);
 
+        server_account_message(s, SERVER_TRANSPORT_AUDIT, buffer_size);
+
         if (buffer_size < ALIGN(sizeof(struct nlmsghdr)))
                 return;
 
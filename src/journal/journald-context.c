@@ -10,6 +10,7 @@
 #include "env-util.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "format-util.h"
 #include "fs-util.h"
 #include "io-util.h"
 #include "journal-util.h"
@@ -18,6 +19,7 @@
 #include "path-util.h"
 #include "process-util.h"
 #include "procfs-util.h"
+#include "stdio-util.h"
 #include "string-util.h"
 #include "syslog-util.h"
 #include "unaligned.h"
@@ -32,7 +34,9 @@
  * until they are unpinned. Unpinned entries are kept around until cache pressure is seen. Cache entries older than 5s
  * are never used (a sad attempt to deal with the UNIX weakness of PIDs reuse), cache entries older than 1s are
  * refreshed in an incremental way (meaning: data is reread from /proc, but any old data we can't refresh is not
- * flushed out). Data newer than 1s is used immediately without refresh.
+ * flushed out). Data newer than 1s is used immediately without refresh. Since we have data to use in the meantime,
+ * the incremental refresh is not done while processing the log message, but later from the event loop, once there
+ * are no more messages to process.
  *
  * Log stream clients (i.e. all clients using the AF_UNIX/SOCK_STREAM stdout/stderr transport) will pin a cache entry
  * as long as their socket is connected. Note that cache entries are shared between different transports. That means a
@@ -66,6 +70,12 @@
 #define CACHE_MAX_MAX (16*1024U)
 #define CACHE_MAX_MIN 64U
 
+/* How many cache entries to refresh per event loop iteration at max */
+#define REFRESH_BATCH_MAX 16U
+
+/* The number of trusted fields we might add from the cached data */
+#define TRUSTED_FIELDS_MAX 18U
+
 static size_t cache_max(void) {
         static size_t cached = -1;
 
@@ -175,12 +185,26 @@ static void client_context_reset(Server *s, ClientContext *c) {
         c->extra_fields_data = mfree(c->extra_fields_data);
         c->extra_fields_mtime = NSEC_INFINITY;
 
+        c->trusted_fields_iovec = mfree(c->trusted_fields_iovec);
+        c->trusted_fields_n_iovec = 0;
+
         c->log_level_max = -1;
 
         c->log_ratelimit_interval = s->ratelimit_interval;
         c->log_ratelimit_burst = s->ratelimit_burst;
 }
 
+static void client_context_dequeue_refresh(Server *s, ClientContext *c) {
+        assert(s);
+        assert(c);
+
+        if (!c->in_refresh_queue)
+                return;
+
+        LIST_REMOVE(refresh_queue, s->client_contexts_refresh_queue, c);
+        c->in_refresh_queue = false;
+}
+
 static ClientContext* client_context_free(Server *s, ClientContext *c) {
         assert(s);
 
@@ -189,6 +213,8 @@ static ClientContext* client_context_free(Server *s, ClientContext *c) {
 
         assert_se(hashmap_remove(s->client_contexts, PID_TO_PTR(c->pid)) == c);
 
+        client_context_dequeue_refresh(s, c);
+
         if (c->in_lru)
                 assert_se(prioq_remove(s->client_contexts_lru, c, &c->lru_index) >= 0);
 
@@ -500,6 +526,92 @@ static int client_context_read_log_ratelimit_burst(ClientContext *c) {
         return safe_atou(value, &c->log_ratelimit_burst);
 }
 
+static int client_context_format_trusted_fields(ClientContext *c) {
+        char pid[DECIMAL_STR_MAX(pid_t)], uid[DECIMAL_STR_MAX(uid_t)], gid[DECIMAL_STR_MAX(gid_t)],
+                auditid[DECIMAL_STR_MAX(uint32_t)], loginuid[DECIMAL_STR_MAX(uid_t)],
+                owner_uid[DECIMAL_STR_MAX(uid_t)], invocation_id[SD_ID128_STRING_MAX];
+        struct {
+                const char *field;
+                const void *value;
+                size_t size;
+        } fields[TRUSTED_FIELDS_MAX];
+        size_t n = 0, size = 0;
+        struct iovec *iovec;
+        uint8_t *q;
+
+        assert(c);
+
+        /* Formats the trusted fields we add to each entry of this client once, into a single allocation of
+         * an iovec array followed by the field data, so that they can be copied into the entries as they
+         * are. This needs to be redone whenever the cached data changes. */
+
+#define ADD_FIELD(_field, _value, _size)                                \
+        do {                                                            \
+                size_t _s = (_size);                                    \
+                if (_s > 0) {                                           \
+                        assert(n < ELEMENTSOF(fields));                 \
+                        fields[n++] = (typeof(fields[0])) { _field, _value, _s }; \
+                        size += STRLEN(_field) + _s;                    \
+                }                                                       \
+        } while (false)
+
+#define ADD_STRING_FIELD(_field, _value)                                \
+        ADD_FIELD(_field, _value, strlen_ptr(_value))
+
+#define ADD_NUMERIC_FIELD(_field, _buf, _value, _isset, _format)        \
+        do {                                                            \
+                if (_isset(_value)) {                                   \
+                        xsprintf(_buf, _format, _value);                \
+                        ADD_STRING_FIELD(_field, _buf);                 \
+                }                                                       \
+        } while (false)
+
+        ADD_NUMERIC_FIELD("_PID=", pid, c->pid, pid_is_valid, PID_FMT);
+        ADD_NUMERIC_FIELD("_UID=", uid, c->uid, uid_is_valid, UID_FMT);
+        ADD_NUMERIC_FIELD("_GID=", gid, c->gid, gid_is_valid, GID_FMT);
+
+        ADD_STRING_FIELD("_COMM=", c->comm);
+        ADD_STRING_FIELD("_EXE=", c->exe);
+        ADD_STRING_FIELD("_CMDLINE=", c->cmdline);
+
+        ADD_STRING_FIELD("_CAP_EFFECTIVE=", c->capeff);
+        ADD_FIELD("_SELINUX_CONTEXT=", c->label, c->label_size);
+        ADD_NUMERIC_FIELD("_AUDIT_SESSION=", auditid, c->auditid, audit_session_is_valid, "%" PRIu32);
+        ADD_NUMERIC_FIELD("_AUDIT_LOGINUID=", loginuid, c->loginuid, uid_is_valid, UID_FMT);
+
+        ADD_STRING_FIELD("_SYSTEMD_CGROUP=", c->cgroup);
+        ADD_STRING_FIELD("_SYSTEMD_SESSION=", c->session);
+        ADD_NUMERIC_FIELD("_SYSTEMD_OWNER_UID=", owner_uid, c->owner_uid, uid_is_valid, UID_FMT);
+        ADD_STRING_FIELD("_SYSTEMD_UNIT=", c->unit);
+        ADD_STRING_FIELD("_SYSTEMD_USER_UNIT=", c->user_unit);
+        ADD_STRING_FIELD("_SYSTEMD_SLICE=", c->slice);
+        ADD_STRING_FIELD("_SYSTEMD_USER_SLICE=", c->user_slice);
+
+        if (!sd_id128_is_null(c->invocation_id))
+                ADD_STRING_FIELD("_SYSTEMD_INVOCATION_ID=", sd_id128_to_string(c->invocation_id, invocation_id));
+
+#undef ADD_NUMERIC_FIELD
+#undef ADD_STRING_FIELD
+#undef ADD_FIELD
+
+        iovec = malloc(n * sizeof(struct iovec) + size);
+        if (!iovec)
+                return -ENOMEM;
+
+        q = (uint8_t*) (iovec + n);
+        for (size_t i = 0; i < n; i++) {
+                size_t l = strlen(fields[i].field);
+
+                iovec[i] = IOVEC_MAKE(q, l + fields[i].size);
+                q = mempcpy(mempcpy(q, fields[i].field, l), fields[i].value, fields[i].size);
+        }
+
+        free_and_replace(c->trusted_fields_iovec, iovec);
+        c->trusted_fields_n_iovec = n;
+
+        return 0;
+}
+
 static void client_context_really_refresh(
                 Server *s,
                 ClientContext *c,
@@ -508,6 +620,8 @@ static void client_context_really_refresh(
                 const char *unit_id,
                 usec_t timestamp) {
 
+        int r;
+
         assert(s);
         assert(c);
         assert(pid_is_valid(c->pid));
@@ -515,6 +629,8 @@ static void client_context_really_refresh(
         if (timestamp == USEC_INFINITY)
                 timestamp = now(CLOCK_MONOTONIC);
 
+        client_context_dequeue_refresh(s, c);
+
         client_context_read_uid_gid(c, ucred);
         client_context_read_basic(c);
         (void) client_context_read_label(c, label, label_size);
@@ -529,6 +645,10 @@ static void client_context_really_refresh(
         (void) client_context_read_log_ratelimit_interval(c);
         (void) client_context_read_log_ratelimit_burst(c);
 
+        r = client_context_format_trusted_fields(c);
+        if (r < 0)
+                log_debug_errno(r, "Failed to format trusted fields of PID " PID_FMT ", ignoring: %m", c->pid);
+
         c->timestamp = timestamp;
 
         if (c->in_lru) {
@@ -537,6 +657,52 @@ static void client_context_really_refresh(
         }
 }
 
+static int client_context_dispatch_refresh(sd_event_source *es, void *userdata) {
+        Server *s = userdata;
+
+        assert(s);
+
+        for (unsigned i = 0; i < REFRESH_BATCH_MAX && s->client_contexts_refresh_queue; i++)
+                client_context_really_refresh(s, s->client_contexts_refresh_queue, NULL, NULL, 0, NULL, USEC_INFINITY);
+
+        if (!s->client_contexts_refresh_queue)
+                return sd_event_source_set_enabled(es, SD_EVENT_OFF);
+
+        return 0;
+}
+
+static int client_context_enqueue_refresh(Server *s, ClientContext *c) {
+        int r;
+
+        assert(s);
+        assert(c);
+
+        if (c->in_refresh_queue)
+                return 0;
+
+        if (!s->client_contexts_refresh_event_source) {
+                r = sd_event_add_defer(s->event, &s->client_contexts_refresh_event_source, client_context_dispatch_refresh, s);
+                if (r < 0)
+                        return r;
+
+                /* Below the priority of the log sources, so that we get to it only once the messages are processed */
+                r = sd_event_source_set_priority(s->client_contexts_refresh_event_source, SD_EVENT_PRIORITY_NORMAL+15);
+                if (r < 0)
+                        return r;
+
+                (void) sd_event_source_set_description(s->client_contexts_refresh_event_source, "client-context-refresh");
+        }
+
+        r = sd_event_source_set_enabled(s->client_contexts_refresh_event_source, SD_EVENT_ON);
+        if (r < 0)
+                return r;
+
+        LIST_PREPEND(refresh_queue, s->client_contexts_refresh_queue, c);
+        c->in_refresh_queue = true;
+
+        return 0;
+}
+
 void client_context_maybe_refresh(
                 Server *s,
                 ClientContext *c,
@@ -562,11 +728,7 @@ void client_context_maybe_refresh(
                 goto refresh;
         }
 
-        /* If the data is older than the lower limit, we refresh, but keep the old data for all we can't update */
-        if (c->timestamp + REFRESH_USEC < timestamp)
-                goto refresh;
-
-        /* If the data passed along doesn't match the cached data we also do a refresh */
+        /* If the data passed along doesn't match the cached data we do a refresh right-away */
         if (ucred && uid_is_valid(ucred->uid) && c->uid != ucred->uid)
                 goto refresh;
 
@@ -576,6 +738,15 @@ void client_context_maybe_refresh(
         if (label_size > 0 && (label_size != c->label_size || memcmp(label, c->label, label_size) != 0))
                 goto refresh;
 
+        /* If the data is older than the lower limit, we refresh, but keep the old data for all we can't update. We
+         * keep using the old data until then, hence there's no need to do this right-away. */
+        if (c->timestamp + REFRESH_USEC < timestamp) {
+                if (client_context_enqueue_refresh(s, c) >= 0)
+                        return;
+
+                goto refresh;
+        }
+
         return;
 
 refresh:
@@ -629,6 +800,23 @@ static void client_context_try_shrink_to(Server *s, size_t limit) {
         }
 }
 
+void client_context_trim(Server *s) {
+        assert(s);
+
+        /* Flush out all entries that aren't pinned */
+        client_context_try_shrink_to(s, 0);
+}
+
+static size_t client_context_cache_max(Server *s) {
+        assert(s);
+
+        /* Don't let the cache grow back to full size while we are short on memory */
+        if (server_low_memory(s))
+                return CACHE_MAX_MIN;
+
+        return cache_max();
+}
+
 void client_context_flush_all(Server *s) {
         assert(s);
 
@@ -667,16 +855,8 @@ static int client_context_get_internal(
         c = hashmap_get(s->client_contexts, PID_TO_PTR(pid));
         if (c) {
 
-                if (add_ref) {
-                        if (c->in_lru) {
-                                /* The entry wasn't pinned so far, let's remove it from the LRU list then */
-                                assert(c->n_ref == 0);
-                                assert_se(prioq_remove(s->client_contexts_lru, c, &c->lru_index) >= 0);
-                                c->in_lru = false;
-                        }
-
-                        c->n_ref++;
-                }
+                if (add_ref)
+                        client_context_ref(s, c);
 
                 client_context_maybe_refresh(s, c, ucred, label, label_len, unit_id, USEC_INFINITY);
 
@@ -684,7 +864,7 @@ static int client_context_get_internal(
                 return 0;
         }
 
-        client_context_try_shrink_to(s, cache_max()-1);
+        client_context_try_shrink_to(s, client_context_cache_max(s)-1);
 
         r = client_context_new(s, pid, &c);
         if (r < 0)
@@ -730,6 +910,21 @@ int client_context_acquire(
         return client_context_get_internal(s, pid, ucred, label, label_len, unit_id, true, ret);
 };
 
+ClientContext* client_context_ref(Server *s, ClientContext *c) {
+        assert(s);
+        assert(c);
+
+        if (c->in_lru) {
+                /* The entry wasn't pinned so far, let's remove it from the LRU list then */
+                assert(c->n_ref == 0);
+                assert_se(prioq_remove(s->client_contexts_lru, c, &c->lru_index) >= 0);
+                c->in_lru = false;
+        }
+
+        c->n_ref++;
+        return c;
+}
+
 ClientContext *client_context_release(Server *s, ClientContext *c) {
         assert(s);
 
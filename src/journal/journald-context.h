@@ -7,6 +7,7 @@
 
 #include "sd-id128.h"
 
+#include "list.h"
 #include "time-util.h"
 
 typedef struct ClientContext ClientContext;
@@ -18,6 +19,9 @@ struct ClientContext {
         unsigned lru_index;
         usec_t timestamp;
         bool in_lru;
+        bool in_refresh_queue;
+
+        LIST_FIELDS(ClientContext, refresh_queue);
 
         pid_t pid;
         uid_t uid;
@@ -53,6 +57,10 @@ struct ClientContext {
         void *extra_fields_data;
         nsec_t extra_fields_mtime;
 
+        /* The trusted fields above, formatted as "_PID=…" and so on, ready to be copied into entries */
+        struct iovec *trusted_fields_iovec;
+        size_t trusted_fields_n_iovec;
+
         usec_t log_ratelimit_interval;
         unsigned log_ratelimit_burst;
 };
@@ -73,6 +81,7 @@ int client_context_acquire(
                 const char *unit_id,
                 ClientContext **ret);
 
+ClientContext* client_context_ref(Server *s, ClientContext *c);
 ClientContext* client_context_release(Server *s, ClientContext *c);
 
 void client_context_maybe_refresh(
@@ -85,6 +94,7 @@ void client_context_maybe_refresh(
 
 void client_context_acquire_default(Server *s);
 void client_context_flush_all(Server *s);
+void client_context_trim(Server *s);
 
 static inline size_t client_context_extra_fields_n_iovec(const ClientContext *c) {
         return c ? c->extra_fields_n_iovec : 0;
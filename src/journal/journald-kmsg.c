@@ -23,6 +23,13 @@
 #include "process-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
+#include "strv.h"
+
+/* For how long to reuse the _UDEV_* fields of a device for further messages about the same device */
+#define KMSG_DEVICE_CACHE_USEC (1 * USEC_PER_SEC)
+
+/* How many records to read from /dev/kmsg at most per wakeup, before giving other event sources a chance */
+#define KMSG_RECORDS_PER_WAKEUP 64U
 
 void server_forward_kmsg(
                 Server *s,
@@ -95,6 +102,68 @@ static bool is_us(const char *identifier, const char *pid) {
                streq(identifier, program_invocation_short_name);
 }
 
+static int dev_kmsg_device_fields(Server *s, const char *device_id, char ***ret) {
+        _cleanup_(sd_device_unrefp) sd_device *d = NULL;
+        _cleanup_strv_free_ char **fields = NULL;
+        const char *g;
+        usec_t n;
+        size_t j = 0;
+        int r;
+
+        assert(s);
+        assert(device_id);
+        assert(ret);
+
+        /* Driver error storms tend to come with many messages about the very same device. Building an
+         * sd_device object from /sys and the udev database for each of them is expensive, hence remember
+         * the fields of the last device for a short while. */
+
+        n = now(CLOCK_MONOTONIC);
+        if (streq_ptr(s->kmsg_device_id, device_id) &&
+            n < usec_add(s->kmsg_device_timestamp, KMSG_DEVICE_CACHE_USEC)) {
+                *ret = s->kmsg_device_fields;
+                return 0;
+        }
+
+        r = sd_device_new_from_device_id(&d, device_id);
+        if (r < 0)
+                return r;
+
+        if (sd_device_get_devname(d, &g) >= 0) {
+                r = strv_consume(&fields, strjoin("_UDEV_DEVNODE=", g));
+                if (r < 0)
+                        return r;
+        }
+
+        if (sd_device_get_sysname(d, &g) >= 0) {
+                r = strv_consume(&fields, strjoin("_UDEV_SYSNAME=", g));
+                if (r < 0)
+                        return r;
+        }
+
+        FOREACH_DEVICE_DEVLINK(d, g) {
+
+                if (j >= N_IOVEC_UDEV_FIELDS)
+                        break;
+
+                r = strv_consume(&fields, strjoin("_UDEV_DEVLINK=", g));
+                if (r < 0)
+                        return r;
+
+                j++;
+        }
+
+        r = free_and_strdup(&s->kmsg_device_id, device_id);
+        if (r < 0)
+                return r;
+
+        strv_free_and_replace(s->kmsg_device_fields, fields);
+        s->kmsg_device_timestamp = n;
+
+        *ret = s->kmsg_device_fields;
+        return 0;
+}
+
 void dev_kmsg_record(Server *s, char *p, size_t l) {
 
         _cleanup_free_ char *message = NULL, *syslog_priority = NULL, *syslog_pid = NULL, *syslog_facility = NULL, *syslog_identifier = NULL, *source_time = NULL, *identifier = NULL, *pid = NULL;
@@ -113,6 +182,8 @@ void dev_kmsg_record(Server *s, char *p, size_t l) {
         if (l <= 0)
                 return;
 
+        server_account_message(s, SERVER_TRANSPORT_KERNEL, l);
+
         e = memchr(p, ',', l);
         if (!e)
                 return;
@@ -211,43 +282,12 @@ void dev_kmsg_record(Server *s, char *p, size_t l) {
         }
 
         if (kernel_device) {
-                _cleanup_(sd_device_unrefp) sd_device *d = NULL;
-
-                if (sd_device_new_from_device_id(&d, kernel_device) >= 0) {
-                        const char *g;
-                        char *b;
-
-                        if (sd_device_get_devname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_DEVNODE=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        if (sd_device_get_sysname(d, &g) >= 0) {
-                                b = strjoin("_UDEV_SYSNAME=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-                        }
-
-                        j = 0;
-                        FOREACH_DEVICE_DEVLINK(d, g) {
-
-                                if (j >= N_IOVEC_UDEV_FIELDS)
-                                        break;
-
-                                b = strjoin("_UDEV_DEVLINK=", g);
-                                if (b) {
-                                        iovec[n++] = IOVEC_MAKE_STRING(b);
-                                        z++;
-                                }
-
-                                j++;
-                        }
-                }
+                char **fields, **g;
+
+                /* The fields are owned by the cache, hence they are not counted in z */
+                if (dev_kmsg_device_fields(s, kernel_device, &fields) >= 0)
+                        STRV_FOREACH(g, fields)
+                                iovec[n++] = IOVEC_MAKE_STRING(*g);
         }
 
         if (asprintf(&source_time, "_SOURCE_MONOTONIC_TIMESTAMP=%llu", usec) >= 0)
@@ -350,6 +390,7 @@ int server_flush_dev_kmsg(Server *s) {
 
 static int dispatch_dev_kmsg(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
         Server *s = userdata;
+        int r;
 
         assert(es);
         assert(fd == s->dev_kmsg_fd);
@@ -361,7 +402,15 @@ static int dispatch_dev_kmsg(sd_event_source *es, int fd, uint32_t revents, void
         if (!(revents & EPOLLIN))
                 log_error("Got invalid event from epoll for /dev/kmsg: %"PRIx32, revents);
 
-        return server_read_dev_kmsg(s);
+        /* Read a batch of records per wakeup instead of a single one, so that bursts of kernel messages
+         * don't cost a full event loop iteration each. */
+        for (unsigned i = 0; i < KMSG_RECORDS_PER_WAKEUP; i++) {
+                r = server_read_dev_kmsg(s);
+                if (r <= 0)
+                        return r;
+        }
+
+        return 0;
 }
 
 int server_open_dev_kmsg(Server *s) {
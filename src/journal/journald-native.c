@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include "alloc-util.h"
+#include "arena.h"
 #include "fd-util.h"
 #include "fs-util.h"
 #include "io-util.h"
@@ -34,6 +35,7 @@ static bool allow_object_pid(const struct ucred *ucred) {
 }
 
 static void server_process_entry_meta(
+                Arena *arena,
                 const char *p, size_t l,
                 const struct ucred *ucred,
                 int *priority,
@@ -63,21 +65,17 @@ static void server_process_entry_meta(
                  startswith(p, "SYSLOG_IDENTIFIER=")) {
                 char *t;
 
-                t = memdup_suffix0(p + 18, l - 18);
-                if (t) {
-                        free(*identifier);
+                t = arena_strndup(arena, p + 18, l - 18);
+                if (t)
                         *identifier = t;
-                }
 
         } else if (l >= 8 &&
                    startswith(p, "MESSAGE=")) {
                 char *t;
 
-                t = memdup_suffix0(p + 8, l - 8);
-                if (t) {
-                        free(*message);
+                t = arena_strndup(arena, p + 8, l - 8);
+                if (t)
                         *message = t;
-                }
 
         } else if (l > STRLEN("OBJECT_PID=") &&
                    l < STRLEN("OBJECT_PID=")  + DECIMAL_STR_MAX(pid_t) &&
@@ -103,9 +101,11 @@ static int server_process_entry(
         /* Process a single entry from a native message. Returns 0 if nothing special happened and the message
          * processing should continue, and a negative or positive value otherwise.
          *
-         * Note that *remaining is altered on both success and failure. */
+         * Note that *remaining is altered on both success and failure.
+         *
+         * Everything allocated for the entry comes from s->native_arena, which is reset when we are done. */
 
-        size_t n = 0, j, tn = SIZE_MAX, entry_size = 0;
+        size_t n = 0, entry_size = 0;
         char *identifier = NULL, *message = NULL;
         struct iovec *iovec = NULL;
         int priority = LOG_INFO;
@@ -176,7 +176,7 @@ static int server_process_entry(
                                 iovec[n++] = IOVEC_MAKE((char*) p, l);
                                 entry_size += l;
 
-                                server_process_entry_meta(p, l, ucred,
+                                server_process_entry_meta(&s->native_arena, p, l, ucred,
                                                           &priority,
                                                           &identifier,
                                                           &message,
@@ -214,7 +214,7 @@ static int server_process_entry(
                                 break;
                         }
 
-                        k = malloc(total);
+                        k = arena_alloc(&s->native_arena, total);
                         if (!k) {
                                 log_oom();
                                 break;
@@ -229,13 +229,12 @@ static int server_process_entry(
                                 entry_size += iovec[n].iov_len;
                                 n++;
 
-                                server_process_entry_meta(k, (e - p) + 1 + l, ucred,
+                                server_process_entry_meta(&s->native_arena, k, (e - p) + 1 + l, ucred,
                                                           &priority,
                                                           &identifier,
                                                           &message,
                                                           &object_pid);
-                        } else
-                                free(k);
+                        }
 
                         *remaining -= (e - p) + 1 + sizeof(uint64_t) + l + 1;
                         p = e + 1 + sizeof(uint64_t) + l + 1;
@@ -245,8 +244,7 @@ static int server_process_entry(
         if (n <= 0)
                 goto finish;
 
-        tn = n++;
-        iovec[tn] = IOVEC_MAKE_STRING("_TRANSPORT=journal");
+        iovec[n++] = IOVEC_MAKE_STRING("_TRANSPORT=journal");
         entry_size += STRLEN("_TRANSPORT=journal");
 
         if (entry_size + n + 1 > ENTRY_SIZE_MAX) { /* data + separators + trailer */
@@ -276,18 +274,8 @@ static int server_process_entry(
         server_dispatch_message(s, iovec, n, MALLOC_ELEMENTSOF(iovec), context, tv, priority, object_pid);
 
 finish:
-        for (j = 0; j < n; j++)  {
-                if (j == tn)
-                        continue;
-
-                if (iovec[j].iov_base < buffer ||
-                    (const char*) iovec[j].iov_base >= p + *remaining)
-                        free(iovec[j].iov_base);
-        }
-
         free(iovec);
-        free(identifier);
-        free(message);
+        arena_reset(&s->native_arena);
 
         return r;
 }
@@ -306,6 +294,8 @@ void server_process_native_message(
         assert(s);
         assert(buffer || buffer_size == 0);
 
+        server_account_message(s, SERVER_TRANSPORT_JOURNAL, buffer_size);
+
         if (ucred && pid_is_valid(ucred->pid)) {
                 r = client_context_get(s, ucred->pid, ucred, label, label_len, NULL, &context);
                 if (r < 0)
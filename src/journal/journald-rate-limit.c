@@ -13,6 +13,7 @@
 #define POOLS_MAX 5
 #define BUCKETS_MAX 127
 #define GROUPS_MAX 2047
+#define LEVELS_MAX 4
 
 static const int priority_map[] = {
         [LOG_EMERG]   = 0,
@@ -29,9 +30,15 @@ typedef struct JournalRateLimitPool JournalRateLimitPool;
 typedef struct JournalRateLimitGroup JournalRateLimitGroup;
 
 struct JournalRateLimitPool {
-        usec_t begin;
-        unsigned num;
+        /* Token bucket, tracked as the "theoretical arrival time": every permitted message pushes this
+         * forward by interval/burst, and a message is permitted as long as this stays within one interval
+         * of the current time. Hence the bucket holds up to 'burst' messages and refills continuously. */
+        usec_t tat;
+
+        /* Suppressed messages are reported at most once per interval, so that a peer that keeps
+         * exceeding its budget does not get a suppression message for every message let through. */
         unsigned suppressed;
+        usec_t suppressed_reported;
 };
 
 struct JournalRateLimitGroup {
@@ -105,24 +112,25 @@ static bool journal_ratelimit_group_expired(JournalRateLimitGroup *g, usec_t ts)
         assert(g);
 
         for (i = 0; i < POOLS_MAX; i++)
-                if (g->pools[i].begin + g->interval >= ts)
+                if (g->pools[i].tat + g->interval >= ts)
                         return false;
 
         return true;
 }
 
-static void journal_ratelimit_vacuum(JournalRateLimit *r, usec_t ts) {
+static void journal_ratelimit_vacuum(JournalRateLimit *r, size_t n_new, usec_t ts) {
         assert(r);
+        assert(n_new <= GROUPS_MAX);
 
-        /* Makes room for at least one new item, but drop all
+        /* Makes room for at least n_new new items, but drop all
          * expored items too. */
 
-        while (r->n_groups >= GROUPS_MAX ||
+        while (r->n_groups + n_new > GROUPS_MAX ||
                (r->lru_tail && journal_ratelimit_group_expired(r->lru_tail, ts)))
                 journal_ratelimit_group_free(r->lru_tail);
 }
 
-static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, const char *id, usec_t interval, usec_t ts) {
+static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, const char *id, usec_t interval) {
         JournalRateLimitGroup *g;
 
         assert(r);
@@ -140,8 +148,6 @@ static JournalRateLimitGroup* journal_ratelimit_group_new(JournalRateLimit *r, c
 
         g->interval = interval;
 
-        journal_ratelimit_vacuum(r, ts);
-
         LIST_PREPEND(bucket, r->buckets[g->hash % BUCKETS_MAX], g);
         LIST_PREPEND(lru, r->lru, g);
         if (!g->lru_next)
@@ -184,71 +190,122 @@ static unsigned burst_modulate(unsigned burst, uint64_t available) {
         return burst;
 }
 
-int journal_ratelimit_test(JournalRateLimit *r, const char *id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available) {
-        uint64_t h;
+static JournalRateLimitGroup* journal_ratelimit_group_get(JournalRateLimit *r, const char *id, usec_t interval) {
         JournalRateLimitGroup *g;
-        JournalRateLimitPool *p;
-        unsigned burst;
-        usec_t ts;
+        uint64_t h;
 
+        assert(r);
         assert(id);
 
-        /* Returns:
+        h = siphash24_string(id, r->hash_key);
+        g = r->buckets[h % BUCKETS_MAX];
+
+        LIST_FOREACH(bucket, g, g)
+                if (streq(g->id, id)) {
+                        g->interval = interval;
+                        return g;
+                }
+
+        return journal_ratelimit_group_new(r, id, interval);
+}
+
+static bool journal_ratelimit_pool_permits(JournalRateLimitPool *p, usec_t interval, unsigned burst, usec_t ts, usec_t *ret_tat) {
+        usec_t cost, tat;
+
+        assert(p);
+        assert(interval > 0);
+        assert(burst > 0);
+        assert(ret_tat);
+
+        cost = MAX(interval / burst, 1U);
+        tat = MAX(p->tat, ts);
+
+        if (tat + cost > ts + interval)
+                return false;
+
+        *ret_tat = tat + cost;
+        return true;
+}
+
+int journal_ratelimit_test_at(
+                JournalRateLimit *r,
+                JournalRateLimitLevel *levels,
+                size_t n_levels,
+                int priority,
+                uint64_t available,
+                usec_t ts) {
+
+        JournalRateLimitPool *pools[LEVELS_MAX];
+        usec_t tats[LEVELS_MAX];
+        size_t n_pools = 0;
+
+        assert(levels || n_levels == 0);
+        assert(n_levels <= LEVELS_MAX);
+
+        /* Tests the message against a hierarchy of budgets, innermost first (e.g. the unit, then its
+         * slice). The message is only permitted if every level still has budget left, and only then is it
+         * charged against all of them, so that a message suppressed by one level does not eat into the
+         * budget of the others. Suppressed messages are counted at the innermost level that refused them.
          *
-         * 0     → the log message shall be suppressed,
-         * 1 + n → the log message shall be permitted, and n messages were dropped from the peer before
-         * < 0   → error
+         * Returns:
+         *
+         * 0   → the log message shall be suppressed,
+         * 1   → the log message shall be permitted; for each level, 'suppressed' is set to the number of
+         *       messages dropped by it that are due to be reported
+         * < 0 → error
          */
 
+        for (size_t i = 0; i < n_levels; i++)
+                levels[i].suppressed = 0;
+
         if (!r)
                 return 1;
 
-        ts = now(CLOCK_MONOTONIC);
+        /* Make room before looking anything up, so that creating the group of one level can never drop
+         * the group of another. */
+        journal_ratelimit_vacuum(r, n_levels, ts);
 
-        h = siphash24_string(id, r->hash_key);
-        g = r->buckets[h % BUCKETS_MAX];
+        for (size_t i = 0; i < n_levels; i++) {
+                JournalRateLimitGroup *g;
+                JournalRateLimitPool *p;
 
-        LIST_FOREACH(bucket, g, g)
-                if (streq(g->id, id))
-                        break;
+                assert(levels[i].id);
 
-        if (!g) {
-                g = journal_ratelimit_group_new(r, id, rl_interval, ts);
+                g = journal_ratelimit_group_get(r, levels[i].id, levels[i].interval);
                 if (!g)
                         return -ENOMEM;
-        } else
-                g->interval = rl_interval;
 
-        if (rl_interval == 0 || rl_burst == 0)
-                return 1;
+                if (levels[i].interval == 0 || levels[i].burst == 0)
+                        continue;
 
-        burst = burst_modulate(rl_burst, available);
+                p = &g->pools[priority_map[priority]];
 
-        p = &g->pools[priority_map[priority]];
+                if (!journal_ratelimit_pool_permits(p, levels[i].interval, burst_modulate(levels[i].burst, available), ts, tats + n_pools)) {
+                        p->suppressed++;
+                        return 0;
+                }
 
-        if (p->begin <= 0) {
-                p->suppressed = 0;
-                p->num = 1;
-                p->begin = ts;
-                return 1;
+                pools[n_pools++] = p;
         }
 
-        if (p->begin + rl_interval < ts) {
-                unsigned s;
+        for (size_t i = 0, j = 0; i < n_levels; i++) {
+                if (levels[i].interval == 0 || levels[i].burst == 0)
+                        continue;
 
-                s = p->suppressed;
-                p->suppressed = 0;
-                p->num = 1;
-                p->begin = ts;
+                pools[j]->tat = tats[j];
 
-                return 1 + s;
-        }
+                if (pools[j]->suppressed > 0 && pools[j]->suppressed_reported + levels[i].interval <= ts) {
+                        levels[i].suppressed = pools[j]->suppressed;
+                        pools[j]->suppressed = 0;
+                        pools[j]->suppressed_reported = ts;
+                }
 
-        if (p->num < burst) {
-                p->num++;
-                return 1;
+                j++;
         }
 
-        p->suppressed++;
-        return 0;
+        return 1;
+}
+
+int journal_ratelimit_test(JournalRateLimit *r, JournalRateLimitLevel *levels, size_t n_levels, int priority, uint64_t available) {
+        return journal_ratelimit_test_at(r, levels, n_levels, priority, available, now(CLOCK_MONOTONIC));
 }
@@ -5,6 +5,16 @@
 
 typedef struct JournalRateLimit JournalRateLimit;
 
+typedef struct JournalRateLimitLevel {
+        const char *id;
+        usec_t interval;
+        unsigned burst;
+
+        /* Set by journal_ratelimit_test() */
+        unsigned suppressed;
+} JournalRateLimitLevel;
+
 JournalRateLimit *journal_ratelimit_new(void);
 void journal_ratelimit_free(JournalRateLimit *r);
-int journal_ratelimit_test(JournalRateLimit *r, const char *id, usec_t rl_interval, unsigned rl_burst, int priority, uint64_t available);
+int journal_ratelimit_test_at(JournalRateLimit *r, JournalRateLimitLevel *levels, size_t n_levels, int priority, uint64_t available, usec_t ts);
+int journal_ratelimit_test(JournalRateLimit *r, JournalRateLimitLevel *levels, size_t n_levels, int priority, uint64_t available);
@@ -46,6 +46,7 @@
 #include "parse-util.h"
 #include "path-util.h"
 #include "proc-cmdline.h"
+#include "psi-util.h"
 #include "process-util.h"
 #include "rm-rf.h"
 #include "selinux-util.h"
@@ -54,6 +55,7 @@
 #include "stdio-util.h"
 #include "string-table.h"
 #include "string-util.h"
+#include "strv.h"
 #include "syslog-util.h"
 #include "user-record.h"
 #include "user-util.h"
@@ -69,6 +71,12 @@
 
 #define NOTIFY_SNDBUF_SIZE (8*1024*1024)
 
+/* Trim our caches if tasks in our cgroup are stalled on memory for 150ms within 2s, and stay in low-memory
+ * mode for a while after the last time that happened */
+#define MEMORY_PRESSURE_THRESHOLD_USEC (150*USEC_PER_MSEC)
+#define MEMORY_PRESSURE_WINDOW_USEC (2*USEC_PER_SEC)
+#define LOW_MEMORY_USEC (30*USEC_PER_SEC)
+
 /* The period to insert between posting changes for coalescing */
 #define POST_CHANGE_TIMER_INTERVAL_USEC (250*USEC_PER_MSEC)
 
@@ -80,6 +88,15 @@
 
 #define IDLE_TIMEOUT_USEC (30*USEC_PER_SEC)
 
+/* The maximum number of datagrams to read from a socket per event loop iteration */
+#define DATAGRAM_BATCH_MAX 64U
+
+/* Entries are queued up and appended in batches, so that bringing the file online, reserving space and
+ * notifying readers is done once for many entries when we are busy. Don't let the queue grow beyond this, so
+ * that entries hit the disk in a timely fashion even if the event loop never gets idle. */
+#define WRITE_QUEUE_ENTRIES_MAX 256U
+#define WRITE_QUEUE_SIZE_MAX (4U*1024U*1024U)
+
 static int determine_path_usage(
                 Server *s,
                 const char *path,
@@ -638,8 +655,13 @@ void server_rotate(Server *s) {
 
 void server_sync(Server *s) {
         JournalFile *f;
+        usec_t start, d;
         int r;
 
+        start = now(CLOCK_MONOTONIC);
+
+        server_flush_write_queue(s);
+
         if (s->system_journal) {
                 r = journal_file_set_offline(s->system_journal, false);
                 if (r < 0)
@@ -659,6 +681,13 @@ void server_sync(Server *s) {
         }
 
         s->sync_scheduled = false;
+
+        /* The fsync() itself happens in the offline threads, this is the time the event loop spent on
+         * initiating it, joining previous ones and writing out what was queued */
+        d = usec_sub_unsigned(now(CLOCK_MONOTONIC), start);
+        s->n_syncs++;
+        s->sync_usec += d;
+        s->sync_usec_max = MAX(s->sync_usec_max, d);
 }
 
 static void do_vacuum(Server *s, JournalStorage *storage, bool verbose) {
@@ -789,78 +818,278 @@ static bool shall_try_append_again(JournalFile *f, int r) {
         }
 }
 
-static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n, int priority) {
-        bool vacuumed = false, rotate = false;
-        struct dual_timestamp ts;
-        JournalFile *f;
-        int r;
+struct QueuedEntry {
+        uid_t uid;
+        int priority;
+        dual_timestamp ts;
+        size_t n_iovec;
+        struct iovec iovec[];
+};
+
+static void server_account_write_latency(Server *s, usec_t latency) {
+        usec_t bound = 10;
+        size_t i;
 
         assert(s);
-        assert(iovec);
-        assert(n > 0);
 
-        /* Get the closest, linearized time we have for this log event from the event loop. (Note that we do not use
-         * the source time, and not even the time the event was originally seen, but instead simply the time we started
-         * processing it, as we want strictly linear ordering in what we write out.) */
-        assert_se(sd_event_now(s->event, CLOCK_REALTIME, &ts.realtime) >= 0);
-        assert_se(sd_event_now(s->event, CLOCK_MONOTONIC, &ts.monotonic) >= 0);
-
-        if (ts.realtime < s->last_realtime_clock) {
-                /* When the time jumps backwards, let's immediately rotate. Of course, this should not happen during
-                 * regular operation. However, when it does happen, then we should make sure that we start fresh files
-                 * to ensure that the entries in the journal files are strictly ordered by time, in order to ensure
-                 * bisection works correctly. */
-
-                log_debug("Time jumped backwards, rotating.");
-                rotate = true;
-        } else {
+        for (i = 0; i < WRITE_LATENCY_BUCKETS - 1; i++, bound *= 10)
+                if (latency <= bound)
+                        break;
 
-                f = find_journal(s, uid);
-                if (!f)
-                        return;
+        s->write_latency[i]++;
+}
+
+void server_account_message(Server *s, ServerTransport t, size_t size) {
+        assert(s);
+        assert(t >= 0 && t < _SERVER_TRANSPORT_MAX);
+
+        s->transport_statistics[t].n_messages++;
+        s->transport_statistics[t].n_bytes += size;
+}
 
-                if (journal_file_rotate_suggested(f, s->max_file_usec)) {
-                        log_debug("%s: Journal header limits reached or header out-of-date, rotating.", f->path);
+static void write_to_journal(Server *s, size_t n_entries) {
+        JournalFileEntry batch[WRITE_QUEUE_ENTRIES_MAX];
+        int sync_priority = INT_MAX;
+        bool vacuumed = false;
+        size_t i = 0;
+
+        assert(s);
+        assert(n_entries <= s->n_write_queue);
+
+        /* Writes out the first n_entries queued entries, in order. Consecutive entries for the same journal
+         * file are appended in one go. Note that rotating and vacuuming might generate driver messages, which
+         * are appended to the queue, hence always access it via the server object and never cache pointers
+         * into it. */
+
+        while (i < n_entries) {
+                QueuedEntry *e = s->write_queue[i];
+                bool rotate = false;
+                JournalFile *f = NULL;
+                size_t j, n = 0;
+                int r;
+
+                if (e->ts.realtime < s->last_realtime_clock) {
+                        /* When the time jumps backwards, let's immediately rotate. Of course, this should not
+                         * happen during regular operation. However, when it does happen, then we should make
+                         * sure that we start fresh files to ensure that the entries in the journal files are
+                         * strictly ordered by time, in order to ensure bisection works correctly. */
+
+                        log_debug("Time jumped backwards, rotating.");
                         rotate = true;
+                } else {
+
+                        f = find_journal(s, e->uid);
+                        if (!f) {
+                                i++;
+                                continue;
+                        }
+
+                        if (journal_file_rotate_suggested(f, s->max_file_usec)) {
+                                log_debug("%s: Journal header limits reached or header out-of-date, rotating.", f->path);
+                                rotate = true;
+                        }
+                }
+
+                if (rotate) {
+                        server_rotate(s);
+                        server_vacuum(s, false);
+                        vacuumed = true;
+
+                        f = find_journal(s, e->uid);
+                        if (!f) {
+                                i++;
+                                vacuumed = false;
+                                continue;
+                        }
+                }
+
+                /* Collect the entries following this one that go to the same file, as long as the time doesn't
+                 * jump backwards in between. */
+                for (j = i; j < n_entries && j - i < ELEMENTSOF(batch); j++) {
+                        QueuedEntry *q = s->write_queue[j];
+
+                        if (j > i && (q->uid != e->uid || q->ts.realtime < s->write_queue[j-1]->ts.realtime))
+                                break;
+
+                        batch[j - i] = (JournalFileEntry) {
+                                .ts = &q->ts,
+                                .iovec = q->iovec,
+                                .n_iovec = q->n_iovec,
+                        };
+                }
+
+                r = journal_file_append_entries(f, batch, j - i, &s->seqnum, &n);
+
+                if (n > 0) {
+                        usec_t t = now(CLOCK_MONOTONIC);
+
+                        /* Only entries that actually made it into the file advance the clock, the one that
+                         * failed (if any) is retried or dropped below. */
+                        s->last_realtime_clock = s->write_queue[i + n - 1]->ts.realtime;
+
+                        for (size_t k = i; k < i + n; k++) {
+                                sync_priority = MIN(sync_priority, s->write_queue[k]->priority);
+                                server_account_write_latency(s, usec_sub_unsigned(t, s->write_queue[k]->ts.monotonic));
+                        }
+
+                        i += n;
+                        vacuumed = false;
+                }
+
+                if (r >= 0)
+                        continue;
+
+                e = s->write_queue[i];
+
+                if (vacuumed || !shall_try_append_again(f, r)) {
+                        log_error_errno(r, "Failed to write entry (%zu items, %zu bytes)%s, ignoring: %m",
+                                        e->n_iovec, IOVEC_TOTAL_SIZE(e->iovec, e->n_iovec),
+                                        vacuumed ? " despite vacuuming" : "");
+                        s->n_write_failed++;
+                        i++;
+                        vacuumed = false;
+                        continue;
                 }
-        }
 
-        if (rotate) {
                 server_rotate(s);
                 server_vacuum(s, false);
                 vacuumed = true;
 
-                f = find_journal(s, uid);
-                if (!f)
-                        return;
+                log_debug("Retrying write.");
         }
 
-        s->last_realtime_clock = ts.realtime;
+        /* Schedule a single sync for everything we wrote, so that a burst of high-priority messages is
+         * committed to disk by one sync, instead of one for each of them. */
+        if (sync_priority != INT_MAX)
+                (void) server_schedule_sync(s, sync_priority);
+}
 
-        r = journal_file_append_entry(f, &ts, NULL, iovec, n, &s->seqnum, NULL, NULL);
-        if (r >= 0) {
-                server_schedule_sync(s, priority);
+void server_flush_write_queue(Server *s) {
+        int r;
+
+        assert(s);
+
+        /* If we are called from within the write path, for example because rotating flushed the runtime
+         * journal, then the queued entries are written once we get back there, in order. */
+        if (s->write_queue_flushing)
+                return;
+
+        s->write_queue_flushing = true;
+
+        while (s->n_write_queue > 0) {
+                size_t n = s->n_write_queue;
+
+                write_to_journal(s, n);
+
+                for (size_t i = 0; i < n; i++)
+                        free(s->write_queue[i]);
+
+                /* Move whatever got queued while we were writing to the front */
+                memmove(s->write_queue, s->write_queue + n, (s->n_write_queue - n) * sizeof(QueuedEntry*));
+                s->n_write_queue -= n;
+        }
+
+        s->write_queue_size = 0;
+        s->write_queue_flushing = false;
+
+        if (s->write_queue_event_source) {
+                r = sd_event_source_set_enabled(s->write_queue_event_source, SD_EVENT_OFF);
+                if (r < 0)
+                        log_error_errno(r, "Failed to disable write queue event source: %m");
+        }
+}
+
+static int server_dispatch_write_queue(sd_event_source *es, void *userdata) {
+        Server *s = userdata;
+
+        assert(s);
+
+        server_flush_write_queue(s);
+        return 0;
+}
+
+static int server_schedule_write_queue(Server *s) {
+        int r;
+
+        assert(s);
+
+        if (s->write_queue_event_source)
+                return sd_event_source_set_enabled(s->write_queue_event_source, SD_EVENT_ONESHOT);
+
+        r = sd_event_add_defer(s->event, &s->write_queue_event_source, server_dispatch_write_queue, s);
+        if (r < 0)
+                return r;
+
+        /* Below the priority of the log sources, so that everything that is pending gets queued up first, and is
+         * then written in one batch. */
+        r = sd_event_source_set_priority(s->write_queue_event_source, SD_EVENT_PRIORITY_NORMAL+10);
+        if (r < 0)
+                return r;
+
+        (void) sd_event_source_set_description(s->write_queue_event_source, "write-queue");
+
+        return sd_event_source_set_enabled(s->write_queue_event_source, SD_EVENT_ONESHOT);
+}
+
+static void server_queue_entry(Server *s, uid_t uid, const struct iovec *iovec, size_t n, int priority) {
+        QueuedEntry *e;
+        size_t sz;
+        char *p;
+        int r;
+
+        assert(s);
+        assert(iovec);
+        assert(n > 0);
+
+        sz = IOVEC_TOTAL_SIZE(iovec, n);
+
+        if (!GREEDY_REALLOC(s->write_queue, s->n_write_queue + 1)) {
+                log_oom();
                 return;
         }
 
-        if (vacuumed || !shall_try_append_again(f, r)) {
-                log_error_errno(r, "Failed to write entry (%zu items, %zu bytes), ignoring: %m", n, IOVEC_TOTAL_SIZE(iovec, n));
+        e = malloc(offsetof(QueuedEntry, iovec) + n * sizeof(struct iovec) + sz);
+        if (!e) {
+                log_oom();
                 return;
         }
 
-        server_rotate(s);
-        server_vacuum(s, false);
+        *e = (QueuedEntry) {
+                .uid = uid,
+                .priority = priority,
+                .n_iovec = n,
+        };
 
-        f = find_journal(s, uid);
-        if (!f)
+        /* Get the closest, linearized time we have for this log event from the event loop. (Note that we do not use
+         * the source time, and not even the time the event was originally seen, but instead simply the time we started
+         * processing it, as we want strictly linear ordering in what we write out.) The queue is written in order,
+         * hence taking the timestamp here rather than when writing preserves that. */
+        assert_se(sd_event_now(s->event, CLOCK_REALTIME, &e->ts.realtime) >= 0);
+        assert_se(sd_event_now(s->event, CLOCK_MONOTONIC, &e->ts.monotonic) >= 0);
+
+        /* The fields are usually allocated on the stack of the caller, hence copy them */
+        p = (char*) (e->iovec + n);
+        for (size_t i = 0; i < n; i++) {
+                e->iovec[i] = IOVEC_MAKE(p, iovec[i].iov_len);
+                p = mempcpy(p, iovec[i].iov_base, iovec[i].iov_len);
+        }
+
+        s->write_queue[s->n_write_queue++] = e;
+        s->write_queue_size += sz;
+
+        /* Don't let the queue grow without bounds if we are so busy that the event loop never gets to it */
+        if (s->n_write_queue >= WRITE_QUEUE_ENTRIES_MAX || s->write_queue_size >= WRITE_QUEUE_SIZE_MAX) {
+                server_flush_write_queue(s);
                 return;
+        }
 
-        log_debug("Retrying write.");
-        r = journal_file_append_entry(f, &ts, NULL, iovec, n, &s->seqnum, NULL, NULL);
-        if (r < 0)
-                log_error_errno(r, "Failed to write entry (%zu items, %zu bytes) despite vacuuming, ignoring: %m", n, IOVEC_TOTAL_SIZE(iovec, n));
-        else
-                server_schedule_sync(s, priority);
+        /* When the event loop is already finished, i.e. when we are shutting down, write immediately */
+        r = server_schedule_write_queue(s);
+        if (r < 0) {
+                if (r != -ESTALE)
+                        log_warning_errno(r, "Failed to schedule writing of queued entries, writing immediately: %m");
+                server_flush_write_queue(s);
+        }
 }
 
 #define IOVEC_ADD_NUMERIC_FIELD(iovec, n, value, type, isset, format, field)  \
@@ -897,15 +1126,15 @@ static void write_to_journal(Server *s, uid_t uid, struct iovec *iovec, size_t n
 static void dispatch_message_real(
                 Server *s,
                 struct iovec *iovec, size_t n, size_t m,
-                const ClientContext *c,
+                ClientContext *c,
                 const struct timeval *tv,
                 int priority,
                 pid_t object_pid) {
 
         char source_time[sizeof("_SOURCE_REALTIME_TIMESTAMP=") + DECIMAL_STR_MAX(usec_t)];
-        _cleanup_free_ char *cmdline1 = NULL, *cmdline2 = NULL;
+        _cleanup_free_ char *cmdline = NULL;
+        ClientContext *o = NULL;
         uid_t journal_uid;
-        ClientContext *o;
 
         assert(s);
         assert(iovec);
@@ -915,33 +1144,21 @@ static void dispatch_message_real(
                (pid_is_valid(object_pid) ? N_IOVEC_OBJECT_FIELDS : 0) +
                client_context_extra_fields_n_iovec(c) <= m);
 
-        if (c) {
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->pid, pid_t, pid_is_valid, PID_FMT, "_PID");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->uid, uid_t, uid_is_valid, UID_FMT, "_UID");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->gid, gid_t, gid_is_valid, GID_FMT, "_GID");
-
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->comm, "_COMM"); /* At most TASK_COMM_LENGTH (16 bytes) */
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->exe, "_EXE"); /* A path, so at most PATH_MAX (4096 bytes) */
+        /* Below we reference the fields of the contexts rather than copying them. Looking up the object's context
+         * might refresh or flush out cache entries though, hence do that first, and pin our own context while doing
+         * so. */
+        if (pid_is_valid(object_pid)) {
+                if (c)
+                        client_context_ref(s, c);
 
-                if (c->cmdline)
-                        /* At most _SC_ARG_MAX (2MB usually), which is too much to put on stack.
-                         * Let's use a heap allocation for this one. */
-                        cmdline1 = set_iovec_string_field(iovec, &n, "_CMDLINE=", c->cmdline);
-
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->capeff, "_CAP_EFFECTIVE"); /* Read from /proc/.../status */
-                IOVEC_ADD_SIZED_FIELD(iovec, n, c->label, c->label_size, "_SELINUX_CONTEXT");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->auditid, uint32_t, audit_session_is_valid, "%" PRIu32, "_AUDIT_SESSION");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->loginuid, uid_t, uid_is_valid, UID_FMT, "_AUDIT_LOGINUID");
-
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->cgroup, "_SYSTEMD_CGROUP"); /* A path */
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->session, "_SYSTEMD_SESSION");
-                IOVEC_ADD_NUMERIC_FIELD(iovec, n, c->owner_uid, uid_t, uid_is_valid, UID_FMT, "_SYSTEMD_OWNER_UID");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->unit, "_SYSTEMD_UNIT"); /* Unit names are bounded by UNIT_NAME_MAX */
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->user_unit, "_SYSTEMD_USER_UNIT");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->slice, "_SYSTEMD_SLICE");
-                IOVEC_ADD_STRING_FIELD(iovec, n, c->user_slice, "_SYSTEMD_USER_SLICE");
+                if (client_context_get(s, object_pid, NULL, NULL, 0, NULL, &o) < 0)
+                        o = NULL;
+        }
 
-                IOVEC_ADD_ID128_FIELD(iovec, n, c->invocation_id, "_SYSTEMD_INVOCATION_ID");
+        if (c) {
+                /* The trusted fields are formatted once by the context cache, just copy them in */
+                memcpy_safe(iovec + n, c->trusted_fields_iovec, c->trusted_fields_n_iovec * sizeof(struct iovec));
+                n += c->trusted_fields_n_iovec;
 
                 if (c->extra_fields_n_iovec > 0) {
                         memcpy(iovec + n, c->extra_fields_iovec, c->extra_fields_n_iovec * sizeof(struct iovec));
@@ -951,7 +1168,7 @@ static void dispatch_message_real(
 
         assert(n <= m);
 
-        if (pid_is_valid(object_pid) && client_context_get(s, object_pid, NULL, NULL, 0, NULL, &o) >= 0) {
+        if (o) {
 
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, o->pid, pid_t, pid_is_valid, PID_FMT, "OBJECT_PID");
                 IOVEC_ADD_NUMERIC_FIELD(iovec, n, o->uid, uid_t, uid_is_valid, UID_FMT, "OBJECT_UID");
@@ -961,7 +1178,7 @@ static void dispatch_message_real(
                 IOVEC_ADD_STRING_FIELD(iovec, n, o->comm, "OBJECT_COMM");
                 IOVEC_ADD_STRING_FIELD(iovec, n, o->exe, "OBJECT_EXE");
                 if (o->cmdline)
-                        cmdline2 = set_iovec_string_field(iovec, &n, "OBJECT_CMDLINE=", o->cmdline);
+                        cmdline = set_iovec_string_field(iovec, &n, "OBJECT_CMDLINE=", o->cmdline);
 
                 IOVEC_ADD_STRING_FIELD(iovec, n, o->capeff, "OBJECT_CAP_EFFECTIVE");
                 IOVEC_ADD_SIZED_FIELD(iovec, n, o->label, o->label_size, "OBJECT_SELINUX_CONTEXT");
@@ -1016,7 +1233,10 @@ static void dispatch_message_real(
         else
                 journal_uid = 0;
 
-        write_to_journal(s, journal_uid, iovec, n, priority);
+        server_queue_entry(s, journal_uid, iovec, n, priority);
+
+        if (pid_is_valid(object_pid))
+                client_context_release(s, c);
 }
 
 void server_driver_message(Server *s, pid_t object_pid, const char *message_id, const char *format, ...) {
@@ -1049,8 +1269,10 @@ void server_driver_message(Server *s, pid_t object_pid, const char *message_id,
         /* Error handling below */
         va_end(ap);
 
-        if (r >= 0)
+        if (r >= 0) {
+                server_account_message(s, SERVER_TRANSPORT_DRIVER, IOVEC_TOTAL_SIZE(iovec, n));
                 dispatch_message_real(s, iovec, n, m, s->my_context, NULL, LOG_INFO, object_pid);
+        }
 
         while (k < n)
                 free(iovec[k++].iov_base);
@@ -1094,19 +1316,40 @@ void server_dispatch_message(
                 return;
 
         if (c && c->unit) {
+                JournalRateLimitLevel levels[2];
+                size_t n_levels = 0;
+
+                levels[n_levels++] = (JournalRateLimitLevel) {
+                        .id = c->unit,
+                        .interval = c->log_ratelimit_interval,
+                        .burst = c->log_ratelimit_burst,
+                };
+
+                /* Units are additionally limited by a budget shared with all other units of their slice,
+                 * if so configured. */
+                if (c->slice && s->ratelimit_slice_burst > 0 && !streq(c->slice, c->unit))
+                        levels[n_levels++] = (JournalRateLimitLevel) {
+                                .id = c->slice,
+                                .interval = s->ratelimit_interval,
+                                .burst = s->ratelimit_slice_burst,
+                        };
+
                 (void) determine_space(s, &available, NULL);
 
-                rl = journal_ratelimit_test(s->ratelimit, c->unit, c->log_ratelimit_interval, c->log_ratelimit_burst, priority & LOG_PRIMASK, available);
-                if (rl == 0)
+                rl = journal_ratelimit_test(s->ratelimit, levels, n_levels, priority & LOG_PRIMASK, available);
+                if (rl == 0) {
+                        s->n_ratelimit_suppressed++;
                         return;
+                }
 
                 /* Write a suppression message if we suppressed something */
-                if (rl > 1)
-                        server_driver_message(s, c->pid,
-                                              "MESSAGE_ID=" SD_MESSAGE_JOURNAL_DROPPED_STR,
-                                              LOG_MESSAGE("Suppressed %i messages from %s", rl - 1, c->unit),
-                                              "N_DROPPED=%i", rl - 1,
-                                              NULL);
+                for (size_t i = 0; i < n_levels; i++)
+                        if (levels[i].suppressed > 0)
+                                server_driver_message(s, c->pid,
+                                                      "MESSAGE_ID=" SD_MESSAGE_JOURNAL_DROPPED_STR,
+                                                      LOG_MESSAGE("Suppressed %u messages from %s", levels[i].suppressed, levels[i].id),
+                                                      "N_DROPPED=%u", levels[i].suppressed,
+                                                      NULL);
         }
 
         dispatch_message_real(s, iovec, n, m, c, tv, priority, object_pid);
@@ -1134,6 +1377,9 @@ int server_flush_to_var(Server *s, bool require_flag_file) {
         if (require_flag_file && !flushed_flag_is_set(s))
                 return 0;
 
+        /* Write out what's queued first, so that it ends up in the runtime journal and is flushed along with it */
+        server_flush_write_queue(s);
+
         (void) system_journal_open(s, true, false);
 
         if (!s->system_journal)
@@ -1234,6 +1480,8 @@ static int server_relinquish_var(Server *s) {
 
         log_debug("Relinquishing %s...", s->system_storage.path);
 
+        server_flush_write_queue(s);
+
         (void) system_journal_open(s, false, true);
 
         s->system_journal = journal_file_close(s->system_journal);
@@ -1248,14 +1496,8 @@ static int server_relinquish_var(Server *s) {
         return 0;
 }
 
-int server_process_datagram(
-                sd_event_source *es,
-                int fd,
-                uint32_t revents,
-                void *userdata) {
-
+static int server_read_datagram(Server *s, int fd) {
         size_t label_len = 0, m;
-        Server *s = userdata;
         struct ucred *ucred = NULL;
         struct timeval *tv = NULL;
         struct cmsghdr *cmsg;
@@ -1288,11 +1530,6 @@ int server_process_datagram(
         assert(s);
         assert(fd == s->native_fd || fd == s->syslog_fd || fd == s->audit_fd);
 
-        if (revents != EPOLLIN)
-                return log_error_errno(SYNTHETIC_ERRNO(EIO),
-                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
-                                       revents);
-
         /* Try to get the right size, if we can. (Not all sockets support SIOCINQ, hence we just try, but don't rely on
          * it.) */
         (void) ioctl(fd, SIOCINQ, &v);
@@ -1312,7 +1549,7 @@ int server_process_datagram(
                 return 0;
         if (n == -EXFULL) {
                 log_warning("Got message with truncated control data (too many fds sent?), ignoring.");
-                return 0;
+                return 1;
         }
         if (n < 0)
                 return log_error_errno(n, "recvmsg() failed: %m");
@@ -1367,9 +1604,43 @@ int server_process_datagram(
         }
 
         close_many(fds, n_fds);
+        return 1;
+}
+
+int server_process_datagram(
+                sd_event_source *es,
+                int fd,
+                uint32_t revents,
+                void *userdata) {
+
+        Server *s = userdata;
+        unsigned n;
+        int r = 0;
+
+        assert(s);
+        assert(fd == s->native_fd || fd == s->syslog_fd || fd == s->audit_fd);
+
+        if (revents != EPOLLIN)
+                return log_error_errno(SYNTHETIC_ERRNO(EIO),
+                                       "Got invalid event from epoll for datagram fd: %" PRIx32,
+                                       revents);
+
+        /* Read a couple of datagrams per wakeup rather than going through the event loop for each of them, but
+         * not too many, so that the other sources get their turn. Note that we don't use recvmmsg() here: the
+         * buffer is sized for each datagram individually via SIOCINQ, which only tells us about the next one. */
+        for (n = 0; n < DATAGRAM_BATCH_MAX; n++) {
+                r = server_read_datagram(s, fd);
+                if (r <= 0)
+                        break;
+        }
+
+        if (n > 0) {
+                s->n_datagrams += n;
+                s->n_datagram_batches++;
+        }
 
         server_refresh_idle_timer(s);
-        return 0;
+        return r < 0 ? r : 0;
 }
 
 static void server_full_flush(Server *s) {
@@ -1406,6 +1677,8 @@ static void server_full_rotate(Server *s) {
 
         assert(s);
 
+        server_flush_write_queue(s);
+
         server_rotate(s);
         server_vacuum(s, true);
 
@@ -1713,6 +1986,104 @@ static int dispatch_hostname_change(sd_event_source *es, int fd, uint32_t revent
         return 0;
 }
 
+bool server_low_memory(Server *s) {
+        assert(s);
+
+        return s->low_memory_until > 0 && now(CLOCK_MONOTONIC) < s->low_memory_until;
+}
+
+void server_trim_memory(Server *s) {
+        assert(s);
+
+        /* Release whatever we only keep around to be faster, and can recreate later */
+
+        server_flush_write_queue(s);
+        client_context_trim(s);
+        mmap_cache_trim(s->mmap);
+
+        /* These are reallocated on the next read */
+        s->buffer = mfree(s->buffer);
+        s->stdout_streams_buffer = mfree(s->stdout_streams_buffer);
+        arena_done(&s->native_arena);
+}
+
+static int dispatch_memory_pressure(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
+        Server *s = userdata;
+
+        assert(s);
+
+        if (revents & EPOLLERR) {
+                log_debug("Memory pressure trigger of our cgroup went away, not watching it anymore.");
+                return sd_event_source_set_enabled(es, SD_EVENT_OFF);
+        }
+
+        if (!server_low_memory(s))
+                log_debug("Under memory pressure, trimming caches and entering low-memory mode.");
+
+        s->low_memory_until = usec_add(now(CLOCK_MONOTONIC), LOW_MEMORY_USEC);
+        server_trim_memory(s);
+
+        return 0;
+}
+
+static int server_open_memory_pressure(Server *s) {
+        _cleanup_free_ char *cgroup = NULL, *path = NULL;
+        _cleanup_close_ int fd = -1;
+        char trigger[STRLEN("some ") + DECIMAL_STR_MAX(usec_t) + 1 + DECIMAL_STR_MAX(usec_t) + 1];
+        int r;
+
+        assert(s);
+
+        /* Let's ask the kernel to tell us when our own cgroup is under memory pressure, so that we can
+         * shrink our caches. This is best-effort, we are fine without. */
+
+        r = cg_all_unified();
+        if (r < 0)
+                return log_debug_errno(r, "Failed to determine whether the unified cgroup hierarchy is used, not watching memory pressure: %m");
+        if (r == 0)
+                return log_debug_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "Not running with the unified cgroup hierarchy, not watching memory pressure.");
+
+        r = is_pressure_supported();
+        if (r < 0)
+                return log_debug_errno(r, "Failed to determine whether PSI is supported, not watching memory pressure: %m");
+        if (r == 0)
+                return log_debug_errno(SYNTHETIC_ERRNO(EOPNOTSUPP), "PSI is not supported, not watching memory pressure.");
+
+        r = cg_pid_get_path(SYSTEMD_CGROUP_CONTROLLER, 0, &cgroup);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to determine our own cgroup, not watching memory pressure: %m");
+
+        r = cg_get_path(SYSTEMD_CGROUP_CONTROLLER, cgroup, "memory.pressure", &path);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to determine memory pressure file of our cgroup: %m");
+
+        fd = open(path, O_RDWR|O_CLOEXEC|O_NONBLOCK|O_NOCTTY);
+        if (fd < 0)
+                return log_debug_errno(errno, "Failed to open %s, not watching memory pressure: %m", path);
+
+        xsprintf(trigger, "some " USEC_FMT " " USEC_FMT, MEMORY_PRESSURE_THRESHOLD_USEC, MEMORY_PRESSURE_WINDOW_USEC);
+        if (write(fd, trigger, strlen(trigger) + 1) < 0)
+                return log_debug_errno(errno, "Failed to set up memory pressure trigger in %s: %m", path);
+
+        r = sd_event_add_io(s->event, &s->memory_pressure_event_source, fd, EPOLLPRI, dispatch_memory_pressure, s);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to add memory pressure event source: %m");
+
+        r = sd_event_source_set_io_fd_own(s->memory_pressure_event_source, true);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to pass ownership of memory pressure fd to event source: %m");
+
+        TAKE_FD(fd);
+
+        r = sd_event_source_set_priority(s->memory_pressure_event_source, SD_EVENT_PRIORITY_IMPORTANT);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to adjust priority of memory pressure event source: %m");
+
+        (void) sd_event_source_set_description(s->memory_pressure_event_source, "memory-pressure");
+
+        return 0;
+}
+
 static int server_open_hostname(Server *s) {
         int r;
 
@@ -2008,6 +2379,104 @@ static int vl_method_relinquish_var(Varlink *link, JsonVariant *parameters, Varl
         return varlink_reply(link, NULL);
 }
 
+static void server_add_compress_statistics(JournalFile *f, uint64_t *bytes_in, uint64_t *bytes_out) {
+        assert(bytes_in);
+        assert(bytes_out);
+
+        if (!f)
+                return;
+
+        *bytes_in += f->compress_bytes_in;
+        *bytes_out += f->compress_bytes_out;
+}
+
+int server_build_statistics(Server *s, JsonVariant **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *transports = NULL, *latency = NULL;
+        uint64_t compress_in = 0, compress_out = 0;
+        MMapCacheStatistics mmap_stats;
+        usec_t bound = 10;
+        JournalFile *f;
+        int r;
+
+        assert(s);
+        assert(ret);
+
+        for (ServerTransport t = 0; t < _SERVER_TRANSPORT_MAX; t++) {
+                _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+
+                r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("messages", JSON_BUILD_UNSIGNED(s->transport_statistics[t].n_messages)),
+                                       JSON_BUILD_PAIR("bytes", JSON_BUILD_UNSIGNED(s->transport_statistics[t].n_bytes))));
+                if (r < 0)
+                        return r;
+
+                r = json_variant_set_field(&transports, server_transport_to_string(t), v);
+                if (r < 0)
+                        return r;
+        }
+
+        /* The last bucket has no upper bound */
+        for (size_t i = 0; i < WRITE_LATENCY_BUCKETS; i++, bound *= 10) {
+                _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+
+                r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR_CONDITION(i < WRITE_LATENCY_BUCKETS - 1, "maxUSec", JSON_BUILD_UNSIGNED(bound)),
+                                       JSON_BUILD_PAIR("count", JSON_BUILD_UNSIGNED(s->write_latency[i]))));
+                if (r < 0)
+                        return r;
+
+                r = json_variant_append_array(&latency, v);
+                if (r < 0)
+                        return r;
+        }
+
+        /* Compression is tracked by the journal files, hence this only covers the currently open ones */
+        server_add_compress_statistics(s->system_journal, &compress_in, &compress_out);
+        server_add_compress_statistics(s->runtime_journal, &compress_in, &compress_out);
+        ORDERED_HASHMAP_FOREACH(f, s->user_journals)
+                server_add_compress_statistics(f, &compress_in, &compress_out);
+
+        mmap_cache_get_statistics(s->mmap, &mmap_stats);
+
+        return json_build(ret,
+                          JSON_BUILD_OBJECT(
+                                  JSON_BUILD_PAIR("transports", JSON_BUILD_VARIANT(transports)),
+                                  JSON_BUILD_PAIR("rateLimitSuppressed", JSON_BUILD_UNSIGNED(s->n_ratelimit_suppressed)),
+                                  JSON_BUILD_PAIR("writeFailed", JSON_BUILD_UNSIGNED(s->n_write_failed)),
+                                  JSON_BUILD_PAIR("writeLatency", JSON_BUILD_VARIANT(latency)),
+                                  JSON_BUILD_PAIR("sync", JSON_BUILD_OBJECT(
+                                                          JSON_BUILD_PAIR("count", JSON_BUILD_UNSIGNED(s->n_syncs)),
+                                                          JSON_BUILD_PAIR("totalUSec", JSON_BUILD_UNSIGNED(s->sync_usec)),
+                                                          JSON_BUILD_PAIR("maxUSec", JSON_BUILD_UNSIGNED(s->sync_usec_max)))),
+                                  JSON_BUILD_PAIR("compression", JSON_BUILD_OBJECT(
+                                                          JSON_BUILD_PAIR("uncompressedBytes", JSON_BUILD_UNSIGNED(compress_in)),
+                                                          JSON_BUILD_PAIR("compressedBytes", JSON_BUILD_UNSIGNED(compress_out)))),
+                                  JSON_BUILD_PAIR("mmapCache", JSON_BUILD_OBJECT(
+                                                          JSON_BUILD_PAIR("contextCacheHits", JSON_BUILD_UNSIGNED(mmap_stats.n_context_cache_hit)),
+                                                          JSON_BUILD_PAIR("windowListHits", JSON_BUILD_UNSIGNED(mmap_stats.n_window_list_hit)),
+                                                          JSON_BUILD_PAIR("misses", JSON_BUILD_UNSIGNED(mmap_stats.n_missed)),
+                                                          JSON_BUILD_PAIR("windows", JSON_BUILD_UNSIGNED(mmap_stats.n_windows)),
+                                                          JSON_BUILD_PAIR("mappedBytes", JSON_BUILD_UNSIGNED(mmap_stats.n_mapped_bytes))))));
+}
+
+static int vl_method_get_statistics(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        Server *s = userdata;
+        int r;
+
+        assert(link);
+        assert(s);
+
+        if (json_variant_elements(parameters) > 0)
+                return varlink_error_invalid_parameter(link, parameters);
+
+        r = server_build_statistics(s, &v);
+        if (r < 0)
+                return r;
+
+        return varlink_reply(link, v);
+}
+
 static int vl_connect(VarlinkServer *server, Varlink *link, void *userdata) {
         Server *s = userdata;
 
@@ -2046,7 +2515,8 @@ static int server_open_varlink(Server *s, const char *socket, int fd) {
                         "io.systemd.Journal.Synchronize",   vl_method_synchronize,
                         "io.systemd.Journal.Rotate",        vl_method_rotate,
                         "io.systemd.Journal.FlushToVar",    vl_method_flush_to_var,
-                        "io.systemd.Journal.RelinquishVar", vl_method_relinquish_var);
+                        "io.systemd.Journal.RelinquishVar", vl_method_relinquish_var,
+                        "io.systemd.Journal.GetStatistics", vl_method_get_statistics);
         if (r < 0)
                 return r;
 
@@ -2092,6 +2562,10 @@ static bool server_is_idle(Server *s) {
         if (s->n_stdout_streams > 0)
                 return false;
 
+        /* Nor if there's something left to write */
+        if (s->n_write_queue > 0)
+                return false;
+
         return true;
 }
 
@@ -2385,6 +2859,8 @@ int server_init(Server *s, const char *namespace) {
         if (r < 0)
                 return r;
 
+        (void) server_open_memory_pressure(s);
+
         r = setup_signals(s);
         if (r < 0)
                 return r;
@@ -2458,6 +2934,22 @@ void server_done(Server *s) {
 
         client_context_flush_all(s);
 
+        if (s->n_datagram_batches > 0)
+                log_debug("Received %" PRIu64 " datagrams in %" PRIu64 " batches (%" PRIu64 " per batch on average).",
+                          s->n_datagrams, s->n_datagram_batches, s->n_datagrams / s->n_datagram_batches);
+
+        if (s->n_syncs > 0) {
+                char avg[FORMAT_TIMESPAN_MAX], max[FORMAT_TIMESPAN_MAX];
+
+                log_debug("Synced journals %" PRIu64 " times, taking %s on average and %s at most.",
+                          s->n_syncs,
+                          format_timespan(avg, sizeof(avg), s->sync_usec / s->n_syncs, 0),
+                          format_timespan(max, sizeof(max), s->sync_usec_max, 0));
+        }
+
+        if (s->event)
+                server_flush_write_queue(s);
+
         (void) journal_file_close(s->system_journal);
         (void) journal_file_close(s->runtime_journal);
 
@@ -2471,15 +2963,18 @@ void server_done(Server *s) {
         sd_event_source_unref(s->dev_kmsg_event_source);
         sd_event_source_unref(s->audit_event_source);
         sd_event_source_unref(s->sync_event_source);
+        sd_event_source_unref(s->write_queue_event_source);
         sd_event_source_unref(s->sigusr1_event_source);
         sd_event_source_unref(s->sigusr2_event_source);
         sd_event_source_unref(s->sigterm_event_source);
         sd_event_source_unref(s->sigint_event_source);
         sd_event_source_unref(s->sigrtmin1_event_source);
         sd_event_source_unref(s->hostname_event_source);
+        sd_event_source_unref(s->memory_pressure_event_source);
         sd_event_source_unref(s->notify_event_source);
         sd_event_source_unref(s->watchdog_event_source);
         sd_event_source_unref(s->idle_event_source);
+        sd_event_source_unref(s->client_contexts_refresh_event_source);
         sd_event_unref(s->event);
 
         safe_close(s->syslog_fd);
@@ -2496,10 +2991,18 @@ void server_done(Server *s) {
         if (s->kernel_seqnum)
                 munmap(s->kernel_seqnum, sizeof(uint64_t));
 
+        for (size_t i = 0; i < s->n_write_queue; i++)
+                free(s->write_queue[i]);
+        free(s->write_queue);
+
         free(s->buffer);
+        free(s->stdout_streams_buffer);
+        arena_done(&s->native_arena);
         free(s->tty_path);
         free(s->cgroup_root);
         free(s->hostname_field);
+        free(s->kmsg_device_id);
+        strv_free(s->kmsg_device_fields);
         free(s->runtime_storage.path);
         free(s->system_storage.path);
         free(s->runtime_directory);
@@ -2524,6 +3027,17 @@ static const char* const split_mode_table[_SPLIT_MAX] = {
 };
 
 DEFINE_STRING_TABLE_LOOKUP(split_mode, SplitMode);
+
+static const char* const server_transport_table[_SERVER_TRANSPORT_MAX] = {
+        [SERVER_TRANSPORT_JOURNAL] = "journal",
+        [SERVER_TRANSPORT_SYSLOG]  = "syslog",
+        [SERVER_TRANSPORT_STDOUT]  = "stdout",
+        [SERVER_TRANSPORT_KERNEL]  = "kernel",
+        [SERVER_TRANSPORT_AUDIT]   = "audit",
+        [SERVER_TRANSPORT_DRIVER]  = "driver",
+};
+
+DEFINE_STRING_TABLE_LOOKUP_TO_STRING(server_transport, ServerTransport);
 DEFINE_CONFIG_PARSE_ENUM(config_parse_split_mode, split_mode, SplitMode, "Failed to parse split mode setting");
 
 int config_parse_line_max(
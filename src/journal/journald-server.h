@@ -7,7 +7,9 @@
 #include "sd-event.h"
 
 typedef struct Server Server;
+typedef struct QueuedEntry QueuedEntry;
 
+#include "arena.h"
 #include "conf-parser.h"
 #include "hashmap.h"
 #include "journal-file.h"
@@ -36,6 +38,27 @@ typedef enum SplitMode {
         _SPLIT_INVALID = -EINVAL,
 } SplitMode;
 
+/* Where messages come from, named after the _TRANSPORT= field values */
+typedef enum ServerTransport {
+        SERVER_TRANSPORT_JOURNAL,
+        SERVER_TRANSPORT_SYSLOG,
+        SERVER_TRANSPORT_STDOUT,
+        SERVER_TRANSPORT_KERNEL,
+        SERVER_TRANSPORT_AUDIT,
+        SERVER_TRANSPORT_DRIVER,
+        _SERVER_TRANSPORT_MAX,
+        _SERVER_TRANSPORT_INVALID = -EINVAL,
+} ServerTransport;
+
+typedef struct ServerTransportStatistics {
+        uint64_t n_messages;
+        uint64_t n_bytes;
+} ServerTransportStatistics;
+
+/* Number of buckets of the histogram of the time from receiving to writing a message: up to 10µs, 100µs, …,
+ * 1s, and longer */
+#define WRITE_LATENCY_BUCKETS 7
+
 typedef struct JournalCompressOptions {
         bool enabled;
         uint64_t threshold_bytes;
@@ -78,12 +101,14 @@ struct Server {
         sd_event_source *dev_kmsg_event_source;
         sd_event_source *audit_event_source;
         sd_event_source *sync_event_source;
+        sd_event_source *write_queue_event_source;
         sd_event_source *sigusr1_event_source;
         sd_event_source *sigusr2_event_source;
         sd_event_source *sigterm_event_source;
         sd_event_source *sigint_event_source;
         sd_event_source *sigrtmin1_event_source;
         sd_event_source *hostname_event_source;
+        sd_event_source *memory_pressure_event_source;
         sd_event_source *notify_event_source;
         sd_event_source *watchdog_event_source;
         sd_event_source *idle_event_source;
@@ -94,12 +119,33 @@ struct Server {
 
         uint64_t seqnum;
 
+        /* Entries waiting to be written, in order */
+        QueuedEntry **write_queue;
+        size_t n_write_queue;
+        size_t write_queue_size;
+
         char *buffer;
 
+        /* Statistics on how many datagrams we get to read per wakeup */
+        uint64_t n_datagrams;
+        uint64_t n_datagram_batches;
+
+        /* Statistics on how long syncing the journal files blocks the event loop */
+        uint64_t n_syncs;
+        usec_t sync_usec;
+        usec_t sync_usec_max;
+
+        /* Statistics exposed via the GetStatistics() varlink method */
+        ServerTransportStatistics transport_statistics[_SERVER_TRANSPORT_MAX];
+        uint64_t write_latency[WRITE_LATENCY_BUCKETS];
+        uint64_t n_ratelimit_suppressed;
+        uint64_t n_write_failed;
+
         JournalRateLimit *ratelimit;
         usec_t sync_interval_usec;
         usec_t ratelimit_interval;
         unsigned ratelimit_burst;
+        unsigned ratelimit_slice_burst;
 
         JournalStorage runtime_storage;
         JournalStorage system_storage;
@@ -124,6 +170,13 @@ struct Server {
         LIST_HEAD(StdoutStream, stdout_streams);
         LIST_HEAD(StdoutStream, stdout_streams_notify_queue);
         unsigned n_stdout_streams;
+        char *stdout_streams_buffer;
+
+        /* Holds the fields of the native protocol entry being processed, reset after each entry */
+        Arena native_arena;
+
+        /* While set and in the future, keep our caches small, because we recently saw memory pressure */
+        usec_t low_memory_until;
 
         char *tty_path;
 
@@ -143,9 +196,15 @@ struct Server {
         uint64_t *kernel_seqnum;
         bool dev_kmsg_readable:1;
 
+        /* The _UDEV_* fields of the device the last kernel message was about, see dev_kmsg_record() */
+        char *kmsg_device_id;
+        char **kmsg_device_fields;
+        usec_t kmsg_device_timestamp;
+
         bool send_watchdog:1;
         bool sent_notify_ready:1;
         bool sync_scheduled:1;
+        bool write_queue_flushing:1;
 
         char machine_id_field[sizeof("_MACHINE_ID=") + 32];
         char boot_id_field[sizeof("_BOOT_ID=") + 32];
@@ -166,6 +225,10 @@ struct Server {
         Hashmap *client_contexts;
         Prioq *client_contexts_lru;
 
+        /* Contexts whose cached data is due to be refreshed */
+        LIST_HEAD(ClientContext, client_contexts_refresh_queue);
+        sd_event_source *client_contexts_refresh_event_source;
+
         usec_t last_cache_pid_flush;
 
         ClientContext *my_context; /* the context of journald itself */
@@ -209,9 +272,12 @@ CONFIG_PARSER_PROTOTYPE(config_parse_split_mode);
 const char *split_mode_to_string(SplitMode s) _const_;
 SplitMode split_mode_from_string(const char *s) _pure_;
 
+const char *server_transport_to_string(ServerTransport t) _const_;
+
 int server_init(Server *s, const char *namespace);
 void server_done(Server *s);
 void server_sync(Server *s);
+void server_flush_write_queue(Server *s);
 int server_vacuum(Server *s, bool verbose);
 void server_rotate(Server *s);
 int server_schedule_sync(Server *s, int priority);
@@ -219,6 +285,10 @@ int server_flush_to_var(Server *s, bool require_flag_file);
 void server_maybe_append_tags(Server *s);
 int server_process_datagram(sd_event_source *es, int fd, uint32_t revents, void *userdata);
 void server_space_usage_message(Server *s, JournalStorage *storage);
+void server_account_message(Server *s, ServerTransport t, size_t size);
+int server_build_statistics(Server *s, JsonVariant **ret);
+bool server_low_memory(Server *s);
+void server_trim_memory(Server *s);
 
 int server_start_or_stop_idle_timer(Server *s);
 int server_refresh_idle_timer(Server *s);
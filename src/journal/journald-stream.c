@@ -39,6 +39,9 @@
 
 #define STDOUT_STREAMS_MAX 4096
 
+/* How many times to read from a single stream per wakeup at most, as long as there's more data queued */
+#define STDOUT_STREAM_READ_BATCH_MAX 8U
+
 /* During the "setup" protocol phase of the stream logic let's define a different maximum line length than
  * during the actual operational phase. We want to allow users to specify very short line lengths after all,
  * but the unit name we embed in the setup protocol might be longer than that. Hence, during the setup phase
@@ -464,6 +467,9 @@ static int stdout_stream_found(
         assert(s);
         assert(p);
 
+        if (s->state == STDOUT_STREAM_RUNNING)
+                server_account_message(s->server, SERVER_TRANSPORT_STDOUT, l);
+
         /* Let's NUL terminate the specified buffer for this call, and revert back afterwards */
         saved = p[l];
         p[l] = 0;
@@ -500,25 +506,22 @@ static int stdout_stream_scan(
 
         line_max = stdout_stream_line_max(s);
 
+        /* Terminate the data, so that we can look for the next \n and NUL in a single pass with
+         * strchrnul(), instead of scanning each line twice. There's always room for this extra byte, see
+         * stdout_stream_read(). */
+        p[remaining] = 0;
+
         for (;;) {
                 LineBreak line_break;
                 size_t skip, found;
-                char *end1, *end2;
                 size_t tmp_remaining = MIN(remaining, line_max);
 
-                end1 = memchr(p, '\n', tmp_remaining);
-                end2 = memchr(p, 0, end1 ? (size_t) (end1 - p) : tmp_remaining);
+                found = strchrnul(p, '\n') - p;
 
-                if (end2) {
-                        /* We found a NUL terminator */
-                        found = end2 - p;
+                if (found < tmp_remaining) {
+                        /* We found a \n or NUL terminator */
                         skip = found + 1;
-                        line_break = LINE_BREAK_NUL;
-                } else if (end1) {
-                        /* We found a \n terminator */
-                        found = end1 - p;
-                        skip = found + 1;
-                        line_break = LINE_BREAK_NEWLINE;
+                        line_break = p[found] == '\n' ? LINE_BREAK_NEWLINE : LINE_BREAK_NUL;
                 } else if (remaining >= line_max) {
                         /* Force a line break after the maximum line length */
                         found = skip = line_max;
@@ -549,14 +552,13 @@ static int stdout_stream_scan(
         return 0;
 }
 
-static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
+static int stdout_stream_read(StdoutStream *s) {
         CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(struct ucred))) control;
-        size_t limit, consumed, allocated;
-        StdoutStream *s = userdata;
+        size_t limit, consumed, n;
         struct ucred *ucred;
         struct iovec iovec;
+        char *buffer, *p;
         ssize_t l;
-        char *p;
         int r;
 
         struct msghdr msghdr = {
@@ -568,27 +570,22 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
 
         assert(s);
 
-        if ((revents|EPOLLIN|EPOLLHUP) != (EPOLLIN|EPOLLHUP)) {
-                log_error("Got invalid event from epoll for stdout stream: %"PRIx32, revents);
-                goto terminate;
-        }
-
-        /* If the buffer is almost full, add room for another 1K */
-        allocated = MALLOC_ELEMENTSOF(s->buffer);
-        if (s->length + 512 >= allocated) {
-                if (!GREEDY_REALLOC(s->buffer, s->length + 1 + 1024)) {
-                        log_oom();
-                        goto terminate;
-                }
-
-                allocated = MALLOC_ELEMENTSOF(s->buffer);
-        }
-
-        /* Try to make use of the allocated buffer in full, but never read more than the configured line size. Also,
-         * always leave room for a terminating NUL we might need to add. */
-        limit = MIN(allocated - 1, MAX(s->server->line_max, STDOUT_STREAM_SETUP_PROTOCOL_LINE_MAX));
+        /* Reads once from the stream and processes all complete lines. Returns > 0 if the read filled the buffer
+         * and there might hence be more data queued, 0 if not, and -EPIPE if the stream shall be terminated.
+         *
+         * We read into a buffer shared by all streams, which is large enough for a full line. Only the
+         * incomplete line left at the end (if any) is kept in the per-stream buffer until more data arrives,
+         * hence idle streams don't pin a buffer of their own, and per-stream memory is bounded by the
+         * maximum line length. Never read more than the configured line size, and always leave room for a
+         * terminating NUL we need to add. */
+        limit = MAX(s->server->line_max, STDOUT_STREAM_SETUP_PROTOCOL_LINE_MAX);
+        if (!GREEDY_REALLOC(s->server->stdout_streams_buffer, limit + 1))
+                return log_oom(), -EPIPE;
+
+        buffer = s->server->stdout_streams_buffer;
         assert(s->length <= limit);
-        iovec = IOVEC_MAKE(s->buffer + s->length, limit - s->length);
+        memcpy_safe(buffer, s->buffer, s->length);
+        iovec = IOVEC_MAKE(buffer + s->length, limit - s->length);
 
         l = recvmsg(s->fd, &msghdr, MSG_DONTWAIT|MSG_CMSG_CLOEXEC);
         if (l < 0) {
@@ -596,13 +593,14 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
                         return 0;
 
                 log_warning_errno(errno, "Failed to read from stream: %m");
-                goto terminate;
+                return -EPIPE;
         }
         cmsg_close_all(&msghdr);
 
-        if (l == 0) {
-                (void) stdout_stream_scan(s, s->buffer, s->length, /* force_flush = */ LINE_BREAK_EOF, NULL);
-                goto terminate;
+        n = l;
+        if (n == 0) {
+                (void) stdout_stream_scan(s, buffer, s->length, /* force_flush = */ LINE_BREAK_EOF, NULL);
+                return -EPIPE;
         }
 
         /* Invalidate the context if the PID of the sender changed. This happens when a forked process
@@ -610,17 +608,22 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
          * which can be invalid if the parent has exited in the meantime. */
         ucred = CMSG_FIND_DATA(&msghdr, SOL_SOCKET, SCM_CREDENTIALS, struct ucred);
         if (ucred && ucred->pid != s->ucred.pid) {
+                char saved;
+
                 /* Force out any previously half-written lines from a different process, before we switch to
-                 * the new ucred structure for everything we just added */
-                r = stdout_stream_scan(s, s->buffer, s->length, /* force_flush = */ LINE_BREAK_PID_CHANGE, NULL);
+                 * the new ucred structure for everything we just added. Scanning terminates the old data
+                 * in place, so save the first byte of the new data. */
+                saved = buffer[s->length];
+                r = stdout_stream_scan(s, buffer, s->length, /* force_flush = */ LINE_BREAK_PID_CHANGE, NULL);
                 if (r < 0)
-                        goto terminate;
+                        return -EPIPE;
+                buffer[s->length] = saved;
 
                 s->context = client_context_release(s->server, s->context);
 
-                p = s->buffer + s->length;
+                p = buffer + s->length;
         } else {
-                p = s->buffer;
+                p = buffer;
                 l += s->length;
         }
 
@@ -630,12 +633,45 @@ static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents,
 
         r = stdout_stream_scan(s, p, l, _LINE_BREAK_INVALID, &consumed);
         if (r < 0)
-                goto terminate;
+                return -EPIPE;
 
-        /* Move what wasn't consumed to the front of the buffer */
+        /* Keep what wasn't consumed for the next read */
         assert(consumed <= (size_t) l);
         s->length = l - consumed;
-        memmove(s->buffer, p + consumed, s->length);
+        if (s->length == 0)
+                s->buffer = mfree(s->buffer);
+        else {
+                if (!GREEDY_REALLOC(s->buffer, s->length)) {
+                        log_oom();
+                        return -EPIPE;
+                }
+
+                memcpy(s->buffer, p + consumed, s->length);
+        }
+
+        return n == iovec.iov_len;
+}
+
+static int stdout_stream_process(sd_event_source *es, int fd, uint32_t revents, void *userdata) {
+        StdoutStream *s = userdata;
+        int r;
+
+        assert(s);
+
+        if ((revents|EPOLLIN|EPOLLHUP) != (EPOLLIN|EPOLLHUP)) {
+                log_error("Got invalid event from epoll for stdout stream: %"PRIx32, revents);
+                goto terminate;
+        }
+
+        /* A chatty stream might have more queued than fits into one read. Keep reading as long as the reads
+         * fill the buffer, but a bounded number of times only, so that other streams get their turn. */
+        for (unsigned i = 0; i < STDOUT_STREAM_READ_BATCH_MAX; i++) {
+                r = stdout_stream_read(s);
+                if (r < 0)
+                        goto terminate;
+                if (r == 0)
+                        break;
+        }
 
         return 1;
 
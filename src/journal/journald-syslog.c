@@ -332,6 +332,8 @@ void server_process_syslog_message(
          * without the terminating NUL byte, the buffer is actually one bigger. */
         assert(buf[raw_len] == '\0');
 
+        server_account_message(s, SERVER_TRANSPORT_SYSLOG, raw_len);
+
         if (ucred && pid_is_valid(ucred->pid)) {
                 r = client_context_get(s, ucred->pid, ucred, label, label_len, NULL, &context);
                 if (r < 0)
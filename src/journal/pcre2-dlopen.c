@@ -11,6 +11,7 @@ pcre2_match_data* (*sym_pcre2_match_data_create)(uint32_t, pcre2_general_context
 void (*sym_pcre2_match_data_free)(pcre2_match_data *);
 void (*sym_pcre2_code_free)(pcre2_code *);
 pcre2_code* (*sym_pcre2_compile)(PCRE2_SPTR, PCRE2_SIZE, uint32_t, int *, PCRE2_SIZE *, pcre2_compile_context *);
+int (*sym_pcre2_jit_compile)(pcre2_code *, uint32_t);
 int (*sym_pcre2_get_error_message)(int, PCRE2_UCHAR *, PCRE2_SIZE);
 int (*sym_pcre2_match)(const pcre2_code *, PCRE2_SPTR, PCRE2_SIZE, PCRE2_SIZE, uint32_t, pcre2_match_data *, pcre2_match_context *);
 PCRE2_SIZE* (*sym_pcre2_get_ovector_pointer)(pcre2_match_data *);
@@ -30,6 +31,7 @@ int dlopen_pcre2(void) {
                         DLSYM_ARG(pcre2_match_data_free),
                         DLSYM_ARG(pcre2_code_free),
                         DLSYM_ARG(pcre2_compile),
+                        DLSYM_ARG(pcre2_jit_compile),
                         DLSYM_ARG(pcre2_get_error_message),
                         DLSYM_ARG(pcre2_match),
                         DLSYM_ARG(pcre2_get_ovector_pointer));
@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <syslog.h>
+
+#include "journald-rate-limit.h"
+#include "tests.h"
+
+#define BASE (100 * USEC_PER_SEC)
+
+static unsigned count_permitted(JournalRateLimit *r, JournalRateLimitLevel *levels, size_t n_levels,
+                                int priority, uint64_t available, usec_t ts, unsigned n) {
+        unsigned permitted = 0;
+
+        for (unsigned i = 0; i < n; i++) {
+                int k;
+
+                k = journal_ratelimit_test_at(r, levels, n_levels, priority, available, ts);
+                assert_se(k >= 0);
+                permitted += k;
+        }
+
+        return permitted;
+}
+
+static void test_burst_and_refill(void) {
+        JournalRateLimit *r;
+        JournalRateLimitLevel level = {
+                .id = "foo.service",
+                .interval = 10 * USEC_PER_SEC,
+                .burst = 10,
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(r = journal_ratelimit_new());
+
+        /* The bucket starts out full and holds exactly one burst */
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE, 15) == 10);
+
+        /* It refills continuously, one message per interval/burst */
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE + USEC_PER_SEC, 5) == 1);
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE + 3 * USEC_PER_SEC, 5) == 2);
+
+        /* … but never beyond one burst, however long it was idle */
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE + 1000 * USEC_PER_SEC, 25) == 10);
+
+        /* A level without interval or burst is not limited */
+        level.burst = 0;
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE + 1000 * USEC_PER_SEC, 25) == 25);
+
+        journal_ratelimit_free(r);
+}
+
+static void test_suppressed(void) {
+        JournalRateLimit *r;
+        JournalRateLimitLevel level = {
+                .id = "foo.service",
+                .interval = 10 * USEC_PER_SEC,
+                .burst = 2,
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(r = journal_ratelimit_new());
+
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE, 5) == 2);
+
+        /* The next permitted message reports what was dropped, and only that one */
+        assert_se(journal_ratelimit_test_at(r, &level, 1, LOG_INFO, 0, BASE + 5 * USEC_PER_SEC) == 1);
+        assert_se(level.suppressed == 3);
+
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE + 5 * USEC_PER_SEC, 3) == 0);
+        assert_se(journal_ratelimit_test_at(r, &level, 1, LOG_INFO, 0, BASE + 10 * USEC_PER_SEC) == 1);
+        assert_se(level.suppressed == 0);
+
+        /* Reports are sent at most once per interval */
+        assert_se(journal_ratelimit_test_at(r, &level, 1, LOG_INFO, 0, BASE + 15 * USEC_PER_SEC) == 1);
+        assert_se(level.suppressed == 3);
+
+        journal_ratelimit_free(r);
+}
+
+static void test_priorities(void) {
+        JournalRateLimit *r;
+        JournalRateLimitLevel level = {
+                .id = "foo.service",
+                .interval = 10 * USEC_PER_SEC,
+                .burst = 10,
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(r = journal_ratelimit_new());
+
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, 0, BASE, 10) == 10);
+
+        /* LOG_NOTICE shares its budget with LOG_INFO, the others each have their own */
+        assert_se(count_permitted(r, &level, 1, LOG_NOTICE, 0, BASE, 5) == 0);
+        assert_se(count_permitted(r, &level, 1, LOG_DEBUG, 0, BASE, 15) == 10);
+        assert_se(count_permitted(r, &level, 1, LOG_WARNING, 0, BASE, 15) == 10);
+        assert_se(count_permitted(r, &level, 1, LOG_ERR, 0, BASE, 15) == 10);
+
+        /* LOG_EMERG, LOG_ALERT and LOG_CRIT share one */
+        assert_se(count_permitted(r, &level, 1, LOG_EMERG, 0, BASE, 5) == 5);
+        assert_se(count_permitted(r, &level, 1, LOG_CRIT, 0, BASE, 10) == 5);
+
+        journal_ratelimit_free(r);
+}
+
+static void test_available_space(void) {
+        JournalRateLimit *r;
+        JournalRateLimitLevel level = {
+                .interval = 10 * USEC_PER_SEC,
+                .burst = 10,
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(r = journal_ratelimit_new());
+
+        /* The burst is scaled with the available disk space: 1 MB and less → 1×, 16 MB → 2×, 4 GB → 4× */
+        level.id = "a.service";
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, UINT64_C(1) << 20, BASE, 50) == 10);
+        level.id = "b.service";
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, UINT64_C(1) << 24, BASE, 50) == 20);
+        level.id = "c.service";
+        assert_se(count_permitted(r, &level, 1, LOG_INFO, UINT64_C(1) << 32, BASE, 50) == 40);
+
+        journal_ratelimit_free(r);
+}
+
+static void test_levels(void) {
+        JournalRateLimit *r;
+        JournalRateLimitLevel levels[2] = {
+                {
+                        .id = "foo.service",
+                        .interval = 10 * USEC_PER_SEC,
+                        .burst = 5,
+                },
+                {
+                        .id = "system.slice",
+                        .interval = 10 * USEC_PER_SEC,
+                        .burst = 8,
+                },
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(r = journal_ratelimit_new());
+
+        /* Messages refused by the unit are not charged to the slice */
+        assert_se(count_permitted(r, levels, 2, LOG_INFO, 0, BASE, 10) == 5);
+
+        /* The slice has 3 left, then it refuses messages of other units, too */
+        levels[0].id = "bar.service";
+        assert_se(count_permitted(r, levels, 2, LOG_INFO, 0, BASE, 10) == 3);
+
+        journal_ratelimit_free(r);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_burst_and_refill();
+        test_suppressed();
+        test_priorities();
+        test_available_space();
+        test_levels();
+
+        return 0;
+}
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "journald-server.h"
+#include "tests.h"
+
+static uint64_t statistic(JsonVariant *v, const char *object, const char *key) {
+        JsonVariant *w;
+
+        w = json_variant_by_key(v, object);
+        assert_se(w);
+        w = json_variant_by_key(w, key);
+        assert_se(w);
+        assert_se(json_variant_is_unsigned(w));
+
+        return json_variant_unsigned(w);
+}
+
+static void test_build_statistics(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        JsonVariant *latency, *w;
+        Server s = {
+                .n_ratelimit_suppressed = 3,
+                .n_write_failed = 1,
+                .n_syncs = 2,
+                .sync_usec = 50,
+                .sync_usec_max = 40,
+        };
+
+        log_info("/* %s */", __func__);
+
+        assert_se(s.mmap = mmap_cache_new());
+
+        server_account_message(&s, SERVER_TRANSPORT_SYSLOG, 10);
+        server_account_message(&s, SERVER_TRANSPORT_SYSLOG, 32);
+        server_account_message(&s, SERVER_TRANSPORT_KERNEL, 7);
+        s.write_latency[0] = 5;
+        s.write_latency[WRITE_LATENCY_BUCKETS - 1] = 1;
+
+        /* This is what GetStatistics() replies with */
+        assert_se(server_build_statistics(&s, &v) >= 0);
+        json_variant_dump(v, JSON_FORMAT_PRETTY_AUTO|JSON_FORMAT_COLOR_AUTO, NULL, NULL);
+
+        w = json_variant_by_key(v, "transports");
+        assert_se(w);
+        assert_se(json_variant_elements(w) == _SERVER_TRANSPORT_MAX * 2);
+        assert_se(statistic(w, "syslog", "messages") == 2);
+        assert_se(statistic(w, "syslog", "bytes") == 42);
+        assert_se(statistic(w, "kernel", "messages") == 1);
+        assert_se(statistic(w, "journal", "messages") == 0);
+
+        assert_se(json_variant_unsigned(json_variant_by_key(v, "rateLimitSuppressed")) == 3);
+        assert_se(json_variant_unsigned(json_variant_by_key(v, "writeFailed")) == 1);
+        assert_se(statistic(v, "sync", "count") == 2);
+        assert_se(statistic(v, "sync", "totalUSec") == 50);
+        assert_se(statistic(v, "sync", "maxUSec") == 40);
+
+        /* No journal file is open, hence nothing was compressed */
+        assert_se(statistic(v, "compression", "uncompressedBytes") == 0);
+        assert_se(statistic(v, "compression", "compressedBytes") == 0);
+        assert_se(statistic(v, "mmapCache", "windows") == 0);
+
+        /* Every bucket but the last one has an upper bound */
+        latency = json_variant_by_key(v, "writeLatency");
+        assert_se(latency);
+        assert_se(json_variant_is_array(latency));
+        assert_se(json_variant_elements(latency) == WRITE_LATENCY_BUCKETS);
+        w = json_variant_by_index(latency, 0);
+        assert_se(json_variant_unsigned(json_variant_by_key(w, "maxUSec")) == 10);
+        assert_se(json_variant_unsigned(json_variant_by_key(w, "count")) == 5);
+        w = json_variant_by_index(latency, WRITE_LATENCY_BUCKETS - 1);
+        assert_se(!json_variant_by_key(w, "maxUSec"));
+        assert_se(json_variant_unsigned(json_variant_by_key(w, "count")) == 1);
+
+        mmap_cache_unref(s.mmap);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_build_statistics();
+
+        return 0;
+}
@@ -69,6 +69,7 @@ struct sd_dhcp_server {
 
         Hashmap *leases_by_client_id;
         Hashmap *static_leases_by_client_id;
+        Hashmap *static_leases_by_address; /* be32 address → DHCPLease, does not own the leases */
         DHCPLease **bound_leases;
         DHCPLease invalid_lease;
 
@@ -163,6 +163,7 @@ static sd_dhcp_server *dhcp_server_free(sd_dhcp_server *server) {
 
         hashmap_free(server->leases_by_client_id);
         hashmap_free(server->static_leases_by_client_id);
+        hashmap_free(server->static_leases_by_address);
 
         ordered_set_free(server->extra_options);
         ordered_set_free(server->vendor_options);
@@ -840,15 +841,11 @@ static int prepare_new_lease(
 }
 
 static bool static_leases_have_address(sd_dhcp_server *server, be32_t address) {
-        DHCPLease *s;
-
         assert(server);
 
-        HASHMAP_FOREACH(s, server->static_leases_by_client_id)
-                if (s->address == address)
-                        return true;
-
-        return false;
+        /* Called for every candidate address when looking for a free one on DISCOVER, hence use the
+         * index by address rather than iterating through all static leases. */
+        return hashmap_contains(server->static_leases_by_address, UINT32_TO_PTR(address));
 }
 
 #define HASH_KEY SD_ID128_MAKE(0d,1d,fe,bd,f1,24,bd,b3,47,f1,dd,6e,73,21,93,30)
@@ -1503,6 +1500,8 @@ int sd_dhcp_server_set_static_lease(
                 };
 
                 old = hashmap_remove(server->static_leases_by_client_id, &c);
+                if (old)
+                        hashmap_remove(server->static_leases_by_address, UINT32_TO_PTR(old->address));
                 return 0;
         }
 
@@ -1523,10 +1522,16 @@ int sd_dhcp_server_set_static_lease(
         if (!lease->client_id.data)
                 return -ENOMEM;
 
-        r = hashmap_ensure_put(&server->static_leases_by_client_id, &dhcp_lease_hash_ops, &lease->client_id, lease);
+        r = hashmap_ensure_put(&server->static_leases_by_address, NULL, UINT32_TO_PTR(lease->address), lease);
         if (r < 0)
                 return r;
 
+        r = hashmap_ensure_put(&server->static_leases_by_client_id, &dhcp_lease_hash_ops, &lease->client_id, lease);
+        if (r < 0) {
+                hashmap_remove(server->static_leases_by_address, UINT32_TO_PTR(lease->address));
+                return r;
+        }
+
         TAKE_PTR(lease);
         return 0;
 }
@@ -227,6 +227,26 @@ static void test_client_id_hash(void) {
         free(b.data);
 }
 
+static void test_static_lease(void) {
+        _cleanup_(sd_dhcp_server_unrefp) sd_dhcp_server *server = NULL;
+        uint8_t id1[ETH_ALEN + 1] = { 0x01, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 },
+                id2[ETH_ALEN + 1] = { 0x01, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07 };
+        struct in_addr a = { .s_addr = htobe32(UINT32_C(10) << 24 | 2) };
+
+        assert_se(sd_dhcp_server_new(&server, 1) >= 0);
+
+        assert_se(sd_dhcp_server_set_static_lease(server, &a, id1, sizeof(id1)) >= 0);
+        /* The same address cannot be assigned to two clients. */
+        assert_se(sd_dhcp_server_set_static_lease(server, &a, id2, sizeof(id2)) == -EEXIST);
+        assert_se(hashmap_size(server->static_leases_by_address) == 1);
+
+        /* Removing the static lease frees up the address again. */
+        assert_se(sd_dhcp_server_set_static_lease(server, NULL, id1, sizeof(id1)) >= 0);
+        assert_se(hashmap_isempty(server->static_leases_by_address));
+        assert_se(sd_dhcp_server_set_static_lease(server, &a, id2, sizeof(id2)) >= 0);
+        assert_se(hashmap_size(server->static_leases_by_address) == 1);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(sd_event_unrefp) sd_event *e;
         int r;
@@ -245,6 +265,7 @@ int main(int argc, char *argv[]) {
 
         test_message_handler();
         test_client_id_hash();
+        test_static_lease();
 
         return 0;
 }
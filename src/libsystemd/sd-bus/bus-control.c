@@ -11,6 +11,7 @@
 
 #include "alloc-util.h"
 #include "bus-control.h"
+#include "bus-creds.h"
 #include "bus-internal.h"
 #include "bus-message.h"
 #include "capability-util.h"
@@ -421,6 +422,111 @@ _public_ int sd_bus_list_names(sd_bus *bus, char ***acquired, char ***activatabl
         return 0;
 }
 
+/* The credentials the bus driver reports for a connection are fixed for the lifetime of the connection, and
+ * unique names are never reused on a bus, hence we can remember them instead of asking the driver for
+ * every single incoming call. We never learn when a peer disconnects though, hence the PID is not cached:
+ * it might have been reused by an unrelated process in the meantime, and everything read from /proc is
+ * derived from it. Only the UID and security label are stored here, which are never looked up via the PID.
+ * At least one driver call is made in any case, so that we fail properly if the name is gone. */
+#define NAME_CREDS_CACHE_MAX 64U
+
+DEFINE_PRIVATE_HASH_OPS_FULL(name_creds_hash_ops, char, string_hash_func, string_compare_func, free,
+                             sd_bus_creds, sd_bus_creds_unref);
+
+static void name_creds_from_cache(
+                sd_bus *bus,
+                const char *unique,
+                sd_bus_creds *c,
+                bool *need_uid,
+                bool *need_selinux) {
+
+        sd_bus_creds *cached;
+
+        assert(bus);
+        assert(c);
+        assert(need_uid);
+        assert(need_selinux);
+
+        if (!unique)
+                return;
+
+        cached = ordered_hashmap_get(bus->name_creds_cache, unique);
+        if (!cached)
+                return;
+
+        if (*need_uid && (cached->mask & SD_BUS_CREDS_EUID)) {
+                c->euid = cached->euid;
+                c->mask |= SD_BUS_CREDS_EUID;
+                *need_uid = false;
+        }
+
+        if (*need_selinux && (cached->mask & SD_BUS_CREDS_SELINUX_CONTEXT)) {
+                c->label = strdup(cached->label);
+                if (c->label) {
+                        c->mask |= SD_BUS_CREDS_SELINUX_CONTEXT;
+                        *need_selinux = false;
+                }
+        }
+}
+
+static int name_creds_to_cache(sd_bus *bus, const char *unique, const sd_bus_creds *c) {
+        _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *n = NULL;
+        sd_bus_creds *cached;
+        int r;
+
+        assert(bus);
+        assert(c);
+
+        if (!unique)
+                return 0;
+
+        if (!(c->mask & (SD_BUS_CREDS_EUID|SD_BUS_CREDS_SELINUX_CONTEXT)))
+                return 0;
+
+        cached = ordered_hashmap_get(bus->name_creds_cache, unique);
+        if (!cached) {
+                _cleanup_free_ char *k = NULL;
+
+                k = strdup(unique);
+                if (!k)
+                        return -ENOMEM;
+
+                n = bus_creds_new();
+                if (!n)
+                        return -ENOMEM;
+
+                /* Peers come and go, and we never learn about it here. Keep the cache bounded by dropping
+                 * the entry that was added first. */
+                if (ordered_hashmap_size(bus->name_creds_cache) >= NAME_CREDS_CACHE_MAX) {
+                        _cleanup_free_ char *old = NULL;
+
+                        sd_bus_creds_unref(ordered_hashmap_steal_first_key_and_value(bus->name_creds_cache, (void**) &old));
+                }
+
+                r = ordered_hashmap_ensure_put(&bus->name_creds_cache, &name_creds_hash_ops, k, n);
+                if (r < 0)
+                        return r;
+
+                TAKE_PTR(k);
+                cached = TAKE_PTR(n);
+        }
+
+        if (c->mask & SD_BUS_CREDS_EUID) {
+                cached->euid = c->euid;
+                cached->mask |= SD_BUS_CREDS_EUID;
+        }
+
+        if ((c->mask & SD_BUS_CREDS_SELINUX_CONTEXT) && !(cached->mask & SD_BUS_CREDS_SELINUX_CONTEXT)) {
+                cached->label = strdup(c->label);
+                if (!cached->label)
+                        return -ENOMEM;
+
+                cached->mask |= SD_BUS_CREDS_SELINUX_CONTEXT;
+        }
+
+        return 0;
+}
+
 _public_ int sd_bus_get_name_creds(
                 sd_bus *bus,
                 const char *name,
@@ -511,6 +617,14 @@ _public_ int sd_bus_get_name_creds(
                 need_uid = mask & SD_BUS_CREDS_EUID;
                 need_selinux = mask & SD_BUS_CREDS_SELINUX_CONTEXT;
 
+                name_creds_from_cache(bus, unique, c, &need_uid, &need_selinux);
+
+                /* The cache can't tell whether the peer is still connected. If it answered everything we
+                 * need, ask the driver for the UID anyway: it is the cheapest call and fails properly if the
+                 * name is gone. */
+                if (!need_pid && !need_uid && !need_selinux && (mask & (SD_BUS_CREDS_EUID|SD_BUS_CREDS_SELINUX_CONTEXT)))
+                        need_uid = true;
+
                 if (need_pid + need_uid + need_selinux > 1) {
 
                         /* If we need more than one of the credentials, then use GetConnectionCredentials() */
@@ -672,8 +786,10 @@ _public_ int sd_bus_get_name_creds(
                                 if (r < 0)
                                         return r;
 
-                                c->euid = u;
-                                c->mask |= SD_BUS_CREDS_EUID;
+                                if (mask & SD_BUS_CREDS_EUID) {
+                                        c->euid = u;
+                                        c->mask |= SD_BUS_CREDS_EUID;
+                                }
 
                                 reply = sd_bus_message_unref(reply);
                         }
@@ -711,6 +827,10 @@ _public_ int sd_bus_get_name_creds(
                         }
                 }
 
+                r = name_creds_to_cache(bus, unique, c);
+                if (r < 0)
+                        return r;
+
                 r = bus_creds_add_more(c, mask, pid, 0);
                 if (r < 0 && r != -ESRCH) /* Return the error, but ignore ESRCH which just means the process is already gone */
                         return r;
@@ -102,6 +102,10 @@ struct node_vtable {
         const sd_bus_vtable *vtable;
         sd_bus_object_find_t find;
 
+        /* The introspection XML of the members, built on first use */
+        char *introspection;
+        bool introspection_trusted;
+
         LIST_FIELDS(struct node_vtable, vtables);
 };
 
@@ -269,22 +273,15 @@ struct sd_bus {
 
         uint64_t creds_mask;
 
+        /* Credentials the bus driver reported for other connections, keyed by their unique name */
+        OrderedHashmap *name_creds_cache;
+
         int *fds;
         size_t n_fds;
 
         char *exec_path;
         char **exec_argv;
 
-        /* We do locking around the memfd cache, since we want to
-         * allow people to process a sd_bus_message in a different
-         * thread then it was generated on and free it there. Since
-         * adding something to the memfd cache might happen when a
-         * message is released, we hence need to protect this bit with
-         * a mutex. */
-        pthread_mutex_t memfd_cache_mutex;
-        struct memfd_cache memfd_cache[MEMFD_CACHE_MAX];
-        unsigned n_memfd_cache;
-
         pid_t original_pid;
         pid_t busexec_pid;
 
@@ -51,10 +51,16 @@ static bool BUS_MATCH_IS_COMPARE(enum bus_match_node_type t) {
         return t >= BUS_MATCH_SENDER && t <= BUS_MATCH_ARG_HAS_LAST;
 }
 
+static bool BUS_MATCH_IS_NAMESPACE(enum bus_match_node_type t) {
+        return t == BUS_MATCH_PATH_NAMESPACE ||
+                (t >= BUS_MATCH_ARG_NAMESPACE && t <= BUS_MATCH_ARG_NAMESPACE_LAST);
+}
+
 static bool BUS_MATCH_CAN_HASH(enum bus_match_node_type t) {
         return (t >= BUS_MATCH_MESSAGE_TYPE && t <= BUS_MATCH_PATH) ||
                 (t >= BUS_MATCH_ARG && t <= BUS_MATCH_ARG_LAST) ||
-                (t >= BUS_MATCH_ARG_HAS && t <= BUS_MATCH_ARG_HAS_LAST);
+                (t >= BUS_MATCH_ARG_HAS && t <= BUS_MATCH_ARG_HAS_LAST) ||
+                BUS_MATCH_IS_NAMESPACE(t);
 }
 
 static void bus_match_node_free(struct bus_match_node *node) {
@@ -183,15 +189,6 @@ static bool value_node_test(
                 return false;
         }
 
-        case BUS_MATCH_ARG_NAMESPACE ... BUS_MATCH_ARG_NAMESPACE_LAST:
-                if (value_str)
-                        return namespace_simple_pattern(node->value.str, value_str);
-
-                return false;
-
-        case BUS_MATCH_PATH_NAMESPACE:
-                return path_simple_pattern(node->value.str, value_str);
-
         case BUS_MATCH_ARG_PATH ... BUS_MATCH_ARG_PATH_LAST:
                 if (value_str)
                         return path_complex_pattern(node->value.str, value_str);
@@ -238,6 +235,70 @@ static bool value_node_same(
         }
 }
 
+static int bus_match_run_namespace(
+                sd_bus *bus,
+                struct bus_match_node *node,
+                const char *value,
+                sd_bus_message *m) {
+
+        _cleanup_free_ char *buf = NULL;
+        struct bus_match_node *found;
+        size_t n, next = 0;
+        char c;
+        int r;
+
+        assert(node);
+        assert(BUS_MATCH_IS_NAMESPACE(node->type));
+        assert(m);
+
+        /* A namespace matches if it is the same as the value, or a prefix of it that is either followed by
+         * the separator in the value or ends in it itself, see simple_pattern_check(). Instead of testing
+         * each value node, look up all the prefixes of the value that qualify in the hash table. */
+
+        if (!value)
+                return 0;
+
+        found = hashmap_get(node->compare.children, value);
+        if (found) {
+                r = bus_match_run(bus, found, m);
+                if (r != 0)
+                        return r;
+
+                if (bus && bus->match_callbacks_modified)
+                        return 0;
+        }
+
+        c = node->type == BUS_MATCH_PATH_NAMESPACE ? '/' : '.';
+        n = strlen(value);
+
+        buf = memdup(value, n + 1);
+        if (!buf)
+                return -ENOMEM;
+
+        /* The prefixes without and with each separator. With consecutive separators, these overlap. */
+        for (char *p = strchr(buf, c); p; p = strchr(p + 1, c))
+                for (size_t k = MAX((size_t) (p - buf), next); k <= (size_t) (p - buf) + 1 && k < n; k++) {
+                        char saved = buf[k];
+
+                        buf[k] = 0;
+                        found = hashmap_get(node->compare.children, buf);
+                        buf[k] = saved;
+                        next = k + 1;
+
+                        if (!found)
+                                continue;
+
+                        r = bus_match_run(bus, found, m);
+                        if (r != 0)
+                                return r;
+
+                        if (bus && bus->match_callbacks_modified)
+                                return 0;
+                }
+
+        return 0;
+}
+
 int bus_match_run(
                 sd_bus *bus,
                 struct bus_match_node *node,
@@ -383,7 +444,13 @@ int bus_match_run(
 
                 /* Lookup via hash table, nice! So let's jump directly. */
 
-                if (test_str)
+                if (BUS_MATCH_IS_NAMESPACE(node->type)) {
+                        r = bus_match_run_namespace(bus, node, test_str, m);
+                        if (r != 0)
+                                return r;
+
+                        found = NULL;
+                } else if (test_str)
                         found = hashmap_get(node->compare.children, test_str);
                 else if (test_strv) {
                         char **i;
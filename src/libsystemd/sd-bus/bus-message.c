@@ -166,17 +166,19 @@ static void *message_extend_fields(sd_bus_message *m, size_t align, size_t sz, b
         if (old_size == new_size)
                 return (uint8_t*) m->header + old_size;
 
+        /* A message usually gets a couple of fields appended one after the other, hence grow the
+         * allocation geometrically rather than to the exact size each time. */
         if (m->free_header) {
-                np = realloc(m->header, ALIGN8(new_size));
-                if (!np)
+                np = m->header;
+                if (!greedy_realloc(&np, ALIGN8(new_size), 1))
                         goto poison;
         } else {
                 /* Initially, the header is allocated as part of
                  * the sd_bus_message itself, let's replace it by
                  * dynamic data */
 
-                np = malloc(ALIGN8(new_size));
-                if (!np)
+                np = NULL;
+                if (!greedy_realloc(&np, ALIGN8(new_size), 1))
                         goto poison;
 
                 memcpy(np, m->header, sizeof(struct bus_header));
@@ -3280,6 +3282,26 @@ static int message_peek_body(
         if (end > m->user_body_size)
                 return -EBADMSG;
 
+        part = m->cached_rindex_part;
+        if (part && part->data &&
+            *rindex >= m->cached_rindex_part_begin &&
+            end <= m->cached_rindex_part_begin + part->size) {
+
+                /* Fast path: almost always the padding and the data both lie in the part we looked at last,
+                 * and that one is already mapped. Saves two walks through find_part() for every field. */
+                q = (uint8_t*) part->data + *rindex - m->cached_rindex_part_begin;
+                for (k = 0; k < padding; k++)
+                        if (q[k] != 0)
+                                return -EBADMSG;
+
+                *rindex = end;
+
+                if (ret)
+                        *ret = q + padding;
+
+                return 0;
+        }
+
         part = find_part(m, *rindex, padding, (void**) &q);
         if (!part)
                 return -EBADMSG;
@@ -5586,6 +5608,7 @@ int bus_message_get_blob(sd_bus_message *m, void **buffer, size_t *sz) {
 int bus_message_read_strv_extend(sd_bus_message *m, char ***l) {
         char type;
         const char *contents, *s;
+        size_t n;
         int r;
 
         assert(m);
@@ -5602,11 +5625,25 @@ int bus_message_read_strv_extend(sd_bus_message *m, char ***l) {
         if (r <= 0)
                 return r;
 
+        /* Keep track of the length ourselves, strv_extend() would count the whole list again for every
+         * single entry. */
+        n = strv_length(*l);
+
         /* sd_bus_message_read_basic() does content validation for us. */
         while ((r = sd_bus_message_read_basic(m, *contents, &s)) > 0) {
-                r = strv_extend(l, s);
-                if (r < 0)
-                        return r;
+                char *v;
+
+                v = strdup(s);
+                if (!v)
+                        return -ENOMEM;
+
+                if (!GREEDY_REALLOC(*l, n + 2)) {
+                        free(v);
+                        return -ENOMEM;
+                }
+
+                (*l)[n++] = v;
+                (*l)[n] = NULL;
         }
         if (r < 0)
                 return r;
@@ -982,7 +982,19 @@ int introspect_path(
                 if (c->vtable[0].flags & SD_BUS_VTABLE_HIDDEN)
                         continue;
 
-                r = introspect_write_interface(&intro, c->interface, c->vtable);
+                /* The vtable can't change while it is registered, hence format its members only once and
+                 * reuse that for every object and every call. */
+                if (!c->introspection || c->introspection_trusted != bus->trusted) {
+                        c->introspection = mfree(c->introspection);
+
+                        r = introspect_format_members(c->vtable, bus->trusted, &c->introspection);
+                        if (r < 0)
+                                return r;
+
+                        c->introspection_trusted = bus->trusted;
+                }
+
+                r = introspect_write_interface_members(&intro, c->interface, c->introspection);
                 if (r < 0)
                         return r;
         }
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <endian.h>
+#include <limits.h>
 #include <poll.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -1008,38 +1009,59 @@ int bus_socket_take_fd(sd_bus *b) {
         return bus_socket_start_auth(b);
 }
 
-int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
+int bus_socket_write_messages(sd_bus *bus, sd_bus_message **messages, size_t n_messages, size_t *idx) {
         struct iovec *iov;
+        size_t n_iovec = 0, n = 0;
+        sd_bus_message *m;
         ssize_t k;
-        size_t n;
         unsigned j;
         int r;
 
         assert(bus);
-        assert(m);
+        assert(messages);
+        assert(n_messages > 0);
         assert(idx);
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
+        m = messages[0];
+
         if (*idx >= BUS_MESSAGE_SIZE(m))
                 return 0;
 
-        r = bus_message_setup_iovec(m);
-        if (r < 0)
-                return r;
+        /* Send the messages following the first one in the same go, as long as they don't carry any fds: the
+         * receiver attaches fds to the message whose first byte it reads together with them, hence these
+         * always need to start a write of their own. */
+        for (; n < n_messages; n++) {
+                sd_bus_message *i = messages[n];
+
+                if (n > 0 && i->n_fds > 0)
+                        break;
+
+                r = bus_message_setup_iovec(i);
+                if (r < 0)
+                        return r;
+
+                if (n > 0 && n_iovec + i->n_iovec > IOV_MAX)
+                        break;
+
+                n_iovec += i->n_iovec;
+        }
 
-        n = m->n_iovec * sizeof(struct iovec);
-        iov = newa(struct iovec, n);
-        memcpy_safe(iov, m->iovec, n);
+        iov = newa(struct iovec, n_iovec);
+        for (size_t i = 0, c = 0; i < n; i++) {
+                memcpy(iov + c, messages[i]->iovec, messages[i]->n_iovec * sizeof(struct iovec));
+                c += messages[i]->n_iovec;
+        }
 
         j = 0;
         iovec_advance(iov, &j, *idx);
 
         if (bus->prefer_writev)
-                k = writev(bus->output_fd, iov, m->n_iovec);
+                k = writev(bus->output_fd, iov, n_iovec);
         else {
                 struct msghdr mh = {
                         .msg_iov = iov,
-                        .msg_iovlen = m->n_iovec,
+                        .msg_iovlen = n_iovec,
                 };
 
                 if (m->n_fds > 0 && *idx == 0) {
@@ -1057,7 +1079,7 @@ int bus_socket_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
                 k = sendmsg(bus->output_fd, &mh, MSG_DONTWAIT|MSG_NOSIGNAL);
                 if (k < 0 && errno == ENOTSOCK) {
                         bus->prefer_writev = true;
-                        k = writev(bus->output_fd, iov, m->n_iovec);
+                        k = writev(bus->output_fd, iov, n_iovec);
                 }
         }
 
@@ -1120,19 +1142,28 @@ static int bus_socket_read_message_need(sd_bus *bus, size_t *need) {
         return 0;
 }
 
-static int bus_socket_make_message(sd_bus *bus, size_t size) {
+static int bus_socket_make_message(sd_bus *bus, size_t size, size_t n_fds) {
+        _cleanup_free_ int *fds_next = NULL;
         sd_bus_message *t = NULL;
         void *b;
         int r;
 
         assert(bus);
         assert(bus->rbuffer_size >= size);
+        assert(bus->n_fds >= n_fds);
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
         r = bus_rqueue_make_room(bus);
         if (r < 0)
                 return r;
 
+        /* Any fds beyond the first n_fds came with the beginning of the next message */
+        if (n_fds > 0 && bus->n_fds > n_fds) {
+                fds_next = newdup(int, bus->fds + n_fds, bus->n_fds - n_fds);
+                if (!fds_next)
+                        return -ENOMEM;
+        }
+
         if (bus->rbuffer_size > size) {
                 b = memdup((const uint8_t*) bus->rbuffer + size,
                            bus->rbuffer_size - size);
@@ -1143,12 +1174,16 @@ static int bus_socket_make_message(sd_bus *bus, size_t size) {
 
         r = bus_message_from_malloc(bus,
                                     bus->rbuffer, size,
-                                    bus->fds, bus->n_fds,
+                                    n_fds > 0 ? bus->fds : NULL, n_fds,
                                     NULL,
                                     &t);
         if (r == -EBADMSG) {
                 log_debug_errno(r, "Received invalid message from connection %s, dropping.", strna(bus->description));
                 free(bus->rbuffer); /* We want to drop current rbuffer and proceed with whatever remains in b */
+                if (n_fds > 0) {
+                        close_many(bus->fds, n_fds);
+                        free(bus->fds);
+                }
         } else if (r < 0) {
                 free(b);
                 return r;
@@ -1158,8 +1193,11 @@ static int bus_socket_make_message(sd_bus *bus, size_t size) {
         bus->rbuffer = b;
         bus->rbuffer_size -= size;
 
-        bus->fds = NULL;
-        bus->n_fds = 0;
+        /* Same for the fds array, if this message got any fds */
+        if (n_fds > 0) {
+                bus->fds = TAKE_PTR(fds_next);
+                bus->n_fds -= n_fds;
+        }
 
         if (t) {
                 t->read_counter = ++bus->read_counter;
@@ -1174,7 +1212,7 @@ int bus_socket_read_message(sd_bus *bus) {
         struct msghdr mh;
         struct iovec iov = {};
         ssize_t k;
-        size_t need;
+        size_t need, ahead, n_fds;
         int r;
         void *b;
         CMSG_BUFFER_TYPE(CMSG_SPACE(sizeof(int) * BUS_FDS_MAX)) control;
@@ -1188,15 +1226,22 @@ int bus_socket_read_message(sd_bus *bus) {
                 return r;
 
         if (bus->rbuffer_size >= need)
-                return bus_socket_make_message(bus, need);
+                return bus_socket_make_message(bus, need, bus->n_fds);
 
-        b = realloc(bus->rbuffer, need);
+        /* Once the size of the current message is known, read the fixed header of the next one along with
+         * the rest of it, so that a stream of messages takes one read per message rather than two. Don't read
+         * any further than that: fds are passed along with the first byte of their message, hence we make sure
+         * every read contains the beginning of one message at most. And since no valid message is shorter
+         * than the fixed header plus 8 bytes, this never leaves a complete message behind in rbuffer. */
+        ahead = bus->rbuffer_size >= sizeof(struct bus_header) ? sizeof(struct bus_header) : 0;
+
+        b = realloc(bus->rbuffer, need + ahead);
         if (!b)
                 return -ENOMEM;
 
         bus->rbuffer = b;
 
-        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, need - bus->rbuffer_size);
+        iov = IOVEC_MAKE((uint8_t *)bus->rbuffer + bus->rbuffer_size, need + ahead - bus->rbuffer_size);
 
         if (bus->prefer_readv) {
                 k = readv(bus->input_fd, &iov, 1);
@@ -1230,6 +1275,7 @@ int bus_socket_read_message(sd_bus *bus) {
         }
 
         bus->rbuffer_size += k;
+        n_fds = bus->n_fds;
 
         if (handle_cmsg) {
                 struct cmsghdr *cmsg;
@@ -1268,8 +1314,12 @@ int bus_socket_read_message(sd_bus *bus) {
         if (r < 0)
                 return r;
 
+        /* If we read into the next message, any fds we just got belong to that one */
+        if (bus->rbuffer_size <= need)
+                n_fds = bus->n_fds;
+
         if (bus->rbuffer_size >= need)
-                return bus_socket_make_message(bus, need);
+                return bus_socket_make_message(bus, need, n_fds);
 
         return 1;
 }
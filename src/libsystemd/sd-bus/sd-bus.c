@@ -2,7 +2,6 @@
 
 #include <endian.h>
 #include <netdb.h>
-#include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <sys/mman.h>
@@ -216,13 +215,11 @@ static sd_bus* bus_free(sd_bus *b) {
         hashmap_free_free(b->vtable_methods);
         hashmap_free_free(b->vtable_properties);
 
+        ordered_hashmap_free(b->name_creds_cache);
+
         assert(hashmap_isempty(b->nodes));
         hashmap_free(b->nodes);
 
-        bus_flush_memfd(b);
-
-        assert_se(pthread_mutex_destroy(&b->memfd_cache_mutex) == 0);
-
         return mfree(b);
 }
 
@@ -254,8 +251,6 @@ _public_ int sd_bus_new(sd_bus **ret) {
         if (!GREEDY_REALLOC(b->wqueue, 1))
                 return -ENOMEM;
 
-        assert_se(pthread_mutex_init(&b->memfd_cache_mutex, NULL) == 0);
-
         *ret = TAKE_PTR(b);
         return 0;
 }
@@ -1963,29 +1958,35 @@ int bus_seal_synthetic_message(sd_bus *b, sd_bus_message *m) {
         return sd_bus_message_seal(m, 0xFFFFFFFFULL, 0);
 }
 
+static void bus_log_sent_message(sd_bus_message *m) {
+        assert(m);
+
+        log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s cookie=%" PRIu64 " reply_cookie=%" PRIu64 " signature=%s error-name=%s error-message=%s",
+                  bus_message_type_to_string(m->header->type),
+                  strna(sd_bus_message_get_sender(m)),
+                  strna(sd_bus_message_get_destination(m)),
+                  strna(sd_bus_message_get_path(m)),
+                  strna(sd_bus_message_get_interface(m)),
+                  strna(sd_bus_message_get_member(m)),
+                  BUS_MESSAGE_COOKIE(m),
+                  m->reply_cookie,
+                  strna(m->root_container.signature),
+                  strna(m->error.name),
+                  strna(m->error.message));
+}
+
 static int bus_write_message(sd_bus *bus, sd_bus_message *m, size_t *idx) {
         int r;
 
         assert(bus);
         assert(m);
 
-        r = bus_socket_write_message(bus, m, idx);
+        r = bus_socket_write_messages(bus, &m, 1, idx);
         if (r <= 0)
                 return r;
 
         if (*idx >= BUS_MESSAGE_SIZE(m))
-                log_debug("Sent message type=%s sender=%s destination=%s path=%s interface=%s member=%s cookie=%" PRIu64 " reply_cookie=%" PRIu64 " signature=%s error-name=%s error-message=%s",
-                          bus_message_type_to_string(m->header->type),
-                          strna(sd_bus_message_get_sender(m)),
-                          strna(sd_bus_message_get_destination(m)),
-                          strna(sd_bus_message_get_path(m)),
-                          strna(sd_bus_message_get_interface(m)),
-                          strna(sd_bus_message_get_member(m)),
-                          BUS_MESSAGE_COOKIE(m),
-                          m->reply_cookie,
-                          strna(m->root_container.signature),
-                          strna(m->error.name),
-                          strna(m->error.message));
+                bus_log_sent_message(m);
 
         return r;
 }
@@ -1997,28 +1998,28 @@ static int dispatch_wqueue(sd_bus *bus) {
         assert(IN_SET(bus->state, BUS_RUNNING, BUS_HELLO));
 
         while (bus->wqueue_size > 0) {
+                size_t n = 0;
 
-                r = bus_write_message(bus, bus->wqueue[0], &bus->windex);
+                /* Write as many of the queued messages as possible at once, see bus_socket_write_messages(),
+                 * windex then refers to the beginning of the first one. */
+                r = bus_socket_write_messages(bus, bus->wqueue, bus->wqueue_size, &bus->windex);
                 if (r < 0)
                         return r;
-                else if (r == 0)
+                if (r == 0)
                         /* Didn't do anything this time */
                         return ret;
-                else if (bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[0])) {
-                        /* Fully written. Let's drop the entry from
-                         * the queue.
-                         *
-                         * This isn't particularly optimized, but
-                         * well, this is supposed to be our worst-case
-                         * buffer only, and the socket buffer is
-                         * supposed to be our primary buffer, and if
-                         * it got full, then all bets are off
-                         * anyway. */
-
-                        bus->wqueue_size--;
-                        bus_message_unref_queued(bus->wqueue[0], bus);
-                        memmove(bus->wqueue, bus->wqueue + 1, sizeof(sd_bus_message*) * bus->wqueue_size);
-                        bus->windex = 0;
+
+                /* Drop the entries that have been written fully from the queue */
+                while (n < bus->wqueue_size && bus->windex >= BUS_MESSAGE_SIZE(bus->wqueue[n])) {
+                        bus->windex -= BUS_MESSAGE_SIZE(bus->wqueue[n]);
+                        bus_log_sent_message(bus->wqueue[n]);
+                        bus_message_unref_queued(bus->wqueue[n], bus);
+                        n++;
+                }
+
+                if (n > 0) {
+                        bus->wqueue_size -= n;
+                        memmove(bus->wqueue, bus->wqueue + n, sizeof(sd_bus_message*) * bus->wqueue_size);
 
                         ret = 1;
                 }
@@ -2254,7 +2255,7 @@ _public_ int sd_bus_call_async(
         if (!callback && !slot && !m->sealed)
                 m->header->flags |= BUS_MESSAGE_NO_REPLY_EXPECTED;
 
-        r = ordered_hashmap_ensure_allocated(&bus->reply_callbacks, &uint64_hash_ops);
+        r = ordered_hashmap_ensure_allocated(&bus->reply_callbacks, &uint64_hash_ops_trusted);
         if (r < 0)
                 return r;
 
@@ -2,10 +2,86 @@
 
 #include "sd-bus.h"
 
+#include "alloc-util.h"
+#include "bus-creds.h"
 #include "bus-dump.h"
+#include "bus-internal.h"
 #include "cgroup-util.h"
+#include "process-util.h"
 #include "tests.h"
 
+static void test_name_creds_cache(void) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *a = NULL, *b = NULL;
+        const char *unique;
+        uid_t x, y;
+        pid_t p, q;
+        int r;
+
+        r = sd_bus_open_system(&bus);
+        if (r < 0) {
+                log_notice_errno(r, "Failed to connect to system bus, skipping %s: %m", __func__);
+                return;
+        }
+
+        assert_se(sd_bus_get_unique_name(bus, &unique) >= 0);
+
+        r = sd_bus_get_name_creds(bus, unique, SD_BUS_CREDS_EUID|SD_BUS_CREDS_PID, &a);
+        assert_se(r >= 0);
+        assert_se(ordered_hashmap_size(bus->name_creds_cache) == 1);
+
+        /* The PID must never be cached, it is always asked from the driver */
+        assert_se(!(((sd_bus_creds*) ordered_hashmap_first(bus->name_creds_cache))->mask & SD_BUS_CREDS_PID));
+
+        /* The second query is answered partially from the cache and must yield the same */
+        r = sd_bus_get_name_creds(bus, unique, SD_BUS_CREDS_EUID|SD_BUS_CREDS_PID, &b);
+        assert_se(r >= 0);
+        assert_se(ordered_hashmap_size(bus->name_creds_cache) == 1);
+
+        assert_se(sd_bus_creds_get_euid(a, &x) >= 0);
+        assert_se(sd_bus_creds_get_euid(b, &y) >= 0);
+        assert_se(x == y);
+        assert_se(x == geteuid());
+
+        assert_se(sd_bus_creds_get_pid(a, &p) >= 0);
+        assert_se(sd_bus_creds_get_pid(b, &q) >= 0);
+        assert_se(p == q);
+        assert_se(p == getpid_cached());
+}
+
+static void test_name_creds_cache_disconnected(void) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *bus = NULL, *peer = NULL;
+        _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *a = NULL, *b = NULL;
+        _cleanup_free_ char *unique = NULL;
+        const char *u;
+        int r;
+
+        r = sd_bus_open_system(&bus);
+        if (r < 0) {
+                log_notice_errno(r, "Failed to connect to system bus, skipping %s: %m", __func__);
+                return;
+        }
+
+        assert_se(sd_bus_open_system(&peer) >= 0);
+        assert_se(sd_bus_get_unique_name(peer, &u) >= 0);
+        assert_se(unique = strdup(u));
+
+        assert_se(sd_bus_get_name_creds(bus, unique, SD_BUS_CREDS_EUID, &a) >= 0);
+        assert_se(ordered_hashmap_size(bus->name_creds_cache) == 1);
+
+        /* Once the peer is gone, the cached UID must not be handed out anymore */
+        peer = sd_bus_flush_close_unref(peer);
+
+        /* Wait until the driver noticed the disconnect */
+        for (unsigned i = 0; sd_bus_get_name_creds(bus, unique, 0, NULL) >= 0; i++) {
+                assert_se(i < 100);
+                usleep(10 * USEC_PER_MSEC);
+        }
+
+        assert_se(sd_bus_get_name_creds(bus, unique, SD_BUS_CREDS_EUID, &b) < 0);
+        assert_se(!b);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(sd_bus_creds_unrefp) sd_bus_creds *creds = NULL;
         int r;
@@ -30,5 +106,8 @@ int main(int argc, char *argv[]) {
                 bus_creds_dump(creds, NULL, true);
         }
 
+        test_name_creds_cache();
+        test_name_creds_cache_disconnected();
+
         return 0;
 }
@@ -23,6 +23,29 @@ static void test_manual_introspection(const sd_bus_vtable vtable[]) {
         fputs("\n", stdout);
 }
 
+static void test_cached_introspection(const sd_bus_vtable vtable[], bool trusted) {
+        struct introspect intro = {}, cached = {};
+        _cleanup_free_ char *s = NULL, *t = NULL, *members = NULL;
+
+        log_info("/* %s(%s) */", __func__, yes_no(trusted));
+
+        assert_se(introspect_begin(&intro, trusted) >= 0);
+        assert_se(introspect_write_interface(&intro, "org.foo", vtable) >= 0);
+        assert_se(introspect_write_interface(&intro, "org.foo", vtable) >= 0);
+        assert_se(introspect_write_interface(&intro, "org.foo.bar", vtable) >= 0);
+        assert_se(introspect_finish(&intro, &s) == 0);
+
+        /* Writing out the preformatted members must give the very same result */
+        assert_se(introspect_format_members(vtable, trusted, &members) >= 0);
+        assert_se(introspect_begin(&cached, trusted) >= 0);
+        assert_se(introspect_write_interface_members(&cached, "org.foo", members) >= 0);
+        assert_se(introspect_write_interface_members(&cached, "org.foo", members) >= 0);
+        assert_se(introspect_write_interface_members(&cached, "org.foo.bar", members) >= 0);
+        assert_se(introspect_finish(&cached, &t) == 0);
+
+        assert_se(streq(s, t));
+}
+
 int main(int argc, char *argv[]) {
         test_setup_logging(LOG_DEBUG);
 
@@ -31,5 +54,11 @@ int main(int argc, char *argv[]) {
         test_manual_introspection(test_vtable_deprecated);
         test_manual_introspection((const sd_bus_vtable *) vtable_format_221);
 
+        test_cached_introspection(test_vtable_1, false);
+        test_cached_introspection(test_vtable_1, true);
+        test_cached_introspection(test_vtable_2, false);
+        test_cached_introspection(test_vtable_deprecated, false);
+        test_cached_introspection((const sd_bus_vtable *) vtable_format_221, false);
+
         return 0;
 }
@@ -22,6 +22,8 @@
 #include "fd-util.h"
 #include "fileio.h"
 #include "log.h"
+#include "stdio-util.h"
+#include "strv.h"
 #include "tests.h"
 #include "util.h"
 
@@ -105,6 +107,38 @@ static void test_bus_label_escape(void) {
         test_bus_label_escape_one(":1", "_3a1");
 }
 
+static void test_bus_message_read_strv(sd_bus *bus) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+        _cleanup_strv_free_ char **l = NULL, **got = NULL;
+
+        for (unsigned i = 0; i < 1000; i++) {
+                char t[STRLEN("item") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(t, "item%u", i);
+                assert_se(strv_extend(&l, t) >= 0);
+        }
+
+        assert_se(sd_bus_message_new_signal(bus, &m, "/foo", "foo.bar", "Baz") >= 0);
+        assert_se(sd_bus_message_append_strv(m, l) >= 0);
+        assert_se(sd_bus_message_append(m, "as", 2, "foo", "bar") >= 0);
+        assert_se(sd_bus_message_append(m, "as", 0) >= 0);
+        assert_se(sd_bus_message_seal(m, 4712, 0) >= 0);
+
+        assert_se(sd_bus_message_read_strv(m, &got) > 0);
+        assert_se(strv_equal(got, l));
+
+        /* Extending appends to what's already there */
+        assert_se(bus_message_read_strv_extend(m, &got) > 0);
+        assert_se(strv_length(got) == strv_length(l) + 2);
+        assert_se(streq(got[1000], "foo"));
+        assert_se(streq(got[1001], "bar"));
+        assert_se(!got[1002]);
+
+        got = strv_free(got);
+        assert_se(sd_bus_message_read_strv(m, &got) > 0);
+        assert_se(!got);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL, *copy = NULL;
         int r, boolean;
@@ -413,6 +447,7 @@ int main(int argc, char *argv[]) {
         assert_se(streq(c, "ccc"));
         assert_se(streq(d, "3"));
 
+        test_bus_message_read_strv(bus);
         test_bus_label_escape();
         test_bus_path_encode();
         test_bus_path_encode_unique();
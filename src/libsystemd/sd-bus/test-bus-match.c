@@ -1,12 +1,16 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include "alloc-util.h"
+#include "bus-internal.h"
 #include "bus-match.h"
 #include "bus-message.h"
 #include "bus-slot.h"
 #include "log.h"
 #include "macro.h"
 #include "memory-util.h"
+#include "stdio-util.h"
 #include "tests.h"
+#include "time-util.h"
 
 static bool mask[32];
 
@@ -66,6 +70,121 @@ static void test_match_scope(const char *match, enum bus_match_scope scope) {
         bus_match_parse_free(components, n_components);
 }
 
+static void test_namespace(sd_bus *bus) {
+        static const char *const path_patterns[] = {
+                "/", "/a", "/a/", "/a/b", "/a/b/", "/ab", "/a/b/c", "/b",
+        };
+        static const char *const arg_patterns[] = {
+                "a", "a.", "a.b", "a.b.", "ab", "a.b.c", ".", "a..",
+        };
+        static const char *const paths[] = {
+                "/", "/a", "/a/b", "/a/b/c", "/ab", "/abc/d", "/b/a",
+        };
+        static const char *const args[] = {
+                "a", "a.b", "a.b.c", "a..b", ".", "", "ab.c", "a.b.", "b.a",
+        };
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        sd_bus_slot slots[ELEMENTSOF(path_patterns) + ELEMENTSOF(arg_patterns)] = {};
+
+        log_info("/* %s */", __func__);
+
+        /* The namespace matches are looked up by the prefixes of the value, compare that with testing
+         * each pattern */
+
+        for (size_t i = 0; i < ELEMENTSOF(path_patterns); i++) {
+                _cleanup_free_ char *match = NULL;
+
+                assert_se(match = strjoin("path_namespace='", path_patterns[i], "'"));
+                assert_se(match_add(slots, &root, match, i) >= 0);
+        }
+
+        for (size_t i = 0; i < ELEMENTSOF(arg_patterns); i++) {
+                _cleanup_free_ char *match = NULL;
+
+                assert_se(match = strjoin("arg0namespace='", arg_patterns[i], "'"));
+                assert_se(match_add(slots, &root, match, ELEMENTSOF(path_patterns) + i) >= 0);
+        }
+
+        bus_match_dump(stdout, &root, 0);
+
+        for (size_t i = 0; i < ELEMENTSOF(paths); i++)
+                for (size_t j = 0; j < ELEMENTSOF(args); j++) {
+                        _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                        assert_se(sd_bus_message_new_signal(bus, &m, paths[i], "bar.x", "waldo") >= 0);
+                        assert_se(sd_bus_message_append(m, "s", args[j]) >= 0);
+                        assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+                        zero(mask);
+                        assert_se(bus_match_run(NULL, &root, m) == 0);
+
+                        for (size_t k = 0; k < ELEMENTSOF(path_patterns); k++)
+                                assert_se(mask[k] == path_simple_pattern(path_patterns[k], paths[i]));
+
+                        for (size_t k = 0; k < ELEMENTSOF(arg_patterns); k++)
+                                assert_se(mask[ELEMENTSOF(path_patterns) + k] ==
+                                          namespace_simple_pattern(arg_patterns[k], args[j]));
+                }
+
+        bus_match_free(&root);
+}
+
+static unsigned n_called;
+
+static int count_filter(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        n_called++;
+        return 0;
+}
+
+static void test_benchmark(sd_bus *bus) {
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        unsigned n_matches = slow_tests_enabled() ? 10000 : 1000, n_runs = 1000;
+        _cleanup_free_ sd_bus_slot *slots = NULL;
+        char b[FORMAT_TIMESPAN_MAX];
+        usec_t ts;
+
+        log_info("/* %s (%u matches) */", __func__, n_matches);
+
+        /* Lots of path_namespace matches below the same prefix, like clients watching many units */
+
+        assert_se(slots = new0(sd_bus_slot, n_matches));
+
+        for (unsigned i = 0; i < n_matches; i++) {
+                char match[STRLEN("path_namespace='/org/freedesktop/systemd1/unit/u'") + DECIMAL_STR_MAX(unsigned)];
+                struct bus_match_component *components;
+                unsigned n_components;
+
+                xsprintf(match, "path_namespace='/org/freedesktop/systemd1/unit/u%u'", i);
+                assert_se(bus_match_parse(match, &components, &n_components) >= 0);
+
+                slots[i].match_callback.callback = count_filter;
+                assert_se(bus_match_add(&root, components, n_components, &slots[i].match_callback) >= 0);
+                bus_match_parse_free(components, n_components);
+        }
+
+        n_called = 0;
+        ts = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < n_runs; i++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+                char path[STRLEN("/org/freedesktop/systemd1/unit/u/job") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(path, "/org/freedesktop/systemd1/unit/u%u/job", i % n_matches);
+                assert_se(sd_bus_message_new_signal(bus, &m, path, "bar.x", "waldo") >= 0);
+                assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+                assert_se(bus_match_run(NULL, &root, m) == 0);
+        }
+        log_info("%u runs in %s", n_runs, format_timespan(b, sizeof b, usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), 1));
+
+        assert_se(n_called == n_runs);
+
+        bus_match_free(&root);
+}
+
 int main(int argc, char *argv[]) {
         struct bus_match_node root = {
                 .type = BUS_MATCH_ROOT,
@@ -141,5 +260,8 @@ int main(int argc, char *argv[]) {
         test_match_scope("member='gurke',path='/org/freedesktop/DBus/Local'", BUS_MATCH_LOCAL);
         test_match_scope("arg2='piep',sender='org.freedesktop.DBus',member='waldo'", BUS_MATCH_DRIVER);
 
+        test_namespace(bus);
+        test_benchmark(bus);
+
         return 0;
 }
@@ -0,0 +1,429 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+#include "sd-bus.h"
+
+#include "alloc-util.h"
+#include "bus-internal.h"
+#include "bus-match.h"
+#include "bus-message.h"
+#include "bus-slot.h"
+#include "fd-util.h"
+#include "macro.h"
+#include "stdio-util.h"
+#include "string-util.h"
+#include "strv.h"
+#include "time-util.h"
+
+/* Measures the throughput of the hot paths in sd-bus. Every benchmark runs for the given time (100ms by
+ * default) and prints one JSON object per line, so that the results can be collected and compared over
+ * time. Benchmarks that need a broker are skipped if $DBUS_SESSION_BUS_ADDRESS is not set. */
+
+static usec_t arg_loop_usec = 100 * USEC_PER_MSEC;
+
+typedef struct Object {
+        char *string;
+        uint32_t u32;
+        uint64_t u64;
+        int boolean;
+        char **strv;
+} Object;
+
+typedef struct Server {
+        sd_bus *bus;
+        Object object;
+        bool quit;
+} Server;
+
+static void report(const char *benchmark, const char *parameter, uint64_t n, usec_t usec) {
+        assert(benchmark);
+        assert(usec > 0);
+
+        printf("{\"benchmark\":\"%s\",\"parameter\":\"%s\",\"iterations\":%" PRIu64 ",\"usec\":" USEC_FMT ","
+               "\"ops_per_sec\":%.0f,\"nsec_per_op\":%.1f}\n",
+               benchmark, strempty(parameter), n, usec,
+               (double) n * USEC_PER_SEC / usec,
+               (double) usec * NSEC_PER_USEC / n);
+
+        fflush(stdout);
+}
+
+/* Runs the body at least once and then until the time is up, but only looks at the clock every 64
+ * iterations, so that fast operations aren't dominated by clock_gettime(). */
+#define BENCHMARK_LOOP(n, start)                                        \
+        for ((n) = 0, (start) = now(CLOCK_MONOTONIC);                   \
+             ((n) & 63) != 0 || (n) == 0 || now(CLOCK_MONOTONIC) < usec_add((start), arg_loop_usec); \
+             (n)++)
+
+static int method_ping(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_exit(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        Server *s = userdata;
+
+        s->quit = true;
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+#define STRING_PROPERTY(name) \
+        SD_BUS_PROPERTY(name, "s", NULL, offsetof(Server, object.string), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE)
+#define U32_PROPERTY(name) \
+        SD_BUS_PROPERTY(name, "u", NULL, offsetof(Server, object.u32), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE)
+#define U64_PROPERTY(name) \
+        SD_BUS_PROPERTY(name, "t", NULL, offsetof(Server, object.u64), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE)
+#define BOOLEAN_PROPERTY(name) \
+        SD_BUS_PROPERTY(name, "b", NULL, offsetof(Server, object.boolean), SD_BUS_VTABLE_PROPERTY_CONST)
+#define STRV_PROPERTY(name) \
+        SD_BUS_PROPERTY(name, "as", NULL, offsetof(Server, object.strv), SD_BUS_VTABLE_PROPERTY_CONST)
+
+/* Roughly the mix of types and the number of properties of org.freedesktop.systemd1.Unit */
+static const sd_bus_vtable vtable[] = {
+        SD_BUS_VTABLE_START(0),
+        SD_BUS_METHOD("Ping", NULL, NULL, method_ping, 0),
+        SD_BUS_METHOD("Exit", NULL, NULL, method_exit, 0),
+        STRING_PROPERTY("Id"), STRING_PROPERTY("Description"), STRING_PROPERTY("LoadState"),
+        STRING_PROPERTY("ActiveState"), STRING_PROPERTY("FreezerState"), STRING_PROPERTY("SubState"),
+        STRING_PROPERTY("FragmentPath"), STRING_PROPERTY("SourcePath"), STRING_PROPERTY("UnitFileState"),
+        STRING_PROPERTY("UnitFilePreset"), STRING_PROPERTY("Following"), STRING_PROPERTY("JobTimeoutAction"),
+        STRING_PROPERTY("JobTimeoutRebootArgument"), STRING_PROPERTY("CollectMode"),
+        STRING_PROPERTY("StartLimitAction"), STRING_PROPERTY("FailureAction"), STRING_PROPERTY("SuccessAction"),
+        STRING_PROPERTY("RebootArgument"), STRING_PROPERTY("OnFailureJobMode"), STRING_PROPERTY("Slice"),
+        U32_PROPERTY("StartLimitBurst"), U32_PROPERTY("FailureActionExitStatus"),
+        U32_PROPERTY("SuccessActionExitStatus"), U32_PROPERTY("RefuseManualStart"),
+        U64_PROPERTY("StateChangeTimestamp"), U64_PROPERTY("StateChangeTimestampMonotonic"),
+        U64_PROPERTY("InactiveExitTimestamp"), U64_PROPERTY("InactiveExitTimestampMonotonic"),
+        U64_PROPERTY("ActiveEnterTimestamp"), U64_PROPERTY("ActiveEnterTimestampMonotonic"),
+        U64_PROPERTY("ActiveExitTimestamp"), U64_PROPERTY("ActiveExitTimestampMonotonic"),
+        U64_PROPERTY("InactiveEnterTimestamp"), U64_PROPERTY("InactiveEnterTimestampMonotonic"),
+        U64_PROPERTY("ConditionTimestamp"), U64_PROPERTY("ConditionTimestampMonotonic"),
+        U64_PROPERTY("AssertTimestamp"), U64_PROPERTY("AssertTimestampMonotonic"),
+        U64_PROPERTY("JobTimeoutUSec"), U64_PROPERTY("JobRunningTimeoutUSec"),
+        U64_PROPERTY("StartLimitIntervalUSec"),
+        BOOLEAN_PROPERTY("CanStart"), BOOLEAN_PROPERTY("CanStop"), BOOLEAN_PROPERTY("CanReload"),
+        BOOLEAN_PROPERTY("CanIsolate"), BOOLEAN_PROPERTY("CanFreeze"), BOOLEAN_PROPERTY("StopWhenUnneeded"),
+        BOOLEAN_PROPERTY("AllowIsolate"), BOOLEAN_PROPERTY("DefaultDependencies"),
+        BOOLEAN_PROPERTY("IgnoreOnIsolate"), BOOLEAN_PROPERTY("NeedDaemonReload"),
+        BOOLEAN_PROPERTY("Transient"), BOOLEAN_PROPERTY("Perpetual"),
+        STRV_PROPERTY("Requires"), STRV_PROPERTY("Wants"), STRV_PROPERTY("Before"), STRV_PROPERTY("After"),
+        STRV_PROPERTY("Conflicts"), STRV_PROPERTY("Documentation"), STRV_PROPERTY("Names"),
+        STRV_PROPERTY("WantedBy"), STRV_PROPERTY("RequiresMountsFor"), STRV_PROPERTY("DropInPaths"),
+        SD_BUS_VTABLE_END
+};
+
+static void* server_thread(void *p) {
+        Server *s = p;
+        int r;
+
+        while (!s->quit) {
+                r = sd_bus_process(s->bus, NULL);
+                assert_se(r >= 0);
+                if (r == 0)
+                        assert_se(sd_bus_wait(s->bus, USEC_INFINITY) >= 0);
+        }
+
+        assert_se(sd_bus_flush(s->bus) >= 0);
+
+        return NULL;
+}
+
+static void server_init(Server *s) {
+        static const char* const dependencies[] = {
+                "sysinit.target", "systemd-journald.socket", "-.mount", "systemd-journald-dev-log.socket",
+                "system.slice", NULL
+        };
+
+        assert(s);
+
+        *s = (Server) {
+                .object = {
+                        .string = (char*) "systemd-journald.service",
+                        .u32 = 4711,
+                        .u64 = UINT64_C(1634567890123456),
+                        .boolean = true,
+                        .strv = (char**) dependencies,
+                },
+        };
+}
+
+static int server_start(Server *s, sd_bus *bus, pthread_t *ret) {
+        assert(s);
+        assert(bus);
+
+        s->bus = bus;
+        assert_se(sd_bus_add_object_vtable(bus, NULL, "/org/test/unit", "org.test.Unit", vtable, s) >= 0);
+
+        return -pthread_create(ret, NULL, server_thread, s);
+}
+
+static void server_stop(sd_bus *client, const char *destination, pthread_t t) {
+        assert_se(sd_bus_call_method(client, destination, "/org/test/unit", "org.test.Unit", "Exit", NULL, NULL, NULL) >= 0);
+        assert_se(pthread_join(t, NULL) == 0);
+}
+
+static void benchmark_calls(sd_bus *client, const char *destination, const char *transport) {
+        usec_t start;
+        uint64_t n;
+
+        BENCHMARK_LOOP(n, start)
+                assert_se(sd_bus_call_method(client, destination, "/org/test/unit", "org.test.Unit", "Ping",
+                                             NULL, NULL, NULL) >= 0);
+        report("method-call", transport, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+
+        BENCHMARK_LOOP(n, start) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+
+                assert_se(sd_bus_call_method(client, destination, "/org/test/unit", "org.freedesktop.DBus.Properties", "GetAll",
+                                             NULL, &reply, "s", "org.test.Unit") >= 0);
+                assert_se(sd_bus_message_skip(reply, "a{sv}") >= 0);
+        }
+        report("get-all", transport, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+}
+
+static void make_pair(sd_bus **ret_server, sd_bus **ret_client) {
+        _cleanup_(sd_bus_unrefp) sd_bus *server = NULL, *client = NULL;
+        int pair[2];
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, SD_ID128_MAKE(c1,4b,03,3e,a6,7d,4a,d2,b5,2b,52,1c,8f,3d,9e,41)) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        while (sd_bus_is_ready(client) <= 0 || sd_bus_is_ready(server) <= 0) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        *ret_server = TAKE_PTR(server);
+        *ret_client = TAKE_PTR(client);
+}
+
+static void benchmark_direct(void) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        Server s;
+        pthread_t t;
+
+        make_pair(&server, &client);
+
+        server_init(&s);
+        assert_se(server_start(&s, server, &t) >= 0);
+
+        benchmark_calls(client, NULL, "direct");
+
+        server_stop(client, NULL, t);
+}
+
+static void benchmark_broker(void) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        const char *unique;
+        Server s;
+        pthread_t t;
+
+        if (!getenv("DBUS_SESSION_BUS_ADDRESS"))
+                return;
+
+        assert_se(sd_bus_open_user(&server) >= 0);
+        assert_se(sd_bus_open_user(&client) >= 0);
+        assert_se(sd_bus_get_unique_name(server, &unique) >= 0);
+
+        server_init(&s);
+        assert_se(server_start(&s, server, &t) >= 0);
+
+        benchmark_calls(client, unique, "broker");
+
+        server_stop(client, unique, t);
+}
+
+static unsigned n_called;
+
+static int count_filter(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        n_called++;
+        return 0;
+}
+
+static void benchmark_fan_out(unsigned n_matches) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *sender = NULL, *receiver = NULL;
+        char parameter[DECIMAL_STR_MAX(unsigned)];
+        usec_t start;
+        uint64_t n;
+
+        /* One signal, delivered to many match callbacks on the receiving side */
+
+        make_pair(&sender, &receiver);
+
+        for (unsigned i = 0; i < n_matches; i++)
+                assert_se(sd_bus_match_signal(receiver, NULL, NULL, "/org/test/unit", "org.test.Unit", "Changed",
+                                              count_filter, NULL) >= 0);
+
+        n_called = 0;
+
+        BENCHMARK_LOOP(n, start) {
+                assert_se(sd_bus_emit_signal(sender, "/org/test/unit", "org.test.Unit", "Changed", "u", (uint32_t) n) >= 0);
+
+                /* Send in batches, so that we don't block on the socket buffer */
+                if ((n & 63) == 63) {
+                        assert_se(sd_bus_flush(sender) >= 0);
+
+                        while (n_called < (n + 1) * n_matches) {
+                                int r;
+
+                                r = sd_bus_process(receiver, NULL);
+                                assert_se(r >= 0);
+                                if (r == 0)
+                                        assert_se(sd_bus_wait(receiver, USEC_INFINITY) >= 0);
+                        }
+                }
+        }
+
+        xsprintf(parameter, "%u", n_matches);
+        report("signal-fan-out", parameter, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+}
+
+static const char* const units[] = {
+        "systemd-journald.service", "Journal Service", "loaded", "active", "running", "",
+        "/org/freedesktop/systemd1/unit/systemd_2djournald_2eservice",
+};
+
+static void append_signature(sd_bus_message *m, const char *signature) {
+        if (streq(signature, "s"))
+                assert_se(sd_bus_message_append(m, "s", units[0]) >= 0);
+
+        else if (streq(signature, "sa{sv}as")) {
+                /* A PropertiesChanged signal of a unit */
+                assert_se(sd_bus_message_append(m, "s", "org.freedesktop.systemd1.Unit") >= 0);
+                assert_se(sd_bus_message_open_container(m, 'a', "{sv}") >= 0);
+                assert_se(sd_bus_message_append(m, "{sv}", "ActiveState", "s", units[3]) >= 0);
+                assert_se(sd_bus_message_append(m, "{sv}", "SubState", "s", units[4]) >= 0);
+                assert_se(sd_bus_message_append(m, "{sv}", "StateChangeTimestamp", "t", UINT64_C(1634567890123456)) >= 0);
+                assert_se(sd_bus_message_append(m, "{sv}", "StateChangeTimestampMonotonic", "t", UINT64_C(12345678)) >= 0);
+                assert_se(sd_bus_message_append(m, "{sv}", "CanStart", "b", true) >= 0);
+                assert_se(sd_bus_message_close_container(m) >= 0);
+                assert_se(sd_bus_message_append(m, "as", 0) >= 0);
+
+        } else if (streq(signature, "a(ssssssouso)")) {
+                /* A ListUnits() reply with 100 units */
+                assert_se(sd_bus_message_open_container(m, 'a', "(ssssssouso)") >= 0);
+                for (unsigned i = 0; i < 100; i++)
+                        assert_se(sd_bus_message_append(m, "(ssssssouso)",
+                                                        units[0], units[1], units[2], units[3], units[4], units[5],
+                                                        units[6], (uint32_t) 0, units[5], "/") >= 0);
+                assert_se(sd_bus_message_close_container(m) >= 0);
+        } else
+                assert_not_reached("Unknown signature");
+}
+
+static void benchmark_marshal(sd_bus *bus, const char *signature) {
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *sealed = NULL;
+        usec_t start;
+        uint64_t n;
+
+        BENCHMARK_LOOP(n, start) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                assert_se(sd_bus_message_new_signal(bus, &m, "/org/test/unit", "org.test.Unit", "Changed") >= 0);
+                append_signature(m, signature);
+                assert_se(sd_bus_message_seal(m, n + 1, 0) >= 0);
+        }
+        report("marshal", signature, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+
+        assert_se(sd_bus_message_new_signal(bus, &sealed, "/org/test/unit", "org.test.Unit", "Changed") >= 0);
+        append_signature(sealed, signature);
+        assert_se(sd_bus_message_seal(sealed, 1, 0) >= 0);
+
+        BENCHMARK_LOOP(n, start) {
+                assert_se(sd_bus_message_rewind(sealed, true) >= 0);
+                assert_se(sd_bus_message_skip(sealed, NULL) >= 0);
+        }
+        report("demarshal", signature, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+}
+
+static void benchmark_match_run(sd_bus *bus, const char *kind, unsigned n_matches) {
+        struct bus_match_node root = {
+                .type = BUS_MATCH_ROOT,
+        };
+        _cleanup_free_ sd_bus_slot *slots = NULL;
+        _cleanup_free_ char *parameter = NULL;
+        usec_t start;
+        uint64_t n;
+
+        assert_se(slots = new0(sd_bus_slot, n_matches));
+
+        for (unsigned i = 0; i < n_matches; i++) {
+                struct bus_match_component *components;
+                unsigned n_components;
+                _cleanup_free_ char *match = NULL;
+
+                if (streq(kind, "member"))
+                        assert_se(asprintf(&match, "type='signal',member='Member%u'", i) >= 0);
+                else
+                        assert_se(asprintf(&match, "type='signal',path_namespace='/org/test/unit/u%u'", i) >= 0);
+
+                assert_se(bus_match_parse(match, &components, &n_components) >= 0);
+
+                slots[i].match_callback.callback = count_filter;
+                assert_se(bus_match_add(&root, components, n_components, &slots[i].match_callback) >= 0);
+                bus_match_parse_free(components, n_components);
+        }
+
+        n_called = 0;
+
+        BENCHMARK_LOOP(n, start) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+                char member[STRLEN("Member") + DECIMAL_STR_MAX(unsigned)],
+                        path[STRLEN("/org/test/unit/u/job") + DECIMAL_STR_MAX(unsigned)];
+                unsigned i = n % n_matches;
+
+                xsprintf(member, "Member%u", i);
+                xsprintf(path, "/org/test/unit/u%u/job", i);
+                assert_se(sd_bus_message_new_signal(bus, &m, path, "org.test.Unit", member) >= 0);
+                assert_se(sd_bus_message_seal(m, 1, 0) >= 0);
+
+                assert_se(bus_match_run(NULL, &root, m) == 0);
+        }
+
+        assert_se(n_called == n);
+
+        assert_se(asprintf(&parameter, "%s,%u", kind, n_matches) >= 0);
+        report("match-run", parameter, n, usec_sub_unsigned(now(CLOCK_MONOTONIC), start));
+
+        bus_match_free(&root);
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(sd_bus_flush_close_unrefp) sd_bus *server = NULL, *client = NULL;
+        const char *signature;
+
+        if (argc > 1)
+                assert_se(parse_sec(argv[1], &arg_loop_usec) >= 0);
+        assert_se(arg_loop_usec > 0);
+
+        benchmark_direct();
+        benchmark_broker();
+
+        FOREACH_STRING(signature, "s", "sa{sv}as", "a(ssssssouso)") {
+                make_pair(&server, &client);
+                benchmark_marshal(client, signature);
+                server = sd_bus_flush_close_unref(server);
+                client = sd_bus_flush_close_unref(client);
+        }
+
+        for (unsigned n = 1; n <= 1000; n *= 10)
+                benchmark_fan_out(n);
+
+        make_pair(&server, &client);
+        for (unsigned n = 10; n <= 100000; n *= 10) {
+                benchmark_match_run(client, "member", n);
+                benchmark_match_run(client, "path_namespace", n);
+        }
+
+        return 0;
+}
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "sd-bus.h"
+
+#include "bus-internal.h"
+#include "fd-util.h"
+#include "log.h"
+#include "macro.h"
+#include "memfd-util.h"
+#include "tests.h"
+
+#define N_MESSAGES 20000U
+
+static void test_queued_messages(bool use_fds) {
+        _cleanup_(sd_bus_close_unrefp) sd_bus *client = NULL, *server = NULL;
+        char padding[1024];
+        int pair[2];
+        unsigned n_received = 0;
+
+        log_info("/* %s(%s) */", __func__, yes_no(use_fds));
+
+        /* Queue up many more messages than fit into the socket buffer, some of them with fds, and make sure
+         * they all arrive in order, with the right fds attached, no matter how the writes get batched and
+         * the reads look ahead. */
+
+        memset(padding, 'x', sizeof(padding) - 1);
+        padding[sizeof(padding) - 1] = 0;
+
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, SD_ID128_MAKE(70,0a,04,f4,c5,7c,4f,b2,91,c7,5c,3a,1d,b8,6e,9b)) >= 0);
+        assert_se(sd_bus_negotiate_fds(server, use_fds) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_negotiate_fds(client, use_fds) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+
+        /* Finish the authentication first, so that both sides know whether fds may be passed */
+        while (sd_bus_is_ready(client) <= 0 || sd_bus_is_ready(server) <= 0) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        for (unsigned i = 0; i < N_MESSAGES; i++) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+
+                assert_se(sd_bus_message_new_signal(client, &m, "/test", "test.Queue", "Item") >= 0);
+                assert_se(sd_bus_message_append(m, "u", i) >= 0);
+
+                if (use_fds && i % 7 == 0) {
+                        _cleanup_close_ int fd = -1;
+
+                        /* Tag each fd by the size of the memfd it refers to */
+                        assert_se((fd = memfd_new("test-bus-socket")) >= 0);
+                        assert_se(memfd_set_size(fd, i) >= 0);
+                        assert_se(sd_bus_message_append(m, "h", fd) >= 0);
+                }
+
+                /* Vary the size a bit */
+                assert_se(sd_bus_message_append(m, "s", padding + i % sizeof(padding)) >= 0);
+
+                assert_se(sd_bus_send(client, m, NULL) >= 0);
+        }
+
+        /* The socket buffer can't take all of this, so some must be waiting in the write queue */
+        assert_se(client->wqueue_size > 1);
+
+        while (n_received < N_MESSAGES) {
+                _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
+                const char *s;
+                uint32_t u;
+                int r;
+
+                r = sd_bus_process(client, NULL);
+                assert_se(r >= 0);
+
+                r = sd_bus_process(server, &m);
+                assert_se(r >= 0);
+                if (!m) {
+                        if (r == 0)
+                                assert_se(sd_bus_wait(server, USEC_PER_SEC) >= 0);
+                        continue;
+                }
+
+                if (!sd_bus_message_is_signal(m, "test.Queue", "Item"))
+                        continue;
+
+                assert_se(sd_bus_message_read(m, "u", &u) >= 0);
+                assert_se(u == n_received);
+
+                if (use_fds && u % 7 == 0) {
+                        struct stat st;
+                        int fd;
+
+                        assert_se(sd_bus_message_read(m, "h", &fd) >= 0);
+                        assert_se(fstat(fd, &st) >= 0);
+                        assert_se((unsigned) st.st_size == u);
+                }
+
+                assert_se(sd_bus_message_read(m, "s", &s) >= 0);
+                assert_se(sd_bus_message_at_end(m, true) > 0);
+
+                n_received++;
+        }
+
+        assert_se(client->wqueue_size == 0);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_INFO);
+
+        test_queued_messages(false);
+        test_queued_messages(true);
+
+        return 0;
+}
@@ -391,6 +391,11 @@ static int enumerator_scan_dir_and_add_devices(sd_device_enumerator *enumerator,
                         continue;
                 }
 
+                /* Do the checks that only need the syspath first, before the udev database and the uevent
+                 * file of the device are read. */
+                if (!device_match_parent(device, enumerator->match_parent, NULL))
+                        continue;
+
                 initialized = sd_device_get_is_initialized(device);
                 if (initialized < 0) {
                         if (initialized != -ENOENT)
@@ -416,9 +421,6 @@ static int enumerator_scan_dir_and_add_devices(sd_device_enumerator *enumerator,
                      sd_device_get_ifindex(device, NULL) >= 0))
                         continue;
 
-                if (!device_match_parent(device, enumerator->match_parent, NULL))
-                        continue;
-
                 if (!match_tag(enumerator, device))
                         continue;
 
@@ -526,6 +528,10 @@ static int enumerator_scan_devices_tag(sd_device_enumerator *enumerator, const c
                         continue;
                 }
 
+                /* Cheap, only looks at the syspath */
+                if (!device_match_parent(device, enumerator->match_parent, NULL))
+                        continue;
+
                 k = sd_device_get_subsystem(device, &subsystem);
                 if (k < 0) {
                         if (k != -ENOENT)
@@ -546,9 +552,6 @@ static int enumerator_scan_devices_tag(sd_device_enumerator *enumerator, const c
                 if (!match_sysname(enumerator, sysname))
                         continue;
 
-                if (!device_match_parent(device, enumerator->match_parent, NULL))
-                        continue;
-
                 if (!match_property(enumerator, device))
                         continue;
 
@@ -719,7 +722,8 @@ static void device_enumerator_dedup_devices(sd_device_enumerator *enumerator) {
                 assert_se(sd_device_get_devpath(*a, &devpath_a) >= 0);
                 assert_se(sd_device_get_devpath(*b, &devpath_b) >= 0);
 
-                if (path_equal(devpath_a, devpath_b))
+                /* devpaths are always normalized, hence a plain string comparison is sufficient */
+                if (streq(devpath_a, devpath_b))
                         sd_device_unref(*a);
                 else
                         *(++b) = *a;
@@ -51,6 +51,9 @@ struct sd_device_monitor {
 
 #define UDEV_MONITOR_MAGIC                0xfeedcafe
 
+/* The maximum number of uevents processed per event loop wakeup */
+#define DEVICE_MONITOR_RECEIVE_BATCH_MAX  32U
+
 typedef struct monitor_netlink_header {
         /* "libudev" prefix to distinguish libudev and kernel messages */
         char prefix[8];
@@ -225,17 +228,39 @@ _public_ int sd_device_monitor_stop(sd_device_monitor *m) {
         return 0;
 }
 
+static int device_monitor_receive_device_full(sd_device_monitor *m, int flags, bool *ret_received, sd_device **ret);
+
 static int device_monitor_event_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
-        _cleanup_(sd_device_unrefp) sd_device *device = NULL;
+        _cleanup_(sd_device_monitor_unrefp) sd_device_monitor *ref = NULL;
         sd_device_monitor *m = userdata;
+        int r;
 
         assert(m);
 
-        if (device_monitor_receive_device(m, &device) <= 0)
-                return 0;
+        /* During coldplug or device storms many uevents are queued at once. Process a bunch of them per
+         * wakeup, instead of going through the event loop for each of them. The callback might stop or
+         * drop the monitor, hence keep a reference and check after each device. */
+        ref = sd_device_monitor_ref(m);
+
+        for (unsigned i = 0; i < DEVICE_MONITOR_RECEIVE_BATCH_MAX; i++) {
+                _cleanup_(sd_device_unrefp) sd_device *device = NULL;
+                bool received;
+
+                r = device_monitor_receive_device_full(m, i > 0 ? MSG_DONTWAIT : 0, &received, &device);
+                if (!received)
+                        break;
+                if (r <= 0)
+                        continue;
+
+                if (m->callback) {
+                        r = m->callback(m, device, m->userdata);
+                        if (r < 0)
+                                return r;
+                }
 
-        if (m->callback)
-                return m->callback(m, device, m->userdata);
+                if (!m->event_source || m->sock < 0)
+                        break;
+        }
 
         return 0;
 }
@@ -414,7 +439,7 @@ static int passes_filter(sd_device_monitor *m, sd_device *device) {
         return device_match_parent(device, m->match_parent_filter, m->nomatch_parent_filter);
 }
 
-int device_monitor_receive_device(sd_device_monitor *m, sd_device **ret) {
+static int device_monitor_receive_device_full(sd_device_monitor *m, int flags, bool *ret_received, sd_device **ret) {
         _cleanup_(sd_device_unrefp) sd_device *device = NULL;
         union {
                 monitor_netlink_header nlh;
@@ -441,15 +466,22 @@ int device_monitor_receive_device(sd_device_monitor *m, sd_device **ret) {
         int r;
 
         assert(m);
+        assert(ret_received);
         assert(ret);
 
-        buflen = recvmsg(m->sock, &smsg, 0);
+        /* Note that most errors below are reported as -EAGAIN, for messages that are ignored. Hence
+         * ret_received tells whether a message was taken from the socket at all. */
+        *ret_received = false;
+
+        buflen = recvmsg(m->sock, &smsg, flags);
         if (buflen < 0) {
-                if (errno != EINTR)
+                if (errno != EINTR && !(FLAGS_SET(flags, MSG_DONTWAIT) && errno == EAGAIN))
                         log_debug_errno(errno, "sd-device-monitor: Failed to receive message: %m");
                 return -errno;
         }
 
+        *ret_received = true;
+
         if (buflen < 32 || (smsg.msg_flags & MSG_TRUNC))
                 return log_debug_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "sd-device-monitor: Invalid message length.");
@@ -526,6 +558,12 @@ int device_monitor_receive_device(sd_device_monitor *m, sd_device **ret) {
         return r;
 }
 
+int device_monitor_receive_device(sd_device_monitor *m, sd_device **ret) {
+        bool received;
+
+        return device_monitor_receive_device_full(m, 0, &received, ret);
+}
+
 static uint32_t string_hash32(const char *str) {
         return MurmurHash2(str, strlen(str), 0);
 }
@@ -70,6 +70,14 @@ struct sd_event_source {
         uint64_t pending_iteration;
         uint64_t prepare_iteration;
 
+        /* Only maintained if event loop profiling is enabled via $SD_EVENT_PROFILE_DELAYS. Reset whenever
+         * the statistics are logged. */
+        usec_t pending_usec;
+        struct {
+                unsigned n_dispatch;
+                usec_t dispatch_usec, dispatch_max_usec, delay_max_usec;
+        } stats;
+
         sd_event_destroy_t destroy_callback;
 
         LIST_FIELDS(sd_event_source, sources);
@@ -88,6 +96,8 @@ struct sd_event_source {
                         uint32_t events;
                         uint32_t revents;
                         bool registered:1;
+                        bool registered_oneshot:1; /* whether it is registered with EPOLLONESHOT */
+                        bool disarmed:1; /* whether that EPOLLONESHOT registration fired since */
                         bool owned:1;
                 } io;
                 struct {
@@ -138,6 +138,7 @@ struct sd_event {
         bool need_process_child:1;
         bool watchdog:1;
         bool profile_delays:1;
+        bool batch_io:1;
 
         int exit_code;
 
@@ -405,8 +406,9 @@ _public_ int sd_event_new(sd_event** ret) {
         e->epoll_fd = fd_move_above_stdio(e->epoll_fd);
 
         if (secure_getenv("SD_EVENT_PROFILE_DELAYS")) {
-                log_debug("Event loop profiling enabled. Logarithmic histogram of event loop iterations in the range 2^0 … 2^63 us will be logged every 5s.");
+                log_debug("Event loop profiling enabled. Logarithmic histogram of event loop iterations in the range 2^0 … 2^63 us and per-source dispatch statistics will be logged every 5s.");
                 e->profile_delays = true;
+                e->last_log_usec = now(CLOCK_MONOTONIC);
         }
 
         *ret = e;
@@ -449,6 +451,8 @@ static void source_io_unregister(sd_event_source *s) {
                                 strna(s->description), event_source_type_to_string(s->type));
 
         s->io.registered = false;
+        s->io.registered_oneshot = false;
+        s->io.disarmed = false;
 }
 
 static int source_io_register(
@@ -467,10 +471,19 @@ static int source_io_register(
 
         if (epoll_ctl(s->event->epoll_fd,
                       s->io.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
-                      s->io.fd, &ev) < 0)
-                return -errno;
+                      s->io.fd, &ev) < 0) {
+                /* A disarmed registration might have been dropped by the kernel in the meantime, if the
+                 * fd was closed and reopened while the source was disabled. */
+                if (errno != ENOENT || !s->io.registered)
+                        return -errno;
+
+                if (epoll_ctl(s->event->epoll_fd, EPOLL_CTL_ADD, s->io.fd, &ev) < 0)
+                        return -errno;
+        }
 
         s->io.registered = true;
+        s->io.registered_oneshot = enabled == SD_EVENT_ONESHOT;
+        s->io.disarmed = false;
 
         return 0;
 }
@@ -1006,6 +1019,9 @@ static int source_set_pending(sd_event_source *s, bool b) {
         if (b) {
                 s->pending_iteration = s->event->iteration;
 
+                if (s->event->profile_delays)
+                        s->pending_usec = now(CLOCK_MONOTONIC);
+
                 r = prioq_put(s->event->pending, s, &s->pending_index);
                 if (r < 0) {
                         s->pending = false;
@@ -2130,8 +2146,9 @@ _public_ int sd_event_source_set_io_fd(sd_event_source *s, int fd) {
                 return 0;
 
         if (event_source_is_offline(s)) {
+                /* A disarmed oneshot registration of the old fd might still be around */
+                source_io_unregister(s);
                 s->io.fd = fd;
-                s->io.registered = false;
         } else {
                 int saved_fd;
 
@@ -2373,7 +2390,12 @@ static int event_source_offline(
         switch (s->type) {
 
         case SOURCE_IO:
-                source_io_unregister(s);
+                /* A oneshot registration that fired has been disarmed by the kernel already, and won't
+                 * report anything until it is re-armed with EPOLL_CTL_MOD. Keep it around then, so that
+                 * the common disable-on-dispatch and re-enable cycle of oneshot sources only costs a
+                 * single epoll_ctl() instead of a removal and a re-addition. */
+                if (!s->io.disarmed)
+                        source_io_unregister(s);
                 break;
 
         case SOURCE_SIGNAL:
@@ -2555,19 +2577,22 @@ _public_ int sd_event_source_get_time(sd_event_source *s, uint64_t *usec) {
 }
 
 _public_ int sd_event_source_set_time(sd_event_source *s, uint64_t usec) {
-        int r;
-
         assert_return(s, -EINVAL);
         assert_return(EVENT_SOURCE_IS_TIME(s->type), -EDOM);
         assert_return(s->event->state != SD_EVENT_FINISHED, -ESTALE);
         assert_return(!event_pid_changed(s->event), -ECHILD);
 
-        r = source_set_pending(s, false);
-        if (r < 0)
-                return r;
+        /* Timers are frequently restarted with the time they already have, there's no need to touch the
+         * prioqs in that case */
+        if (s->time.next == usec && !s->pending)
+                return 0;
 
         s->time.next = usec;
 
+        /* Unsetting the pending flag reorders the time prioqs already */
+        if (s->pending)
+                return source_set_pending(s, false);
+
         event_source_time_prioq_reshuffle(s);
         return 0;
 }
@@ -2601,23 +2626,23 @@ _public_ int sd_event_source_get_time_accuracy(sd_event_source *s, uint64_t *use
 }
 
 _public_ int sd_event_source_set_time_accuracy(sd_event_source *s, uint64_t usec) {
-        int r;
-
         assert_return(s, -EINVAL);
         assert_return(usec != UINT64_MAX, -EINVAL);
         assert_return(EVENT_SOURCE_IS_TIME(s->type), -EDOM);
         assert_return(s->event->state != SD_EVENT_FINISHED, -ESTALE);
         assert_return(!event_pid_changed(s->event), -ECHILD);
 
-        r = source_set_pending(s, false);
-        if (r < 0)
-                return r;
-
         if (usec == 0)
                 usec = DEFAULT_ACCURACY_USEC;
 
+        if (s->time.accuracy == usec && !s->pending)
+                return 0;
+
         s->time.accuracy = usec;
 
+        if (s->pending)
+                return source_set_pending(s, false);
+
         event_source_time_prioq_reshuffle(s);
         return 0;
 }
@@ -3037,6 +3062,10 @@ static int process_io(sd_event *e, sd_event_source *s, uint32_t revents) {
         else
                 s->io.revents = revents;
 
+        /* The kernel won't report this fd again until we re-arm it */
+        if (s->io.registered_oneshot)
+                s->io.disarmed = true;
+
         return source_set_pending(s, true);
 }
 
@@ -3099,11 +3128,10 @@ static int process_timer(
                 if (s->enabled == SD_EVENT_OFF || s->pending)
                         break;
 
+                /* This moves the source behind all other candidates in both prioqs */
                 r = source_set_pending(s, true);
                 if (r < 0)
                         return r;
-
-                event_source_time_prioq_reshuffle(s);
         }
 
         return 0;
@@ -3443,9 +3471,29 @@ static int process_inotify(sd_event *e) {
         return done;
 }
 
+static void source_update_stats(sd_event_source *s, usec_t start) {
+        usec_t end, d;
+
+        assert(s);
+
+        end = now(CLOCK_MONOTONIC);
+
+        d = usec_sub_unsigned(end, start);
+        s->stats.n_dispatch++;
+        s->stats.dispatch_usec = usec_add(s->stats.dispatch_usec, d);
+        s->stats.dispatch_max_usec = MAX(s->stats.dispatch_max_usec, d);
+
+        if (s->pending_usec > 0)
+                s->stats.delay_max_usec = MAX(s->stats.delay_max_usec, usec_sub_unsigned(start, s->pending_usec));
+
+        /* Defer and exit sources stay pending across dispatches, hence they are ready again right away */
+        s->pending_usec = s->pending || s->type == SOURCE_EXIT ? end : 0;
+}
+
 static int source_dispatch(sd_event_source *s) {
         _cleanup_(sd_event_unrefp) sd_event *saved_event = NULL;
         EventSourceType saved_type;
+        usec_t start = 0;
         int r = 0;
 
         assert(s);
@@ -3496,6 +3544,9 @@ static int source_dispatch(sd_event_source *s) {
                         return r;
         }
 
+        if (saved_event->profile_delays)
+                start = now(CLOCK_MONOTONIC);
+
         s->dispatching = true;
 
         switch (s->type) {
@@ -3574,6 +3625,9 @@ static int source_dispatch(sd_event_source *s) {
 
         s->dispatching = false;
 
+        if (start > 0)
+                source_update_stats(s, start);
+
         if (r < 0) {
                 log_debug_errno(r, "Event source %s (type %s) returned error, %s: %m",
                                 strna(s->description),
@@ -4073,9 +4127,26 @@ _public_ int sd_event_dispatch(sd_event *e) {
         p = event_next_pending(e);
         if (p) {
                 _unused_ _cleanup_(sd_event_unrefp) sd_event *ref = sd_event_ref(e);
+                EventSourceType type = p->type;
+                int64_t priority = p->priority;
 
                 e->state = SD_EVENT_RUNNING;
                 r = source_dispatch(p);
+
+                /* In batch mode, dispatch all other IO sources of the same priority that are pending
+                 * already right away, instead of going through a whole new iteration for each of
+                 * them. Their pending flag is reset when they are dispatched, hence each of them is
+                 * dispatched at most once here. Anything of a different priority or type that became
+                 * pending in the meantime ends the batch, so that it is dispatched in order as usual. */
+                if (e->batch_io && type == SOURCE_IO)
+                        while (r >= 0 && !e->exit_requested) {
+                                p = event_next_pending(e);
+                                if (!p || p->type != SOURCE_IO || p->priority != priority)
+                                        break;
+
+                                r = source_dispatch(p);
+                        }
+
                 e->state = SD_EVENT_INITIAL;
                 return r;
         }
@@ -4087,6 +4158,7 @@ _public_ int sd_event_dispatch(sd_event *e) {
 
 static void event_log_delays(sd_event *e) {
         char b[ELEMENTSOF(e->delays) * DECIMAL_STR_MAX(unsigned) + 1], *p;
+        sd_event_source *s;
         size_t l, i;
 
         p = b;
@@ -4096,6 +4168,23 @@ static void event_log_delays(sd_event *e) {
                 e->delays[i] = 0;
         }
         log_debug("Event loop iterations: %s", b);
+
+        LIST_FOREACH(sources, s, e->sources) {
+                char t[FORMAT_TIMESPAN_MAX], m[FORMAT_TIMESPAN_MAX], d[FORMAT_TIMESPAN_MAX];
+
+                if (s->stats.n_dispatch == 0)
+                        continue;
+
+                log_debug("Event source %s (type %s): %u dispatches, %s total, %s max, %s max delay",
+                          strna(s->description),
+                          event_source_type_to_string(s->type),
+                          s->stats.n_dispatch,
+                          format_timespan(t, sizeof(t), s->stats.dispatch_usec, 1),
+                          format_timespan(m, sizeof(m), s->stats.dispatch_max_usec, 1),
+                          format_timespan(d, sizeof(d), s->stats.delay_max_usec, 1));
+
+                s->stats = (typeof(s->stats)) {};
+        }
 }
 
 _public_ int sd_event_run(sd_event *e, uint64_t timeout) {
@@ -4329,6 +4418,23 @@ _public_ int sd_event_get_watchdog(sd_event *e) {
         return e->watchdog;
 }
 
+_public_ int sd_event_set_batch_io(sd_event *e, int b) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        e->batch_io = b;
+        return e->batch_io;
+}
+
+_public_ int sd_event_get_batch_io(sd_event *e) {
+        assert_return(e, -EINVAL);
+        assert_return(e = event_resolve(e), -ENOPKG);
+        assert_return(!event_pid_changed(e), -ECHILD);
+
+        return e->batch_io;
+}
+
 _public_ int sd_event_get_iteration(sd_event *e, uint64_t *ret) {
         assert_return(e, -EINVAL);
         assert_return(e = event_resolve(e), -ENOPKG);
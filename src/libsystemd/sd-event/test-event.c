@@ -5,6 +5,7 @@
 #include "sd-event.h"
 
 #include "alloc-util.h"
+#include "event-source.h"
 #include "fd-util.h"
 #include "fs-util.h"
 #include "log.h"
@@ -712,6 +713,173 @@ static void test_simple_timeout(void) {
         assert_se(t >= usec_add(f, some_time));
 }
 
+static int oneshot_io_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        unsigned *c = (unsigned*) userdata;
+
+        assert_se(sd_event_source_get_enabled(s, NULL) == 0);
+
+        *c += 1;
+        if (*c % 2 == 0)
+                assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+
+        return 0;
+}
+
+static void test_oneshot_io(void) {
+        _cleanup_close_pair_ int p[2] = {-1, -1}, q[2] = {-1, -1};
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+        unsigned count = 0;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(pipe2(p, O_CLOEXEC|O_NONBLOCK) >= 0);
+        assert_se(pipe2(q, O_CLOEXEC|O_NONBLOCK) >= 0);
+
+        assert_se(sd_event_add_io(e, &s, p[0], EPOLLIN, oneshot_io_handler, &count) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+
+        /* The pipe stays readable, so the source has to fire again every time it is re-enabled, no
+         * matter whether that happens from the handler or from outside */
+        assert_se(write(p[1], "1", 1) == 1);
+
+        for (unsigned i = 1; i <= 10; i++) {
+                assert_se(sd_event_run(e, 0) > 0);
+                assert_se(count == i);
+
+                if (i % 2 != 0)
+                        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+        }
+
+        /* Once disabled, it must stay quiet */
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_OFF) >= 0);
+        assert_se(sd_event_run(e, 0) == 0);
+        assert_se(count == 10);
+
+        /* Switching the fd of a disabled source must not leave the old fd behind */
+        assert_se(sd_event_source_set_io_fd(s, q[0]) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ONESHOT) >= 0);
+        assert_se(sd_event_run(e, 0) == 0);
+        assert_se(count == 10);
+
+        assert_se(write(q[1], "1", 1) == 1);
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == 11);
+}
+
+#define N_BATCH_PIPES 32
+
+static int batch_io_handler(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        unsigned *c = userdata;
+
+        *c += 1;
+        return 0;
+}
+
+static void benchmark_io_dispatch(sd_event *e, unsigned *count, bool batch) {
+        char buf[FORMAT_TIMESPAN_MAX];
+        usec_t start, elapsed;
+
+        assert_se(sd_event_set_batch_io(e, batch) == batch);
+
+        *count = 0;
+        start = now(CLOCK_MONOTONIC);
+        while (*count < 100000)
+                assert_se(sd_event_run(e, 0) > 0);
+        elapsed = now(CLOCK_MONOTONIC) - start;
+
+        log_info("IO dispatch %s batching: %u events in %s, %.0f events/s",
+                 batch ? "with" : "without", *count, format_timespan(buf, sizeof(buf), elapsed, 1),
+                 (double) *count * USEC_PER_SEC / MAX(elapsed, 1u));
+}
+
+static void test_batch_io(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        sd_event_source *sources[N_BATCH_PIPES + 1] = {};
+        int pipes[N_BATCH_PIPES + 1][2];
+        unsigned count = 0, low_count = 0;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(sd_event_get_batch_io(e) == 0);
+
+        /* All pipes stay readable, so all sources are pending in every iteration. The last one has a
+         * lower priority than the others. */
+        for (unsigned i = 0; i <= N_BATCH_PIPES; i++) {
+                assert_se(pipe2(pipes[i], O_CLOEXEC|O_NONBLOCK) >= 0);
+                assert_se(write(pipes[i][1], "x", 1) == 1);
+
+                assert_se(sd_event_add_io(e, sources + i, pipes[i][0], EPOLLIN, batch_io_handler,
+                                          i < N_BATCH_PIPES ? &count : &low_count) >= 0);
+                if (i == N_BATCH_PIPES)
+                        assert_se(sd_event_source_set_priority(sources[i], 10) >= 0);
+        }
+
+        /* Without batching, every iteration dispatches a single source */
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == 1);
+
+        /* With it, all sources of the same priority are dispatched in one go, but nothing else */
+        assert_se(sd_event_set_batch_io(e, true) == 1);
+        assert_se(sd_event_get_batch_io(e) == 1);
+        count = 0;
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == N_BATCH_PIPES);
+        assert_se(low_count == 0);
+
+        /* Rate limits still apply to each source */
+        assert_se(sd_event_source_set_ratelimit(sources[0], 60 * USEC_PER_SEC, 1) >= 0);
+        count = 0;
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == N_BATCH_PIPES);
+        assert_se(sd_event_run(e, 0) > 0);
+        assert_se(count == N_BATCH_PIPES * 2 - 1);
+        assert_se(sd_event_source_is_ratelimited(sources[0]) > 0);
+        assert_se(sd_event_source_set_ratelimit(sources[0], 0, 0) >= 0);
+
+        if (slow_tests_enabled()) {
+                benchmark_io_dispatch(e, &count, false);
+                benchmark_io_dispatch(e, &count, true);
+        }
+
+        for (unsigned i = 0; i <= N_BATCH_PIPES; i++) {
+                sd_event_source_unref(sources[i]);
+                safe_close_pair(pipes[i]);
+        }
+}
+
+static int slow_defer_handler(sd_event_source *s, void *userdata) {
+        assert_se(usleep(2 * USEC_PER_MSEC) >= 0);
+        return 0;
+}
+
+static void test_profile_stats(void) {
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        _cleanup_(sd_event_source_unrefp) sd_event_source *s = NULL;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(setenv("SD_EVENT_PROFILE_DELAYS", "1", 1) >= 0);
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(unsetenv("SD_EVENT_PROFILE_DELAYS") >= 0);
+
+        assert_se(sd_event_add_defer(e, &s, slow_defer_handler, NULL) >= 0);
+        assert_se(sd_event_source_set_enabled(s, SD_EVENT_ON) >= 0);
+
+        /* The source is ready from the start, so this is queueing delay */
+        assert_se(usleep(USEC_PER_MSEC) >= 0);
+
+        for (unsigned i = 0; i < 3; i++)
+                assert_se(sd_event_run(e, 0) > 0);
+
+        assert_se(s->stats.n_dispatch == 3);
+        assert_se(s->stats.dispatch_max_usec >= 2 * USEC_PER_MSEC);
+        assert_se(s->stats.dispatch_usec >= 6 * USEC_PER_MSEC);
+        assert_se(s->stats.delay_max_usec >= USEC_PER_MSEC);
+}
+
 int main(int argc, char *argv[]) {
         test_setup_logging(LOG_DEBUG);
 
@@ -730,5 +898,11 @@ int main(int argc, char *argv[]) {
 
         test_ratelimit();
 
+        test_oneshot_io();
+
+        test_batch_io();
+
+        test_profile_stats();
+
         return 0;
 }
@@ -20,6 +20,7 @@ struct sd_hwdb {
         };
 
         OrderedHashmap *properties;
+        char *properties_modalias; /* the modalias the properties were looked up for, if complete */
         Iterator properties_iterator;
         bool properties_modified;
 };
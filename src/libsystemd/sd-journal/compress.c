@@ -1,7 +1,9 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <inttypes.h>
+#include <limits.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -18,6 +20,7 @@
 #endif
 
 #if HAVE_ZSTD
+#include <zdict.h>
 #include <zstd.h>
 #include <zstd_errors.h>
 #endif
@@ -53,6 +56,171 @@ static int zstd_ret_to_errno(size_t ret) {
                 return -EBADMSG;
         }
 }
+
+/* Upper bound on the number of threads compress_stream_zstd() compresses with */
+#define ZSTD_STREAM_WORKERS_MAX 4U
+
+static unsigned zstd_stream_workers(void) {
+        long n;
+
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+        if (n <= 0)
+                return 1;
+
+        return MIN((unsigned) n, ZSTD_STREAM_WORKERS_MAX);
+}
+#endif
+
+struct ZstdDictionary {
+        uint32_t id;
+#if HAVE_ZSTD
+        ZSTD_CDict *cdict;
+        ZSTD_DDict *ddict;
+
+        /* Compression and decompression contexts are reused across calls, since setting them up is
+         * comparatively expensive for the small objects dictionaries are meant for */
+        ZSTD_CCtx *cctx;
+        ZSTD_DCtx *dctx;
+#endif
+};
+
+#if HAVE_XZ || HAVE_ZSTD
+/* Codec state is expensive to set up compared to the small blobs we usually deal with, hence keep one
+ * instance of each around per thread and reuse it for all blob operations. The state is registered with a
+ * thread-specific key, so that it is released when the thread exits. */
+typedef struct CodecCache {
+#if HAVE_XZ
+        lzma_stream xz_encoder;
+        lzma_stream xz_decoder;
+#endif
+#if HAVE_ZSTD
+        ZSTD_CCtx *zstd_cctx;
+        ZSTD_DCtx *zstd_dctx;
+#endif
+} CodecCache;
+
+static pthread_key_t codec_cache_key;
+static bool codec_cache_key_initialized = false;
+static thread_local CodecCache *codec_cache = NULL;
+
+static void codec_cache_free(void *p) {
+        CodecCache *c = p;
+
+        if (!c)
+                return;
+
+        /* Called from the exiting thread, make sure a later user in that thread doesn't see a stale
+         * pointer */
+        if (c == codec_cache)
+                codec_cache = NULL;
+
+#if HAVE_XZ
+        lzma_end(&c->xz_encoder);
+        lzma_end(&c->xz_decoder);
+#endif
+#if HAVE_ZSTD
+        ZSTD_freeCCtx(c->zstd_cctx);
+        ZSTD_freeDCtx(c->zstd_dctx);
+#endif
+        free(c);
+}
+
+static void codec_cache_key_initialize(void) {
+        assert_se(pthread_key_create(&codec_cache_key, codec_cache_free) == 0);
+        codec_cache_key_initialized = true;
+}
+
+static CodecCache* codec_cache_get(void) {
+        static pthread_once_t once = PTHREAD_ONCE_INIT;
+        CodecCache *c;
+
+        if (codec_cache)
+                return codec_cache;
+
+        assert_se(pthread_once(&once, codec_cache_key_initialize) == 0);
+
+        c = new0(CodecCache, 1);
+        if (!c)
+                return NULL;
+
+#if HAVE_XZ
+        c->xz_encoder = c->xz_decoder = (lzma_stream) LZMA_STREAM_INIT;
+#endif
+
+        if (pthread_setspecific(codec_cache_key, c) != 0) {
+                free(c);
+                return NULL;
+        }
+
+        return (codec_cache = c);
+}
+
+_destructor_ static void codec_cache_key_done(void) {
+        /* Release the cache of the thread that unloads us (usually the main thread on exit), and make sure
+         * the destructor is not called for other threads once our code might be gone. */
+        if (!codec_cache_key_initialized)
+                return;
+
+        (void) pthread_setspecific(codec_cache_key, NULL);
+        codec_cache_free(codec_cache);
+        (void) pthread_key_delete(codec_cache_key);
+}
+#endif
+
+#if HAVE_ZSTD
+static ZSTD_CCtx* zstd_cctx_get(void) {
+        CodecCache *c;
+
+        c = codec_cache_get();
+        if (!c)
+                return NULL;
+
+        if (!c->zstd_cctx)
+                c->zstd_cctx = ZSTD_createCCtx();
+
+        return c->zstd_cctx;
+}
+
+static int zstd_dctx_get(ZstdDictionary *d, ZSTD_DCtx **ret) {
+        ZSTD_DCtx *dctx;
+        size_t k;
+
+        assert(ret);
+
+        if (d)
+                dctx = d->dctx;
+        else {
+                CodecCache *c;
+
+                c = codec_cache_get();
+                if (!c)
+                        return -ENOMEM;
+
+                if (!c->zstd_dctx) {
+                        c->zstd_dctx = ZSTD_createDCtx();
+                        if (!c->zstd_dctx)
+                                return -ENOMEM;
+                }
+
+                dctx = c->zstd_dctx;
+        }
+
+        /* A previous user might have bailed out in the middle of a frame, start from scratch */
+        k = ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+        if (ZSTD_isError(k))
+                return zstd_ret_to_errno(k);
+
+        /* Frames compressed without a dictionary decode fine with one referenced, hence we can use the
+         * dictionary's context for all objects of a file that carries a dictionary. */
+        if (d) {
+                k = ZSTD_DCtx_refDDict(dctx, d->ddict);
+                if (ZSTD_isError(k))
+                        return zstd_ret_to_errno(k);
+        }
+
+        *ret = dctx;
+        return 0;
+}
 #endif
 
 #define ALIGN_8(l) ALIGN_TO(l, sizeof(size_t))
@@ -78,8 +246,8 @@ int compress_blob_xz(const void *src, uint64_t src_size,
                 { LZMA_FILTER_LZMA2, (lzma_options_lzma*) &opt },
                 { LZMA_VLI_UNKNOWN, NULL }
         };
+        CodecCache *c;
         lzma_ret ret;
-        size_t out_pos = 0;
 
         assert(src);
         assert(src_size > 0);
@@ -93,12 +261,25 @@ int compress_blob_xz(const void *src, uint64_t src_size,
         if (src_size < 80)
                 return -ENOBUFS;
 
-        ret = lzma_stream_buffer_encode((lzma_filter*) filters, LZMA_CHECK_NONE, NULL,
-                                        src, src_size, dst, &out_pos, dst_alloc_size);
+        c = codec_cache_get();
+        if (!c)
+                return -ENOMEM;
+
+        /* Reinitializing an encoder reuses the memory allocated for the previous one */
+        ret = lzma_stream_encoder(&c->xz_encoder, filters, LZMA_CHECK_NONE);
         if (ret != LZMA_OK)
+                return -ENOMEM;
+
+        c->xz_encoder.next_in = src;
+        c->xz_encoder.avail_in = src_size;
+        c->xz_encoder.next_out = dst;
+        c->xz_encoder.avail_out = dst_alloc_size;
+
+        ret = lzma_code(&c->xz_encoder, LZMA_FINISH);
+        if (ret != LZMA_STREAM_END)
                 return -ENOBUFS;
 
-        *dst_size = out_pos;
+        *dst_size = dst_alloc_size - c->xz_encoder.avail_out;
         return 0;
 #else
         return -EPROTONOSUPPORT;
@@ -138,6 +319,107 @@ int compress_blob_lz4(const void *src, uint64_t src_size,
 int compress_blob_zstd(
                 const void *src, uint64_t src_size,
                 void *dst, size_t dst_alloc_size, size_t *dst_size) {
+
+        return compress_blob_zstd_with_dict(NULL, src, src_size, dst, dst_alloc_size, dst_size);
+}
+
+int zstd_dictionary_train(
+                const void *samples,
+                const size_t *sample_sizes,
+                size_t n_samples,
+                size_t dict_max_size,
+                void **ret,
+                size_t *ret_size) {
+#if HAVE_ZSTD
+        _cleanup_free_ void *buf = NULL;
+        size_t k;
+
+        assert(samples);
+        assert(sample_sizes);
+        assert(dict_max_size > 0);
+        assert(ret);
+        assert(ret_size);
+
+        if (n_samples > UINT_MAX)
+                return -E2BIG;
+
+        buf = malloc(dict_max_size);
+        if (!buf)
+                return -ENOMEM;
+
+        k = ZDICT_trainFromBuffer(buf, dict_max_size, samples, sample_sizes, (unsigned) n_samples);
+        if (ZDICT_isError(k)) {
+                log_debug("Failed to train ZSTD dictionary: %s", ZDICT_getErrorName(k));
+                return zstd_ret_to_errno(k);
+        }
+
+        *ret = TAKE_PTR(buf);
+        *ret_size = k;
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+int zstd_dictionary_new(const void *data, size_t size, ZstdDictionary **ret) {
+#if HAVE_ZSTD
+        _cleanup_(zstd_dictionary_freep) ZstdDictionary *d = NULL;
+        uint32_t id;
+
+        assert(data);
+        assert(size > 0);
+        assert(ret);
+
+        /* Raw content dictionaries have no ID, and frames compressed with them can't be told apart from
+         * frames compressed without a dictionary. Only accept properly trained dictionaries. */
+        id = ZSTD_getDictID_fromDict(data, size);
+        if (id == 0)
+                return -EBADMSG;
+
+        d = new0(ZstdDictionary, 1);
+        if (!d)
+                return -ENOMEM;
+
+        d->id = id;
+
+        d->cdict = ZSTD_createCDict(data, size, 0);
+        d->ddict = ZSTD_createDDict(data, size);
+        d->cctx = ZSTD_createCCtx();
+        d->dctx = ZSTD_createDCtx();
+        if (!d->cdict || !d->ddict || !d->cctx || !d->dctx)
+                return -ENOMEM;
+
+        *ret = TAKE_PTR(d);
+        return 0;
+#else
+        return -EPROTONOSUPPORT;
+#endif
+}
+
+ZstdDictionary* zstd_dictionary_free(ZstdDictionary *d) {
+        if (!d)
+                return NULL;
+
+#if HAVE_ZSTD
+        ZSTD_freeCDict(d->cdict);
+        ZSTD_freeDDict(d->ddict);
+        ZSTD_freeCCtx(d->cctx);
+        ZSTD_freeDCtx(d->dctx);
+#endif
+
+        return mfree(d);
+}
+
+uint32_t zstd_dictionary_get_id(const ZstdDictionary *d) {
+        assert(d);
+
+        return d->id;
+}
+
+int compress_blob_zstd_with_dict(
+                ZstdDictionary *d,
+                const void *src, uint64_t src_size,
+                void *dst, size_t dst_alloc_size, size_t *dst_size) {
 #if HAVE_ZSTD
         size_t k;
 
@@ -147,7 +429,17 @@ int compress_blob_zstd(
         assert(dst_alloc_size > 0);
         assert(dst_size);
 
-        k = ZSTD_compress(dst, dst_alloc_size, src, src_size, 0);
+        if (d)
+                k = ZSTD_compress_usingCDict(d->cctx, dst, dst_alloc_size, src, src_size, d->cdict);
+        else {
+                ZSTD_CCtx *cctx;
+
+                cctx = zstd_cctx_get();
+                if (!cctx)
+                        return -ENOMEM;
+
+                k = ZSTD_compressCCtx(cctx, dst, dst_alloc_size, src, src_size, 0);
+        }
         if (ZSTD_isError(k))
                 return zstd_ret_to_errno(k);
 
@@ -166,7 +458,8 @@ int decompress_blob_xz(
                 size_t dst_max) {
 
 #if HAVE_XZ
-        _cleanup_(lzma_end) lzma_stream s = LZMA_STREAM_INIT;
+        CodecCache *c;
+        lzma_stream *s;
         lzma_ret ret;
         size_t space;
 
@@ -175,7 +468,12 @@ int decompress_blob_xz(
         assert(dst);
         assert(dst_size);
 
-        ret = lzma_stream_decoder(&s, UINT64_MAX, 0);
+        c = codec_cache_get();
+        if (!c)
+                return -ENOMEM;
+        s = &c->xz_decoder;
+
+        ret = lzma_stream_decoder(s, UINT64_MAX, 0);
         if (ret != LZMA_OK)
                 return -ENOMEM;
 
@@ -183,37 +481,37 @@ int decompress_blob_xz(
         if (!greedy_realloc(dst, space, 1))
                 return -ENOMEM;
 
-        s.next_in = src;
-        s.avail_in = src_size;
+        s->next_in = src;
+        s->avail_in = src_size;
 
-        s.next_out = *dst;
-        s.avail_out = space;
+        s->next_out = *dst;
+        s->avail_out = space;
 
         for (;;) {
                 size_t used;
 
-                ret = lzma_code(&s, LZMA_FINISH);
+                ret = lzma_code(s, LZMA_FINISH);
 
                 if (ret == LZMA_STREAM_END)
                         break;
                 else if (ret != LZMA_OK)
                         return -ENOMEM;
 
-                if (dst_max > 0 && (space - s.avail_out) >= dst_max)
+                if (dst_max > 0 && (space - s->avail_out) >= dst_max)
                         break;
                 else if (dst_max > 0 && space == dst_max)
                         return -ENOBUFS;
 
-                used = space - s.avail_out;
+                used = space - s->avail_out;
                 space = MIN(2 * space, dst_max ?: SIZE_MAX);
                 if (!greedy_realloc(dst, space, 1))
                         return -ENOMEM;
 
-                s.avail_out = space - used;
-                s.next_out = *(uint8_t**)dst + used;
+                s->avail_out = space - used;
+                s->next_out = *(uint8_t**)dst + used;
         }
 
-        *dst_size = space - s.avail_out;
+        *dst_size = space - s->avail_out;
         return 0;
 #else
         return -EPROTONOSUPPORT;
@@ -264,8 +562,21 @@ int decompress_blob_zstd(
                 size_t *dst_size,
                 size_t dst_max) {
 
+        return decompress_blob_zstd_with_dict(NULL, src, src_size, dst, dst_size, dst_max);
+}
+
+int decompress_blob_zstd_with_dict(
+                ZstdDictionary *d,
+                const void *src,
+                uint64_t src_size,
+                void **dst,
+                size_t *dst_size,
+                size_t dst_max) {
+
 #if HAVE_ZSTD
+        ZSTD_DCtx *dctx;
         uint64_t size;
+        int r;
 
         assert(src);
         assert(src_size > 0);
@@ -284,9 +595,9 @@ int decompress_blob_zstd(
         if (!(greedy_realloc(dst, MAX(ZSTD_DStreamOutSize(), size), 1)))
                 return -ENOMEM;
 
-        _cleanup_(ZSTD_freeDCtxp) ZSTD_DCtx *dctx = ZSTD_createDCtx();
-        if (!dctx)
-                return -ENOMEM;
+        r = zstd_dctx_get(d, &dctx);
+        if (r < 0)
+                return r;
 
         ZSTD_inBuffer input = {
                 .src = src,
@@ -344,7 +655,8 @@ int decompress_startswith_xz(
                 uint8_t extra) {
 
 #if HAVE_XZ
-        _cleanup_(lzma_end) lzma_stream s = LZMA_STREAM_INIT;
+        CodecCache *c;
+        lzma_stream *s;
         size_t allocated;
         lzma_ret ret;
 
@@ -356,7 +668,12 @@ int decompress_startswith_xz(
         assert(buffer);
         assert(prefix);
 
-        ret = lzma_stream_decoder(&s, UINT64_MAX, 0);
+        c = codec_cache_get();
+        if (!c)
+                return -ENOMEM;
+        s = &c->xz_decoder;
+
+        ret = lzma_stream_decoder(s, UINT64_MAX, 0);
         if (ret != LZMA_OK)
                 return -EBADMSG;
 
@@ -365,32 +682,32 @@ int decompress_startswith_xz(
 
         allocated = MALLOC_SIZEOF_SAFE(*buffer);
 
-        s.next_in = src;
-        s.avail_in = src_size;
+        s->next_in = src;
+        s->avail_in = src_size;
 
-        s.next_out = *buffer;
-        s.avail_out = allocated;
+        s->next_out = *buffer;
+        s->avail_out = allocated;
 
         for (;;) {
-                ret = lzma_code(&s, LZMA_FINISH);
+                ret = lzma_code(s, LZMA_FINISH);
 
                 if (!IN_SET(ret, LZMA_OK, LZMA_STREAM_END))
                         return -EBADMSG;
 
-                if (allocated - s.avail_out >= prefix_len + 1)
+                if (allocated - s->avail_out >= prefix_len + 1)
                         return memcmp(*buffer, prefix, prefix_len) == 0 &&
                                 ((const uint8_t*) *buffer)[prefix_len] == extra;
 
                 if (ret == LZMA_STREAM_END)
                         return 0;
 
-                s.avail_out += allocated;
+                s->avail_out += allocated;
 
                 if (!(greedy_realloc(buffer, allocated * 2, 1)))
                         return -ENOMEM;
 
                 allocated = MALLOC_SIZEOF_SAFE(*buffer);
-                s.next_out = *(uint8_t**)buffer + allocated - s.avail_out;
+                s->next_out = *(uint8_t**)buffer + allocated - s->avail_out;
         }
 
 #else
@@ -474,7 +791,22 @@ int decompress_startswith_zstd(
                 const void *prefix,
                 size_t prefix_len,
                 uint8_t extra) {
+
+        return decompress_startswith_zstd_with_dict(NULL, src, src_size, buffer, prefix, prefix_len, extra);
+}
+
+int decompress_startswith_zstd_with_dict(
+                ZstdDictionary *d,
+                const void *src,
+                uint64_t src_size,
+                void **buffer,
+                const void *prefix,
+                size_t prefix_len,
+                uint8_t extra) {
 #if HAVE_ZSTD
+        ZSTD_DCtx *dctx;
+        int r;
+
         assert(src);
         assert(src_size > 0);
         assert(buffer);
@@ -487,9 +819,9 @@ int decompress_startswith_zstd(
         if (size < prefix_len + 1)
                 return 0; /* Decompressed text too short to match the prefix and extra */
 
-        _cleanup_(ZSTD_freeDCtxp) ZSTD_DCtx *dctx = ZSTD_createDCtx();
-        if (!dctx)
-                return -ENOMEM;
+        r = zstd_dctx_get(d, &dctx);
+        if (r < 0)
+                return r;
 
         if (!(greedy_realloc(buffer, MAX(ZSTD_DStreamOutSize(), prefix_len + 1), 1)))
                 return -ENOMEM;
@@ -875,6 +1207,14 @@ int compress_stream_zstd(int fdf, int fdt, uint64_t max_bytes, uint64_t *ret_unc
         if (ZSTD_isError(z))
                 log_debug("Failed to enable ZSTD checksum, ignoring: %s", ZSTD_getErrorName(z));
 
+        /* The streams compressed here are core dumps, which may be many GB in size. Hence, let zstd
+         * compress on a couple of worker threads, which also overlaps compression with our reading and
+         * writing. This fails if libzstd has been built without multi-threading support, in which case we
+         * simply compress synchronously. */
+        z = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, (int) zstd_stream_workers());
+        if (ZSTD_isError(z))
+                log_debug("Failed to enable ZSTD multi-threading, ignoring: %s", ZSTD_getErrorName(z));
+
         /* This loop read from the input file, compresses that entire chunk,
          * and writes all output produced to the output file.
          */
@@ -4,6 +4,7 @@
 #include <unistd.h>
 
 #include "journal-def.h"
+#include "macro.h"
 
 const char* object_compressed_to_string(int compression);
 int object_compressed_from_string(const char *compression);
@@ -15,6 +16,20 @@ int compress_blob_lz4(const void *src, uint64_t src_size,
 int compress_blob_zstd(const void *src, uint64_t src_size,
                        void *dst, size_t dst_alloc_size, size_t *dst_size);
 
+/* A trained zstd dictionary, with the digested compression and decompression state cached */
+typedef struct ZstdDictionary ZstdDictionary;
+
+int zstd_dictionary_train(const void *samples, const size_t *sample_sizes, size_t n_samples,
+                          size_t dict_max_size, void **ret, size_t *ret_size);
+int zstd_dictionary_new(const void *data, size_t size, ZstdDictionary **ret);
+ZstdDictionary* zstd_dictionary_free(ZstdDictionary *d);
+DEFINE_TRIVIAL_CLEANUP_FUNC(ZstdDictionary*, zstd_dictionary_free);
+uint32_t zstd_dictionary_get_id(const ZstdDictionary *d);
+
+int compress_blob_zstd_with_dict(ZstdDictionary *d,
+                                 const void *src, uint64_t src_size,
+                                 void *dst, size_t dst_alloc_size, size_t *dst_size);
+
 static inline int compress_blob(const void *src, uint64_t src_size,
                                 void *dst, size_t dst_alloc_size, size_t *dst_size) {
         int r;
@@ -42,6 +57,9 @@ int decompress_blob_lz4(const void *src, uint64_t src_size,
                         void **dst, size_t* dst_size, size_t dst_max);
 int decompress_blob_zstd(const void *src, uint64_t src_size,
                         void **dst, size_t* dst_size, size_t dst_max);
+int decompress_blob_zstd_with_dict(ZstdDictionary *d,
+                                   const void *src, uint64_t src_size,
+                                   void **dst, size_t* dst_size, size_t dst_max);
 int decompress_blob(int compression,
                     const void *src, uint64_t src_size,
                     void **dst, size_t* dst_size, size_t dst_max);
@@ -58,6 +76,11 @@ int decompress_startswith_zstd(const void *src, uint64_t src_size,
                                void **buffer,
                                const void *prefix, size_t prefix_len,
                                uint8_t extra);
+int decompress_startswith_zstd_with_dict(ZstdDictionary *d,
+                                         const void *src, uint64_t src_size,
+                                         void **buffer,
+                                         const void *prefix, size_t prefix_len,
+                                         uint8_t extra);
 int decompress_startswith(int compression,
                           const void *src, uint64_t src_size,
                           void **buffer,
@@ -266,9 +266,17 @@ int journal_file_hmac_put_object(JournalFile *f, ObjectType type, Object *o, uin
         case OBJECT_FIELD_HASH_TABLE:
         case OBJECT_DATA_HASH_TABLE:
         case OBJECT_ENTRY_ARRAY:
+        case OBJECT_DATA_BLOOM:
+        case OBJECT_REALTIME_INDEX:
                 /* Nothing: everything is mutable */
                 break;
 
+        case OBJECT_ZSTD_DICTIONARY:
+                /* All but the reserved field */
+                gcry_md_write(f->hmac, &o->zstd_dictionary.dictionary_id, sizeof(o->zstd_dictionary.dictionary_id));
+                gcry_md_write(f->hmac, o->zstd_dictionary.payload, le64toh(o->object.size) - offsetof(ZstdDictionaryObject, payload));
+                break;
+
         case OBJECT_TAG:
                 /* All but the tag itself */
                 gcry_md_write(f->hmac, &o->tag.seqnum, sizeof(o->tag.seqnum));
@@ -23,9 +23,12 @@ typedef struct EntryObject EntryObject;
 typedef struct HashTableObject HashTableObject;
 typedef struct EntryArrayObject EntryArrayObject;
 typedef struct TagObject TagObject;
+typedef struct DataBloomObject DataBloomObject;
+typedef struct RealtimeIndexObject RealtimeIndexObject;
+typedef struct ZstdDictionaryObject ZstdDictionaryObject;
 
-typedef struct EntryItem EntryItem;
 typedef struct HashItem HashItem;
+typedef struct RealtimeIndexItem RealtimeIndexItem;
 
 typedef struct FSSHeader FSSHeader;
 
@@ -39,6 +42,9 @@ typedef enum ObjectType {
         OBJECT_FIELD_HASH_TABLE,
         OBJECT_ENTRY_ARRAY,
         OBJECT_TAG,
+        OBJECT_DATA_BLOOM,
+        OBJECT_REALTIME_INDEX,
+        OBJECT_ZSTD_DICTIONARY,
         _OBJECT_TYPE_MAX
 } ObjectType;
 
@@ -86,19 +92,24 @@ struct FieldObject FieldObject__contents;
 struct FieldObject__packed FieldObject__contents _packed_;
 assert_cc(sizeof(struct FieldObject) == sizeof(struct FieldObject__packed));
 
-struct EntryItem {
-        le64_t object_offset;
-        le64_t hash;
-} _packed_;
-
-#define EntryObject__contents { \
-        ObjectHeader object;    \
-        le64_t seqnum;          \
-        le64_t realtime;        \
-        le64_t monotonic;       \
-        sd_id128_t boot_id;     \
-        le64_t xor_hash;        \
-        EntryItem items[];      \
+/* In compact journal files (HEADER_INCOMPATIBLE_COMPACT) all offsets fit in 32bit, and entry items do not carry
+ * a copy of the hash of the data object they reference. */
+#define EntryObject__contents {                 \
+        ObjectHeader object;                    \
+        le64_t seqnum;                          \
+        le64_t realtime;                        \
+        le64_t monotonic;                       \
+        sd_id128_t boot_id;                     \
+        le64_t xor_hash;                        \
+        union {                                 \
+                struct {                        \
+                        le64_t object_offset;   \
+                        le64_t hash;            \
+                } regular[0];                   \
+                struct {                        \
+                        le32_t object_offset;   \
+                } compact[0];                   \
+        } items;                                \
         }
 
 struct EntryObject EntryObject__contents;
@@ -118,7 +129,10 @@ struct HashTableObject {
 struct EntryArrayObject {
         ObjectHeader object;
         le64_t next_entry_array_offset;
-        le64_t items[];
+        union {
+                le64_t regular[0];
+                le32_t compact[0];
+        } items;
 } _packed_;
 
 #define TAG_LENGTH (256/8)
@@ -130,6 +144,40 @@ struct TagObject {
         uint8_t tag[TAG_LENGTH]; /* SHA-256 HMAC */
 } _packed_;
 
+/* A Bloom filter over the hashes of all DATA objects in the file, appended when the file is archived. Bit
+ * positions are derived from the 64bit DATA object hash via double hashing, see journal_file_data_bloom_bit(). */
+struct DataBloomObject {
+        ObjectHeader object;
+        le64_t n_items;
+        le32_t n_hashes;
+        le32_t reserved;
+        le64_t bits[];
+} _packed_;
+
+/* A sparse index of the main entry array chain, appended when the file is archived: one item per entry
+ * array, carrying the realtime timestamp of its first entry and the number of entries in all arrays before
+ * it. Allows realtime seeks to skip directly to the right array in the chain. */
+struct RealtimeIndexItem {
+        le64_t entry_array_offset;
+        le64_t first_entry_offset;
+        le64_t first_entry_realtime;
+        le64_t n_preceding;
+} _packed_;
+
+struct RealtimeIndexObject {
+        ObjectHeader object;
+        RealtimeIndexItem items[];
+} _packed_;
+
+/* A trained ZSTD dictionary, written right after the hash tables of a new file. ZSTD compressed DATA
+ * objects of the file may refer to it (HEADER_INCOMPATIBLE_ZSTD_DICTIONARY). */
+struct ZstdDictionaryObject {
+        ObjectHeader object;
+        le32_t dictionary_id;
+        le32_t reserved;
+        uint8_t payload[];
+} _packed_;
+
 union Object {
         ObjectHeader object;
         DataObject data;
@@ -138,6 +186,9 @@ union Object {
         HashTableObject hash_table;
         EntryArrayObject entry_array;
         TagObject tag;
+        DataBloomObject data_bloom;
+        RealtimeIndexObject realtime_index;
+        ZstdDictionaryObject zstd_dictionary;
 };
 
 enum {
@@ -153,30 +204,34 @@ enum {
         HEADER_INCOMPATIBLE_COMPRESSED_LZ4  = 1 << 1,
         HEADER_INCOMPATIBLE_KEYED_HASH      = 1 << 2,
         HEADER_INCOMPATIBLE_COMPRESSED_ZSTD = 1 << 3,
+        HEADER_INCOMPATIBLE_COMPACT         = 1 << 4,
+        HEADER_INCOMPATIBLE_ZSTD_DICTIONARY = 1 << 5,
 };
 
-#define HEADER_INCOMPATIBLE_ANY               \
-        (HEADER_INCOMPATIBLE_COMPRESSED_XZ |  \
-         HEADER_INCOMPATIBLE_COMPRESSED_LZ4 | \
-         HEADER_INCOMPATIBLE_KEYED_HASH |     \
-         HEADER_INCOMPATIBLE_COMPRESSED_ZSTD)
+#define HEADER_INCOMPATIBLE_ANY                \
+        (HEADER_INCOMPATIBLE_COMPRESSED_XZ |   \
+         HEADER_INCOMPATIBLE_COMPRESSED_LZ4 |  \
+         HEADER_INCOMPATIBLE_KEYED_HASH |      \
+         HEADER_INCOMPATIBLE_COMPRESSED_ZSTD | \
+         HEADER_INCOMPATIBLE_COMPACT |         \
+         HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
 
 #if HAVE_XZ && HAVE_LZ4 && HAVE_ZSTD
 #  define HEADER_INCOMPATIBLE_SUPPORTED HEADER_INCOMPATIBLE_ANY
 #elif HAVE_XZ && HAVE_LZ4
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT)
 #elif HAVE_XZ && HAVE_ZSTD
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT|HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
 #elif HAVE_LZ4 && HAVE_ZSTD
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT|HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
 #elif HAVE_XZ
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_XZ|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT)
 #elif HAVE_LZ4
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_LZ4|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT)
 #elif HAVE_ZSTD
-#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH)
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_COMPRESSED_ZSTD|HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT|HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
 #else
-#  define HEADER_INCOMPATIBLE_SUPPORTED HEADER_INCOMPATIBLE_KEYED_HASH
+#  define HEADER_INCOMPATIBLE_SUPPORTED (HEADER_INCOMPATIBLE_KEYED_HASH|HEADER_INCOMPATIBLE_COMPACT)
 #endif
 
 enum {
@@ -227,12 +282,16 @@ enum {
         /* Added in 246 */                              \
         le64_t data_hash_chain_depth;                   \
         le64_t field_hash_chain_depth;                  \
+        /* Added in 250 */                              \
+        le64_t data_bloom_offset;                       \
+        le64_t realtime_index_offset;                   \
+        le64_t zstd_dictionary_offset;                  \
         }
 
 struct Header struct_Header__contents;
 struct Header__packed struct_Header__contents _packed_;
 assert_cc(sizeof(struct Header) == sizeof(struct Header__packed));
-assert_cc(sizeof(struct Header) == 256);
+assert_cc(sizeof(struct Header) == 280);
 
 #define FSS_HEADER_SIGNATURE                                            \
         ((const char[]) { 'K', 'S', 'H', 'H', 'R', 'H', 'L', 'P' })
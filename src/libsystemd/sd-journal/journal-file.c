@@ -73,6 +73,9 @@
 /* How many entries to keep in the entry array chain cache at max */
 #define CHAIN_CACHE_MAX 20
 
+/* How many recently used DATA objects to remember when appending */
+#define DATA_CACHE_SIZE 256U
+
 /* How much to increase the journal file size at once each time we allocate something new. */
 #define FILE_SIZE_INCREASE (8 * 1024 * 1024ULL)          /* 8MB */
 
@@ -85,10 +88,89 @@
 /* Longest hash chain to rotate after */
 #define HASH_CHAIN_DEPTH_MAX 100
 
+/* Bloom filter parameters for archived files: 10 bits per DATA object and 7 hash functions for a false
+ * positive rate of about 1% */
+#define DATA_BLOOM_BITS_PER_ITEM 10
+#define DATA_BLOOM_N_HASHES 7
+#define DATA_BLOOM_N_HASHES_MAX 32
+
+/* ZSTD dictionaries are trained from the small DATA objects of the previous file. zstd suggests around 100x
+ * the dictionary size worth of samples; we don't bother with dictionaries smaller than 1K. Training happens
+ * synchronously when the file is rotated, i.e. on journald's main loop, and its cost grows with the amount
+ * of samples. Hence keep that small, and also limit how many objects we look at to collect them, so that
+ * large files with few small objects don't make us walk the whole file. */
+#define ZSTD_DICTIONARY_SIZE_MIN (1024U)
+#define ZSTD_DICTIONARY_SIZE_MAX (8U * 1024U)
+#define ZSTD_DICTIONARY_SAMPLE_SIZE_MAX (4U * 1024U)
+#define ZSTD_DICTIONARY_SAMPLES_MAX (1024U * 1024U)
+#define ZSTD_DICTIONARY_OBJECTS_MAX (64U * 1024U)
+
 #ifdef __clang__
 #  pragma GCC diagnostic ignored "-Waddress-of-packed-member"
 #endif
 
+/* Host-endian representation of an entry item, independent of whether the file is compact or not */
+typedef struct EntryItem {
+        uint64_t object_offset;
+        uint64_t hash;
+} EntryItem;
+
+/* Archived files are not written to anymore, hence it's a good time to add structures that speed up readers.
+ * This runs as part of offlining, i.e. usually in the offline thread, while the caller continues using the
+ * shared mmap cache for other files. The cache is not thread-safe, hence use a private one for the duration. */
+static void journal_file_archive_post_process(JournalFile *f) {
+        MMapCache *saved_mmap = f->mmap;
+        MMapFileDescriptor *saved_cache_fd = f->cache_fd;
+        HashItem *saved_data_hash_table = f->data_hash_table, *saved_field_hash_table = f->field_hash_table;
+        int r;
+
+        assert(f);
+        assert(f->archive);
+
+        f->cache_fd = NULL;
+        f->mmap = mmap_cache_new();
+        if (!f->mmap) {
+                log_oom_debug();
+                goto finish;
+        }
+
+        f->cache_fd = mmap_cache_add_fd(f->mmap, f->fd, PROT_READ|PROT_WRITE);
+        if (!f->cache_fd) {
+                log_oom_debug();
+                goto finish;
+        }
+
+        /* Make sure the hash tables are mapped via the private cache if we need them */
+        f->data_hash_table = f->field_hash_table = NULL;
+        f->post_processing = true;
+
+        /* Add a bloom filter for the data objects, so that readers can quickly rule out this file when
+         * looking for matches. */
+        r = journal_file_append_data_bloom(f);
+        if (r < 0)
+                log_debug_errno(r, "Failed to append data bloom filter to %s, ignoring: %m", f->path);
+
+        /* Similar, add a sparse index for seeking by realtime */
+        r = journal_file_append_realtime_index(f);
+        if (r < 0)
+                log_debug_errno(r, "Failed to append realtime index to %s, ignoring: %m", f->path);
+
+        if (mmap_cache_got_sigbus(f->mmap, f->cache_fd))
+                log_debug("SIGBUS while post-processing archived journal file %s, ignoring.", f->path);
+
+finish:
+        f->post_processing = false;
+
+        if (f->cache_fd)
+                mmap_cache_free_fd(f->mmap, f->cache_fd);
+        mmap_cache_unref(f->mmap);
+
+        f->mmap = saved_mmap;
+        f->cache_fd = saved_cache_fd;
+        f->data_hash_table = saved_data_hash_table;
+        f->field_hash_table = saved_field_hash_table;
+}
+
 /* This may be called from a separate thread to prevent blocking the caller for the duration of fsync().
  * As a result we use atomic operations on f->offline_state for inter-thread communications with
  * journal_file_set_offline() and journal_file_set_online(). */
@@ -115,8 +197,16 @@ static void journal_file_set_offline_internal(JournalFile *f) {
                         break;
 
                 case OFFLINE_SYNCING:
+                        /* Both are no-ops if the file has been post-processed already */
+                        if (f->archive)
+                                journal_file_archive_post_process(f);
+
                         (void) fsync(f->fd);
 
+                        /* Sync the rename to disk, too */
+                        if (f->archive)
+                                (void) fsync_directory_of_file(f->fd);
+
                         if (!__sync_bool_compare_and_swap(&f->offline_state, OFFLINE_SYNCING, OFFLINE_OFFLINING))
                                 continue;
 
@@ -396,11 +486,17 @@ JournalFile* journal_file_close(JournalFile *f) {
         mmap_cache_unref(f->mmap);
 
         ordered_hashmap_free_free(f->chain_cache);
+        free(f->data_cache);
+        free(f->match_cache);
 
 #if HAVE_COMPRESSION
         free(f->compress_buffer);
 #endif
 
+#if HAVE_ZSTD
+        zstd_dictionary_free(f->zstd_dict);
+#endif
+
 #if HAVE_GCRYPT
         if (f->fss_file)
                 munmap(f->fss_file, PAGE_ALIGN(f->fss_file_size));
@@ -430,7 +526,8 @@ static int journal_file_init_header(JournalFile *f, JournalFile *template) {
                 f->compress_xz * HEADER_INCOMPATIBLE_COMPRESSED_XZ |
                 f->compress_lz4 * HEADER_INCOMPATIBLE_COMPRESSED_LZ4 |
                 f->compress_zstd * HEADER_INCOMPATIBLE_COMPRESSED_ZSTD |
-                f->keyed_hash * HEADER_INCOMPATIBLE_KEYED_HASH);
+                f->keyed_hash * HEADER_INCOMPATIBLE_KEYED_HASH |
+                f->compact * HEADER_INCOMPATIBLE_COMPACT);
 
         h.compatible_flags = htole32(
                 f->seal * HEADER_COMPATIBLE_SEALED);
@@ -497,7 +594,7 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                   f->path, type, flags & ~any);
                 flags = (flags & any) & ~supported;
                 if (flags) {
-                        const char* strv[5];
+                        const char* strv[7];
                         unsigned n = 0;
                         _cleanup_free_ char *t = NULL;
 
@@ -513,6 +610,10 @@ static bool warn_wrong_flags(const JournalFile *f, bool compatible) {
                                         strv[n++] = "zstd-compressed";
                                 if (flags & HEADER_INCOMPATIBLE_KEYED_HASH)
                                         strv[n++] = "keyed-hash";
+                                if (flags & HEADER_INCOMPATIBLE_COMPACT)
+                                        strv[n++] = "compact";
+                                if (flags & HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
+                                        strv[n++] = "zstd-dictionary";
                         }
                         strv[n] = NULL;
                         assert(n < ELEMENTSOF(strv));
@@ -616,6 +717,8 @@ static int journal_file_verify_header(JournalFile *f) {
 
         f->keyed_hash = JOURNAL_HEADER_KEYED_HASH(f->header);
 
+        f->compact = JOURNAL_HEADER_COMPACT(f->header);
+
         return 0;
 }
 
@@ -686,6 +789,10 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 return -E2BIG;
 
+        /* Compact files store 32-bit offsets, hence may never grow beyond 4G */
+        if (JOURNAL_HEADER_COMPACT(f->header) && new_size > JOURNAL_COMPACT_SIZE_MAX)
+                return -E2BIG;
+
         if (new_size > f->metrics.min_size && f->metrics.keep_free > 0) {
                 struct statvfs svfs;
 
@@ -703,6 +810,8 @@ static int journal_file_allocate(JournalFile *f, uint64_t offset, uint64_t size)
         new_size = DIV_ROUND_UP(new_size, FILE_SIZE_INCREASE) * FILE_SIZE_INCREASE;
         if (f->metrics.max_size > 0 && new_size > f->metrics.max_size)
                 new_size = f->metrics.max_size;
+        if (JOURNAL_HEADER_COMPACT(f->header) && new_size > JOURNAL_COMPACT_SIZE_MAX)
+                new_size = JOURNAL_COMPACT_SIZE_MAX;
 
         /* Note that the glibc fallocate() fallback is very
            inefficient, hence we try to minimize the allocation area
@@ -768,6 +877,9 @@ static uint64_t minimum_header_size(Object *o) {
                 [OBJECT_FIELD_HASH_TABLE] = sizeof(HashTableObject),
                 [OBJECT_ENTRY_ARRAY] = sizeof(EntryArrayObject),
                 [OBJECT_TAG] = sizeof(TagObject),
+                [OBJECT_DATA_BLOOM] = sizeof(DataBloomObject),
+                [OBJECT_REALTIME_INDEX] = sizeof(RealtimeIndexObject),
+                [OBJECT_ZSTD_DICTIONARY] = sizeof(ZstdDictionaryObject),
         };
 
         if (o->object.type >= ELEMENTSOF(table) || table[o->object.type] <= 0)
@@ -834,17 +946,17 @@ static int journal_file_check_object(JournalFile *f, uint64_t offset, Object *o)
 
                 sz = le64toh(READ_NOW(o->object.size));
                 if (sz < offsetof(EntryObject, items) ||
-                    (sz - offsetof(EntryObject, items)) % sizeof(EntryItem) != 0)
+                    (sz - offsetof(EntryObject, items)) % journal_file_entry_item_size(f) != 0)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "Bad entry size (<= %zu): %" PRIu64 ": %" PRIu64,
                                                offsetof(EntryObject, items),
                                                sz,
                                                offset);
 
-                if ((sz - offsetof(EntryObject, items)) / sizeof(EntryItem) <= 0)
+                if ((sz - offsetof(EntryObject, items)) / journal_file_entry_item_size(f) <= 0)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "Invalid number items in entry: %" PRIu64 ": %" PRIu64,
-                                               (sz - offsetof(EntryObject, items)) / sizeof(EntryItem),
+                                               (sz - offsetof(EntryObject, items)) / journal_file_entry_item_size(f),
                                                offset);
 
                 if (le64toh(o->entry.seqnum) <= 0)
@@ -890,8 +1002,8 @@ static int journal_file_check_object(JournalFile *f, uint64_t offset, Object *o)
 
                 sz = le64toh(READ_NOW(o->object.size));
                 if (sz < offsetof(EntryArrayObject, items) ||
-                    (sz - offsetof(EntryArrayObject, items)) % sizeof(le64_t) != 0 ||
-                    (sz - offsetof(EntryArrayObject, items)) / sizeof(le64_t) <= 0)
+                    (sz - offsetof(EntryArrayObject, items)) % journal_file_entry_array_item_size(f) != 0 ||
+                    (sz - offsetof(EntryArrayObject, items)) / journal_file_entry_array_item_size(f) <= 0)
                         return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
                                                "Invalid object entry array size: %" PRIu64 ": %" PRIu64,
                                                sz,
@@ -919,6 +1031,60 @@ static int journal_file_check_object(JournalFile *f, uint64_t offset, Object *o)
                                                le64toh(o->tag.epoch), offset);
 
                 break;
+
+        case OBJECT_DATA_BLOOM: {
+                uint64_t sz;
+
+                sz = le64toh(READ_NOW(o->object.size));
+                if (sz <= offsetof(DataBloomObject, bits) ||
+                    (sz - offsetof(DataBloomObject, bits)) % sizeof(le64_t) != 0)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid data bloom filter size: %" PRIu64 ": %" PRIu64,
+                                               sz,
+                                               offset);
+
+                if (le32toh(o->data_bloom.n_hashes) <= 0 ||
+                    le32toh(o->data_bloom.n_hashes) > DATA_BLOOM_N_HASHES_MAX)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid number of data bloom filter hashes: %" PRIu32 ": %" PRIu64,
+                                               le32toh(o->data_bloom.n_hashes),
+                                               offset);
+
+                break;
+        }
+
+        case OBJECT_REALTIME_INDEX: {
+                uint64_t sz;
+
+                sz = le64toh(READ_NOW(o->object.size));
+                if (sz < offsetof(RealtimeIndexObject, items) ||
+                    (sz - offsetof(RealtimeIndexObject, items)) % sizeof(RealtimeIndexItem) != 0 ||
+                    (sz - offsetof(RealtimeIndexObject, items)) / sizeof(RealtimeIndexItem) <= 0)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid realtime index size: %" PRIu64 ": %" PRIu64,
+                                               sz,
+                                               offset);
+
+                break;
+        }
+
+        case OBJECT_ZSTD_DICTIONARY: {
+                uint64_t sz;
+
+                sz = le64toh(READ_NOW(o->object.size));
+                if (sz <= offsetof(ZstdDictionaryObject, payload))
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid ZSTD dictionary size: %" PRIu64 ": %" PRIu64,
+                                               sz,
+                                               offset);
+
+                if (le32toh(o->zstd_dictionary.dictionary_id) == 0)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Invalid ZSTD dictionary ID: %" PRIu64,
+                                               offset);
+
+                break;
+        }
         }
 
         return 0;
@@ -1045,26 +1211,17 @@ static void journal_file_revert_entry_seqnum(
                 *seqnum = revert_seqnum - 1;
 }
 
-int journal_file_append_object(
-                JournalFile *f,
-                ObjectType type,
-                uint64_t size,
-                Object **ret,
-                uint64_t *ret_offset) {
-
-        int r;
+static int journal_file_tail_end(JournalFile *f, uint64_t *ret_offset) {
+        Object *tail;
         uint64_t p;
-        Object *tail, *o;
-        void *t;
+        int r;
 
         assert(f);
         assert(f->header);
-        assert(type > OBJECT_UNUSED && type < _OBJECT_TYPE_MAX);
-        assert(size >= sizeof(ObjectHeader));
+        assert(ret_offset);
 
-        r = journal_file_set_online(f);
-        if (r < 0)
-                return r;
+        /* Returns the offset right after the last object in the file, i.e. where the next object would be
+         * appended. */
 
         p = le64toh(f->header->tail_object_offset);
         if (p == 0)
@@ -1087,6 +1244,39 @@ int journal_file_append_object(
                 p += sz;
         }
 
+        *ret_offset = p;
+        return 0;
+}
+
+int journal_file_append_object(
+                JournalFile *f,
+                ObjectType type,
+                uint64_t size,
+                Object **ret,
+                uint64_t *ret_offset) {
+
+        int r;
+        uint64_t p;
+        Object *o;
+        void *t;
+
+        assert(f);
+        assert(f->header);
+        assert(type > OBJECT_UNUSED && type < _OBJECT_TYPE_MAX);
+        assert(size >= sizeof(ObjectHeader));
+
+        /* When called while offlining, the file is still online, and going through
+         * journal_file_set_online() would cancel the very offlining we are part of. */
+        if (!f->post_processing) {
+                r = journal_file_set_online(f);
+                if (r < 0)
+                        return r;
+        }
+
+        r = journal_file_tail_end(f, &p);
+        if (r < 0)
+                return r;
+
         r = journal_file_allocate(f, p, size);
         if (r < 0)
                 return r;
@@ -1228,6 +1418,227 @@ int journal_file_map_field_hash_table(JournalFile *f) {
         return 0;
 }
 
+int journal_file_decompress_blob(
+                JournalFile *f,
+                int compression,
+                const void *src, uint64_t src_size,
+                void **dst, size_t *dst_size, size_t dst_max) {
+
+        assert(f);
+
+#if HAVE_ZSTD
+        if (compression == OBJECT_COMPRESSED_ZSTD && f->zstd_dict)
+                return decompress_blob_zstd_with_dict(f->zstd_dict, src, src_size, dst, dst_size, dst_max);
+#endif
+
+        return decompress_blob(compression, src, src_size, dst, dst_size, dst_max);
+}
+
+int journal_file_decompress_startswith(
+                JournalFile *f,
+                int compression,
+                const void *src, uint64_t src_size,
+                void **buffer,
+                const void *prefix, size_t prefix_len,
+                uint8_t extra) {
+
+        assert(f);
+
+#if HAVE_ZSTD
+        if (compression == OBJECT_COMPRESSED_ZSTD && f->zstd_dict)
+                return decompress_startswith_zstd_with_dict(f->zstd_dict, src, src_size, buffer, prefix, prefix_len, extra);
+#endif
+
+        return decompress_startswith(compression, src, src_size, buffer, prefix, prefix_len, extra);
+}
+
+#if HAVE_ZSTD
+static int journal_file_collect_zstd_dictionary_samples(
+                JournalFile *f,
+                void **ret_samples,
+                size_t **ret_sizes,
+                size_t *ret_n_samples,
+                size_t *ret_n_bytes) {
+
+        _cleanup_free_ uint8_t *samples = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        size_t n_samples = 0, n_bytes = 0;
+        unsigned n_objects = 0;
+        uint64_t m;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(ret_samples);
+        assert(ret_sizes);
+        assert(ret_n_samples);
+        assert(ret_n_bytes);
+
+        r = journal_file_map_data_hash_table(f);
+        if (r < 0)
+                return r;
+
+        m = le64toh(READ_NOW(f->header->data_hash_table_size)) / sizeof(HashItem);
+
+        for (uint64_t i = 0; i < m && n_bytes < ZSTD_DICTIONARY_SAMPLES_MAX && n_objects < ZSTD_DICTIONARY_OBJECTS_MAX; i++) {
+                uint64_t p;
+
+                p = le64toh(f->data_hash_table[i].head_hash_offset);
+                while (p > 0 && n_bytes < ZSTD_DICTIONARY_SAMPLES_MAX && n_objects++ < ZSTD_DICTIONARY_OBJECTS_MAX) {
+                        const void *data;
+                        uint64_t l, q;
+                        size_t rsize;
+                        Object *o;
+
+                        r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                        if (r < 0)
+                                return r;
+
+                        l = le64toh(READ_NOW(o->object.size));
+                        if (l <= offsetof(Object, data.payload))
+                                return -EBADMSG;
+                        l -= offsetof(Object, data.payload);
+
+                        if (o->object.flags & OBJECT_COMPRESSION_MASK) {
+                                r = journal_file_decompress_blob(f, o->object.flags & OBJECT_COMPRESSION_MASK,
+                                                                 o->data.payload, l, &f->compress_buffer, &rsize,
+                                                                 ZSTD_DICTIONARY_SAMPLE_SIZE_MAX + 1);
+                                if (r < 0)
+                                        return r;
+
+                                data = f->compress_buffer;
+                        } else {
+                                data = o->data.payload;
+                                rsize = l;
+                        }
+
+                        /* Large objects compress well on their own, only train on the small ones */
+                        if (rsize > 0 && rsize <= ZSTD_DICTIONARY_SAMPLE_SIZE_MAX) {
+                                if (!GREEDY_REALLOC(samples, n_bytes + rsize) ||
+                                    !GREEDY_REALLOC(sizes, n_samples + 1))
+                                        return -ENOMEM;
+
+                                memcpy(samples + n_bytes, data, rsize);
+                                sizes[n_samples++] = rsize;
+                                n_bytes += rsize;
+                        }
+
+                        /* The decompression above might have moved the window, refresh our pointer */
+                        r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                        if (r < 0)
+                                return r;
+
+                        q = le64toh(READ_NOW(o->data.next_hash_offset));
+                        if (q > 0 && q <= p) /* Refuse going in loops */
+                                return -EBADMSG;
+                        p = q;
+                }
+        }
+
+        *ret_samples = TAKE_PTR(samples);
+        *ret_sizes = TAKE_PTR(sizes);
+        *ret_n_samples = n_samples;
+        *ret_n_bytes = n_bytes;
+        return 0;
+}
+
+static int journal_file_setup_zstd_dictionary(JournalFile *f, JournalFile *template) {
+        _cleanup_(zstd_dictionary_freep) ZstdDictionary *d = NULL;
+        _cleanup_free_ void *samples = NULL, *dict = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        size_t n_samples, n_bytes, dict_size;
+        uint64_t p;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(template);
+
+        /* Trains a ZSTD dictionary from the DATA objects of the previous file and appends it to this
+         * newly created one. Failing to train a dictionary is not an error, we'll just compress data
+         * objects the old way then. */
+
+        r = journal_file_collect_zstd_dictionary_samples(template, &samples, &sizes, &n_samples, &n_bytes);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to collect ZSTD dictionary samples from %s, ignoring: %m",
+                                template->path);
+                return 0;
+        }
+
+        dict_size = MIN(n_bytes / 100, (size_t) ZSTD_DICTIONARY_SIZE_MAX);
+        if (dict_size < ZSTD_DICTIONARY_SIZE_MIN) {
+                log_debug("Not enough samples in %s to train a ZSTD dictionary, not using one.", template->path);
+                return 0;
+        }
+
+        r = zstd_dictionary_train(samples, sizes, n_samples, dict_size, &dict, &dict_size);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to train ZSTD dictionary from %s, ignoring: %m",
+                                template->path);
+                return 0;
+        }
+
+        r = zstd_dictionary_new(dict, dict_size, &d);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to load trained ZSTD dictionary, ignoring: %m");
+                return 0;
+        }
+
+        r = journal_file_append_object(f, OBJECT_ZSTD_DICTIONARY,
+                                       offsetof(Object, zstd_dictionary.payload) + dict_size,
+                                       &o, &p);
+        if (r < 0)
+                return r;
+
+        o->zstd_dictionary.dictionary_id = htole32(zstd_dictionary_get_id(d));
+        memcpy(o->zstd_dictionary.payload, dict, dict_size);
+
+        f->header->zstd_dictionary_offset = htole64(p);
+        f->header->incompatible_flags |= htole32(HEADER_INCOMPATIBLE_ZSTD_DICTIONARY);
+
+        log_debug("Trained %zu byte ZSTD dictionary from %zu samples (%zu bytes) of %s.",
+                  dict_size, n_samples, n_bytes, template->path);
+
+        f->zstd_dict = TAKE_PTR(d);
+        return 0;
+}
+
+static int journal_file_load_zstd_dictionary(JournalFile *f) {
+        uint64_t p, l;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        if (!JOURNAL_HEADER_ZSTD_DICTIONARY(f->header))
+                return 0;
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, zstd_dictionary_offset))
+                return -EBADMSG;
+
+        p = le64toh(f->header->zstd_dictionary_offset);
+        if (p == 0)
+                return -EBADMSG;
+
+        r = journal_file_move_to_object(f, OBJECT_ZSTD_DICTIONARY, p, &o);
+        if (r < 0)
+                return r;
+
+        l = le64toh(READ_NOW(o->object.size)) - offsetof(Object, zstd_dictionary.payload);
+
+        r = zstd_dictionary_new(o->zstd_dictionary.payload, l, &f->zstd_dict);
+        if (r < 0)
+                return r;
+
+        if (zstd_dictionary_get_id(f->zstd_dict) != le32toh(o->zstd_dictionary.dictionary_id))
+                return -EBADMSG;
+
+        return 0;
+}
+#endif
+
 static int journal_file_link_field(
                 JournalFile *f,
                 Object *o,
@@ -1321,6 +1732,10 @@ static int journal_file_link_data(
         if (JOURNAL_HEADER_CONTAINS(f->header, n_data))
                 f->header->n_data = htole64(le64toh(f->header->n_data) + 1);
 
+        /* The bloom filter doesn't know about the new object, hence drop it */
+        if (JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset))
+                f->header->data_bloom_offset = 0;
+
         return 0;
 }
 
@@ -1443,6 +1858,125 @@ int journal_file_find_field_object(
                         ret, ret_offset);
 }
 
+int journal_file_data_bloom_test(JournalFile *f, uint64_t hash) {
+        uint64_t p, n_bits;
+        uint32_t k;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        /* Returns 0 if an object with the specified hash is definitely not in the file, > 0 if it might
+         * be, i.e. also if there's no bloom filter to check. */
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset))
+                return 1;
+
+        p = le64toh(READ_NOW(f->header->data_bloom_offset));
+        if (p == 0)
+                return 1;
+
+        r = journal_file_move_to_object(f, OBJECT_DATA_BLOOM, p, &o);
+        if (r < 0)
+                return r;
+
+        n_bits = (le64toh(o->object.size) - offsetof(DataBloomObject, bits)) * 8;
+        k = le32toh(o->data_bloom.n_hashes);
+
+        for (uint32_t i = 0; i < k; i++) {
+                uint64_t b;
+
+                b = journal_file_data_bloom_bit(hash, i, n_bits);
+                if (!(le64toh(o->data_bloom.bits[b / 64]) & (UINT64_C(1) << (b % 64))))
+                        return 0;
+        }
+
+        return 1;
+}
+
+int journal_file_append_data_bloom(JournalFile *f) {
+        uint64_t n, n_bits, m, q;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        /* Adds a bloom filter over the hashes of all DATA objects to the file, for use by readers to quickly
+         * rule out files when looking for a specific field/value pair. The filter is dropped again as soon
+         * as another DATA object is added, hence this is only useful for files that aren't written to
+         * anymore, i.e. when archiving. */
+
+        if (!f->writable)
+                return -EPERM;
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset))
+                return -EOPNOTSUPP;
+
+        /* Older versions of the verifier refuse to authenticate objects they don't know */
+        if (JOURNAL_HEADER_SEALED(f->header))
+                return -EOPNOTSUPP;
+
+        if (le64toh(f->header->data_bloom_offset) != 0)
+                return 0;
+
+        n = le64toh(f->header->n_data);
+        if (n == 0)
+                return 0;
+
+        r = journal_file_map_data_hash_table(f);
+        if (r < 0)
+                return r;
+
+        m = le64toh(READ_NOW(f->header->data_hash_table_size)) / sizeof(HashItem);
+        if (m <= 0)
+                return -EBADMSG;
+
+        if (n > (UINT64_MAX - 63) / DATA_BLOOM_BITS_PER_ITEM)
+                return -EFBIG;
+        n_bits = ALIGN_TO(n * DATA_BLOOM_BITS_PER_ITEM, 64);
+
+        r = journal_file_append_object(f, OBJECT_DATA_BLOOM, offsetof(Object, data_bloom.bits) + n_bits / 8, &o, &q);
+        if (r < 0)
+                return r;
+
+        o->data_bloom.n_items = htole64(n);
+        o->data_bloom.n_hashes = htole32(DATA_BLOOM_N_HASHES);
+        o->data_bloom.reserved = 0;
+        memzero(o->data_bloom.bits, n_bits / 8);
+
+        for (uint64_t i = 0; i < m; i++) {
+                uint64_t p, depth = 0;
+
+                p = le64toh(f->data_hash_table[i].head_hash_offset);
+                while (p > 0) {
+                        Object *d;
+
+                        r = journal_file_move_to_object(f, OBJECT_DATA, p, &d);
+                        if (r < 0)
+                                return r;
+
+                        for (uint32_t k = 0; k < DATA_BLOOM_N_HASHES; k++) {
+                                uint64_t b;
+
+                                b = journal_file_data_bloom_bit(le64toh(d->data.hash), k, n_bits);
+                                o->data_bloom.bits[b / 64] |= htole64(UINT64_C(1) << (b % 64));
+                        }
+
+                        r = next_hash_offset(f, &p, &d->data.next_hash_offset, &depth, NULL);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        /* Only make the filter visible to readers once it is complete */
+        __sync_synchronize();
+        f->header->data_bloom_offset = htole64(q);
+
+        return 0;
+}
+
 int journal_file_find_data_object_with_hash(
                 JournalFile *f,
                 const void *data, uint64_t size, uint64_t hash,
@@ -1459,6 +1993,14 @@ int journal_file_find_data_object_with_hash(
         if (le64toh(f->header->data_hash_table_size) <= 0)
                 return 0;
 
+        /* If the file has a bloom filter, it can tell us cheaply that the object doesn't exist, without
+         * walking the hash chain. */
+        r = journal_file_data_bloom_test(f, hash);
+        if (r == 0)
+                return 0;
+        if (r < 0)
+                log_debug_errno(r, "Failed to check data bloom filter of %s, ignoring: %m", f->path);
+
         /* Map the data hash table, if it isn't mapped yet. */
         r = journal_file_map_data_hash_table(f);
         if (r < 0)
@@ -1494,8 +2036,8 @@ int journal_file_find_data_object_with_hash(
 
                         l -= offsetof(Object, data.payload);
 
-                        r = decompress_blob(o->object.flags & OBJECT_COMPRESSION_MASK,
-                                            o->data.payload, l, &f->compress_buffer, &rsize, 0);
+                        r = journal_file_decompress_blob(f, o->object.flags & OBJECT_COMPRESSION_MASK,
+                                                         o->data.payload, l, &f->compress_buffer, &rsize, 0);
                         if (r < 0)
                                 return r;
 
@@ -1606,53 +2148,160 @@ static int journal_file_append_field(
         if (!journal_field_valid(field, size, true))
                 return -EBADMSG;
 
-        hash = journal_file_hash_data(f, field, size);
+        hash = journal_file_hash_data(f, field, size);
+
+        r = journal_file_find_field_object_with_hash(f, field, size, hash, &o, &p);
+        if (r < 0)
+                return r;
+        if (r > 0) {
+
+                if (ret)
+                        *ret = o;
+
+                if (ret_offset)
+                        *ret_offset = p;
+
+                return 0;
+        }
+
+        osize = offsetof(Object, field.payload) + size;
+        r = journal_file_append_object(f, OBJECT_FIELD, osize, &o, &p);
+        if (r < 0)
+                return r;
+
+        o->field.hash = htole64(hash);
+        memcpy(o->field.payload, field, size);
+
+        r = journal_file_link_field(f, o, p, hash);
+        if (r < 0)
+                return r;
+
+        /* The linking might have altered the window, so let's
+         * refresh our pointer */
+        r = journal_file_move_to_object(f, OBJECT_FIELD, p, &o);
+        if (r < 0)
+                return r;
+
+#if HAVE_GCRYPT
+        r = journal_file_hmac_put_object(f, OBJECT_FIELD, o, p);
+        if (r < 0)
+                return r;
+#endif
+
+        if (ret)
+                *ret = o;
+
+        if (ret_offset)
+                *ret_offset = p;
+
+        return 0;
+}
+
+#if HAVE_COMPRESSION
+static uint64_t journal_file_compress_threshold(JournalFile *f) {
+        assert(f);
+
+#if HAVE_ZSTD
+        /* With a dictionary even small objects compress well, hence use the minimal threshold */
+        if (f->compress_zstd && f->zstd_dict)
+                return MIN_COMPRESS_THRESHOLD;
+#endif
+
+        return f->compress_threshold_bytes;
+}
+
+static int journal_file_compress_blob(
+                JournalFile *f,
+                const void *src, uint64_t src_size,
+                void *dst, size_t dst_alloc_size, size_t *dst_size) {
+
+        assert(f);
+
+#if HAVE_ZSTD
+        if (f->compress_zstd && f->zstd_dict) {
+                int r;
+
+                r = compress_blob_zstd_with_dict(f->zstd_dict, src, src_size, dst, dst_alloc_size, dst_size);
+                if (r < 0)
+                        return r;
+
+                return OBJECT_COMPRESSED_ZSTD;
+        }
+#endif
+
+        return compress_blob(src, src_size, dst, dst_alloc_size, dst_size);
+}
+#endif
+
+typedef struct DataCacheItem {
+        uint64_t hash;
+        uint64_t offset;
+} DataCacheItem;
+
+static int journal_file_data_cache_get(
+                JournalFile *f,
+                const void *data, uint64_t size, uint64_t hash,
+                Object **ret, uint64_t *ret_offset) {
+
+        DataCacheItem *i;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(data || size == 0);
 
-        r = journal_file_find_field_object_with_hash(f, field, size, hash, &o, &p);
-        if (r < 0)
-                return r;
-        if (r > 0) {
+        /* Fields like _HOSTNAME= or _BOOT_ID= are the same for most entries we write. Hence, remember where
+         * we last found DATA objects, indexed by hash, which saves us the walk through the data hash table
+         * and hash chain for them. This is a direct-mapped cache rather than an LRU one, so that keeping it
+         * up-to-date costs next to nothing. */
 
-                if (ret)
-                        *ret = o;
+        if (!f->data_cache)
+                return 0;
 
-                if (ret_offset)
-                        *ret_offset = p;
+        i = f->data_cache + hash % DATA_CACHE_SIZE;
+        if (i->offset == 0 || i->hash != hash)
+                return 0;
 
+        r = journal_file_move_to_object(f, OBJECT_DATA, i->offset, &o);
+        if (r < 0) {
+                *i = (DataCacheItem) {};
                 return 0;
         }
 
-        osize = offsetof(Object, field.payload) + size;
-        r = journal_file_append_object(f, OBJECT_FIELD, osize, &o, &p);
-        if (r < 0)
-                return r;
+        /* Hashes might collide, hence compare the payload, too. Only uncompressed objects are cached. */
+        if (le64toh(o->data.hash) != hash ||
+            (o->object.flags & OBJECT_COMPRESSION_MASK) ||
+            le64toh(o->object.size) != offsetof(Object, data.payload) + size ||
+            memcmp_safe(o->data.payload, data, size) != 0)
+                return 0;
 
-        o->field.hash = htole64(hash);
-        memcpy(o->field.payload, field, size);
+        if (ret)
+                *ret = o;
 
-        r = journal_file_link_field(f, o, p, hash);
-        if (r < 0)
-                return r;
+        if (ret_offset)
+                *ret_offset = i->offset;
 
-        /* The linking might have altered the window, so let's
-         * refresh our pointer */
-        r = journal_file_move_to_object(f, OBJECT_FIELD, p, &o);
-        if (r < 0)
-                return r;
+        return 1;
+}
 
-#if HAVE_GCRYPT
-        r = journal_file_hmac_put_object(f, OBJECT_FIELD, o, p);
-        if (r < 0)
-                return r;
-#endif
+static void journal_file_data_cache_put(JournalFile *f, Object *o, uint64_t hash, uint64_t offset) {
+        assert(f);
+        assert(o);
 
-        if (ret)
-                *ret = o;
+        /* Checking a compressed object for a match requires decompressing it, which is not worth it */
+        if (o->object.flags & OBJECT_COMPRESSION_MASK)
+                return;
 
-        if (ret_offset)
-                *ret_offset = p;
+        if (!f->data_cache) {
+                f->data_cache = new0(DataCacheItem, DATA_CACHE_SIZE);
+                if (!f->data_cache)
+                        return;
+        }
 
-        return 0;
+        f->data_cache[hash % DATA_CACHE_SIZE] = (DataCacheItem) {
+                .hash = hash,
+                .offset = offset,
+        };
 }
 
 static int journal_file_append_data(
@@ -1671,10 +2320,13 @@ static int journal_file_append_data(
 
         hash = journal_file_hash_data(f, data, size);
 
-        r = journal_file_find_data_object_with_hash(f, data, size, hash, &o, &p);
+        r = journal_file_data_cache_get(f, data, size, hash, &o, &p);
+        if (r == 0)
+                r = journal_file_find_data_object_with_hash(f, data, size, hash, &o, &p);
         if (r < 0)
                 return r;
         if (r > 0) {
+                journal_file_data_cache_put(f, o, hash, p);
 
                 if (ret)
                         *ret = o;
@@ -1693,15 +2345,18 @@ static int journal_file_append_data(
         o->data.hash = htole64(hash);
 
 #if HAVE_COMPRESSION
-        if (JOURNAL_FILE_COMPRESS(f) && size >= f->compress_threshold_bytes) {
+        if (JOURNAL_FILE_COMPRESS(f) && size >= journal_file_compress_threshold(f)) {
                 size_t rsize = 0;
 
-                compression = compress_blob(data, size, o->data.payload, size - 1, &rsize);
+                compression = journal_file_compress_blob(f, data, size, o->data.payload, size - 1, &rsize);
 
                 if (compression >= 0) {
                         o->object.size = htole64(offsetof(Object, data.payload) + rsize);
                         o->object.flags |= compression;
 
+                        f->compress_bytes_in += size;
+                        f->compress_bytes_out += rsize;
+
                         log_debug("Compressed data object %"PRIu64" -> %zu using %s",
                                   size, rsize, object_compressed_to_string(compression));
                 } else
@@ -1747,6 +2402,8 @@ static int journal_file_append_data(
                 fo->field.head_data_offset = le64toh(p);
         }
 
+        journal_file_data_cache_put(f, o, hash, p);
+
         if (ret)
                 *ret = o;
 
@@ -1756,8 +2413,43 @@ static int journal_file_append_data(
         return 0;
 }
 
-uint64_t journal_file_entry_n_items(Object *o) {
+int journal_file_move_to_entry_item_data(JournalFile *f, Object *o, uint64_t i, Object **ret, uint64_t *ret_offset) {
+        le64_t le_hash = 0;
+        uint64_t p;
+        Object *d;
+        int r;
+
+        assert(f);
+        assert(o);
+        assert(o->object.type == OBJECT_ENTRY);
+
+        /* Looks up the data object referenced by the i-th item of the specified entry object. For regular
+         * files we also make sure the hash stored in the item matches the one of the data object, compact
+         * files do not carry a copy of the hash in the entry item. */
+
+        p = journal_file_entry_item_object_offset(f, o, i);
+        if (!JOURNAL_HEADER_COMPACT(f->header))
+                le_hash = o->entry.items.regular[i].hash;
+
+        r = journal_file_move_to_object(f, OBJECT_DATA, p, &d);
+        if (r < 0)
+                return r;
+
+        if (!JOURNAL_HEADER_COMPACT(f->header) && le_hash != d->data.hash)
+                return -EBADMSG;
+
+        if (ret)
+                *ret = d;
+        if (ret_offset)
+                *ret_offset = p;
+
+        return 0;
+}
+
+uint64_t journal_file_entry_n_items(JournalFile *f, Object *o) {
         uint64_t sz;
+
+        assert(f);
         assert(o);
 
         if (o->object.type != OBJECT_ENTRY)
@@ -1767,12 +2459,13 @@ uint64_t journal_file_entry_n_items(Object *o) {
         if (sz < offsetof(Object, entry.items))
                 return 0;
 
-        return (sz - offsetof(Object, entry.items)) / sizeof(EntryItem);
+        return (sz - offsetof(Object, entry.items)) / journal_file_entry_item_size(f);
 }
 
-uint64_t journal_file_entry_array_n_items(Object *o) {
+uint64_t journal_file_entry_array_n_items(JournalFile *f, Object *o) {
         uint64_t sz;
 
+        assert(f);
         assert(o);
 
         if (o->object.type != OBJECT_ENTRY_ARRAY)
@@ -1782,7 +2475,22 @@ uint64_t journal_file_entry_array_n_items(Object *o) {
         if (sz < offsetof(Object, entry_array.items))
                 return 0;
 
-        return (sz - offsetof(Object, entry_array.items)) / sizeof(uint64_t);
+        return (sz - offsetof(Object, entry_array.items)) / journal_file_entry_array_item_size(f);
+}
+
+uint64_t journal_file_realtime_index_n_items(Object *o) {
+        uint64_t sz;
+
+        assert(o);
+
+        if (o->object.type != OBJECT_REALTIME_INDEX)
+                return 0;
+
+        sz = le64toh(READ_NOW(o->object.size));
+        if (sz < offsetof(Object, realtime_index.items))
+                return 0;
+
+        return (sz - offsetof(Object, realtime_index.items)) / sizeof(RealtimeIndexItem);
 }
 
 uint64_t journal_file_hash_table_n_items(Object *o) {
@@ -1800,6 +2508,17 @@ uint64_t journal_file_hash_table_n_items(Object *o) {
         return (sz - offsetof(Object, hash_table.items)) / sizeof(HashItem);
 }
 
+static void write_entry_array_item(JournalFile *f, Object *o, uint64_t i, uint64_t p) {
+        assert(f);
+        assert(o);
+
+        if (JOURNAL_HEADER_COMPACT(f->header)) {
+                assert(p <= UINT32_MAX);
+                o->entry_array.items.compact[i] = htole32(p);
+        } else
+                o->entry_array.items.regular[i] = htole64(p);
+}
+
 static int link_entry_into_array(JournalFile *f,
                                  le64_t *first,
                                  le64_t *idx,
@@ -1822,9 +2541,9 @@ static int link_entry_into_array(JournalFile *f,
                 if (r < 0)
                         return r;
 
-                n = journal_file_entry_array_n_items(o);
+                n = journal_file_entry_array_n_items(f, o);
                 if (i < n) {
-                        o->entry_array.items[i] = htole64(p);
+                        write_entry_array_item(f, o, i, p);
                         *idx = htole64(hidx + 1);
                         return 0;
                 }
@@ -1843,7 +2562,7 @@ static int link_entry_into_array(JournalFile *f,
                 n = 4;
 
         r = journal_file_append_object(f, OBJECT_ENTRY_ARRAY,
-                                       offsetof(Object, entry_array.items) + n * sizeof(uint64_t),
+                                       offsetof(Object, entry_array.items) + n * journal_file_entry_array_item_size(f),
                                        &o, &q);
         if (r < 0)
                 return r;
@@ -1854,7 +2573,7 @@ static int link_entry_into_array(JournalFile *f,
                 return r;
 #endif
 
-        o->entry_array.items[i] = htole64(p);
+        write_entry_array_item(f, o, i, p);
 
         if (ap == 0)
                 *first = htole64(q);
@@ -1915,7 +2634,7 @@ static int journal_file_link_entry_item(JournalFile *f, Object *o, uint64_t offs
         assert(o);
         assert(offset > 0);
 
-        p = le64toh(o->entry.items[i].object_offset);
+        p = journal_file_entry_item_object_offset(f, o, i);
         r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
         if (r < 0)
                 return r;
@@ -1958,7 +2677,7 @@ static int journal_file_link_entry(JournalFile *f, Object *o, uint64_t offset) {
         f->header->tail_entry_monotonic = o->entry.monotonic;
 
         /* Link up the items */
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         for (uint64_t i = 0; i < n; i++) {
                 r = journal_file_link_entry_item(f, o, offset, i);
                 if (r < 0)
@@ -1986,14 +2705,21 @@ static int journal_file_append_entry_internal(
         assert(items || n_items == 0);
         assert(ts);
 
-        osize = offsetof(Object, entry.items) + (n_items * sizeof(EntryItem));
+        osize = offsetof(Object, entry.items) + (n_items * journal_file_entry_item_size(f));
 
         r = journal_file_append_object(f, OBJECT_ENTRY, osize, &o, &np);
         if (r < 0)
                 return r;
 
         o->entry.seqnum = htole64(journal_file_entry_seqnum(f, seqnum));
-        memcpy_safe(o->entry.items, items, n_items * sizeof(EntryItem));
+        for (unsigned i = 0; i < n_items; i++)
+                if (JOURNAL_HEADER_COMPACT(f->header)) {
+                        assert(items[i].object_offset <= UINT32_MAX);
+                        o->entry.items.compact[i].object_offset = htole32(items[i].object_offset);
+                } else {
+                        o->entry.items.regular[i].object_offset = htole64(items[i].object_offset);
+                        o->entry.items.regular[i].hash = htole64(items[i].hash);
+                }
         o->entry.realtime = htole64(ts->realtime);
         o->entry.monotonic = htole64(ts->monotonic);
         o->entry.xor_hash = htole64(xor_hash);
@@ -2107,10 +2833,10 @@ int journal_file_enable_post_change_timer(JournalFile *f, sd_event *e, usec_t t)
 }
 
 static int entry_item_cmp(const EntryItem *a, const EntryItem *b) {
-        return CMP(le64toh(a->object_offset), le64toh(b->object_offset));
+        return CMP(a->object_offset, b->object_offset);
 }
 
-int journal_file_append_entry(
+static int journal_file_append_entry_one(
                 JournalFile *f,
                 const dual_timestamp *ts,
                 const sd_id128_t *boot_id,
@@ -2172,15 +2898,21 @@ int journal_file_append_entry(
                 else
                         xor_hash ^= le64toh(o->data.hash);
 
-                items[i].object_offset = htole64(p);
-                items[i].hash = o->data.hash;
+                items[i] = (EntryItem) {
+                        .object_offset = p,
+                        .hash = le64toh(o->data.hash),
+                };
         }
 
         /* Order by the position on disk, in order to improve seek
          * times for rotating media. */
         typesafe_qsort(items, n_iovec, entry_item_cmp);
 
-        r = journal_file_append_entry_internal(f, ts, boot_id, xor_hash, items, n_iovec, seqnum, ret, ret_offset);
+        return journal_file_append_entry_internal(f, ts, boot_id, xor_hash, items, n_iovec, seqnum, ret, ret_offset);
+}
+
+static int journal_file_append_entry_finish(JournalFile *f, int r) {
+        assert(f);
 
         /* If the memory mapping triggered a SIGBUS then we return an
          * IO error and ignore the error code passed down to us, since
@@ -2198,6 +2930,99 @@ int journal_file_append_entry(
         return r;
 }
 
+int journal_file_append_entry(
+                JournalFile *f,
+                const dual_timestamp *ts,
+                const sd_id128_t *boot_id,
+                const struct iovec iovec[], unsigned n_iovec,
+                uint64_t *seqnum,
+                Object **ret, uint64_t *ret_offset) {
+
+        int r;
+
+        assert(f);
+
+        r = journal_file_append_entry_one(f, ts, boot_id, iovec, n_iovec, seqnum, ret, ret_offset);
+        return journal_file_append_entry_finish(f, r);
+}
+
+static uint64_t journal_file_entry_size_estimate(JournalFile *f, const JournalFileEntry *e) {
+        uint64_t sz;
+
+        assert(f);
+        assert(e);
+
+        /* Upper bound of the space the entry takes up on disk, assuming none of its data objects exist yet
+         * and ignoring any entry arrays and field objects that might have to be allocated. */
+
+        sz = ALIGN64(offsetof(Object, entry.items) + e->n_iovec * journal_file_entry_item_size(f));
+        for (unsigned i = 0; i < e->n_iovec; i++)
+                sz += ALIGN64(offsetof(Object, data.payload) + e->iovec[i].iov_len);
+
+        return sz;
+}
+
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileEntry entries[], size_t n_entries,
+                uint64_t *seqnum,
+                size_t *ret_n_appended) {
+
+        uint64_t p, sz = 0;
+        size_t n = 0;
+        int r;
+
+        assert(f);
+        assert(f->header);
+        assert(entries || n_entries == 0);
+
+        /* Appends a number of entries in one go. Space for all of them is reserved with a single
+         * allocation up front, and the change notification is posted only once at the end. Entries are
+         * appended in order, and we stop at the first one that fails. The number of entries successfully
+         * appended is returned in ret_n_appended, so that the caller may retry the remaining ones, for
+         * example after rotating. */
+
+        r = journal_file_set_online(f);
+        if (r < 0)
+                goto finish;
+
+        for (size_t i = 0; i < n_entries; i++)
+                sz += journal_file_entry_size_estimate(f, entries + i);
+
+        r = journal_file_tail_end(f, &p);
+        if (r < 0)
+                goto finish;
+
+        /* The estimate is an upper bound, since data objects are deduplicated. Hence don't fail if we
+         * can't reserve all of it, the individual appends below will tell us if we really ran out of
+         * space. Anything else (SIGBUS, a corrupted header, the file being deleted) would make every
+         * single append fail too, hence give up right away. */
+        r = journal_file_allocate(f, p, sz);
+        if (IN_SET(r, -E2BIG, -ENOSPC))
+                log_debug_errno(r, "Failed to reserve %"PRIu64" bytes for %zu entries, ignoring: %m", sz, n_entries);
+        else if (r < 0)
+                goto finish;
+
+        r = 0;
+        for (; n < n_entries; n++) {
+                r = journal_file_append_entry_one(
+                                f,
+                                entries[n].ts,
+                                entries[n].boot_id,
+                                entries[n].iovec, entries[n].n_iovec,
+                                seqnum,
+                                NULL, NULL);
+                if (r < 0)
+                        break;
+        }
+
+finish:
+        if (ret_n_appended)
+                *ret_n_appended = n;
+
+        return journal_file_append_entry_finish(f, r);
+}
+
 typedef struct ChainCacheItem {
         uint64_t first; /* the array at the beginning of the chain */
         uint64_t array; /* the cached array */
@@ -2275,9 +3100,9 @@ static int generic_array_get(
                 if (r < 0)
                         return r;
 
-                k = journal_file_entry_array_n_items(o);
+                k = journal_file_entry_array_n_items(f, o);
                 if (i < k) {
-                        p = le64toh(o->entry_array.items[i]);
+                        p = journal_file_entry_array_item(f, o, i);
                         goto found;
                 }
 
@@ -2290,7 +3115,7 @@ static int generic_array_get(
 
 found:
         /* Let's cache this item for the next invocation */
-        chain_cache_put(f->chain_cache, ci, first, a, le64toh(o->entry_array.items[0]), t, i);
+        chain_cache_put(f->chain_cache, ci, first, a, journal_file_entry_array_item(f, o, 0), t, i);
 
         r = journal_file_move_to_object(f, OBJECT_ENTRY, p, &o);
         if (r < 0)
@@ -2396,13 +3221,13 @@ static int generic_array_bisect(
                 if (r < 0)
                         return r;
 
-                k = journal_file_entry_array_n_items(array);
+                k = journal_file_entry_array_n_items(f, array);
                 right = MIN(k, n);
                 if (right <= 0)
                         return 0;
 
                 i = right - 1;
-                lp = p = le64toh(array->entry_array.items[i]);
+                lp = p = journal_file_entry_array_item(f, array, i);
                 if (p <= 0)
                         r = -EBADMSG;
                 else
@@ -2435,7 +3260,7 @@ static int generic_array_bisect(
                                 if (last_index > 0) {
                                         uint64_t x = last_index - 1;
 
-                                        p = le64toh(array->entry_array.items[x]);
+                                        p = journal_file_entry_array_item(f, array, x);
                                         if (p <= 0)
                                                 return -EBADMSG;
 
@@ -2455,7 +3280,7 @@ static int generic_array_bisect(
                                 if (last_index < right) {
                                         uint64_t y = last_index + 1;
 
-                                        p = le64toh(array->entry_array.items[y]);
+                                        p = journal_file_entry_array_item(f, array, y);
                                         if (p <= 0)
                                                 return -EBADMSG;
 
@@ -2485,7 +3310,7 @@ static int generic_array_bisect(
                                 assert(left < right);
                                 i = (left + right) / 2;
 
-                                p = le64toh(array->entry_array.items[i]);
+                                p = journal_file_entry_array_item(f, array, i);
                                 if (p <= 0)
                                         r = -EBADMSG;
                                 else
@@ -2533,14 +3358,14 @@ found:
                 return 0;
 
         /* Let's cache this item for the next invocation */
-        chain_cache_put(f->chain_cache, ci, first, a, le64toh(array->entry_array.items[0]), t, subtract_one ? (i > 0 ? i-1 : UINT64_MAX) : i);
+        chain_cache_put(f->chain_cache, ci, first, a, journal_file_entry_array_item(f, array, 0), t, subtract_one ? (i > 0 ? i-1 : UINT64_MAX) : i);
 
         if (subtract_one && i == 0)
                 p = last_p;
         else if (subtract_one)
-                p = le64toh(array->entry_array.items[i-1]);
+                p = journal_file_entry_array_item(f, array, i-1);
         else
-                p = le64toh(array->entry_array.items[i]);
+                p = journal_file_entry_array_item(f, array, i);
 
         r = journal_file_move_to_object(f, OBJECT_ENTRY, p, &o);
         if (r < 0)
@@ -2704,6 +3529,147 @@ static int test_object_realtime(JournalFile *f, uint64_t p, uint64_t needle) {
                 return TEST_RIGHT;
 }
 
+int journal_file_append_realtime_index(JournalFile *f) {
+        uint64_t a, n = 0, i = 0, t = 0, q;
+        Object *o, *array;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        /* Adds a sparse index of the main entry array chain to the file. Since entry arrays are never
+         * modified other than by appending items, and the chain is only ever extended at the end, the
+         * index stays valid when more entries are added later, it just won't cover the new arrays. */
+
+        if (!f->writable)
+                return -EPERM;
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset))
+                return -EOPNOTSUPP;
+
+        /* Older versions of the verifier refuse to authenticate objects they don't know */
+        if (JOURNAL_HEADER_SEALED(f->header))
+                return -EOPNOTSUPP;
+
+        if (le64toh(f->header->realtime_index_offset) != 0)
+                return 0;
+
+        /* First, count the arrays in the chain */
+        for (a = le64toh(f->header->entry_array_offset); a > 0; a = le64toh(array->entry_array.next_entry_array_offset)) {
+                r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &array);
+                if (r < 0)
+                        return r;
+
+                if (n >= le64toh(f->header->n_entry_arrays))
+                        return -EBADMSG;
+
+                n++;
+        }
+
+        /* With a single array there's nothing to skip */
+        if (n <= 1)
+                return 0;
+
+        r = journal_file_append_object(f, OBJECT_REALTIME_INDEX, offsetof(Object, realtime_index.items) + n * sizeof(RealtimeIndexItem), &o, &q);
+        if (r < 0)
+                return r;
+
+        for (a = le64toh(f->header->entry_array_offset); a > 0 && i < n; a = le64toh(array->entry_array.next_entry_array_offset)) {
+                uint64_t p;
+                Object *e;
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &array);
+                if (r < 0)
+                        return r;
+
+                p = journal_file_entry_array_item(f, array, 0);
+                if (p == 0)
+                        break;
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY, p, &e);
+                if (r < 0)
+                        return r;
+
+                o->realtime_index.items[i++] = (RealtimeIndexItem) {
+                        .entry_array_offset = htole64(a),
+                        .first_entry_offset = htole64(p),
+                        .first_entry_realtime = e->entry.realtime,
+                        .n_preceding = htole64(t),
+                };
+
+                t += journal_file_entry_array_n_items(f, array);
+        }
+
+        if (i < n)
+                return -EBADMSG;
+
+        /* Only make the index visible to readers once it is complete */
+        __sync_synchronize();
+        f->header->realtime_index_offset = htole64(q);
+
+        return 0;
+}
+
+static void journal_file_seed_realtime_index(JournalFile *f, uint64_t realtime) {
+        uint64_t p, first, n, left, right;
+        const RealtimeIndexItem *item;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(f->header);
+
+        /* If the file carries a realtime index, look up the last array in the main entry array chain whose
+         * first entry is older than what we are looking for, and prime the chain cache with it, so that
+         * generic_array_bisect() can jump there right-away instead of walking the chain from the start. */
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset))
+                return;
+
+        p = le64toh(READ_NOW(f->header->realtime_index_offset));
+        if (p == 0)
+                return;
+
+        r = journal_file_move_to_object(f, OBJECT_REALTIME_INDEX, p, &o);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to read realtime index of %s, ignoring: %m", f->path);
+                return;
+        }
+
+        n = journal_file_realtime_index_n_items(o);
+
+        left = 0;
+        right = n;
+        while (left < right) {
+                uint64_t i = (left + right) / 2;
+
+                if (le64toh(o->realtime_index.items[i].first_entry_realtime) < realtime)
+                        left = i + 1;
+                else
+                        right = i;
+        }
+
+        /* Nothing to skip if the first array is the one to look at */
+        if (left <= 1)
+                return;
+
+        item = o->realtime_index.items + left - 1;
+        first = le64toh(f->header->entry_array_offset);
+
+        if (!VALID64(le64toh(item->entry_array_offset)) ||
+            !VALID64(le64toh(item->first_entry_offset)) ||
+            le64toh(item->n_preceding) >= le64toh(f->header->n_entries))
+                return;
+
+        chain_cache_put(f->chain_cache,
+                        ordered_hashmap_get(f->chain_cache, &first),
+                        first,
+                        le64toh(item->entry_array_offset),
+                        le64toh(item->first_entry_offset),
+                        le64toh(item->n_preceding),
+                        UINT64_MAX);
+}
+
 int journal_file_move_to_entry_by_realtime(
                 JournalFile *f,
                 uint64_t realtime,
@@ -2713,6 +3679,8 @@ int journal_file_move_to_entry_by_realtime(
         assert(f);
         assert(f->header);
 
+        journal_file_seed_realtime_index(f, realtime);
+
         return generic_array_bisect(
                         f,
                         le64toh(f->header->entry_array_offset),
@@ -3249,6 +4217,22 @@ void journal_file_dump(JournalFile *f) {
                                le64toh(o->tag.epoch));
                         break;
 
+                case OBJECT_DATA_BLOOM:
+                        printf("Type: OBJECT_DATA_BLOOM n_items=%"PRIu64" n_hashes=%"PRIu32"\n",
+                               le64toh(o->data_bloom.n_items),
+                               le32toh(o->data_bloom.n_hashes));
+                        break;
+
+                case OBJECT_REALTIME_INDEX:
+                        printf("Type: OBJECT_REALTIME_INDEX n_items=%"PRIu64"\n",
+                               journal_file_realtime_index_n_items(o));
+                        break;
+
+                case OBJECT_ZSTD_DICTIONARY:
+                        printf("Type: OBJECT_ZSTD_DICTIONARY id=%"PRIu32"\n",
+                               le32toh(o->zstd_dictionary.dictionary_id));
+                        break;
+
                 default:
                         printf("Type: unknown (%i)\n", o->object.type);
                         break;
@@ -3294,7 +4278,7 @@ void journal_file_print_header(JournalFile *f) {
                "Sequential number ID: %s\n"
                "State: %s\n"
                "Compatible flags:%s%s\n"
-               "Incompatible flags:%s%s%s%s%s\n"
+               "Incompatible flags:%s%s%s%s%s%s%s\n"
                "Header size: %"PRIu64"\n"
                "Arena size: %"PRIu64"\n"
                "Data hash table size: %"PRIu64"\n"
@@ -3321,6 +4305,8 @@ void journal_file_print_header(JournalFile *f) {
                JOURNAL_HEADER_COMPRESSED_LZ4(f->header) ? " COMPRESSED-LZ4" : "",
                JOURNAL_HEADER_COMPRESSED_ZSTD(f->header) ? " COMPRESSED-ZSTD" : "",
                JOURNAL_HEADER_KEYED_HASH(f->header) ? " KEYED-HASH" : "",
+               JOURNAL_HEADER_COMPACT(f->header) ? " COMPACT" : "",
+               JOURNAL_HEADER_ZSTD_DICTIONARY(f->header) ? " ZSTD-DICTIONARY" : "",
                (le32toh(f->header->incompatible_flags) & ~HEADER_INCOMPATIBLE_ANY) ? " ???" : "",
                le64toh(f->header->header_size),
                le64toh(f->header->arena_size),
@@ -3362,6 +4348,14 @@ void journal_file_print_header(JournalFile *f) {
                 printf("Deepest data hash chain: %" PRIu64"\n",
                        f->header->data_hash_chain_depth);
 
+        if (JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset))
+                printf("Data bloom filter: %s\n",
+                       f->header->data_bloom_offset != 0 ? "yes" : "no");
+
+        if (JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset))
+                printf("Realtime index: %s\n",
+                       f->header->realtime_index_offset != 0 ? "yes" : "no");
+
         if (fstat(f->fd, &st) >= 0)
                 printf("Disk usage: %s\n", format_bytes(bytes, sizeof(bytes), (uint64_t) st.st_blocks * 512ULL));
 }
@@ -3465,21 +4459,43 @@ int journal_file_open(
         } else
                 f->keyed_hash = r;
 
+        /* Compact files can't be read by older versions, hence they are opt-in for now */
+        r = getenv_bool("SYSTEMD_JOURNAL_COMPACT");
+        if (r < 0) {
+                if (r != -ENXIO)
+                        log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_COMPACT environment variable, ignoring.");
+                f->compact = false;
+        } else
+                f->compact = r;
+
+        /* ZSTD dictionaries are trained from the previous file, and can't be read by older versions either */
+        r = getenv_bool("SYSTEMD_JOURNAL_ZSTD_DICTIONARY");
+        if (r < 0) {
+                if (r != -ENXIO)
+                        log_debug_errno(r, "Failed to parse $SYSTEMD_JOURNAL_ZSTD_DICTIONARY environment variable, ignoring.");
+                f->zstd_dictionary = false;
+        } else
+                f->zstd_dictionary = r;
+
         if (DEBUG_LOGGING) {
-                static int last_seal = -1, last_compress = -1, last_keyed_hash = -1;
+                static int last_seal = -1, last_compress = -1, last_keyed_hash = -1, last_compact = -1, last_zstd_dictionary = -1;
                 static uint64_t last_bytes = UINT64_MAX;
                 char bytes[FORMAT_BYTES_MAX];
 
                 if (last_seal != f->seal ||
                     last_keyed_hash != f->keyed_hash ||
+                    last_compact != f->compact ||
+                    last_zstd_dictionary != f->zstd_dictionary ||
                     last_compress != JOURNAL_FILE_COMPRESS(f) ||
                     last_bytes != f->compress_threshold_bytes) {
 
-                        log_debug("Journal effective settings seal=%s keyed_hash=%s compress=%s compress_threshold_bytes=%s",
-                                  yes_no(f->seal), yes_no(f->keyed_hash), yes_no(JOURNAL_FILE_COMPRESS(f)),
-                                  format_bytes(bytes, sizeof bytes, f->compress_threshold_bytes));
+                        log_debug("Journal effective settings seal=%s keyed_hash=%s compact=%s compress=%s zstd_dictionary=%s compress_threshold_bytes=%s",
+                                  yes_no(f->seal), yes_no(f->keyed_hash), yes_no(f->compact), yes_no(JOURNAL_FILE_COMPRESS(f)),
+                                  yes_no(f->zstd_dictionary), format_bytes(bytes, sizeof bytes, f->compress_threshold_bytes));
                         last_seal = f->seal;
                         last_keyed_hash = f->keyed_hash;
+                        last_compact = f->compact;
+                        last_zstd_dictionary = f->zstd_dictionary;
                         last_compress = JOURNAL_FILE_COMPRESS(f);
                         last_bytes = f->compress_threshold_bytes;
                 }
@@ -3602,6 +4618,12 @@ int journal_file_open(
                 r = journal_file_verify_header(f);
                 if (r < 0)
                         goto fail;
+
+#if HAVE_ZSTD
+                r = journal_file_load_zstd_dictionary(f);
+                if (r < 0)
+                        goto fail;
+#endif
         }
 
 #if HAVE_GCRYPT
@@ -3639,6 +4661,15 @@ int journal_file_open(
                 if (r < 0)
                         goto fail;
 
+#if HAVE_ZSTD
+                /* Dictionaries are not covered by the first tag, hence don't use them in sealed files */
+                if (f->zstd_dictionary && f->compress_zstd && !f->seal && template) {
+                        r = journal_file_setup_zstd_dictionary(f, template);
+                        if (r < 0)
+                                goto fail;
+                }
+#endif
+
 #if HAVE_GCRYPT
                 r = journal_file_append_first_tag(f);
                 if (r < 0)
@@ -3704,9 +4735,6 @@ int journal_file_archive(JournalFile *f) {
         if (rename(f->path, p) < 0 && errno != ENOENT)
                 return -errno;
 
-        /* Sync the rename to disk */
-        (void) fsync_directory_of_file(f->fd);
-
         /* Set as archive so offlining commits w/state=STATE_ARCHIVED. Previously we would set old_file->header->state
          * to STATE_ARCHIVED directly here, but journal_file_set_offline() short-circuits when state != STATE_ONLINE,
          * which would result in the rotated journal never getting fsync() called before closing.  Now we simply queue
@@ -3865,7 +4893,7 @@ int journal_file_open_reliably(
 }
 
 int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint64_t p) {
-        uint64_t q, n, xor_hash = 0;
+        uint64_t n, xor_hash = 0;
         const sd_id128_t *boot_id;
         dual_timestamp ts;
         EntryItem *items;
@@ -3883,27 +4911,20 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
         ts.realtime = le64toh(o->entry.realtime);
         boot_id = &o->entry.boot_id;
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(from, o);
         /* alloca() can't take 0, hence let's allocate at least one */
         items = newa(EntryItem, MAX(1u, n));
 
         for (uint64_t i = 0; i < n; i++) {
                 uint64_t l, h;
-                le64_t le_hash;
                 size_t t;
                 void *data;
                 Object *u;
 
-                q = le64toh(o->entry.items[i].object_offset);
-                le_hash = o->entry.items[i].hash;
-
-                r = journal_file_move_to_object(from, OBJECT_DATA, q, &o);
+                r = journal_file_move_to_entry_item_data(from, o, i, &o, NULL);
                 if (r < 0)
                         return r;
 
-                if (le_hash != o->data.hash)
-                        return -EBADMSG;
-
                 l = le64toh(READ_NOW(o->object.size));
                 if (l < offsetof(Object, data.payload))
                         return -EBADMSG;
@@ -3919,7 +4940,8 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
 #if HAVE_COMPRESSION
                         size_t rsize = 0;
 
-                        r = decompress_blob(
+                        r = journal_file_decompress_blob(
+                                        from,
                                         o->object.flags & OBJECT_COMPRESSION_MASK,
                                         o->data.payload, l,
                                         &from->compress_buffer, &rsize,
@@ -3944,8 +4966,10 @@ int journal_file_copy_entry(JournalFile *from, JournalFile *to, Object *o, uint6
                 else
                         xor_hash ^= le64toh(u->data.hash);
 
-                items[i].object_offset = htole64(h);
-                items[i].hash = u->data.hash;
+                items[i] = (EntryItem) {
+                        .object_offset = h,
+                        .hash = le64toh(u->data.hash),
+                };
 
                 r = journal_file_move_to_object(from, OBJECT_ENTRY, p, &o);
                 if (r < 0)
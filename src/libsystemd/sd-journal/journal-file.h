@@ -72,10 +72,18 @@ typedef struct JournalFile {
         bool close_fd:1;
         bool archive:1;
         bool keyed_hash:1;
+        bool compact:1;
+        bool zstd_dictionary:1;
 
         direction_t last_direction;
         LocationType location_type;
         uint64_t last_n_entries;
+        unsigned prioq_idx; /* in sd_journal's queue of files with a candidate entry */
+
+        /* sd_journal's lookups of its matches in this file, indexed by Match.cache_index */
+        struct MatchCache *match_cache;
+        size_t n_match_cache;
+        unsigned match_cache_generation;
 
         char *path;
         struct stat last_stat;
@@ -99,16 +107,25 @@ typedef struct JournalFile {
         usec_t post_change_timer_period;
 
         OrderedHashmap *chain_cache;
+        struct DataCacheItem *data_cache;
 
         pthread_t offline_thread;
         volatile OfflineState offline_state;
+        /* Set while structures are appended to an archived file as part of offlining it */
+        bool post_processing;
 
         unsigned last_seen_generation;
 
         uint64_t compress_threshold_bytes;
+        /* Sizes of the payloads we compressed while appending, before and after compression */
+        uint64_t compress_bytes_in;
+        uint64_t compress_bytes_out;
 #if HAVE_COMPRESSION
         void *compress_buffer;
 #endif
+#if HAVE_ZSTD
+        struct ZstdDictionary *zstd_dict;
+#endif
 
 #if HAVE_GCRYPT
         gcry_md_hd_t hmac;
@@ -201,11 +218,48 @@ static inline bool VALID_EPOCH(uint64_t u) {
 #define JOURNAL_HEADER_KEYED_HASH(h) \
         FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_KEYED_HASH)
 
+#define JOURNAL_HEADER_COMPACT(h) \
+        FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_COMPACT)
+
+#define JOURNAL_HEADER_ZSTD_DICTIONARY(h) \
+        FLAGS_SET(le32toh((h)->incompatible_flags), HEADER_INCOMPATIBLE_ZSTD_DICTIONARY)
+
+/* Offsets in compact journal files are stored in 32bit, hence they may not grow beyond this */
+#define JOURNAL_COMPACT_SIZE_MAX ((uint64_t) UINT32_MAX)
+
 int journal_file_move_to_object(JournalFile *f, ObjectType type, uint64_t offset, Object **ret);
 
-uint64_t journal_file_entry_n_items(Object *o) _pure_;
-uint64_t journal_file_entry_array_n_items(Object *o) _pure_;
+static inline size_t journal_file_entry_item_size(JournalFile *f) {
+        assert(f);
+        return JOURNAL_HEADER_COMPACT(f->header) ? sizeof_field(Object, entry.items.compact[0]) :
+                                                   sizeof_field(Object, entry.items.regular[0]);
+}
+
+static inline uint64_t journal_file_entry_item_object_offset(JournalFile *f, Object *o, size_t i) {
+        assert(f);
+        assert(o);
+        return JOURNAL_HEADER_COMPACT(f->header) ? le32toh(o->entry.items.compact[i].object_offset) :
+                                                   le64toh(o->entry.items.regular[i].object_offset);
+}
+
+static inline size_t journal_file_entry_array_item_size(JournalFile *f) {
+        assert(f);
+        return JOURNAL_HEADER_COMPACT(f->header) ? sizeof(le32_t) : sizeof(le64_t);
+}
+
+static inline uint64_t journal_file_entry_array_item(JournalFile *f, Object *o, size_t i) {
+        assert(f);
+        assert(o);
+        return JOURNAL_HEADER_COMPACT(f->header) ? le32toh(o->entry_array.items.compact[i]) :
+                                                   le64toh(o->entry_array.items.regular[i]);
+}
+
+uint64_t journal_file_entry_n_items(JournalFile *f, Object *o) _pure_;
+uint64_t journal_file_entry_array_n_items(JournalFile *f, Object *o) _pure_;
 uint64_t journal_file_hash_table_n_items(Object *o) _pure_;
+uint64_t journal_file_realtime_index_n_items(Object *o) _pure_;
+
+int journal_file_move_to_entry_item_data(JournalFile *f, Object *o, uint64_t i, Object **ret, uint64_t *ret_offset);
 
 int journal_file_append_object(JournalFile *f, ObjectType type, uint64_t size, Object **ret, uint64_t *offset);
 int journal_file_append_entry(
@@ -217,6 +271,33 @@ int journal_file_append_entry(
                 Object **ret,
                 uint64_t *offset);
 
+typedef struct JournalFileEntry {
+        const dual_timestamp *ts;
+        const sd_id128_t *boot_id;
+        const struct iovec *iovec;
+        unsigned n_iovec;
+} JournalFileEntry;
+
+int journal_file_append_entries(
+                JournalFile *f,
+                const JournalFileEntry entries[], size_t n_entries,
+                uint64_t *seqno,
+                size_t *ret_n_appended);
+
+static inline uint64_t journal_file_data_bloom_bit(uint64_t hash, uint32_t i, uint64_t n_bits) {
+        /* Derives the i-th bit position from the two halves of the 64bit data hash (Kirsch-Mitzenmacher
+         * double hashing), so that we don't have to hash the payload more than once. */
+        uint64_t h1 = (uint32_t) hash, h2 = (uint32_t) (hash >> 32) | 1;
+
+        assert(n_bits > 0);
+        return (h1 + (uint64_t) i * h2) % n_bits;
+}
+
+int journal_file_append_data_bloom(JournalFile *f);
+int journal_file_data_bloom_test(JournalFile *f, uint64_t hash);
+
+int journal_file_append_realtime_index(JournalFile *f);
+
 int journal_file_find_data_object(JournalFile *f, const void *data, uint64_t size, Object **ret, uint64_t *offset);
 int journal_file_find_data_object_with_hash(JournalFile *f, const void *data, uint64_t size, uint64_t hash, Object **ret, uint64_t *offset);
 
@@ -271,4 +352,17 @@ static inline bool JOURNAL_FILE_COMPRESS(JournalFile *f) {
 
 uint64_t journal_file_hash_data(JournalFile *f, const void *data, size_t sz);
 
+int journal_file_decompress_blob(
+                JournalFile *f,
+                int compression,
+                const void *src, uint64_t src_size,
+                void **dst, size_t *dst_size, size_t dst_max);
+int journal_file_decompress_startswith(
+                JournalFile *f,
+                int compression,
+                const void *src, uint64_t src_size,
+                void **buffer,
+                const void *prefix, size_t prefix_len,
+                uint8_t extra);
+
 bool journal_field_valid(const char *p, size_t l, bool allow_protected);
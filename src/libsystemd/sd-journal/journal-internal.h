@@ -12,6 +12,7 @@
 #include "journal-def.h"
 #include "journal-file.h"
 #include "list.h"
+#include "prioq.h"
 #include "set.h"
 
 typedef struct Match Match;
@@ -36,8 +37,25 @@ struct Match {
 
         /* For terms */
         LIST_HEAD(Match, matches);
+
+        /* For concrete matches, index into the per-file lookup caches */
+        unsigned cache_index;
 };
 
+typedef struct MatchCache {
+        /* The data object of a concrete match in a file, and the file's number of data objects when it
+         * was looked up, so that a negative result can be trusted until new data objects show up. */
+        bool data_looked_up:1;
+        uint64_t data_offset;
+        uint64_t n_data;
+
+        /* The result of the last lookup of the next entry referencing the data object: the entry at
+         * 'entry_offset' was the first one at or beyond 'after_offset' in 'direction'. */
+        direction_t direction;
+        uint64_t after_offset;
+        uint64_t entry_offset;
+} MatchCache;
+
 struct Location {
         LocationType type;
 
@@ -80,7 +98,12 @@ struct sd_journal {
         JournalFile *current_file;
         uint64_t current_field;
 
+        /* Files with a candidate entry, ordered by their location in files_prioq_direction */
+        Prioq *files_prioq;
+        direction_t files_prioq_direction;
+
         Match *level0, *level1, *level2;
+        unsigned n_match_caches, match_generation;
 
         pid_t original_pid;
 
@@ -112,17 +135,30 @@ struct sd_journal {
         bool fields_file_lost:1;
         bool has_runtime_files:1;
         bool has_persistent_files:1;
+        bool files_prioq_valid:1;
 
         size_t data_threshold;
 
+#if HAVE_COMPRESSION
+        /* Decompressed data returned to the caller lives here. Shared by all files, since returned data
+         * is only valid until the next call anyway. */
+        void *compress_buffer;
+#endif
+
         Hashmap *directories_by_path;
         Hashmap *directories_by_wd;
 
         Hashmap *errors;
 };
 
+typedef struct JournalBoot {
+        sd_id128_t id;
+        usec_t first, last; /* realtime of the first and last entry */
+} JournalBoot;
+
 char *journal_make_match_string(sd_journal *j);
 void journal_print_header(sd_journal *j);
+int journal_get_boots(sd_journal *j, JournalBoot **ret, size_t *ret_n);
 
 #define JOURNAL_FOREACH_DATA_RETVAL(j, data, l, retval)                     \
         for (sd_journal_restart_data(j); ((retval) = sd_journal_enumerate_data((j), &(data), &(l))) > 0; )
@@ -155,10 +155,10 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                         _cleanup_free_ void *b = NULL;
                         size_t b_size;
 
-                        r = decompress_blob(compression,
-                                            o->data.payload,
-                                            le64toh(o->object.size) - offsetof(Object, data.payload),
-                                            &b, &b_size, 0);
+                        r = journal_file_decompress_blob(f, compression,
+                                                         o->data.payload,
+                                                         le64toh(o->object.size) - offsetof(Object, data.payload),
+                                                         &b, &b_size, 0);
                         if (r < 0) {
                                 error_errno(offset, r, "%s decompression failed: %m",
                                             object_compressed_to_string(compression));
@@ -209,7 +209,7 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                 break;
 
         case OBJECT_ENTRY:
-                if ((le64toh(o->object.size) - offsetof(EntryObject, items)) % sizeof(EntryItem) != 0) {
+                if ((le64toh(o->object.size) - offsetof(EntryObject, items)) % journal_file_entry_item_size(f) != 0) {
                         error(offset,
                               "Bad entry size (<= %zu): %"PRIu64,
                               offsetof(EntryObject, items),
@@ -217,10 +217,10 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                         return -EBADMSG;
                 }
 
-                if ((le64toh(o->object.size) - offsetof(EntryObject, items)) / sizeof(EntryItem) <= 0) {
+                if ((le64toh(o->object.size) - offsetof(EntryObject, items)) / journal_file_entry_item_size(f) <= 0) {
                         error(offset,
                               "Invalid number items in entry: %"PRIu64,
-                              (le64toh(o->object.size) - offsetof(EntryObject, items)) / sizeof(EntryItem));
+                              (le64toh(o->object.size) - offsetof(EntryObject, items)) / journal_file_entry_item_size(f));
                         return -EBADMSG;
                 }
 
@@ -245,13 +245,13 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                         return -EBADMSG;
                 }
 
-                for (i = 0; i < journal_file_entry_n_items(o); i++) {
-                        if (le64toh(o->entry.items[i].object_offset) == 0 ||
-                            !VALID64(le64toh(o->entry.items[i].object_offset))) {
+                for (i = 0; i < journal_file_entry_n_items(f, o); i++) {
+                        if (journal_file_entry_item_object_offset(f, o, i) == 0 ||
+                            !VALID64(journal_file_entry_item_object_offset(f, o, i))) {
                                 error(offset,
                                       "Invalid entry item (%"PRIu64"/%"PRIu64" offset: "OFSfmt,
-                                      i, journal_file_entry_n_items(o),
-                                      le64toh(o->entry.items[i].object_offset));
+                                      i, journal_file_entry_n_items(f, o),
+                                      journal_file_entry_item_object_offset(f, o, i));
                                 return -EBADMSG;
                         }
                 }
@@ -319,13 +319,13 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                         return -EBADMSG;
                 }
 
-                for (i = 0; i < journal_file_entry_array_n_items(o); i++)
-                        if (le64toh(o->entry_array.items[i]) != 0 &&
-                            !VALID64(le64toh(o->entry_array.items[i]))) {
+                for (i = 0; i < journal_file_entry_array_n_items(f, o); i++)
+                        if (journal_file_entry_array_item(f, o, i) != 0 &&
+                            !VALID64(journal_file_entry_array_item(f, o, i))) {
                                 error(offset,
                                       "Invalid object entry array item (%"PRIu64"/%"PRIu64"): "OFSfmt,
-                                      i, journal_file_entry_array_n_items(o),
-                                      le64toh(o->entry_array.items[i]));
+                                      i, journal_file_entry_array_n_items(f, o),
+                                      journal_file_entry_array_item(f, o, i));
                                 return -EBADMSG;
                         }
 
@@ -346,6 +346,60 @@ static int journal_file_object_verify(JournalFile *f, uint64_t offset, Object *o
                         return -EBADMSG;
                 }
 
+                break;
+
+        case OBJECT_DATA_BLOOM:
+                if (le64toh(o->object.size) <= offsetof(DataBloomObject, bits) ||
+                    (le64toh(o->object.size) - offsetof(DataBloomObject, bits)) % sizeof(le64_t) != 0) {
+                        error(offset,
+                              "Invalid data bloom filter size: %"PRIu64,
+                              le64toh(o->object.size));
+                        return -EBADMSG;
+                }
+
+                if (le32toh(o->data_bloom.n_hashes) <= 0) {
+                        error(offset,
+                              "Invalid number of data bloom filter hashes: %"PRIu32,
+                              le32toh(o->data_bloom.n_hashes));
+                        return -EBADMSG;
+                }
+
+                break;
+
+        case OBJECT_REALTIME_INDEX:
+                if (le64toh(o->object.size) < offsetof(RealtimeIndexObject, items) ||
+                    (le64toh(o->object.size) - offsetof(RealtimeIndexObject, items)) % sizeof(RealtimeIndexItem) != 0 ||
+                    journal_file_realtime_index_n_items(o) <= 0) {
+                        error(offset,
+                              "Invalid realtime index size: %"PRIu64,
+                              le64toh(o->object.size));
+                        return -EBADMSG;
+                }
+
+                for (i = 0; i < journal_file_realtime_index_n_items(o); i++)
+                        if (!VALID64(le64toh(o->realtime_index.items[i].entry_array_offset)) ||
+                            !VALID64(le64toh(o->realtime_index.items[i].first_entry_offset))) {
+                                error(offset,
+                                      "Invalid realtime index item (%"PRIu64"/%"PRIu64")",
+                                      i, journal_file_realtime_index_n_items(o));
+                                return -EBADMSG;
+                        }
+
+                break;
+
+        case OBJECT_ZSTD_DICTIONARY:
+                if (le64toh(o->object.size) <= offsetof(ZstdDictionaryObject, payload)) {
+                        error(offset,
+                              "Invalid ZSTD dictionary size: %"PRIu64,
+                              le64toh(o->object.size));
+                        return -EBADMSG;
+                }
+
+                if (le32toh(o->zstd_dictionary.dictionary_id) == 0) {
+                        error(offset, "Invalid ZSTD dictionary ID");
+                        return -EBADMSG;
+                }
+
                 break;
         }
 
@@ -422,9 +476,9 @@ static int entry_points_to_data(
         if (r < 0)
                 return r;
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         for (i = 0; i < n; i++)
-                if (le64toh(o->entry.items[i].object_offset) == data_p) {
+                if (journal_file_entry_item_object_offset(f, o, i) == data_p) {
                         found = true;
                         break;
                 }
@@ -449,10 +503,10 @@ static int entry_points_to_data(
                 if (r < 0)
                         return r;
 
-                m = journal_file_entry_array_n_items(o);
+                m = journal_file_entry_array_n_items(f, o);
                 u = MIN(n - i, m);
 
-                if (entry_p <= le64toh(o->entry_array.items[u-1])) {
+                if (entry_p <= journal_file_entry_array_item(f, o, u-1)) {
                         uint64_t x, y, z;
 
                         x = 0;
@@ -461,13 +515,13 @@ static int entry_points_to_data(
                         while (x < y) {
                                 z = (x + y) / 2;
 
-                                if (le64toh(o->entry_array.items[z]) == entry_p)
+                                if (journal_file_entry_array_item(f, o, z) == entry_p)
                                         return 0;
 
                                 if (x + 1 >= y)
                                         break;
 
-                                if (entry_p < le64toh(o->entry_array.items[z]))
+                                if (entry_p < journal_file_entry_array_item(f, o, z))
                                         y = z;
                                 else
                                         x = z;
@@ -542,10 +596,10 @@ static int verify_data(
                         return -EBADMSG;
                 }
 
-                m = journal_file_entry_array_n_items(o);
+                m = journal_file_entry_array_n_items(f, o);
                 for (j = 0; i < n && j < m; i++, j++) {
 
-                        q = le64toh(o->entry_array.items[j]);
+                        q = journal_file_entry_array_item(f, o, j);
                         if (q <= last) {
                                 error(p, "Data object's entry array not sorted");
                                 return -EBADMSG;
@@ -568,6 +622,72 @@ static int verify_data(
         return 0;
 }
 
+static int verify_realtime_index(JournalFile *f) {
+        uint64_t p, a, n, i, t = 0;
+        Object *o, *array;
+        int r;
+
+        assert(f);
+
+        /* Checks that the realtime index matches the main entry array chain. The index may cover only a
+         * prefix of the chain, since arrays might have been added after it was written. */
+
+        if (!JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset))
+                return 0;
+
+        p = le64toh(f->header->realtime_index_offset);
+        if (p == 0)
+                return 0;
+
+        r = journal_file_move_to_object(f, OBJECT_REALTIME_INDEX, p, &o);
+        if (r < 0)
+                return r;
+
+        n = journal_file_realtime_index_n_items(o);
+        a = le64toh(f->header->entry_array_offset);
+
+        for (i = 0; i < n; i++) {
+                const RealtimeIndexItem *item = o->realtime_index.items + i;
+                uint64_t q;
+                Object *e;
+
+                if (a == 0) {
+                        error(p, "Realtime index has more items than the entry array chain");
+                        return -EBADMSG;
+                }
+
+                if (le64toh(item->entry_array_offset) != a ||
+                    le64toh(item->n_preceding) != t) {
+                        error(p, "Realtime index item %"PRIu64" doesn't match entry array chain", i);
+                        return -EBADMSG;
+                }
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY_ARRAY, a, &array);
+                if (r < 0)
+                        return r;
+
+                q = journal_file_entry_array_item(f, array, 0);
+                if (le64toh(item->first_entry_offset) != q) {
+                        error(p, "Realtime index item %"PRIu64" has wrong first entry", i);
+                        return -EBADMSG;
+                }
+
+                t += journal_file_entry_array_n_items(f, array);
+                a = le64toh(array->entry_array.next_entry_array_offset);
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY, q, &e);
+                if (r < 0)
+                        return r;
+
+                if (e->entry.realtime != item->first_entry_realtime) {
+                        error(p, "Realtime index item %"PRIu64" has wrong timestamp", i);
+                        return -EBADMSG;
+                }
+        }
+
+        return 0;
+}
+
 static int verify_hash_table(
                 JournalFile *f,
                 MMapFileDescriptor *cache_data_fd, uint64_t n_data,
@@ -624,6 +744,14 @@ static int verify_hash_table(
                                 return -EBADMSG;
                         }
 
+                        r = journal_file_data_bloom_test(f, le64toh(o->data.hash));
+                        if (r < 0)
+                                return r;
+                        if (r == 0) {
+                                error(p, "Data object missing from data bloom filter");
+                                return -EBADMSG;
+                        }
+
                         r = verify_data(f, o, p, cache_entry_fd, n_entries, cache_entry_array_fd, n_entry_arrays);
                         if (r < 0)
                                 return r;
@@ -685,13 +813,15 @@ static int verify_entry(
         assert(o);
         assert(cache_data_fd);
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         for (i = 0; i < n; i++) {
                 uint64_t q, h;
                 Object *u;
 
-                q = le64toh(o->entry.items[i].object_offset);
-                h = le64toh(o->entry.items[i].hash);
+                q = journal_file_entry_item_object_offset(f, o, i);
+                /* Compact files don't store a copy of the hash in the entry item, take it from the data
+                 * object below instead */
+                h = JOURNAL_HEADER_COMPACT(f->header) ? 0 : le64toh(o->entry.items.regular[i].hash);
 
                 if (!contains_uint64(f->mmap, cache_data_fd, n_data, q)) {
                         error(p, "Invalid data object of entry");
@@ -702,7 +832,9 @@ static int verify_entry(
                 if (r < 0)
                         return r;
 
-                if (le64toh(u->data.hash) != h) {
+                if (JOURNAL_HEADER_COMPACT(f->header))
+                        h = le64toh(u->data.hash);
+                else if (le64toh(u->data.hash) != h) {
                         error(p, "Hash mismatch for data object of entry");
                         return -EBADMSG;
                 }
@@ -765,11 +897,11 @@ static int verify_entry_array(
                         return -EBADMSG;
                 }
 
-                m = journal_file_entry_array_n_items(o);
+                m = journal_file_entry_array_n_items(f, o);
                 for (j = 0; i < n && j < m; i++, j++) {
                         uint64_t p;
 
-                        p = le64toh(o->entry_array.items[j]);
+                        p = journal_file_entry_array_item(f, o, j);
                         if (p <= last) {
                                 error(a, "Entry array not sorted at %"PRIu64" of %"PRIu64, i, n);
                                 return -EBADMSG;
@@ -812,7 +944,7 @@ int journal_file_verify(
 
         uint64_t entry_seqnum = 0, entry_monotonic = 0, entry_realtime = 0;
         sd_id128_t entry_boot_id;
-        bool entry_seqnum_set = false, entry_monotonic_set = false, entry_realtime_set = false, found_main_entry_array = false;
+        bool entry_seqnum_set = false, entry_monotonic_set = false, entry_realtime_set = false, found_main_entry_array = false, found_data_bloom = false, found_realtime_index = false, found_zstd_dictionary = false;
         uint64_t n_weird = 0, n_objects = 0, n_entries = 0, n_data = 0, n_fields = 0, n_data_hash_tables = 0, n_field_hash_tables = 0, n_entry_arrays = 0, n_tags = 0;
         usec_t last_usec = 0;
         int data_fd = -1, entry_fd = -1, entry_array_fd = -1;
@@ -1166,6 +1298,35 @@ int journal_file_verify(
                         n_tags++;
                         break;
 
+                case OBJECT_DATA_BLOOM:
+                        if (JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset) &&
+                            p == le64toh(f->header->data_bloom_offset)) {
+                                if (le64toh(o->data_bloom.n_items) != n_data) {
+                                        error(p, "Data bloom filter covers %"PRIu64" data objects, but %"PRIu64" precede it",
+                                              le64toh(o->data_bloom.n_items), n_data);
+                                        r = -EBADMSG;
+                                        goto fail;
+                                }
+
+                                found_data_bloom = true;
+                        }
+
+                        break;
+
+                case OBJECT_REALTIME_INDEX:
+                        if (JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset) &&
+                            p == le64toh(f->header->realtime_index_offset))
+                                found_realtime_index = true;
+
+                        break;
+
+                case OBJECT_ZSTD_DICTIONARY:
+                        if (JOURNAL_HEADER_CONTAINS(f->header, zstd_dictionary_offset) &&
+                            p == le64toh(f->header->zstd_dictionary_offset))
+                                found_zstd_dictionary = true;
+
+                        break;
+
                 default:
                         n_weird++;
                 }
@@ -1230,6 +1391,27 @@ int journal_file_verify(
                 goto fail;
         }
 
+        if (JOURNAL_HEADER_CONTAINS(f->header, data_bloom_offset) &&
+            !found_data_bloom && le64toh(f->header->data_bloom_offset) != 0) {
+                error(le64toh(f->header->data_bloom_offset), "Data bloom filter pointer dead");
+                r = -EBADMSG;
+                goto fail;
+        }
+
+        if (JOURNAL_HEADER_CONTAINS(f->header, realtime_index_offset) &&
+            !found_realtime_index && le64toh(f->header->realtime_index_offset) != 0) {
+                error(le64toh(f->header->realtime_index_offset), "Realtime index pointer dead");
+                r = -EBADMSG;
+                goto fail;
+        }
+
+        if (JOURNAL_HEADER_ZSTD_DICTIONARY(f->header) && !found_zstd_dictionary) {
+                error(JOURNAL_HEADER_CONTAINS(f->header, zstd_dictionary_offset) ? le64toh(f->header->zstd_dictionary_offset) : 0,
+                      "ZSTD dictionary pointer dead");
+                r = -EBADMSG;
+                goto fail;
+        }
+
         if (entry_seqnum_set &&
             entry_seqnum != le64toh(f->header->tail_entry_seqnum)) {
                 error(offsetof(Header, tail_entry_seqnum), "Invalid tail seqnum");
@@ -1268,6 +1450,10 @@ int journal_file_verify(
         if (r < 0)
                 goto fail;
 
+        r = verify_realtime_index(f);
+        if (r < 0)
+                goto fail;
+
         r = verify_hash_table(f,
                               cache_data_fd, n_data,
                               cache_entry_fd, n_entries,
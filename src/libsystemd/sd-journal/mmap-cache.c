@@ -7,6 +7,7 @@
 #include "alloc-util.h"
 #include "errno-util.h"
 #include "fd-util.h"
+#include "format-util.h"
 #include "hashmap.h"
 #include "list.h"
 #include "log.h"
@@ -17,6 +18,7 @@
 
 typedef struct Window Window;
 typedef struct Context Context;
+typedef struct AccessState AccessState;
 
 struct Window {
         MMapCache *cache;
@@ -45,17 +47,28 @@ struct Context {
         LIST_FIELDS(Context, by_window);
 };
 
+struct AccessState {
+        /* Location and size of the most recently created window, and the size to use for the next one */
+        uint64_t last_woffset;
+        uint64_t last_wsize;
+        uint64_t window_size;
+};
+
 struct MMapFileDescriptor {
         MMapCache *cache;
         int fd;
         int prot;
         bool sigbus;
         LIST_HEAD(Window, windows);
+
+        /* Most recently created window for each context, used to detect sequential access */
+        AccessState access[MMAP_CACHE_MAX_CONTEXTS];
 };
 
 struct MMapCache {
         unsigned n_ref;
         unsigned n_windows;
+        uint64_t n_mapped_bytes;
 
         unsigned n_context_cache_hit, n_window_list_hit, n_missed;
 
@@ -71,10 +84,22 @@ struct MMapCache {
 #if ENABLE_DEBUG_MMAP_CACHE
 /* Tiny windows increase mmap activity and the chance of exposing unsafe use. */
 # define WINDOW_SIZE (page_size())
+# define WINDOW_SIZE_MAX WINDOW_SIZE
 #else
 # define WINDOW_SIZE (8ULL*1024ULL*1024ULL)
+/* When a file is read sequentially the window size is doubled on each new window, up to this limit */
+# define WINDOW_SIZE_MAX (128ULL*1024ULL*1024ULL)
 #endif
 
+/* The total amount of address space we try to stay below. If we go beyond it, unused windows are
+ * released first, and new windows fall back to the default size. */
+#define MAPPED_BYTES_MAX (sizeof(void*) >= 8 ? 4ULL*1024ULL*1024ULL*1024ULL : 256ULL*1024ULL*1024ULL)
+
+/* The SIGBUS queue is process-global, but journald runs a private cache on the offline thread while the
+ * main one is in use. Count the live caches so that a page one of them doesn't own can be left for the
+ * others rather than treated as fatal. */
+static unsigned n_mmap_caches = 0;
+
 MMapCache* mmap_cache_new(void) {
         MMapCache *m;
 
@@ -83,6 +108,7 @@ MMapCache* mmap_cache_new(void) {
                 return NULL;
 
         m->n_ref = 1;
+        __sync_fetch_and_add(&n_mmap_caches, 1);
         return m;
 }
 
@@ -91,8 +117,10 @@ static void window_unlink(Window *w) {
 
         assert(w);
 
-        if (w->ptr)
+        if (w->ptr) {
                 munmap(w->ptr, w->size);
+                w->cache->n_mapped_bytes -= w->size;
+        }
 
         if (w->fd)
                 LIST_REMOVE(by_fd, w->fd->windows, w);
@@ -182,6 +210,7 @@ static Window *window_add(MMapCache *m, MMapFileDescriptor *f, bool keep_always,
         };
 
         LIST_PREPEND(by_fd, f->windows, w);
+        m->n_mapped_bytes += size;
 
         return w;
 }
@@ -284,6 +313,7 @@ static MMapCache *mmap_cache_free(MMapCache *m) {
         while (m->unused)
                 window_free(m->unused);
 
+        __sync_fetch_and_sub(&n_mmap_caches, 1);
         return mfree(m);
 }
 
@@ -408,6 +438,28 @@ static int mmap_try_harder(MMapCache *m, void *addr, MMapFileDescriptor *f, int
         return 0;
 }
 
+static int access_direction(const AccessState *a, uint64_t offset, size_t size) {
+        assert(a);
+
+        /* Checks whether the requested range directly follows (returns > 0) or directly precedes
+         * (returns < 0) the window we created last for this file and context, i.e. whether we are being read
+         * sequentially. Returns 0 for anything that looks like random access. */
+
+        if (a->last_wsize == 0)
+                return 0;
+
+        if (offset >= a->last_woffset &&
+            offset + size > a->last_woffset + a->last_wsize &&
+            offset < a->last_woffset + 2 * a->last_wsize)
+                return 1;
+
+        if (offset < a->last_woffset &&
+            a->last_woffset - offset <= a->last_wsize)
+                return -1;
+
+        return 0;
+}
+
 static int add_mmap(
                 MMapCache *m,
                 MMapFileDescriptor *f,
@@ -419,10 +471,11 @@ static int add_mmap(
                 void **ret) {
 
         uint64_t woffset, wsize;
+        int direction, r;
+        AccessState *a;
         Context *c;
         Window *w;
         void *d;
-        int r;
 
         assert(m);
         assert(m->n_ref > 0);
@@ -434,17 +487,42 @@ static int add_mmap(
         wsize = size + (offset - woffset);
         wsize = PAGE_ALIGN(wsize);
 
-        if (wsize < WINDOW_SIZE) {
+        a = &f->access[context];
+
+        direction = access_direction(a, offset, size);
+        if (direction != 0)
+                /* Sequential access, grow the window so that we need fewer of them */
+                a->window_size = MIN(MAX(a->window_size, WINDOW_SIZE) * 2, WINDOW_SIZE_MAX);
+        else
+                a->window_size = WINDOW_SIZE;
+
+        /* If we are above our address space budget, release unused windows first, and if that's not
+         * enough, don't make things worse by creating a large window. */
+        while (m->n_mapped_bytes + a->window_size > MAPPED_BYTES_MAX)
+                if (make_room(m) <= 0) {
+                        a->window_size = WINDOW_SIZE;
+                        break;
+                }
+
+        if (wsize < a->window_size) {
                 uint64_t delta;
 
-                delta = PAGE_ALIGN((WINDOW_SIZE - wsize) / 2);
+                if (direction > 0)
+                        /* Moving forward, hence map what comes next */
+                        delta = 0;
+                else if (direction < 0)
+                        /* Moving backwards, hence map what comes before */
+                        delta = a->window_size - wsize;
+                else
+                        /* Random access, center the window around the requested range */
+                        delta = PAGE_ALIGN((a->window_size - wsize) / 2);
 
-                if (delta > offset)
+                if (delta > woffset)
                         woffset = 0;
                 else
                         woffset -= delta;
 
-                wsize = WINDOW_SIZE;
+                wsize = a->window_size;
         }
 
         if (st) {
@@ -463,6 +541,16 @@ static int add_mmap(
         if (r < 0)
                 return r;
 
+        if (direction != 0) {
+                /* We are being read sequentially, hence tell the kernel to read ahead aggressively, and
+                 * to start reading in the whole window right away, so that we don't take a synchronous
+                 * page fault for each page while walking through it. Both calls are just hints, hence
+                 * ignore failures. */
+                if (direction > 0)
+                        (void) madvise(d, wsize, MADV_SEQUENTIAL);
+                (void) madvise(d, wsize, MADV_WILLNEED);
+        }
+
         c = context_add(m, context);
         if (!c)
                 goto outofmem;
@@ -473,6 +561,9 @@ static int add_mmap(
 
         context_attach_window(c, w);
 
+        a->last_woffset = woffset;
+        a->last_wsize = wsize;
+
         *ret = (uint8_t*) w->ptr + (offset - w->offset);
 
         return 1;
@@ -522,12 +613,38 @@ int mmap_cache_get(
 }
 
 void mmap_cache_stats_log_debug(MMapCache *m) {
+        char buf[FORMAT_BYTES_MAX];
+
         assert(m);
 
-        log_debug("mmap cache statistics: %u context cache hit, %u window list hit, %u miss", m->n_context_cache_hit, m->n_window_list_hit, m->n_missed);
+        log_debug("mmap cache statistics: %u context cache hit, %u window list hit, %u miss, %u windows, %s mapped",
+                  m->n_context_cache_hit, m->n_window_list_hit, m->n_missed, m->n_windows, format_bytes(buf, sizeof(buf), m->n_mapped_bytes));
+}
+
+void mmap_cache_trim(MMapCache *m) {
+        assert(m);
+
+        /* Unmap all windows not currently in use by any context */
+        while (m->unused)
+                window_free(m->unused);
+}
+
+void mmap_cache_get_statistics(MMapCache *m, MMapCacheStatistics *ret) {
+        assert(m);
+        assert(ret);
+
+        *ret = (MMapCacheStatistics) {
+                .n_context_cache_hit = m->n_context_cache_hit,
+                .n_window_list_hit = m->n_window_list_hit,
+                .n_missed = m->n_missed,
+                .n_windows = m->n_windows,
+                .n_mapped_bytes = m->n_mapped_bytes,
+        };
 }
 
 static void mmap_cache_process_sigbus(MMapCache *m) {
+        void *foreign[SIGBUS_QUEUE_MAX];
+        size_t n_foreign = 0;
         bool found = false;
         MMapFileDescriptor *f;
         int r;
@@ -564,13 +681,22 @@ static void mmap_cache_process_sigbus(MMapCache *m) {
                                 break;
                 }
 
-                /* Didn't find a matching window, give up */
-                if (!ours) {
+                if (ours)
+                        continue;
+
+                /* Didn't find a matching window. If another cache is alive the page might be one of
+                 * its windows, so put it back once we are done popping. Otherwise give up. */
+                if (__sync_add_and_fetch(&n_mmap_caches, 0) <= 1 || n_foreign >= ELEMENTSOF(foreign)) {
                         log_error("Unknown SIGBUS page, aborting.");
                         abort();
                 }
+
+                foreign[n_foreign++] = addr;
         }
 
+        for (size_t i = 0; i < n_foreign; i++)
+                sigbus_push(foreign[i]);
+
         /* The list of triggered pages is now empty. Now, let's remap
          * all windows of the triggered file to anonymous maps, so
          * that no page of the file in question is triggered again, so
@@ -2,10 +2,11 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/stat.h>
 
 /* One context per object type, plus one of the header, plus one "additional" one */
-#define MMAP_CACHE_MAX_CONTEXTS 9
+#define MMAP_CACHE_MAX_CONTEXTS 12
 
 typedef struct MMapCache MMapCache;
 typedef struct MMapFileDescriptor MMapFileDescriptor;
@@ -26,6 +27,16 @@ int mmap_cache_get(
 MMapFileDescriptor * mmap_cache_add_fd(MMapCache *m, int fd, int prot);
 void mmap_cache_free_fd(MMapCache *m, MMapFileDescriptor *f);
 
+typedef struct MMapCacheStatistics {
+        unsigned n_context_cache_hit;
+        unsigned n_window_list_hit;
+        unsigned n_missed;
+        unsigned n_windows;
+        uint64_t n_mapped_bytes;
+} MMapCacheStatistics;
+
 void mmap_cache_stats_log_debug(MMapCache *m);
+void mmap_cache_trim(MMapCache *m);
+void mmap_cache_get_statistics(MMapCache *m, MMapCacheStatistics *ret);
 
 bool mmap_cache_got_sigbus(MMapCache *m, MMapFileDescriptor *f);
@@ -33,8 +33,10 @@
 #include "lookup3.h"
 #include "nulstr-util.h"
 #include "path-util.h"
+#include "prioq.h"
 #include "process-util.h"
 #include "replace-var.h"
+#include "sort-util.h"
 #include "stat-util.h"
 #include "stdio-util.h"
 #include "string-util.h"
@@ -105,6 +107,7 @@ static void detach_location(sd_journal *j) {
 
         j->current_file = NULL;
         j->current_field = 0;
+        j->files_prioq_valid = false;
 
         ORDERED_HASHMAP_FOREACH(f, j->files)
                 journal_file_reset_location(f);
@@ -312,6 +315,7 @@ _public_ int sd_journal_add_match(sd_journal *j, const void *data, size_t size)
 
         m->hash = hash;
         m->size = size;
+        m->cache_index = j->n_match_caches++;
         m->data = memdup(data, size);
         if (!m->data)
                 goto fail;
@@ -425,6 +429,10 @@ _public_ void sd_journal_flush_matches(sd_journal *j) {
 
         j->level0 = j->level1 = j->level2 = NULL;
 
+        /* Invalidate the per-file lookup caches of the matches we just freed */
+        j->n_match_caches = 0;
+        j->match_generation++;
+
         detach_location(j);
 }
 
@@ -481,6 +489,75 @@ _pure_ static int compare_with_location(const JournalFile *f, const Location *l,
         return 0;
 }
 
+static MatchCache *match_cache_get(sd_journal *j, Match *m, JournalFile *f) {
+        assert(j);
+        assert(m);
+        assert(m->type == MATCH_DISCRETE);
+        assert(f);
+
+        if (f->match_cache_generation != j->match_generation) {
+                f->n_match_cache = 0;
+                f->match_cache_generation = j->match_generation;
+        }
+
+        if (m->cache_index >= f->n_match_cache) {
+                /* If we can't allocate this, we just do without the cache */
+                if (!GREEDY_REALLOC(f->match_cache, m->cache_index + 1))
+                        return NULL;
+
+                memzero(f->match_cache + f->n_match_cache,
+                        (m->cache_index + 1 - f->n_match_cache) * sizeof(MatchCache));
+                f->n_match_cache = m->cache_index + 1;
+        }
+
+        return f->match_cache + m->cache_index;
+}
+
+static int match_find_data_object(sd_journal *j, Match *m, JournalFile *f, MatchCache *c, uint64_t *ret) {
+        uint64_t dp, hash, n_data;
+        int r;
+
+        assert(j);
+        assert(m);
+        assert(m->type == MATCH_DISCRETE);
+        assert(f);
+        assert(ret);
+
+        /* Looking up the data object means hashing the match (with the per-file key, if keyed hashing is
+         * used) and walking a hash chain. With many OR'ed matches that's done over and over again for every
+         * entry we advance by, hence remember the result. A missing data object might show up later in
+         * an online file, but only if the number of data objects changed. */
+
+        n_data = JOURNAL_HEADER_CONTAINS(f->header, n_data) ? le64toh(f->header->n_data) : UINT64_MAX;
+
+        if (c && c->data_looked_up && (c->data_offset != 0 || (n_data != UINT64_MAX && c->n_data == n_data))) {
+                *ret = c->data_offset;
+                return c->data_offset != 0;
+        }
+
+        /* If the keyed hash logic is used, we need to calculate the hash fresh per file. Otherwise
+         * we can use what we pre-calculated. */
+        if (JOURNAL_HEADER_KEYED_HASH(f->header))
+                hash = journal_file_hash_data(f, m->data, m->size);
+        else
+                hash = m->hash;
+
+        r = journal_file_find_data_object_with_hash(f, m->data, m->size, hash, NULL, &dp);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                dp = 0;
+
+        if (c) {
+                c->data_looked_up = true;
+                c->data_offset = dp;
+                c->n_data = n_data;
+        }
+
+        *ret = dp;
+        return r;
+}
+
 static int next_for_match(
                 sd_journal *j,
                 Match *m,
@@ -499,20 +576,35 @@ static int next_for_match(
         assert(f);
 
         if (m->type == MATCH_DISCRETE) {
-                uint64_t dp, hash;
+                MatchCache *c;
+                uint64_t dp;
 
-                /* If the keyed hash logic is used, we need to calculate the hash fresh per file. Otherwise
-                 * we can use what we pre-calculated. */
-                if (JOURNAL_HEADER_KEYED_HASH(f->header))
-                        hash = journal_file_hash_data(f, m->data, m->size);
-                else
-                        hash = m->hash;
+                c = match_cache_get(j, m, f);
 
-                r = journal_file_find_data_object_with_hash(f, m->data, m->size, hash, NULL, &dp);
+                r = match_find_data_object(j, m, f, c, &dp);
                 if (r <= 0)
                         return r;
 
-                return journal_file_move_to_entry_by_offset_for_data(f, dp, after_offset, direction, ret, offset);
+                /* If the entry we found last time is still at or beyond the offset, it's still the next
+                 * one. Entries are only ever appended, hence this holds for online files too. This makes
+                 * advancing an OR term with many matches cheap: only the matches whose candidate we
+                 * passed need to bisect their entry arrays again. */
+                if (c && c->entry_offset != 0 && c->direction == direction &&
+                    (direction == DIRECTION_DOWN ?
+                     c->after_offset <= after_offset && after_offset <= c->entry_offset :
+                     c->entry_offset <= after_offset && after_offset <= c->after_offset))
+                        np = c->entry_offset;
+                else {
+                        r = journal_file_move_to_entry_by_offset_for_data(f, dp, after_offset, direction, NULL, &np);
+                        if (r <= 0)
+                                return r;
+
+                        if (c) {
+                                c->direction = direction;
+                                c->after_offset = after_offset;
+                                c->entry_offset = np;
+                        }
+                }
 
         } else if (m->type == MATCH_OR_TERM) {
                 Match *i;
@@ -568,12 +660,13 @@ static int next_for_match(
 
         assert(np > 0);
 
-        r = journal_file_move_to_object(f, OBJECT_ENTRY, np, &n);
-        if (r < 0)
-                return r;
+        if (ret) {
+                r = journal_file_move_to_object(f, OBJECT_ENTRY, np, &n);
+                if (r < 0)
+                        return r;
 
-        if (ret)
                 *ret = n;
+        }
         if (offset)
                 *offset = np;
 
@@ -595,14 +688,9 @@ static int find_location_for_match(
         assert(f);
 
         if (m->type == MATCH_DISCRETE) {
-                uint64_t dp, hash;
-
-                if (JOURNAL_HEADER_KEYED_HASH(f->header))
-                        hash = journal_file_hash_data(f, m->data, m->size);
-                else
-                        hash = m->hash;
+                uint64_t dp;
 
-                r = journal_file_find_data_object_with_hash(f, m->data, m->size, hash, NULL, &dp);
+                r = match_find_data_object(j, m, f, match_cache_get(j, m, f), &dp);
                 if (r <= 0)
                         return r;
 
@@ -684,6 +772,37 @@ static int find_location_for_match(
         }
 }
 
+static bool location_outside_file(sd_journal *j, JournalFile *f, direction_t direction) {
+        uint64_t head, tail;
+
+        assert(j);
+        assert(f);
+
+        /* When the location is going to be resolved by realtime, the head and tail timestamps in the
+         * header are enough to tell that there's nothing for us in this file, without looking at any of
+         * its entry arrays or hash tables. This matters for --since= and --until= on systems with lots of
+         * archived files, most of which are entirely out of range. */
+
+        if (!IN_SET(j->current_location.type, LOCATION_SEEK, LOCATION_DISCRETE))
+                return false;
+        if (!j->current_location.realtime_set)
+                return false;
+        if (j->current_location.seqnum_set && sd_id128_equal(j->current_location.seqnum_id, f->header->seqnum_id))
+                return false;
+        if (j->current_location.monotonic_set)
+                return false;
+
+        head = le64toh(f->header->head_entry_realtime);
+        tail = le64toh(f->header->tail_entry_realtime);
+        if (head == 0 || tail == 0)
+                return false;
+
+        if (direction == DIRECTION_DOWN)
+                return tail < j->current_location.realtime;
+        else
+                return head > j->current_location.realtime;
+}
+
 static int find_location_with_matches(
                 sd_journal *j,
                 JournalFile *f,
@@ -698,6 +817,9 @@ static int find_location_with_matches(
         assert(ret);
         assert(offset);
 
+        if (location_outside_file(j, f, direction))
+                return 0;
+
         if (!j->level0) {
                 /* No matches is simple */
 
@@ -813,50 +935,124 @@ static int next_beyond_location(sd_journal *j, JournalFile *f, direction_t direc
         }
 }
 
-static int real_journal_next(sd_journal *j, direction_t direction) {
-        JournalFile *new_file = NULL;
-        unsigned i, n_files;
+static int journal_file_compare_down(const void *a, const void *b) {
+        return journal_file_compare_locations((JournalFile*) a, (JournalFile*) b);
+}
+
+static int journal_file_compare_up(const void *a, const void *b) {
+        return journal_file_compare_locations((JournalFile*) b, (JournalFile*) a);
+}
+
+static int files_prioq_advance(sd_journal *j, JournalFile *f, direction_t direction) {
+        int r;
+
+        assert(j);
+        assert(f);
+
+        /* Moves the file to the next candidate beyond the current location, and puts it in its place in
+         * the queue. Returns > 0 if the file has a candidate, 0 otherwise. */
+
+        r = next_beyond_location(j, f, direction);
+        if (r < 0) {
+                log_debug_errno(r, "Can't iterate through %s, ignoring: %m", f->path);
+                remove_file_real(j, f);
+                return 0;
+        }
+        if (r == 0) {
+                f->location_type = LOCATION_TAIL;
+                (void) prioq_remove(j->files_prioq, f, &f->prioq_idx);
+                return 0;
+        }
+
+        if (prioq_reshuffle(j->files_prioq, f, &f->prioq_idx) > 0)
+                return 1;
+
+        r = prioq_put(j->files_prioq, f, &f->prioq_idx);
+        if (r < 0)
+                return r;
+
+        return 1;
+}
+
+static int files_prioq_rebuild(sd_journal *j, direction_t direction) {
+        unsigned n_files;
         const void **files;
-        Object *o;
         int r;
 
-        assert_return(j, -EINVAL);
-        assert_return(!journal_pid_changed(j), -ECHILD);
+        assert(j);
+
+        if (!j->files_prioq || j->files_prioq_direction != direction) {
+                j->files_prioq = prioq_free(j->files_prioq);
+
+                r = prioq_ensure_allocated(&j->files_prioq,
+                                           direction == DIRECTION_DOWN ? journal_file_compare_down : journal_file_compare_up);
+                if (r < 0)
+                        return r;
+
+                j->files_prioq_direction = direction;
+        } else
+                while (prioq_pop(j->files_prioq))
+                        ;
 
         r = iterated_cache_get(j->files_cache, NULL, &files, &n_files);
         if (r < 0)
                 return r;
 
-        for (i = 0; i < n_files; i++) {
-                JournalFile *f = (JournalFile *)files[i];
-                bool found;
+        for (unsigned i = 0; i < n_files; i++) {
+                r = files_prioq_advance(j, (JournalFile*) files[i], direction);
+                if (r < 0)
+                        return r;
+        }
 
-                r = next_beyond_location(j, f, direction);
-                if (r < 0) {
-                        log_debug_errno(r, "Can't iterate through %s, ignoring: %m", f->path);
-                        remove_file_real(j, f);
-                        continue;
-                } else if (r == 0) {
-                        f->location_type = LOCATION_TAIL;
-                        continue;
-                }
+        j->files_prioq_valid = true;
+        return 0;
+}
 
-                if (!new_file)
-                        found = true;
-                else {
-                        int k;
+static int real_journal_next(sd_journal *j, direction_t direction) {
+        JournalFile *new_file;
+        Object *o;
+        int r;
 
-                        k = journal_file_compare_locations(f, new_file);
+        assert_return(j, -EINVAL);
+        assert_return(!journal_pid_changed(j), -ECHILD);
 
-                        found = direction == DIRECTION_DOWN ? k < 0 : k > 0;
-                }
+        /* The files that have a candidate entry are kept in a priority queue ordered by the location of
+         * their candidate in the iteration direction. Only the file we picked the last entry from needs to
+         * move on, hence this is O(log n) in the number of files, rather than O(n).
+         *
+         * Files that hit EOF are only looked at again when the queue is rebuilt, i.e. when it runs empty,
+         * the direction changes, we seek, or files are added. */
 
-                if (found)
-                        new_file = f;
+        if (!j->files_prioq_valid || j->files_prioq_direction != direction) {
+                r = files_prioq_rebuild(j, direction);
+                if (r < 0)
+                        return r;
+        } else if (j->current_file && j->current_file->location_type == LOCATION_DISCRETE) {
+                r = files_prioq_advance(j, j->current_file, direction);
+                if (r < 0)
+                        return r;
         }
 
-        if (!new_file)
-                return 0;
+        for (;;) {
+                uint64_t offset;
+
+                new_file = prioq_peek(j->files_prioq);
+                if (!new_file) {
+                        /* Look at all files again next time, maybe new entries appeared */
+                        j->files_prioq_valid = false;
+                        return 0;
+                }
+
+                /* The candidate might have been the same entry as the one we just returned from another
+                 * file, in which case the file is moved on to the next one. */
+                offset = new_file->current_offset;
+
+                r = files_prioq_advance(j, new_file, direction);
+                if (r < 0)
+                        return r;
+                if (r > 0 && new_file->current_offset == offset)
+                        break;
+        }
 
         r = journal_file_move_to_object(new_file, OBJECT_ENTRY, new_file->current_offset, &o);
         if (r < 0)
@@ -1360,6 +1556,7 @@ static int add_any_file(
         check_network(j, f->fd);
 
         j->current_invalidate_counter++;
+        j->files_prioq_valid = false;
 
         log_debug("File %s added.", f->path);
 
@@ -1424,6 +1621,7 @@ static void remove_file_real(sd_journal *j, JournalFile *f) {
         assert(f);
 
         (void) ordered_hashmap_remove(j->files, f->path);
+        (void) prioq_remove(j->files_prioq, f, &f->prioq_idx);
 
         log_debug("File %s removed.", f->path);
 
@@ -2152,6 +2350,7 @@ _public_ void sd_journal_close(sd_journal *j) {
 
         sd_journal_flush_matches(j);
 
+        prioq_free(j->files_prioq);
         ordered_hashmap_free_with_destructor(j->files, journal_file_close);
         iterated_cache_free(j->files_cache);
 
@@ -2178,6 +2377,9 @@ _public_ void sd_journal_close(sd_journal *j) {
         free(j->namespace);
         free(j->unique_field);
         free(j->fields_buffer);
+#if HAVE_COMPRESSION
+        free(j->compress_buffer);
+#endif
         free(j);
 }
 
@@ -2298,31 +2500,25 @@ _public_ int sd_journal_get_data(sd_journal *j, const char *field, const void **
 
         field_length = strlen(field);
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         for (i = 0; i < n; i++) {
                 uint64_t p, l;
-                le64_t le_hash;
                 size_t t;
                 int compression;
 
-                p = le64toh(o->entry.items[i].object_offset);
-                le_hash = o->entry.items[i].hash;
-                r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                r = journal_file_move_to_entry_item_data(f, o, i, &o, &p);
                 if (r < 0)
                         return r;
 
-                if (le_hash != o->data.hash)
-                        return -EBADMSG;
-
                 l = le64toh(o->object.size) - offsetof(Object, data.payload);
 
                 compression = o->object.flags & OBJECT_COMPRESSION_MASK;
                 if (compression) {
 #if HAVE_COMPRESSION
-                        r = decompress_startswith(compression,
-                                                  o->data.payload, l,
-                                                  &f->compress_buffer,
-                                                  field, field_length, '=');
+                        r = journal_file_decompress_startswith(f, compression,
+                                                               o->data.payload, l,
+                                                               &j->compress_buffer,
+                                                               field, field_length, '=');
                         if (r < 0)
                                 log_debug_errno(r, "Cannot decompress %s object of length %"PRIu64" at offset "OFSfmt": %m",
                                                 object_compressed_to_string(compression), l, p);
@@ -2330,14 +2526,14 @@ _public_ int sd_journal_get_data(sd_journal *j, const char *field, const void **
 
                                 size_t rsize;
 
-                                r = decompress_blob(compression,
-                                                    o->data.payload, l,
-                                                    &f->compress_buffer, &rsize,
-                                                    j->data_threshold);
+                                r = journal_file_decompress_blob(f, compression,
+                                                                 o->data.payload, l,
+                                                                 &j->compress_buffer, &rsize,
+                                                                 j->data_threshold);
                                 if (r < 0)
                                         return r;
 
-                                *data = f->compress_buffer;
+                                *data = j->compress_buffer;
                                 *size = (size_t) rsize;
 
                                 return 0;
@@ -2398,16 +2594,17 @@ static int return_data(
                 size_t rsize;
                 int r;
 
-                r = decompress_blob(
+                r = journal_file_decompress_blob(
+                                f,
                                 compression,
                                 o->data.payload, l,
-                                &f->compress_buffer, &rsize,
+                                &j->compress_buffer, &rsize,
                                 j->data_threshold);
                 if (r < 0)
                         return r;
 
                 if (ret_data)
-                        *ret_data = f->compress_buffer;
+                        *ret_data = j->compress_buffer;
                 if (ret_size)
                         *ret_size = (size_t) rsize;
 #else
@@ -2425,8 +2622,7 @@ static int return_data(
 
 _public_ int sd_journal_enumerate_data(sd_journal *j, const void **data, size_t *size) {
         JournalFile *f;
-        uint64_t p, n;
-        le64_t le_hash;
+        uint64_t n;
         int r;
         Object *o;
 
@@ -2446,19 +2642,14 @@ _public_ int sd_journal_enumerate_data(sd_journal *j, const void **data, size_t
         if (r < 0)
                 return r;
 
-        n = journal_file_entry_n_items(o);
+        n = journal_file_entry_n_items(f, o);
         if (j->current_field >= n)
                 return 0;
 
-        p = le64toh(o->entry.items[j->current_field].object_offset);
-        le_hash = o->entry.items[j->current_field].hash;
-        r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+        r = journal_file_move_to_entry_item_data(f, o, j->current_field, &o, NULL);
         if (r < 0)
                 return r;
 
-        if (le_hash != o->data.hash)
-                return -EBADMSG;
-
         r = return_data(j, f, o, data, size);
         if (r < 0)
                 return r;
@@ -2840,6 +3031,222 @@ _public_ int sd_journal_get_cutoff_monotonic_usec(
         return found;
 }
 
+static int journal_boot_compare(const JournalBoot *a, const JournalBoot *b) {
+        int r;
+
+        /* Sequence numbers can't be compared across sequence number spaces, hence go by the wall clock
+         * only. Break ties by boot ID, so that this is a total order. */
+        r = CMP(a->first, b->first);
+        if (r != 0)
+                return r;
+
+        return memcmp(&a->id, &b->id, sizeof(a->id));
+}
+
+static int journal_boots_add(Hashmap **boots, sd_id128_t id, usec_t first, usec_t last) {
+        _cleanup_free_ JournalBoot *new_boot = NULL;
+        JournalBoot *boot;
+        int r;
+
+        assert(boots);
+
+        boot = hashmap_get(*boots, &id);
+        if (boot) {
+                boot->first = MIN(boot->first, first);
+                boot->last = MAX(boot->last, last);
+                return 0;
+        }
+
+        new_boot = new(JournalBoot, 1);
+        if (!new_boot)
+                return -ENOMEM;
+
+        *new_boot = (JournalBoot) {
+                .id = id,
+                .first = first,
+                .last = last,
+        };
+
+        r = hashmap_ensure_put(boots, &id128_hash_ops, &new_boot->id, new_boot);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(new_boot);
+        return 0;
+}
+
+static int add_boots_from_entries(JournalFile *f, Hashmap **boots) {
+        sd_id128_t id = SD_ID128_NULL;
+        usec_t first = 0, last = 0;
+        uint64_t p = 0;
+        Object *o;
+        int r;
+
+        assert(f);
+        assert(boots);
+
+        /* Walks through the main entry array and takes the boot ID from the entry header, like iterating
+         * through the journal does. Runs of entries of the same boot are merged right away. */
+
+        for (;;) {
+                usec_t t;
+
+                r = journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        break;
+
+                t = le64toh(o->entry.realtime);
+
+                if (sd_id128_equal(o->entry.boot_id, id)) {
+                        first = MIN(first, t);
+                        last = MAX(last, t);
+                        continue;
+                }
+
+                if (!sd_id128_is_null(id)) {
+                        r = journal_boots_add(boots, id, first, last);
+                        if (r < 0)
+                                return r;
+                }
+
+                id = o->entry.boot_id;
+                first = last = t;
+        }
+
+        if (sd_id128_is_null(id))
+                return 0;
+
+        return journal_boots_add(boots, id, first, last);
+}
+
+static int add_boots_from_file(sd_journal *j, JournalFile *f, Hashmap **boots) {
+        uint64_t p, head, n = 0;
+        Object *o;
+        int r;
+
+        assert(j);
+        assert(f);
+        assert(boots);
+
+        /* Every boot ID a file knows about has a data object linked into the _BOOT_ID field's list, and
+         * each data object has the first and the last entry referencing it at hand. Hence the boots of a
+         * file can usually be listed without iterating through its entries, or merging it with other
+         * files. That only holds if every entry carries exactly one _BOOT_ID= field and was linked to its
+         * data object though. If the entry counts don't add up, go through the entries instead. */
+
+        r = journal_file_find_field_object(f, "_BOOT_ID", STRLEN("_BOOT_ID"), &o, NULL);
+        if (r < 0)
+                return r;
+        if (r == 0)
+                return add_boots_from_entries(f, boots);
+
+        head = le64toh(o->field.head_data_offset);
+
+        for (p = head; p != 0; p = le64toh(o->data.next_field_offset)) {
+                r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                if (r < 0)
+                        return r;
+
+                n += le64toh(o->data.n_entries);
+        }
+
+        if (n != le64toh(READ_NOW(f->header->n_entries)))
+                return add_boots_from_entries(f, boots);
+
+        for (p = head; p != 0;) {
+                uint64_t next, first_offset;
+                usec_t first, last;
+                sd_id128_t id;
+                char s[SD_ID128_STRING_MAX];
+                const void *data;
+                size_t l;
+
+                r = journal_file_move_to_object(f, OBJECT_DATA, p, &o);
+                if (r < 0)
+                        return r;
+
+                next = le64toh(o->data.next_field_offset);
+                first_offset = le64toh(o->data.entry_offset);
+
+                if (le64toh(o->data.n_entries) <= 0 || first_offset == 0) {
+                        p = next;
+                        continue;
+                }
+
+                r = return_data(j, f, o, &data, &l);
+                if (r < 0)
+                        return r;
+                if (l != STRLEN("_BOOT_ID=") + 32 || memcmp(data, "_BOOT_ID=", STRLEN("_BOOT_ID=")) != 0)
+                        return -EBADMSG;
+
+                memcpy(s, (const char*) data + STRLEN("_BOOT_ID="), 32);
+                s[32] = 0;
+
+                r = sd_id128_from_string(s, &id);
+                if (r < 0)
+                        return r;
+
+                r = journal_file_move_to_object(f, OBJECT_ENTRY, first_offset, &o);
+                if (r < 0)
+                        return r;
+
+                first = le64toh(o->entry.realtime);
+
+                r = journal_file_next_entry_for_data(f, NULL, 0, p, DIRECTION_UP, &o, NULL);
+                if (r < 0)
+                        return r;
+                if (r == 0)
+                        return -EBADMSG;
+
+                last = le64toh(o->entry.realtime);
+
+                r = journal_boots_add(boots, id, MIN(first, last), MAX(first, last));
+                if (r < 0)
+                        return r;
+
+                p = next;
+        }
+
+        return 0;
+}
+
+int journal_get_boots(sd_journal *j, JournalBoot **ret, size_t *ret_n) {
+        _cleanup_hashmap_free_free_ Hashmap *boots = NULL;
+        _cleanup_free_ JournalBoot *array = NULL;
+        JournalBoot *boot;
+        JournalFile *f;
+        size_t n = 0;
+        int r;
+
+        assert(j);
+        assert(ret);
+        assert(ret_n);
+
+        /* Returns all boots in the journal files, ordered from the oldest to the newest. Matches are not
+         * taken into account. */
+
+        ORDERED_HASHMAP_FOREACH(f, j->files) {
+                r = add_boots_from_file(j, f, &boots);
+                if (r < 0)
+                        return log_debug_errno(r, "Failed to read boot IDs from %s: %m", f->path);
+        }
+
+        array = new(JournalBoot, hashmap_size(boots));
+        if (!array && hashmap_size(boots) > 0)
+                return -ENOMEM;
+
+        HASHMAP_FOREACH(boot, boots)
+                array[n++] = *boot;
+
+        typesafe_qsort(array, n, journal_boot_compare);
+
+        *ret = TAKE_PTR(array);
+        *ret_n = n;
+        return 0;
+}
+
 void journal_print_header(sd_journal *j) {
         JournalFile *f;
         bool newline = false;
@@ -10,6 +10,7 @@
 #include "process-util.h"
 #include "random-util.h"
 #include "string-util.h"
+#include "strv.h"
 #include "tests.h"
 
 typedef int (compress_t)(const void *src, uint64_t src_size, void *dst,
@@ -138,6 +139,119 @@ static void test_compress_decompress(const char* label, const char* type,
                  100 - compressed * 100. / total,
                  skipped);
 }
+
+#if HAVE_ZSTD
+#define N_LINES 4096
+
+/* Short, repetitive journal fields, as seen in the majority of DATA objects of a typical journal file */
+static char* make_line(size_t i) {
+        char *line;
+        int r;
+
+        switch (i % 4) {
+        case 0:
+                r = asprintf(&line, "MESSAGE=Accepted publickey for user%zu from 10.0.%zu.%zu port %zu ssh2",
+                             i % 97, i / 256 % 256, i % 256, 32768 + i);
+                break;
+        case 1:
+                r = asprintf(&line, "MESSAGE=Started Session %zu of User user%zu.", i, i % 97);
+                break;
+        case 2:
+                r = asprintf(&line, "_SYSTEMD_UNIT=session-%zu.scope", i);
+                break;
+        default:
+                r = asprintf(&line, "_SOURCE_REALTIME_TIMESTAMP=%zu", 1600000000000000 + i * 7919);
+        }
+        assert_se(r >= 0);
+
+        return line;
+}
+
+static void test_compress_decompress_lines(const char *label, char **lines, ZstdDictionary *d) {
+        usec_t n, n2 = 0;
+        float dt;
+
+        _cleanup_free_ char *buf = NULL;
+        _cleanup_free_ void *buf2 = NULL;
+        size_t skipped = 0, compressed = 0, total = 0;
+
+        buf = malloc(MAX_SIZE);
+        assert_se(buf);
+
+        n = now(CLOCK_MONOTONIC);
+
+        for (size_t i = 0;; i++) {
+                const char *line = lines[i % N_LINES];
+                size_t j = 0, k = 0, size;
+                int r;
+
+                size = strlen(line);
+
+                /* Same as the journal: only accept results that are actually smaller than the input */
+                r = compress_blob_zstd_with_dict(d, line, size, buf, size - 1, &j);
+                assert_se(r == 0 || r == -ENOBUFS);
+
+                total += size;
+                if (r != 0) {
+                        skipped += size;
+                        compressed += size;
+                } else {
+                        r = decompress_blob_zstd_with_dict(d, buf, j, &buf2, &k, 0);
+                        assert_se(r == 0);
+                        assert_se(k == size);
+                        assert_se(memcmp(line, buf2, size) == 0);
+
+                        compressed += j;
+                }
+
+                n2 = now(CLOCK_MONOTONIC);
+                if (n2 - n > arg_duration)
+                        break;
+        }
+
+        dt = (n2-n) / 1e6;
+
+        log_info("%s/lines: compressed & decompressed %zu bytes in %.2fs (%.2fMiB/s), "
+                 "mean compression %.2f%%, skipped %zu bytes",
+                 label, total, dt,
+                 total / 1024. / 1024 / dt,
+                 100 - compressed * 100. / total,
+                 skipped);
+}
+
+static void test_zstd_dictionary(void) {
+        _cleanup_(zstd_dictionary_freep) ZstdDictionary *d = NULL;
+        _cleanup_strv_free_ char **lines = NULL;
+        _cleanup_free_ char *samples = NULL;
+        _cleanup_free_ size_t *sizes = NULL;
+        _cleanup_free_ void *dict = NULL;
+        size_t n_bytes = 0, dict_size;
+
+        /* Train on one set of lines, and measure on another, like the journal does when it trains a
+         * dictionary from the previous file */
+        sizes = new(size_t, N_LINES);
+        lines = new0(char*, N_LINES + 1);
+        assert_se(sizes && lines);
+
+        for (size_t i = 0; i < N_LINES; i++) {
+                _cleanup_free_ char *line = make_line(i);
+
+                sizes[i] = strlen(line);
+                assert_se(GREEDY_REALLOC(samples, n_bytes + sizes[i]));
+                memcpy(samples + n_bytes, line, sizes[i]);
+                n_bytes += sizes[i];
+
+                lines[i] = make_line(N_LINES + i);
+        }
+
+        assert_se(zstd_dictionary_train(samples, sizes, N_LINES, 16 * 1024, &dict, &dict_size) == 0);
+        assert_se(zstd_dictionary_new(dict, dict_size, &d) == 0);
+        log_info("ZSTD: trained %zu byte dictionary from %zu bytes of samples", dict_size, n_bytes);
+
+        test_compress_decompress_lines("ZSTD", lines, NULL);
+        test_compress_decompress_lines("ZSTD+dictionary", lines, d);
+}
+#endif
 #endif
 
 int main(int argc, char *argv[]) {
@@ -170,6 +284,9 @@ int main(int argc, char *argv[]) {
                 test_compress_decompress("ZSTD", i, compress_blob_zstd, decompress_blob_zstd);
 #endif
         }
+#if HAVE_ZSTD
+        test_zstd_dictionary();
+#endif
         return 0;
 #else
         return log_tests_skipped("No compression feature is enabled");
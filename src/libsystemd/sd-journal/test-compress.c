@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <pthread.h>
 #include <sys/stat.h>
 
 #if HAVE_LZ4
@@ -163,6 +164,92 @@ _unused_ static void test_decompress_startswith_short(const char *compression,
         }
 }
 
+_unused_ static void test_decompress_interleaved(const char *compression,
+                                                 compress_blob_t compress,
+                                                 decompress_blob_t decompress,
+                                                 decompress_sw_t decompress_sw,
+                                                 const char *huge) {
+
+        _cleanup_free_ char *compressed1 = NULL, *decompressed = NULL;
+        char compressed2[512];
+        size_t csize1, csize2, len;
+        int r;
+
+        /* Codec state is cached between calls. Make sure that bailing out early in the middle of one blob,
+         * or failing on garbage, doesn't affect the next one. */
+
+        log_info("/* %s with %s */", __func__, compression);
+
+        assert_se(compressed1 = malloc(HUGE_SIZE));
+        r = compress(huge, HUGE_SIZE, compressed1, HUGE_SIZE, &csize1);
+        assert_se(r == 0);
+
+        r = compress(TEXT, sizeof TEXT, compressed2, sizeof compressed2, &csize2);
+        assert_se(r == 0);
+
+        for (unsigned i = 0; i < 3; i++) {
+                assert_se(decompress_sw(compressed1, csize1, (void **) &decompressed, "HUGE", 4, '=') > 0);
+
+                assert_se(decompress("garbage", 7, (void **) &decompressed, &len, 0) < 0);
+
+                assert_se(decompress(compressed1, csize1, (void **) &decompressed, &len, 64) == 0);
+                assert_se(len >= 64);
+                assert_se(memcmp(decompressed, huge, 64) == 0);
+
+                assert_se(decompress(compressed2, csize2, (void **) &decompressed, &len, 0) == 0);
+                assert_se(len == sizeof TEXT);
+                assert_se(memcmp(decompressed, TEXT, sizeof TEXT) == 0);
+        }
+}
+
+typedef struct CodecThreadArgs {
+        compress_blob_t *compress;
+        decompress_blob_t *decompress;
+} CodecThreadArgs;
+
+_unused_ static void codec_round_trip(compress_blob_t compress, decompress_blob_t decompress) {
+        _cleanup_free_ char *decompressed = NULL;
+        char compressed[512];
+        size_t csize, len;
+
+        assert_se(compress(TEXT, sizeof TEXT, compressed, sizeof compressed, &csize) == 0);
+        assert_se(decompress(compressed, csize, (void **) &decompressed, &len, 0) == 0);
+        assert_se(len == sizeof TEXT);
+        assert_se(memcmp(decompressed, TEXT, sizeof TEXT) == 0);
+}
+
+_unused_ static void* codec_thread(void *p) {
+        CodecThreadArgs *args = p;
+
+        codec_round_trip(args->compress, args->decompress);
+        return NULL;
+}
+
+_unused_ static void test_decompress_thread(const char *compression,
+                                            compress_blob_t compress,
+                                            decompress_blob_t decompress) {
+
+        CodecThreadArgs args = {
+                .compress = compress,
+                .decompress = decompress,
+        };
+        pthread_t t;
+
+        /* Codec state is cached per thread and released when the thread exits. Make sure that works, and
+         * doesn't affect the state of other threads. */
+
+        log_info("/* %s with %s */", __func__, compression);
+
+        codec_round_trip(compress, decompress);
+
+        for (unsigned i = 0; i < 3; i++) {
+                assert_se(pthread_create(&t, NULL, codec_thread, &args) == 0);
+                assert_se(pthread_join(t, NULL) == 0);
+        }
+
+        codec_round_trip(compress, decompress);
+}
+
 _unused_ static void test_compress_stream(const char *compression,
                                           const char *cat,
                                           compress_stream_t compress,
@@ -311,6 +398,8 @@ int main(int argc, char *argv[]) {
                              compress_stream_xz, decompress_stream_xz, srcfile);
 
         test_decompress_startswith_short("XZ", compress_blob_xz, decompress_startswith_xz);
+        test_decompress_interleaved("XZ", compress_blob_xz, decompress_blob_xz, decompress_startswith_xz, huge);
+        test_decompress_thread("XZ", compress_blob_xz, decompress_blob_xz);
 
 #else
         log_info("/* XZ test skipped */");
@@ -338,6 +427,8 @@ int main(int argc, char *argv[]) {
         test_lz4_decompress_partial();
 
         test_decompress_startswith_short("LZ4", compress_blob_lz4, decompress_startswith_lz4);
+        test_decompress_interleaved("LZ4", compress_blob_lz4, decompress_blob_lz4, decompress_startswith_lz4, huge);
+        test_decompress_thread("LZ4", compress_blob_lz4, decompress_blob_lz4);
 
 #else
         log_info("/* LZ4 test skipped */");
@@ -363,6 +454,8 @@ int main(int argc, char *argv[]) {
                              compress_stream_zstd, decompress_stream_zstd, srcfile);
 
         test_decompress_startswith_short("ZSTD", compress_blob_zstd, decompress_startswith_zstd);
+        test_decompress_interleaved("ZSTD", compress_blob_zstd, decompress_blob_zstd, decompress_startswith_zstd, huge);
+        test_decompress_thread("ZSTD", compress_blob_zstd, decompress_blob_zstd);
 #else
         log_info("/* ZSTD test skipped */");
 #endif
@@ -9,6 +9,7 @@
 #include "chattr-util.h"
 #include "io-util.h"
 #include "journal-file.h"
+#include "journal-internal.h"
 #include "journal-vacuum.h"
 #include "log.h"
 #include "parse-util.h"
@@ -131,6 +132,22 @@ static void setup_interleaved(void) {
         test_close(two);
 }
 
+static void setup_spread(void) {
+        JournalFile *one, *two, *three, *four;
+        one = test_open("one.journal");
+        two = test_open("two.journal");
+        three = test_open("three.journal");
+        four = test_open("four.journal");
+        append_number(three, 1, NULL);
+        append_number(one, 2, NULL);
+        append_number(four, 3, NULL);
+        append_number(two, 4, NULL);
+        test_close(one);
+        test_close(two);
+        test_close(three);
+        test_close(four);
+}
+
 static void mkdtemp_chdir_chattr(char *path) {
         assert_se(mkdtemp(path));
         assert_se(chdir(path) >= 0);
@@ -143,6 +160,7 @@ static void mkdtemp_chdir_chattr(char *path) {
 static void test_skip(void (*setup)(void)) {
         char t[] = "/var/tmp/journal-skip-XXXXXX";
         sd_journal *j;
+        uint64_t realtime;
         int r;
 
         mkdtemp_chdir_chattr(t);
@@ -183,6 +201,29 @@ static void test_skip(void (*setup)(void)) {
         test_check_numbers_up(j, 4);
         sd_journal_close(j);
 
+        /* Seek to the realtime of the third entry, iterate down, then seek there again and iterate up.
+         */
+        assert_ret(sd_journal_open_directory(&j, t, 0));
+        assert_ret(sd_journal_seek_head(j));
+        assert_ret(r = sd_journal_next_skip(j, 3));
+        assert_se(r == 3);
+        test_check_number(j, 3);
+        assert_ret(sd_journal_get_realtime_usec(j, &realtime));
+        assert_ret(sd_journal_seek_realtime_usec(j, realtime));
+        assert_ret(r = sd_journal_next(j));
+        assert_se(r == 1);
+        test_check_number(j, 3);
+        assert_ret(r = sd_journal_next(j));
+        assert_se(r == 1);
+        test_check_number(j, 4);
+        assert_ret(r = sd_journal_next(j));
+        assert_se(r == 0);
+        assert_ret(sd_journal_seek_realtime_usec(j, realtime));
+        assert_ret(r = sd_journal_previous(j));
+        assert_se(r == 1);
+        test_check_numbers_up(j, 3);
+        sd_journal_close(j);
+
         log_info("Done...");
 
         if (arg_keep)
@@ -278,6 +319,78 @@ static void test_sequence_numbers(void) {
         }
 }
 
+static void append_boot(JournalFile *f, sd_id128_t boot_id, usec_t realtime, bool with_field, uint64_t *seqnum) {
+        char field[STRLEN("_BOOT_ID=") + SD_ID128_STRING_MAX] = "_BOOT_ID=";
+        struct iovec iovec[1];
+        dual_timestamp ts;
+
+        dual_timestamp_get(&ts);
+        ts.realtime = realtime;
+
+        if (with_field) {
+                sd_id128_to_string(boot_id, field + STRLEN("_BOOT_ID="));
+                iovec[0] = IOVEC_MAKE_STRING(field);
+        } else
+                iovec[0] = IOVEC_MAKE_STRING("MESSAGE=no boot ID field");
+
+        assert_ret(journal_file_append_entry(f, &ts, &boot_id, iovec, 1, seqnum, NULL, NULL));
+}
+
+static void test_boots(void) {
+        char t[] = "/var/tmp/journal-boots-XXXXXX";
+        _cleanup_free_ JournalBoot *boots = NULL;
+        JournalFile *one, *two;
+        sd_id128_t a, b, c, d;
+        uint64_t seqnum = 0;
+        size_t n_boots;
+        sd_journal *j;
+        usec_t base;
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(sd_id128_randomize(&a) >= 0);
+        assert_se(sd_id128_randomize(&b) >= 0);
+        assert_se(sd_id128_randomize(&c) >= 0);
+        assert_se(sd_id128_randomize(&d) >= 0);
+
+        base = now(CLOCK_REALTIME);
+
+        /* Boots spread over two files sharing a sequence number space, as after a rotation. The last entry
+         * has no _BOOT_ID= field, the boot ID in its header has to be used then. */
+        one = test_open("one.journal");
+        assert_ret(journal_file_open(-1, "two.journal", O_RDWR|O_CREAT, 0644, true, UINT64_MAX, false, NULL, NULL, NULL, one, &two));
+        append_boot(one, a, base + 1 * USEC_PER_SEC, true, &seqnum);
+        append_boot(one, a, base + 2 * USEC_PER_SEC, true, &seqnum);
+        append_boot(two, b, base + 3 * USEC_PER_SEC, true, &seqnum);
+        append_boot(one, b, base + 4 * USEC_PER_SEC, true, &seqnum);
+        append_boot(two, c, base + 5 * USEC_PER_SEC, true, &seqnum);
+        append_boot(two, d, base + 6 * USEC_PER_SEC, false, &seqnum);
+        test_close(one);
+        test_close(two);
+
+        assert_ret(sd_journal_open_directory(&j, t, 0));
+        assert_ret(journal_get_boots(j, &boots, &n_boots));
+        assert_se(n_boots == 4);
+        assert_se(sd_id128_equal(boots[0].id, a));
+        assert_se(sd_id128_equal(boots[1].id, b));
+        assert_se(sd_id128_equal(boots[2].id, c));
+        assert_se(sd_id128_equal(boots[3].id, d));
+        assert_se(boots[0].first == base + 1 * USEC_PER_SEC);
+        assert_se(boots[0].last == base + 2 * USEC_PER_SEC);
+        assert_se(boots[1].first == base + 3 * USEC_PER_SEC);
+        assert_se(boots[1].last == base + 4 * USEC_PER_SEC);
+        assert_se(boots[3].first == base + 6 * USEC_PER_SEC);
+        sd_journal_close(j);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else {
+                journal_directory_vacuum(".", 3000000, 0, 0, NULL, true);
+
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+        }
+}
+
 int main(int argc, char *argv[]) {
         test_setup_logging(LOG_DEBUG);
 
@@ -289,8 +402,10 @@ int main(int argc, char *argv[]) {
 
         test_skip(setup_sequential);
         test_skip(setup_interleaved);
+        test_skip(setup_spread);
 
         test_sequence_numbers();
+        test_boots();
 
         return 0;
 }
@@ -14,11 +14,25 @@
 #include "macro.h"
 #include "parse-util.h"
 #include "rm-rf.h"
+#include "stdio-util.h"
 #include "tests.h"
 #include "util.h"
 
 #define N_ENTRIES 200
 
+static unsigned get_number(sd_journal *j) {
+        _cleanup_free_ char *k = NULL;
+        const void *d;
+        unsigned u;
+        size_t l;
+
+        assert_se(sd_journal_get_data(j, "NUMBER", &d, &l) >= 0);
+        assert_se(k = strndup(d, l));
+        assert_se(safe_atou(k + 7, &u) >= 0);
+
+        return u;
+}
+
 static void verify_contents(sd_journal *j, unsigned skip) {
         unsigned i;
 
@@ -165,6 +179,30 @@ static void run_test(void) {
 
         verify_contents(j, 0);
 
+        printf("NEXT TEST\n");
+        sd_journal_flush_matches(j);
+        for (i = 0; i < N_ENTRIES; i += 7) {
+                char match[STRLEN("NUMBER=") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(match, "NUMBER=%u", i);
+                assert_se(sd_journal_add_match(j, match, 0) >= 0);
+        }
+
+        /* Iterate down, then back up from the tail, to make sure the lookups remembered for each match
+         * are still right after the direction changed */
+        i = 0;
+        SD_JOURNAL_FOREACH(j) {
+                assert_se(get_number(j) == i);
+                i += 7;
+        }
+        assert_se(i == DIV_ROUND_UP(N_ENTRIES, 7) * 7);
+
+        SD_JOURNAL_FOREACH_BACKWARDS(j) {
+                i -= 7;
+                assert_se(get_number(j) == i);
+        }
+        assert_se(i == 0);
+
         assert_se(sd_journal_query_unique(j, "NUMBER") >= 0);
         SD_JOURNAL_FOREACH_UNIQUE(j, data, l)
                 printf("%.*s\n", (int) l, (const char*) data);
@@ -180,12 +218,17 @@ int main(int argc, char *argv[]) {
 
         test_setup_logging(LOG_DEBUG);
 
-        /* Run this test twice. Once with old hashing and once with new hashing */
+        /* Run this test three times. Once with old hashing, once with new hashing, and once with new
+         * hashing in a compact file */
         assert_se(setenv("SYSTEMD_JOURNAL_KEYED_HASH", "1", 1) >= 0);
         run_test();
 
         assert_se(setenv("SYSTEMD_JOURNAL_KEYED_HASH", "0", 1) >= 0);
         run_test();
 
+        assert_se(setenv("SYSTEMD_JOURNAL_KEYED_HASH", "1", 1) >= 0);
+        assert_se(setenv("SYSTEMD_JOURNAL_COMPACT", "1", 1) >= 0);
+        run_test();
+
         return 0;
 }
@@ -4,12 +4,17 @@
 #include <unistd.h>
 
 #include "chattr-util.h"
+#include "glob-util.h"
 #include "io-util.h"
 #include "journal-authenticate.h"
 #include "journal-file.h"
 #include "journal-vacuum.h"
+#include "journal-verify.h"
 #include "log.h"
 #include "rm-rf.h"
+#include "set.h"
+#include "stdio-util.h"
+#include "strv.h"
 #include "tests.h"
 
 static bool arg_keep = false;
@@ -116,6 +121,385 @@ static void test_non_empty(void) {
         puts("------------------------------------------------------------");
 }
 
+static void test_append_entries(void) {
+        dual_timestamp ts, ts_later, ts_bad;
+        JournalFile *f;
+        struct iovec iovec[3];
+        JournalFileEntry entries[3];
+        static const char test[] = "TEST1=1", test2[] = "TEST2=2";
+        Object *o;
+        uint64_t p, seqnum = 0;
+        size_t n;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+
+        iovec[0] = IOVEC_MAKE_STRING(test);
+        iovec[1] = IOVEC_MAKE_STRING(test2);
+        iovec[2] = IOVEC_MAKE_STRING(test);
+
+        for (size_t i = 0; i < ELEMENTSOF(entries); i++)
+                entries[i] = (JournalFileEntry) {
+                        .ts = &ts,
+                        .iovec = iovec + i,
+                        .n_iovec = 1,
+                };
+
+        assert_se(journal_file_append_entries(f, entries, ELEMENTSOF(entries), &seqnum, &n) == 0);
+        assert_se(n == ELEMENTSOF(entries));
+        assert_se(seqnum == 3);
+        assert_se(le64toh(f->header->n_entries) == 3);
+
+        /* An entry with an invalid timestamp stops the batch, the ones before it are kept */
+        entries[1].ts = &DUAL_TIMESTAMP_NULL;
+        assert_se(journal_file_append_entries(f, entries, ELEMENTSOF(entries), &seqnum, &n) == -EBADMSG);
+        assert_se(n == 1);
+        assert_se(seqnum == 4);
+
+        /* The tail of the file is the last entry that was actually appended, not the one that failed */
+        ts_later = (dual_timestamp) {
+                .realtime = ts.realtime + USEC_PER_SEC,
+                .monotonic = ts.monotonic + USEC_PER_SEC,
+        };
+        ts_bad = (dual_timestamp) {
+                .realtime = ts.realtime + 2 * USEC_PER_SEC,
+                .monotonic = USEC_INFINITY,
+        };
+        entries[0].ts = &ts_later;
+        entries[1].ts = &ts_bad;
+        assert_se(journal_file_append_entries(f, entries, 2, &seqnum, &n) == -EBADMSG);
+        assert_se(n == 1);
+        assert_se(seqnum == 5);
+        assert_se(le64toh(f->header->tail_entry_realtime) == entries[n - 1].ts->realtime);
+
+        assert_se(journal_file_append_entries(f, NULL, 0, &seqnum, &n) == 0);
+        assert_se(n == 0);
+
+        assert_se(journal_file_next_entry(f, 0, DIRECTION_DOWN, &o, &p) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 1);
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 2);
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 3);
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 4);
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 5);
+        assert_se(le64toh(o->entry.realtime) == ts_later.realtime);
+        assert_se(journal_file_next_entry(f, p, DIRECTION_DOWN, &o, &p) == 0);
+
+        assert_se(journal_file_find_data_object(f, test, strlen(test), NULL, &p) == 1);
+        assert_se(journal_file_next_entry_for_data(f, NULL, 0, p, DIRECTION_UP, &o, NULL) == 1);
+        assert_se(le64toh(o->entry.seqnum) == 5);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static void test_data_dedup(void) {
+        dual_timestamp ts;
+        JournalFile *f;
+        struct iovec iovec[3];
+        char t[] = "/var/tmp/journal-XXXXXX";
+        uint64_t p, q;
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+
+        /* Plenty of distinct values, so that cache slots get reused, mixed with a few repeated ones */
+        for (unsigned i = 0; i < 1000; i++) {
+                char number[STRLEN("NUMBER=") + DECIMAL_STR_MAX(unsigned)], mod[STRLEN("MOD=") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(number, "NUMBER=%u", i);
+                xsprintf(mod, "MOD=%u", i % 7);
+                iovec[0] = IOVEC_MAKE_STRING("_HOSTNAME=foo");
+                iovec[1] = IOVEC_MAKE_STRING(number);
+                iovec[2] = IOVEC_MAKE_STRING(mod);
+                assert_se(journal_file_append_entry(f, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL) == 0);
+        }
+
+        assert_se(le64toh(f->header->n_data) == 1 + 1000 + 7);
+        assert_se(le64toh(f->header->n_entries) == 1000);
+
+        assert_se(journal_file_find_data_object(f, "_HOSTNAME=foo", STRLEN("_HOSTNAME=foo"), NULL, &p) == 1);
+        iovec[0] = IOVEC_MAKE_STRING("_HOSTNAME=foo");
+        assert_se(journal_file_append_entry(f, &ts, NULL, iovec, 1, NULL, NULL, NULL) == 0);
+        assert_se(journal_file_find_data_object(f, "_HOSTNAME=foo", STRLEN("_HOSTNAME=foo"), NULL, &q) == 1);
+        assert_se(p == q);
+        assert_se(le64toh(f->header->n_data) == 1 + 1000 + 7);
+
+        assert_se(journal_file_verify(f, NULL, NULL, NULL, NULL, false) >= 0);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static void test_data_bloom(void) {
+        dual_timestamp ts;
+        JournalFile *f;
+        struct iovec iovec;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+
+        for (unsigned i = 0; i < 100; i++) {
+                char buf[STRLEN("NUMBER=") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(buf, "NUMBER=%u", i);
+                iovec = IOVEC_MAKE_STRING(buf);
+                assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+        }
+
+        assert_se(f->header->data_bloom_offset == 0);
+        assert_se(journal_file_append_data_bloom(f) == 0);
+        assert_se(f->header->data_bloom_offset != 0);
+
+        /* No false negatives */
+        for (unsigned i = 0; i < 100; i++) {
+                char buf[STRLEN("NUMBER=") + DECIMAL_STR_MAX(unsigned)];
+
+                xsprintf(buf, "NUMBER=%u", i);
+                assert_se(journal_file_find_data_object(f, buf, strlen(buf), NULL, NULL) == 1);
+        }
+
+        assert_se(journal_file_find_data_object(f, "NUMBER=100", STRLEN("NUMBER=100"), NULL, NULL) == 0);
+        assert_se(journal_file_verify(f, NULL, NULL, NULL, NULL, false) >= 0);
+
+        /* Adding a new data object invalidates the filter */
+        iovec = IOVEC_MAKE_STRING("NUMBER=100");
+        assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+        assert_se(f->header->data_bloom_offset == 0);
+        assert_se(journal_file_find_data_object(f, "NUMBER=100", STRLEN("NUMBER=100"), NULL, NULL) == 1);
+        assert_se(journal_file_verify(f, NULL, NULL, NULL, NULL, false) >= 0);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static void test_realtime_index(void) {
+        dual_timestamp ts, base;
+        JournalFile *f;
+        struct iovec iovec;
+        static const char test[] = "TEST1=1";
+        Object *o;
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&base));
+        iovec = IOVEC_MAKE_STRING(test);
+
+        /* Write enough entries to end up with a couple of entry arrays in the main chain */
+        for (unsigned i = 0; i < 1000; i++) {
+                ts = (dual_timestamp) {
+                        .realtime = base.realtime + i * 2,
+                        .monotonic = base.monotonic + i * 2,
+                };
+                assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+        }
+
+        assert_se(f->header->realtime_index_offset == 0);
+        assert_se(journal_file_append_realtime_index(f) == 0);
+        assert_se(f->header->realtime_index_offset != 0);
+
+        /* Entries written after the index was added are still found, the index just doesn't cover them */
+        for (unsigned i = 1000; i < 1100; i++) {
+                ts = (dual_timestamp) {
+                        .realtime = base.realtime + i * 2,
+                        .monotonic = base.monotonic + i * 2,
+                };
+                assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+        }
+
+        for (unsigned i = 0; i < 1100; i += 7) {
+                /* Exact hits */
+                assert_se(journal_file_move_to_entry_by_realtime(f, base.realtime + i * 2, DIRECTION_DOWN, &o, NULL) == 1);
+                assert_se(le64toh(o->entry.seqnum) == i + 1);
+                assert_se(journal_file_move_to_entry_by_realtime(f, base.realtime + i * 2, DIRECTION_UP, &o, NULL) == 1);
+                assert_se(le64toh(o->entry.seqnum) == i + 1);
+
+                /* In between two entries */
+                assert_se(journal_file_move_to_entry_by_realtime(f, base.realtime + i * 2 + 1, DIRECTION_DOWN, &o, NULL) == (i < 1099));
+                if (i < 1099)
+                        assert_se(le64toh(o->entry.seqnum) == i + 2);
+                assert_se(journal_file_move_to_entry_by_realtime(f, base.realtime + i * 2 + 1, DIRECTION_UP, &o, NULL) == 1);
+                assert_se(le64toh(o->entry.seqnum) == i + 1);
+        }
+
+        assert_se(journal_file_verify(f, NULL, NULL, NULL, NULL, false) >= 0);
+
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+static void test_archive_post_process(void) {
+        _cleanup_set_free_ Set *deferred_closes = NULL;
+        _cleanup_strv_free_ char **archived = NULL;
+        dual_timestamp ts, base;
+        JournalFile *f;
+        struct iovec iovec;
+        static const char test[] = "TEST1=1";
+        char t[] = "/var/tmp/journal-XXXXXX";
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        assert_se(dual_timestamp_get(&base));
+        iovec = IOVEC_MAKE_STRING(test);
+
+        for (unsigned i = 0; i < 1000; i++) {
+                ts = (dual_timestamp) {
+                        .realtime = base.realtime + i,
+                        .monotonic = base.monotonic + i,
+                };
+                assert_se(journal_file_append_entry(f, &ts, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+        }
+
+        /* The old file is post-processed by the offline thread, while we continue writing to the new one */
+        assert_se(deferred_closes = set_new(NULL));
+        assert_se(journal_file_rotate(&f, true, UINT64_MAX, false, deferred_closes) >= 0);
+        assert_se(set_size(deferred_closes) == 1);
+
+        assert_se(journal_file_append_entry(f, &base, NULL, &iovec, 1, NULL, NULL, NULL) == 0);
+
+        set_clear_with_destructor(deferred_closes, journal_file_close);
+        (void) journal_file_close(f);
+
+        assert_se(glob_extend(&archived, "test@*.journal", 0) >= 0);
+        assert_se(strv_length(archived) == 1);
+
+        assert_se(journal_file_open(-1, archived[0], O_RDONLY, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+        assert_se(f->header->state == STATE_ARCHIVED);
+        assert_se(f->header->data_bloom_offset != 0);
+        assert_se(f->header->realtime_index_offset != 0);
+        assert_se(journal_file_verify(f, NULL, NULL, NULL, NULL, false) >= 0);
+        (void) journal_file_close(f);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+
+#if HAVE_ZSTD
+static void test_zstd_dictionary(void) {
+        dual_timestamp ts;
+        JournalFile *f, *g;
+        struct iovec iovec[2];
+        char t[] = "/var/tmp/journal-XXXXXX";
+        char buf[STRLEN("MESSAGE=Started session  of user root.") + DECIMAL_STR_MAX(unsigned)];
+        Object *o;
+
+        test_setup_logging(LOG_DEBUG);
+
+        mkdtemp_chdir_chattr(t);
+
+        assert_se(setenv("SYSTEMD_JOURNAL_ZSTD_DICTIONARY", "1", 1) >= 0);
+
+        assert_se(journal_file_open(-1, "test.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &f) == 0);
+
+        /* Without a template there is nothing to train from */
+        assert_se(!JOURNAL_HEADER_ZSTD_DICTIONARY(f->header));
+
+        assert_se(dual_timestamp_get(&ts));
+
+        for (unsigned i = 0; i < 5000; i++) {
+                const char *comm = i % 2 == 0 ? "_COMM=sshd" : "_COMM=systemd-logind";
+
+                xsprintf(buf, "MESSAGE=Started session %u of user root.", i);
+                iovec[0] = IOVEC_MAKE_STRING(buf);
+                iovec[1] = IOVEC_MAKE_STRING(comm);
+                assert_se(journal_file_append_entry(f, &ts, NULL, iovec, 2, NULL, NULL, NULL) == 0);
+        }
+
+        assert_se(journal_file_open(-1, "test2.journal", O_RDWR|O_CREAT, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, f, &g) == 0);
+        assert_se(JOURNAL_HEADER_ZSTD_DICTIONARY(g->header));
+        assert_se(g->header->zstd_dictionary_offset != 0);
+
+        for (unsigned i = 5000; i < 5100; i++) {
+                xsprintf(buf, "MESSAGE=Started session %u of user root.", i);
+                iovec[0] = IOVEC_MAKE_STRING(buf);
+                iovec[1] = IOVEC_MAKE_STRING("_COMM=sshd");
+                assert_se(journal_file_append_entry(g, &ts, NULL, iovec, 2, NULL, NULL, NULL) == 0);
+        }
+
+        /* Small objects are compressed against the dictionary now */
+        assert_se(journal_file_find_data_object(g, buf, strlen(buf), &o, NULL) == 1);
+        assert_se(o->object.flags & OBJECT_COMPRESSED_ZSTD);
+        assert_se(le64toh(o->object.size) - offsetof(Object, data.payload) < strlen(buf));
+
+        assert_se(journal_file_verify(g, NULL, NULL, NULL, NULL, false) >= 0);
+
+        (void) journal_file_close(g);
+        (void) journal_file_close(f);
+
+        /* Reopening the file loads the dictionary again */
+        assert_se(journal_file_open(-1, "test2.journal", O_RDONLY, 0666, true, UINT64_MAX, false, NULL, NULL, NULL, NULL, &g) == 0);
+        assert_se(journal_file_find_data_object(g, buf, strlen(buf), NULL, NULL) == 1);
+        assert_se(journal_file_find_data_object(g, "_COMM=sshd", STRLEN("_COMM=sshd"), NULL, NULL) == 1);
+        (void) journal_file_close(g);
+
+        assert_se(unsetenv("SYSTEMD_JOURNAL_ZSTD_DICTIONARY") >= 0);
+
+        if (arg_keep)
+                log_info("Not removing %s", t);
+        else
+                assert_se(rm_rf(t, REMOVE_ROOT|REMOVE_PHYSICAL) >= 0);
+
+        puts("------------------------------------------------------------");
+}
+#endif
+
 static void test_empty(void) {
         JournalFile *f1, *f2, *f3, *f4;
         char t[] = "/var/tmp/journal-XXXXXX";
@@ -250,6 +634,14 @@ int main(int argc, char *argv[]) {
                 return log_tests_skipped("/etc/machine-id not found");
 
         test_non_empty();
+        test_append_entries();
+        test_data_dedup();
+        test_data_bloom();
+        test_realtime_index();
+        test_archive_post_process();
+#if HAVE_ZSTD
+        test_zstd_dictionary();
+#endif
         test_empty();
 #if HAVE_COMPRESSION
         test_min_compress_size();
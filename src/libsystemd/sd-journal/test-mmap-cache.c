@@ -12,7 +12,7 @@
 #include "util.h"
 
 int main(int argc, char *argv[]) {
-        MMapFileDescriptor *fx;
+        MMapFileDescriptor *fx, *fy;
         int x, y, z, r;
         char px[] = "/tmp/testmmapXXXXXXX", py[] = "/tmp/testmmapYXXXXXX", pz[] = "/tmp/testmmapZXXXXXX";
         MMapCache *m;
@@ -55,6 +55,27 @@ int main(int argc, char *argv[]) {
 
         assert_se((uint8_t*) p + 1 == (uint8_t*) q);
 
+#if !ENABLE_DEBUG_MMAP_CACHE
+        /* Walk through the file sequentially, the windows should grow so that far away objects end up
+         * in the same window. */
+        assert_se(fy = mmap_cache_add_fd(m, y, PROT_READ));
+
+        for (uint64_t o = 0; o < 128ULL*1024ULL*1024ULL; o += 4ULL*1024ULL*1024ULL) {
+                r = mmap_cache_get(m, fy, 2, false, o, 16, NULL, &p);
+                assert_se(r >= 0);
+        }
+
+        r = mmap_cache_get(m, fy, 3, false, 128ULL*1024ULL*1024ULL, 16, NULL, &p);
+        assert_se(r >= 0);
+
+        r = mmap_cache_get(m, fy, 3, false, 128ULL*1024ULL*1024ULL + 32ULL*1024ULL*1024ULL, 16, NULL, &q);
+        assert_se(r >= 0);
+
+        assert_se((uint8_t*) p + 32ULL*1024ULL*1024ULL == (uint8_t*) q);
+
+        mmap_cache_free_fd(m, fy);
+#endif
+
         mmap_cache_free_fd(m, fx);
         mmap_cache_unref(m);
 
@@ -14,6 +14,12 @@
 
 #define RTNL_RQUEUE_MAX 64*1024
 
+#define RTNL_RBUFFER_SIZE_MIN (32U*1024U)
+
+/* While corked, messages are sent in batches of at most this many messages or bytes */
+#define RTNL_WQUEUE_MAX 64
+#define RTNL_WQUEUE_SIZE_MAX (64U*1024U)
+
 #define RTNL_CONTAINER_DEPTH 32
 
 struct reply_callback {
@@ -77,7 +83,12 @@ struct sd_netlink {
 
         struct nlmsghdr *rbuffer;
 
+        sd_netlink_message **wqueue;
+        size_t wqueue_size;
+        size_t wqueue_bytes;
+
         bool processing:1;
+        bool corked:1;
 
         uint32_t serial;
 
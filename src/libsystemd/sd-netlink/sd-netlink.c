@@ -61,9 +61,11 @@ static int sd_netlink_new(sd_netlink **ret) {
                 .serial = (uint32_t) (now(CLOCK_MONOTONIC) % UINT32_MAX) + 1,
         };
 
-        /* We guarantee that the read buffer has at least space for
-         * a message header */
-        if (!greedy_realloc((void**)&rtnl->rbuffer, sizeof(struct nlmsghdr), sizeof(uint8_t)))
+        /* We guarantee that the read buffer has at least space for a message header. In fact, make it
+         * large right away: the kernel sizes the datagrams it sends us for dumps after the largest buffer we
+         * ever passed to recvmsg() (capped at 32K), hence with a small buffer, dumps of large tables arrive
+         * in small datagrams of a page or so each, and cost many more syscalls. */
+        if (!greedy_realloc((void**)&rtnl->rbuffer, RTNL_RBUFFER_SIZE_MIN, sizeof(uint8_t)))
                 return -ENOMEM;
 
         *ret = TAKE_PTR(rtnl);
@@ -186,6 +188,10 @@ static sd_netlink *netlink_free(sd_netlink *rtnl) {
                 sd_netlink_message_unref(rtnl->rqueue_partial[i]);
         free(rtnl->rqueue_partial);
 
+        for (size_t j = 0; j < rtnl->wqueue_size; j++)
+                sd_netlink_message_unref(rtnl->wqueue[j]);
+        free(rtnl->wqueue);
+
         free(rtnl->rbuffer);
 
         while ((s = rtnl->slots)) {
@@ -232,6 +238,79 @@ static void rtnl_seal_message(sd_netlink *rtnl, sd_netlink_message *m) {
         rtnl_message_seal(m);
 }
 
+static int netlink_flush_wqueue(sd_netlink *nl) {
+        ssize_t k;
+
+        assert(nl);
+
+        if (nl->wqueue_size == 0)
+                return 0;
+
+        /* Send all queued messages in a single datagram, the kernel processes them one after the other. If
+         * that fails, none of them was sent, hence queue synthetic error replies for all of them, which are
+         * then dispatched to the reply callbacks from the event loop, like regular replies. */
+        k = socket_writev_message(nl, nl->wqueue, nl->wqueue_size);
+        if (k < 0) {
+                log_debug_errno(k, "sd-netlink: failed to send %zu queued messages: %m", nl->wqueue_size);
+
+                for (size_t i = 0; i < nl->wqueue_size; i++) {
+                        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
+
+                        /* If this fails, the reply callback will time out eventually */
+                        if (rtnl_message_new_synthetic_error(nl, k, rtnl_message_get_serial(nl->wqueue[i]), &m) < 0)
+                                continue;
+                        if (rtnl_rqueue_make_room(nl) < 0)
+                                continue;
+
+                        nl->rqueue[nl->rqueue_size++] = TAKE_PTR(m);
+                }
+        }
+
+        for (size_t i = 0; i < nl->wqueue_size; i++)
+                sd_netlink_message_unref(nl->wqueue[i]);
+        nl->wqueue_size = 0;
+        nl->wqueue_bytes = 0;
+
+        return k < 0 ? (int) k : 0;
+}
+
+static int netlink_queue_message(sd_netlink *nl, sd_netlink_message *m, uint32_t *serial) {
+        assert(nl);
+        assert(m);
+        assert(m->hdr);
+        assert(serial);
+
+        if (m->sealed)
+                return -EPERM;
+
+        if (nl->wqueue_size >= RTNL_WQUEUE_MAX ||
+            nl->wqueue_bytes + m->hdr->nlmsg_len > RTNL_WQUEUE_SIZE_MAX)
+                (void) netlink_flush_wqueue(nl); /* Failures are reported to the reply callbacks */
+
+        if (!GREEDY_REALLOC(nl->wqueue, nl->wqueue_size + 1))
+                return -ENOMEM;
+
+        rtnl_seal_message(nl, m);
+
+        nl->wqueue[nl->wqueue_size++] = sd_netlink_message_ref(m);
+        nl->wqueue_bytes += m->hdr->nlmsg_len;
+
+        *serial = rtnl_message_get_serial(m);
+        return 1;
+}
+
+int sd_netlink_cork(sd_netlink *nl, int b) {
+        assert_return(nl, -EINVAL);
+        assert_return(!rtnl_pid_changed(nl), -ECHILD);
+
+        nl->corked = b;
+
+        if (b)
+                return 0;
+
+        return netlink_flush_wqueue(nl);
+}
+
 int sd_netlink_send(sd_netlink *nl,
                     sd_netlink_message *message,
                     uint32_t *serial) {
@@ -242,6 +321,9 @@ int sd_netlink_send(sd_netlink *nl,
         assert_return(message, -EINVAL);
         assert_return(!message->sealed, -EPERM);
 
+        /* Keep the order of messages, send whatever is queued first */
+        (void) netlink_flush_wqueue(nl);
+
         rtnl_seal_message(nl, message);
 
         r = socket_write_message(nl, message);
@@ -274,6 +356,8 @@ int sd_netlink_sendv(
                         return -ENOMEM;
         }
 
+        (void) netlink_flush_wqueue(nl);
+
         for (unsigned i = 0; i < msgcount; i++) {
                 assert_return(!messages[i]->sealed, -EPERM);
 
@@ -602,7 +686,7 @@ int sd_netlink_call_async(
         if (hashmap_size(nl->reply_callbacks) >= REPLY_CALLBACKS_MAX)
                 return -ERANGE;
 
-        r = hashmap_ensure_allocated(&nl->reply_callbacks, &trivial_hash_ops);
+        r = hashmap_ensure_allocated(&nl->reply_callbacks, &trivial_hash_ops_trusted);
         if (r < 0)
                 return r;
 
@@ -619,7 +703,10 @@ int sd_netlink_call_async(
         slot->reply_callback.callback = callback;
         slot->reply_callback.timeout = calc_elapse(usec);
 
-        k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
+        if (nl->corked)
+                k = netlink_queue_message(nl, m, &slot->reply_callback.serial);
+        else
+                k = sd_netlink_send(nl, m, &slot->reply_callback.serial);
         if (k < 0)
                 return k;
 
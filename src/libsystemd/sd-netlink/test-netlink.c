@@ -390,6 +390,34 @@ static void test_pipe(int ifindex) {
         assert_se((rtnl = sd_netlink_unref(rtnl)) == NULL);
 }
 
+static void test_pipe_corked(int ifindex) {
+        _cleanup_(sd_netlink_unrefp) sd_netlink *rtnl = NULL;
+        int counter = 0;
+
+        assert_se(sd_netlink_open(&rtnl) >= 0);
+
+        assert_se(sd_netlink_cork(rtnl, true) >= 0);
+
+        /* More than fit into one batch */
+        for (unsigned i = 0; i < 100; i++) {
+                _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
+
+                assert_se(sd_rtnl_message_new_link(rtnl, &m, RTM_GETLINK, ifindex) >= 0);
+
+                counter++;
+                assert_se(sd_netlink_call_async(rtnl, NULL, m, pipe_handler, NULL, &counter, 0, NULL) >= 0);
+        }
+
+        assert_se(sd_netlink_cork(rtnl, false) >= 0);
+
+        while (counter > 0) {
+                assert_se(sd_netlink_wait(rtnl, 0) >= 0);
+                assert_se(sd_netlink_process(rtnl, NULL) >= 0);
+        }
+
+        assert_se((rtnl = sd_netlink_unref(rtnl)) == NULL);
+}
+
 static void test_container(sd_netlink *rtnl) {
         _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *m = NULL;
         uint16_t u16_data;
@@ -574,6 +602,7 @@ int main(void) {
         test_slot_set(if_loopback);
         test_async_destroy_callback(if_loopback);
         test_pipe(if_loopback);
+        test_pipe_corked(if_loopback);
         test_event_loop(if_loopback);
         test_link_configure(rtnl, if_loopback);
 
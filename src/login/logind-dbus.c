@@ -3866,6 +3866,14 @@ int match_job_removed(sd_bus_message *message, void *userdata, sd_bus_error *err
         session = hashmap_get(m->session_units, unit);
         if (session) {
                 if (streq_ptr(path, session->scope_job)) {
+                        char ts[FORMAT_TIMESPAN_MAX];
+
+                        log_debug("Scope job of session %s finished with result '%s' after %s.",
+                                  session->id, result,
+                                  format_timespan(ts, sizeof ts,
+                                                  usec_sub_unsigned(now(CLOCK_MONOTONIC), session->timestamp.monotonic),
+                                                  USEC_PER_MSEC));
+
                         session->scope_job = mfree(session->scope_job);
                         (void) session_jobs_reply(session, id, unit, result);
 
@@ -3994,6 +4002,26 @@ int manager_send_changed(Manager *manager, const char *property, ...) {
                         l);
 }
 
+int manager_send_object_changed(Manager *manager, const char *path, const char *interface, char **names) {
+        assert(manager);
+        assert(path);
+        assert(interface);
+
+        if (!manager->changed_queue)
+                return sd_bus_emit_properties_changed_strv(manager->bus, path, interface, names);
+
+        return bus_changed_queue_add_strv(manager->changed_queue, path, interface, names);
+}
+
+int manager_flush_changed(Manager *manager) {
+        assert(manager);
+
+        if (!manager->changed_queue)
+                return 0;
+
+        return bus_changed_queue_flush(manager->changed_queue);
+}
+
 static int strdup_job(sd_bus_message *reply, char **job) {
         const char *j;
         char *copy;
@@ -388,6 +388,9 @@ int seat_send_signal(Seat *s, bool new_seat) {
         if (!p)
                 return -ENOMEM;
 
+        /* Send out pending property changes first, so that this signal doesn't overtake them */
+        (void) manager_flush_changed(s->manager);
+
         return sd_bus_emit_signal(
                         s->manager->bus,
                         "/org/freedesktop/login1",
@@ -411,7 +414,7 @@ int seat_send_changed(Seat *s, const char *properties, ...) {
 
         l = strv_from_stdarg_alloca(properties);
 
-        return sd_bus_emit_properties_changed_strv(s->manager->bus, p, "org.freedesktop.login1.Seat", l);
+        return manager_send_object_changed(s->manager, p, "org.freedesktop.login1.Seat", l);
 }
 
 static const sd_bus_vtable seat_vtable[] = {
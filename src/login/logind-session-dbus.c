@@ -700,6 +700,9 @@ int session_send_signal(Session *s, bool new_session) {
         if (!p)
                 return -ENOMEM;
 
+        /* Send out pending property changes first, so that this signal doesn't overtake them */
+        (void) manager_flush_changed(s->manager);
+
         return sd_bus_emit_signal(
                         s->manager->bus,
                         "/org/freedesktop/login1",
@@ -723,7 +726,7 @@ int session_send_changed(Session *s, const char *properties, ...) {
 
         l = strv_from_stdarg_alloca(properties);
 
-        return sd_bus_emit_properties_changed_strv(s->manager->bus, p, "org.freedesktop.login1.Session", l);
+        return manager_send_object_changed(s->manager, p, "org.freedesktop.login1.Session", l);
 }
 
 int session_send_lock(Session *s, bool lock) {
@@ -773,6 +776,7 @@ int session_send_create_reply(Session *s, sd_bus_error *error) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *c = NULL;
         _cleanup_close_ int fifo_fd = -1;
         _cleanup_free_ char *p = NULL;
+        char ts[FORMAT_TIMESPAN_MAX];
 
         assert(s);
 
@@ -802,14 +806,15 @@ int session_send_create_reply(Session *s, sd_bus_error *error) {
 
         log_debug("Sending reply about created session: "
                   "id=%s object_path=%s uid=%u runtime_path=%s "
-                  "session_fd=%d seat=%s vtnr=%u",
+                  "session_fd=%d seat=%s vtnr=%u, setup took %s",
                   s->id,
                   p,
                   (uint32_t) s->user->user_record->uid,
                   s->user->runtime_path,
                   fifo_fd,
                   s->seat ? s->seat->id : "",
-                  (uint32_t) s->vtnr);
+                  (uint32_t) s->vtnr,
+                  format_timespan(ts, sizeof ts, usec_sub_unsigned(now(CLOCK_MONOTONIC), s->timestamp.monotonic), USEC_PER_MSEC));
 
         return sd_bus_reply_method_return(
                         c, "soshusub",
@@ -407,6 +407,9 @@ int user_send_signal(User *u, bool new_user) {
         if (!p)
                 return -ENOMEM;
 
+        /* Send out pending property changes first, so that this signal doesn't overtake them */
+        (void) manager_flush_changed(u->manager);
+
         return sd_bus_emit_signal(
                         u->manager->bus,
                         "/org/freedesktop/login1",
@@ -430,5 +433,5 @@ int user_send_changed(User *u, const char *properties, ...) {
 
         l = strv_from_stdarg_alloca(properties);
 
-        return sd_bus_emit_properties_changed_strv(u->manager->bus, p, "org.freedesktop.login1.User", l);
+        return manager_send_object_changed(u->manager, p, "org.freedesktop.login1.User", l);
 }
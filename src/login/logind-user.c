@@ -133,29 +133,16 @@ User *user_free(User *u) {
         u->slice = mfree(u->slice);
         u->runtime_path = mfree(u->runtime_path);
         u->state_file = mfree(u->state_file);
+        u->saved_state = mfree(u->saved_state);
 
         user_record_unref(u->user_record);
 
         return mfree(u);
 }
 
-static int user_save_internal(User *u) {
-        _cleanup_free_ char *temp_path = NULL;
-        _cleanup_fclose_ FILE *f = NULL;
-        int r;
-
+static void user_serialize(User *u, FILE *f) {
         assert(u);
-        assert(u->state_file);
-
-        r = mkdir_safe_label("/run/systemd/users", 0755, 0, 0, MKDIR_WARN_MODE);
-        if (r < 0)
-                goto fail;
-
-        r = fopen_temporary(u->state_file, &f, &temp_path);
-        if (r < 0)
-                goto fail;
-
-        (void) fchmod(fileno(f), 0644);
+        assert(f);
 
         fprintf(f,
                 "# This is private data. Do not parse.\n"
@@ -273,6 +260,46 @@ static int user_save_internal(User *u) {
                 }
                 fputc('\n', f);
         }
+}
+
+static int user_save_internal(User *u) {
+        _cleanup_free_ char *temp_path = NULL, *text = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        size_t size;
+        int r;
+
+        assert(u);
+        assert(u->state_file);
+
+        /* The user record is saved whenever any of its sessions changes, often several times in a row with
+         * the same contents. Hence, serialize it to memory first, and only write it out if it changed. */
+
+        f = open_memstream_unlocked(&text, &size);
+        if (!f)
+                return log_oom();
+
+        user_serialize(u, f);
+
+        r = fflush_and_check(f);
+        if (r < 0)
+                return log_error_errno(r, "Failed to serialize user data: %m");
+
+        f = safe_fclose(f);
+
+        if (streq_ptr(text, u->saved_state))
+                return 0;
+
+        r = mkdir_safe_label("/run/systemd/users", 0755, 0, 0, MKDIR_WARN_MODE);
+        if (r < 0)
+                goto fail;
+
+        r = fopen_temporary(u->state_file, &f, &temp_path);
+        if (r < 0)
+                goto fail;
+
+        (void) fchmod(fileno(f), 0644);
+
+        fputs(text, f);
 
         r = fflush_and_check(f);
         if (r < 0)
@@ -283,10 +310,12 @@ static int user_save_internal(User *u) {
                 goto fail;
         }
 
+        free_and_replace(u->saved_state, text);
         return 0;
 
 fail:
         (void) unlink(u->state_file);
+        u->saved_state = mfree(u->saved_state);
 
         if (temp_path)
                 (void) unlink(temp_path);
@@ -559,6 +588,7 @@ int user_finalize(User *u) {
         }
 
         (void) unlink(u->state_file);
+        u->saved_state = mfree(u->saved_state);
         user_add_to_gc_queue(u);
 
         if (u->started) {
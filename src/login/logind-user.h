@@ -25,6 +25,7 @@ struct User {
         UserRecord *user_record;
 
         char *state_file;
+        char *saved_state;               /* what was last written to state_file */
         char *runtime_path;
 
         char *slice;                     /* user-UID.slice */
@@ -156,6 +156,7 @@ static Manager* manager_unref(Manager *m) {
 
         bus_verify_polkit_async_registry_free(m->polkit_registry);
 
+        bus_changed_queue_free(m->changed_queue);
         sd_bus_flush_close_unref(m->bus);
         sd_event_unref(m->event);
 
@@ -680,6 +681,10 @@ static int manager_connect_bus(Manager *m) {
         if (r < 0)
                 return log_error_errno(r, "Failed to attach bus to event loop: %m");
 
+        r = bus_changed_queue_new(m->bus, m->event, 0, &m->changed_queue);
+        if (r < 0)
+                return log_error_errno(r, "Failed to allocate queue for property changes: %m");
+
         return 0;
 }
 
@@ -8,6 +8,7 @@
 #include "sd-device.h"
 #include "sd-event.h"
 
+#include "bus-changed-queue.h"
 #include "conf-parser.h"
 #include "hashmap.h"
 #include "list.h"
@@ -26,6 +27,10 @@ struct Manager {
         sd_event *event;
         sd_bus *bus;
 
+        /* Collects the PropertiesChanged signals of sessions, users and seats, so that each object sends
+         * at most one per event loop iteration */
+        BusChangedQueue *changed_queue;
+
         Hashmap *devices;
         Hashmap *seats;
         Hashmap *sessions;
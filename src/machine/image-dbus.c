@@ -18,6 +18,7 @@
 #include "loop-util.h"
 #include "missing_capability.h"
 #include "mount-util.h"
+#include "operation.h"
 #include "os-util.h"
 #include "process-util.h"
 #include "raw-clone.h"
@@ -26,6 +27,176 @@
 
 static BUS_DEFINE_PROPERTY_GET_ENUM(property_get_type, image_type, ImageType);
 
+typedef struct ImageMetadata {
+        char *path;
+        struct stat st;
+
+        char *hostname;
+        sd_id128_t machine_id;
+        char **machine_info;
+        char **os_release;
+} ImageMetadata;
+
+static ImageMetadata* image_metadata_free(ImageMetadata *md) {
+        if (!md)
+                return NULL;
+
+        free(md->path);
+        free(md->hostname);
+        strv_free(md->machine_info);
+        strv_free(md->os_release);
+        return mfree(md);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(ImageMetadata*, image_metadata_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(image_metadata_hash_ops, char, path_hash_func, path_compare,
+                                              ImageMetadata, image_metadata_free);
+
+static bool image_metadata_is_current(const ImageMetadata *md, const struct stat *st) {
+        assert(md);
+        assert(st);
+
+        return md->st.st_dev == st->st_dev &&
+                md->st.st_ino == st->st_ino &&
+                md->st.st_size == st->st_size &&
+                md->st.st_mtim.tv_sec == st->st_mtim.tv_sec &&
+                md->st.st_mtim.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+void manager_image_metadata_cache_prune(Manager *m) {
+        ImageMetadata *md;
+
+        assert(m);
+
+        /* Drops what we remember about image files that are gone or were modified since, for example after
+         * images were removed, renamed or cloned. */
+
+        HASHMAP_FOREACH(md, m->image_metadata_cache) {
+                struct stat st;
+
+                if (stat(md->path, &st) >= 0 && image_metadata_is_current(md, &st))
+                        continue;
+
+                image_metadata_free(hashmap_remove(m->image_metadata_cache, md->path));
+        }
+}
+
+static int image_operation_done(Operation *o, int ret, sd_bus_error *error) {
+        assert(o);
+
+        manager_image_metadata_cache_prune(o->manager);
+
+        if (ret < 0)
+                return ret;
+
+        return sd_bus_reply_method_return(o->message, NULL);
+}
+
+static int image_metadata_remember(Manager *m, Image *image, const struct stat *st) {
+        _cleanup_(image_metadata_freep) ImageMetadata *md = NULL;
+        int r;
+
+        assert(m);
+        assert(image);
+        assert(st);
+
+        md = new(ImageMetadata, 1);
+        if (!md)
+                return -ENOMEM;
+
+        *md = (ImageMetadata) {
+                .path = strdup(image->path),
+                .st = *st,
+                .machine_id = image->machine_id,
+        };
+        if (!md->path)
+                return -ENOMEM;
+
+        r = free_and_strdup(&md->hostname, image->hostname);
+        if (r < 0)
+                return r;
+
+        md->machine_info = strv_copy(image->machine_info);
+        if (!md->machine_info)
+                return -ENOMEM;
+
+        md->os_release = strv_copy(image->os_release);
+        if (!md->os_release)
+                return -ENOMEM;
+
+        image_metadata_free(hashmap_remove(m->image_metadata_cache, md->path));
+
+        r = hashmap_ensure_put(&m->image_metadata_cache, &image_metadata_hash_ops, md->path, md);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(md);
+        return 0;
+}
+
+static int image_acquire_metadata(Image *image) {
+        Manager *m = image->userdata;
+        ImageMetadata *md;
+        struct stat st;
+        int r;
+
+        assert(image);
+        assert(m);
+
+        if (image->metadata_valid)
+                return 0;
+
+        /* Reading the metadata of a raw image means dissecting it and mounting it in a child process, and
+         * Image objects don't live longer than one event loop iteration here. Hence remember what we found
+         * per image file, for as long as the file remains unmodified. Directory trees are cheap to read
+         * directly, and their top-level timestamps don't tell us about changes inside anyway. */
+        if (image->type != IMAGE_RAW)
+                return image_read_metadata(image);
+
+        if (stat(image->path, &st) < 0) {
+                image_metadata_free(hashmap_remove(m->image_metadata_cache, image->path));
+                return -errno;
+        }
+
+        md = hashmap_get(m->image_metadata_cache, image->path);
+        if (md && !image_metadata_is_current(md, &st)) {
+                image_metadata_free(hashmap_remove(m->image_metadata_cache, image->path));
+                md = NULL;
+        }
+        if (md) {
+                _cleanup_strv_free_ char **machine_info = NULL, **os_release = NULL;
+
+                machine_info = strv_copy(md->machine_info);
+                if (!machine_info)
+                        return -ENOMEM;
+
+                os_release = strv_copy(md->os_release);
+                if (!os_release)
+                        return -ENOMEM;
+
+                r = free_and_strdup(&image->hostname, md->hostname);
+                if (r < 0)
+                        return r;
+
+                image->machine_id = md->machine_id;
+                strv_free_and_replace(image->machine_info, machine_info);
+                strv_free_and_replace(image->os_release, os_release);
+                image->metadata_valid = true;
+                return 0;
+        }
+
+        r = image_read_metadata(image);
+        if (r < 0)
+                return r;
+
+        r = image_metadata_remember(m, image, &st);
+        if (r < 0)
+                log_debug_errno(r, "Failed to cache metadata of image '%s', ignoring: %m", image->name);
+
+        return 0;
+}
+
 int bus_image_method_remove(
                 sd_bus_message *message,
                 void *userdata,
@@ -34,6 +205,7 @@ int bus_image_method_remove(
         _cleanup_close_pair_ int errno_pipe_fd[2] = { -1, -1 };
         Image *image = userdata;
         Manager *m = image->userdata;
+        Operation *operation;
         pid_t child;
         int r;
 
@@ -77,12 +249,14 @@ int bus_image_method_remove(
 
         errno_pipe_fd[1] = safe_close(errno_pipe_fd[1]);
 
-        r = operation_new(m, NULL, child, message, errno_pipe_fd[0], NULL);
+        r = operation_new(m, NULL, child, message, errno_pipe_fd[0], &operation);
         if (r < 0) {
                 (void) sigkill_wait(child);
                 return r;
         }
 
+        operation->done = image_operation_done;
+
         errno_pipe_fd[0] = -1;
 
         return 1;
@@ -126,6 +300,8 @@ int bus_image_method_rename(
         if (r < 0)
                 return r;
 
+        manager_image_metadata_cache_prune(m);
+
         return sd_bus_reply_method_return(message, NULL);
 }
 
@@ -137,6 +313,7 @@ int bus_image_method_clone(
         _cleanup_close_pair_ int errno_pipe_fd[2] = { -1, -1 };
         Image *image = userdata;
         Manager *m = image->userdata;
+        Operation *operation;
         const char *new_name;
         int r, read_only;
         pid_t child;
@@ -189,12 +366,14 @@ int bus_image_method_clone(
 
         errno_pipe_fd[1] = safe_close(errno_pipe_fd[1]);
 
-        r = operation_new(m, NULL, child, message, errno_pipe_fd[0], NULL);
+        r = operation_new(m, NULL, child, message, errno_pipe_fd[0], &operation);
         if (r < 0) {
                 (void) sigkill_wait(child);
                 return r;
         }
 
+        operation->done = image_operation_done;
+
         errno_pipe_fd[0] = -1;
 
         return 1;
@@ -283,11 +462,9 @@ int bus_image_method_get_hostname(
         Image *image = userdata;
         int r;
 
-        if (!image->metadata_valid) {
-                r = image_read_metadata(image);
-                if (r < 0)
-                        return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
-        }
+        r = image_acquire_metadata(image);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
 
         return sd_bus_reply_method_return(message, "s", image->hostname);
 }
@@ -301,11 +478,9 @@ int bus_image_method_get_machine_id(
         Image *image = userdata;
         int r;
 
-        if (!image->metadata_valid) {
-                r = image_read_metadata(image);
-                if (r < 0)
-                        return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
-        }
+        r = image_acquire_metadata(image);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
 
         r = sd_bus_message_new_method_return(message, &reply);
         if (r < 0)
@@ -329,11 +504,9 @@ int bus_image_method_get_machine_info(
         Image *image = userdata;
         int r;
 
-        if (!image->metadata_valid) {
-                r = image_read_metadata(image);
-                if (r < 0)
-                        return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
-        }
+        r = image_acquire_metadata(image);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
 
         return bus_reply_pair_array(message, image->machine_info);
 }
@@ -346,11 +519,9 @@ int bus_image_method_get_os_release(
         Image *image = userdata;
         int r;
 
-        if (!image->metadata_valid) {
-                r = image_read_metadata(image);
-                if (r < 0)
-                        return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
-        }
+        r = image_acquire_metadata(image);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to read image metadata: %m");
 
         return bus_reply_pair_array(message, image->os_release);
 }
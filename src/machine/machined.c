@@ -81,6 +81,7 @@ static Manager* manager_unref(Manager *m) {
         hashmap_free(m->machine_units);
         hashmap_free(m->machine_leaders);
         hashmap_free(m->image_cache);
+        hashmap_free(m->image_metadata_cache);
 
         sd_event_source_unref(m->image_cache_defer_event);
 #if ENABLE_NSCD
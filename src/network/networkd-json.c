@@ -114,6 +114,13 @@ int manager_build_json(Manager *manager, JsonVariant **ret) {
         assert(manager);
         assert(ret);
 
+        /* Monitoring tools may call Describe() every few seconds, which is costly with many links.
+         * Hence, reuse the previous result as long as no link changed in the meantime. */
+        if (manager->json) {
+                *ret = json_variant_ref(manager->json);
+                return 0;
+        }
+
         elements = new(JsonVariant*, hashmap_size(manager->links_by_index));
         if (!elements)
                 return -ENOMEM;
@@ -128,9 +135,17 @@ int manager_build_json(Manager *manager, JsonVariant **ret) {
         typesafe_qsort(elements, n, link_json_compare);
 
         r = json_build(ret, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("Interfaces", JSON_BUILD_VARIANT_ARRAY(elements, n))));
+        if (r >= 0)
+                manager->json = json_variant_ref(*ret);
 
 finalize:
         json_variant_unref_many(elements, n);
         free(elements);
         return r;
 }
+
+void manager_invalidate_json(Manager *manager) {
+        assert(manager);
+
+        manager->json = json_variant_unref(manager->json);
+}
@@ -8,3 +8,4 @@ typedef struct Manager Manager;
 
 int link_build_json(Link *link, JsonVariant **ret);
 int manager_build_json(Manager *manager, JsonVariant **ret);
+void manager_invalidate_json(Manager *manager);
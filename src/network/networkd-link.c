@@ -36,6 +36,7 @@
 #include "networkd-ipv4acd.h"
 #include "networkd-ipv4ll.h"
 #include "networkd-ipv6-proxy-ndp.h"
+#include "networkd-json.h"
 #include "networkd-link-bus.h"
 #include "networkd-link.h"
 #include "networkd-lldp-tx.h"
@@ -980,6 +981,7 @@ static Link *link_drop(Link *link) {
 
         (void) unlink(link->state_file);
         link_clean(link);
+        manager_invalidate_json(link->manager);
 
         STRV_FOREACH(n, link->alternative_names)
                 hashmap_remove(link->manager->links_by_name, *n);
@@ -1411,6 +1413,7 @@ static int link_initialized(Link *link, sd_device *device) {
         link_set_state(link, LINK_STATE_INITIALIZED);
 
         link->sd_device = sd_device_ref(device);
+        manager_invalidate_json(link->manager);
 
         /* udev has initialized the link, but we don't know if we have yet
          * processed the NEWLINK messages with the latest state. Do a GETLINK,
@@ -2197,6 +2200,9 @@ static int link_update(Link *link, sd_netlink_message *message) {
         assert(link);
         assert(message);
 
+        /* Name, alternative names and so on may change below. */
+        manager_invalidate_json(link->manager);
+
         r = link_update_name(link, message);
         if (r < 0)
                 return r;
@@ -2304,6 +2310,7 @@ static int link_new(Manager *manager, sd_netlink_message *message, Link **ret) {
                 return log_link_debug_errno(link, r, "Failed to store link into manager: %m");
 
         link->manager = manager;
+        manager_invalidate_json(manager);
 
         r = hashmap_ensure_put(&manager->links_by_name, &string_hash_ops, link->ifname, link);
         if (r < 0)
@@ -12,6 +12,7 @@
 #include "networkd-lldp-tx.h"
 #include "networkd-manager.h"
 #include "networkd-network.h"
+#include "networkd-state-file.h"
 #include "string-table.h"
 #include "string-util.h"
 #include "strv.h"
@@ -54,7 +55,11 @@ static void lldp_handler(sd_lldp *lldp, sd_lldp_event_t event, sd_lldp_neighbor
 
         assert(link);
 
-        (void) link_lldp_save(link);
+        /* A refresh only restarts the TTL of a neighbor whose data is unchanged, hence the saved data stays
+         * the same. Otherwise, let the post handler of the event loop save the data, so that multiple
+         * datagrams received in one event loop iteration result in only one write. */
+        if (event != SD_LLDP_EVENT_REFRESHED)
+                link_dirty(link);
 
         if (link_lldp_emit_enabled(link) && event == SD_LLDP_EVENT_ADDED) {
                 /* If we received information about a new neighbor, restart the LLDP "fast" logic */
@@ -28,6 +28,7 @@
 #include "networkd-address-pool.h"
 #include "networkd-dhcp-server-bus.h"
 #include "networkd-dhcp6.h"
+#include "networkd-json.h"
 #include "networkd-link-bus.h"
 #include "networkd-manager-bus.h"
 #include "networkd-manager.h"
@@ -459,6 +460,7 @@ Manager* manager_free(Manager *m) {
         m->dhcp6_prefixes = hashmap_free_with_destructor(m->dhcp6_prefixes, dhcp6_pd_free);
         m->dhcp6_pd_prefixes = set_free_with_destructor(m->dhcp6_pd_prefixes, dhcp6_pd_free);
 
+        m->json = json_variant_unref(m->json);
         m->dirty_links = set_free_with_destructor(m->dirty_links, link_unref);
         m->links_requesting_uuid = set_free_with_destructor(m->links_requesting_uuid, link_unref);
         m->links_by_name = hashmap_free(m->links_by_name);
@@ -474,6 +476,9 @@ Manager* manager_free(Manager *m) {
         hashmap_free(m->route_table_names_by_number);
         hashmap_free(m->route_table_numbers_by_name);
 
+        set_free(m->ignore_foreign_route_protocols);
+        set_free(m->ignore_foreign_route_tables);
+
         /* routing_policy_rule_free() access m->rules and m->rules_foreign.
          * So, it is necessary to set NULL after the sets are freed. */
         m->rules = set_free(m->rules);
@@ -11,6 +11,7 @@
 #include "dhcp-identifier.h"
 #include "firewall-util.h"
 #include "hashmap.h"
+#include "json.h"
 #include "networkd-link.h"
 #include "networkd-network.h"
 #include "ordered-set.h"
@@ -34,8 +35,15 @@ struct Manager {
         bool manage_foreign_routes;
         bool manage_foreign_rules;
 
+        /* Routes with these protocols or in these tables are never tracked */
+        Set *ignore_foreign_route_protocols;
+        Set *ignore_foreign_route_tables;
+
         Set *dirty_links;
 
+        /* Cached result of manager_build_json(), dropped whenever a link changes. */
+        JsonVariant *json;
+
         char *state_file;
         LinkOperationalState operational_state;
         LinkCarrierState carrier_state;
@@ -92,6 +100,7 @@ struct Manager {
         usec_t speed_meter_interval_usec;
         usec_t speed_meter_usec_new;
         usec_t speed_meter_usec_old;
+        bool speed_meter_pending;
 
         bool dhcp4_prefix_root_cannot_set_table;
         bool bridge_mdb_on_master_not_supported;
@@ -10,6 +10,8 @@
 #include "conf-parser.h"
 #include "dns-domain.h"
 #include "fd-util.h"
+#include "fileio.h"
+#include "fs-util.h"
 #include "hostname-util.h"
 #include "in-addr-util.h"
 #include "net-condition.h"
@@ -32,6 +34,7 @@
 #include "parse-util.h"
 #include "path-lookup.h"
 #include "set.h"
+#include "siphash24.h"
 #include "socket-util.h"
 #include "stat-util.h"
 #include "string-table.h"
@@ -271,6 +274,86 @@ int network_verify(Network *network) {
         return 0;
 }
 
+#define CONFIG_HASH_KEY SD_ID128_MAKE(5c,3e,0b,8f,a1,72,4d,e6,93,2b,7f,d0,14,c8,65,a9)
+
+static int network_config_parse(Network *network, const char *filename, const char *dropin_dirname, const char *sections) {
+        _cleanup_strv_free_ char **dropin_dirs = NULL, **files = NULL;
+        struct siphash state;
+        usec_t mtime = 0;
+        const char *suffix;
+        char **f;
+        int r;
+
+        assert(network);
+        assert(filename);
+        assert(dropin_dirname);
+
+        /* Like config_parse_many(), but each file is read into memory once, and exactly the bytes that are
+         * parsed are hashed too, in the order they are parsed. A reload can then tell whether anything
+         * actually changed, even if the timestamps did. */
+
+        suffix = strjoina("/", dropin_dirname);
+        r = strv_extend_strv_concat(&dropin_dirs, (char**) NETWORK_DIRS, suffix);
+        if (r < 0)
+                return r;
+
+        r = conf_files_list_strv(&files, ".conf", NULL, 0, (const char* const*) dropin_dirs);
+        if (r < 0)
+                return r;
+
+        r = strv_extend_front(&files, filename);
+        if (r < 0)
+                return r;
+
+        siphash24_init(&state, CONFIG_HASH_KEY.bytes);
+
+        STRV_FOREACH(f, files) {
+                _cleanup_fclose_ FILE *file = NULL, *mem = NULL;
+                _cleanup_free_ char *data = NULL;
+                struct stat st;
+                size_t size;
+
+                r = fopen_unlocked(*f, "re", &file);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to open configuration file '%s': %m", *f);
+
+                /* The stream config_parse() reads from has no fd, hence do what it would do with it here */
+                if (fstat(fileno(file), &st) < 0)
+                        return log_error_errno(errno, "Failed to fstat(%s): %m", *f);
+
+                (void) stat_warn_permissions(*f, &st);
+                mtime = MAX(mtime, timespec_load(&st.st_mtim));
+
+                r = read_full_stream(file, &data, &size);
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read configuration file '%s': %m", *f);
+
+                siphash24_compress(*f, strlen(*f) + 1, &state);
+                siphash24_compress(&size, sizeof(size), &state);
+                siphash24_compress(data, size, &state);
+
+                if (size == 0)
+                        continue;
+
+                mem = fmemopen_unlocked(data, size, "r");
+                if (!mem)
+                        return log_oom();
+
+                r = config_parse(NULL, *f, mem,
+                                 sections,
+                                 config_item_perf_lookup, network_network_gperf_lookup,
+                                 CONFIG_PARSE_WARN,
+                                 network,
+                                 NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        network->timestamp = mtime;
+        network->config_hash = siphash24_finalize(&state);
+        return 0;
+}
+
 int network_load_one(Manager *manager, OrderedHashmap **networks, const char *filename) {
         _cleanup_free_ char *fname = NULL, *name = NULL;
         _cleanup_(network_unrefp) Network *network = NULL;
@@ -421,8 +504,8 @@ int network_load_one(Manager *manager, OrderedHashmap **networks, const char *fi
                 .can_non_iso = -1,
         };
 
-        r = config_parse_many(
-                        STRV_MAKE_CONST(filename), NETWORK_DIRS, dropin_dirname,
+        r = network_config_parse(
+                        network, filename, dropin_dirname,
                         "Match\0"
                         "Link\0"
                         "SR-IOV\0"
@@ -476,11 +559,7 @@ int network_load_one(Manager *manager, OrderedHashmap **networks, const char *fi
                         "StochasticFairBlue\0"
                         "StochasticFairnessQueueing\0"
                         "TokenBucketFilter\0"
-                        "TrivialLinkEqualizer\0",
-                        config_item_perf_lookup, network_network_gperf_lookup,
-                        CONFIG_PARSE_WARN,
-                        network,
-                        &network->timestamp);
+                        "TrivialLinkEqualizer\0");
         if (r < 0)
                 return r;
 
@@ -543,8 +622,8 @@ int network_reload(Manager *manager) {
                 if (r < 0)
                         continue; /* The .network file is new. */
 
-                if (n->timestamp != old->timestamp)
-                        continue; /* The .network file is modified. */
+                if (n->timestamp != old->timestamp && n->config_hash != old->config_hash)
+                        continue; /* The .network file or one of its drop-ins is modified. */
 
                 if (!streq(n->filename, old->filename))
                         continue;
@@ -73,6 +73,7 @@ struct Network {
         char *name;
         char *filename;
         usec_t timestamp;
+        uint64_t config_hash; /* of the contents of the .network file and its drop-ins, as parsed */
         char *description;
 
         /* [Match] section */
@@ -262,6 +262,10 @@ int manager_process_requests(sd_event_source *s, void *userdata) {
 
         assert(manager);
 
+        /* Collect the netlink messages of all requests we process here, and send them in batches rather
+         * than one by one. The replies are dispatched to the individual requests as before. */
+        (void) sd_netlink_cork(manager->rtnl, true);
+
         for (;;) {
                 bool processed = false;
                 Request *req;
@@ -311,6 +315,7 @@ int manager_process_requests(sd_event_source *s, void *userdata) {
                                 r = request_process_link_up_or_down(req);
                                 break;
                         default:
+                                (void) sd_netlink_cork(manager->rtnl, false);
                                 return -EINVAL;
                         }
                         if (r < 0)
@@ -326,5 +331,6 @@ int manager_process_requests(sd_event_source *s, void *userdata) {
                         break;
         }
 
+        (void) sd_netlink_cork(manager->rtnl, false);
         return 0;
 }
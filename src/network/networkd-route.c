@@ -170,6 +170,7 @@ static const char * const route_protocol_full_table[] = {
 };
 
 DEFINE_PRIVATE_STRING_TABLE_LOOKUP_TO_STRING_FALLBACK(route_protocol_full, int, UINT8_MAX);
+DEFINE_PRIVATE_STRING_TABLE_LOOKUP_FROM_STRING_FALLBACK(route_protocol_full, int, UINT8_MAX);
 
 static unsigned routes_max(void) {
         static thread_local unsigned cached = 0;
@@ -1856,6 +1857,48 @@ static int process_route_one(Manager *manager, Link *link, uint16_t type, const
         return 1;
 }
 
+static bool route_protocol_may_be_ours(unsigned char protocol) {
+        /* The protocols we install routes with (by default), and the kernel's own ones. */
+        return IN_SET(protocol, RTPROT_UNSPEC, RTPROT_KERNEL, RTPROT_BOOT, RTPROT_STATIC, RTPROT_RA, RTPROT_DHCP);
+}
+
+static bool route_table_may_be_ours(uint32_t table) {
+        return IN_SET(table, RT_TABLE_UNSPEC, RT_TABLE_DEFAULT, RT_TABLE_MAIN, RT_TABLE_LOCAL);
+}
+
+static bool manager_ignores_foreign_route(Manager *m, sd_netlink_message *message) {
+        unsigned char protocol, table8;
+        uint32_t table;
+
+        assert(m);
+        assert(message);
+
+        /* Checks the header fields of the message only, so that routes we are not interested in are dropped
+         * before we allocate anything for them. That matters on hosts where a routing daemon maintains
+         * full Internet routing tables. Routes with a protocol we use ourselves are never dropped, even in an
+         * ignored table, since they may be ours and we need to notice when they go away. */
+
+        if (set_isempty(m->ignore_foreign_route_protocols) && set_isempty(m->ignore_foreign_route_tables))
+                return false;
+
+        if (sd_rtnl_message_route_get_protocol(message, &protocol) < 0)
+                return false;
+
+        if (route_protocol_may_be_ours(protocol))
+                return false;
+
+        if (set_contains(m->ignore_foreign_route_protocols, UINT32_TO_PTR(protocol)))
+                return true;
+
+        if (sd_netlink_message_read_u32(message, RTA_TABLE, &table) < 0) {
+                if (sd_rtnl_message_route_get_table(message, &table8) < 0)
+                        return false;
+                table = table8;
+        }
+
+        return set_contains(m->ignore_foreign_route_tables, UINT32_TO_PTR(table));
+}
+
 int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Manager *m) {
         _cleanup_ordered_set_free_free_ OrderedSet *multipath_routes = NULL;
         _cleanup_(route_freep) Route *tmp = NULL;
@@ -1888,6 +1931,9 @@ int manager_rtnl_process_route(sd_netlink *rtnl, sd_netlink_message *message, Ma
                 return 0;
         }
 
+        if (manager_ignores_foreign_route(m, message))
+                return 0;
+
         r = sd_netlink_message_read_u32(message, RTA_OIF, &ifindex);
         if (r < 0 && r != -ENODATA) {
                 log_warning_errno(r, "rtnl: could not get ifindex from route message, ignoring: %m");
@@ -3051,6 +3097,84 @@ int config_parse_route_table_names(
         }
 }
 
+int config_parse_ignore_foreign_routes(
+                const char *unit,
+                const char *filename,
+                unsigned line,
+                const char *section,
+                unsigned section_line,
+                const char *lvalue,
+                int ltype,
+                const char *rvalue,
+                void *data,
+                void *userdata) {
+
+        Manager *m = userdata;
+        Set **s = data;
+        int r;
+
+        assert(filename);
+        assert(lvalue);
+        assert(rvalue);
+        assert(data);
+        assert(userdata);
+
+        /* ltype is true for route tables, false for route protocols */
+
+        if (isempty(rvalue)) {
+                *s = set_free(*s);
+                return 0;
+        }
+
+        for (const char *p = rvalue;;) {
+                _cleanup_free_ char *word = NULL;
+                uint32_t k;
+
+                r = extract_first_word(&p, &word, NULL, 0);
+                if (r == -ENOMEM)
+                        return log_oom();
+                if (r < 0) {
+                        log_syntax(unit, LOG_WARNING, filename, line, r,
+                                   "Invalid %s=, ignoring assignment: %s", lvalue, rvalue);
+                        return 0;
+                }
+                if (r == 0)
+                        return 0;
+
+                if (ltype) {
+                        r = manager_get_route_table_from_string(m, word, &k);
+                        if (r < 0) {
+                                log_syntax(unit, LOG_WARNING, filename, line, r,
+                                           "Failed to parse route table \"%s\", ignoring: %m", word);
+                                continue;
+                        }
+                        if (route_table_may_be_ours(k)) {
+                                log_syntax(unit, LOG_WARNING, filename, line, 0,
+                                           "Routes in table \"%s\" cannot be ignored, ignoring.", word);
+                                continue;
+                        }
+                } else {
+                        r = route_protocol_full_from_string(word);
+                        if (r < 0) {
+                                log_syntax(unit, LOG_WARNING, filename, line, r,
+                                           "Failed to parse route protocol \"%s\", ignoring: %m", word);
+                                continue;
+                        }
+                        if (route_protocol_may_be_ours(r)) {
+                                log_syntax(unit, LOG_WARNING, filename, line, 0,
+                                           "Routes with protocol \"%s\" cannot be ignored, ignoring.", word);
+                                continue;
+                        }
+
+                        k = r;
+                }
+
+                r = set_ensure_put(s, NULL, UINT32_TO_PTR(k));
+                if (r < 0)
+                        return log_oom();
+        }
+}
+
 static int route_section_verify(Route *route, Network *network) {
         if (section_is_invalid(route->section))
                 return -EINVAL;
@@ -3173,6 +3297,16 @@ static int route_section_verify(Route *route, Network *network) {
                                          "Ignoring [Route] section from line %u.",
                                          route->section->filename, route->section->line);
 
+        /* We'd never learn when such a route goes away, see manager_ignores_foreign_route() */
+        if (!route_protocol_may_be_ours(route->protocol) &&
+            (set_contains(network->manager->ignore_foreign_route_protocols, UINT32_TO_PTR(route->protocol)) ||
+             set_contains(network->manager->ignore_foreign_route_tables, UINT32_TO_PTR(route->table))))
+                return log_warning_errno(SYNTHETIC_ERRNO(EINVAL),
+                                         "%s: Protocol= or Table= is listed in IgnoreForeignRouteProtocols= or "
+                                         "IgnoreForeignRouteTables= in networkd.conf. "
+                                         "Ignoring [Route] section from line %u.",
+                                         route->section->filename, route->section->line);
+
         return 0;
 }
 
@@ -5,6 +5,7 @@
 #include "sd-event.h"
 #include "sd-netlink.h"
 
+#include "netlink-util.h"
 #include "networkd-link-bus.h"
 #include "networkd-link.h"
 #include "networkd-manager.h"
@@ -41,11 +42,44 @@ static int process_message(Manager *manager, sd_netlink_message *message) {
         return 0;
 }
 
+static int speed_meter_reply_handler(sd_netlink *rtnl, sd_netlink_message *reply, Manager *manager) {
+        usec_t usec_now;
+        Link *link;
+        int r;
+
+        assert(manager);
+
+        manager->speed_meter_pending = false;
+
+        if (!reply)
+                return 0;
+
+        r = sd_netlink_message_get_errno(reply);
+        if (r < 0) {
+                log_warning_errno(r, "Failed to call RTM_GETLINK, ignoring: %m");
+                return 0;
+        }
+
+        r = sd_event_now(manager->event, CLOCK_MONOTONIC, &usec_now);
+        if (r < 0)
+                return r;
+
+        manager->speed_meter_usec_old = manager->speed_meter_usec_new;
+        manager->speed_meter_usec_new = usec_now;
+
+        HASHMAP_FOREACH(link, manager->links_by_index)
+                link->stats_updated = false;
+
+        for (sd_netlink_message *i = reply; i; i = sd_netlink_message_next(i))
+                (void) process_message(manager, i);
+
+        return 0;
+}
+
 static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata) {
-        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL, *reply = NULL;
+        _cleanup_(sd_netlink_message_unrefp) sd_netlink_message *req = NULL;
         Manager *manager = userdata;
         usec_t usec_now;
-        Link *link;
         int r;
 
         assert(s);
@@ -59,11 +93,10 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
         if (r < 0)
                 return r;
 
-        manager->speed_meter_usec_old = manager->speed_meter_usec_new;
-        manager->speed_meter_usec_new = usec_now;
-
-        HASHMAP_FOREACH(link, manager->links_by_index)
-                link->stats_updated = false;
+        /* With many links the dump may take a while. Do not pile up requests if the previous one has not
+         * been answered yet, and do not block the event loop while waiting for the reply. */
+        if (manager->speed_meter_pending)
+                return 0;
 
         r = sd_rtnl_message_new_link(manager->rtnl, &req, RTM_GETLINK, 0);
         if (r < 0) {
@@ -77,15 +110,13 @@ static int speed_meter_handler(sd_event_source *s, uint64_t usec, void *userdata
                 return 0;
         }
 
-        r = sd_netlink_call(manager->rtnl, req, 0, &reply);
+        r = netlink_call_async(manager->rtnl, NULL, req, speed_meter_reply_handler, NULL, manager);
         if (r < 0) {
                 log_warning_errno(r, "Failed to call RTM_GETLINK, ignoring: %m");
                 return 0;
         }
 
-        for (sd_netlink_message *i = reply; i; i = sd_netlink_message_next(i))
-                (void) process_message(manager, i);
-
+        manager->speed_meter_pending = true;
         return 0;
 }
 
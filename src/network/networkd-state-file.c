@@ -9,6 +9,7 @@
 #include "fileio.h"
 #include "fs-util.h"
 #include "network-internal.h"
+#include "networkd-json.h"
 #include "networkd-link.h"
 #include "networkd-manager-bus.h"
 #include "networkd-manager.h"
@@ -689,6 +690,8 @@ void link_dirty(Link *link) {
 
         /* The serialized state in /run is no longer up-to-date. */
 
+        manager_invalidate_json(link->manager);
+
         /* Also mark manager dirty as link is dirty */
         link->manager->dirty = true;
 
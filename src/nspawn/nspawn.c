@@ -3575,6 +3575,24 @@ static int setup_notify_child(void) {
         return TAKE_FD(fd);
 }
 
+static void log_setup_phase(const char *phase, usec_t *since) {
+        char buf[FORMAT_TIMESPAN_MAX];
+        usec_t n;
+
+        assert(phase);
+        assert(since);
+
+        /* Logs how long the container setup step that just completed took, to make it easy to see where
+         * the start-up time of a container goes. */
+
+        if (!DEBUG_LOGGING)
+                return;
+
+        n = now(CLOCK_MONOTONIC);
+        log_debug("%s took %s.", phase, format_timespan(buf, sizeof(buf), usec_sub_unsigned(n, *since), 1));
+        *since = n;
+}
+
 static int outer_child(
                 Barrier *barrier,
                 const char *directory,
@@ -3596,6 +3614,7 @@ static int outer_child(
         _cleanup_close_ int fd = -1;
         bool idmap = false;
         const char *p;
+        usec_t since;
         pid_t pid;
         ssize_t l;
         int r;
@@ -3614,6 +3633,7 @@ static int outer_child(
         assert(kmsg_socket >= 0);
 
         log_debug("Outer child is initializing.");
+        since = now(CLOCK_MONOTONIC);
 
         r = load_os_release_pairs_with_prefix("/", "container_host_", &os_release_pairs);
         if (r < 0)
@@ -3838,6 +3858,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_setup_phase("Setting up container root file system", &since);
+
         r = base_filesystem_create(directory, arg_uid_shift, (gid_t) arg_uid_shift);
         if (r < 0)
                 return r;
@@ -3873,6 +3895,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_setup_phase("Setting up API file systems and device nodes", &since);
+
         r = setup_propagate(directory);
         if (r < 0)
                 return r;
@@ -3915,6 +3939,8 @@ static int outer_child(
         if (r < 0)
                 return r;
 
+        log_setup_phase("Setting up credentials, custom mounts and host resources", &since);
+
         /* The same stuff as the $container env var, but nicely readable for the entire payload */
         p = prefix_roota(directory, "/run/host/container-manager");
         (void) write_string_file(p, arg_container_service_name, WRITE_STRING_FILE_CREATE);
@@ -3940,6 +3966,8 @@ static int outer_child(
         if (r < 0)
                 return log_error_errno(r, "Failed to move root directory: %m");
 
+        log_setup_phase("Setting up cgroups and moving root", &since);
+
         fd = setup_notify_child();
         if (fd < 0)
                 return fd;
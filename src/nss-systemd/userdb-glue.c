@@ -17,6 +17,10 @@ UserDBFlags nss_glue_userdb_flags(void) {
         if (getenv_bool_secure("SYSTEMD_NSS_DYNAMIC_BYPASS") > 0)
                 flags |= USERDB_EXCLUDE_DYNAMIC_USER;
 
+        /* Processes doing lots of lookups may opt into keeping results around for a few seconds */
+        if (getenv_bool_secure("SYSTEMD_NSS_CACHE") > 0)
+                flags |= USERDB_CACHE;
+
         return flags;
 }
 
@@ -379,17 +379,27 @@ static int monitor_swap_contexts_handler(sd_event_source *s, uint64_t usec, void
         return 0;
 }
 
-static void clear_candidate_hashmapp(Manager **m) {
-        if (*m)
-                hashmap_clear((*m)->monitored_mem_pressure_cgroup_contexts_candidates);
+static int update_mem_pressure_candidates(Manager *m, usec_t usec_now) {
+        int r;
+
+        assert(m);
+
+        /* The candidates are kept across ticks, their pgscan values are the baseline for the pgscan rate of
+         * the next update */
+        r = update_monitored_cgroup_contexts_candidates(
+                        m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
+        if (r == -ENOMEM)
+                return log_oom();
+        if (r < 0)
+                return log_debug_errno(r, "Failed to update monitored memory pressure candidate cgroup contexts, ignoring: %m");
+
+        m->mem_pressure_candidates_updated = usec_now;
+        return 0;
 }
 
 static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t usec, void *userdata) {
-        /* Don't want to use stale candidate data. Setting this will clear the candidate hashmap on return unless we
-         * update the candidate data (in which case clear_candidates will be NULL). */
-        _cleanup_(clear_candidate_hashmapp) Manager *clear_candidates = userdata;
         _cleanup_set_free_ Set *targets = NULL;
-        bool in_post_action_delay = false;
+        bool in_post_action_delay = false, refresh_candidates;
         Manager *m = userdata;
         usec_t usec_now;
         int r;
@@ -424,13 +434,6 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
         if (r < 0)
                 log_debug_errno(r, "Failed to update monitored memory pressure cgroup contexts, ignoring: %m");
 
-        r = update_monitored_cgroup_contexts_candidates(
-                        m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
-        if (r == -ENOMEM)
-                return log_oom();
-        if (r < 0)
-                log_debug_errno(r, "Failed to update monitored memory pressure candidate cgroup contexts, ignoring: %m");
-
         /* Since pressure counters are lagging, we need to wait a bit after a kill to ensure we don't read stale
          * values and go on a kill storm. */
         if (m->mem_pressure_post_action_delay_start > 0) {
@@ -467,14 +470,9 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                                   m->default_mem_pressure_duration_usec,
                                                   USEC_PER_SEC));
 
-                        r = update_monitored_cgroup_contexts_candidates(
-                                        m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
+                        r = update_mem_pressure_candidates(m, usec_now);
                         if (r == -ENOMEM)
-                                return log_oom();
-                        if (r < 0)
-                                log_debug_errno(r, "Failed to update monitored memory pressure candidate cgroup contexts, ignoring: %m");
-                        else
-                                clear_candidates = NULL;
+                                return r;
 
                         r = oomd_kill_by_pgscan_rate(m->monitored_mem_pressure_cgroup_contexts_candidates, t->path, m->dry_run, &selected);
                         if (r == -ENOMEM)
@@ -496,28 +494,32 @@ static int monitor_memory_pressure_contexts_handler(sd_event_source *s, uint64_t
                                 return 0;
                         }
                 }
-        } else {
-                /* If any monitored cgroup is over their pressure limit, get all the kill candidates for every
-                 * monitored cgroup. This saves CPU cycles from doing it every interval by only doing it when a kill
-                 * might happen.
-                 * Candidate cgroup data will continue to get updated during the post-action delay period in case
-                 * pressure continues to be high after a kill. */
+        }
+
+        /* If any monitored cgroup is over their pressure limit, get all the kill candidates for every monitored
+         * cgroup on every tick, so that the pgscan rates at kill time are taken over a single interval. This
+         * saves CPU cycles from doing it every interval by only doing it when a kill might happen. Otherwise
+         * only refresh them occasionally, to keep the pgscan baseline recent.
+         * Candidate cgroup data will continue to get updated during the post-action delay period in case
+         * pressure continues to be high after a kill. */
+        if (m->mem_pressure_candidates_updated == usec_now) /* Already done above */
+                return 0;
+
+        refresh_candidates = usec_now >= usec_add(m->mem_pressure_candidates_updated, MEM_PRESSURE_CANDIDATES_REFRESH_USEC);
+        if (!refresh_candidates) {
                 OomdCGroupContext *c;
-                HASHMAP_FOREACH(c, m->monitored_mem_pressure_cgroup_contexts) {
-                        if (c->mem_pressure_limit_hit_start == 0)
-                                continue;
 
-                        r = update_monitored_cgroup_contexts_candidates(
-                                        m->monitored_mem_pressure_cgroup_contexts, &m->monitored_mem_pressure_cgroup_contexts_candidates);
-                        if (r == -ENOMEM)
-                                return log_oom();
-                        if (r < 0)
-                                log_debug_errno(r, "Failed to update monitored memory pressure candidate cgroup contexts, ignoring: %m");
-                        else {
-                                clear_candidates = NULL;
+                HASHMAP_FOREACH(c, m->monitored_mem_pressure_cgroup_contexts)
+                        if (c->mem_pressure_limit_hit_start > 0) {
+                                refresh_candidates = true;
                                 break;
                         }
-                }
+        }
+
+        if (refresh_candidates) {
+                r = update_mem_pressure_candidates(m, usec_now);
+                if (r == -ENOMEM)
+                        return r;
         }
 
         return 0;
@@ -25,6 +25,10 @@
 #define RECLAIM_DURATION_USEC (30 * USEC_PER_SEC)
 #define POST_ACTION_DELAY_USEC (15 * USEC_PER_SEC)
 
+/* Walking all candidate cgroups is expensive, so only do it every tick while a kill might be coming up.
+ * Otherwise refresh them at this interval, so that the pgscan baseline is never older than this. */
+#define MEM_PRESSURE_CANDIDATES_REFRESH_USEC (10 * USEC_PER_SEC)
+
 typedef struct Manager Manager;
 
 struct Manager {
@@ -47,6 +51,7 @@ struct Manager {
         OomdSystemContext system_context;
 
         usec_t mem_pressure_post_action_delay_start;
+        usec_t mem_pressure_candidates_updated;
 
         sd_event_source *swap_context_event_source;
         sd_event_source *mem_pressure_context_event_source;
@@ -142,7 +142,14 @@ bool oomd_swap_free_below(const OomdSystemContext *ctx, int threshold_permyriad)
         return (ctx->swap_total - ctx->swap_used) < swap_threshold;
 }
 
-int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const char *prefix, OomdCGroupContext ***ret) {
+static int sort_cgroup_contexts(
+                Hashmap *h,
+                oomd_compare_t compare_func,
+                const char *prefix,
+                bool (*useful)(const OomdCGroupContext *ctx, uint64_t threshold),
+                uint64_t threshold,
+                OomdCGroupContext ***ret) {
+
         _cleanup_free_ OomdCGroupContext **sorted = NULL;
         OomdCGroupContext *item;
         size_t k = 0;
@@ -160,6 +167,11 @@ int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const cha
                 if ((item->path && prefix && !path_startswith(item->path, prefix)) || item->preference == MANAGED_OOM_PREFERENCE_OMIT)
                         continue;
 
+                /* Also skip the ones that would not be killed anyway, so that only those need to be sorted. With
+                 * deep hierarchies most candidates are idle leaves. */
+                if (useful && !useful(item, threshold))
+                        continue;
+
                 sorted[k++] = item;
         }
 
@@ -171,6 +183,19 @@ int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const cha
         return (int) k;
 }
 
+int oomd_sort_cgroup_contexts(Hashmap *h, oomd_compare_t compare_func, const char *prefix, OomdCGroupContext ***ret) {
+        return sort_cgroup_contexts(h, compare_func, prefix, NULL, 0, ret);
+}
+
+static bool pgscan_kill_useful(const OomdCGroupContext *ctx, uint64_t threshold) {
+        /* Cgroups with no reclaim and memory usage won't alleviate pressure. */
+        return ctx->pgscan > 0 || ctx->current_memory_usage > 0;
+}
+
+static bool swap_kill_useful(const OomdCGroupContext *ctx, uint64_t threshold) {
+        return ctx->swap_usage > threshold;
+}
+
 int oomd_cgroup_kill(const char *path, bool recurse, bool dry_run) {
         _cleanup_set_free_ Set *pids_killed = NULL;
         int r;
@@ -213,16 +238,11 @@ int oomd_kill_by_pgscan_rate(Hashmap *h, const char *prefix, bool dry_run, char
         assert(h);
         assert(ret_selected);
 
-        n = oomd_sort_cgroup_contexts(h, compare_pgscan_rate_and_memory_usage, prefix, &sorted);
+        n = sort_cgroup_contexts(h, compare_pgscan_rate_and_memory_usage, prefix, pgscan_kill_useful, 0, &sorted);
         if (n < 0)
                 return n;
 
         for (int i = 0; i < n; i++) {
-                /* Skip cgroups with no reclaim and memory usage; it won't alleviate pressure.
-                 * Continue since there might be "avoid" cgroups at the end. */
-                if (sorted[i]->pgscan == 0 && sorted[i]->current_memory_usage == 0)
-                        continue;
-
                 r = oomd_cgroup_kill(sorted[i]->path, true, dry_run);
                 if (r == 0)
                         continue; /* We didn't find anything to kill */
@@ -251,18 +271,13 @@ int oomd_kill_by_swap_usage(Hashmap *h, uint64_t threshold_usage, bool dry_run,
         assert(h);
         assert(ret_selected);
 
-        n = oomd_sort_cgroup_contexts(h, compare_swap_usage, NULL, &sorted);
+        /* Only cgroups with more than threshold swap usage are considered. */
+        n = sort_cgroup_contexts(h, compare_swap_usage, NULL, swap_kill_useful, threshold_usage, &sorted);
         if (n < 0)
                 return n;
 
-        /* Try to kill cgroups with non-zero swap usage until we either succeed in killing or we get to a cgroup with
-         * no swap usage. Threshold killing only cgroups with more than threshold swap usage. */
+        /* Try to kill cgroups in order until we succeed in killing. */
         for (int i = 0; i < n; i++) {
-                /* Skip over cgroups with not enough swap usage. Don't break since there might be "avoid"
-                 * cgroups at the end. */
-                if (sorted[i]->swap_usage <= threshold_usage)
-                        continue;
-
                 r = oomd_cgroup_kill(sorted[i]->path, true, dry_run);
                 if (r == 0)
                         continue; /* We didn't find anything to kill */
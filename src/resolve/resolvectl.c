@@ -1047,7 +1047,7 @@ static int show_statistics(int argc, char **argv, void *userdata) {
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         _cleanup_(table_unrefp) Table *table = NULL;
         sd_bus *bus = userdata;
-        uint64_t n_current_transactions, n_total_transactions,
+        uint64_t n_current_transactions, n_total_transactions, n_coalesced_lookups,
                 cache_size, n_cache_hit, n_cache_miss,
                 n_dnssec_secure, n_dnssec_insecure, n_dnssec_bogus, n_dnssec_indeterminate;
         int r, dnssec_supported;
@@ -1075,6 +1075,10 @@ static int show_statistics(int argc, char **argv, void *userdata) {
 
         reply = sd_bus_message_unref(reply);
 
+        r = bus_get_property_trivial(bus, bus_resolve_mgr, "CoalescedLookups", &error, 't', &n_coalesced_lookups);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get coalesced lookup count: %s", bus_error_message(&error, r));
+
         r = bus_get_property(bus, bus_resolve_mgr, "CacheStatistics", &error, &reply, "(ttt)");
         if (r < 0)
                 return log_error_errno(r, "Failed to get cache statistics: %s", bus_error_message(&error, r));
@@ -1115,6 +1119,8 @@ static int show_statistics(int argc, char **argv, void *userdata) {
                            TABLE_UINT64, n_current_transactions,
                            TABLE_STRING, "Total Transactions:",
                            TABLE_UINT64, n_total_transactions,
+                           TABLE_STRING, "Coalesced Lookups:",
+                           TABLE_UINT64, n_coalesced_lookups,
                            TABLE_EMPTY, TABLE_EMPTY,
                            TABLE_STRING, "Cache",
                            TABLE_SET_COLOR, ansi_highlight(),
@@ -1700,9 +1700,10 @@ static int bus_method_reset_statistics(sd_bus_message *message, void *userdata,
         bus_client_log(message, "statistics reset");
 
         LIST_FOREACH(scopes, s, m->dns_scopes)
-                s->cache.n_hit = s->cache.n_miss = 0;
+                s->cache.n_hit = s->cache.n_miss = s->cache.n_evicted = 0;
 
         m->n_transactions_total = 0;
+        m->n_lookups_coalesced = 0;
         zero(m->n_dnssec_verdict);
 
         return sd_bus_reply_method_return(message, NULL);
@@ -2067,6 +2068,7 @@ static const sd_bus_vtable resolve_vtable[] = {
         SD_BUS_PROPERTY("CurrentDNSServerEx", "(iiayqs)", bus_property_get_current_dns_server_ex, offsetof(Manager, current_dns_server), SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
         SD_BUS_PROPERTY("Domains", "a(isb)", bus_property_get_domains, 0, 0),
         SD_BUS_PROPERTY("TransactionStatistics", "(tt)", bus_property_get_transaction_statistics, 0, 0),
+        SD_BUS_PROPERTY("CoalescedLookups", "t", NULL, offsetof(Manager, n_lookups_coalesced), 0),
         SD_BUS_PROPERTY("CacheStatistics", "(ttt)", bus_property_get_cache_statistics, 0, 0),
         SD_BUS_PROPERTY("DNSSEC", "s", bus_property_get_dnssec_mode, 0, 0),
         SD_BUS_PROPERTY("DNSSECStatistics", "(tttt)", bus_property_get_dnssec_statistics, 0, 0),
@@ -498,6 +498,11 @@ int manager_parse_config_file(Manager *m) {
                         return r;
         }
 
+        if (m->cache_size <= 0) {
+                log_warning("CacheSize= must be larger than zero, using the default of %u.", DNS_CACHE_MAX_DEFAULT);
+                m->cache_size = DNS_CACHE_MAX_DEFAULT;
+        }
+
 #if ! HAVE_GCRYPT
         if (m->dnssec_mode != DNSSEC_NO) {
                 log_warning("DNSSEC option cannot be enabled or set to allow-downgrade when systemd-resolved is built without gcrypt support. Turning off DNSSEC support.");
@@ -11,10 +11,6 @@
 #include "resolved-dns-packet.h"
 #include "string-util.h"
 
-/* Never cache more than 4K entries. RFC 1536, Section 5 suggests to
- * leave DNS caches unbounded, but that's crazy. */
-#define CACHE_MAX 4096
-
 /* We never keep any item longer than 2h in our cache */
 #define CACHE_TTL_MAX_USEC (2 * USEC_PER_HOUR)
 
@@ -24,6 +20,11 @@
 
 #define CACHEABLE_QUERY_FLAGS (SD_RESOLVED_AUTHENTICATED|SD_RESOLVED_CONFIDENTIAL)
 
+/* Positive entries which were looked up at least this often are refreshed once less than 1/10 of their
+ * lifetime is left, so that the popular ones don't drop out of the cache */
+#define CACHE_PREFETCH_HITS_MIN 3U
+#define CACHE_PREFETCH_LIFETIME_DIVISOR 10U
+
 typedef enum DnsCacheItemType DnsCacheItemType;
 typedef struct DnsCacheItem DnsCacheItem;
 
@@ -42,7 +43,9 @@ struct DnsCacheItem {
         DnsAnswer *answer;       /* The full validated answer, if this is an RRset acquired via a "primary" lookup */
         DnsPacket *full_packet;  /* The full packet this information was acquired with */
 
+        usec_t added;
         usec_t until;
+        unsigned n_hit;          /* Number of lookups since the item was added */
         uint64_t query_flags;    /* SD_RESOLVED_AUTHENTICATED and/or SD_RESOLVED_CONFIDENTIAL */
         DnssecResult dnssec_result;
 
@@ -52,10 +55,26 @@ struct DnsCacheItem {
 
         unsigned prioq_idx;
         LIST_FIELDS(DnsCacheItem, by_key);
+        LIST_FIELDS(DnsCacheItem, by_use);
 
         bool shared_owner;
 };
 
+/* Each entry of a saved cache (see dns_cache_save()) starts with this header, followed by one
+ * DnsCacheSavedRR for each RR, and the DNS packet holding the key as question, and the RRs. */
+typedef struct _packed_ DnsCacheSavedEntry {
+        uint64_t until; /* CLOCK_REALTIME */
+        uint64_t query_flags;
+        int32_t dnssec_result;
+        uint32_t n_rrs;
+        uint32_t size;
+} DnsCacheSavedEntry;
+
+typedef struct _packed_ DnsCacheSavedRR {
+        uint32_t flags; /* DnsAnswerFlags */
+        int32_t ifindex;
+} DnsCacheSavedRR;
+
 /* Returns true if this is a cache item created as result of an explicit lookup, or created as "side-effect"
  * of another request. "Primary" entries will carry the full answer data (with NSEC, …) that can aso prove
  * wildcard expansion, non-existance and such, while entries that were created as "side-effect" just contain
@@ -95,6 +114,26 @@ static DnsCacheItem* dns_cache_item_free(DnsCacheItem *i) {
 }
 DEFINE_TRIVIAL_CLEANUP_FUNC(DnsCacheItem*, dns_cache_item_free);
 
+static void dns_cache_item_unlink_use(DnsCache *c, DnsCacheItem *i) {
+        assert(c);
+        assert(i);
+
+        if (c->by_use_tail == i)
+                c->by_use_tail = i->by_use_prev;
+
+        LIST_REMOVE(by_use, c->by_use, i);
+}
+
+static void dns_cache_item_link_use(DnsCache *c, DnsCacheItem *i) {
+        assert(c);
+        assert(i);
+
+        LIST_PREPEND(by_use, c->by_use, i);
+
+        if (!c->by_use_tail)
+                c->by_use_tail = i;
+}
+
 static void dns_cache_item_unlink_and_free(DnsCache *c, DnsCacheItem *i) {
         DnsCacheItem *first;
 
@@ -112,6 +151,7 @@ static void dns_cache_item_unlink_and_free(DnsCache *c, DnsCacheItem *i) {
                 hashmap_remove(c->by_key, i->key);
 
         prioq_remove(c->by_expiry, i, &i->prioq_idx);
+        dns_cache_item_unlink_use(c, i);
 
         dns_cache_item_free(i);
 }
@@ -146,6 +186,7 @@ static bool dns_cache_remove_by_key(DnsCache *c, DnsResourceKey *key) {
 
         LIST_FOREACH_SAFE(by_key, i, n, first) {
                 prioq_remove(c->by_expiry, i, &i->prioq_idx);
+                dns_cache_item_unlink_use(c, i);
                 dns_cache_item_free(i);
         }
 
@@ -162,21 +203,32 @@ void dns_cache_flush(DnsCache *c) {
 
         assert(hashmap_size(c->by_key) == 0);
         assert(prioq_size(c->by_expiry) == 0);
+        assert(!c->by_use && !c->by_use_tail);
 
         c->by_key = hashmap_free(c->by_key);
         c->by_expiry = prioq_free(c->by_expiry);
 }
 
 static void dns_cache_make_space(DnsCache *c, unsigned add) {
+        unsigned max;
+        usec_t t = 0;
+
         assert(c);
 
         if (add <= 0)
                 return;
 
+        max = c->max > 0 ? c->max : DNS_CACHE_MAX_DEFAULT;
+
         /* Makes space for n new entries. Note that we actually allow
-         * the cache to grow beyond CACHE_MAX, but only when we shall
-         * add more RRs to the cache than CACHE_MAX at once. In that
-         * case the cache will be emptied completely otherwise. */
+         * the cache to grow beyond the maximum, but only when we shall
+         * add more RRs to the cache than the maximum at once. In that
+         * case the cache will be emptied completely otherwise.
+         *
+         * Entries that are past their TTL are dropped first. After that,
+         * the RRsets that have not been looked up for the longest time
+         * are evicted, rather than those which expire soonest: the latter
+         * tend to be the popular ones with short TTLs. */
 
         for (;;) {
                 _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
@@ -185,12 +237,22 @@ static void dns_cache_make_space(DnsCache *c, unsigned add) {
                 if (prioq_size(c->by_expiry) <= 0)
                         break;
 
-                if (prioq_size(c->by_expiry) + add < CACHE_MAX)
+                if (prioq_size(c->by_expiry) + add < max)
                         break;
 
                 i = prioq_peek(c->by_expiry);
                 assert(i);
 
+                if (t <= 0)
+                        t = now(clock_boottime_or_monotonic());
+
+                if (i->until > t) {
+                        i = c->by_use_tail;
+                        assert(i);
+
+                        c->n_evicted++;
+                }
+
                 /* Take an extra reference to the key so that it
                  * doesn't go away in the middle of the remove call */
                 key = dns_resource_key_ref(i->key);
@@ -297,6 +359,8 @@ static int dns_cache_link_item(DnsCache *c, DnsCacheItem *i) {
                 }
         }
 
+        dns_cache_item_link_use(c, i);
+
         return 0;
 }
 
@@ -395,6 +459,7 @@ static void dns_cache_item_update_positive(
         dns_packet_unref(i->full_packet);
         i->full_packet = full_packet;
 
+        i->added = timestamp;
         i->until = calculate_until(rr, min_ttl, UINT32_MAX, timestamp, false);
         i->query_flags = query_flags & CACHEABLE_QUERY_FLAGS;
         i->shared_owner = shared_owner;
@@ -488,6 +553,7 @@ static int dns_cache_put_positive(
                 .rr = dns_resource_record_ref(rr),
                 .answer = dns_answer_ref(answer),
                 .full_packet = dns_packet_ref(full_packet),
+                .added = timestamp,
                 .until = calculate_until(rr, min_ttl, UINT32_MAX, timestamp, false),
                 .query_flags = query_flags & CACHEABLE_QUERY_FLAGS,
                 .shared_owner = shared_owner,
@@ -1016,6 +1082,13 @@ int dns_cache_lookup(
                 goto miss;
         }
 
+        /* Mark the RRset as recently used, so that it is evicted last */
+        LIST_FOREACH(by_key, j, first) {
+                dns_cache_item_unlink_use(c, j);
+                dns_cache_item_link_use(c, j);
+                j->n_hit++;
+        }
+
         if (FLAGS_SET(query_flags, SD_RESOLVED_CLAMP_TTL)) {
                 /* 'current' is always passed to answer_add_clamp_ttl(), but is only used conditionally.
                  * We'll do the same assert there to make sure that it was initialized properly. */
@@ -1223,6 +1296,36 @@ miss:
         return 0;
 }
 
+bool dns_cache_needs_prefetch(DnsCache *c, DnsResourceKey *key) {
+        DnsCacheItem *i;
+        usec_t t = 0;
+
+        assert(c);
+        assert(key);
+
+        /* Returns true if the positive RRset for the key is looked up often, and about to expire, so that
+         * it is worth refreshing it before the next lookup misses. */
+
+        LIST_FOREACH(by_key, i, hashmap_get(c->by_key, key)) {
+                if (i->type != DNS_CACHE_POSITIVE || !DNS_CACHE_ITEM_IS_PRIMARY(i))
+                        continue;
+
+                if (i->n_hit < CACHE_PREFETCH_HITS_MIN)
+                        continue;
+
+                if (t <= 0)
+                        t = now(clock_boottime_or_monotonic());
+
+                if (i->until <= t)
+                        continue;
+
+                if (i->until - t < (i->until - i->added) / CACHE_PREFETCH_LIFETIME_DIVISOR)
+                        return true;
+        }
+
+        return false;
+}
+
 int dns_cache_check_conflicts(DnsCache *cache, DnsResourceRecord *rr, int owner_family, const union in_addr_union *owner_address) {
         DnsCacheItem *i, *first;
         bool same_owner = true;
@@ -1345,6 +1448,180 @@ void dns_cache_dump(DnsCache *cache, FILE *f) {
         }
 }
 
+int dns_cache_save(DnsCache *cache, FILE *f) {
+        DnsCacheItem *i;
+        usec_t t_boot, t_real;
+        int n = 0, r;
+
+        assert(cache);
+        assert(f);
+
+        /* Writes the RRsets that were looked up explicitly, together with their full answers, which is all
+         * that is needed to reconstruct the rest. The expiry is recorded in CLOCK_REALTIME, so that it
+         * remains valid across restarts. Signed data is skipped, since we keep the RRSIGs separately. */
+
+        t_boot = now(clock_boottime_or_monotonic());
+        t_real = now(CLOCK_REALTIME);
+
+        HASHMAP_FOREACH(i, cache->by_key) {
+                _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
+                DnsCacheSavedEntry e;
+                DnsAnswerItem *item;
+                bool signed_data = false;
+
+                if (i->type != DNS_CACHE_POSITIVE || !DNS_CACHE_ITEM_IS_PRIMARY(i) || i->shared_owner)
+                        continue;
+                if (i->until <= t_boot)
+                        continue;
+
+                DNS_ANSWER_FOREACH_ITEM(item, i->answer)
+                        if (item->rrsig) {
+                                signed_data = true;
+                                break;
+                        }
+                if (signed_data)
+                        continue;
+
+                r = dns_packet_new(&p, DNS_PROTOCOL_DNS, 0, DNS_PACKET_SIZE_MAX);
+                if (r < 0)
+                        return r;
+
+                r = dns_packet_append_key(p, i->key, 0, NULL);
+                if (r < 0)
+                        continue;
+
+                DNS_ANSWER_FOREACH_ITEM(item, i->answer) {
+                        r = dns_packet_append_rr(p, item->rr, 0, NULL, NULL);
+                        if (r < 0)
+                                break;
+                }
+                if (r < 0) /* Doesn't fit into a single packet, skip it */
+                        continue;
+
+                e = (DnsCacheSavedEntry) {
+                        .until = usec_add(t_real, i->until - t_boot),
+                        .query_flags = i->query_flags,
+                        .dnssec_result = i->dnssec_result,
+                        .n_rrs = dns_answer_size(i->answer),
+                        .size = p->size,
+                };
+
+                fwrite(&e, sizeof(e), 1, f);
+
+                DNS_ANSWER_FOREACH_ITEM(item, i->answer) {
+                        DnsCacheSavedRR s = {
+                                .flags = item->flags,
+                                .ifindex = item->ifindex,
+                        };
+
+                        fwrite(&s, sizeof(s), 1, f);
+                }
+
+                fwrite(DNS_PACKET_DATA(p), 1, p->size, f);
+                n++;
+        }
+
+        return n;
+}
+
+int dns_cache_load(DnsCache *cache, DnsCacheMode cache_mode, FILE *f) {
+        usec_t t_real;
+        int n = 0, r;
+
+        assert(cache);
+        assert(f);
+
+        /* Adds the entries written by dns_cache_save(), with their TTLs reduced by the time that passed
+         * since then. Returns the number of entries added. */
+
+        t_real = now(CLOCK_REALTIME);
+
+        for (;;) {
+                _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
+                _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL;
+                _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
+                _cleanup_free_ DnsCacheSavedRR *rrs = NULL;
+                DnsCacheSavedEntry e;
+                uint32_t left_ttl;
+                size_t k;
+
+                k = fread(&e, 1, sizeof(e), f);
+                if (k == 0 && feof(f))
+                        break;
+                if (k != sizeof(e))
+                        return -EBADMSG;
+
+                if (e.n_rrs == 0 || e.n_rrs > UINT16_MAX ||
+                    e.size < DNS_PACKET_HEADER_SIZE || e.size > DNS_PACKET_SIZE_MAX)
+                        return -EBADMSG;
+
+                rrs = new(DnsCacheSavedRR, e.n_rrs);
+                if (!rrs)
+                        return -ENOMEM;
+
+                if (fread(rrs, sizeof(DnsCacheSavedRR), e.n_rrs, f) != e.n_rrs)
+                        return -EBADMSG;
+
+                r = dns_packet_new(&p, DNS_PROTOCOL_DNS, e.size, DNS_PACKET_SIZE_MAX);
+                if (r < 0)
+                        return r;
+
+                if (fread(DNS_PACKET_DATA(p), 1, e.size, f) != e.size)
+                        return -EBADMSG;
+
+                p->size = e.size;
+                dns_packet_rewind(p, DNS_PACKET_HEADER_SIZE);
+
+                /* Expired in the meantime? */
+                if (e.until <= t_real + USEC_PER_SEC)
+                        continue;
+
+                left_ttl = (uint32_t) MIN((e.until - t_real) / USEC_PER_SEC, (usec_t) UINT32_MAX);
+
+                r = dns_packet_read_key(p, &key, NULL, NULL);
+                if (r < 0)
+                        return r;
+
+                answer = dns_answer_new(e.n_rrs);
+                if (!answer)
+                        return -ENOMEM;
+
+                for (uint32_t j = 0; j < e.n_rrs; j++) {
+                        _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+
+                        r = dns_packet_read_rr(p, &rr, NULL, NULL);
+                        if (r < 0)
+                                return r;
+
+                        r = dns_resource_record_clamp_ttl(&rr, left_ttl);
+                        if (r < 0)
+                                return r;
+
+                        r = dns_answer_add(answer, rr, rrs[j].ifindex, rrs[j].flags, NULL);
+                        if (r < 0)
+                                return r;
+                }
+
+                r = dns_cache_put(cache,
+                                  cache_mode,
+                                  key,
+                                  DNS_RCODE_SUCCESS,
+                                  answer,
+                                  NULL,
+                                  e.query_flags,
+                                  e.dnssec_result,
+                                  UINT32_MAX,
+                                  AF_UNSPEC,
+                                  &IN_ADDR_NULL);
+                if (r < 0)
+                        return r;
+
+                n++;
+        }
+
+        return n;
+}
+
 bool dns_cache_is_empty(DnsCache *cache) {
         if (!cache)
                 return true;
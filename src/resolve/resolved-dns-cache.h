@@ -8,11 +8,20 @@
 #include "resolved-dns-dnssec.h"
 #include "time-util.h"
 
+/* Never cache more than 4K entries by default. RFC 1536, Section 5 suggests to leave DNS caches unbounded,
+ * but that's crazy. */
+#define DNS_CACHE_MAX_DEFAULT 4096U
+
 typedef struct DnsCache {
         Hashmap *by_key;
         Prioq *by_expiry;
+        /* All items, the most recently used one first */
+        struct DnsCacheItem *by_use;
+        struct DnsCacheItem *by_use_tail;
+        unsigned max; /* 0 means DNS_CACHE_MAX_DEFAULT */
         unsigned n_hit;
         unsigned n_miss;
+        unsigned n_evicted;
 } DnsCache;
 
 #include "resolved-dns-answer.h"
@@ -46,9 +55,13 @@ int dns_cache_lookup(
                 uint64_t *ret_query_flags,
                 DnssecResult *ret_dnssec_result);
 
+bool dns_cache_needs_prefetch(DnsCache *c, DnsResourceKey *key);
+
 int dns_cache_check_conflicts(DnsCache *cache, DnsResourceRecord *rr, int owner_family, const union in_addr_union *owner_address);
 
 void dns_cache_dump(DnsCache *cache, FILE *f);
+int dns_cache_save(DnsCache *cache, FILE *f);
+int dns_cache_load(DnsCache *cache, DnsCacheMode cache_mode, FILE *f);
 bool dns_cache_is_empty(DnsCache *cache);
 
 unsigned dns_cache_size(DnsCache *cache);
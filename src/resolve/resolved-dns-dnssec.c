@@ -60,6 +60,12 @@ uint16_t dnssec_keytag(DnsResourceRecord *dnskey, bool mask_revoke) {
 
 #if HAVE_GCRYPT
 
+/* SHA-256 fingerprints of recently successfully verified signatures, in a small direct-mapped table
+ * indexed by the first byte of the fingerprint. The same RRsets tend to be validated over and over again
+ * as they are refetched, and verifying a signature is by far the most expensive part of that. */
+#define VERIFIED_FINGERPRINT_SIZE 32U
+static uint8_t verified_cache[UINT8_MAX + 1][VERIFIED_FINGERPRINT_SIZE];
+
 static int rr_compare(DnsResourceRecord * const *a, DnsResourceRecord * const *b) {
         const DnsResourceRecord *x = *a, *y = *b;
         size_t m;
@@ -598,6 +604,48 @@ static int algorithm_to_gcrypt_md(uint8_t algorithm) {
         }
 }
 
+static int dnssec_verified_fingerprint(
+                const void *sig_data,
+                size_t sig_size,
+                DnsResourceRecord *rrsig,
+                DnsResourceRecord *dnskey,
+                uint8_t ret[static VERIFIED_FINGERPRINT_SIZE]) {
+
+        _cleanup_(gcry_md_closep) gcry_md_hd_t md = NULL;
+        gcry_error_t err;
+        void *digest;
+
+        assert(sig_data);
+        assert(rrsig);
+        assert(dnskey);
+
+        /* Identifies a specific signature check: the signed data, the signature and the key. The sizes
+         * are included so that the concatenation is unambiguous. */
+
+        initialize_libgcrypt(false);
+
+        err = gcry_md_open(&md, GCRY_MD_SHA256, 0);
+        if (gcry_err_code(err) != GPG_ERR_NO_ERROR || !md)
+                return -EIO;
+
+        gcry_md_write(md, &sig_size, sizeof(sig_size));
+        gcry_md_write(md, sig_data, sig_size);
+        gcry_md_write(md, &rrsig->rrsig.signature_size, sizeof(rrsig->rrsig.signature_size));
+        gcry_md_write(md, rrsig->rrsig.signature, rrsig->rrsig.signature_size);
+        md_add_uint16(md, dnskey->dnskey.flags);
+        md_add_uint8(md, dnskey->dnskey.protocol);
+        md_add_uint8(md, dnskey->dnskey.algorithm);
+        gcry_md_write(md, &dnskey->dnskey.key_size, sizeof(dnskey->dnskey.key_size));
+        gcry_md_write(md, dnskey->dnskey.key, dnskey->dnskey.key_size);
+
+        digest = gcry_md_read(md, 0);
+        if (!digest)
+                return -EIO;
+
+        memcpy(ret, digest, VERIFIED_FINGERPRINT_SIZE);
+        return 0;
+}
+
 static void dnssec_fix_rrset_ttl(
                 DnsResourceRecord *list[],
                 unsigned n,
@@ -642,6 +690,7 @@ int dnssec_verify_rrset(
         size_t sig_size = 0;
         _cleanup_free_ char *sig_data = NULL;
         _cleanup_fclose_ FILE *f = NULL;
+        uint8_t fingerprint[VERIFIED_FINGERPRINT_SIZE];
         size_t hash_size;
         void *hash;
         bool wildcard;
@@ -832,40 +881,54 @@ int dnssec_verify_rrset(
         }
         }
 
-        switch (rrsig->rrsig.algorithm) {
+        /* Skip the expensive public key operation if we already verified this exact signature over this
+         * exact data with this exact key before. Everything else (expiry, wildcard, TTL) is still checked
+         * above and below, as that depends on the time and the question. */
+        r = dnssec_verified_fingerprint(sig_data, sig_size, rrsig, dnskey, fingerprint);
+        if (r < 0)
+                return r;
 
-        case DNSSEC_ALGORITHM_RSASHA1:
-        case DNSSEC_ALGORITHM_RSASHA1_NSEC3_SHA1:
-        case DNSSEC_ALGORITHM_RSASHA256:
-        case DNSSEC_ALGORITHM_RSASHA512:
-                r = dnssec_rsa_verify(
-                                gcry_md_algo_name(md_algorithm),
-                                hash, hash_size,
-                                rrsig,
-                                dnskey);
-                break;
+        if (memcmp(verified_cache[fingerprint[0]], fingerprint, sizeof(fingerprint)) == 0)
+                r = 1;
+        else {
+                switch (rrsig->rrsig.algorithm) {
+
+                case DNSSEC_ALGORITHM_RSASHA1:
+                case DNSSEC_ALGORITHM_RSASHA1_NSEC3_SHA1:
+                case DNSSEC_ALGORITHM_RSASHA256:
+                case DNSSEC_ALGORITHM_RSASHA512:
+                        r = dnssec_rsa_verify(
+                                        gcry_md_algo_name(md_algorithm),
+                                        hash, hash_size,
+                                        rrsig,
+                                        dnskey);
+                        break;
 
-        case DNSSEC_ALGORITHM_ECDSAP256SHA256:
-        case DNSSEC_ALGORITHM_ECDSAP384SHA384:
-                r = dnssec_ecdsa_verify(
-                                gcry_md_algo_name(md_algorithm),
-                                rrsig->rrsig.algorithm,
-                                hash, hash_size,
-                                rrsig,
-                                dnskey);
-                break;
+                case DNSSEC_ALGORITHM_ECDSAP256SHA256:
+                case DNSSEC_ALGORITHM_ECDSAP384SHA384:
+                        r = dnssec_ecdsa_verify(
+                                        gcry_md_algo_name(md_algorithm),
+                                        rrsig->rrsig.algorithm,
+                                        hash, hash_size,
+                                        rrsig,
+                                        dnskey);
+                        break;
 #if GCRYPT_VERSION_NUMBER >= 0x010600
-        case DNSSEC_ALGORITHM_ED25519:
-                r = dnssec_eddsa_verify(
-                                rrsig->rrsig.algorithm,
-                                sig_data, sig_size,
-                                rrsig,
-                                dnskey);
-                break;
+                case DNSSEC_ALGORITHM_ED25519:
+                        r = dnssec_eddsa_verify(
+                                        rrsig->rrsig.algorithm,
+                                        sig_data, sig_size,
+                                        rrsig,
+                                        dnskey);
+                        break;
 #endif
+                }
+                if (r < 0)
+                        return r;
+
+                if (r > 0)
+                        memcpy(verified_cache[fingerprint[0]], fingerprint, sizeof(fingerprint));
         }
-        if (r < 0)
-                return r;
 
         /* Now, fix the ttl, expiry, and remember the synthesizing source and the signer */
         if (r > 0)
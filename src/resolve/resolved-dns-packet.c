@@ -723,11 +723,12 @@ int dns_packet_append_opt(
                 uint16_t max_udp_size,
                 bool edns0_do,
                 bool include_rfc6975,
+                bool tcp_keepalive,
                 const char *nsid,
                 int rcode,
                 size_t *ret_start) {
 
-        size_t saved_size;
+        size_t saved_size, keepalive_size;
         int r;
 
         assert(p);
@@ -743,6 +744,9 @@ int dns_packet_append_opt(
 
         saved_size = p->size;
 
+        /* An empty edns-tcp-keepalive option, see RFC7828. Only to be used on queries sent via TCP. */
+        keepalive_size = tcp_keepalive ? 4 : 0;
+
         /* empty name */
         r = dns_packet_append_uint8(p, 0, NULL);
         if (r < 0)
@@ -802,7 +806,7 @@ int dns_packet_append_opt(
                         NSEC3_ALGORITHM_SHA1,
                 };
 
-                r = dns_packet_append_uint16(p, sizeof(rfc6975), NULL); /* RDLENGTH */
+                r = dns_packet_append_uint16(p, sizeof(rfc6975) + keepalive_size, NULL); /* RDLENGTH */
                 if (r < 0)
                         goto fail;
 
@@ -815,7 +819,7 @@ int dns_packet_append_opt(
                         goto fail;
                 }
 
-                r = dns_packet_append_uint16(p, 4 + strlen(nsid), NULL); /* RDLENGTH */
+                r = dns_packet_append_uint16(p, 4 + strlen(nsid) + keepalive_size, NULL); /* RDLENGTH */
                 if (r < 0)
                         goto fail;
 
@@ -829,10 +833,20 @@ int dns_packet_append_opt(
 
                 r = dns_packet_append_blob(p, nsid, strlen(nsid), NULL);
         } else
-                r = dns_packet_append_uint16(p, 0, NULL);
+                r = dns_packet_append_uint16(p, keepalive_size, NULL); /* RDLENGTH */
         if (r < 0)
                 goto fail;
 
+        if (tcp_keepalive) {
+                r = dns_packet_append_uint16(p, 11, NULL); /* OPTION-CODE: edns-tcp-keepalive */
+                if (r < 0)
+                        goto fail;
+
+                r = dns_packet_append_uint16(p, 0, NULL); /* OPTION-LENGTH */
+                if (r < 0)
+                        goto fail;
+        }
+
         DNS_PACKET_HEADER(p)->arcount = htobe16(DNS_PACKET_ARCOUNT(p) + 1);
 
         p->opt_start = saved_size;
@@ -1475,6 +1489,9 @@ int dns_packet_read_name(
                         if (r < 0)
                                 return r;
 
+                        if (!ret)
+                                continue; /* Just skipping over the name, no need to decode it */
+
                         if (!GREEDY_REALLOC(name, n + !first + DNS_LABEL_ESCAPED_MAX))
                                 return -ENOMEM;
 
@@ -1511,10 +1528,12 @@ int dns_packet_read_name(
                         return -EBADMSG;
         }
 
-        if (!GREEDY_REALLOC(name, n + 1))
-                return -ENOMEM;
+        if (ret) {
+                if (!GREEDY_REALLOC(name, n + 1))
+                        return -ENOMEM;
 
-        name[n] = 0;
+                name[n] = 0;
+        }
 
         if (after_rindex != 0)
                 p->rindex= after_rindex;
@@ -1640,7 +1659,7 @@ int dns_packet_read_key(
         assert(p);
         INIT_REWINDER(rewinder, p);
 
-        r = dns_packet_read_name(p, &name, true, NULL);
+        r = dns_packet_read_name(p, ret ? &name : NULL, true, NULL);
         if (r < 0)
                 return r;
 
@@ -2620,6 +2639,50 @@ int dns_packet_has_nsid_request(DnsPacket *p) {
         return has_nsid;
 }
 
+int dns_packet_get_tcp_keepalive(DnsPacket *p, usec_t *ret) {
+        const uint8_t *d;
+        size_t l;
+
+        assert(p);
+        assert(ret);
+
+        if (!p->opt)
+                return 0;
+
+        d = p->opt->opt.data;
+        l = p->opt->opt.data_size;
+
+        while (l > 0) {
+                uint16_t code, length;
+
+                if (l < 4U)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "EDNS0 variable part has invalid size.");
+
+                code = unaligned_read_be16(d);
+                length = unaligned_read_be16(d + 2);
+
+                if (l < 4U + length)
+                        return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                               "Truncated option in EDNS0 variable part.");
+
+                if (code == 11) {
+                        if (length != 2)
+                                return log_debug_errno(SYNTHETIC_ERRNO(EBADMSG),
+                                                       "edns-tcp-keepalive option in DNS reply has invalid size.");
+
+                        /* The timeout is specified in units of 100ms */
+                        *ret = unaligned_read_be16(d + 4) * (100 * USEC_PER_MSEC);
+                        return 1;
+                }
+
+                d += 4U + length;
+                l -= 4U + length;
+        }
+
+        return 0;
+}
+
 size_t dns_packet_size_unfragmented(DnsPacket *p) {
         assert(p);
 
@@ -135,8 +135,13 @@ static int dns_query_candidate_add_transaction(
                         r = dns_transaction_new(&t, c->scope, key, NULL, c->query->flags);
                         if (r < 0)
                                 return r;
-                } else if (set_contains(c->transactions, t))
-                        return 0;
+                } else {
+                        if (set_contains(c->transactions, t))
+                                return 0;
+
+                        /* Somebody else already asked the same question, let's just wait for the answer too */
+                        c->scope->manager->n_lookups_coalesced++;
+                }
         } else {
                 /* "Bypass" lookup with a query packet */
                 assert(bypass);
@@ -41,6 +41,7 @@ int dns_scope_new(Manager *m, DnsScope **ret, Link *l, DnsProtocol protocol, int
                 .protocol = protocol,
                 .family = family,
                 .resend_timeout = MULTICAST_RESEND_TIMEOUT_MIN_USEC,
+                .cache.max = m->cache_size,
         };
 
         if (protocol == DNS_PROTOCOL_DNS) {
@@ -1088,6 +1089,11 @@ DnsTransaction *dns_scope_find_transaction(
                     !(t->query_flags & SD_RESOLVED_NO_CACHE))
                         continue;
 
+                /* Prefetches refresh the cache in the background, queries which may use the cache
+                 * shouldn't wait for them */
+                if (t->prefetch && !(query_flags & SD_RESOLVED_NO_CACHE))
+                        continue;
+
                 /* If we are asked to clamp ttls an the existing transaction doesn't do it, we can't
                  * reuse */
                 if ((query_flags & SD_RESOLVED_CLAMP_TTL) &&
@@ -1310,7 +1316,8 @@ void dns_scope_dump(DnsScope *s, FILE *f) {
         }
 
         if (!dns_cache_is_empty(&s->cache)) {
-                fputs("CACHE:\n", f);
+                fprintf(f, "CACHE (hits: %u, misses: %u, evicted: %u):\n",
+                        s->cache.n_hit, s->cache.n_miss, s->cache.n_evicted);
                 dns_cache_dump(&s->cache, f);
         }
 }
@@ -597,7 +597,7 @@ DnsServerFeatureLevel dns_server_possible_feature_level(DnsServer *s) {
         return s->possible_feature_level;
 }
 
-int dns_server_adjust_opt(DnsServer *server, DnsPacket *packet, DnsServerFeatureLevel level) {
+int dns_server_adjust_opt(DnsServer *server, DnsPacket *packet, DnsServerFeatureLevel level, bool stream) {
         size_t packet_size;
         bool edns_do;
         int r;
@@ -659,7 +659,10 @@ int dns_server_adjust_opt(DnsServer *server, DnsPacket *packet, DnsServerFeature
 
         log_debug("Announcing packet size %zu in egress EDNS(0) packet.", packet_size);
 
-        return dns_packet_append_opt(packet, packet_size, edns_do, /* include_rfc6975 = */ true, NULL, 0, NULL);
+        /* When talking via TCP or TLS, ask the server how long it is willing to keep the connection open, so
+         * that we can keep reusing it for subsequent lookups instead of reconnecting (and redoing the TLS
+         * handshake) each time. */
+        return dns_packet_append_opt(packet, packet_size, edns_do, /* include_rfc6975 = */ true, /* tcp_keepalive = */ stream, NULL, 0, NULL);
 }
 
 int dns_server_ifindex(const DnsServer *s) {
@@ -876,9 +879,14 @@ DnsServer *manager_set_dns_server(Manager *m, DnsServer *s) {
         dns_server_unref(m->current_dns_server);
         m->current_dns_server = dns_server_ref(s);
 
-        if (m->unicast_scope)
+        if (m->unicast_scope) {
                 dns_cache_flush(&m->unicast_scope->cache);
 
+                /* The first time a server is picked, this picks up the cache of our previous instance */
+                if (s)
+                        manager_restore_cache(m);
+        }
+
         (void) manager_send_changed(m, "CurrentDNSServer");
 
         return s;
@@ -11,6 +11,7 @@
 #include "resolved-manager.h"
 
 #define DNS_STREAM_TIMEOUT_USEC (10 * USEC_PER_SEC)
+#define DNS_STREAM_KEEPALIVE_MAX_USEC (2 * USEC_PER_MINUTE)
 #define DNS_STREAMS_MAX 128
 
 #define DNS_QUERIES_PER_STREAM 32
@@ -437,7 +438,7 @@ static int on_stream_io(sd_event_source *es, int fd, uint32_t revents, void *use
 
         /* If we did something, let's restart the timeout event source */
         if (progressed && s->timeout_event_source) {
-                r = sd_event_source_set_time_relative(s->timeout_event_source, DNS_STREAM_TIMEOUT_USEC);
+                r = sd_event_source_set_time_relative(s->timeout_event_source, s->timeout_usec);
                 if (r < 0)
                         log_warning_errno(errno, "Couldn't restart TCP connection timeout, ignoring: %m");
         }
@@ -507,6 +508,7 @@ int dns_stream_new(
                 .fd = -1,
                 .protocol = protocol,
                 .type = type,
+                .timeout_usec = DNS_STREAM_TIMEOUT_USEC,
         };
 
         r = ordered_set_ensure_allocated(&s->write_queue, &dns_packet_hash_ops);
@@ -523,7 +525,7 @@ int dns_stream_new(
                         m->event,
                         &s->timeout_event_source,
                         clock_boottime_or_monotonic(),
-                        DNS_STREAM_TIMEOUT_USEC, 0,
+                        s->timeout_usec, 0,
                         on_stream_timeout, s);
         if (r < 0)
                 return r;
@@ -577,6 +579,16 @@ DnsPacket *dns_stream_take_read_packet(DnsStream *s) {
         return TAKE_PTR(s->read_packet);
 }
 
+void dns_stream_set_keepalive(DnsStream *s, usec_t keepalive) {
+        assert(s);
+
+        /* Called with the idle timeout the peer advertised via edns-tcp-keepalive (RFC 7828). We never go
+         * below our own default, so that outstanding lookups are not cut short, and never keep idle
+         * connections around forever either, whatever the peer says. */
+
+        s->timeout_usec = CLAMP(keepalive, DNS_STREAM_TIMEOUT_USEC, DNS_STREAM_KEEPALIVE_MAX_USEC);
+}
+
 void dns_stream_detach(DnsStream *s) {
         assert(s);
 
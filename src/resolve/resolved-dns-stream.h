@@ -60,6 +60,7 @@ struct DnsStream {
 
         sd_event_source *io_event_source;
         sd_event_source *timeout_event_source;
+        usec_t timeout_usec;
 
         be16_t write_size, read_size;
         DnsPacket *write_packet, *read_packet;
@@ -104,4 +105,5 @@ static inline bool DNS_STREAM_QUEUED(DnsStream *s) {
 
 DnsPacket *dns_stream_take_read_packet(DnsStream *s);
 
+void dns_stream_set_keepalive(DnsStream *s, usec_t keepalive);
 void dns_stream_detach(DnsStream *s);
@@ -20,6 +20,9 @@
 /* On the extra stubs, use a more conservative choice */
 #define ADVERTISE_EXTRA_DATAGRAM_SIZE_MAX DNS_PACKET_UNICAST_SIZE_LARGE_MAX
 
+/* How many UDP queries to process at most per wakeup of a stub socket */
+#define STUB_UDP_RECEIVE_BATCH_MAX 32U
+
 static int manager_dns_stub_fd_extra(Manager *m, DnsStubListenerExtra *l, int type);
 
 static void dns_stub_listener_extra_hash_func(const DnsStubListenerExtra *a, struct siphash *state) {
@@ -446,7 +449,7 @@ static int dns_stub_finish_reply_packet(
         assert(p);
 
         if (add_opt) {
-                r = dns_packet_append_opt(p, max_udp_size, edns0_do, /* include_rfc6975 = */ false, nsid ? nsid_string() : NULL, rcode, NULL);
+                r = dns_packet_append_opt(p, max_udp_size, edns0_do, /* include_rfc6975 = */ false, /* tcp_keepalive = */ false, nsid ? nsid_string() : NULL, rcode, NULL);
                 if (r == -EMSGSIZE) /* Hit the size limit? then indicate truncation */
                         tc = true;
                 else if (r < 0)
@@ -963,19 +966,25 @@ static void dns_stub_process_query(Manager *m, DnsStubListenerExtra *l, DnsStrea
 }
 
 static int on_dns_stub_packet_internal(sd_event_source *s, int fd, uint32_t revents, Manager *m, DnsStubListenerExtra *l) {
-        _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
         int r;
 
-        r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
-        if (r <= 0)
-                return r;
+        /* Under load, process a batch of queries per wakeup instead of going through the event loop for
+         * each of them. The batch is bounded, so that the replies from upstream servers still get their
+         * turn. */
+        for (unsigned n = 0; n < STUB_UDP_RECEIVE_BATCH_MAX; n++) {
+                _cleanup_(dns_packet_unrefp) DnsPacket *p = NULL;
 
-        if (dns_packet_validate_query(p) > 0) {
-                log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+                r = manager_recv(m, fd, DNS_PROTOCOL_DNS, &p);
+                if (r <= 0) /* drained, or failed */
+                        return r;
 
-                dns_stub_process_query(m, l, NULL, p);
-        } else
-                log_debug("Invalid DNS stub UDP packet, ignoring.");
+                if (dns_packet_validate_query(p) > 0) {
+                        log_debug("Got DNS stub UDP query packet for id %u", DNS_PACKET_ID(p));
+
+                        dns_stub_process_query(m, l, NULL, p);
+                } else
+                        log_debug("Invalid DNS stub UDP packet, ignoring.");
+        }
 
         return 0;
 }
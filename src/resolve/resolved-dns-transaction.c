@@ -170,6 +170,10 @@ DnsTransaction* dns_transaction_gc(DnsTransaction *t) {
         if (t->block_gc > 0)
                 return t;
 
+        /* Nobody references prefetches, they stay around until they are done */
+        if (t->prefetch && DNS_TRANSACTION_IS_LIVE(t->state))
+                return t;
+
         if (set_isempty(t->notify_query_candidates) &&
             set_isempty(t->notify_query_candidates_done) &&
             set_isempty(t->notify_zone_items) &&
@@ -587,6 +591,7 @@ static void on_transaction_stream_error(DnsTransaction *t, int error) {
 }
 
 static int dns_transaction_on_stream_packet(DnsTransaction *t, DnsStream *s, DnsPacket *p) {
+        usec_t keepalive;
         bool encrypted;
 
         assert(t);
@@ -609,6 +614,11 @@ static int dns_transaction_on_stream_packet(DnsTransaction *t, DnsStream *s, Dns
         dns_transaction_process_reply(t, p, encrypted);
         t->block_gc--;
 
+        /* If the server told us how long it keeps idle connections open, keep ours open as long, so that
+         * it is reused for the next lookups. (The packet has been extracted by now, if it was valid.) */
+        if (s->type == DNS_STREAM_LOOKUP && dns_packet_get_tcp_keepalive(p, &keepalive) > 0)
+                dns_stream_set_keepalive(s, keepalive);
+
         /* If the response wasn't useful, then complete the transition
          * now. After all, we are the worst feature set now with TCP
          * sockets, and there's really no point in retrying. */
@@ -698,7 +708,7 @@ static int dns_transaction_emit_tcp(DnsTransaction *t) {
                         if (!dns_server_dnssec_supported(t->server) && dns_type_is_dnssec(dns_transaction_key(t)->type))
                                 return -EOPNOTSUPP;
 
-                        r = dns_server_adjust_opt(t->server, t->sent, t->current_feature_level);
+                        r = dns_server_adjust_opt(t->server, t->sent, t->current_feature_level, /* stream = */ true);
                         if (r < 0)
                                 return r;
                 }
@@ -1488,7 +1498,7 @@ static int dns_transaction_emit_udp(DnsTransaction *t) {
                 }
 
                 if (!t->bypass) {
-                        r = dns_server_adjust_opt(t->server, t->sent, t->current_feature_level);
+                        r = dns_server_adjust_opt(t->server, t->sent, t->current_feature_level, /* stream = */ false);
                         if (r < 0)
                                 return r;
                 }
@@ -1595,6 +1605,50 @@ static void dns_transaction_randomize_answer(DnsTransaction *t) {
         dns_answer_randomize(t->answer);
 }
 
+static void dns_transaction_maybe_prefetch(DnsTransaction *t) {
+        DnsTransaction *aux;
+        uint64_t flags;
+        int r;
+
+        assert(t);
+
+        /* If the answer we just took from the cache is popular and about to expire, start a transaction
+         * that refreshes it from the network. Nobody references that transaction, it is freed once it
+         * completed, and the answer ends up in the cache like any other. */
+
+        if (t->scope->protocol != DNS_PROTOCOL_DNS || t->bypass || t->prefetch)
+                return;
+
+        if (!dns_cache_needs_prefetch(&t->scope->cache, dns_transaction_key(t)))
+                return;
+
+        flags = t->query_flags | SD_RESOLVED_NO_CACHE;
+
+        if (dns_scope_find_transaction(t->scope, dns_transaction_key(t), flags))
+                return; /* Already being refreshed, or looked up otherwise anyway */
+
+        r = dns_transaction_new(&aux, t->scope, dns_transaction_key(t), NULL, flags);
+        if (r < 0)
+                return (void) log_debug_errno(r, "Failed to allocate prefetch transaction, ignoring: %m");
+
+        aux->prefetch = true;
+
+        log_debug("Prefetching cache entry for transaction %" PRIu16 " with transaction %" PRIu16 ".", t->id, aux->id);
+
+        aux->block_gc++;
+        r = dns_transaction_go(aux);
+        aux->block_gc--;
+        if (r < 0) {
+                log_debug_errno(r, "Failed to start prefetch transaction, ignoring: %m");
+
+                if (DNS_TRANSACTION_IS_LIVE(aux->state))
+                        return dns_transaction_complete_errno(aux, r);
+        }
+
+        /* Frees the transaction right away if it completed already */
+        dns_transaction_gc(aux);
+}
+
 static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
         int r;
 
@@ -1724,6 +1778,7 @@ static int dns_transaction_prepare(DnsTransaction *t, usec_t ts) {
                                 dns_transaction_reset_answer(t);
                         else {
                                 t->answer_source = DNS_TRANSACTION_CACHE;
+                                dns_transaction_maybe_prefetch(t);
                                 if (t->answer_rcode == DNS_RCODE_SUCCESS)
                                         dns_transaction_complete(t, DNS_TRANSACTION_SUCCESS);
                                 else
@@ -112,6 +112,9 @@ struct DnsTransaction {
 
         bool probing:1;
 
+        /* Refreshes a cache entry in the background, nobody waits for the result */
+        bool prefetch:1;
+
         /* Query candidates this transaction is referenced by and that
          * shall be notified about this specific transaction
          * completing. */
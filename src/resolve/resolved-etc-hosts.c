@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <sys/inotify.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -286,12 +287,65 @@ int etc_hosts_parse(EtcHosts *hosts, FILE *f) {
         return 0;
 }
 
+static int on_etc_hosts_change(sd_event_source *s, const struct inotify_event *event, void *userdata) {
+        Manager *m = userdata;
+
+        assert(m);
+
+        /* Something changed. Drop the watch, so that the next lookup goes through the regular checks again
+         * and sets up a new watch, possibly on a new inode. */
+        m->etc_hosts_event_source = sd_event_source_disable_unref(m->etc_hosts_event_source);
+        return 0;
+}
+
+static int manager_etc_hosts_watch(Manager *m) {
+        int r;
+
+        assert(m);
+
+        if (m->etc_hosts_event_source)
+                return 0;
+
+        /* A symlinked /etc/hosts (e.g. into /run) can change without anything happening to the inodes we
+         * could watch here, e.g. when a directory along the target path is replaced. Stick to polling with
+         * stat() then. */
+        r = is_symlink("/etc/hosts");
+        if (r > 0)
+                return 0;
+
+        /* Watch /etc/hosts, so that we don't have to stat() it on lookups while it doesn't change. If it
+         * doesn't exist (yet), watch /etc instead, until it is created. Watch the inode of /etc/hosts
+         * itself, not what it might point to, so that we also notice it being replaced. */
+        r = sd_event_add_inotify(m->event, &m->etc_hosts_event_source, "/etc/hosts",
+                                 IN_MODIFY|IN_CLOSE_WRITE|IN_ATTRIB|IN_MOVE_SELF|IN_DELETE_SELF|IN_DONT_FOLLOW,
+                                 on_etc_hosts_change, m);
+        if (r == -ENOENT)
+                r = sd_event_add_inotify(m->event, &m->etc_hosts_event_source, "/etc",
+                                         IN_CREATE|IN_MOVED_TO|IN_ONLYDIR,
+                                         on_etc_hosts_change, m);
+        if (r < 0)
+                return log_debug_errno(r, "Failed to watch /etc/hosts, falling back to polling: %m");
+
+        /* A symlink might have been put in place before the watch was added */
+        if (is_symlink("/etc/hosts") > 0) {
+                m->etc_hosts_event_source = sd_event_source_disable_unref(m->etc_hosts_event_source);
+                return 0;
+        }
+
+        (void) sd_event_source_set_description(m->etc_hosts_event_source, "etc-hosts-change");
+        return 0;
+}
+
 static int manager_etc_hosts_read(Manager *m) {
         _cleanup_fclose_ FILE *f = NULL;
         struct stat st;
         usec_t ts;
         int r;
 
+        /* If we are watching /etc/hosts and haven't been told about any change, what we have is current */
+        if (m->etc_hosts_event_source && m->etc_hosts_last != USEC_INFINITY)
+                return 0;
+
         assert_se(sd_event_now(m->event, clock_boottime_or_monotonic(), &ts) >= 0);
 
         /* See if we checked /etc/hosts recently already */
@@ -300,6 +354,9 @@ static int manager_etc_hosts_read(Manager *m) {
 
         m->etc_hosts_last = ts;
 
+        /* Set up the watch before looking at the file, so that we don't miss changes made while we read it */
+        (void) manager_etc_hosts_watch(m);
+
         if (m->etc_hosts_stat.st_mode != 0) {
                 if (stat("/etc/hosts", &st) < 0) {
                         if (errno != ENOENT)
@@ -355,7 +412,9 @@ int manager_etc_hosts_lookup(Manager *m, DnsQuestion* q, DnsAnswer **answer) {
         if (!m->read_etc_hosts)
                 return 0;
 
-        (void) manager_etc_hosts_read(m);
+        if (manager_etc_hosts_read(m) < 0)
+                /* Don't rely on the watch to tell us when to try again */
+                m->etc_hosts_event_source = sd_event_source_disable_unref(m->etc_hosts_event_source);
 
         name = dns_question_first_name(q);
         if (!name)
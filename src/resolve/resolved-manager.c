@@ -15,6 +15,7 @@
 #include "dns-domain.h"
 #include "fd-util.h"
 #include "fileio.h"
+#include "fs-util.h"
 #include "hostname-util.h"
 #include "idn-util.h"
 #include "io-util.h"
@@ -38,6 +39,7 @@
 #include "socket-util.h"
 #include "string-table.h"
 #include "string-util.h"
+#include "tmpfile-util.h"
 #include "utf8.h"
 
 #define SEND_TIMEOUT_USEC (200 * USEC_PER_MSEC)
@@ -592,6 +594,7 @@ int manager_new(Manager **ret) {
                 .dnssec_mode = DEFAULT_DNSSEC_MODE,
                 .dns_over_tls_mode = DEFAULT_DNS_OVER_TLS_MODE,
                 .enable_cache = DNS_CACHE_MODE_YES,
+                .cache_size = DNS_CACHE_MAX_DEFAULT,
                 .dns_stub_listener_mode = DNS_STUB_LISTENER_YES,
                 .read_resolv_conf = true,
                 .need_builtin_fallbacks = true,
@@ -742,11 +745,14 @@ Manager *manager_free(Manager *m) {
         sd_event_source_unref(m->hostname_event_source);
         safe_close(m->hostname_fd);
 
+        sd_event_source_unref(m->etc_hosts_event_source);
+
         sd_event_unref(m->event);
 
         free(m->full_hostname);
         free(m->llmnr_hostname);
         free(m->mdns_hostname);
+        free(m->recv_buffer);
 
         while ((s = hashmap_first(m->dnssd_services)))
                dnssd_service_free(s);
@@ -774,22 +780,23 @@ int manager_recv(Manager *m, int fd, DnsProtocol protocol, DnsPacket **ret) {
                 .msg_controllen = sizeof(control),
         };
         struct cmsghdr *cmsg;
-        ssize_t ms, l;
+        ssize_t l;
         int r;
 
         assert(m);
         assert(fd >= 0);
         assert(ret);
 
-        ms = next_datagram_size_fd(fd);
-        if (ms < 0)
-                return ms;
-
-        r = dns_packet_new(&p, protocol, ms, DNS_PACKET_SIZE_MAX);
-        if (r < 0)
-                return r;
+        /* Receive into a buffer large enough for any datagram, and copy the data into a packet of the
+         * right size afterwards. This saves the syscall for determining the size of the next datagram
+         * first, and copying the data is cheaper than that. */
+        if (!m->recv_buffer) {
+                m->recv_buffer = malloc(DNS_PACKET_SIZE_MAX);
+                if (!m->recv_buffer)
+                        return -ENOMEM;
+        }
 
-        iov = IOVEC_MAKE(DNS_PACKET_DATA(p), p->allocated);
+        iov = IOVEC_MAKE(m->recv_buffer, DNS_PACKET_SIZE_MAX);
 
         l = recvmsg_safe(fd, &mh, 0);
         if (IN_SET(l, -EAGAIN, -EINTR))
@@ -799,6 +806,11 @@ int manager_recv(Manager *m, int fd, DnsProtocol protocol, DnsPacket **ret) {
 
         assert(!(mh.msg_flags & MSG_TRUNC));
 
+        r = dns_packet_new(&p, protocol, l, DNS_PACKET_SIZE_MAX);
+        if (r < 0)
+                return r;
+
+        memcpy(DNS_PACKET_DATA(p), m->recv_buffer, l);
         p->size = (size_t) l;
 
         p->family = sa.sa.sa_family;
@@ -1511,6 +1523,122 @@ void manager_flush_caches(Manager *m, int log_level) {
         log_full(log_level, "Flushed all caches.");
 }
 
+#define SAVED_CACHE_PATH "/run/systemd/resolve/cache"
+#define SAVED_CACHE_MAGIC "systemd-resolved-cache-2"
+
+static char* manager_saved_cache_modes(Manager *m) {
+        assert(m);
+
+        /* What was cached depends on these, too: entries validated or not, learnt over an encrypted
+         * connection or not, negative entries or not. */
+        return strjoin(dnssec_mode_to_string(manager_get_dnssec_mode(m)), " ",
+                       dns_over_tls_mode_to_string(manager_get_dns_over_tls_mode(m)), " ",
+                       dns_cache_mode_to_string(m->enable_cache));
+}
+
+int manager_save_cache(Manager *m) {
+        _cleanup_(unlink_and_freep) char *temp_path = NULL;
+        _cleanup_free_ char *modes = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        int n, r;
+
+        assert(m);
+
+        /* Saves the cache of the global unicast scope, so that it can be restored by the next instance,
+         * see manager_restore_cache(). The cache only applies to the server it was filled from and to the
+         * settings it was filled with, hence those are recorded, too. */
+
+        if (!m->persistent_cache || m->enable_cache == DNS_CACHE_MODE_NO)
+                return 0;
+
+        if (!m->unicast_scope || !m->current_dns_server || dns_cache_is_empty(&m->unicast_scope->cache))
+                return 0;
+
+        modes = manager_saved_cache_modes(m);
+        if (!modes)
+                return log_oom();
+
+        r = fopen_temporary(SAVED_CACHE_PATH, &f, &temp_path);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to open new %s for writing: %m", SAVED_CACHE_PATH);
+
+        (void) fchmod(fileno(f), 0600);
+
+        fprintf(f, "%s\n%s\n%s\n", SAVED_CACHE_MAGIC, dns_server_string_full(m->current_dns_server), modes);
+
+        n = dns_cache_save(&m->unicast_scope->cache, f);
+        if (n < 0)
+                return log_warning_errno(n, "Failed to save DNS cache: %m");
+
+        r = fflush_and_check(f);
+        if (r < 0)
+                return log_warning_errno(r, "Failed to write %s: %m", SAVED_CACHE_PATH);
+
+        if (rename(temp_path, SAVED_CACHE_PATH) < 0)
+                return log_warning_errno(errno, "Failed to move new %s into place: %m", SAVED_CACHE_PATH);
+
+        temp_path = mfree(temp_path);
+
+        log_debug("Saved %i DNS cache entries to %s.", n, SAVED_CACHE_PATH);
+        return 0;
+}
+
+void manager_restore_cache(Manager *m) {
+        _cleanup_free_ char *magic = NULL, *server = NULL, *saved_modes = NULL, *modes = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        int r;
+
+        assert(m);
+
+        if (!m->persistent_cache || m->enable_cache == DNS_CACHE_MODE_NO)
+                return;
+
+        if (!m->unicast_scope || !m->current_dns_server)
+                return;
+
+        f = fopen(SAVED_CACHE_PATH, "re");
+        if (!f) {
+                if (errno != ENOENT)
+                        log_debug_errno(errno, "Failed to open %s, ignoring: %m", SAVED_CACHE_PATH);
+                return;
+        }
+
+        /* Whatever happens below, use the saved data only once */
+        (void) unlink(SAVED_CACHE_PATH);
+
+        r = read_line(f, LONG_LINE_MAX, &magic);
+        if (r <= 0 || !streq(magic, SAVED_CACHE_MAGIC))
+                return (void) log_debug("%s is not in a supported format, ignoring.", SAVED_CACHE_PATH);
+
+        r = read_line(f, LONG_LINE_MAX, &server);
+        if (r <= 0)
+                return (void) log_debug("%s is truncated, ignoring.", SAVED_CACHE_PATH);
+
+        if (!streq(server, dns_server_string_full(m->current_dns_server)))
+                return (void) log_debug("%s was saved for DNS server %s, ignoring.", SAVED_CACHE_PATH, server);
+
+        r = read_line(f, LONG_LINE_MAX, &saved_modes);
+        if (r <= 0)
+                return (void) log_debug("%s is truncated, ignoring.", SAVED_CACHE_PATH);
+
+        modes = manager_saved_cache_modes(m);
+        if (!modes)
+                return (void) log_oom();
+
+        if (!streq(saved_modes, modes))
+                return (void) log_debug("%s was saved with different DNSSEC, DNS-over-TLS or cache settings (%s), ignoring.",
+                                        SAVED_CACHE_PATH, saved_modes);
+
+        r = dns_cache_load(&m->unicast_scope->cache, m->enable_cache, f);
+        if (r < 0) {
+                log_debug_errno(r, "Failed to restore DNS cache from %s, ignoring: %m", SAVED_CACHE_PATH);
+                dns_cache_flush(&m->unicast_scope->cache);
+                return;
+        }
+
+        log_debug("Restored %i DNS cache entries from %s.", r, SAVED_CACHE_PATH);
+}
+
 void manager_reset_server_features(Manager *m) {
         Link *l;
 
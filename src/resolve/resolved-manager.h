@@ -41,6 +41,8 @@ struct Manager {
         DnsOverTlsMode dns_over_tls_mode;
         DnsCacheMode enable_cache;
         bool cache_from_localhost;
+        unsigned cache_size;
+        bool persistent_cache;
         DnsStubListenerMode dns_stub_listener_mode;
 
 #if ENABLE_DNS_OVER_TLS
@@ -125,13 +127,18 @@ struct Manager {
         sd_event_source *sigusr2_event_source;
         sd_event_source *sigrtmin1_event_source;
 
+        /* Datagrams are received into this, and then copied into packets of the right size */
+        void *recv_buffer;
+
         unsigned n_transactions_total;
+        uint64_t n_lookups_coalesced;
         unsigned n_dnssec_verdict[_DNSSEC_VERDICT_MAX];
 
         /* Data from /etc/hosts */
         EtcHosts etc_hosts;
         usec_t etc_hosts_last;
         struct stat etc_hosts_stat;
+        sd_event_source *etc_hosts_event_source;
         bool read_etc_hosts;
 
         OrderedSet *dns_extra_stub_listeners;
@@ -197,6 +204,8 @@ void manager_dnssec_verdict(Manager *m, DnssecVerdict verdict, const DnsResource
 bool manager_routable(Manager *m);
 
 void manager_flush_caches(Manager *m, int log_level);
+int manager_save_cache(Manager *m);
+void manager_restore_cache(Manager *m);
 void manager_reset_server_features(Manager *m);
 
 void manager_cleanup_saved_user(Manager *m);
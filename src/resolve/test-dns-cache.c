@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "fd-util.h"
+#include "resolved-dns-cache.h"
+#include "tests.h"
+
+static void test_dns_cache_save_load(void) {
+        _cleanup_(dns_resource_key_unrefp) DnsResourceKey *key = NULL;
+        _cleanup_(dns_resource_record_unrefp) DnsResourceRecord *rr = NULL;
+        _cleanup_(dns_answer_unrefp) DnsAnswer *answer = NULL, *found = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        DnsCache a = {}, b = {}, c = {};
+        DnssecResult dnssec_result;
+        uint64_t query_flags;
+        long size;
+        int rcode;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(key = dns_resource_key_new(DNS_CLASS_IN, DNS_TYPE_A, "www.example.com"));
+        assert_se(rr = dns_resource_record_new(key));
+        rr->ttl = 3600;
+        rr->a.in_addr.s_addr = htobe32(0xc0000201);
+
+        assert_se(answer = dns_answer_new(1));
+        assert_se(dns_answer_add(answer, rr, 1, DNS_ANSWER_CACHEABLE, NULL) >= 0);
+
+        assert_se(dns_cache_put(&a, DNS_CACHE_MODE_YES, key, DNS_RCODE_SUCCESS, answer, NULL,
+                                0, DNSSEC_UNSIGNED, UINT32_MAX, AF_INET, &IN_ADDR_NULL) >= 0);
+
+        assert_se(f = tmpfile());
+        assert_se(dns_cache_save(&a, f) == 1);
+        assert_se(fflush(f) == 0);
+        assert_se((size = ftell(f)) > 0);
+
+        /* What was saved comes back, with the same data and flags */
+        rewind(f);
+        assert_se(dns_cache_load(&b, DNS_CACHE_MODE_YES, f) == 1);
+        assert_se(dns_cache_lookup(&b, key, 0, &rcode, &found, NULL, &query_flags, &dnssec_result) > 0);
+        assert_se(rcode == DNS_RCODE_SUCCESS);
+        assert_se(dnssec_result == DNSSEC_UNSIGNED);
+        assert_se(dns_answer_size(found) == 1);
+        assert_se(dns_resource_record_equal(found->items[0].rr, rr) > 0);
+        assert_se(found->items[0].rr->ttl <= rr->ttl);
+        assert_se(found->items[0].ifindex == 1);
+
+        /* A truncated file is refused */
+        assert_se(ftruncate(fileno(f), size - 1) >= 0);
+        rewind(f);
+        assert_se(dns_cache_load(&c, DNS_CACHE_MODE_YES, f) == -EBADMSG);
+
+        dns_cache_flush(&a);
+        dns_cache_flush(&b);
+        dns_cache_flush(&c);
+}
+
+int main(int argc, char **argv) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_dns_cache_save_load();
+
+        return 0;
+}
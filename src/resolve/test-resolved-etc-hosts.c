@@ -128,6 +128,46 @@ static void test_parse_etc_hosts(void) {
         assert_se(!set_contains(hosts.no_address, "foobar.foo.foo"));
 }
 
+static void test_parse_etc_hosts_large(void) {
+        _cleanup_(unlink_tempfilep) char t[] = "/tmp/test-resolved-etc-hosts-large.XXXXXX";
+        _cleanup_(etc_hosts_free) EtcHosts hosts = {};
+        _cleanup_fclose_ FILE *f = NULL;
+        unsigned n = 100000;
+        char b[FORMAT_TIMESPAN_MAX];
+        EtcHostsItemByName *bn;
+        usec_t ts;
+        int fd;
+
+        if (!slow_tests_enabled()) {
+                log_info("/* %s skipped, slow tests are disabled */", __func__);
+                return;
+        }
+
+        log_info("/* %s */", __func__);
+
+        fd = mkostemp_safe(t);
+        assert_se(fd >= 0);
+
+        assert_se(f = fdopen(fd, "r+"));
+
+        for (unsigned i = 0; i < n; i++)
+                fprintf(f, "10.%u.%u.%u host%u.example.com host%u\n",
+                        (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF, i, i);
+        assert_se(fflush_and_check(f) >= 0);
+        rewind(f);
+
+        ts = now(CLOCK_MONOTONIC);
+        assert_se(etc_hosts_parse(&hosts, f) == 0);
+        log_info("parsing %u lines took %s", n, format_timespan(b, sizeof b, now(CLOCK_MONOTONIC) - ts, 0));
+
+        assert_se(hashmap_size(hosts.by_address) == n);
+        assert_se(hashmap_size(hosts.by_name) == 2 * n);
+
+        assert_se(bn = hashmap_get(hosts.by_name, "host0.example.com"));
+        assert_se(bn->n_addresses == 1);
+        assert_se(address_equal_4(bn->addresses[0], inet_addr("10.0.0.0")));
+}
+
 static void test_parse_file(const char *fname) {
         _cleanup_(etc_hosts_free) EtcHosts hosts = {};
         _cleanup_fclose_ FILE *f;
@@ -144,6 +184,7 @@ int main(int argc, char **argv) {
         if (argc == 1) {
                 test_parse_etc_hosts_system();
                 test_parse_etc_hosts();
+                test_parse_etc_hosts_large();
         } else
                 test_parse_file(argv[1]);
 
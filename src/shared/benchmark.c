@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdlib.h>
+
+#include "alloc-util.h"
+#include "benchmark.h"
+#include "log.h"
+#include "parse-util.h"
+#include "sort-util.h"
+
+#define BENCHMARK_WARMUP_DEFAULT 3U
+#define BENCHMARK_REPETITIONS_DEFAULT 25U
+
+int benchmark_new(const char *group, Benchmark **ret) {
+        _cleanup_(benchmark_freep) Benchmark *b = NULL;
+        const char *e;
+        int r;
+
+        assert(group);
+        assert(ret);
+
+        b = new(Benchmark, 1);
+        if (!b)
+                return -ENOMEM;
+
+        *b = (Benchmark) {
+                .group = strdup(group),
+                .warmup = BENCHMARK_WARMUP_DEFAULT,
+                .repetitions = BENCHMARK_REPETITIONS_DEFAULT,
+        };
+        if (!b->group)
+                return -ENOMEM;
+
+        e = getenv("SYSTEMD_BENCHMARK_REPETITIONS");
+        if (e) {
+                unsigned n;
+
+                r = safe_atou(e, &n);
+                if (r < 0 || n == 0)
+                        log_warning("Failed to parse $SYSTEMD_BENCHMARK_REPETITIONS, ignoring: %s", e);
+                else
+                        b->repetitions = n;
+        }
+
+        *ret = TAKE_PTR(b);
+        return 0;
+}
+
+Benchmark* benchmark_free(Benchmark *b) {
+        if (!b)
+                return NULL;
+
+        free(b->group);
+        json_variant_unref(b->results);
+        return mfree(b);
+}
+
+static int nsec_compare(const nsec_t *a, const nsec_t *b) {
+        return CMP(*a, *b);
+}
+
+static nsec_t percentile(const nsec_t *sorted, size_t n, unsigned p) {
+        assert(sorted);
+        assert(n > 0);
+        assert(p <= 100);
+
+        /* Nearest-rank method */
+        return sorted[(n * p + 99) / 100 - (p > 0)];
+}
+
+int benchmark_run(Benchmark *b, const char *name, BenchmarkFunc func, void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        _cleanup_free_ nsec_t *t = NULL;
+        nsec_t median, p90, p99;
+        int r;
+
+        assert(b);
+        assert(name);
+        assert(func);
+
+        t = new(nsec_t, b->repetitions);
+        if (!t)
+                return -ENOMEM;
+
+        for (unsigned i = 0; i < b->warmup; i++)
+                func(userdata);
+
+        for (unsigned i = 0; i < b->repetitions; i++) {
+                nsec_t begin;
+
+                begin = now_nsec(CLOCK_MONOTONIC);
+                func(userdata);
+                t[i] = now_nsec(CLOCK_MONOTONIC) - begin;
+        }
+
+        typesafe_qsort(t, b->repetitions, nsec_compare);
+
+        median = percentile(t, b->repetitions, 50);
+        p90 = percentile(t, b->repetitions, 90);
+        p99 = percentile(t, b->repetitions, 99);
+
+        log_info("%s/%s: min " NSEC_FMT "ns, median " NSEC_FMT "ns, p90 " NSEC_FMT "ns, p99 " NSEC_FMT "ns, max " NSEC_FMT "ns",
+                 b->group, name, t[0], median, p90, p99, t[b->repetitions - 1]);
+
+        r = json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("group", JSON_BUILD_STRING(b->group)),
+                                       JSON_BUILD_PAIR("name", JSON_BUILD_STRING(name)),
+                                       JSON_BUILD_PAIR("repetitions", JSON_BUILD_UNSIGNED(b->repetitions)),
+                                       JSON_BUILD_PAIR("min_nsec", JSON_BUILD_UNSIGNED(t[0])),
+                                       JSON_BUILD_PAIR("median_nsec", JSON_BUILD_UNSIGNED(median)),
+                                       JSON_BUILD_PAIR("p90_nsec", JSON_BUILD_UNSIGNED(p90)),
+                                       JSON_BUILD_PAIR("p99_nsec", JSON_BUILD_UNSIGNED(p99)),
+                                       JSON_BUILD_PAIR("max_nsec", JSON_BUILD_UNSIGNED(t[b->repetitions - 1]))));
+        if (r < 0)
+                return r;
+
+        return json_variant_append_array(&b->results, v);
+}
+
+int benchmark_report(Benchmark *b, FILE *f) {
+        assert(b);
+
+        if (!b->results)
+                return 0;
+
+        json_variant_dump(b->results, JSON_FORMAT_PRETTY_AUTO|JSON_FORMAT_COLOR_AUTO, f, NULL);
+        return 0;
+}
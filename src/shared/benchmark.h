@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include <stdio.h>
+
+#include "json.h"
+#include "macro.h"
+#include "time-util.h"
+
+/* A minimal harness for microbenchmarks: each benchmark function is run a number of times for warmup, then
+ * timed over a number of repetitions. The results are logged in human readable form and collected as JSON,
+ * so that they can be compared between builds.
+ *
+ * The number of repetitions may be overridden with $SYSTEMD_BENCHMARK_REPETITIONS. */
+
+typedef void (*BenchmarkFunc)(void *userdata);
+
+typedef struct Benchmark {
+        char *group;
+        unsigned warmup;
+        unsigned repetitions;
+        JsonVariant *results;
+} Benchmark;
+
+int benchmark_new(const char *group, Benchmark **ret);
+Benchmark* benchmark_free(Benchmark *b);
+DEFINE_TRIVIAL_CLEANUP_FUNC(Benchmark*, benchmark_free);
+
+/* Runs func(userdata) b->warmup + b->repetitions times, and records min/median/p90/p99/max of the timed
+ * repetitions, in nanoseconds, under the specified name. */
+int benchmark_run(Benchmark *b, const char *name, BenchmarkFunc func, void *userdata);
+
+/* Writes all results recorded so far as JSON array to f (stdout if NULL). */
+int benchmark_report(Benchmark *b, FILE *f);
@@ -0,0 +1,275 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "bus-changed-queue.h"
+#include "list.h"
+#include "log.h"
+#include "ordered-set.h"
+#include "set.h"
+#include "strv.h"
+
+typedef struct ChangedItem ChangedItem;
+
+struct ChangedItem {
+        char *path;
+        char *interface;
+
+        /* NULL if all properties shall be sent */
+        OrderedSet *names;
+        bool all;
+
+        LIST_FIELDS(ChangedItem, items);
+};
+
+struct BusChangedQueue {
+        sd_bus *bus;
+        sd_event_source *event_source;
+
+        usec_t interval;
+        usec_t last_flush;
+
+        /* The items are indexed by path and interface, and flushed in the order they were queued in */
+        Set *index;
+        LIST_HEAD(ChangedItem, items);
+        ChangedItem *items_tail;
+};
+
+static void changed_item_hash_func(const ChangedItem *i, struct siphash *state) {
+        assert(i);
+
+        string_hash_func(i->path, state);
+        string_hash_func(i->interface, state);
+}
+
+static int changed_item_compare_func(const ChangedItem *x, const ChangedItem *y) {
+        int r;
+
+        assert(x);
+        assert(y);
+
+        r = strcmp(x->path, y->path);
+        if (r != 0)
+                return r;
+
+        return strcmp(x->interface, y->interface);
+}
+
+DEFINE_PRIVATE_HASH_OPS(changed_item_hash_ops, ChangedItem, changed_item_hash_func, changed_item_compare_func);
+
+static ChangedItem* changed_item_free(BusChangedQueue *q, ChangedItem *i) {
+        if (!i)
+                return NULL;
+
+        if (q) {
+                set_remove(q->index, i);
+
+                if (q->items_tail == i)
+                        q->items_tail = i->items_prev;
+                LIST_REMOVE(items, q->items, i);
+        }
+
+        ordered_set_free(i->names);
+        free(i->path);
+        free(i->interface);
+
+        return mfree(i);
+}
+
+static int bus_changed_queue_arm(BusChangedQueue *q) {
+        int r;
+
+        assert(q);
+        assert(q->event_source);
+
+        if (q->interval > 0) {
+                usec_t n;
+
+                r = sd_event_now(sd_event_source_get_event(q->event_source), CLOCK_MONOTONIC, &n);
+                if (r < 0)
+                        return r;
+
+                r = sd_event_source_set_time(q->event_source, MAX(n, usec_add(q->last_flush, q->interval)));
+                if (r < 0)
+                        return r;
+        }
+
+        return sd_event_source_set_enabled(q->event_source, SD_EVENT_ONESHOT);
+}
+
+int bus_changed_queue_flush(BusChangedQueue *q) {
+        ChangedItem *i;
+        int r = 0;
+
+        assert(q);
+
+        while ((i = q->items)) {
+                _cleanup_free_ char **names = NULL;
+                int k;
+
+                if (!i->all) {
+                        names = ordered_set_get_strv(i->names);
+                        if (!names) {
+                                r = -ENOMEM;
+                                goto finish;
+                        }
+                }
+
+                k = sd_bus_emit_properties_changed_strv(q->bus, i->path, i->interface, names);
+                if (k < 0) {
+                        log_debug_errno(k, "Failed to send PropertiesChanged for %s on %s: %m", i->interface, i->path);
+                        if (r >= 0)
+                                r = k;
+                }
+
+                changed_item_free(q, i);
+        }
+
+finish:
+        if (q->event_source) {
+                (void) sd_event_now(sd_event_source_get_event(q->event_source), CLOCK_MONOTONIC, &q->last_flush);
+
+                /* If we failed half-way, try again later */
+                if (q->items)
+                        (void) bus_changed_queue_arm(q);
+                else
+                        (void) sd_event_source_set_enabled(q->event_source, SD_EVENT_OFF);
+        }
+
+        return r;
+}
+
+static int on_defer(sd_event_source *s, void *userdata) {
+        (void) bus_changed_queue_flush(userdata);
+        return 0;
+}
+
+static int on_time(sd_event_source *s, uint64_t usec, void *userdata) {
+        (void) bus_changed_queue_flush(userdata);
+        return 0;
+}
+
+int bus_changed_queue_add_strv(BusChangedQueue *q, const char *path, const char *interface, char **names) {
+        ChangedItem *i;
+        bool armed;
+        int r, k;
+
+        assert(q);
+        assert(path);
+        assert(interface);
+
+        if (names && !names[0])
+                return 0;
+
+        armed = q->items;
+
+        i = set_get(q->index, &(ChangedItem) { .path = (char*) path, .interface = (char*) interface });
+        if (!i) {
+                _cleanup_free_ char *p = NULL, *n = NULL;
+
+                p = strdup(path);
+                n = strdup(interface);
+                if (!p || !n)
+                        return -ENOMEM;
+
+                i = new(ChangedItem, 1);
+                if (!i)
+                        return -ENOMEM;
+
+                *i = (ChangedItem) {
+                        .path = TAKE_PTR(p),
+                        .interface = TAKE_PTR(n),
+                };
+
+                r = set_ensure_put(&q->index, &changed_item_hash_ops, i);
+                if (r < 0) {
+                        changed_item_free(NULL, i);
+                        return r;
+                }
+
+                LIST_INSERT_AFTER(items, q->items, q->items_tail, i);
+                q->items_tail = i;
+        }
+
+        if (names && !i->all) {
+                r = ordered_set_put_strdupv(&i->names, names);
+                if (r < 0)
+                        /* The item is queued already, possibly with only some of the names. Announce all
+                         * properties as changed instead, so that nothing is lost, but still let the caller
+                         * know. */
+                        names = NULL;
+        } else
+                r = 0;
+
+        if (!names) {
+                i->all = true;
+                i->names = ordered_set_free(i->names);
+        }
+
+        if (!q->event_source) {
+                k = bus_changed_queue_flush(q);
+                return r < 0 ? r : k;
+        }
+
+        if (!armed) {
+                k = bus_changed_queue_arm(q);
+                if (k < 0) {
+                        /* Without the event source nobody would ever send this out, do it right away */
+                        k = bus_changed_queue_flush(q);
+                        return r < 0 ? r : k;
+                }
+        }
+
+        return r;
+}
+
+int bus_changed_queue_new(sd_bus *bus, sd_event *e, usec_t interval, BusChangedQueue **ret) {
+        _cleanup_(bus_changed_queue_freep) BusChangedQueue *q = NULL;
+        int r;
+
+        assert(bus);
+        assert(ret);
+
+        q = new(BusChangedQueue, 1);
+        if (!q)
+                return -ENOMEM;
+
+        *q = (BusChangedQueue) {
+                .bus = sd_bus_ref(bus),
+                .interval = interval,
+        };
+
+        /* Without an event loop changes are sent right away, as if there was no queue */
+        if (e) {
+                if (interval > 0)
+                        r = sd_event_add_time(e, &q->event_source, CLOCK_MONOTONIC, 0, 0, on_time, q);
+                else
+                        r = sd_event_add_defer(e, &q->event_source, on_defer, q);
+                if (r < 0)
+                        return r;
+
+                r = sd_event_source_set_enabled(q->event_source, SD_EVENT_OFF);
+                if (r < 0)
+                        return r;
+
+                (void) sd_event_source_set_description(q->event_source, "bus-changed-queue");
+        }
+
+        *ret = TAKE_PTR(q);
+        return 0;
+}
+
+BusChangedQueue* bus_changed_queue_free(BusChangedQueue *q) {
+        if (!q)
+                return NULL;
+
+        /* Anything still queued is dropped */
+
+        while (q->items)
+                changed_item_free(q, q->items);
+
+        set_free(q->index);
+        sd_event_source_disable_unref(q->event_source);
+        sd_bus_unref(q->bus);
+
+        return mfree(q);
+}
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "sd-bus.h"
+#include "sd-event.h"
+
+#include "macro.h"
+#include "time-util.h"
+
+/* Collects the properties that changed per object and interface, and emits one PropertiesChanged signal
+ * for each of them later on: with an interval of zero once per event loop iteration, otherwise at most
+ * once per interval. Properties of the same object that change several times in between are sent only
+ * once, in their final state. */
+
+typedef struct BusChangedQueue BusChangedQueue;
+
+int bus_changed_queue_new(sd_bus *bus, sd_event *e, usec_t interval, BusChangedQueue **ret);
+BusChangedQueue* bus_changed_queue_free(BusChangedQueue *q);
+DEFINE_TRIVIAL_CLEANUP_FUNC(BusChangedQueue*, bus_changed_queue_free);
+
+/* A NULL list means all properties that are marked as emitting changes, as for
+ * sd_bus_emit_properties_changed_strv(). */
+int bus_changed_queue_add_strv(BusChangedQueue *q, const char *path, const char *interface, char **names);
+
+/* Emits everything that is queued right away, e.g. before sending other signals that must not overtake
+ * the changes. */
+int bus_changed_queue_flush(BusChangedQueue *q);
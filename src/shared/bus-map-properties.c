@@ -142,11 +142,15 @@ int bus_message_map_all_properties(
                 sd_bus_error *error,
                 void *userdata) {
 
+        size_t n_map, last = 0;
         int r;
 
         assert(m);
         assert(map);
 
+        for (n_map = 0; map[n_map].member; n_map++)
+                ;
+
         r = sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sv}");
         if (r < 0)
                 return r;
@@ -156,17 +160,23 @@ int bus_message_map_all_properties(
                 const char *member;
                 const char *contents;
                 void *v;
-                unsigned i;
 
                 r = sd_bus_message_read_basic(m, SD_BUS_TYPE_STRING, &member);
                 if (r < 0)
                         return r;
 
-                for (i = 0, prop = NULL; map[i].member; i++)
+                /* Properties are usually sent in vtable order, and the maps mostly list them in the same
+                 * order, hence start looking right after the previous match. */
+                prop = NULL;
+                for (size_t k = 0; k < n_map; k++) {
+                        size_t i = (last + k) % n_map;
+
                         if (streq(map[i].member, member)) {
                                 prop = &map[i];
+                                last = i + 1;
                                 break;
                         }
+                }
 
                 if (prop) {
                         r = sd_bus_message_peek_type(m, NULL, &contents);
@@ -178,7 +188,7 @@ int bus_message_map_all_properties(
                                 return r;
 
                         v = (uint8_t *)userdata + prop->offset;
-                        if (map[i].set)
+                        if (prop->set)
                                 r = prop->set(sd_bus_message_get_bus(m), member, m, error, v);
                         else
                                 r = map_basic(sd_bus_message_get_bus(m), member, m, flags, error, v);
@@ -244,3 +254,100 @@ int bus_map_all_properties(
 
         return r;
 }
+
+typedef struct GetAllRequest {
+        sd_bus_slot *slot;
+        sd_bus_message *reply;
+} GetAllRequest;
+
+static int get_all_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        GetAllRequest *req = userdata;
+
+        assert(m);
+        assert(req);
+
+        req->reply = sd_bus_message_ref(m);
+        return 0;
+}
+
+int bus_get_all_properties_many(
+                sd_bus *bus,
+                const char *destination,
+                char **paths,
+                const char *interface,
+                unsigned max_in_flight,
+                bus_get_all_handler_t handler,
+                void *userdata) {
+
+        GetAllRequest *requests;
+        size_t n, n_sent = 0, n_handled = 0;
+        int r = 0;
+
+        assert(bus);
+        assert(destination);
+        assert(max_in_flight > 0);
+        assert(handler);
+
+        /* Like calling GetAll() for each of the paths in turn, but keeps up to max_in_flight calls going at
+         * the same time, so that we don't pay a full round trip for every single object. The handler is
+         * called for each reply in the order of the paths, also for error replies. */
+
+        n = strv_length(paths);
+        if (n == 0)
+                return 0;
+
+        requests = new0(GetAllRequest, n);
+        if (!requests)
+                return -ENOMEM;
+
+        while (n_handled < n) {
+                GetAllRequest *req = requests + n_handled;
+
+                for (; n_sent < n && n_sent - n_handled < max_in_flight; n_sent++) {
+                        r = sd_bus_call_method_async(
+                                        bus,
+                                        &requests[n_sent].slot,
+                                        destination,
+                                        paths[n_sent],
+                                        "org.freedesktop.DBus.Properties",
+                                        "GetAll",
+                                        get_all_reply,
+                                        requests + n_sent,
+                                        "s", strempty(interface));
+                        if (r < 0)
+                                goto finish;
+                }
+
+                if (req->reply) {
+                        r = handler(req->reply, n_handled, userdata);
+                        req->reply = sd_bus_message_unref(req->reply);
+                        req->slot = sd_bus_slot_unref(req->slot);
+                        if (r < 0)
+                                goto finish;
+
+                        n_handled++;
+                        continue;
+                }
+
+                r = sd_bus_process(bus, NULL);
+                if (r < 0)
+                        goto finish;
+                if (r > 0)
+                        continue;
+
+                r = sd_bus_wait(bus, UINT64_MAX);
+                if (r < 0)
+                        goto finish;
+        }
+
+        r = 0;
+
+finish:
+        for (size_t i = n_handled; i < n_sent; i++) {
+                sd_bus_slot_unref(requests[i].slot);
+                sd_bus_message_unref(requests[i].reply);
+        }
+
+        free(requests);
+        return r;
+}
@@ -23,3 +23,9 @@ int bus_map_strv_sort(sd_bus *bus, const char *member, sd_bus_message *m, sd_bus
 int bus_message_map_all_properties(sd_bus_message *m, const struct bus_properties_map *map, unsigned flags, sd_bus_error *error, void *userdata);
 int bus_map_all_properties(sd_bus *bus, const char *destination, const char *path, const struct bus_properties_map *map,
                            unsigned flags, sd_bus_error *error, sd_bus_message **reply, void *userdata);
+
+/* Called for each reply, including error replies. Returning a negative value stops the iteration. */
+typedef int (*bus_get_all_handler_t)(sd_bus_message *reply, size_t idx, void *userdata);
+
+int bus_get_all_properties_many(sd_bus *bus, const char *destination, char **paths, const char *interface,
+                                unsigned max_in_flight, bus_get_all_handler_t handler, void *userdata);
@@ -9,15 +9,22 @@
 #include "escape.h"
 #include "strv.h"
 
+typedef struct JobResult {
+        char *name;
+        char *result;
+} JobResult;
+
 typedef struct BusWaitForJobs {
         sd_bus *bus;
 
         /* The set of jobs to wait for, as bus object paths */
         Set *jobs;
 
-        /* The unit name and job result of the last Job message */
-        char *name;
-        char *result;
+        /* The unit names and job results of the JobRemoved messages not processed yet. Usually there's at
+         * most one, but if the bus is dispatched by somebody else while jobs are being enqueued, several
+         * may pile up before bus_wait_for_jobs() gets to see them. */
+        JobResult *results;
+        size_t n_results;
 
         sd_bus_slot *slot_job_removed;
         sd_bus_slot *slot_disconnected;
@@ -32,7 +39,19 @@ static int match_disconnected(sd_bus_message *m, void *userdata, sd_bus_error *e
         return 0;
 }
 
+static void job_results_clear(BusWaitForJobs *d) {
+        assert(d);
+
+        for (size_t i = 0; i < d->n_results; i++) {
+                free(d->results[i].name);
+                free(d->results[i].result);
+        }
+
+        d->n_results = 0;
+}
+
 static int match_job_removed(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _cleanup_free_ char *n = NULL, *res = NULL;
         const char *path, *unit, *result;
         BusWaitForJobs *d = userdata;
         uint32_t id;
@@ -54,9 +73,20 @@ static int match_job_removed(sd_bus_message *m, void *userdata, sd_bus_error *er
 
         free(found);
 
-        (void) free_and_strdup(&d->result, empty_to_null(result));
+        if (isempty(unit) || isempty(result))
+                return 0;
+
+        n = strdup(unit);
+        res = strdup(result);
+        if (!n || !res || !GREEDY_REALLOC(d->results, d->n_results + 1)) {
+                log_oom();
+                return 0;
+        }
 
-        (void) free_and_strdup(&d->name, empty_to_null(unit));
+        d->results[d->n_results++] = (JobResult) {
+                .name = TAKE_PTR(n),
+                .result = TAKE_PTR(res),
+        };
 
         return 0;
 }
@@ -72,8 +102,8 @@ BusWaitForJobs* bus_wait_for_jobs_free(BusWaitForJobs *d) {
 
         sd_bus_unref(d->bus);
 
-        free(d->name);
-        free(d->result);
+        job_results_clear(d);
+        free(d->results);
 
         return mfree(d);
 }
@@ -139,17 +169,17 @@ static int bus_process_wait(sd_bus *bus) {
         }
 }
 
-static int bus_job_get_service_result(BusWaitForJobs *d, char **result) {
+static int bus_job_get_service_result(BusWaitForJobs *d, const char *name, char **result) {
         _cleanup_free_ char *dbus_path = NULL;
 
         assert(d);
-        assert(d->name);
+        assert(name);
         assert(result);
 
-        if (!endswith(d->name, ".service"))
+        if (!endswith(name, ".service"))
                 return -EINVAL;
 
-        dbus_path = unit_dbus_path_from_name(d->name);
+        dbus_path = unit_dbus_path_from_name(name);
         if (!dbus_path)
                 return -ENOMEM;
 
@@ -228,63 +258,64 @@ finish:
                          service_shell_quoted ?: "<service>");
 }
 
-static int check_wait_response(BusWaitForJobs *d, bool quiet, const char* const* extra_args) {
+static int check_wait_response(BusWaitForJobs *d, const JobResult *j, bool quiet, const char* const* extra_args) {
         assert(d);
-        assert(d->name);
-        assert(d->result);
+        assert(j);
+        assert(j->name);
+        assert(j->result);
 
         if (!quiet) {
-                if (streq(d->result, "canceled"))
-                        log_error("Job for %s canceled.", strna(d->name));
-                else if (streq(d->result, "timeout"))
-                        log_error("Job for %s timed out.", strna(d->name));
-                else if (streq(d->result, "dependency"))
-                        log_error("A dependency job for %s failed. See 'journalctl -xe' for details.", strna(d->name));
-                else if (streq(d->result, "invalid"))
-                        log_error("%s is not active, cannot reload.", strna(d->name));
-                else if (streq(d->result, "assert"))
-                        log_error("Assertion failed on job for %s.", strna(d->name));
-                else if (streq(d->result, "unsupported"))
-                        log_error("Operation on or unit type of %s not supported on this system.", strna(d->name));
-                else if (streq(d->result, "collected"))
-                        log_error("Queued job for %s was garbage collected.", strna(d->name));
-                else if (streq(d->result, "once"))
-                        log_error("Unit %s was started already once and can't be started again.", strna(d->name));
-                else if (!STR_IN_SET(d->result, "done", "skipped")) {
-
-                        if (d->name && endswith(d->name, ".service")) {
+                if (streq(j->result, "canceled"))
+                        log_error("Job for %s canceled.", strna(j->name));
+                else if (streq(j->result, "timeout"))
+                        log_error("Job for %s timed out.", strna(j->name));
+                else if (streq(j->result, "dependency"))
+                        log_error("A dependency job for %s failed. See 'journalctl -xe' for details.", strna(j->name));
+                else if (streq(j->result, "invalid"))
+                        log_error("%s is not active, cannot reload.", strna(j->name));
+                else if (streq(j->result, "assert"))
+                        log_error("Assertion failed on job for %s.", strna(j->name));
+                else if (streq(j->result, "unsupported"))
+                        log_error("Operation on or unit type of %s not supported on this system.", strna(j->name));
+                else if (streq(j->result, "collected"))
+                        log_error("Queued job for %s was garbage collected.", strna(j->name));
+                else if (streq(j->result, "once"))
+                        log_error("Unit %s was started already once and can't be started again.", strna(j->name));
+                else if (!STR_IN_SET(j->result, "done", "skipped")) {
+
+                        if (j->name && endswith(j->name, ".service")) {
                                 _cleanup_free_ char *result = NULL;
                                 int q;
 
-                                q = bus_job_get_service_result(d, &result);
+                                q = bus_job_get_service_result(d, j->name, &result);
                                 if (q < 0)
-                                        log_debug_errno(q, "Failed to get Result property of unit %s: %m", d->name);
+                                        log_debug_errno(q, "Failed to get Result property of unit %s: %m", j->name);
 
-                                log_job_error_with_service_result(d->name, result, extra_args);
+                                log_job_error_with_service_result(j->name, result, extra_args);
                         } else
                                 log_error("Job failed. See \"journalctl -xe\" for details.");
                 }
         }
 
-        if (STR_IN_SET(d->result, "canceled", "collected"))
+        if (STR_IN_SET(j->result, "canceled", "collected"))
                 return -ECANCELED;
-        else if (streq(d->result, "timeout"))
+        else if (streq(j->result, "timeout"))
                 return -ETIME;
-        else if (streq(d->result, "dependency"))
+        else if (streq(j->result, "dependency"))
                 return -EIO;
-        else if (streq(d->result, "invalid"))
+        else if (streq(j->result, "invalid"))
                 return -ENOEXEC;
-        else if (streq(d->result, "assert"))
+        else if (streq(j->result, "assert"))
                 return -EPROTO;
-        else if (streq(d->result, "unsupported"))
+        else if (streq(j->result, "unsupported"))
                 return -EOPNOTSUPP;
-        else if (streq(d->result, "once"))
+        else if (streq(j->result, "once"))
                 return -ESTALE;
-        else if (STR_IN_SET(d->result, "done", "skipped"))
+        else if (STR_IN_SET(j->result, "done", "skipped"))
                 return 0;
 
         return log_debug_errno(SYNTHETIC_ERRNO(EIO),
-                               "Unexpected job result, assuming server side newer than us: %s", d->result);
+                               "Unexpected job result, assuming server side newer than us: %s", j->result);
 }
 
 int bus_wait_for_jobs(BusWaitForJobs *d, bool quiet, const char* const* extra_args) {
@@ -292,26 +323,28 @@ int bus_wait_for_jobs(BusWaitForJobs *d, bool quiet, const char* const* extra_ar
 
         assert(d);
 
-        while (!set_isempty(d->jobs)) {
+        for (;;) {
                 int q;
 
-                q = bus_process_wait(d->bus);
-                if (q < 0)
-                        return log_error_errno(q, "Failed to wait for response: %m");
-
-                if (d->name && d->result) {
-                        q = check_wait_response(d, quiet, extra_args);
+                for (size_t i = 0; i < d->n_results; i++) {
+                        q = check_wait_response(d, d->results + i, quiet, extra_args);
                         /* Return the first error as it is most likely to be
                          * meaningful. */
                         if (q < 0 && r == 0)
                                 r = q;
 
                         log_full_errno_zerook(LOG_DEBUG, q,
-                                              "Got result %s/%m for job %s", d->result, d->name);
+                                              "Got result %s/%m for job %s", d->results[i].result, d->results[i].name);
                 }
 
-                d->name = mfree(d->name);
-                d->result = mfree(d->result);
+                job_results_clear(d);
+
+                if (set_isempty(d->jobs))
+                        break;
+
+                q = bus_process_wait(d->bus);
+                if (q < 0)
+                        return log_error_errno(q, "Failed to wait for response: %m");
         }
 
         return r;
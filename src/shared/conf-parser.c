@@ -104,6 +104,89 @@ int config_item_perf_lookup(
         return 1;
 }
 
+typedef struct ConfigParseAssignment {
+        unsigned line;
+        unsigned section_line;
+        const char *section;    /* points into ConfigParseRecording.sections, or NULL */
+        const char *rvalue;     /* points into .lvalue */
+        char lvalue[];
+} ConfigParseAssignment;
+
+struct ConfigParseRecording {
+        char **sections;
+        ConfigParseAssignment **assignments;
+        size_t n_assignments;
+
+        /* Set if some line was dropped with a warning. We don't want to silently swallow those when
+         * replaying, hence such recordings are not handed out. */
+        bool lossy;
+};
+
+ConfigParseRecording* config_parse_recording_free(ConfigParseRecording *rec) {
+        if (!rec)
+                return NULL;
+
+        for (size_t i = 0; i < rec->n_assignments; i++)
+                free(rec->assignments[i]);
+        free(rec->assignments);
+        strv_free(rec->sections);
+
+        return mfree(rec);
+}
+
+static int config_parse_recording_add(
+                ConfigParseRecording *rec,
+                unsigned line,
+                const char *section,
+                unsigned section_line,
+                const char *lvalue,
+                const char *rvalue) {
+
+        ConfigParseAssignment *a;
+        size_t ll, rl;
+        char *s = NULL;
+
+        assert(rec);
+        assert(lvalue);
+        assert(rvalue);
+
+        if (section) {
+                s = strv_isempty(rec->sections) ? NULL : rec->sections[strv_length(rec->sections) - 1];
+                if (!streq_ptr(s, section)) {
+                        if (strv_extend(&rec->sections, section) < 0)
+                                return -ENOMEM;
+
+                        s = rec->sections[strv_length(rec->sections) - 1];
+                }
+        }
+
+        if (!GREEDY_REALLOC(rec->assignments, rec->n_assignments + 1))
+                return -ENOMEM;
+
+        ll = strlen(lvalue);
+        rl = strlen(rvalue);
+
+        a = malloc(offsetof(ConfigParseAssignment, lvalue) + ll + 1 + rl + 1);
+        if (!a)
+                return -ENOMEM;
+
+        *a = (ConfigParseAssignment) {
+                .line = line,
+                .section_line = section_line,
+                .section = s,
+        };
+        memcpy(a->lvalue, lvalue, ll + 1);
+        a->rvalue = memcpy(a->lvalue + ll + 1, rvalue, rl + 1);
+
+        rec->assignments[rec->n_assignments++] = a;
+        return 0;
+}
+
+static void config_parse_recording_mark_lossy(ConfigParseRecording *rec) {
+        if (rec)
+                rec->lossy = true;
+}
+
 /* Run the user supplied parser for an assignment */
 static int next_assignment(
                 const char *unit,
@@ -116,7 +199,8 @@ static int next_assignment(
                 const char *lvalue,
                 const char *rvalue,
                 ConfigParseFlags flags,
-                void *userdata) {
+                void *userdata,
+                ConfigParseRecording *rec) {
 
         ConfigParserCallback func = NULL;
         int ltype = 0;
@@ -133,17 +217,25 @@ static int next_assignment(
         if (r < 0)
                 return r;
         if (r > 0) {
-                if (func)
-                        return func(unit, filename, line, section, section_line,
-                                    lvalue, ltype, rvalue, data, userdata);
+                if (!func)
+                        return 0;
 
-                return 0;
+                if (rec) {
+                        r = config_parse_recording_add(rec, line, section, section_line, lvalue, rvalue);
+                        if (r < 0)
+                                return log_oom();
+                }
+
+                return func(unit, filename, line, section, section_line,
+                            lvalue, ltype, rvalue, data, userdata);
         }
 
         /* Warn about unknown non-extension fields. */
-        if (!(flags & CONFIG_PARSE_RELAXED) && !startswith(lvalue, "X-"))
+        if (!(flags & CONFIG_PARSE_RELAXED) && !startswith(lvalue, "X-")) {
                 log_syntax(unit, LOG_WARNING, filename, line, 0,
                            "Unknown key name '%s' in section '%s', ignoring.", lvalue, section);
+                config_parse_recording_mark_lossy(rec);
+        }
 
         return 0;
 }
@@ -161,7 +253,8 @@ static int parse_line(
                 unsigned *section_line,
                 bool *section_ignored,
                 char *l,
-                void *userdata) {
+                void *userdata,
+                ConfigParseRecording *rec) {
 
         char *e;
 
@@ -177,8 +270,10 @@ static int parse_line(
         if (*l == '\n')
                 return 0;
 
-        if (!utf8_is_valid(l))
+        if (!utf8_is_valid(l)) {
+                config_parse_recording_mark_lossy(rec);
                 return log_syntax_invalid_utf8(unit, LOG_WARNING, filename, line, l);
+        }
 
         if (*l == '[') {
                 size_t k;
@@ -207,8 +302,10 @@ static int parse_line(
                                                 break;
                                         }
 
-                        if (!ignore)
+                        if (!ignore) {
                                 log_syntax(unit, LOG_WARNING, filename, line, 0, "Unknown section '%s'. Ignoring.", n);
+                                config_parse_recording_mark_lossy(rec);
+                        }
 
                         free(n);
                         *section = mfree(*section);
@@ -224,19 +321,25 @@ static int parse_line(
         }
 
         if (sections && !*section) {
-                if (!(flags & CONFIG_PARSE_RELAXED) && !*section_ignored)
+                if (!(flags & CONFIG_PARSE_RELAXED) && !*section_ignored) {
                         log_syntax(unit, LOG_WARNING, filename, line, 0, "Assignment outside of section. Ignoring.");
+                        config_parse_recording_mark_lossy(rec);
+                }
 
                 return 0;
         }
 
         e = strchr(l, '=');
-        if (!e)
+        if (!e) {
+                config_parse_recording_mark_lossy(rec);
                 return log_syntax(unit, LOG_WARNING, filename, line, 0,
                                   "Missing '=', ignoring line.");
-        if (e == l)
+        }
+        if (e == l) {
+                config_parse_recording_mark_lossy(rec);
                 return log_syntax(unit, LOG_WARNING, filename, line, 0,
                                   "Missing key name before '=', ignoring line.");
+        }
 
         *e = 0;
         e++;
@@ -251,11 +354,12 @@ static int parse_line(
                                strstrip(l),
                                strstrip(e),
                                flags,
-                               userdata);
+                               userdata,
+                               rec);
 }
 
 /* Go through the file and parse each line */
-int config_parse(
+static int config_parse_internal(
                 const char *unit,
                 const char *filename,
                 FILE *f,
@@ -264,12 +368,14 @@ int config_parse(
                 const void *table,
                 ConfigParseFlags flags,
                 void *userdata,
-                usec_t *latest_mtime) {
+                usec_t *latest_mtime,
+                ConfigParseRecording *rec) {
 
         _cleanup_free_ char *section = NULL, *continuation = NULL;
         _cleanup_fclose_ FILE *ours = NULL;
         unsigned line = 0, section_line = 0;
         bool section_ignored = false, bom_seen = false;
+        ReadLineFlags read_flags = READ_LINE_NOT_A_TTY;
         int r, fd;
         usec_t mtime;
 
@@ -280,15 +386,17 @@ int config_parse(
          * looking at is later than the current *latest_mtime value. */
 
         if (!f) {
-                f = ours = fopen(filename, "re");
-                if (!f) {
+                r = fopen_unlocked(filename, "re", &ours);
+                if (r < 0) {
                         /* Only log on request, except for ENOENT,
                          * since we return 0 to the caller. */
-                        if ((flags & CONFIG_PARSE_WARN) || errno == ENOENT)
-                                log_full_errno(errno == ENOENT ? LOG_DEBUG : LOG_ERR, errno,
+                        if ((flags & CONFIG_PARSE_WARN) || r == -ENOENT)
+                                log_full_errno(r == -ENOENT ? LOG_DEBUG : LOG_ERR, r,
                                                "Failed to open configuration file '%s': %m", filename);
-                        return errno == ENOENT ? 0 : -errno;
+                        return r == -ENOENT ? 0 : r;
                 }
+
+                f = ours;
         }
 
         fd = fileno(f);
@@ -301,6 +409,10 @@ int config_parse(
 
                 (void) stat_warn_permissions(filename, &st);
                 mtime = timespec_load(&st.st_mtim);
+
+                /* Determine this once, instead of letting read_line() call isatty() for every line */
+                if (S_ISCHR(st.st_mode) && isatty(fd))
+                        read_flags = READ_LINE_IS_A_TTY;
         } else
                 mtime = 0;
 
@@ -309,7 +421,7 @@ int config_parse(
                 bool escaped = false;
                 char *l, *p, *e;
 
-                r = read_line(f, LONG_LINE_MAX, &buf);
+                r = read_line_full(f, LONG_LINE_MAX, read_flags, &buf);
                 if (r == 0)
                         break;
                 if (r == -ENOBUFS) {
@@ -392,7 +504,8 @@ int config_parse(
                                &section_line,
                                &section_ignored,
                                p,
-                               userdata);
+                               userdata,
+                               rec);
                 if (r < 0) {
                         if (flags & CONFIG_PARSE_WARN)
                                 log_warning_errno(r, "%s:%u: Failed to parse file: %m", filename, line);
@@ -414,7 +527,8 @@ int config_parse(
                                &section_line,
                                &section_ignored,
                                continuation,
-                               userdata);
+                               userdata,
+                               rec);
                 if (r < 0) {
                         if (flags & CONFIG_PARSE_WARN)
                                 log_warning_errno(r, "%s:%u: Failed to parse file: %m", filename, line);
@@ -428,6 +542,78 @@ int config_parse(
         return 1;
 }
 
+int config_parse(
+                const char *unit,
+                const char *filename,
+                FILE *f,
+                const char *sections,
+                ConfigItemLookup lookup,
+                const void *table,
+                ConfigParseFlags flags,
+                void *userdata,
+                usec_t *latest_mtime) {
+
+        return config_parse_internal(unit, filename, f, sections, lookup, table, flags, userdata, latest_mtime, NULL);
+}
+
+int config_parse_record(
+                const char *unit,
+                const char *filename,
+                FILE *f,
+                const char *sections,
+                ConfigItemLookup lookup,
+                const void *table,
+                ConfigParseFlags flags,
+                void *userdata,
+                usec_t *latest_mtime,
+                ConfigParseRecording **ret_recording) {
+
+        _cleanup_(config_parse_recording_freep) ConfigParseRecording *rec = NULL;
+        int r;
+
+        assert(ret_recording);
+
+        rec = new0(ConfigParseRecording, 1);
+        if (!rec)
+                return log_oom();
+
+        r = config_parse_internal(unit, filename, f, sections, lookup, table, flags, userdata, latest_mtime, rec);
+
+        /* Only hand out recordings of files that were parsed completely and without complaints */
+        *ret_recording = r > 0 && !rec->lossy ? TAKE_PTR(rec) : NULL;
+        return r;
+}
+
+int config_parse_replay(
+                const char *unit,
+                const char *filename,
+                const ConfigParseRecording *rec,
+                ConfigItemLookup lookup,
+                const void *table,
+                void *userdata) {
+
+        int r;
+
+        assert(filename);
+        assert(rec);
+        assert(lookup);
+
+        /* Feeds the assignments of a previous config_parse_record() run to the parsers again, without
+         * looking at the file. The caller has to make sure the file didn't change in the meantime. */
+
+        for (size_t i = 0; i < rec->n_assignments; i++) {
+                const ConfigParseAssignment *a = rec->assignments[i];
+
+                r = next_assignment(unit, filename, a->line, lookup, table,
+                                    a->section, a->section_line, a->lvalue, a->rvalue,
+                                    0, userdata, NULL);
+                if (r < 0)
+                        return r;
+        }
+
+        return 1;
+}
+
 static int config_parse_many_files(
                 const char* const* conf_files,
                 char **files,
@@ -797,6 +983,7 @@ int config_parse_strv(
                 void *userdata) {
 
         char ***sv = data;
+        size_t n = SIZE_MAX;
         int r;
 
         assert(filename);
@@ -822,7 +1009,7 @@ int config_parse_strv(
                         return 0;
                 }
 
-                r = strv_consume(sv, word);
+                r = strv_consume_with_size(sv, &n, word);
                 if (r < 0)
                         return log_oom();
         }
@@ -91,6 +91,33 @@ int config_parse(
                 void *userdata,
                 usec_t *latest_mtime);      /* input/output, possibly NULL */
 
+/* The assignments found in a file by config_parse_record(), which config_parse_replay() can feed to the
+ * parsers again later on, without reading and tokenizing the file again. */
+typedef struct ConfigParseRecording ConfigParseRecording;
+
+ConfigParseRecording* config_parse_recording_free(ConfigParseRecording *rec);
+DEFINE_TRIVIAL_CLEANUP_FUNC(ConfigParseRecording*, config_parse_recording_free);
+
+int config_parse_record(
+                const char *unit,
+                const char *filename,
+                FILE *f,
+                const char *sections,       /* nulstr */
+                ConfigItemLookup lookup,
+                const void *table,
+                ConfigParseFlags flags,
+                void *userdata,
+                usec_t *latest_mtime,       /* input/output, possibly NULL */
+                ConfigParseRecording **ret_recording); /* NULL if the file can't be replayed faithfully */
+
+int config_parse_replay(
+                const char *unit,
+                const char *filename,
+                const ConfigParseRecording *rec,
+                ConfigItemLookup lookup,
+                const void *table,
+                void *userdata);
+
 int config_parse_many_nulstr(
                 const char *conf_file,      /* possibly NULL */
                 const char *conf_file_dirs, /* nulstr */
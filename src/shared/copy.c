@@ -134,7 +134,7 @@ int copy_bytes_full(
 
         /* Try btrfs reflinks first. This only works on regular, seekable files, hence let's check the file offsets of
          * source and destination first. */
-        if ((copy_flags & COPY_REFLINK)) {
+        if ((copy_flags & COPY_REFLINK) && max_bytes > 0) {
                 off_t foffset;
 
                 foffset = lseek(fdf, 0, SEEK_CUR);
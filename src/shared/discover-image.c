@@ -896,11 +896,20 @@ int image_clone(Image *i, const char *new_name, bool read_only) {
 
                 break;
 
-        case IMAGE_RAW:
+        case IMAGE_RAW: {
+                unsigned file_attr = FS_NOCOW_FL;
+
                 new_path = strjoina("/var/lib/machines/", new_name, ".raw");
 
-                r = copy_file_atomic(i->path, new_path, read_only ? 0444 : 0644, FS_NOCOW_FL, FS_NOCOW_FL, COPY_REFLINK|COPY_CRTIME);
+                /* btrfs refuses to reflink between files that differ in their NOCOW flag, and we'd fall back
+                 * to a full copy then. Hence, take the flag over from the source rather than forcing it, so
+                 * that the clone is cheap wherever reflinks are supported. */
+                (void) read_attr_path(i->path, &file_attr);
+
+                r = copy_file_atomic(i->path, new_path, read_only ? 0444 : 0644,
+                                     file_attr & FS_NOCOW_FL, FS_NOCOW_FL, COPY_REFLINK|COPY_CRTIME);
                 break;
+        }
 
         case IMAGE_BLOCK:
         default:
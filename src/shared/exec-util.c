@@ -4,6 +4,7 @@
 #include <errno.h>
 #include <sys/prctl.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <stdio.h>
 
@@ -79,6 +80,64 @@ static int do_spawn(const char *path, char *argv[], int stdout_fd, pid_t *pid, b
         return 1;
 }
 
+typedef struct ExecChild {
+        usec_t start;
+        char path[];
+} ExecChild;
+
+static ExecChild* exec_child_new(const char *path) {
+        ExecChild *c;
+        size_t l;
+
+        assert(path);
+
+        l = strlen(path);
+        c = malloc(offsetof(ExecChild, path) + l + 1);
+        if (!c)
+                return NULL;
+
+        c->start = now(CLOCK_MONOTONIC);
+        memcpy(c->path, path, l + 1);
+        return c;
+}
+
+static int exec_child_wait(ExecChild *c, pid_t pid) {
+        char buf[FORMAT_TIMESPAN_MAX];
+        int r;
+
+        assert(c);
+        assert(pid > 0);
+
+        r = wait_for_terminate_and_check(c->path, pid, WAIT_LOG);
+
+        /* Report how long each binary took, so that slow ones stand out in the logs. */
+        log_debug("%s finished after %s.",
+                  c->path, format_timespan(buf, sizeof(buf), usec_sub_unsigned(now(CLOCK_MONOTONIC), c->start), USEC_PER_MSEC));
+
+        return r;
+}
+
+static int exec_child_wait_any(Hashmap *pids) {
+        _cleanup_free_ ExecChild *c = NULL;
+        siginfo_t si = {};
+
+        assert(pids);
+
+        /* Waits for whichever of the children in 'pids' finishes first, and reaps it. */
+
+        if (waitid(P_ALL, 0, &si, WEXITED|WNOWAIT) < 0)
+                return log_error_errno(errno, "Failed to wait for child processes: %m");
+
+        c = hashmap_remove(pids, PID_TO_PTR(si.si_pid));
+        if (!c) {
+                /* Not one of ours? Just reap it. */
+                (void) wait_for_terminate(si.si_pid, NULL);
+                return 0;
+        }
+
+        return exec_child_wait(c, si.si_pid);
+}
+
 static int do_execute(
                 char **directories,
                 usec_t timeout,
@@ -87,7 +146,8 @@ static int do_execute(
                 int output_fd,
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                unsigned max_parallel) {
 
         _cleanup_hashmap_free_free_ Hashmap *pids = NULL;
         _cleanup_strv_free_ char **paths = NULL;
@@ -99,7 +159,8 @@ static int do_execute(
          * use of SIGALRM to set a time limit.
          *
          * We attempt to perform parallel execution if configured by the user, however
-         * if `callbacks` is nonnull, execution must be serial.
+         * if `callbacks` is nonnull, execution must be serial. If max_parallel is non-zero,
+         * no more than that many binaries are run at the same time.
          */
         parallel_execution = FLAGS_SET(flags, EXEC_DIR_PARALLEL) && !callbacks;
 
@@ -124,12 +185,12 @@ static int do_execute(
                         return log_error_errno(errno, "Failed to set environment variable: %m");
 
         STRV_FOREACH(path, paths) {
-                _cleanup_free_ char *t = NULL;
+                _cleanup_free_ ExecChild *c = NULL;
                 _cleanup_close_ int fd = -1;
                 pid_t pid;
 
-                t = strdup(*path);
-                if (!t)
+                c = exec_child_new(*path);
+                if (!c)
                         return log_oom();
 
                 if (callbacks) {
@@ -138,17 +199,25 @@ static int do_execute(
                                 return log_error_errno(fd, "Failed to open serialization file: %m");
                 }
 
-                r = do_spawn(t, argv, fd, &pid, FLAGS_SET(flags, EXEC_DIR_SET_SYSTEMD_EXEC_PID));
+                r = do_spawn(c->path, argv, fd, &pid, FLAGS_SET(flags, EXEC_DIR_SET_SYSTEMD_EXEC_PID));
                 if (r <= 0)
                         continue;
 
                 if (parallel_execution) {
-                        r = hashmap_put(pids, PID_TO_PTR(pid), t);
+                        r = hashmap_put(pids, PID_TO_PTR(pid), c);
                         if (r < 0)
                                 return log_oom();
-                        t = NULL;
+                        c = NULL;
+
+                        if (max_parallel > 0 && hashmap_size(pids) >= max_parallel) {
+                                r = exec_child_wait_any(pids);
+                                if (r < 0)
+                                        return r;
+                                if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
+                                        return r;
+                        }
                 } else {
-                        r = wait_for_terminate_and_check(t, pid, WAIT_LOG);
+                        r = exec_child_wait(c, pid);
                         if (FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS)) {
                                 if (r < 0)
                                         continue;
@@ -174,16 +243,9 @@ static int do_execute(
         }
 
         while (!hashmap_isempty(pids)) {
-                _cleanup_free_ char *t = NULL;
-                pid_t pid;
-
-                pid = PTR_TO_PID(hashmap_first_key(pids));
-                assert(pid > 0);
-
-                t = hashmap_remove(pids, PID_TO_PTR(pid));
-                assert(t);
-
-                r = wait_for_terminate_and_check(t, pid, WAIT_LOG);
+                r = exec_child_wait_any(pids);
+                if (r < 0)
+                        return r;
                 if (!FLAGS_SET(flags, EXEC_DIR_IGNORE_ERRORS) && r > 0)
                         return r;
         }
@@ -191,14 +253,15 @@ static int do_execute(
         return 0;
 }
 
-int execute_directories(
+int execute_directories_full(
                 const char* const* directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void* const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags) {
+                ExecDirFlags flags,
+                unsigned max_parallel) {
 
         char **dirs = (char**) directories;
         _cleanup_close_ int fd = -1;
@@ -230,7 +293,7 @@ int execute_directories(
         if (r < 0)
                 return r;
         if (r == 0) {
-                r = do_execute(dirs, timeout, callbacks, callback_args, fd, argv, envp, flags);
+                r = do_execute(dirs, timeout, callbacks, callback_args, fd, argv, envp, flags, max_parallel);
                 _exit(r < 0 ? EXIT_FAILURE : r);
         }
 
@@ -30,14 +30,26 @@ typedef enum ExecCommandFlags {
         _EXEC_COMMAND_FLAGS_INVALID   = -EINVAL,
 } ExecCommandFlags;
 
-int execute_directories(
+int execute_directories_full(
                 const char* const* directories,
                 usec_t timeout,
                 gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
                 void* const callback_args[_STDOUT_CONSUME_MAX],
                 char *argv[],
                 char *envp[],
-                ExecDirFlags flags);
+                ExecDirFlags flags,
+                unsigned max_parallel);
+
+static inline int execute_directories(
+                const char* const* directories,
+                usec_t timeout,
+                gather_stdout_callback_t const callbacks[_STDOUT_CONSUME_MAX],
+                void* const callback_args[_STDOUT_CONSUME_MAX],
+                char *argv[],
+                char *envp[],
+                ExecDirFlags flags) {
+        return execute_directories_full(directories, timeout, callbacks, callback_args, argv, envp, flags, 0);
+}
 
 int exec_command_flags_from_strv(char **ex_opts, ExecCommandFlags *flags);
 int exec_command_flags_to_strv(ExecCommandFlags flags, char ***ex_opts);
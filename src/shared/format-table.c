@@ -1820,10 +1820,55 @@ static int table_data_requested_width_height(
         return truncation_applied;
 }
 
+static size_t align_string_width(const char *str, size_t length) {
+        size_t w = 0;
+
+        /* Determine current width on screen */
+        for (const char *p = str; p < str + length;) {
+                char32_t c;
+
+                if (utf8_encoded_to_unichar(p, &c) < 0) {
+                        p++, w++; /* count invalid chars as 1 */
+                        continue;
+                }
+
+                p = utf8_next_char(p);
+                w += unichar_iswide(c) ? 2 : 1;
+        }
+
+        return w;
+}
+
+static void align_string_padding(const char *str, size_t new_length, unsigned percent, size_t *ret_lspace, size_t *ret_rspace) {
+        size_t w, space;
+
+        assert(str);
+        assert(percent <= 100);
+        assert(ret_lspace);
+        assert(ret_rspace);
+
+        /* Like align_string_mem(), but only determines the number of spaces to add on either side, so that
+         * they can be written out directly, without allocating an aligned copy of the string. */
+
+        w = align_string_width(str, strlen(str));
+        if (w >= new_length) {
+                *ret_lspace = *ret_rspace = 0;
+                return;
+        }
+
+        space = new_length - w;
+        *ret_lspace = space * percent / 100U;
+        *ret_rspace = space - *ret_lspace;
+}
+
+static void fputs_spaces(size_t n, FILE *f) {
+        for (size_t i = 0; i < n; i++)
+                fputc(' ', f);
+}
+
 static char *align_string_mem(const char *str, const char *url, size_t new_length, unsigned percent) {
-        size_t w = 0, space, lspace, old_length, clickable_length;
+        size_t w, space, lspace, old_length, clickable_length;
         _cleanup_free_ char *clickable = NULL;
-        const char *p;
         char *ret;
         int r;
 
@@ -1843,19 +1888,7 @@ static char *align_string_mem(const char *str, const char *url, size_t new_lengt
         } else
                 clickable_length = old_length;
 
-        /* Determine current width on screen */
-        p = str;
-        while (p < str + old_length) {
-                char32_t c;
-
-                if (utf8_encoded_to_unichar(p, &c) < 0) {
-                        p++, w++; /* count invalid chars as 1 */
-                        continue;
-                }
-
-                p = utf8_next_char(p);
-                w += unichar_iswide(c) ? 2 : 1;
-        }
+        w = align_string_width(str, old_length);
 
         /* Already wider than the target, if so, don't do anything */
         if (w >= new_length)
@@ -2192,8 +2225,8 @@ int table_print(Table *t, FILE *f) {
                                 _cleanup_free_ char *buffer = NULL, *extracted = NULL;
                                 bool lines_truncated = false;
                                 const char *field, *color = NULL;
+                                size_t l, lspace = 0, rspace = 0;
                                 TableData *d;
-                                size_t l;
 
                                 assert_se(d = row[t->display_map ? t->display_map[j] : j]);
 
@@ -2248,20 +2281,31 @@ int table_print(Table *t, FILE *f) {
 
                                         if (l < width[j]) {
                                                 _cleanup_free_ char *aligned = NULL;
-                                                /* Field is shorter than allocated space. Let's align with spaces */
+                                                bool drop_trailing;
 
-                                                aligned = align_string_mem(field, d->url, width[j], d->align_percent);
-                                                if (!aligned)
-                                                        return -ENOMEM;
+                                                /* Field is shorter than allocated space. Let's align with spaces */
 
                                                 /* Drop trailing white spaces of last column when no cosmetics is set. */
-                                                if (j == display_columns - 1 &&
-                                                    (!colors_enabled() || (!table_data_color(d) && row != t->data)) &&
-                                                    (!urlify_enabled() || !d->url))
-                                                        delete_trailing_chars(aligned, NULL);
-
-                                                free_and_replace(buffer, aligned);
-                                                field = buffer;
+                                                drop_trailing = j == display_columns - 1 &&
+                                                        (!colors_enabled() || (!table_data_color(d) && row != t->data)) &&
+                                                        (!urlify_enabled() || !d->url);
+
+                                                if (!d->url && !drop_trailing)
+                                                        /* The common case: the spaces are written out right
+                                                         * away, there's no need to build an aligned copy of
+                                                         * each cell. */
+                                                        align_string_padding(field, width[j], d->align_percent, &lspace, &rspace);
+                                                else {
+                                                        aligned = align_string_mem(field, d->url, width[j], d->align_percent);
+                                                        if (!aligned)
+                                                                return -ENOMEM;
+
+                                                        if (drop_trailing)
+                                                                delete_trailing_chars(aligned, NULL);
+
+                                                        free_and_replace(buffer, aligned);
+                                                        field = buffer;
+                                                }
                                         }
                                 }
 
@@ -2299,7 +2343,9 @@ int table_print(Table *t, FILE *f) {
                                                 fputs(ansi_underline(), f);
                                 }
 
+                                fputs_spaces(lspace, f);
                                 fputs(field, f);
+                                fputs_spaces(rspace, f);
 
                                 if (colors_enabled() && (color || row == t->data))
                                         fputs(ANSI_NORMAL, f);
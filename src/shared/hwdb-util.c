@@ -11,6 +11,7 @@
 #include "fs-util.h"
 #include "hwdb-internal.h"
 #include "hwdb-util.h"
+#include "io-util.h"
 #include "label.h"
 #include "mkdir.h"
 #include "nulstr-util.h"
@@ -579,6 +580,62 @@ static int import_file(struct trie *trie, const char *filename, uint16_t file_pr
         return r;
 }
 
+static bool hwdb_bin_is_current(const char *hwdb_bin, const char *root, char **files, bool compat) {
+        struct trie_header_f head;
+        _cleanup_close_ int fd = -1;
+        const char * const *d;
+        struct stat st;
+        usec_t built;
+        char **f;
+
+        assert(hwdb_bin);
+
+        /* Returns true if hwdb.bin was written by this version of the tool, in the requested format, after
+         * the last change to any of the source files. Adding, removing or renaming a source file updates
+         * the mtime of its directory, hence it is enough to look at the directories and the files we
+         * found. */
+
+        fd = open(hwdb_bin, O_RDONLY|O_CLOEXEC|O_NOCTTY);
+        if (fd < 0)
+                return false;
+
+        if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+                return false;
+
+        if (loop_read_exact(fd, &head, sizeof(head), false) < 0)
+                return false;
+
+        if (memcmp(head.signature, (const uint8_t[]) HWDB_SIG, sizeof(head.signature)) != 0 ||
+            le64toh(head.tool_version) != PROJECT_VERSION ||
+            le64toh(head.value_entry_size) != (compat ? sizeof(struct trie_value_entry_f) : sizeof(struct trie_value_entry2_f)))
+                return false;
+
+        built = timespec_load(&st.st_mtim);
+
+        for (d = conf_file_dirs; *d; d++) {
+                _cleanup_free_ char *p = NULL;
+
+                p = path_join(root, *d);
+                if (!p)
+                        return false;
+
+                if (stat(p, &st) < 0) {
+                        if (errno == ENOENT)
+                                continue;
+                        return false;
+                }
+
+                if (timespec_load(&st.st_mtim) >= built)
+                        return false;
+        }
+
+        STRV_FOREACH(f, files)
+                if (stat(*f, &st) < 0 || timespec_load(&st.st_mtim) >= built)
+                        return false;
+
+        return true;
+}
+
 int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool compat) {
         _cleanup_free_ char *hwdb_bin = NULL;
         _cleanup_(trie_freep) struct trie *trie = NULL;
@@ -612,6 +669,16 @@ int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool co
         if (err < 0)
                 return log_error_errno(err, "Failed to enumerate hwdb files: %m");
 
+        hwdb_bin = path_join(root, hwdb_bin_dir ?: default_hwdb_bin_dir, "hwdb.bin");
+        if (!hwdb_bin)
+                return -ENOMEM;
+
+        /* In strict mode the sources are always parsed, since the caller wants to hear about errors in them */
+        if (!strict && hwdb_bin_is_current(hwdb_bin, root, files, compat)) {
+                log_debug("%s is newer than all hwdb sources, skipping rebuild.", hwdb_bin);
+                return 0;
+        }
+
         STRV_FOREACH(f, files) {
                 log_debug("Reading file \"%s\"", *f);
                 err = import_file(trie, *f, file_priority++, compat);
@@ -635,10 +702,6 @@ int hwdb_update(const char *root, const char *hwdb_bin_dir, bool strict, bool co
         log_debug("strings dedup'ed: %8zu bytes (%8zu)",
                   trie->strings->dedup_len, trie->strings->dedup_count);
 
-        hwdb_bin = path_join(root, hwdb_bin_dir ?: default_hwdb_bin_dir, "hwdb.bin");
-        if (!hwdb_bin)
-                return -ENOMEM;
-
         mkdir_parents_label(hwdb_bin, 0755);
         err = trie_store(trie, hwdb_bin, compat);
         if (err < 0)
@@ -718,22 +718,53 @@ static int is_symlink_with_known_name(const UnitFileInstallInfo *i, const char *
         return false;
 }
 
-static int find_symlinks_in_directory(
-                DIR *dir,
-                const char *dir_path,
-                const char *root_dir,
-                const UnitFileInstallInfo *i,
-                bool match_aliases,
-                bool ignore_same_name,
-                const char *config_path,
-                bool *same_name_link) {
+/* The symlinks found in one directory, with their destinations already made absolute. Reading these is the
+ * expensive part of determining the state of a unit file, and when the state of many unit files is queried
+ * in one go the very same directories would be read over and over again. Hence they are read only once
+ * into a SymlinkDirectory, and kept around in a cache keyed by the config path for the whole query. */
+typedef struct SymlinkDirectory {
+        char *path;
+        char **links;   /* pairs of symlink name and absolute destination */
+        int error;      /* first error encountered while reading the symlinks, if any */
+} SymlinkDirectory;
+
+/* The .wants/.requires directories of one config path, followed by the config path itself. */
+typedef struct SymlinkIndex {
+        SymlinkDirectory *directories;
+        size_t n_directories;
+        int error;      /* error encountered while reading the config path itself, if any */
+} SymlinkIndex;
+
+static SymlinkIndex* symlink_index_free(SymlinkIndex *x) {
+        if (!x)
+                return NULL;
 
+        for (size_t k = 0; k < x->n_directories; k++) {
+                free(x->directories[k].path);
+                strv_free(x->directories[k].links);
+        }
+
+        free(x->directories);
+        return mfree(x);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(SymlinkIndex*, symlink_index_free);
+
+DEFINE_PRIVATE_HASH_OPS_FULL(symlink_index_hash_ops, char, path_hash_func, path_compare, free,
+                             SymlinkIndex, symlink_index_free);
+
+static int symlink_directory_read(DIR *dir, const char *dir_path, SymlinkDirectory *ret) {
+        _cleanup_strv_free_ char **links = NULL;
+        size_t n_links = 0;
         struct dirent *de;
         int r = 0;
 
+        assert(dir);
+        assert(dir_path);
+        assert(ret);
+
         FOREACH_DIRENT(de, dir, return -errno) {
-                _cleanup_free_ char *dest = NULL;
-                bool found_path = false, found_dest, b = false;
+                _cleanup_free_ char *dest = NULL, *name = NULL;
                 int q;
 
                 if (de->d_type != DT_LNK)
@@ -760,6 +791,172 @@ static int find_symlinks_in_directory(
                         free_and_replace(dest, x);
                 }
 
+                name = strdup(de->d_name);
+                if (!name)
+                        return -ENOMEM;
+
+                if (!GREEDY_REALLOC(links, n_links + 3))
+                        return -ENOMEM;
+
+                links[n_links++] = TAKE_PTR(name);
+                links[n_links++] = TAKE_PTR(dest);
+                links[n_links] = NULL;
+        }
+
+        *ret = (SymlinkDirectory) {
+                .links = TAKE_PTR(links),
+                .error = r,
+        };
+
+        ret->path = strdup(dir_path);
+        if (!ret->path) {
+                ret->links = strv_free(ret->links);
+                return -ENOMEM;
+        }
+
+        return 0;
+}
+
+static int symlink_index_add(SymlinkIndex *x, DIR *dir, const char *dir_path) {
+        int r;
+
+        assert(x);
+
+        if (!GREEDY_REALLOC(x->directories, x->n_directories + 1))
+                return -ENOMEM;
+
+        r = symlink_directory_read(dir, dir_path, x->directories + x->n_directories);
+        if (r < 0)
+                return r;
+
+        x->n_directories++;
+        return 0;
+}
+
+static int symlink_index_new(const char *config_path, SymlinkIndex **ret) {
+        _cleanup_(symlink_index_freep) SymlinkIndex *x = NULL;
+        _cleanup_closedir_ DIR *config_dir = NULL;
+        struct dirent *de;
+        int r;
+
+        assert(config_path);
+        assert(ret);
+
+        x = new0(SymlinkIndex, 1);
+        if (!x)
+                return -ENOMEM;
+
+        config_dir = opendir(config_path);
+        if (!config_dir) {
+                if (!IN_SET(errno, ENOENT, ENOTDIR, EACCES))
+                        x->error = -errno;
+
+                *ret = TAKE_PTR(x);
+                return 0;
+        }
+
+        FOREACH_DIRENT(de, config_dir, x->error = -errno; goto finish) {
+                const char *suffix;
+                _cleanup_free_ const char *path = NULL;
+                _cleanup_closedir_ DIR *d = NULL;
+
+                if (de->d_type != DT_DIR)
+                        continue;
+
+                suffix = strrchr(de->d_name, '.');
+                if (!STRPTR_IN_SET(suffix, ".wants", ".requires"))
+                        continue;
+
+                path = path_join(config_path, de->d_name);
+                if (!path)
+                        return -ENOMEM;
+
+                d = opendir(path);
+                if (!d) {
+                        log_error_errno(errno, "Failed to open directory '%s' while scanning for symlinks, ignoring: %m", path);
+                        continue;
+                }
+
+                r = symlink_index_add(x, d, path);
+                if (r == -ENOMEM)
+                        return r;
+                if (r < 0)
+                        log_debug_errno(r, "Failed to lookup for symlinks in '%s': %m", path);
+        }
+
+        /* The links in the config path itself come last, since they are only looked at if nothing suitable
+         * was found in the .wants or .requires directories. */
+        rewinddir(config_dir);
+        r = symlink_index_add(x, config_dir, config_path);
+        if (r == -ENOMEM)
+                return r;
+        if (r < 0)
+                x->error = r;
+
+finish:
+        *ret = TAKE_PTR(x);
+        return 0;
+}
+
+static int symlink_index_get(Hashmap **cache, const char *config_path, SymlinkIndex **ret, SymlinkIndex **ret_owned) {
+        _cleanup_(symlink_index_freep) SymlinkIndex *x = NULL;
+        _cleanup_free_ char *key = NULL;
+        int r;
+
+        assert(config_path);
+        assert(ret);
+        assert(ret_owned);
+
+        /* Returns the index of the specified config path, either from the cache or freshly read. If there
+         * is no cache the caller has to free the index, hence it is returned in ret_owned, too. */
+
+        if (cache) {
+                x = hashmap_get(*cache, config_path);
+                if (x) {
+                        *ret = TAKE_PTR(x);
+                        *ret_owned = NULL;
+                        return 0;
+                }
+        }
+
+        r = symlink_index_new(config_path, &x);
+        if (r < 0)
+                return r;
+
+        if (!cache) {
+                *ret = *ret_owned = TAKE_PTR(x);
+                return 0;
+        }
+
+        key = strdup(config_path);
+        if (!key)
+                return -ENOMEM;
+
+        r = hashmap_ensure_put(cache, &symlink_index_hash_ops, key, x);
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(key);
+        *ret = TAKE_PTR(x);
+        *ret_owned = NULL;
+        return 0;
+}
+
+static int find_symlinks_in_directory(
+                const SymlinkDirectory *dir,
+                const char *root_dir,
+                const UnitFileInstallInfo *i,
+                bool match_aliases,
+                bool ignore_same_name,
+                const char *config_path,
+                bool *same_name_link) {
+
+        char **name, **dest;
+        int q;
+
+        STRV_FOREACH_PAIR(name, dest, dir->links) {
+                bool found_path = false, found_dest, b = false;
+
                 assert(unit_name_is_valid(i->name, UNIT_NAME_ANY));
                 if (!ignore_same_name)
                                /* Check if the symlink itself matches what we are looking for.
@@ -767,17 +964,17 @@ static int find_symlinks_in_directory(
                                 * If ignore_same_name is specified, we are in one of the directories which
                                 * have lower priority than the unit file, and even if a file or symlink with
                                 * this name was found, we should ignore it. */
-                                found_path = streq(de->d_name, i->name);
+                                found_path = streq(*name, i->name);
 
                 /* Check if what the symlink points to matches what we are looking for */
-                found_dest = streq(basename(dest), i->name);
+                found_dest = streq(basename(*dest), i->name);
 
                 if (found_path && found_dest) {
                         _cleanup_free_ char *p = NULL, *t = NULL;
 
                         /* Filter out same name links in the main
                          * config path */
-                        p = path_make_absolute(de->d_name, dir_path);
+                        p = path_make_absolute(*name, dir->path);
                         t = path_make_absolute(i->name, config_path);
 
                         if (!p || !t)
@@ -793,7 +990,7 @@ static int find_symlinks_in_directory(
                                 return 1;
 
                         /* Check if symlink name is in the set of names used by [Install] */
-                        q = is_symlink_with_known_name(i, de->d_name);
+                        q = is_symlink_with_known_name(i, *name);
                         if (q < 0)
                                 return q;
                         if (q > 0)
@@ -801,7 +998,7 @@ static int find_symlinks_in_directory(
                 }
         }
 
-        return r;
+        return dir->error;
 }
 
 static int find_symlinks(
@@ -810,55 +1007,36 @@ static int find_symlinks(
                 bool match_name,
                 bool ignore_same_name,
                 const char *config_path,
+                Hashmap **symlink_cache,
                 bool *same_name_link) {
 
-        _cleanup_closedir_ DIR *config_dir = NULL;
-        struct dirent *de;
-        int r = 0;
+        _cleanup_(symlink_index_freep) SymlinkIndex *owned = NULL;
+        SymlinkIndex *x;
+        int r;
 
         assert(i);
         assert(config_path);
         assert(same_name_link);
 
-        config_dir = opendir(config_path);
-        if (!config_dir) {
-                if (IN_SET(errno, ENOENT, ENOTDIR, EACCES))
-                        return 0;
-                return -errno;
-        }
-
-        FOREACH_DIRENT(de, config_dir, return -errno) {
-                const char *suffix;
-                _cleanup_free_ const char *path = NULL;
-                _cleanup_closedir_ DIR *d = NULL;
-
-                if (de->d_type != DT_DIR)
-                        continue;
-
-                suffix = strrchr(de->d_name, '.');
-                if (!STRPTR_IN_SET(suffix, ".wants", ".requires"))
-                        continue;
-
-                path = path_join(config_path, de->d_name);
-                if (!path)
-                        return -ENOMEM;
+        r = symlink_index_get(symlink_cache, config_path, &x, &owned);
+        if (r < 0)
+                return r;
 
-                d = opendir(path);
-                if (!d) {
-                        log_error_errno(errno, "Failed to open directory '%s' while scanning for symlinks, ignoring: %m", path);
-                        continue;
-                }
+        for (size_t k = 0; k < x->n_directories; k++) {
+                const SymlinkDirectory *d = x->directories + k;
+                bool last = k + 1 == x->n_directories && x->error == 0;
 
-                r = find_symlinks_in_directory(d, path, root_dir, i, match_name, ignore_same_name, config_path, same_name_link);
+                r = find_symlinks_in_directory(d, root_dir, i, match_name, ignore_same_name, config_path, same_name_link);
                 if (r > 0)
                         return 1;
-                else if (r < 0)
-                        log_debug_errno(r, "Failed to lookup for symlinks in '%s': %m", path);
+                if (last)
+                        /* This is the config path itself: its errors are propagated */
+                        return r;
+                if (r < 0)
+                        log_debug_errno(r, "Failed to lookup for symlinks in '%s': %m", d->path);
         }
 
-        /* We didn't find any suitable symlinks in .wants or .requires directories, let's look for linked unit files in this directory. */
-        rewinddir(config_dir);
-        return find_symlinks_in_directory(config_dir, config_path, root_dir, i, match_name, ignore_same_name, config_path, same_name_link);
+        return x->error;
 }
 
 static int find_symlinks_in_scope(
@@ -866,6 +1044,7 @@ static int find_symlinks_in_scope(
                 const LookupPaths *paths,
                 const UnitFileInstallInfo *i,
                 bool match_name,
+                Hashmap **symlink_cache,
                 UnitFileState *state) {
 
         bool same_name_link_runtime = false, same_name_link_config = false;
@@ -884,7 +1063,7 @@ static int find_symlinks_in_scope(
         STRV_FOREACH(p, paths->search_path)  {
                 bool same_name_link = false;
 
-                r = find_symlinks(paths->root_dir, i, match_name, ignore_same_name, *p, &same_name_link);
+                r = find_symlinks(paths->root_dir, i, match_name, ignore_same_name, *p, symlink_cache, &same_name_link);
                 if (r < 0)
                         return r;
                 if (r > 0) {
@@ -2806,10 +2985,11 @@ int unit_file_get_default(
         return 0;
 }
 
-int unit_file_lookup_state(
+static int unit_file_lookup_state_full(
                 UnitFileScope scope,
                 const LookupPaths *paths,
                 const char *name,
+                Hashmap **symlink_cache,
                 UnitFileState *ret) {
 
         _cleanup_(install_context_done) InstallContext c = {};
@@ -2872,7 +3052,7 @@ int unit_file_lookup_state(
                 /* Check if any of the Alias= symlinks have been created.
                  * We ignore other aliases, and only check those that would
                  * be created by systemctl enable for this unit. */
-                r = find_symlinks_in_scope(scope, paths, i, true, &state);
+                r = find_symlinks_in_scope(scope, paths, i, true, symlink_cache, &state);
                 if (r < 0)
                         return r;
                 if (r > 0)
@@ -2880,7 +3060,7 @@ int unit_file_lookup_state(
 
                 /* Check if the file is known under other names. If it is,
                  * it might be in use. Report that as UNIT_FILE_INDIRECT. */
-                r = find_symlinks_in_scope(scope, paths, i, false, &state);
+                r = find_symlinks_in_scope(scope, paths, i, false, symlink_cache, &state);
                 if (r < 0)
                         return r;
                 if (r > 0)
@@ -2904,6 +3084,15 @@ int unit_file_lookup_state(
         return 0;
 }
 
+int unit_file_lookup_state(
+                UnitFileScope scope,
+                const LookupPaths *paths,
+                const char *name,
+                UnitFileState *ret) {
+
+        return unit_file_lookup_state_full(scope, paths, name, NULL, ret);
+}
+
 int unit_file_get_state(
                 UnitFileScope scope,
                 const char *root_dir,
@@ -3420,6 +3609,7 @@ int unit_file_get_list(
                 char **patterns) {
 
         _cleanup_(lookup_paths_free) LookupPaths paths = {};
+        _cleanup_hashmap_free_ Hashmap *symlink_cache = NULL;
         char **dirname;
         int r;
 
@@ -3470,7 +3660,9 @@ int unit_file_get_list(
                         if (!f->path)
                                 return -ENOMEM;
 
-                        r = unit_file_lookup_state(scope, &paths, de->d_name, &f->state);
+                        /* All unit files share the symlink cache, so that each directory in the search
+                         * path is read only once, instead of once per unit file. */
+                        r = unit_file_lookup_state_full(scope, &paths, de->d_name, &symlink_cache, &f->state);
                         if (r < 0)
                                 f->state = UNIT_FILE_BAD;
 
@@ -441,9 +441,10 @@ int journal_importer_push_data(JournalImporter *imp, const char *data, size_t si
 void journal_importer_drop_iovw(JournalImporter *imp) {
         size_t remain, target;
 
-        /* This function drops processed data that along with the iovw that points at it */
+        /* This function drops processed data that along with the iovw that points at it. The iovec array
+         * itself is kept around, the next entry will most likely need about as many fields as this one. */
 
-        iovw_free_contents(&imp->iovw, false);
+        imp->iovw.count = 0;
 
         /* possibly reset buffer position */
         remain = imp->filled - imp->offset;
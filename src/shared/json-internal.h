@@ -14,6 +14,13 @@ typedef union JsonValue  {
         long double real;
         intmax_t integer;
         uintmax_t unsig;
+
+        /* For strings: either points into the parsed input (if no unescaping was necessary) or into the
+         * string returned separately. Not NUL terminated in the former case. */
+        struct {
+                const char *string;
+                size_t size;
+        } view;
 } JsonValue;
 
 /* Let's protect us against accidental structure size changes on our most relevant arch */
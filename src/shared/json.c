@@ -1510,7 +1510,18 @@ static void json_format_string(FILE *f, const char *q, JsonFormatFlags flags) {
         if (flags & JSON_FORMAT_COLOR)
                 fputs(ansi_green(), f);
 
-        for (; *q; q++)
+        for (const char *e = q + strlen(q); q < e; q++) {
+                size_t n;
+
+                /* Write out runs of characters that need no escaping in one go */
+                n = ascii_printable_span(q, e - q, '"', '\\');
+                if (n > 0) {
+                        fwrite(q, 1, n, f);
+                        q += n;
+                        if (q >= e)
+                                break;
+                }
+
                 switch (*q) {
                 case '"':
                         fputs("\\\"", f);
@@ -1541,12 +1552,14 @@ static void json_format_string(FILE *f, const char *q, JsonFormatFlags flags) {
                         break;
 
                 default:
-                        if ((signed char) *q >= 0 && *q < ' ')
+                        if (((signed char) *q >= 0 && *q < ' ') || *q == 0x7f)
+                                /* 0x7f is refused unescaped by our own parser, hence escape it too */
                                 fprintf(f, "\\u%04x", *q);
                         else
                                 fputc(*q, f);
                         break;
                 }
+        }
 
         if (flags & JSON_FORMAT_COLOR)
                 fputs(ANSI_NORMAL, f);
@@ -2397,14 +2410,15 @@ static int unhex_ucs2(const char *c, uint16_t *ret) {
         return 0;
 }
 
-static int json_parse_string(const char **p, char **ret) {
+static int json_parse_string(const char **p, char **ret, JsonValue *ret_value) {
         _cleanup_free_ char *s = NULL;
         size_t n = 0;
-        const char *c;
+        const char *c, *e;
 
         assert(p);
         assert(*p);
         assert(ret);
+        assert(ret_value);
 
         c = *p;
 
@@ -2413,6 +2427,50 @@ static int json_parse_string(const char **p, char **ret) {
 
         c++;
 
+        /* Most strings need no unescaping at all, refer to them in the input directly in that case, and
+         * only copy them once we hit the first escape sequence. strpbrk() is usually vectorized, and lets us
+         * check everything up to the next quote or backslash in bulk. */
+        e = strpbrk(c, "\"\\");
+        if (!e)
+                return -EINVAL;
+
+        for (const char *q = c;; ) {
+                int len;
+
+                q += ascii_printable_span(q, e - q, 0, 0);
+
+                if (*q == '\\') {
+                        n = q - c;
+
+                        s = new(char, n + 1);
+                        if (!s)
+                                return -ENOMEM;
+
+                        memcpy(s, c, n);
+                        c = q;
+                        break;
+                }
+
+                if (*q == '"') {
+                        *p = q + 1;
+
+                        *ret = NULL;
+                        ret_value->view.string = c;
+                        ret_value->view.size = q - c;
+                        return JSON_TOKEN_STRING;
+                }
+
+                /* Check for EOF, control characters 0x00..0x1f and control character 0x7f */
+                if (*q == 0 || (*q > 0 && *q < ' ') || *q == 0x7f)
+                        return -EINVAL;
+
+                len = utf8_encoded_valid_unichar(q, e - q);
+                if (len < 0)
+                        return len;
+
+                q += len;
+        }
+
         for (;;) {
                 int len;
 
@@ -2429,15 +2487,12 @@ static int json_parse_string(const char **p, char **ret) {
                         return -EINVAL;
 
                 if (*c == '"') {
-                        if (!s) {
-                                s = strdup("");
-                                if (!s)
-                                        return -ENOMEM;
-                        } else
-                                s[n] = 0;
+                        s[n] = 0;
 
                         *p = c + 1;
 
+                        ret_value->view.string = s;
+                        ret_value->view.size = n;
                         *ret = TAKE_PTR(s);
                         return JSON_TOKEN_STRING;
                 }
@@ -2711,11 +2766,10 @@ int json_tokenize(
 
                 } else if (*c == '"') {
 
-                        r = json_parse_string(&c, ret_string);
+                        r = json_parse_string(&c, ret_string, ret_value);
                         if (r < 0)
                                 return r;
 
-                        *ret_value = JSON_VALUE_NULL;
                         *state = INT_TO_PTR(STATE_VALUE_POST);
                         goto finish;
 
@@ -3033,7 +3087,10 @@ static int json_parse_internal(
                                 goto finish;
                         }
 
-                        r = json_variant_new_string(&add, string);
+                        if (string)
+                                r = json_variant_new_string(&add, string);
+                        else
+                                r = json_variant_new_stringn(&add, value.view.string, value.view.size);
                         if (r < 0)
                                 goto finish;
 
@@ -11,9 +11,11 @@
 #include "alloc-util.h"
 #include "def.h"
 #include "dirent-util.h"
+#include "errno-util.h"
 #include "fd-util.h"
 #include "format-util.h"
 #include "killall.h"
+#include "missing_syscall.h"
 #include "parse-util.h"
 #include "process-util.h"
 #include "set.h"
@@ -186,6 +188,16 @@ static int wait_for_children(Set *pids, sigset_t *mask, usec_t timeout) {
         }
 }
 
+static int kill_pidfd_or_pid(int pidfd, pid_t pid, int sig) {
+        if (pidfd >= 0) {
+                if (pidfd_send_signal(pidfd, sig, NULL, 0) < 0)
+                        return -errno;
+        } else if (kill(pid, sig) < 0)
+                return -errno;
+
+        return 0;
+}
+
 static int killall(int sig, Set *pids, bool send_sighup) {
         _cleanup_closedir_ DIR *dir = NULL;
         struct dirent *d;
@@ -199,6 +211,7 @@ static int killall(int sig, Set *pids, bool send_sighup) {
                 return log_warning_errno(errno, "opendir(/proc) failed: %m");
 
         FOREACH_DIRENT_ALL(d, dir, break) {
+                _cleanup_close_ int pidfd = -1;
                 pid_t pid;
                 int r;
 
@@ -208,6 +221,17 @@ static int killall(int sig, Set *pids, bool send_sighup) {
                 if (parse_pid(d->d_name, &pid) < 0)
                         continue;
 
+                /* Pin the process before we look at it, so that the signal is guaranteed to hit the very
+                 * process we checked, even if its PID got recycled in the meantime. If pidfds are not
+                 * available, fall back to plain kill(). */
+                pidfd = pidfd_open(pid, 0);
+                if (pidfd < 0) {
+                        if (errno == ESRCH)
+                                continue;
+                        if (!ERRNO_IS_NOT_SUPPORTED(errno) && !ERRNO_IS_PRIVILEGE(errno))
+                                log_debug_errno(errno, "Failed to open pidfd for " PID_FMT ", falling back to kill(): %m", pid);
+                }
+
                 if (ignore_proc(pid, sig == SIGKILL && !in_initrd()))
                         continue;
 
@@ -218,15 +242,16 @@ static int killall(int sig, Set *pids, bool send_sighup) {
                         log_notice("Sending SIGKILL to PID "PID_FMT" (%s).", pid, strna(s));
                 }
 
-                if (kill(pid, sig) >= 0) {
+                r = kill_pidfd_or_pid(pidfd, pid, sig);
+                if (r >= 0) {
                         n_killed++;
                         if (pids) {
                                 r = set_put(pids, PID_TO_PTR(pid));
                                 if (r < 0)
                                         log_oom();
                         }
-                } else if (errno != ENOENT)
-                        log_warning_errno(errno, "Could not kill %d: %m", pid);
+                } else if (!IN_SET(r, -ENOENT, -ESRCH))
+                        log_warning_errno(r, "Could not kill %d: %m", pid);
 
                 if (send_sighup) {
                         /* Optionally, also send a SIGHUP signal, but
@@ -241,7 +266,7 @@ static int killall(int sig, Set *pids, bool send_sighup) {
 
                         if (get_ctty_devnr(pid, NULL) >= 0)
                                 /* it's OK if the process is gone, just ignore the result */
-                                (void) kill(pid, SIGHUP);
+                                (void) kill_pidfd_or_pid(pidfd, pid, SIGHUP);
                 }
         }
 
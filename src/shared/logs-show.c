@@ -31,6 +31,7 @@
 #include "parse-util.h"
 #include "pretty-print.h"
 #include "process-util.h"
+#include "siphash24.h"
 #include "sparse-endian.h"
 #include "stdio-util.h"
 #include "string-table.h"
@@ -983,6 +984,299 @@ static int update_json_data_split(
         return update_json_data(h, flags, name, eq + 1, size - fieldlen - 1);
 }
 
+/* The fields of the entry being written by output_json_stream(). The field data is copied back to back
+ * into one buffer, since what sd_journal_enumerate_data() returns is only valid until the next call. All
+ * of this is reused for the next entry, so that writing an entry normally doesn't allocate anything. */
+typedef struct JsonStreamField {
+        size_t offset;    /* of "NAME=value" in the buffer */
+        size_t name_len;
+        size_t size;      /* of "NAME=value" */
+        size_t next;      /* index + 1 of the next field with the same name, 0 if this is the last one */
+        size_t last;      /* for the first field of a name, the index of the last field with that name */
+        bool duplicate;   /* not the first field with this name */
+} JsonStreamField;
+
+static struct {
+        char *buffer;
+        size_t buffer_size;
+        JsonStreamField *fields;
+        size_t n_fields;
+        size_t *table;    /* open addressing, index + 1 of the first field of a name, 0 if empty */
+        size_t n_table;
+} json_stream = {};
+
+static int json_stream_add_field(const void *data, size_t size, size_t name_len) {
+        JsonStreamField *field;
+
+        if (!GREEDY_REALLOC(json_stream.buffer, json_stream.buffer_size + size))
+                return -ENOMEM;
+        if (!GREEDY_REALLOC(json_stream.fields, json_stream.n_fields + 1))
+                return -ENOMEM;
+
+        memcpy(json_stream.buffer + json_stream.buffer_size, data, size);
+
+        field = json_stream.fields + json_stream.n_fields;
+        *field = (JsonStreamField) {
+                .offset = json_stream.buffer_size,
+                .name_len = name_len,
+                .size = size,
+                .last = json_stream.n_fields,
+        };
+
+        json_stream.buffer_size += size;
+        json_stream.n_fields++;
+        return 0;
+}
+
+static int json_stream_group_fields(void) {
+        static const uint8_t key[16] = {};
+        size_t n_table, mask;
+
+        /* Links all fields with the same name together, so that they can be written as one array, in the
+         * position of the first one. The table is kept at most half full. */
+
+        n_table = 16;
+        while (n_table < json_stream.n_fields * 2)
+                n_table *= 2;
+
+        if (n_table > json_stream.n_table) {
+                if (!GREEDY_REALLOC(json_stream.table, n_table))
+                        return -ENOMEM;
+                json_stream.n_table = n_table;
+        }
+
+        mask = json_stream.n_table - 1;
+        memzero(json_stream.table, json_stream.n_table * sizeof(size_t));
+
+        for (size_t i = 0; i < json_stream.n_fields; i++) {
+                JsonStreamField *field = json_stream.fields + i;
+                const char *name = json_stream.buffer + field->offset;
+                size_t k;
+
+                for (k = siphash24(name, field->name_len, key) & mask; json_stream.table[k] != 0; k = (k + 1) & mask) {
+                        JsonStreamField *first = json_stream.fields + json_stream.table[k] - 1;
+
+                        if (first->name_len == field->name_len &&
+                            memcmp(json_stream.buffer + first->offset, name, field->name_len) == 0) {
+                                json_stream.fields[first->last].next = i + 1;
+                                first->last = i;
+                                field->duplicate = true;
+                                break;
+                        }
+                }
+
+                if (!field->duplicate)
+                        json_stream.table[k] = i + 1;
+        }
+
+        return 0;
+}
+
+static void json_stream_write_string(FILE *f, const char *p, size_t l) {
+        const char *e = p + l;
+
+        /* Escapes the same way json_format_string() does. The caller ensures this is valid UTF-8, but it may
+         * still contain newlines and other control characters. */
+
+        fputc('"', f);
+
+        for (const char *q = p;; q++) {
+                if (q < e && !IN_SET(*q, '"', '\\') && !((signed char) *q >= 0 && *q < ' ') && *q != 0x7f)
+                        continue;
+
+                fwrite(p, 1, q - p, f);
+                if (q >= e)
+                        break;
+
+                switch (*q) {
+                case '"':
+                        fputs("\\\"", f);
+                        break;
+
+                case '\\':
+                        fputs("\\\\", f);
+                        break;
+
+                case '\b':
+                        fputs("\\b", f);
+                        break;
+
+                case '\f':
+                        fputs("\\f", f);
+                        break;
+
+                case '\n':
+                        fputs("\\n", f);
+                        break;
+
+                case '\r':
+                        fputs("\\r", f);
+                        break;
+
+                case '\t':
+                        fputs("\\t", f);
+                        break;
+
+                default:
+                        fprintf(f, "\\u%04x", *q);
+                        break;
+                }
+
+                p = q + 1;
+        }
+
+        fputc('"', f);
+}
+
+static void json_stream_write_value(FILE *f, OutputFlags flags, size_t name_len, const char *p, size_t l) {
+
+        /* Mirrors what update_json_data() turns values into */
+
+        if (!(flags & OUTPUT_SHOW_ALL) && name_len + 1 + l >= JSON_THRESHOLD)
+                fputs("null", f);
+        else if (utf8_is_printable(p, l))
+                json_stream_write_string(f, p, l);
+        else {
+                fputc('[', f);
+                for (size_t i = 0; i < l; i++)
+                        fprintf(f, i > 0 ? ",%u" : "%u", (uint8_t) p[i]);
+                fputc(']', f);
+        }
+}
+
+static void json_stream_write_field(FILE *f, OutputFlags flags, const char *name, const char *value) {
+        fputc(',', f);
+        json_stream_write_string(f, name, strlen(name));
+        fputc(':', f);
+        json_stream_write_value(f, flags, strlen(name), value, strlen(value));
+}
+
+static int output_json_stream(
+                FILE *f,
+                sd_journal *j,
+                OutputMode mode,
+                OutputFlags flags,
+                const Set *output_fields) {
+
+        char sid[SD_ID128_STRING_MAX], usecbuf[DECIMAL_STR_MAX(usec_t)];
+        _cleanup_free_ char *cursor = NULL;
+        uint64_t realtime, monotonic;
+        sd_id128_t boot_id;
+        int r;
+
+        assert(f);
+        assert(j);
+
+        /* Writes the entry directly, without building a JsonVariant object first. This produces the same
+         * as json_variant_dump() in the single line formats, except that the fields are written in the
+         * order they appear in the entry. This is what log shippers use, so it better be fast. */
+
+        (void) sd_journal_set_data_threshold(j, flags & OUTPUT_SHOW_ALL ? 0 : JSON_THRESHOLD);
+
+        r = sd_journal_get_realtime_usec(j, &realtime);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get realtime timestamp: %m");
+
+        r = sd_journal_get_monotonic_usec(j, &monotonic, &boot_id);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get monotonic timestamp: %m");
+
+        r = sd_journal_get_cursor(j, &cursor);
+        if (r < 0)
+                return log_error_errno(r, "Failed to get cursor: %m");
+
+        json_stream.buffer_size = json_stream.n_fields = 0;
+
+        for (;;) {
+                const void *data;
+                const char *eq;
+                size_t size;
+
+                r = sd_journal_enumerate_data(j, &data, &size);
+                if (r == -EBADMSG) {
+                        log_debug_errno(r, "Skipping message we can't read: %m");
+                        return 0;
+                }
+                if (r < 0)
+                        return log_error_errno(r, "Failed to read journal: %m");
+                if (r == 0)
+                        break;
+
+                if (memory_startswith(data, size, "_BOOT_ID="))
+                        continue;
+
+                eq = memchr(data, '=', MIN(size, JSON_THRESHOLD));
+                if (!eq)
+                        continue;
+
+                if (!journal_field_valid(data, eq - (const char*) data, true))
+                        return log_error_errno(SYNTHETIC_ERRNO(EINVAL), "Invalid field.");
+
+                r = field_set_test(output_fields, data, eq - (const char*) data);
+                if (r < 0)
+                        return r;
+                if (!r)
+                        continue;
+
+                r = json_stream_add_field(data, size, eq - (const char*) data);
+                if (r < 0)
+                        return log_oom();
+        }
+
+        r = json_stream_group_fields();
+        if (r < 0)
+                return log_oom();
+
+        if (mode == OUTPUT_JSON_SSE)
+                fputs("data: ", f);
+        if (mode == OUTPUT_JSON_SEQ)
+                fputc('\x1e', f); /* ASCII Record Separator */
+
+        fputs("{\"__CURSOR\":", f);
+        json_stream_write_value(f, flags, STRLEN("__CURSOR"), cursor, strlen(cursor));
+        xsprintf(usecbuf, USEC_FMT, realtime);
+        json_stream_write_field(f, flags, "__REALTIME_TIMESTAMP", usecbuf);
+        xsprintf(usecbuf, USEC_FMT, monotonic);
+        json_stream_write_field(f, flags, "__MONOTONIC_TIMESTAMP", usecbuf);
+        json_stream_write_field(f, flags, "_BOOT_ID", sd_id128_to_string(boot_id, sid));
+
+        for (size_t i = 0; i < json_stream.n_fields; i++) {
+                const JsonStreamField *field = json_stream.fields + i;
+                bool array;
+
+                if (field->duplicate)
+                        continue;
+
+                fputc(',', f);
+                json_stream_write_string(f, json_stream.buffer + field->offset, field->name_len);
+                fputc(':', f);
+
+                array = field->next != 0;
+                if (array)
+                        fputc('[', f);
+
+                for (;;) {
+                        json_stream_write_value(f, flags, field->name_len,
+                                                json_stream.buffer + field->offset + field->name_len + 1,
+                                                field->size - field->name_len - 1);
+                        if (field->next == 0)
+                                break;
+
+                        field = json_stream.fields + field->next - 1;
+                        fputc(',', f);
+                }
+
+                if (array)
+                        fputc(']', f);
+        }
+
+        fputs("}\n", f);
+        if (mode == OUTPUT_JSON_SSE)
+                fputc('\n', f); /* In case of SSE add a second newline */
+
+        return 0;
+}
+
 static int output_json(
                 FILE *f,
                 sd_journal *j,
@@ -1005,6 +1299,9 @@ static int output_json(
 
         assert(j);
 
+        if (mode != OUTPUT_JSON_PRETTY && !(flags & OUTPUT_COLOR))
+                return output_json_stream(f, j, mode, flags, output_fields);
+
         (void) sd_journal_set_data_threshold(j, flags & OUTPUT_SHOW_ALL ? 0 : JSON_THRESHOLD);
 
         r = sd_journal_get_realtime_usec(j, &realtime);
@@ -298,6 +298,12 @@ int bind_remount_recursive_with_mountinfo(
                         if (r < 0)
                                 return r;
 
+                        /* Skip the remount if the mount has the flags we want already, which is common for
+                         * submounts of a tree that was made read-only or noexec before. With many sandboxing
+                         * options in effect this saves a lot of syscalls for each service started. */
+                        if (((flags ^ new_flags) & flags_mask & ~MS_RELATIME) == 0)
+                                continue;
+
                         /* Now, remount this with the new flags set, but exclude MS_RELATIME from it. (It's
                          * the default anyway, thus redundant, and in userns we'll get an error if we try to
                          * explicitly enable it) */
@@ -400,6 +406,10 @@ int bind_remount_one_with_mountinfo(
                         log_debug_errno(r, "Could not get flags for '%s', ignoring: %m", path);
         }
 
+        /* Nothing to do if the mount has the flags we want already. */
+        if (((flags ^ new_flags) & flags_mask & ~MS_RELATIME) == 0)
+                return 0;
+
         r = mount_nofollow(NULL, path, NULL, ((flags & ~flags_mask)|MS_BIND|MS_REMOUNT|new_flags) & ~MS_RELATIME, NULL);
         if (r < 0) {
                 if (((flags ^ new_flags) & flags_mask & ~MS_RELATIME) != 0) /* Ignore MS_RELATIME again,
@@ -153,25 +153,28 @@ int net_match_config(
 
         assert(match);
 
-        r = link_get_type_string(device, iftype, &iftype_str);
-        if (r == -ENOMEM)
-                return r;
+        /* This is called for each .network file for each link. Hence, look up the properties of the
+         * device only when the corresponding setting is actually used, and test the name first, as
+         * that is the most commonly used one. */
 
-        if (device) {
+        if (match->ifname) {
+                if (!ifname && device)
+                        (void) sd_device_get_sysname(device, &ifname);
+
+                if (!net_condition_test_ifname(match->ifname, ifname, alternative_names))
+                        return false;
+        }
+
+        if (match->mac) {
                 const char *mac_str;
 
-                (void) sd_device_get_property_value(device, "ID_PATH", &path);
-                if (!driver)
-                        (void) sd_device_get_property_value(device, "ID_NET_DRIVER", &driver);
-                if (!ifname)
-                        (void) sd_device_get_sysname(device, &ifname);
-                if (!mac &&
+                if (!mac && device &&
                     sd_device_get_sysattr_value(device, "address", &mac_str) >= 0)
                         mac = ether_aton(mac_str);
-        }
 
-        if (match->mac && (!mac || !set_contains(match->mac, mac)))
-                return false;
+                if (!mac || !set_contains(match->mac, mac))
+                        return false;
+        }
 
         if (match->permanent_mac &&
             (!permanent_mac ||
@@ -179,17 +182,30 @@ int net_match_config(
              !set_contains(match->permanent_mac, permanent_mac)))
                 return false;
 
-        if (!net_condition_test_strv(match->path, path))
-                return false;
+        if (match->path) {
+                if (device)
+                        (void) sd_device_get_property_value(device, "ID_PATH", &path);
 
-        if (!net_condition_test_strv(match->driver, driver))
-                return false;
+                if (!net_condition_test_strv(match->path, path))
+                        return false;
+        }
 
-        if (!net_condition_test_strv(match->iftype, iftype_str))
-                return false;
+        if (match->driver) {
+                if (!driver && device)
+                        (void) sd_device_get_property_value(device, "ID_NET_DRIVER", &driver);
 
-        if (!net_condition_test_ifname(match->ifname, ifname, alternative_names))
-                return false;
+                if (!net_condition_test_strv(match->driver, driver))
+                        return false;
+        }
+
+        if (match->iftype) {
+                r = link_get_type_string(device, iftype, &iftype_str);
+                if (r == -ENOMEM)
+                        return r;
+
+                if (!net_condition_test_strv(match->iftype, iftype_str))
+                        return false;
+        }
 
         if (!net_condition_test_property(match->property, device))
                 return false;
@@ -281,9 +281,13 @@ static int tpm2_make_primary(
         static const TPML_PCR_SELECTION creation_pcr = {};
         ESYS_TR primary = ESYS_TR_NONE;
         TSS2_RC rc;
+        usec_t ts;
 
         log_debug("Creating primary key on TPM.");
 
+        /* Deriving the primary key is typically the slowest TPM operation we do, hence measure it */
+        ts = now(CLOCK_MONOTONIC);
+
         rc = sym_Esys_CreatePrimary(
                         c,
                         ESYS_TR_RH_OWNER,
@@ -304,7 +308,10 @@ static int tpm2_make_primary(
                 return log_error_errno(SYNTHETIC_ERRNO(ENOTRECOVERABLE),
                                        "Failed to generate primary key in TPM: %s", sym_Tss2_RC_Decode(rc));
 
-        log_debug("Successfully created primary key on TPM.");
+        if (DEBUG_LOGGING) {
+                char buf[FORMAT_TIMESPAN_MAX];
+                log_debug("Successfully created primary key on TPM in %s.", format_timespan(buf, sizeof(buf), now(CLOCK_MONOTONIC) - ts, USEC_PER_MSEC));
+        }
 
         *ret_primary = primary;
         return 0;
@@ -679,13 +686,15 @@ int tpm2_unseal(
         /* If we know the policy hash to expect, and it doesn't match, we can shortcut things here, and not
          * wait until the TPM2 tells us to go away. */
         if (known_policy_hash_size > 0 &&
-            memcmp_nn(policy_digest->buffer, policy_digest->size, known_policy_hash, known_policy_hash_size) != 0)
-                return log_error_errno(SYNTHETIC_ERRNO(EPERM),
-                                       "Current policy digest does not match stored policy digest, cancelling TPM2 authentication attempt.");
+            memcmp_nn(policy_digest->buffer, policy_digest->size, known_policy_hash, known_policy_hash_size) != 0) {
+                r = log_error_errno(SYNTHETIC_ERRNO(EPERM),
+                                    "Current policy digest does not match stored policy digest, cancelling TPM2 authentication attempt.");
+                goto finish;
+        }
 
         r = tpm2_make_primary(c.esys_context, &primary);
         if (r < 0)
-                return r;
+                goto finish;
 
         log_debug("Loading HMAC key into TPM.");
 
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <pthread.h>
+
+#include "alloc-util.h"
+#include "hashmap.h"
+#include "string-util.h"
+#include "userdb-cache.h"
+
+#define USERDB_CACHE_MAX 1024U
+
+typedef struct CacheEntry {
+        char *key;
+        char *text; /* NULL for a cached negative lookup */
+        usec_t until;
+} CacheEntry;
+
+static CacheEntry* cache_entry_free(CacheEntry *e) {
+        if (!e)
+                return NULL;
+
+        free(e->key);
+        free(e->text);
+        return mfree(e);
+}
+
+DEFINE_TRIVIAL_CLEANUP_FUNC(CacheEntry*, cache_entry_free);
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(cache_hash_ops, char, string_hash_func, string_compare_func, CacheEntry, cache_entry_free);
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static OrderedHashmap *cache = NULL; /* oldest first */
+static usec_t cache_ttl = USERDB_CACHE_TTL_DEFAULT_USEC;
+static pthread_once_t cache_atfork_once = PTHREAD_ONCE_INIT;
+
+static void cache_atfork_prepare(void) {
+        assert_se(pthread_mutex_lock(&cache_mutex) == 0);
+}
+
+static void cache_atfork_parent(void) {
+        assert_se(pthread_mutex_unlock(&cache_mutex) == 0);
+}
+
+static void cache_atfork_child(void) {
+        /* Whatever the child does next (drop privileges, join another namespace, …) it shouldn't be
+         * answered with records the parent looked up, hence start over. We hold the lock, taken in the
+         * prepare handler, so nobody else can have been halfway through modifying the cache. */
+        cache = ordered_hashmap_free(cache);
+        assert_se(pthread_mutex_unlock(&cache_mutex) == 0);
+}
+
+static void cache_atfork_register(void) {
+        assert_se(pthread_atfork(cache_atfork_prepare, cache_atfork_parent, cache_atfork_child) == 0);
+}
+
+static void cache_lock(void) {
+        assert_se(pthread_once(&cache_atfork_once, cache_atfork_register) == 0);
+        assert_se(pthread_mutex_lock(&cache_mutex) == 0);
+}
+
+static void cache_unlock(void) {
+        assert_se(pthread_mutex_unlock(&cache_mutex) == 0);
+}
+
+int userdb_cache_get(const char *key, JsonVariant **ret) {
+        _cleanup_free_ char *text = NULL;
+        CacheEntry *e;
+        bool hit = false, negative = false;
+
+        assert(key);
+        assert(ret);
+
+        /* Returns > 0 and the cached object on a hit, -ESRCH if a negative lookup is cached, and 0 on a
+         * miss. */
+
+        cache_lock();
+
+        e = ordered_hashmap_get(cache, key);
+        if (e && e->until <= now(CLOCK_MONOTONIC)) {
+                ordered_hashmap_remove(cache, key);
+                cache_entry_free(e);
+                e = NULL;
+        }
+        if (e) {
+                hit = true;
+                negative = !e->text;
+                text = strdup(strempty(e->text));
+        }
+
+        cache_unlock();
+
+        if (!hit)
+                return 0;
+        if (!text)
+                return -ENOMEM;
+        if (negative)
+                return -ESRCH;
+
+        /* Parse it outside of the lock, so that the object isn't shared with anyone */
+        return json_parse(text, 0, ret, NULL, NULL) < 0 ? 0 : 1;
+}
+
+int userdb_cache_put(const char *key, JsonVariant *v) {
+        _cleanup_(cache_entry_freep) CacheEntry *e = NULL;
+        CacheEntry *old;
+        int r;
+
+        assert(key);
+
+        e = new(CacheEntry, 1);
+        if (!e)
+                return -ENOMEM;
+
+        *e = (CacheEntry) {
+                .key = strdup(key),
+        };
+        if (!e->key)
+                return -ENOMEM;
+
+        if (v) {
+                r = json_variant_format(v, 0, &e->text);
+                if (r < 0)
+                        return r;
+        }
+
+        cache_lock();
+
+        if (cache_ttl == 0) {
+                r = 0;
+                goto finish;
+        }
+
+        e->until = usec_add(now(CLOCK_MONOTONIC), cache_ttl);
+
+        old = ordered_hashmap_remove(cache, key);
+        cache_entry_free(old);
+
+        if (ordered_hashmap_size(cache) >= USERDB_CACHE_MAX)
+                cache_entry_free(ordered_hashmap_steal_first(cache));
+
+        r = ordered_hashmap_ensure_put(&cache, &cache_hash_ops, e->key, e);
+        if (r >= 0) {
+                TAKE_PTR(e);
+                r = 1;
+        }
+
+finish:
+        cache_unlock();
+        return r;
+}
+
+void userdb_cache_set_ttl(usec_t ttl) {
+        cache_lock();
+
+        cache_ttl = ttl;
+        if (ttl == 0)
+                cache = ordered_hashmap_free(cache);
+
+        cache_unlock();
+}
+
+void userdb_cache_flush(void) {
+        cache_lock();
+
+        cache = ordered_hashmap_free(cache);
+
+        cache_unlock();
+}
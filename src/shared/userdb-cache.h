@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+#pragma once
+
+#include "json.h"
+#include "time-util.h"
+
+/* A small in-process cache for userdb lookups, shared by all threads. Entries are stored in serialized
+ * form, hence everything returned from here is private to the caller. */
+
+#define USERDB_CACHE_TTL_DEFAULT_USEC (5 * USEC_PER_SEC)
+
+int userdb_cache_get(const char *key, JsonVariant **ret);
+int userdb_cache_put(const char *key, JsonVariant *v);
+
+/* Pass 0 to turn caching off */
+void userdb_cache_set_ttl(usec_t ttl);
+void userdb_cache_flush(void);
@@ -12,9 +12,11 @@
 #include "parse-util.h"
 #include "set.h"
 #include "socket-util.h"
+#include "stdio-util.h"
 #include "strv.h"
 #include "user-record-nss.h"
 #include "user-util.h"
+#include "userdb-cache.h"
 #include "userdb-dropin.h"
 #include "userdb.h"
 #include "varlink.h"
@@ -618,7 +620,170 @@ static int synthetic_nobody_user_build(UserRecord **ret) {
                                           JSON_BUILD_PAIR("disposition", JSON_BUILD_STRING("intrinsic"))));
 }
 
-int userdb_by_name(const char *name, UserDBFlags flags, UserRecord **ret) {
+static char* userdb_cache_key(const char *kind, UserDBFlags flags, const char *id) {
+        char *k;
+
+        /* The result depends on where we looked, hence the flags are part of the key */
+        if (asprintf(&k, "%s:%x:%s", kind, (unsigned) (flags & ~USERDB_CACHE), id) < 0)
+                return NULL;
+
+        return k;
+}
+
+static int record_cache_get(const char *key, JsonVariant **ret_record, bool *ret_incomplete) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        JsonVariant *record, *incomplete;
+        int r;
+
+        r = userdb_cache_get(key, &v);
+        if (r <= 0)
+                return r;
+
+        record = json_variant_by_key(v, "record");
+        incomplete = json_variant_by_key(v, "incomplete");
+        if (!record || !incomplete || !json_variant_is_boolean(incomplete))
+                return 0;
+
+        *ret_record = json_variant_ref(record);
+        *ret_incomplete = json_variant_boolean(incomplete);
+        return 1;
+}
+
+static void record_cache_put(const char *key, int error, JsonVariant *record, UserRecordMask mask, bool incomplete) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+
+        /* Only remember that a record doesn't exist, other errors might be temporary */
+        if (error == -ESRCH) {
+                (void) userdb_cache_put(key, NULL);
+                return;
+        }
+        if (error < 0)
+                return;
+
+        /* Don't keep secrets around in memory any longer than necessary */
+        if (FLAGS_SET(mask, USER_RECORD_SECRET))
+                return;
+
+        if (json_build(&v, JSON_BUILD_OBJECT(
+                                       JSON_BUILD_PAIR("record", JSON_BUILD_VARIANT(record)),
+                                       JSON_BUILD_PAIR("incomplete", JSON_BUILD_BOOLEAN(incomplete)))) < 0)
+                return;
+
+        (void) userdb_cache_put(key, v);
+}
+
+static int user_record_cache_get(const char *key, UserRecord **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *record = NULL;
+        _cleanup_(user_record_unrefp) UserRecord *hr = NULL;
+        bool incomplete;
+        int r;
+
+        assert(key);
+        assert(ret);
+
+        r = record_cache_get(key, &record, &incomplete);
+        if (r <= 0)
+                return r;
+
+        hr = user_record_new();
+        if (!hr)
+                return -ENOMEM;
+
+        /* If this fails for whatever reason, just look it up again */
+        if (user_record_load(hr, record, USER_RECORD_LOAD_REFUSE_SECRET|USER_RECORD_PERMISSIVE) < 0)
+                return 0;
+
+        hr->incomplete = incomplete;
+
+        *ret = TAKE_PTR(hr);
+        return 1;
+}
+
+static int group_record_cache_get(const char *key, GroupRecord **ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *record = NULL;
+        _cleanup_(group_record_unrefp) GroupRecord *g = NULL;
+        bool incomplete;
+        int r;
+
+        assert(key);
+        assert(ret);
+
+        r = record_cache_get(key, &record, &incomplete);
+        if (r <= 0)
+                return r;
+
+        g = group_record_new();
+        if (!g)
+                return -ENOMEM;
+
+        if (group_record_load(g, record, USER_RECORD_LOAD_REFUSE_SECRET|USER_RECORD_PERMISSIVE) < 0)
+                return 0;
+
+        g->incomplete = incomplete;
+
+        *ret = TAKE_PTR(g);
+        return 1;
+}
+
+static int user_record_lookup_cached(
+                const char *kind,
+                const char *id,
+                int (*lookup)(const void *userdata, UserDBFlags flags, UserRecord **ret),
+                const void *userdata,
+                UserDBFlags flags,
+                UserRecord **ret) {
+
+        _cleanup_(user_record_unrefp) UserRecord *hr = NULL;
+        _cleanup_free_ char *key = NULL;
+        int r;
+
+        key = userdb_cache_key(kind, flags, id);
+        if (!key)
+                return -ENOMEM;
+
+        r = user_record_cache_get(key, &hr);
+        if (r == 0) {
+                r = lookup(userdata, flags, &hr);
+                record_cache_put(key, r, hr ? hr->json : NULL, hr ? hr->mask : 0, hr && hr->incomplete);
+        }
+        if (r < 0)
+                return r;
+
+        if (ret)
+                *ret = TAKE_PTR(hr);
+        return 0;
+}
+
+static int group_record_lookup_cached(
+                const char *kind,
+                const char *id,
+                int (*lookup)(const void *userdata, UserDBFlags flags, GroupRecord **ret),
+                const void *userdata,
+                UserDBFlags flags,
+                GroupRecord **ret) {
+
+        _cleanup_(group_record_unrefp) GroupRecord *g = NULL;
+        _cleanup_free_ char *key = NULL;
+        int r;
+
+        key = userdb_cache_key(kind, flags, id);
+        if (!key)
+                return -ENOMEM;
+
+        r = group_record_cache_get(key, &g);
+        if (r == 0) {
+                r = lookup(userdata, flags, &g);
+                record_cache_put(key, r, g ? g->json : NULL, g ? g->mask : 0, g && g->incomplete);
+        }
+        if (r < 0)
+                return r;
+
+        if (ret)
+                *ret = TAKE_PTR(g);
+        return 0;
+}
+
+static int userdb_by_name_uncached(const char *name, UserDBFlags flags, UserRecord **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *query = NULL;
         int r;
@@ -671,7 +836,21 @@ int userdb_by_name(const char *name, UserDBFlags flags, UserRecord **ret) {
         return r;
 }
 
-int userdb_by_uid(uid_t uid, UserDBFlags flags, UserRecord **ret) {
+static int userdb_by_name_lookup(const void *userdata, UserDBFlags flags, UserRecord **ret) {
+        return userdb_by_name_uncached(userdata, flags, ret);
+}
+
+int userdb_by_name(const char *name, UserDBFlags flags, UserRecord **ret) {
+        if (!FLAGS_SET(flags, USERDB_CACHE))
+                return userdb_by_name_uncached(name, flags, ret);
+
+        if (!valid_user_group_name(name, VALID_USER_RELAX))
+                return -EINVAL;
+
+        return user_record_lookup_cached("user-name", name, userdb_by_name_lookup, name, flags, ret);
+}
+
+static int userdb_by_uid_uncached(uid_t uid, UserDBFlags flags, UserRecord **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *query = NULL;
         int r;
@@ -722,6 +901,23 @@ int userdb_by_uid(uid_t uid, UserDBFlags flags, UserRecord **ret) {
         return r;
 }
 
+static int userdb_by_uid_lookup(const void *userdata, UserDBFlags flags, UserRecord **ret) {
+        return userdb_by_uid_uncached(*(const uid_t*) userdata, flags, ret);
+}
+
+int userdb_by_uid(uid_t uid, UserDBFlags flags, UserRecord **ret) {
+        char id[DECIMAL_STR_MAX(uid_t)];
+
+        if (!FLAGS_SET(flags, USERDB_CACHE))
+                return userdb_by_uid_uncached(uid, flags, ret);
+
+        if (!uid_is_valid(uid))
+                return -EINVAL;
+
+        xsprintf(id, UID_FMT, uid);
+        return user_record_lookup_cached("user-uid", id, userdb_by_uid_lookup, &uid, flags, ret);
+}
+
 int userdb_all(UserDBFlags flags, UserDBIterator **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         int r, qr;
@@ -891,7 +1087,7 @@ static int synthetic_nobody_group_build(GroupRecord **ret) {
                                           JSON_BUILD_PAIR("disposition", JSON_BUILD_STRING("intrinsic"))));
 }
 
-int groupdb_by_name(const char *name, UserDBFlags flags, GroupRecord **ret) {
+static int groupdb_by_name_uncached(const char *name, UserDBFlags flags, GroupRecord **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *query = NULL;
         int r;
@@ -942,7 +1138,21 @@ int groupdb_by_name(const char *name, UserDBFlags flags, GroupRecord **ret) {
         return r;
 }
 
-int groupdb_by_gid(gid_t gid, UserDBFlags flags, GroupRecord **ret) {
+static int groupdb_by_name_lookup(const void *userdata, UserDBFlags flags, GroupRecord **ret) {
+        return groupdb_by_name_uncached(userdata, flags, ret);
+}
+
+int groupdb_by_name(const char *name, UserDBFlags flags, GroupRecord **ret) {
+        if (!FLAGS_SET(flags, USERDB_CACHE))
+                return groupdb_by_name_uncached(name, flags, ret);
+
+        if (!valid_user_group_name(name, VALID_USER_RELAX))
+                return -EINVAL;
+
+        return group_record_lookup_cached("group-name", name, groupdb_by_name_lookup, name, flags, ret);
+}
+
+static int groupdb_by_gid_uncached(gid_t gid, UserDBFlags flags, GroupRecord **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *query = NULL;
         int r;
@@ -992,6 +1202,23 @@ int groupdb_by_gid(gid_t gid, UserDBFlags flags, GroupRecord **ret) {
         return r;
 }
 
+static int groupdb_by_gid_lookup(const void *userdata, UserDBFlags flags, GroupRecord **ret) {
+        return groupdb_by_gid_uncached(*(const gid_t*) userdata, flags, ret);
+}
+
+int groupdb_by_gid(gid_t gid, UserDBFlags flags, GroupRecord **ret) {
+        char id[DECIMAL_STR_MAX(gid_t)];
+
+        if (!FLAGS_SET(flags, USERDB_CACHE))
+                return groupdb_by_gid_uncached(gid, flags, ret);
+
+        if (!gid_is_valid(gid))
+                return -EINVAL;
+
+        xsprintf(id, GID_FMT, gid);
+        return group_record_lookup_cached("group-gid", id, groupdb_by_gid_lookup, &gid, flags, ret);
+}
+
 int groupdb_all(UserDBFlags flags, UserDBIterator **ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         int r, qr;
@@ -1135,7 +1362,30 @@ int groupdb_iterator_get(UserDBIterator *iterator, GroupRecord **ret) {
         return r;
 }
 
+static bool membership_dropin_matches(const char *fn, const char *user, const char *group) {
+        const char *e, *c;
+
+        e = endswith(fn, ".membership");
+        if (!e)
+                return false;
+
+        c = memchr(fn, ':', e - fn);
+        if (!c)
+                return false;
+
+        if (user && (strlen(user) != (size_t) (c - fn) || !strneq(fn, user, c - fn)))
+                return false;
+
+        c++; /* skip over ':' */
+        if (group && (strlen(group) != (size_t) (e - c) || !strneq(c, group, e - c)))
+                return false;
+
+        return true;
+}
+
 static void discover_membership_dropins(UserDBIterator *i, UserDBFlags flags) {
+        size_t k = 0;
+        char **d;
         int r;
 
         r = conf_files_list_nulstr(
@@ -1144,8 +1394,24 @@ static void discover_membership_dropins(UserDBIterator *i, UserDBFlags flags) {
                         NULL,
                         CONF_FILES_REGULAR|CONF_FILES_BASENAME|CONF_FILES_FILTER_MASKED,
                         USERDB_DROPIN_DIR_NULSTR("userdb"));
-        if (r < 0)
+        if (r < 0) {
                 log_debug_errno(r, "Failed to find membership drop-ins, ignoring: %m");
+                return;
+        }
+
+        if (!i->filter_user_name && !i->filter_group_name)
+                return;
+
+        /* The drop-in names are "<user>:<group>.membership", i.e. the file list is an index already. Drop
+         * everything that can't match right away, so that the iterator doesn't have to look at it again. */
+        STRV_FOREACH(d, i->dropins) {
+                if (membership_dropin_matches(*d, i->filter_user_name, i->filter_group_name))
+                        i->dropins[k++] = *d;
+                else
+                        free(*d);
+        }
+        if (i->dropins)
+                i->dropins[k] = NULL;
 }
 
 int membershipdb_by_user(const char *name, UserDBFlags flags, UserDBIterator **ret) {
@@ -1418,7 +1684,7 @@ int membershipdb_iterator_get(
         return r;
 }
 
-int membershipdb_by_group_strv(const char *name, UserDBFlags flags, char ***ret) {
+static int membershipdb_by_group_strv_uncached(const char *name, UserDBFlags flags, char ***ret) {
         _cleanup_(userdb_iterator_freep) UserDBIterator *iterator = NULL;
         _cleanup_strv_free_ char **members = NULL;
         int r;
@@ -1451,6 +1717,37 @@ int membershipdb_by_group_strv(const char *name, UserDBFlags flags, char ***ret)
         return 0;
 }
 
+int membershipdb_by_group_strv(const char *name, UserDBFlags flags, char ***ret) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        _cleanup_strv_free_ char **members = NULL;
+        _cleanup_free_ char *key = NULL;
+        int r;
+
+        assert(name);
+        assert(ret);
+
+        if (!FLAGS_SET(flags, USERDB_CACHE))
+                return membershipdb_by_group_strv_uncached(name, flags, ret);
+
+        key = userdb_cache_key("members", flags, name);
+        if (!key)
+                return -ENOMEM;
+
+        if (userdb_cache_get(key, &v) > 0 && json_variant_strv(v, ret) >= 0)
+                return 0;
+
+        r = membershipdb_by_group_strv_uncached(name, flags, &members);
+        if (r < 0)
+                return r;
+
+        v = json_variant_unref(v);
+        if (json_variant_new_array_strv(&v, members) >= 0)
+                (void) userdb_cache_put(key, v);
+
+        *ret = TAKE_PTR(members);
+        return 0;
+}
+
 int userdb_block_nss_systemd(int b) {
         _cleanup_(dlclosep) void *dl = NULL;
         int (*call)(bool b);
@@ -27,6 +27,11 @@
 #define VARLINK_DEFAULT_TIMEOUT_USEC (45U*USEC_PER_SEC)
 #define VARLINK_BUFFER_MAX (16U*1024U*1024U)
 #define VARLINK_READ_SIZE (64U*1024U)
+#define VARLINK_WRITEV_MAX 64U
+
+/* Once this much output is queued up a server connection stops reading and dispatching further method
+ * calls, until the peer catches up */
+#define VARLINK_OUTPUT_HIGH_WATER_DEFAULT (1U*1024U*1024U)
 
 typedef enum VarlinkState {
         /* Client side states */
@@ -118,9 +123,15 @@ struct Varlink {
         size_t input_buffer_size;
         size_t input_buffer_unscanned;
 
-        char *output_buffer; /* valid data starts at output_buffer_index, ends at output_buffer_index+output_buffer_size */
-        size_t output_buffer_index;
+        /* Each queued message is kept in its own buffer, so that enqueuing never has to copy what is already
+         * pending. Valid entries start at output_queue_index, and the first output_queue_written bytes of the
+         * first one have already been sent. output_buffer_size is the total number of bytes not written yet. */
+        struct iovec *output_queue;
+        size_t output_queue_index;
+        size_t n_output_queue;
+        size_t output_queue_written;
         size_t output_buffer_size;
+        size_t output_high_water;
 
         VarlinkReply reply_callback;
 
@@ -262,7 +273,8 @@ static int varlink_new(Varlink **ret) {
                 .ucred.gid = GID_INVALID,
 
                 .timestamp = USEC_INFINITY,
-                .timeout = VARLINK_DEFAULT_TIMEOUT_USEC
+                .timeout = VARLINK_DEFAULT_TIMEOUT_USEC,
+                .output_high_water = VARLINK_OUTPUT_HIGH_WATER_DEFAULT,
         };
 
         *ret = v;
@@ -352,6 +364,17 @@ static void varlink_detach_event_sources(Varlink *v) {
         v->defer_event_source = sd_event_source_disable_unref(v->defer_event_source);
 }
 
+static void varlink_output_queue_clear(Varlink *v) {
+        assert(v);
+
+        for (size_t i = v->output_queue_index; i < v->n_output_queue; i++)
+                free(v->output_queue[i].iov_base);
+
+        v->output_queue = mfree(v->output_queue);
+        v->output_queue_index = v->n_output_queue = v->output_queue_written = 0;
+        v->output_buffer_size = 0;
+}
+
 static void varlink_clear(Varlink *v) {
         assert(v);
 
@@ -360,7 +383,7 @@ static void varlink_clear(Varlink *v) {
         v->fd = safe_close(v->fd);
 
         v->input_buffer = mfree(v->input_buffer);
-        v->output_buffer = mfree(v->output_buffer);
+        varlink_output_queue_clear(v);
 
         v->current = json_variant_unref(v->current);
         v->reply = json_variant_unref(v->reply);
@@ -429,7 +452,17 @@ disconnect:
         return 1;
 }
 
+static bool varlink_output_congested(Varlink *v) {
+        assert(v);
+
+        /* Only servers apply backpressure: a client that stopped reading replies because it has too much
+         * to send could deadlock against a server doing the same */
+        return v->state == VARLINK_IDLE_SERVER && v->output_buffer_size >= v->output_high_water;
+}
+
 static int varlink_write(Varlink *v) {
+        struct iovec iov[VARLINK_WRITEV_MAX];
+        size_t n_iov;
         ssize_t n;
 
         assert(v);
@@ -445,19 +478,31 @@ static int varlink_write(Varlink *v) {
                 return 0;
 
         assert(v->fd >= 0);
+        assert(v->output_queue_index < v->n_output_queue);
+
+        /* Hand as many queued messages as we can to the kernel in one go */
+        n_iov = MIN(v->n_output_queue - v->output_queue_index, VARLINK_WRITEV_MAX);
+        memcpy(iov, v->output_queue + v->output_queue_index, n_iov * sizeof(struct iovec));
+        iov[0].iov_base = (uint8_t*) iov[0].iov_base + v->output_queue_written;
+        iov[0].iov_len -= v->output_queue_written;
 
-        /* We generally prefer recv()/send() (mostly because of MSG_NOSIGNAL) but also want to be compatible
-         * with non-socket IO, hence fall back automatically.
+        /* We generally prefer recvmsg()/sendmsg() (mostly because of MSG_NOSIGNAL) but also want to be
+         * compatible with non-socket IO, hence fall back automatically.
          *
          * Use a local variable to help gcc figure out that we set 'n' in all cases. */
         bool prefer_write = v->prefer_read_write;
         if (!prefer_write) {
-                n = send(v->fd, v->output_buffer + v->output_buffer_index, v->output_buffer_size, MSG_DONTWAIT|MSG_NOSIGNAL);
+                struct msghdr mh = {
+                        .msg_iov = iov,
+                        .msg_iovlen = n_iov,
+                };
+
+                n = sendmsg(v->fd, &mh, MSG_DONTWAIT|MSG_NOSIGNAL);
                 if (n < 0 && errno == ENOTSOCK)
                         prefer_write = v->prefer_read_write = true;
         }
         if (prefer_write)
-                n = write(v->fd, v->output_buffer + v->output_buffer_index, v->output_buffer_size);
+                n = writev(v->fd, iov, n_iov);
         if (n < 0) {
                 if (errno == EAGAIN)
                         return 0;
@@ -472,12 +517,23 @@ static int varlink_write(Varlink *v) {
                 return -errno;
         }
 
+        assert((size_t) n <= v->output_buffer_size);
         v->output_buffer_size -= n;
 
-        if (v->output_buffer_size == 0)
-                v->output_buffer_index = 0;
-        else
-                v->output_buffer_index += n;
+        /* Release all messages that went out completely, and remember how far we got into the next one */
+        n += v->output_queue_written;
+        while (v->output_queue_index < v->n_output_queue &&
+               (size_t) n >= v->output_queue[v->output_queue_index].iov_len) {
+                n -= v->output_queue[v->output_queue_index].iov_len;
+                free(v->output_queue[v->output_queue_index].iov_base);
+                v->output_queue_index++;
+        }
+        v->output_queue_written = n;
+
+        if (v->output_queue_index >= v->n_output_queue) {
+                assert(v->output_buffer_size == 0);
+                v->output_queue_index = v->n_output_queue = v->output_queue_written = 0;
+        }
 
         v->timestamp = now(CLOCK_MONOTONIC);
         return 1;
@@ -499,6 +555,8 @@ static int varlink_read(Varlink *v) {
                 return 0;
         if (v->read_disconnected)
                 return 0;
+        if (varlink_output_congested(v))
+                return 0;
 
         if (v->input_buffer_size >= VARLINK_BUFFER_MAX)
                 return -ENOBUFS;
@@ -508,25 +566,18 @@ static int varlink_read(Varlink *v) {
         if (MALLOC_SIZEOF_SAFE(v->input_buffer) <= v->input_buffer_index + v->input_buffer_size) {
                 size_t add;
 
-                add = MIN(VARLINK_BUFFER_MAX - v->input_buffer_size, VARLINK_READ_SIZE);
-
-                if (v->input_buffer_index == 0) {
-
-                        if (!GREEDY_REALLOC(v->input_buffer, v->input_buffer_size + add))
-                                return -ENOMEM;
-
-                } else {
-                        char *b;
-
-                        b = new(char, v->input_buffer_size + add);
-                        if (!b)
-                                return -ENOMEM;
-
-                        memcpy(b, v->input_buffer + v->input_buffer_index, v->input_buffer_size);
-
-                        free_and_replace(v->input_buffer, b);
+                /* Move the unparsed rest to the front first, which often frees up enough room already.
+                 * The input has to stay contiguous, since each message is parsed in place. */
+                if (v->input_buffer_index > 0) {
+                        memmove(v->input_buffer, v->input_buffer + v->input_buffer_index, v->input_buffer_size);
                         v->input_buffer_index = 0;
                 }
+
+                add = MIN(VARLINK_BUFFER_MAX - v->input_buffer_size, VARLINK_READ_SIZE);
+
+                if (MALLOC_SIZEOF_SAFE(v->input_buffer) < v->input_buffer_size + add &&
+                    !GREEDY_REALLOC(v->input_buffer, v->input_buffer_size + add))
+                        return -ENOMEM;
         }
 
         rs = MALLOC_SIZEOF_SAFE(v->input_buffer) - (v->input_buffer_index + v->input_buffer_size);
@@ -795,6 +846,8 @@ static int varlink_dispatch_method(Varlink *v) {
                 return 0;
         if (!v->current)
                 return 0;
+        if (varlink_output_congested(v))
+                return 0;
 
         if (!json_variant_is_object(v->current))
                 goto invalid;
@@ -1100,7 +1153,8 @@ int varlink_get_events(Varlink *v) {
         if (!v->read_disconnected &&
             IN_SET(v->state, VARLINK_AWAITING_REPLY, VARLINK_AWAITING_REPLY_MORE, VARLINK_CALLING, VARLINK_IDLE_SERVER) &&
             !v->current &&
-            v->input_buffer_unscanned <= 0)
+            v->input_buffer_unscanned <= 0 &&
+            !varlink_output_congested(v))
                 ret |= EPOLLIN;
 
         if (!v->write_disconnected &&
@@ -1250,35 +1304,23 @@ static int varlink_enqueue_json(Varlink *v, JsonVariant *m) {
 
         varlink_log(v, "Sending message: %s", text);
 
-        if (v->output_buffer_size == 0) {
-
-                free_and_replace(v->output_buffer, text);
-
-                v->output_buffer_size = r + 1;
-                v->output_buffer_index = 0;
-
-        } else if (v->output_buffer_index == 0) {
-
-                if (!GREEDY_REALLOC(v->output_buffer, v->output_buffer_size + r + 1))
-                        return -ENOMEM;
-
-                memcpy(v->output_buffer + v->output_buffer_size, text, r + 1);
-                v->output_buffer_size += r + 1;
-
-        } else {
-                char *n;
-                const size_t new_size = v->output_buffer_size + r + 1;
-
-                n = new(char, new_size);
-                if (!n)
-                        return -ENOMEM;
+        /* Drop the pointers to messages written out already before growing the queue, so it stays
+         * bounded by what is actually pending */
+        if (v->n_output_queue >= MALLOC_ELEMENTSOF(v->output_queue) &&
+            v->output_queue_index > 0 &&
+            v->output_queue_index >= v->n_output_queue / 2) {
+                memmove(v->output_queue, v->output_queue + v->output_queue_index,
+                        (v->n_output_queue - v->output_queue_index) * sizeof(struct iovec));
+                v->n_output_queue -= v->output_queue_index;
+                v->output_queue_index = 0;
+        }
 
-                memcpy(mempcpy(n, v->output_buffer + v->output_buffer_index, v->output_buffer_size), text, r + 1);
+        if (!GREEDY_REALLOC(v->output_queue, v->n_output_queue + 1))
+                return -ENOMEM;
 
-                free_and_replace(v->output_buffer, n);
-                v->output_buffer_size = new_size;
-                v->output_buffer_index = 0;
-        }
+        /* The trailing NUL byte is the message separator, hence send it along */
+        v->output_queue[v->n_output_queue++] = IOVEC_MAKE(TAKE_PTR(text), r + 1);
+        v->output_buffer_size += r + 1;
 
         return 0;
 }
@@ -1819,6 +1861,14 @@ int varlink_set_relative_timeout(Varlink *v, usec_t timeout) {
         return 0;
 }
 
+int varlink_set_output_high_water(Varlink *v, size_t size) {
+        assert_return(v, -EINVAL);
+        assert_return(size > 0, -EINVAL);
+
+        v->output_high_water = size;
+        return 0;
+}
+
 VarlinkServer *varlink_get_server(Varlink *v) {
         assert_return(v, NULL);
 
@@ -118,6 +118,9 @@ int varlink_get_peer_pid(Varlink *v, pid_t *ret);
 
 int varlink_set_relative_timeout(Varlink *v, usec_t usec);
 
+/* Pause reading further method calls on a server connection while this many bytes of replies are queued */
+int varlink_set_output_high_water(Varlink *v, size_t size);
+
 VarlinkServer* varlink_get_server(Varlink *v);
 
 int varlink_set_description(Varlink *v, const char *d);
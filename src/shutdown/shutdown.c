@@ -269,6 +269,13 @@ static void sync_with_progress(void) {
         (void) kill(pid, SIGKILL);
 }
 
+static void log_phase_duration(const char *phase, usec_t begin) {
+        char buf[FORMAT_TIMESPAN_MAX];
+
+        log_debug("%s took %s.", phase,
+                  format_timespan(buf, sizeof(buf), usec_sub_unsigned(now(CLOCK_MONOTONIC), begin), USEC_PER_MSEC));
+}
+
 static int read_current_sysctl_printk_log_level(void) {
         _cleanup_free_ char *sysctl_printk_vals = NULL, *sysctl_printk_curr = NULL;
         int current_lvl;
@@ -408,6 +415,7 @@ int main(int argc, char *argv[]) {
         /* Unmount all mountpoints, swaps, and loopback devices */
         for (;;) {
                 bool changed = false;
+                usec_t ts;
 
                 if (use_watchdog)
                         (void) watchdog_ping();
@@ -421,7 +429,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_umount) {
                         log_info("Unmounting file systems.");
+                        ts = now(CLOCK_MONOTONIC);
                         r = umount_all(&changed, umount_log_level);
+                        log_phase_duration("Unmounting file systems", ts);
                         if (r == 0) {
                                 need_umount = false;
                                 log_info("All filesystems unmounted.");
@@ -433,7 +443,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_swapoff) {
                         log_info("Deactivating swaps.");
+                        ts = now(CLOCK_MONOTONIC);
                         r = swapoff_all(&changed);
+                        log_phase_duration("Deactivating swaps", ts);
                         if (r == 0) {
                                 need_swapoff = false;
                                 log_info("All swaps deactivated.");
@@ -445,7 +457,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_loop_detach) {
                         log_info("Detaching loop devices.");
+                        ts = now(CLOCK_MONOTONIC);
                         r = loopback_detach_all(&changed, umount_log_level);
+                        log_phase_duration("Detaching loop devices", ts);
                         if (r == 0) {
                                 need_loop_detach = false;
                                 log_info("All loop devices detached.");
@@ -457,7 +471,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_md_detach) {
                         log_info("Stopping MD devices.");
+                        ts = now(CLOCK_MONOTONIC);
                         r = md_detach_all(&changed, umount_log_level);
+                        log_phase_duration("Stopping MD devices", ts);
                         if (r == 0) {
                                 need_md_detach = false;
                                 log_info("All MD devices stopped.");
@@ -469,7 +485,9 @@ int main(int argc, char *argv[]) {
 
                 if (need_dm_detach) {
                         log_info("Detaching DM devices.");
+                        ts = now(CLOCK_MONOTONIC);
                         r = dm_detach_all(&changed, umount_log_level);
+                        log_phase_duration("Detaching DM devices", ts);
                         if (r == 0) {
                                 need_dm_detach = false;
                                 log_info("All DM devices detached.");
@@ -405,7 +405,7 @@ static int strverscmp_improvedp(char *const* a, char *const* b) {
 
 static int validate_version(
                 const char *root,
-                const Image *img,
+                Image *img,
                 const char *host_os_release_id,
                 const char *host_os_release_version_id,
                 const char *host_os_release_sysext_level) {
@@ -431,6 +431,14 @@ static int validate_version(
                 return log_error_errno(SYNTHETIC_ERRNO(EINVAL),
                                        "Extension image contains /usr/lib/os-release file, which is not allowed (it may carry /etc/os-release), refusing.");
 
+        /* The image is mounted at this point already, hence read its extension-release file from the
+         * mounted tree, rather than dissecting and mounting it a second time via image_read_metadata(). */
+        if (!img->metadata_valid) {
+                r = load_extension_release_pairs(root, img->name, &img->extension_release);
+                if (r < 0)
+                        log_debug_errno(r, "Failed to read extension-release of image %s, ignoring: %m", img->name);
+        }
+
         return extension_release_validate(
                         img->name,
                         host_os_release_id,
@@ -717,9 +725,8 @@ static int merge(Hashmap *images) {
         return r != 123; /* exit code 123 means: didn't do anything */
 }
 
-static int image_discover_and_read_metadata(Hashmap **ret_images) {
+static int image_discover_extensions(Hashmap **ret_images) {
         _cleanup_(hashmap_freep) Hashmap *images = NULL;
-        Image *img;
         int r;
 
         assert(ret_images);
@@ -732,12 +739,6 @@ static int image_discover_and_read_metadata(Hashmap **ret_images) {
         if (r < 0)
                 return log_error_errno(r, "Failed to discover extension images: %m");
 
-        HASHMAP_FOREACH(img, images) {
-                r = image_read_metadata(img);
-                if (r < 0)
-                        return log_error_errno(r, "Failed to read metadata for image %s: %m", img->name);
-        }
-
         *ret_images = TAKE_PTR(images);
 
         return 0;
@@ -751,7 +752,7 @@ static int verb_merge(int argc, char **argv, void *userdata) {
         if (!have_effective_cap(CAP_SYS_ADMIN))
                 return log_error_errno(SYNTHETIC_ERRNO(EPERM), "Need to be privileged.");
 
-        r = image_discover_and_read_metadata(&images);
+        r = image_discover_extensions(&images);
         if (r < 0)
                 return r;
 
@@ -786,7 +787,7 @@ static int verb_refresh(int argc, char **argv, void *userdata) {
         if (!have_effective_cap(CAP_SYS_ADMIN))
                 return log_error_errno(SYNTHETIC_ERRNO(EPERM), "Need to be privileged.");
 
-        r = image_discover_and_read_metadata(&images);
+        r = image_discover_extensions(&images);
         if (r < 0)
                 return r;
 
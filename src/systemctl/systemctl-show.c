@@ -1779,6 +1779,7 @@ static int show_one(
                 const char *path,
                 const char *unit,
                 SystemctlShowMode show_mode,
+                sd_bus_message *prefetched,
                 bool *new_line,
                 bool *ellipsized) {
 
@@ -1902,15 +1903,29 @@ static int show_one(
 
         log_debug("Showing one %s", path);
 
-        r = bus_map_all_properties(
-                        bus,
-                        "org.freedesktop.systemd1",
-                        path,
-                        show_mode == SYSTEMCTL_SHOW_STATUS ? status_map : property_map,
-                        BUS_MAP_BOOLEAN_AS_BOOL,
-                        &error,
-                        &reply,
-                        &info);
+        if (prefetched) {
+                /* The reply to GetAll() was already requested for us, possibly an error */
+                reply = sd_bus_message_ref(prefetched);
+
+                if (sd_bus_message_is_method_error(reply, NULL))
+                        r = sd_bus_error_copy(&error, sd_bus_message_get_error(reply));
+                else
+                        r = bus_message_map_all_properties(
+                                        reply,
+                                        show_mode == SYSTEMCTL_SHOW_STATUS ? status_map : property_map,
+                                        BUS_MAP_BOOLEAN_AS_BOOL,
+                                        &error,
+                                        &info);
+        } else
+                r = bus_map_all_properties(
+                                bus,
+                                "org.freedesktop.systemd1",
+                                path,
+                                show_mode == SYSTEMCTL_SHOW_STATUS ? status_map : property_map,
+                                BUS_MAP_BOOLEAN_AS_BOOL,
+                                &error,
+                                &reply,
+                                &info);
         if (r < 0)
                 return log_error_errno(r, "Failed to get properties: %s", bus_error_message(&error, r));
 
@@ -1983,6 +1998,61 @@ static int get_unit_dbus_path_by_pid(
         return 0;
 }
 
+typedef struct ShowContext {
+        sd_bus *bus;
+        char **paths;
+        char **units;
+        SystemctlShowMode show_mode;
+        bool *new_line;
+        bool *ellipsized;
+        int ret;
+} ShowContext;
+
+static int show_one_prefetched(sd_bus_message *reply, size_t idx, void *userdata) {
+        ShowContext *c = userdata;
+        int r;
+
+        assert(c);
+
+        r = show_one(c->bus, c->paths[idx], c->units[idx], c->show_mode, reply, c->new_line, c->ellipsized);
+        if (r < 0)
+                return r;
+        if (r > 0 && c->ret == 0)
+                c->ret = r;
+
+        return 0;
+}
+
+static int show_many(
+                sd_bus *bus,
+                char **paths,
+                char **units,
+                SystemctlShowMode show_mode,
+                bool *new_line,
+                bool *ellipsized) {
+
+        ShowContext c = {
+                .bus = bus,
+                .paths = paths,
+                .units = units,
+                .show_mode = show_mode,
+                .new_line = new_line,
+                .ellipsized = ellipsized,
+        };
+        int r;
+
+        assert(strv_length(paths) == strv_length(units));
+
+        /* Request the properties of the next few units while we are still busy showing the current one,
+         * so that we don't wait for a full round trip for every unit, which adds up on remote
+         * connections. */
+        r = bus_get_all_properties_many(bus, "org.freedesktop.systemd1", paths, NULL, 16, show_one_prefetched, &c);
+        if (r < 0)
+                return r;
+
+        return c.ret;
+}
+
 static int show_all(
                 sd_bus *bus,
                 bool *new_line,
@@ -1990,8 +2060,9 @@ static int show_all(
 
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
         _cleanup_free_ UnitInfo *unit_infos = NULL;
+        _cleanup_strv_free_ char **paths = NULL, **units = NULL;
         unsigned c;
-        int r, ret = 0;
+        int r;
 
         r = get_unit_list(bus, NULL, NULL, &unit_infos, 0, &reply);
         if (r < 0)
@@ -2004,20 +2075,18 @@ static int show_all(
         typesafe_qsort(unit_infos, c, unit_info_compare);
 
         for (const UnitInfo *u = unit_infos; u < unit_infos + c; u++) {
-                _cleanup_free_ char *p = NULL;
+                char *p;
 
                 p = unit_dbus_path_from_name(u->id);
                 if (!p)
                         return log_oom();
 
-                r = show_one(bus, p, u->id, SYSTEMCTL_SHOW_STATUS, new_line, ellipsized);
-                if (r < 0)
-                        return r;
-                else if (r > 0 && ret == 0)
-                        ret = r;
+                if (strv_consume(&paths, p) < 0 ||
+                    strv_extend(&units, u->id) < 0)
+                        return log_oom();
         }
 
-        return ret;
+        return show_many(bus, paths, units, SYSTEMCTL_SHOW_STATUS, new_line, ellipsized);
 }
 
 static int show_system_status(sd_bus *bus) {
@@ -2111,7 +2180,7 @@ int show(int argc, char *argv[], void *userdata) {
 
         /* If no argument is specified inspect the manager itself */
         if (show_mode == SYSTEMCTL_SHOW_PROPERTIES && argc <= 1)
-                return show_one(bus, "/org/freedesktop/systemd1", NULL, show_mode, &new_line, &ellipsized);
+                return show_one(bus, "/org/freedesktop/systemd1", NULL, show_mode, NULL, &new_line, &ellipsized);
 
         if (show_mode == SYSTEMCTL_SHOW_STATUS && argc <= 1) {
 
@@ -2151,7 +2220,7 @@ int show(int argc, char *argv[], void *userdata) {
                                         return log_oom();
                         }
 
-                        r = show_one(bus, path, unit, show_mode, &new_line, &ellipsized);
+                        r = show_one(bus, path, unit, show_mode, NULL, &new_line, &ellipsized);
                         if (r < 0)
                                 return r;
                         else if (r > 0 && ret == 0)
@@ -2159,7 +2228,7 @@ int show(int argc, char *argv[], void *userdata) {
                 }
 
                 if (!strv_isempty(patterns)) {
-                        _cleanup_strv_free_ char **names = NULL;
+                        _cleanup_strv_free_ char **names = NULL, **paths = NULL;
 
                         r = expand_unit_names(bus, patterns, NULL, &names, NULL);
                         if (r < 0)
@@ -2170,18 +2239,21 @@ int show(int argc, char *argv[], void *userdata) {
                                 return r;
 
                         STRV_FOREACH(name, names) {
-                                _cleanup_free_ char *path = NULL;
+                                char *path;
 
                                 path = unit_dbus_path_from_name(*name);
                                 if (!path)
                                         return log_oom();
 
-                                r = show_one(bus, path, *name, show_mode, &new_line, &ellipsized);
-                                if (r < 0)
-                                        return r;
-                                if (r > 0 && ret == 0)
-                                        ret = r;
+                                if (strv_consume(&paths, path) < 0)
+                                        return log_oom();
                         }
+
+                        r = show_many(bus, paths, names, show_mode, &new_line, &ellipsized);
+                        if (r < 0)
+                                return r;
+                        if (r > 0 && ret == 0)
+                                ret = r;
                 }
         }
 
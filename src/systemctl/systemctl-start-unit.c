@@ -15,6 +15,10 @@
 #include "systemctl-util.h"
 #include "systemctl.h"
 #include "terminal-util.h"
+#include "unit-def.h"
+
+/* How many job requests to have in flight at the same time when operating on many units at once */
+#define START_UNIT_PIPELINE_MAX 64U
 
 static const struct {
         const char *verb;      /* systemctl verb */
@@ -51,6 +55,24 @@ static const char *verb_to_job_type(const char *verb) {
        return "start";
 }
 
+static int log_start_unit_failure(const char *job_type, const char *name, const sd_bus_error *error, int r) {
+        assert(job_type);
+        assert(name);
+
+        log_error_errno(r, "Failed to %s %s: %s", job_type, name, bus_error_message(error, r));
+
+        if (!sd_bus_error_has_names(error, BUS_ERROR_NO_SUCH_UNIT,
+                                           BUS_ERROR_UNIT_MASKED,
+                                           BUS_ERROR_JOB_TYPE_NOT_APPLICABLE))
+                log_error("See %s logs and 'systemctl%s status%s %s' for details.",
+                          arg_scope == UNIT_FILE_SYSTEM ? "system" : "user",
+                          arg_scope == UNIT_FILE_SYSTEM ? "" : " --user",
+                          name[0] == '-' ? " --" : "",
+                          name);
+
+        return r;
+}
+
 static int start_unit_one(
                 sd_bus *bus,
                 const char *method,    /* When using classic per-job bus methods */
@@ -162,18 +184,215 @@ fail:
         if (arg_action != ACTION_SYSTEMCTL)
                 return r;
 
-        log_error_errno(r, "Failed to %s %s: %s", job_type, name, bus_error_message(error, r));
+        return log_start_unit_failure(job_type, name, error, r);
+}
 
-        if (!sd_bus_error_has_names(error, BUS_ERROR_NO_SUCH_UNIT,
-                                           BUS_ERROR_UNIT_MASKED,
-                                           BUS_ERROR_JOB_TYPE_NOT_APPLICABLE))
-                log_error("See %s logs and 'systemctl%s status%s %s' for details.",
-                          arg_scope == UNIT_FILE_SYSTEM ? "system" : "user",
-                          arg_scope == UNIT_FILE_SYSTEM ? "" : " --user",
-                          name[0] == '-' ? " --" : "",
-                          name);
+typedef struct StartUnitPipeline {
+        const char *job_type;
+        const char *mode;
+        BusWaitForJobs *w;
+        BusWaitForUnits *wu;
+        size_t n_pending;
+        bool check_reload;
+} StartUnitPipeline;
+
+typedef struct StartUnitCall {
+        StartUnitPipeline *pipeline;
+        char *name; /* borrowed from the caller's strv */
+        sd_bus_slot *slot;
+        sd_bus_slot *reload_slot;
+        sd_bus_error error;
+        int r;
+} StartUnitCall;
 
-        return r;
+static int on_need_daemon_reload_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        StartUnitCall *c = userdata;
+        int b, r;
+
+        assert(m);
+        assert(c);
+
+        c->pipeline->n_pending--;
+
+        /* Errors are ignored here, like need_daemon_reload() does, since this is used to show a warning only */
+        if (sd_bus_message_is_method_error(m, NULL))
+                return 0;
+
+        r = sd_bus_message_read(m, "v", "b", &b);
+        if (r < 0)
+                return 0;
+
+        if (b)
+                warn_unit_file_changed(c->name);
+
+        return 0;
+}
+
+static int on_start_unit_reply(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        StartUnitCall *c = userdata;
+        StartUnitPipeline *p;
+        _cleanup_free_ char *unit_path = NULL;
+        const char *path;
+        int r;
+
+        assert(m);
+        assert(c);
+
+        p = c->pipeline;
+        p->n_pending--;
+
+        if (sd_bus_message_is_method_error(m, NULL)) {
+                (void) sd_bus_error_copy(&c->error, sd_bus_message_get_error(m));
+                c->r = log_start_unit_failure(p->job_type, c->name, &c->error, -sd_bus_message_get_errno(m));
+                return 0;
+        }
+
+        r = sd_bus_message_read(m, "o", &path);
+        if (r < 0)
+                return c->r = bus_log_parse_error(r);
+
+        /* The job needs to be watched right away, i.e. before the bus is dispatched any further, so that
+         * its JobRemoved signal isn't missed. */
+        if (p->w) {
+                log_debug("Adding %s to the set", path);
+                r = bus_wait_for_jobs_add(p->w, path);
+                if (r < 0)
+                        return c->r = log_error_errno(r, "Failed to watch job for %s: %m", c->name);
+        }
+
+        if (p->wu) {
+                r = bus_wait_for_units_add_unit(p->wu, c->name, BUS_WAIT_FOR_INACTIVE|BUS_WAIT_NO_JOB, NULL, NULL);
+                if (r < 0)
+                        return c->r = log_error_errno(r, "Failed to watch unit %s: %m", c->name);
+        }
+
+        if (!p->check_reload)
+                return 0;
+
+        /* The unit is loaded now, hence we may address it by its path directly, and save the GetUnit()
+         * round trip need_daemon_reload() does. */
+        unit_path = unit_dbus_path_from_name(c->name);
+        if (!unit_path)
+                return c->r = log_oom();
+
+        r = sd_bus_call_method_async(
+                        sd_bus_message_get_bus(m),
+                        &c->reload_slot,
+                        "org.freedesktop.systemd1",
+                        unit_path,
+                        "org.freedesktop.DBus.Properties",
+                        "Get",
+                        on_need_daemon_reload_reply,
+                        c,
+                        "ss", "org.freedesktop.systemd1.Unit", "NeedDaemonReload");
+        if (r < 0)
+                log_debug_errno(r, "Failed to check whether %s needs a daemon reload, ignoring: %m", c->name);
+        else
+                p->n_pending++;
+
+        return 0;
+}
+
+static int start_units_pipelined(
+                sd_bus *bus,
+                const char *method,
+                const char *job_type,
+                const char *mode,
+                char **names,
+                BusWaitForJobs *w,
+                BusWaitForUnits *wu,
+                char ***stopped_units) {
+
+        _cleanup_free_ StartUnitCall *calls = NULL;
+        StartUnitPipeline p = {
+                .job_type = job_type,
+                .mode = mode,
+                .w = w,
+                .wu = wu,
+                /* A stopped unit may be garbage collected by now, and addressing it by path would load
+                 * it again */
+                .check_reload = !streq(method, "StopUnit"),
+        };
+        size_t n, next = 0;
+        int r, ret = EXIT_SUCCESS;
+
+        assert(bus);
+        assert(method);
+        assert(mode);
+        assert(stopped_units);
+
+        /* Like start_unit_one(), but enqueues the jobs for all units without waiting for each reply before
+         * sending the next request, with up to START_UNIT_PIPELINE_MAX requests in flight. This matters if
+         * globs expand to a large number of units. */
+
+        n = strv_length(names);
+        calls = new(StartUnitCall, n);
+        if (!calls)
+                return log_oom();
+
+        for (size_t i = 0; i < n; i++)
+                calls[i] = (StartUnitCall) {
+                        .pipeline = &p,
+                        .name = names[i],
+                        .error = SD_BUS_ERROR_NULL,
+                };
+
+        while (next < n || p.n_pending > 0) {
+                while (next < n && p.n_pending < START_UNIT_PIPELINE_MAX) {
+                        StartUnitCall *c = calls + next++;
+
+                        log_debug("Executing dbus call org.freedesktop.systemd1.Manager %s(%s, %s)",
+                                  method, c->name, mode);
+
+                        r = bus_call_method_async(bus, &c->slot, bus_systemd_mgr, method, on_start_unit_reply, c,
+                                                  "ss", c->name, mode);
+                        if (r < 0) {
+                                c->r = log_error_errno(r, "Failed to issue %s() call for %s: %m", method, c->name);
+                                continue;
+                        }
+
+                        p.n_pending++;
+                }
+
+                r = sd_bus_process(bus, NULL);
+                if (r < 0) {
+                        ret = log_error_errno(r, "Failed to process bus: %m");
+                        goto finish;
+                }
+                if (r > 0)
+                        continue;
+
+                r = sd_bus_wait(bus, UINT64_MAX);
+                if (r < 0) {
+                        ret = log_error_errno(r, "Failed to wait for bus: %m");
+                        goto finish;
+                }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+                if (calls[i].r < 0) {
+                        if (ret == EXIT_SUCCESS)
+                                ret = translate_bus_error_to_exit_status(calls[i].r, &calls[i].error);
+                        continue;
+                }
+
+                if (streq(method, "StopUnit")) {
+                        r = strv_push(stopped_units, calls[i].name);
+                        if (r < 0) {
+                                ret = log_oom();
+                                goto finish;
+                        }
+                }
+        }
+
+finish:
+        for (size_t i = 0; i < n; i++) {
+                sd_bus_slot_unref(calls[i].slot);
+                sd_bus_slot_unref(calls[i].reload_slot);
+                sd_bus_error_free(&calls[i].error);
+        }
+
+        return ret;
 }
 
 static int enqueue_marked_jobs(
@@ -364,7 +583,11 @@ int start_unit(int argc, char *argv[], void *userdata) {
         if (arg_marked)
                 ret = enqueue_marked_jobs(bus, w);
 
-        else
+        else if (arg_action == ACTION_SYSTEMCTL && !arg_dry_run && !arg_show_transaction && strv_length(names) > 1) {
+                ret = start_units_pipelined(bus, method, job_type, mode, names, w, wu, &stopped_units);
+                if (ret < 0)
+                        return ret;
+        } else
                 STRV_FOREACH(name, names) {
                         _cleanup_(sd_bus_error_free) sd_bus_error error = SD_BUS_ERROR_NULL;
 
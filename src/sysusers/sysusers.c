@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
 #include <getopt.h>
+#include <stdio_ext.h>
 #include <utmp.h>
 
 #include "alloc-util.h"
@@ -140,9 +141,11 @@ static int load_user_database(void) {
         int r;
 
         passwd_path = prefix_roota(arg_root, "/etc/passwd");
-        f = fopen(passwd_path, "re");
-        if (!f)
-                return errno == ENOENT ? 0 : -errno;
+        r = fopen_unlocked(passwd_path, "re", &f);
+        if (r == -ENOENT)
+                return 0;
+        if (r < 0)
+                return r;
 
         r = hashmap_ensure_allocated(&database_by_username, &string_hash_ops);
         if (r < 0)
@@ -188,9 +191,11 @@ static int load_group_database(void) {
         int r;
 
         group_path = prefix_roota(arg_root, "/etc/group");
-        f = fopen(group_path, "re");
-        if (!f)
-                return errno == ENOENT ? 0 : -errno;
+        r = fopen_unlocked(group_path, "re", &f);
+        if (r == -ENOENT)
+                return 0;
+        if (r < 0)
+                return r;
 
         r = hashmap_ensure_allocated(&database_by_groupname, &string_hash_ops);
         if (r < 0)
@@ -393,8 +398,11 @@ static int write_temporary_passwd(const char *passwd_path, FILE **tmpfile, char
         if (r < 0)
                 return log_debug_errno(r, "Failed to open temporary copy of %s: %m", passwd_path);
 
-        original = fopen(passwd_path, "re");
-        if (original) {
+        /* We are the only user of this stream, hence skip the stdio locking for each entry written. */
+        (void) __fsetlocking(passwd, FSETLOCKING_BYCALLER);
+
+        r = fopen_unlocked(passwd_path, "re", &original);
+        if (r >= 0) {
 
                 /* Allow fallback path for when /proc is not mounted. On any normal system /proc will be
                  * mounted, but e.g. when 'dnf --installroot' is used, it might not be. There is no security
@@ -430,8 +438,8 @@ static int write_temporary_passwd(const char *passwd_path, FILE **tmpfile, char
                         return log_debug_errno(r, "Failed to read %s: %m", passwd_path);
 
         } else {
-                if (errno != ENOENT)
-                        return log_debug_errno(errno, "Failed to open %s: %m", passwd_path);
+                if (r != -ENOENT)
+                        return log_debug_errno(r, "Failed to open %s: %m", passwd_path);
                 if (fchmod(fileno(passwd), 0644) < 0)
                         return log_debug_errno(errno, "Failed to fchmod %s: %m", passwd_tmp);
         }
@@ -512,10 +520,12 @@ static int write_temporary_shadow(const char *shadow_path, FILE **tmpfile, char
         if (r < 0)
                 return log_debug_errno(r, "Failed to open temporary copy of %s: %m", shadow_path);
 
+        (void) __fsetlocking(shadow, FSETLOCKING_BYCALLER);
+
         lstchg = (long) (now(CLOCK_REALTIME) / USEC_PER_DAY);
 
-        original = fopen(shadow_path, "re");
-        if (original) {
+        r = fopen_unlocked(shadow_path, "re", &original);
+        if (r >= 0) {
 
                 r = copy_rights_with_fallback(fileno(original), fileno(shadow), shadow_tmp);
                 if (r < 0)
@@ -548,8 +558,8 @@ static int write_temporary_shadow(const char *shadow_path, FILE **tmpfile, char
                         return log_debug_errno(r, "Failed to read %s: %m", shadow_path);
 
         } else {
-                if (errno != ENOENT)
-                        return log_debug_errno(errno, "Failed to open %s: %m", shadow_path);
+                if (r != -ENOENT)
+                        return log_debug_errno(r, "Failed to open %s: %m", shadow_path);
                 if (fchmod(fileno(shadow), 0000) < 0)
                         return log_debug_errno(errno, "Failed to fchmod %s: %m", shadow_tmp);
         }
@@ -645,8 +655,10 @@ static int write_temporary_group(const char *group_path, FILE **tmpfile, char **
         if (r < 0)
                 return log_debug_errno(r, "Failed to open temporary copy of %s: %m", group_path);
 
-        original = fopen(group_path, "re");
-        if (original) {
+        (void) __fsetlocking(group, FSETLOCKING_BYCALLER);
+
+        r = fopen_unlocked(group_path, "re", &original);
+        if (r >= 0) {
 
                 r = copy_rights_with_fallback(fileno(original), fileno(group), group_tmp);
                 if (r < 0)
@@ -685,8 +697,8 @@ static int write_temporary_group(const char *group_path, FILE **tmpfile, char **
                         return log_debug_errno(r, "Failed to read %s: %m", group_path);
 
         } else {
-                if (errno != ENOENT)
-                        return log_debug_errno(errno, "Failed to open %s: %m", group_path);
+                if (r != -ENOENT)
+                        return log_debug_errno(r, "Failed to open %s: %m", group_path);
                 if (fchmod(fileno(group), 0644) < 0)
                         return log_debug_errno(errno, "Failed to fchmod %s: %m", group_tmp);
         }
@@ -746,8 +758,10 @@ static int write_temporary_gshadow(const char * gshadow_path, FILE **tmpfile, ch
         if (r < 0)
                 return log_debug_errno(r, "Failed to open temporary copy of %s: %m", gshadow_path);
 
-        original = fopen(gshadow_path, "re");
-        if (original) {
+        (void) __fsetlocking(gshadow, FSETLOCKING_BYCALLER);
+
+        r = fopen_unlocked(gshadow_path, "re", &original);
+        if (r >= 0) {
                 struct sgrp *sg;
 
                 r = copy_rights_with_fallback(fileno(original), fileno(gshadow), gshadow_tmp);
@@ -774,8 +788,8 @@ static int write_temporary_gshadow(const char * gshadow_path, FILE **tmpfile, ch
                         return r;
 
         } else {
-                if (errno != ENOENT)
-                        return log_debug_errno(errno, "Failed to open %s: %m", gshadow_path);
+                if (r != -ENOENT)
+                        return log_debug_errno(r, "Failed to open %s: %m", gshadow_path);
                 if (fchmod(fileno(gshadow), 0000) < 0)
                         return log_debug_errno(errno, "Failed to fchmod %s: %m", gshadow_tmp);
         }
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include "alloc-util.h"
+#include "benchmark.h"
+#include "hashmap.h"
+#include "json.h"
+#include "prioq.h"
+#include "strv.h"
+#include "tests.h"
+
+#define N_ITEMS 10000U
+
+static void bench_hashmap_put_get(void *userdata) {
+        _cleanup_hashmap_free_ Hashmap *h = NULL;
+
+        assert_se(h = hashmap_new(NULL));
+
+        for (unsigned i = 1; i <= N_ITEMS; i++)
+                assert_se(hashmap_put(h, UINT_TO_PTR(i), UINT_TO_PTR(i)) > 0);
+
+        for (unsigned i = 1; i <= N_ITEMS; i++)
+                assert_se(hashmap_get(h, UINT_TO_PTR(i)) == UINT_TO_PTR(i));
+}
+
+static void bench_prioq_put_pop(void *userdata) {
+        _cleanup_(prioq_freep) Prioq *q = NULL;
+
+        assert_se(q = prioq_new(trivial_compare_func));
+
+        for (unsigned i = 1; i <= N_ITEMS; i++)
+                assert_se(prioq_put(q, UINT_TO_PTR((i * 7919U) % N_ITEMS + 1), NULL) >= 0);
+
+        for (unsigned i = 1; i <= N_ITEMS; i++)
+                assert_se(prioq_pop(q));
+}
+
+static void bench_strv_extend_sort(void *userdata) {
+        _cleanup_strv_free_ char **l = NULL;
+
+        for (unsigned i = 0; i < N_ITEMS / 10; i++)
+                assert_se(strv_extendf(&l, "item-%u", (i * 7919U) % N_ITEMS) >= 0);
+
+        strv_sort(l);
+}
+
+static void bench_json_parse(void *userdata) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        const char *text = userdata;
+
+        assert_se(json_parse(text, 0, &v, NULL, NULL) >= 0);
+}
+
+static void bench_json_format(void *userdata) {
+        _cleanup_free_ char *text = NULL;
+        JsonVariant *v = userdata;
+
+        assert_se(json_variant_format(v, 0, &text) >= 0);
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(json_variant_unrefp) JsonVariant *doc = NULL;
+        _cleanup_(benchmark_freep) Benchmark *b = NULL;
+        _cleanup_free_ char *text = NULL;
+
+        test_setup_logging(LOG_INFO);
+
+        assert_se(benchmark_new("containers", &b) >= 0);
+
+        assert_se(benchmark_run(b, "hashmap-put-get", bench_hashmap_put_get, NULL) >= 0);
+        assert_se(benchmark_run(b, "prioq-put-pop", bench_prioq_put_pop, NULL) >= 0);
+        assert_se(benchmark_run(b, "strv-extend-sort", bench_strv_extend_sort, NULL) >= 0);
+
+        for (unsigned i = 0; i < N_ITEMS / 10; i++) {
+                _cleanup_(json_variant_unrefp) JsonVariant *e = NULL;
+
+                assert_se(json_build(&e, JSON_BUILD_OBJECT(
+                                                     JSON_BUILD_PAIR("index", JSON_BUILD_UNSIGNED(i)),
+                                                     JSON_BUILD_PAIR("name", JSON_BUILD_STRING("benchmark")),
+                                                     JSON_BUILD_PAIR("enabled", JSON_BUILD_BOOLEAN(i % 2 == 0)))) >= 0);
+                assert_se(json_variant_append_array(&doc, e) >= 0);
+        }
+
+        assert_se(json_variant_format(doc, 0, &text) >= 0);
+
+        assert_se(benchmark_run(b, "json-parse", bench_json_parse, text) >= 0);
+        assert_se(benchmark_run(b, "json-format", bench_json_format, doc) >= 0);
+
+        assert_se(benchmark_report(b, stdout) >= 0);
+
+        return 0;
+}
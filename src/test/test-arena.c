@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "string-util.h"
+#include "tests.h"
+
+static void test_arena_alloc(void) {
+        Arena a = {};
+        char *s, *t, *big;
+        uint8_t *z;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(s = arena_strdup(&a, "hello"));
+        assert_se(streq(s, "hello"));
+        assert_se(t = arena_strndup(&a, "waldoquux", 5));
+        assert_se(streq(t, "waldo"));
+        assert_se(streq(s, "hello"));
+
+        /* Every allocation is aligned well enough for any type */
+        for (size_t i = 1; i < 100; i++)
+                assert_se(((uintptr_t) arena_alloc(&a, i) & (__alignof(long double) - 1)) == 0);
+
+        assert_se(z = arena_alloc0(&a, 333));
+        for (size_t i = 0; i < 333; i++)
+                assert_se(z[i] == 0);
+
+        /* Large allocations get their own block, that doesn't affect the small ones */
+        assert_se(big = arena_alloc(&a, 1024*1024));
+        memset(big, 'x', 1024*1024);
+        assert_se(s = arena_memdup(&a, "foo", 4));
+        assert_se(streq(s, "foo"));
+
+        /* Fill up more than one block */
+        for (unsigned i = 0; i < 10000; i++) {
+                assert_se(s = arena_strdup(&a, "0123456789"));
+                assert_se(streq(s, "0123456789"));
+        }
+
+        arena_done(&a);
+        assert_se(!a.blocks);
+}
+
+static void test_arena_reset(void) {
+        Arena a = {};
+        void *p, *q;
+
+        log_info("/* %s */", __func__);
+
+        /* Resetting keeps the block, hence the same memory is handed out again */
+        assert_se(p = arena_alloc(&a, 64));
+        arena_reset(&a);
+        assert_se(q = arena_alloc(&a, 64));
+        assert_se(p == q);
+
+        for (unsigned i = 0; i < 10000; i++)
+                assert_se(arena_alloc(&a, 64));
+        arena_reset(&a);
+        assert_se(a.blocks);
+        assert_se(arena_alloc(&a, 64));
+
+        /* An oversized block is not kept around */
+        arena_done(&a);
+        assert_se(arena_alloc(&a, 1024*1024));
+        arena_reset(&a);
+        assert_se(!a.blocks);
+
+        /* Resetting or freeing an empty arena is fine */
+        arena_reset(&a);
+        arena_done(&a);
+        arena_done(&a);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_arena_alloc();
+        test_arena_reset();
+
+        return 0;
+}
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <sys/socket.h>
+
+#include "sd-bus.h"
+#include "sd-event.h"
+
+#include "bus-changed-queue.h"
+#include "log.h"
+#include "strv.h"
+#include "tests.h"
+
+typedef struct Context {
+        unsigned n_signals;
+        char **names;
+} Context;
+
+static int get_property(
+                sd_bus *bus,
+                const char *path,
+                const char *interface,
+                const char *property,
+                sd_bus_message *reply,
+                void *userdata,
+                sd_bus_error *error) {
+
+        return sd_bus_message_append(reply, "s", property);
+}
+
+static const sd_bus_vtable vtable[] = {
+        SD_BUS_VTABLE_START(0),
+        SD_BUS_PROPERTY("A", "s", get_property, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("B", "s", get_property, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("C", "s", get_property, 0, SD_BUS_VTABLE_PROPERTY_EMITS_CHANGE),
+        SD_BUS_PROPERTY("D", "s", get_property, 0, SD_BUS_VTABLE_PROPERTY_CONST),
+        SD_BUS_VTABLE_END
+};
+
+static int on_properties_changed(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        Context *c = userdata;
+        const char *interface, *name, *value;
+
+        assert_se(sd_bus_message_read(m, "s", &interface) >= 0);
+        assert_se(streq(interface, "org.test.Changed"));
+
+        c->names = strv_free(c->names);
+
+        assert_se(sd_bus_message_enter_container(m, 'a', "{sv}") >= 0);
+        while (sd_bus_message_read(m, "{sv}", &name, "s", &value) > 0) {
+                assert_se(streq(name, value));
+                assert_se(strv_extend(&c->names, name) >= 0);
+        }
+        assert_se(sd_bus_message_exit_container(m) >= 0);
+
+        c->n_signals++;
+        return 0;
+}
+
+static void run_until(sd_event *e, Context *c, unsigned n_signals) {
+        while (c->n_signals < n_signals)
+                assert_se(sd_event_run(e, USEC_PER_SEC) > 0);
+
+        /* And nothing else must follow */
+        for (unsigned i = 0; i < 10; i++)
+                assert_se(sd_event_run(e, 0) >= 0);
+        assert_se(c->n_signals == n_signals);
+}
+
+static void test_changed_queue(usec_t interval) {
+        _cleanup_(sd_bus_close_unrefp) sd_bus *client = NULL, *server = NULL;
+        _cleanup_(bus_changed_queue_freep) BusChangedQueue *q = NULL;
+        _cleanup_(sd_event_unrefp) sd_event *e = NULL;
+        Context c = {};
+        int pair[2];
+
+        log_info("/* %s(" USEC_FMT ") */", __func__, interval);
+
+        assert_se(sd_event_new(&e) >= 0);
+        assert_se(socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, pair) >= 0);
+
+        assert_se(sd_bus_new(&server) >= 0);
+        assert_se(sd_bus_set_fd(server, pair[0], pair[0]) >= 0);
+        assert_se(sd_bus_set_server(server, true, SD_ID128_MAKE(2b,8c,14,5e,5f,86,4b,4f,8d,9b,2e,3c,a2,d0,6f,17)) >= 0);
+        assert_se(sd_bus_add_object_vtable(server, NULL, "/test", "org.test.Changed", vtable, NULL) >= 0);
+        assert_se(sd_bus_start(server) >= 0);
+
+        assert_se(sd_bus_new(&client) >= 0);
+        assert_se(sd_bus_set_fd(client, pair[1], pair[1]) >= 0);
+        assert_se(sd_bus_start(client) >= 0);
+        assert_se(sd_bus_match_signal(client, NULL, NULL, "/test", "org.freedesktop.DBus.Properties", "PropertiesChanged", on_properties_changed, &c) >= 0);
+
+        while (sd_bus_is_ready(client) <= 0 || sd_bus_is_ready(server) <= 0) {
+                assert_se(sd_bus_process(client, NULL) >= 0);
+                assert_se(sd_bus_process(server, NULL) >= 0);
+        }
+
+        assert_se(sd_bus_attach_event(server, e, 0) >= 0);
+        assert_se(sd_bus_attach_event(client, e, 0) >= 0);
+
+        assert_se(bus_changed_queue_new(server, e, interval, &q) >= 0);
+
+        /* Changes queued up in the same iteration end up in a single signal */
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("A")) >= 0);
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("B", "A")) >= 0);
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("A")) >= 0);
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE_EMPTY) >= 0);
+        assert_se(c.n_signals == 0);
+
+        run_until(e, &c, 1);
+        assert_se(strv_equal(c.names, STRV_MAKE("A", "B")));
+
+        /* A NULL list means everything that emits changes */
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("C")) >= 0);
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", NULL) >= 0);
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("A")) >= 0);
+
+        run_until(e, &c, 2);
+        assert_se(strv_equal(c.names, STRV_MAKE("A", "B", "C")));
+
+        /* An explicit flush sends everything right away */
+        assert_se(bus_changed_queue_add_strv(q, "/test", "org.test.Changed", STRV_MAKE("B")) >= 0);
+        assert_se(bus_changed_queue_flush(q) >= 0);
+        assert_se(bus_changed_queue_flush(q) >= 0);
+
+        run_until(e, &c, 3);
+        assert_se(strv_equal(c.names, STRV_MAKE("B")));
+
+        strv_free(c.names);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_changed_queue(0);
+        test_changed_queue(10 * USEC_PER_MSEC);
+
+        return 0;
+}
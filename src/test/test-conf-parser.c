@@ -385,6 +385,66 @@ static void test_config_parse(unsigned i, const char *s) {
         }
 }
 
+static void test_config_parse_record_one(const char *s, bool replayable) {
+        _cleanup_(config_parse_recording_freep) ConfigParseRecording *rec = NULL;
+        _cleanup_(unlink_tempfilep) char name[] = "/tmp/test-conf-parser.XXXXXX";
+        _cleanup_free_ char *setting1 = NULL, *setting1_replayed = NULL;
+        _cleanup_strv_free_ char **setting2 = NULL, **setting2_replayed = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+
+        const ConfigTableItem items[] = {
+                { "Section", "setting1",  config_parse_string,   0, &setting1},
+                { "Section", "setting2",  config_parse_strv,     0, &setting2},
+                {}
+        };
+        const ConfigTableItem items_replayed[] = {
+                { "Section", "setting1",  config_parse_string,   0, &setting1_replayed},
+                { "Section", "setting2",  config_parse_strv,     0, &setting2_replayed},
+                {}
+        };
+
+        assert_se(fmkostemp_safe(name, "r+", &f) == 0);
+        assert_se(fwrite(s, strlen(s), 1, f) == 1);
+        rewind(f);
+
+        assert_se(config_parse_record(NULL, name, f, "Section\0", config_item_table_lookup, items,
+                                      0, NULL, NULL, &rec) == 1);
+        assert_se(!!rec == replayable);
+        if (!rec)
+                return;
+
+        assert_se(config_parse_replay(NULL, name, rec, config_item_table_lookup, items_replayed, NULL) == 1);
+        assert_se(streq_ptr(setting1, setting1_replayed));
+        assert_se(strv_equal(setting2, setting2_replayed));
+}
+
+static void test_config_parse_record(void) {
+        log_info("/* %s */", __func__);
+
+        test_config_parse_record_one("[Section]\n"
+                                     "setting1=1\n"
+                                     "setting2=a b\n"
+                                     "# comment\n"
+                                     "setting2=c \\\n"
+                                     "  d\n"
+                                     "setting1=2\n"
+                                     "setting2=\n"
+                                     "setting2=e\n", true);
+        test_config_parse_record_one("[Section]\n"
+                                     "setting1=1\n"
+                                     "[X-Section]\n"
+                                     "setting1=2\n", true);
+        test_config_parse_record_one("[Section]\n"
+                                     "setting1=1\n"
+                                     "setting3=2\n", false);
+        test_config_parse_record_one("[Section]\n"
+                                     "setting1=1\n"
+                                     "[OtherSection]\n"
+                                     "setting1=2\n", false);
+        test_config_parse_record_one("[Section]\n"
+                                     "setting1\n", false);
+}
+
 int main(int argc, char **argv) {
         unsigned i;
 
@@ -407,5 +467,7 @@ int main(int argc, char **argv) {
         for (i = 0; i < ELEMENTSOF(config_file); i++)
                 test_config_parse(i, config_file[i]);
 
+        test_config_parse_record();
+
         return 0;
 }
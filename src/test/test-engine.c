@@ -70,6 +70,40 @@ static void verify_dependency_atoms(void) {
         }
 }
 
+static void verify_change_generation(Manager *m, Unit *a, Unit *b) {
+        Unit *u = NULL;
+        uint64_t g;
+
+        g = m->unit_change_generation;
+
+        /* Zero and generations we never handed out ask for a full list */
+        assert_se(manager_unit_generation_is_stale(m, 0));
+        assert_se(manager_unit_generation_is_stale(m, g + 1));
+        assert_se(!manager_unit_generation_is_stale(m, g));
+        assert_se(!unit_changed_since(a, g));
+        assert_se(!unit_changed_since(b, g));
+
+        /* A change visible on the bus bumps the generation of that unit only */
+        unit_add_to_dbus_queue(a);
+        assert_se(m->unit_change_generation > g);
+        assert_se(unit_changed_since(a, g));
+        assert_se(!unit_changed_since(b, g));
+        assert_se(!manager_unit_generation_is_stale(m, g));
+
+        /* So does adding a unit */
+        g = m->unit_change_generation;
+        assert_se(unit_new_for_name(m, sizeof(Service), "generation.service", &u) >= 0);
+        assert_se(unit_changed_since(u, g));
+        assert_se(!unit_changed_since(a, g));
+        assert_se(!manager_unit_generation_is_stale(m, g));
+
+        /* Removing one can't be expressed as a change, hence requires a full list */
+        g = m->unit_change_generation;
+        unit_free(u);
+        assert_se(manager_unit_generation_is_stale(m, g));
+        assert_se(!manager_unit_generation_is_stale(m, m->unit_change_generation));
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
         _cleanup_(sd_bus_error_free) sd_bus_error err = SD_BUS_ERROR_NULL;
@@ -259,6 +293,7 @@ int main(int argc, char *argv[]) {
         assert_se(mm == 3U*5U*7U*11U*13U);
 
         verify_dependency_atoms();
+        verify_change_generation(m, a, b);
 
         return 0;
 }
@@ -100,6 +100,34 @@ static void test_strv_env_merge(void) {
         assert_se(strv_length(r) == 5);
 }
 
+static void test_strv_env_merge_large(void) {
+        _cleanup_strv_free_ char **a = NULL, **b = NULL, **r = NULL;
+
+        log_info("/* %s */", __func__);
+
+        /* Large enough for strv_env_merge() to use its hash table index */
+
+        for (unsigned i = 0; i < 100; i++)
+                assert_se(strv_extendf(&a, "VAR%u=a", i) >= 0);
+
+        for (unsigned i = 50; i < 150; i++)
+                assert_se(strv_extendf(&b, "VAR%u=b", i) >= 0);
+        assert_se(strv_extend(&b, "VAR0=c") >= 0);
+        assert_se(strv_extend(&b, "VAR0=d") >= 0);
+
+        r = strv_env_merge(2, a, b);
+        assert_se(r);
+        assert_se(strv_length(r) == 150);
+
+        /* Overridden entries stay in place, new ones are appended in order */
+        assert_se(streq(r[0], "VAR0=d"));
+        assert_se(streq(r[49], "VAR49=a"));
+        assert_se(streq(r[50], "VAR50=b"));
+        assert_se(streq(r[99], "VAR99=b"));
+        assert_se(streq(r[100], "VAR100=b"));
+        assert_se(streq(r[149], "VAR149=b"));
+}
+
 static void test_strv_env_replace_strdup(void) {
         log_info("/* %s */", __func__);
 
@@ -417,6 +445,7 @@ int main(int argc, char *argv[]) {
         test_strv_env_pairs_get();
         test_strv_env_unset();
         test_strv_env_merge();
+        test_strv_env_merge_large();
         test_strv_env_replace_strdup();
         test_strv_env_assign();
         test_env_strv_get_n();
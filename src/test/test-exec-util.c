@@ -237,6 +237,46 @@ const gather_stdout_callback_t gather_stdout[] = {
         gather_stdout_three,
 };
 
+static void test_execution_max_parallel(void) {
+        char template[] = "/tmp/test-exec-util-max-parallel.XXXXXXX";
+        const char *dirs[] = {template, NULL};
+        const char *name, *name2, *name3, *output, *t;
+        _cleanup_free_ char *contents = NULL;
+
+        assert_se(mkdtemp(template));
+
+        output = strjoina(template, "/output");
+
+        log_info("/* %s >>%s */", __func__, output);
+
+        name = strjoina(template, "/10-foo");
+        name2 = strjoina(template, "/20-bar");
+        name3 = strjoina(template, "/30-baz");
+
+        /* With only one binary running at a time, the parallel mode has to follow the order of the
+         * files, too. The first one sleeps, so that it would finish last if they ran in parallel. */
+        t = strjoina("#!/bin/sh\nsleep 1\necho $(basename $0) >>", output);
+        assert_se(write_string_file(name, t, WRITE_STRING_FILE_CREATE) == 0);
+
+        t = strjoina("#!/bin/sh\necho $(basename $0) >>", output);
+        assert_se(write_string_file(name2, t, WRITE_STRING_FILE_CREATE) == 0);
+        assert_se(write_string_file(name3, t, WRITE_STRING_FILE_CREATE) == 0);
+
+        assert_se(chmod(name, 0755) == 0);
+        assert_se(chmod(name2, 0755) == 0);
+        assert_se(chmod(name3, 0755) == 0);
+
+        if (access(name, X_OK) < 0 && ERRNO_IS_PRIVILEGE(errno))
+                return;
+
+        execute_directories_full(dirs, DEFAULT_TIMEOUT_USEC, NULL, NULL, NULL, NULL, EXEC_DIR_PARALLEL | EXEC_DIR_IGNORE_ERRORS, 1);
+
+        assert_se(read_full_file(output, &contents, NULL) >= 0);
+        assert_se(streq(contents, "10-foo\n20-bar\n30-baz\n"));
+
+        (void) rm_rf(template, REMOVE_ROOT|REMOVE_PHYSICAL);
+}
+
 static void test_stdout_gathering(void) {
         char template[] = "/tmp/test-exec-util.XXXXXXX";
         const char *dirs[] = {template, NULL};
@@ -463,6 +503,7 @@ int main(int argc, char *argv[]) {
         test_execute_directory(true);
         test_execute_directory(false);
         test_execution_order();
+        test_execution_max_parallel();
         test_stdout_gathering();
         test_environment_gathering();
         test_error_catching();
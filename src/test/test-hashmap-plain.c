@@ -830,6 +830,63 @@ static void test_hashmap_free(void) {
         }
 }
 
+static void test_hashmap_benchmark(void) {
+        unsigned n_entries = 1 << 20, n_lookups = 1 << 22;
+        _cleanup_strv_free_ char **keys = NULL;
+        char b[FORMAT_TIMESPAN_MAX];
+        const struct {
+                const char *title;
+                const struct hash_ops *ops;
+        } tests[] = {
+                { "trivial_hash_ops",         NULL },
+                { "trivial_hash_ops_trusted", &trivial_hash_ops_trusted },
+                { "string_hash_ops",          &string_hash_ops },
+        };
+
+        /* This only measures, it doesn't test anything the other tests don't */
+        if (!slow_tests_enabled()) {
+                log_info("/* %s skipped, slow tests are disabled */", __func__);
+                return;
+        }
+
+        log_info("/* %s (%u entries) */", __func__, n_entries);
+
+        assert_se(keys = new0(char*, n_entries + 1));
+        for (unsigned i = 0; i < n_entries; i++)
+                assert_se(asprintf(&keys[i], "unit-%u.service", i) >= 0);
+
+        for (unsigned j = 0; j < ELEMENTSOF(tests); j++) {
+                _cleanup_hashmap_free_ Hashmap *h = NULL;
+                usec_t ts, n;
+
+                assert_se(h = hashmap_new(tests[j].ops));
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_entries; i++)
+                        assert_se(hashmap_put(h, keys[i], UINT_TO_PTR(i + 1)) == 1);
+                n = usec_sub_unsigned(now(CLOCK_MONOTONIC), ts);
+                log_info("%s: %u inserts in %s, %g/s",
+                         tests[j].title, n_entries, format_timespan(b, sizeof b, n, 1),
+                         (double) n_entries * USEC_PER_SEC / MAX(n, 1u));
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_lookups; i++)
+                        assert_se(PTR_TO_UINT(hashmap_get(h, keys[i % n_entries])) == i % n_entries + 1);
+                n = usec_sub_unsigned(now(CLOCK_MONOTONIC), ts);
+                log_info("%s: %u successful lookups in %s, %g/s",
+                         tests[j].title, n_lookups, format_timespan(b, sizeof b, n, 1),
+                         (double) n_lookups * USEC_PER_SEC / MAX(n, 1u));
+
+                ts = now(CLOCK_MONOTONIC);
+                for (unsigned i = 0; i < n_lookups; i++)
+                        assert_se(!hashmap_get(h, tests[j].ops == &string_hash_ops ? (const void*) "unit-x.service" : keys[i % n_entries] + 1));
+                n = usec_sub_unsigned(now(CLOCK_MONOTONIC), ts);
+                log_info("%s: %u failed lookups in %s, %g/s",
+                         tests[j].title, n_lookups, format_timespan(b, sizeof b, n, 1),
+                         (double) n_lookups * USEC_PER_SEC / MAX(n, 1u));
+        }
+}
+
 typedef struct Item {
         int seen;
 } Item;
@@ -1090,6 +1147,7 @@ void test_hashmap_funcs(void) {
         test_hashmap_size();
         test_hashmap_many();
         test_hashmap_free();
+        test_hashmap_benchmark();
         test_hashmap_free_with_destructor();
         test_hashmap_first();
         test_hashmap_first_key();
@@ -14,6 +14,7 @@
 #include "util.h"
 
 static void test_tokenizer(const char *data, ...) {
+        const char *begin = data;
         unsigned line = 0, column = 0;
         void *state = NULL;
         va_list ap;
@@ -42,7 +43,12 @@ static void test_tokenizer(const char *data, ...) {
                         const char *nn;
 
                         nn = va_arg(ap, const char *);
-                        assert_se(streq_ptr(nn, str));
+                        assert_se(strlen(nn) == v.view.size);
+                        assert_se(memcmp(nn, v.view.string, v.view.size) == 0);
+
+                        /* Strings that needed no unescaping are referenced in the input */
+                        if (!str)
+                                assert_se(v.view.string >= begin && v.view.string + v.view.size < data);
 
                 } else if (t == JSON_TOKEN_REAL) {
                         long double d;
@@ -477,6 +483,20 @@ static void test_normalize(void) {
         t = mfree(t);
 }
 
+static void test_format_string(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *w = NULL;
+        _cleanup_free_ char *t = NULL;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(json_variant_new_string(&v, "plain text that is long enough for several words \"\\\x01\x7f\n\xc3\xa4 end") >= 0);
+        assert_se(json_variant_format(v, 0, &t) >= 0);
+        assert_se(streq(t, "\"plain text that is long enough for several words \\\"\\\\\\u0001\\u007f\\n\xc3\xa4 end\""));
+
+        assert_se(json_parse(t, 0, &w, NULL, NULL) >= 0);
+        assert_se(json_variant_equal(v, w));
+}
+
 static void test_bisect(void) {
         log_info("/* %s */", __func__);
 
@@ -572,6 +592,7 @@ int main(int argc, char *argv[]) {
         test_depth();
 
         test_normalize();
+        test_format_string();
         test_bisect();
 
         return 0;
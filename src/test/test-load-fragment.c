@@ -10,6 +10,7 @@
 #include "capability-util.h"
 #include "conf-parser.h"
 #include "fd-util.h"
+#include "fileio.h"
 #include "format-util.h"
 #include "fs-util.h"
 #include "hashmap.h"
@@ -17,10 +18,12 @@
 #include "install-printf.h"
 #include "install.h"
 #include "load-fragment.h"
+#include "load-prefetch.h"
 #include "macro.h"
 #include "memory-util.h"
 #include "rm-rf.h"
 #include "specifier.h"
+#include "stat-util.h"
 #include "string-util.h"
 #include "strv.h"
 #include "tests.h"
@@ -829,6 +832,46 @@ static void test_config_parse_memory_limit(void) {
 
 }
 
+static void test_fragment_prefetch(void) {
+        _cleanup_(rm_rf_physical_and_freep) char *d = NULL;
+        _cleanup_hashmap_free_ Hashmap *fragments = NULL;
+        _cleanup_strv_free_ char **paths = NULL;
+        PrefetchedFragment *p;
+        char *a, *b, *c;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(mkdtemp_malloc("/tmp/test-prefetch-XXXXXX", &d) >= 0);
+        a = strjoina(d, "/a.service");
+        b = strjoina(d, "/b.service");
+        c = strjoina(d, "/c.service");
+
+        assert_se(write_string_file(a, "[Service]\nExecStart=/bin/true", WRITE_STRING_FILE_CREATE) >= 0);
+        assert_se(symlink("/dev/null", b) >= 0);
+
+        assert_se(paths = strv_new(a, b, c, a));
+        assert_se(fragment_prefetch(paths, 4, &fragments) >= 0);
+        assert_se(hashmap_size(fragments) == 3);
+
+        assert_se(p = hashmap_get(fragments, a));
+        assert_se(p->error == 0);
+        assert_se(streq(p->data, "[Service]\nExecStart=/bin/true\n"));
+
+        assert_se(p = hashmap_get(fragments, b));
+        assert_se(p->error == 0);
+        assert_se(null_or_empty(&p->st));
+        assert_se(!p->data);
+
+        assert_se(p = hashmap_get(fragments, c));
+        assert_se(p->error == -ENOENT);
+
+        /* Already known paths are not read again */
+        p = hashmap_get(fragments, a);
+        assert_se(fragment_prefetch(STRV_MAKE(a), 1, &fragments) >= 0);
+        assert_se(hashmap_get(fragments, a) == p);
+        assert_se(hashmap_size(fragments) == 3);
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
         int r;
@@ -850,6 +893,7 @@ int main(int argc, char *argv[]) {
         TEST_REQ_RUNNING_SYSTEMD(test_install_printf());
         test_unit_dump_config_items();
         test_config_parse_memory_limit();
+        test_fragment_prefetch();
 
         return r;
 }
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <fcntl.h>
+
+#include "sd-journal.h"
+
+#include "alloc-util.h"
+#include "fd-util.h"
+#include "fileio.h"
+#include "io-util.h"
+#include "journal-file.h"
+#include "json.h"
+#include "logs-show.h"
+#include "path-util.h"
+#include "rm-rf.h"
+#include "string-util.h"
+#include "tests.h"
+#include "tmpfile-util.h"
+
+#define MULTI_LINE_MESSAGE "first line\nsecond \"quoted\" line\n\tindented \\ line\n"
+
+static void test_output_json_one(OutputMode mode) {
+        _cleanup_(rm_rf_physical_and_freep) char *dn = NULL;
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL;
+        _cleanup_free_ char *fn = NULL, *text = NULL;
+        _cleanup_fclose_ FILE *f = NULL;
+        JournalFile *jf = NULL;
+        sd_journal *j = NULL;
+        struct iovec iovec[2];
+        dual_timestamp ts;
+        const char *p;
+        size_t size;
+
+        log_info("/* %s(%s) */", __func__, output_mode_to_string(mode));
+
+        assert_se(mkdtemp_malloc("/var/tmp/test-logs-show.XXXXXX", &dn) >= 0);
+        assert_se(fn = path_join(dn, "test.journal"));
+
+        assert_se(journal_file_open(-1, fn, O_RDWR|O_CREAT, 0644, false, UINT64_MAX, false, NULL, NULL, NULL, NULL, &jf) == 0);
+
+        assert_se(dual_timestamp_get(&ts));
+        iovec[0] = IOVEC_MAKE_STRING("MESSAGE=" MULTI_LINE_MESSAGE);
+        iovec[1] = IOVEC_MAKE_STRING("FOO=bar");
+        assert_se(journal_file_append_entry(jf, &ts, NULL, iovec, ELEMENTSOF(iovec), NULL, NULL, NULL) == 0);
+
+        (void) journal_file_close(jf);
+
+        assert_se(sd_journal_open_files(&j, (const char**) STRV_MAKE(fn), 0) >= 0);
+        assert_se(sd_journal_next(j) > 0);
+
+        assert_se(f = open_memstream_unlocked(&text, &size));
+        assert_se(show_journal_entry(f, j, mode, 0, OUTPUT_SHOW_ALL, NULL, NULL, NULL) >= 0);
+        assert_se(fflush_and_check(f) >= 0);
+        f = safe_fclose(f);
+
+        sd_journal_close(j);
+
+        /* Raw control characters would break the record framing of all JSON modes */
+        p = text;
+        if (mode == OUTPUT_JSON_SEQ)
+                assert_se(p = startswith(p, "\x1e"));
+        else if (mode == OUTPUT_JSON_SSE)
+                assert_se(p = startswith(p, "data: "));
+        assert_se(!strchr(p, '\t'));
+        assert_se(strchr(p, '\n') == p + strlen(p) - 1 - (mode == OUTPUT_JSON_SSE));
+
+        assert_se(json_parse(p, 0, &v, NULL, NULL) >= 0);
+        assert_se(streq_ptr(json_variant_string(json_variant_by_key(v, "MESSAGE")), MULTI_LINE_MESSAGE));
+        assert_se(streq_ptr(json_variant_string(json_variant_by_key(v, "FOO")), "bar"));
+}
+
+static void test_output_json(void) {
+        test_output_json_one(OUTPUT_JSON);
+        test_output_json_one(OUTPUT_JSON_SEQ);
+        test_output_json_one(OUTPUT_JSON_SSE);
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_output_json();
+
+        return 0;
+}
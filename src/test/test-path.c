@@ -1,8 +1,10 @@
 /* SPDX-License-Identifier: LGPL-2.1-or-later */
 
+#include <fcntl.h>
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "alloc-util.h"
 #include "all-units.h"
@@ -23,7 +25,7 @@ typedef void (*test_function_t)(Manager *m);
 
 static int setup_test(Manager **m) {
         char **tests_path = STRV_MAKE("exists", "existsglobFOOBAR", "changed", "modified", "unit",
-                                      "directorynotempty", "makedirectory");
+                                      "directorynotempty", "makedirectory", "shared");
         char **test_path;
         Manager *tmp = NULL;
         int r;
@@ -371,6 +373,56 @@ static void test_path_makedirectory_directorymode(Manager *m) {
         (void) rm_rf(test_path, REMOVE_ROOT|REMOVE_PHYSICAL);
 }
 
+static void test_path_shared_watch(Manager *m) {
+        const char *test_dir = "/tmp/test-path_shared", *test_file = "/tmp/test-path_shared/file";
+        _cleanup_close_ int fd = -1;
+        Unit *unit_changed = NULL, *unit_modified = NULL;
+        Path *changed, *modified;
+        Service *service_changed, *service_modified;
+
+        assert_se(m);
+
+        /* Both units watch the same directory, hence share one inotify watch descriptor */
+        assert_se(mkdir_p(test_dir, 0755) >= 0);
+        assert_se(touch(test_file) >= 0);
+
+        assert_se(manager_load_startable_unit_or_warn(m, "path-shared-changed.path", NULL, &unit_changed) >= 0);
+        assert_se(manager_load_startable_unit_or_warn(m, "path-shared-modified.path", NULL, &unit_modified) >= 0);
+
+        changed = PATH(unit_changed);
+        modified = PATH(unit_modified);
+        service_changed = service_for_path(m, changed, NULL);
+        service_modified = service_for_path(m, modified, NULL);
+
+        assert_se(unit_start(unit_changed) >= 0);
+        assert_se(unit_start(unit_modified) >= 0);
+        if (check_states(m, changed, service_changed, PATH_WAITING, SERVICE_DEAD) < 0 ||
+            check_states(m, modified, service_modified, PATH_WAITING, SERVICE_DEAD) < 0)
+                return;
+
+        /* IN_MODIFY is part of the shared mask, but only PathModified= asked for it */
+        assert_se((fd = open(test_file, O_WRONLY|O_CLOEXEC)) >= 0);
+        assert_se(write(fd, "test", 4) == 4);
+        if (check_states(m, modified, service_modified, PATH_RUNNING, SERVICE_RUNNING) < 0)
+                return;
+        assert_se(changed->state == PATH_WAITING);
+        assert_se(service_changed->state == SERVICE_DEAD);
+
+        /* Stopping one unit must not remove the watch from under the other one */
+        assert_se(unit_stop(unit_modified) >= 0);
+        assert_se(unit_stop(UNIT(service_modified)) >= 0);
+        if (check_states(m, modified, service_modified, PATH_DEAD, SERVICE_DEAD) < 0)
+                return;
+
+        fd = safe_close(fd);
+        if (check_states(m, changed, service_changed, PATH_RUNNING, SERVICE_RUNNING) < 0)
+                return;
+
+        assert_se(unit_stop(UNIT(service_changed)) >= 0);
+        assert_se(unit_stop(unit_changed) >= 0);
+        (void) rm_rf(test_dir, REMOVE_ROOT|REMOVE_PHYSICAL);
+}
+
 int main(int argc, char *argv[]) {
         static const test_function_t tests[] = {
                 test_path_exists,
@@ -380,6 +432,7 @@ int main(int argc, char *argv[]) {
                 test_path_unit,
                 test_path_directorynotempty,
                 test_path_makedirectory_directorymode,
+                test_path_shared_watch,
                 NULL,
         };
 
@@ -7,6 +7,8 @@
 #include "set.h"
 #include "siphash24.h"
 #include "sort-util.h"
+#include "tests.h"
+#include "time-util.h"
 
 #define SET_SIZE 1024*4
 
@@ -119,10 +121,56 @@ static void test_struct(void) {
         assert_se(set_isempty(s));
 }
 
+static void test_benchmark(void) {
+        _cleanup_(prioq_freep) Prioq *q = NULL;
+        _cleanup_free_ struct test *items = NULL;
+        unsigned n_items = slow_tests_enabled() ? 1U << 20 : 1U << 14, n_reshuffles = n_items * 4, previous = 0;
+        char b[FORMAT_TIMESPAN_MAX];
+        usec_t ts;
+
+        log_info("/* %s (%u items) */", __func__, n_items);
+
+        srand(0);
+
+        assert_se(q = prioq_new((compare_func_t) test_compare));
+        assert_se(items = new(struct test, n_items));
+
+        ts = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < n_items; i++) {
+                items[i].value = (unsigned) rand();
+                assert_se(prioq_put(q, items + i, &items[i].idx) >= 0);
+        }
+        log_info("%u puts in %s", n_items, format_timespan(b, sizeof b, usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), 1));
+
+        /* Move random items around, like sd-event does with its earliest/latest queues */
+        ts = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < n_reshuffles; i++) {
+                struct test *t = items + (unsigned) rand() % n_items;
+
+                t->value = (unsigned) rand();
+                assert_se(prioq_reshuffle(q, t, &t->idx) == 1);
+        }
+        log_info("%u reshuffles in %s", n_reshuffles, format_timespan(b, sizeof b, usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), 1));
+
+        ts = now(CLOCK_MONOTONIC);
+        for (unsigned i = 0; i < n_items; i++) {
+                struct test *t;
+
+                assert_se(t = prioq_pop(q));
+                assert_se(previous <= t->value);
+                previous = t->value;
+        }
+        log_info("%u pops in %s", n_items, format_timespan(b, sizeof b, usec_sub_unsigned(now(CLOCK_MONOTONIC), ts), 1));
+
+        assert_se(prioq_isempty(q));
+}
+
 int main(int argc, char* argv[]) {
+        test_setup_logging(LOG_INFO);
 
         test_unsigned();
         test_struct();
+        test_benchmark();
 
         return 0;
 }
@@ -757,6 +757,36 @@ static void test_strv_push(void) {
         assert_se(streq_ptr(a[3], NULL));
 }
 
+static void test_strv_push_with_size(void) {
+        _cleanup_strv_free_ char **a = NULL;
+        size_t n = 0;
+        char *i;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(i = strdup("foo"));
+        assert_se(strv_push_with_size(&a, &n, i) >= 0);
+        assert_se(n == 1);
+
+        assert_se(strv_extend_with_size(&a, &n, "bar") >= 0);
+        assert_se(n == 2);
+
+        assert_se(i = strdup("baz"));
+        assert_se(strv_consume_with_size(&a, &n, i) >= 0);
+        assert_se(n == 3);
+
+        /* NULL values are ignored, and the size is left untouched */
+        assert_se(strv_push_with_size(&a, &n, NULL) >= 0);
+        assert_se(n == 3);
+
+        /* SIZE_MAX means the size is determined first */
+        n = SIZE_MAX;
+        assert_se(strv_extend_with_size(&a, &n, "qux") >= 0);
+        assert_se(n == 4);
+
+        assert_se(strv_equal(a, STRV_MAKE("foo", "bar", "baz", "qux")));
+}
+
 static void test_strv_compare(void) {
         _cleanup_strv_free_ char **a = NULL;
         _cleanup_strv_free_ char **b = NULL;
@@ -1043,6 +1073,7 @@ int main(int argc, char *argv[]) {
         test_strv_insert();
         test_strv_push_prepend();
         test_strv_push();
+        test_strv_push_with_size();
         test_strv_compare();
         test_strv_is_uniq();
         test_strv_reverse();
@@ -3,6 +3,7 @@
 #include "rm-rf.h"
 #include "service.h"
 #include "tests.h"
+#include "unit-serialize.h"
 
 #define EXEC_START_ABSOLUTE \
         "ExecStart 0 /bin/sh \"sh\" \"-e\" \"-x\" \"-c\" \"systemctl --state=failed --no-legend --no-pager >/failed ; systemctl daemon-reload ; echo OK >/testok\""
@@ -50,12 +51,21 @@ static void test_deserialize_exec_command(void) {
         test_deserialize_exec_command_one(m, "control-command", "ExecWhat 11 /a/b c d e", -EINVAL);
 }
 
+static void test_deserialize_fields_sorted(void) {
+        log_info("/* %s */", __func__);
+
+        /* The table is looked up with a binary search, hence must be sorted and free of duplicates */
+        assert_se(unit_deserialize_fields_sorted());
+}
+
 int main(int argc, char *argv[]) {
         _cleanup_(rm_rf_physical_and_freep) char *runtime_dir = NULL;
         int r;
 
         test_setup_logging(LOG_DEBUG);
 
+        test_deserialize_fields_sorted();
+
         r = enter_cgroup_subroot(NULL);
         if (r == -ENOMEDIUM)
                 return log_tests_skipped("cgroupfs not available");
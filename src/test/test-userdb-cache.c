@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+
+#include <unistd.h>
+
+#include "process-util.h"
+#include "tests.h"
+#include "userdb-cache.h"
+
+static void test_userdb_cache(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *w = NULL;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(userdb_cache_get("u:foo", &w) == 0);
+
+        assert_se(json_build(&v, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("userName", JSON_BUILD_STRING("foo")),
+                                                   JSON_BUILD_PAIR("uid", JSON_BUILD_UNSIGNED(4711)))) >= 0);
+        assert_se(userdb_cache_put("u:foo", v) > 0);
+        assert_se(userdb_cache_put("u:bar", NULL) > 0);
+
+        /* What we get back is a copy, not the object we put in */
+        assert_se(userdb_cache_get("u:foo", &w) > 0);
+        assert_se(w != v);
+        assert_se(json_variant_equal(v, w));
+        w = json_variant_unref(w);
+
+        assert_se(userdb_cache_get("u:bar", &w) == -ESRCH);
+        assert_se(!w);
+
+        userdb_cache_flush();
+        assert_se(userdb_cache_get("u:foo", &w) == 0);
+        assert_se(userdb_cache_get("u:bar", &w) == 0);
+
+        /* Entries expire */
+        userdb_cache_set_ttl(50 * USEC_PER_MSEC);
+        assert_se(userdb_cache_put("u:foo", v) > 0);
+        assert_se(userdb_cache_get("u:foo", &w) > 0);
+        w = json_variant_unref(w);
+        usleep(100 * USEC_PER_MSEC);
+        assert_se(userdb_cache_get("u:foo", &w) == 0);
+
+        /* And nothing is remembered while caching is turned off */
+        userdb_cache_set_ttl(0);
+        assert_se(userdb_cache_put("u:foo", v) == 0);
+        assert_se(userdb_cache_get("u:foo", &w) == 0);
+
+        userdb_cache_set_ttl(USERDB_CACHE_TTL_DEFAULT_USEC);
+}
+
+static void test_userdb_cache_fork(void) {
+        _cleanup_(json_variant_unrefp) JsonVariant *v = NULL, *w = NULL;
+        int r;
+
+        log_info("/* %s */", __func__);
+
+        assert_se(json_build(&v, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("userName", JSON_BUILD_STRING("foo")))) >= 0);
+        assert_se(userdb_cache_put("u:foo", v) > 0);
+
+        r = safe_fork("(userdb-cache)", FORK_WAIT|FORK_LOG, NULL);
+        assert_se(r >= 0);
+        if (r == 0) {
+                /* The child starts out with an empty cache */
+                assert_se(userdb_cache_get("u:foo", &w) == 0);
+                _exit(EXIT_SUCCESS);
+        }
+
+        /* … while the parent keeps its own */
+        assert_se(userdb_cache_get("u:foo", &w) > 0);
+        assert_se(json_variant_equal(v, w));
+
+        userdb_cache_flush();
+}
+
+int main(int argc, char *argv[]) {
+        test_setup_logging(LOG_DEBUG);
+
+        test_userdb_cache();
+        test_userdb_cache_fork();
+
+        return 0;
+}
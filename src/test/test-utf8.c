@@ -66,6 +66,33 @@ static void test_ascii_is_valid_n(void) {
         assert_se( ascii_is_valid_n("\342\204\242", 0));
 }
 
+static void test_ascii_printable_span(void) {
+        char buf[24];
+
+        log_info("/* %s */", __func__);
+
+        assert_se(ascii_printable_span("", 0, 0, 0) == 0);
+        assert_se(ascii_printable_span("foo", 3, 0, 0) == 3);
+        assert_se(ascii_printable_span("foo bar baz \"quux\"", 18, 0, 0) == 18);
+        assert_se(ascii_printable_span("foo bar baz \"quux\"", 18, '"', '\\') == 12);
+        assert_se(ascii_printable_span("foo bar baz\\quux", 16, '"', '\\') == 11);
+        assert_se(ascii_printable_span("foo bar baz quux\n", 17, 0, 0) == 16);
+        assert_se(ascii_printable_span("foo bar baz quux\342\204\242", 19, 0, 0) == 16);
+
+        /* Place every possible byte at every position, so that both the word-wise and the byte-wise
+         * checks see it */
+        for (size_t i = 0; i < sizeof(buf); i++)
+                for (unsigned c = 0; c < 256; c++) {
+                        bool plain = c >= 0x20 && c < 0x7f && !IN_SET(c, '"', '\\');
+
+                        memset(buf, 'a', sizeof(buf));
+                        buf[i] = (char) c;
+
+                        assert_se(ascii_printable_span(buf, sizeof(buf), '"', '\\') == (plain ? sizeof(buf) : i));
+                        assert_se(ascii_printable_span(buf, i, '"', '\\') == i);
+                }
+}
+
 static void test_utf8_encoded_valid_unichar(void) {
         log_info("/* %s */", __func__);
 
@@ -241,6 +268,7 @@ int main(int argc, char *argv[]) {
         test_utf8_is_printable();
         test_ascii_is_valid();
         test_ascii_is_valid_n();
+        test_ascii_printable_span();
         test_utf8_encoded_valid_unichar();
         test_utf8_escape_invalid();
         test_utf8_escape_non_printable();
@@ -20,6 +20,10 @@
    should cover any auxiliary fds, the listener server fds, stdin/stdout/stderr and whatever else. */
 #define OVERLOAD_CONNECTIONS 333
 
+/* Enough data to overflow the socket buffer many times, so that the replies are written out in bits */
+#define STREAM_COUNT 256U
+#define STREAM_SIZE (16U*1024U)
+
 static int n_done = 0;
 static int block_write_fd = -1;
 
@@ -48,6 +52,30 @@ static int method_something(Varlink *link, JsonVariant *parameters, VarlinkMetho
         return varlink_reply(link, ret);
 }
 
+static int method_stream(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
+        _cleanup_free_ char *data = NULL;
+        int r;
+
+        if (!FLAGS_SET(flags, VARLINK_METHOD_MORE))
+                return varlink_error(link, VARLINK_ERROR_INVALID_PARAMETER, NULL);
+
+        data = new(char, STREAM_SIZE + 1);
+        if (!data)
+                return -ENOMEM;
+        memset(data, 'x', STREAM_SIZE);
+        data[STREAM_SIZE] = 0;
+
+        for (unsigned i = 0; i < STREAM_COUNT; i++) {
+                r = varlink_notifyb(link, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("index", JSON_BUILD_UNSIGNED(i)),
+                                                            JSON_BUILD_PAIR("data", JSON_BUILD_STRING(data))));
+                if (r < 0)
+                        return r;
+        }
+
+        return varlink_replyb(link, JSON_BUILD_OBJECT(JSON_BUILD_PAIR("index", JSON_BUILD_UNSIGNED(STREAM_COUNT)),
+                                                      JSON_BUILD_PAIR("data", JSON_BUILD_STRING(data))));
+}
+
 static int method_done(Varlink *link, JsonVariant *parameters, VarlinkMethodFlags flags, void *userdata) {
 
         if (++n_done == 2)
@@ -78,6 +106,9 @@ static int on_connect(VarlinkServer *s, Varlink *link, void *userdata) {
         assert_se(varlink_get_peer_uid(link, &uid) >= 0);
         assert_se(getuid() == uid);
 
+        /* Keep this low, so that the streaming test actually runs into it */
+        assert_se(varlink_set_output_high_water(link, 64U*1024U) >= 0);
+
         return 0;
 }
 
@@ -140,6 +171,46 @@ static void flood_test(const char *address) {
                 connections[k] = varlink_unref(connections[k]);
 }
 
+static int stream_reply(Varlink *link, JsonVariant *parameters, const char *error_id, VarlinkReplyFlags flags, void *userdata) {
+        unsigned *n = userdata;
+
+        assert_se(n);
+        assert_se(!error_id);
+        assert_se(json_variant_unsigned(json_variant_by_key(parameters, "index")) == *n);
+        assert_se(strlen(json_variant_string(json_variant_by_key(parameters, "data"))) == STREAM_SIZE);
+        assert_se(FLAGS_SET(flags, VARLINK_REPLY_CONTINUES) == (*n < STREAM_COUNT));
+
+        (*n)++;
+        return 0;
+}
+
+static void stream_test(const char *address) {
+        _cleanup_(varlink_flush_close_unrefp) Varlink *c = NULL;
+        unsigned n = 0;
+        int r;
+
+        log_debug("Streaming from server...");
+
+        assert_se(varlink_connect_address(&c, address) >= 0);
+        assert_se(varlink_set_description(c, "stream-client") >= 0);
+        varlink_set_userdata(c, &n);
+        assert_se(varlink_bind_reply(c, stream_reply) >= 0);
+
+        /* After each call the server sits on far more queued output than its high-water mark, and only
+         * picks up the next call once that is drained */
+        for (unsigned i = 0; i < 3; i++) {
+                n = 0;
+                assert_se(varlink_observeb(c, "io.test.Stream", JSON_BUILD_EMPTY_OBJECT) >= 0);
+
+                while (n <= STREAM_COUNT) {
+                        r = varlink_process(c);
+                        assert_se(r >= 0);
+                        if (r == 0)
+                                assert_se(varlink_wait(c, USEC_INFINITY) >= 0);
+                }
+        }
+}
+
 static void *thread(void *arg) {
         _cleanup_(varlink_flush_close_unrefp) Varlink *c = NULL;
         _cleanup_(json_variant_unrefp) JsonVariant *i = NULL;
@@ -160,6 +231,7 @@ static void *thread(void *arg) {
         assert_se(streq_ptr(json_variant_string(json_variant_by_key(o, "method")), "io.test.IDontExist"));
         assert_se(streq(e, VARLINK_ERROR_METHOD_NOT_FOUND));
 
+        stream_test(arg);
         flood_test(arg);
 
         assert_se(varlink_send(c, "io.test.Done", NULL) >= 0);
@@ -213,6 +285,7 @@ int main(int argc, char *argv[]) {
 
         assert_se(varlink_server_bind_method(s, "io.test.DoSomething", method_something) >= 0);
         assert_se(varlink_server_bind_method(s, "io.test.Done", method_done) >= 0);
+        assert_se(varlink_server_bind_method(s, "io.test.Stream", method_stream) >= 0);
         assert_se(varlink_server_bind_connect(s, on_connect) >= 0);
         assert_se(varlink_server_listen_address(s, sp, 0600) >= 0);
         assert_se(varlink_server_attach_event(s, e, 0) >= 0);
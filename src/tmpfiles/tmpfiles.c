@@ -403,21 +403,54 @@ static bool takes_ownership(ItemType t) {
                       RECURSIVE_REMOVE_PATH);
 }
 
-static struct Item* find_glob(OrderedHashmap *h, const char *match) {
+static struct Item* find_glob(Item **l, size_t n, const char *match) {
+        for (size_t k = 0; k < n; k++)
+                if (fnmatch(l[k]->path, match, FNM_PATHNAME|FNM_PERIOD) == 0)
+                        return l[k];
+
+        return NULL;
+}
+
+static int find_glob_candidates(OrderedHashmap *h, const char *dir, Item ***ret, size_t *ret_n) {
+        _cleanup_free_ Item **l = NULL;
+        size_t n = 0;
         ItemArray *j;
 
-        ORDERED_HASHMAP_FOREACH(j, h) {
-                size_t n;
+        assert(dir);
+        assert(ret);
+        assert(ret_n);
 
-                for (n = 0; n < j->n_items; n++) {
-                        Item *item = j->items + n;
+        /* Globs are matched with FNM_PATHNAME, i.e. component by component, hence a glob can only match an
+         * entry of the specified directory if its directory part matches the directory itself. Collect
+         * those globs, so that the entries of a directory with many files need not be checked against
+         * all of them. Globs whose directory part we can't split off safely are always included. */
 
-                        if (fnmatch(item->path, match, FNM_PATHNAME|FNM_PERIOD) == 0)
-                                return item;
+        ORDERED_HASHMAP_FOREACH(j, h)
+                for (size_t k = 0; k < j->n_items; k++) {
+                        Item *item = j->items + k;
+                        const char *e;
+
+                        e = strrchr(item->path, '/');
+                        if (e && e > item->path && e[-1] != '\\' && !strchr(e, ']')) {
+                                _cleanup_free_ char *d = NULL;
+
+                                d = strndup(item->path, e - item->path);
+                                if (!d)
+                                        return -ENOMEM;
+
+                                if (fnmatch(d, dir, FNM_PATHNAME|FNM_PERIOD) != 0)
+                                        continue;
+                        }
+
+                        if (!GREEDY_REALLOC(l, n + 1))
+                                return -ENOMEM;
+
+                        l[n++] = item;
                 }
-        }
 
-        return NULL;
+        *ret = TAKE_PTR(l);
+        *ret_n = n;
+        return 0;
 }
 
 static int load_unix_sockets(void) {
@@ -606,10 +639,16 @@ static int dir_cleanup(
                 AgeBy age_by_file,
                 AgeBy age_by_dir) {
 
+        _cleanup_free_ Item **glob_candidates = NULL;
+        size_t n_glob_candidates = 0;
         bool deleted = false;
         struct dirent *dent;
         int r = 0;
 
+        r = find_glob_candidates(globs, p, &glob_candidates, &n_glob_candidates);
+        if (r < 0)
+                return log_oom();
+
         FOREACH_DIRENT_ALL(dent, d, break) {
                 _cleanup_free_ char *sub_path = NULL;
                 nsec_t atime_nsec, mtime_nsec, ctime_nsec, btime_nsec;
@@ -692,7 +731,7 @@ static int dir_cleanup(
                         continue;
                 }
 
-                if (find_glob(globs, sub_path)) {
+                if (find_glob(glob_candidates, n_glob_candidates, sub_path)) {
                         log_debug("Ignoring \"%s\": a separate glob exists.", sub_path);
                         continue;
                 }
@@ -1943,17 +1982,16 @@ static int item_do(Item *i, int fd, const char *path, fdaction_t action) {
         r = action(i, fd, path, &st);
 
         if (S_ISDIR(st.st_mode)) {
-                char procfs_path[STRLEN("/proc/self/fd/") + DECIMAL_STR_MAX(int)];
                 _cleanup_closedir_ DIR *d = NULL;
                 struct dirent *de;
 
-                /* The passed 'fd' was opened with O_PATH. We need to convert
-                 * it into a 'regular' fd before reading the directory content. */
-                xsprintf(procfs_path, "/proc/self/fd/%i", fd);
-
-                d = opendir(procfs_path);
+                /* The passed 'fd' was opened with O_PATH. We need to convert it into a 'regular' fd
+                 * before reading the directory content. Do so relative to the fd itself rather than via
+                 * /proc/self/fd/, which saves a full path lookup through procfs for each directory of the
+                 * tree. */
+                d = xopendirat(fd, ".", O_NOFOLLOW);
                 if (!d) {
-                        log_error_errno(errno, "Failed to opendir() '%s': %m", procfs_path);
+                        log_error_errno(errno, "Failed to open directory '%s': %m", path);
                         if (r == 0)
                                 r = -errno;
                         goto finish;
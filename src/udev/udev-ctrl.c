@@ -160,6 +160,25 @@ sd_event_source *udev_ctrl_get_event_source(struct udev_ctrl *uctrl) {
         return uctrl->event_source;
 }
 
+int udev_ctrl_take_connection(struct udev_ctrl *uctrl) {
+        int fd;
+
+        assert(uctrl);
+
+        /* Hands the current connection over to the caller, and accepts new connections again. The
+         * connected client will be notified by closing the returned fd. */
+
+        if (uctrl->sock_connect < 0)
+                return -ENOTCONN;
+
+        uctrl->event_source_connect = sd_event_source_unref(uctrl->event_source_connect);
+        fd = TAKE_FD(uctrl->sock_connect);
+
+        (void) sd_event_source_set_enabled(uctrl->event_source, SD_EVENT_ON);
+
+        return fd;
+}
+
 static void udev_ctrl_disconnect_and_listen_again(struct udev_ctrl *uctrl) {
         udev_ctrl_disconnect(uctrl);
         udev_ctrl_unref(uctrl);
@@ -18,6 +18,7 @@ enum udev_ctrl_msg_type {
         UDEV_CTRL_SET_CHILDREN_MAX,
         UDEV_CTRL_PING,
         UDEV_CTRL_EXIT,
+        UDEV_CTRL_WAIT_QUEUE_EMPTY,
 };
 
 union udev_ctrl_msg_value {
@@ -40,6 +41,7 @@ int udev_ctrl_cleanup(struct udev_ctrl *uctrl);
 int udev_ctrl_attach_event(struct udev_ctrl *uctrl, sd_event *event);
 int udev_ctrl_start(struct udev_ctrl *uctrl, udev_ctrl_handler_t callback, void *userdata);
 sd_event_source *udev_ctrl_get_event_source(struct udev_ctrl *uctrl);
+int udev_ctrl_take_connection(struct udev_ctrl *uctrl);
 
 int udev_ctrl_wait(struct udev_ctrl *uctrl, usec_t timeout);
 
@@ -72,6 +74,10 @@ static inline int udev_ctrl_send_ping(struct udev_ctrl *uctrl) {
         return udev_ctrl_send(uctrl, UDEV_CTRL_PING, 0, NULL);
 }
 
+static inline int udev_ctrl_send_wait_queue_empty(struct udev_ctrl *uctrl) {
+        return udev_ctrl_send(uctrl, UDEV_CTRL_WAIT_QUEUE_EMPTY, 0, NULL);
+}
+
 static inline int udev_ctrl_send_exit(struct udev_ctrl *uctrl) {
         return udev_ctrl_send(uctrl, UDEV_CTRL_EXIT, 0, NULL);
 }
@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -18,6 +19,7 @@
 #include "fs-util.h"
 #include "hexdecoct.h"
 #include "mkdir.h"
+#include "parse-util.h"
 #include "path-util.h"
 #include "selinux-util.h"
 #include "smack-util.h"
@@ -129,6 +131,73 @@ static int node_symlink(sd_device *dev, const char *node, const char *slink) {
         return 1;
 }
 
+static int stack_entry_read(int dir_fd, const char *name, int *ret_priority, char **ret_devnode) {
+        _cleanup_(sd_device_unrefp) sd_device *dev = NULL;
+        _cleanup_free_ char *buf = NULL;
+        const char *devnode;
+        int r, priority;
+        char *colon;
+
+        assert(dir_fd >= 0);
+        assert(name);
+        assert(ret_priority);
+        assert(ret_devnode);
+
+        /* Entries in the stack directory are symlinks pointing to "<priority>:<devnode>", so that we
+         * don't need to read the uevent file and the udev database of every device claiming the same
+         * symlink. Entries created by older versions are empty regular files, for those look at the
+         * device itself. */
+
+        r = readlinkat_malloc(dir_fd, name, &buf);
+        if (r >= 0) {
+                colon = strchr(buf, ':');
+                if (!colon)
+                        return -EINVAL;
+
+                *colon = '\0';
+
+                r = safe_atoi(buf, &priority);
+                if (r < 0)
+                        return r;
+
+                if (!path_startswith(colon + 1, "/dev"))
+                        return -EINVAL;
+
+                /* Left-over entries of devices that are gone must not win */
+                if (access(colon + 1, F_OK) < 0)
+                        return -errno;
+
+                /* Move the devnode to the beginning of the buffer, and hand out the buffer */
+                memmove(buf, colon + 1, strlen(colon + 1) + 1);
+
+                *ret_priority = priority;
+                *ret_devnode = TAKE_PTR(buf);
+                return 0;
+        }
+        if (r != -EINVAL) /* EINVAL means this is not a symlink */
+                return r;
+
+        r = sd_device_new_from_device_id(&dev, name);
+        if (r < 0)
+                return r;
+
+        r = sd_device_get_devname(dev, &devnode);
+        if (r < 0)
+                return r;
+
+        r = device_get_devlink_priority(dev, &priority);
+        if (r < 0)
+                return r;
+
+        buf = strdup(devnode);
+        if (!buf)
+                return -ENOMEM;
+
+        *ret_priority = priority;
+        *ret_devnode = TAKE_PTR(buf);
+        return 0;
+}
+
 static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir, char **ret) {
         _cleanup_closedir_ DIR *dir = NULL;
         _cleanup_free_ char *target = NULL;
@@ -174,8 +243,7 @@ static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir,
                 return r;
 
         FOREACH_DIRENT_ALL(dent, dir, break) {
-                _cleanup_(sd_device_unrefp) sd_device *dev_db = NULL;
-                const char *devnode;
+                _cleanup_free_ char *devnode = NULL;
                 int db_prio = 0;
 
                 if (dent->d_name[0] == '\0')
@@ -189,23 +257,16 @@ static int link_find_prioritized(sd_device *dev, bool add, const char *stackdir,
                 if (streq(dent->d_name, id))
                         continue;
 
-                if (sd_device_new_from_device_id(&dev_db, dent->d_name) < 0)
-                        continue;
-
-                if (sd_device_get_devname(dev_db, &devnode) < 0)
-                        continue;
-
-                if (device_get_devlink_priority(dev_db, &db_prio) < 0)
+                if (stack_entry_read(dirfd(dir), dent->d_name, &db_prio, &devnode) < 0)
                         continue;
 
                 if (target && db_prio <= priority)
                         continue;
 
-                log_device_debug(dev_db, "Device claims priority %i for '%s'", db_prio, stackdir);
+                log_device_debug(dev, "Device %s (%s) claims priority %i for '%s'",
+                                 dent->d_name, devnode, db_prio, stackdir);
 
-                r = free_and_strdup(&target, devnode);
-                if (r < 0)
-                        return r;
+                free_and_replace(target, devnode);
                 priority = db_prio;
         }
 
@@ -297,10 +358,28 @@ static int link_update(sd_device *dev, const char *slink_in, bool add) {
 
                 (void) rmdir(dirname);
         } else {
+                _cleanup_free_ char *data = NULL;
+                const char *devnode;
+                int priority;
+
+                r = device_get_devlink_priority(dev, &priority);
+                if (r < 0)
+                        return log_device_debug_errno(dev, r, "Failed to get devlink priority: %m");
+
+                r = sd_device_get_devname(dev, &devnode);
+                if (r < 0)
+                        return log_device_debug_errno(dev, r, "Failed to get device node: %m");
+
+                /* See stack_entry_read() */
+                if (asprintf(&data, "%i:%s", priority, devnode) < 0)
+                        return log_oom_debug();
+
                 for (unsigned j = 0; j < TOUCH_FILE_MAX_RETRIES; j++) {
                         /* This may fail with -ENOENT when the parent directory is removed during
                          * creating the file by another udevd worker. */
-                        r = touch_file(filename, /* parents= */ true, USEC_INFINITY, UID_INVALID, GID_INVALID, 0444);
+                        r = mkdir_parents(filename, 0755);
+                        if (r >= 0)
+                                r = symlink_atomic(data, filename);
                         if (r != -ENOENT)
                                 break;
                 }
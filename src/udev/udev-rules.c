@@ -36,6 +36,13 @@
 
 #define RULES_DIRS (const char* const*) CONF_PATHS_STRV("udev/rules.d")
 
+/* Besides the rules files themselves, parsed rules depend on the user and group names resolved while
+ * parsing them. */
+static const char* const rules_extra_sources[] = {
+        "/etc/passwd",
+        "/etc/group",
+};
+
 typedef enum {
         OP_MATCH,        /* == */
         OP_NOMATCH,      /* != */
@@ -166,6 +173,11 @@ struct UdevRuleLine {
         UdevRuleToken *current_token;
         LIST_HEAD(UdevRuleToken, tokens);
         LIST_FIELDS(UdevRuleLine, rule_lines);
+
+        /* The first ACTION and SUBSYSTEM match of the line, if any. These are checked before everything
+         * else, against values looked up once per event, so that lines for other devices are cheap to skip. */
+        UdevRuleToken *action_token;
+        UdevRuleToken *subsystem_token;
 };
 
 struct UdevRuleFile {
@@ -180,6 +192,8 @@ struct UdevRules {
         ResolveNameTiming resolve_name_timing;
         Hashmap *known_users;
         Hashmap *known_groups;
+        Hashmap *source_stats; /* path → struct stat of all files the rules were built from, at load time */
+        bool names_from_nss;   /* some user or group name was not (only) looked up in the files above */
         UdevRuleFile *current_file;
         LIST_HEAD(UdevRuleFile, rule_files);
 };
@@ -275,6 +289,7 @@ static void udev_rule_line_clear_tokens(UdevRuleLine *rule_line) {
                 udev_rule_token_free(i);
 
         rule_line->tokens = NULL;
+        rule_line->action_token = rule_line->subsystem_token = NULL;
 }
 
 static UdevRuleLine* udev_rule_line_free(UdevRuleLine *rule_line) {
@@ -320,9 +335,56 @@ UdevRules *udev_rules_free(UdevRules *rules) {
 
         hashmap_free_free_key(rules->known_users);
         hashmap_free_free_key(rules->known_groups);
+        hashmap_free(rules->source_stats);
         return mfree(rules);
 }
 
+static bool rule_name_in_db_file(const char *path, const char *name, bool group) {
+        _cleanup_fclose_ FILE *f = NULL;
+
+        assert(path);
+        assert(name);
+
+        f = fopen(path, "re");
+        if (!f)
+                return false;
+
+        for (;;) {
+                if (group) {
+                        struct group *gr;
+
+                        if (fgetgrent_sane(f, &gr) <= 0)
+                                return false;
+                        if (streq(gr->gr_name, name))
+                                return true;
+                } else {
+                        struct passwd *pw;
+
+                        if (fgetpwent_sane(f, &pw) <= 0)
+                                return false;
+                        if (streq(pw->pw_name, name))
+                                return true;
+                }
+        }
+}
+
+static void rule_note_name_source(UdevRules *rules, const char *name, bool group) {
+        assert(rules);
+        assert(name);
+
+        /* Only changes to /etc/passwd and /etc/group are noticed when deciding whether the rules need to be
+         * parsed again. A name that other NSS modules answered (or may answer later, if it is not known
+         * yet) can change without them, hence remember that the rules must not be reused. */
+        if (rules->names_from_nss)
+                return;
+
+        if (group ? parse_gid(name, NULL) >= 0 : parse_uid(name, NULL) >= 0)
+                return;
+
+        if (!rule_name_in_db_file(group ? "/etc/group" : "/etc/passwd", name, group))
+                rules->names_from_nss = true;
+}
+
 static int rule_resolve_user(UdevRules *rules, const char *name, uid_t *ret) {
         _cleanup_free_ char *n = NULL;
         uid_t uid;
@@ -338,6 +400,8 @@ static int rule_resolve_user(UdevRules *rules, const char *name, uid_t *ret) {
                 return 0;
         }
 
+        rule_note_name_source(rules, name, false);
+
         r = get_user_creds(&name, &uid, NULL, NULL, NULL, USER_CREDS_ALLOW_MISSING);
         if (r < 0) {
                 log_unknown_owner(NULL, rules, r, "user", name);
@@ -373,6 +437,8 @@ static int rule_resolve_group(UdevRules *rules, const char *name, gid_t *ret) {
                 return 0;
         }
 
+        rule_note_name_source(rules, name, true);
+
         r = get_group_creds(&name, &gid, USER_CREDS_ALLOW_MISSING);
         if (r < 0) {
                 log_unknown_owner(NULL, rules, r, "group", name);
@@ -1080,6 +1146,24 @@ static void sort_tokens(UdevRuleLine *rule_line) {
         }
 }
 
+static void rule_line_find_prefilter_tokens(UdevRuleLine *rule_line) {
+        UdevRuleToken *t;
+
+        assert(rule_line);
+
+        /* All match tokens up to TK_M_SUBSYSTEM are side-effect free, hence evaluating the ACTION and
+         * SUBSYSTEM matches out of order doesn't change the outcome of the line. */
+        LIST_FOREACH(tokens, t, rule_line->tokens) {
+                if (t->type > TK_M_SUBSYSTEM)
+                        break;
+
+                if (t->type == TK_M_ACTION && !rule_line->action_token)
+                        rule_line->action_token = t;
+                else if (t->type == TK_M_SUBSYSTEM && !rule_line->subsystem_token)
+                        rule_line->subsystem_token = t;
+        }
+}
+
 static int rule_add_line(UdevRules *rules, const char *line_str, unsigned line_nr) {
         _cleanup_(udev_rule_line_freep) UdevRuleLine *rule_line = NULL;
         _cleanup_free_ char *line = NULL;
@@ -1140,6 +1224,7 @@ static int rule_add_line(UdevRules *rules, const char *line_str, unsigned line_n
         }
 
         sort_tokens(rule_line);
+        rule_line_find_prefilter_tokens(rule_line);
         TAKE_PTR(rule_line);
         return 0;
 }
@@ -1296,6 +1381,100 @@ UdevRules* udev_rules_new(ResolveNameTiming resolve_name_timing) {
         return rules;
 }
 
+static int udev_rules_add_source(UdevRules *rules, const char *path) {
+        _cleanup_free_ struct stat *st = NULL;
+        _cleanup_free_ char *p = NULL;
+        int r;
+
+        assert(rules);
+        assert(path);
+
+        st = new0(struct stat, 1);
+        if (!st)
+                return -ENOMEM;
+
+        /* A file that doesn't exist is recorded with a zeroed stat structure */
+        if (stat(path, st) < 0)
+                *st = (struct stat) {};
+
+        p = strdup(path);
+        if (!p)
+                return -ENOMEM;
+
+        r = hashmap_ensure_put(&rules->source_stats, &path_hash_ops_free_free, p, st);
+        if (r == -EEXIST)
+                return 0;
+        if (r < 0)
+                return r;
+
+        TAKE_PTR(p);
+        TAKE_PTR(st);
+        return 0;
+}
+
+static int udev_rules_add_sources(UdevRules *rules, char **files) {
+        char **f;
+        int r;
+
+        assert(rules);
+
+        /* Called before the files are read, so that changes made while we parse them are noticed later. */
+
+        STRV_FOREACH(f, files) {
+                r = udev_rules_add_source(rules, *f);
+                if (r < 0)
+                        return r;
+        }
+
+        for (size_t i = 0; i < ELEMENTSOF(rules_extra_sources); i++) {
+                r = udev_rules_add_source(rules, rules_extra_sources[i]);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+static bool udev_rules_source_unmodified(UdevRules *rules, const char *path) {
+        struct stat *old, st;
+
+        assert(rules);
+        assert(path);
+
+        old = hashmap_get(rules->source_stats, path);
+        if (!old)
+                return false;
+
+        if (stat(path, &st) < 0)
+                return errno == ENOENT && (old->st_mode & S_IFMT) == 0;
+
+        return stat_inode_unmodified(old, &st);
+}
+
+bool udev_rules_sources_unmodified(UdevRules *rules) {
+        _cleanup_strv_free_ char **files = NULL;
+        char **f;
+
+        if (!rules || !rules->source_stats || rules->names_from_nss)
+                return false;
+
+        if (conf_files_list_strv(&files, ".rules", NULL, 0, RULES_DIRS) < 0)
+                return false;
+
+        if (strv_length(files) + ELEMENTSOF(rules_extra_sources) != hashmap_size(rules->source_stats))
+                return false;
+
+        STRV_FOREACH(f, files)
+                if (!udev_rules_source_unmodified(rules, *f))
+                        return false;
+
+        for (size_t i = 0; i < ELEMENTSOF(rules_extra_sources); i++)
+                if (!udev_rules_source_unmodified(rules, rules_extra_sources[i]))
+                        return false;
+
+        return true;
+}
+
 int udev_rules_load(UdevRules **ret_rules, ResolveNameTiming resolve_name_timing) {
         _cleanup_(udev_rules_freep) UdevRules *rules = NULL;
         _cleanup_strv_free_ char **files = NULL;
@@ -1312,6 +1491,13 @@ int udev_rules_load(UdevRules **ret_rules, ResolveNameTiming resolve_name_timing
         if (r < 0)
                 return log_debug_errno(r, "Failed to enumerate rules files: %m");
 
+        r = udev_rules_add_sources(rules, files);
+        if (r < 0) {
+                /* Not fatal, this only means we'll always reload the rules when asked to */
+                log_debug_errno(r, "Failed to record rules sources, ignoring: %m");
+                rules->source_stats = hashmap_free(rules->source_stats);
+        }
+
         STRV_FOREACH(f, files) {
                 r = udev_rules_parse_file(rules, *f);
                 if (r < 0)
@@ -2279,31 +2465,26 @@ static int udev_rule_apply_parent_token_to_event(
 static int udev_rule_apply_line_to_event(
                 UdevRules *rules,
                 UdevEvent *event,
+                UdevRuleLineType mask,
+                const char *action,
+                const char *subsystem,
                 usec_t timeout_usec,
                 int timeout_signal,
                 Hashmap *properties_list,
                 UdevRuleLine **next_line) {
 
         UdevRuleLine *line = rules->current_file->current_line;
-        UdevRuleLineType mask = LINE_HAS_GOTO | LINE_UPDATE_SOMETHING;
         UdevRuleToken *token, *next_token;
         bool parents_done = false;
-        sd_device_action_t action;
         int r;
 
-        r = sd_device_get_action(event->dev, &action);
-        if (r < 0)
-                return r;
-
-        if (action != SD_DEVICE_REMOVE) {
-                if (sd_device_get_devnum(event->dev, NULL) >= 0)
-                        mask |= LINE_HAS_DEVLINK;
+        if ((line->type & mask) == 0)
+                return 0;
 
-                if (sd_device_get_ifindex(event->dev, NULL) >= 0)
-                        mask |= LINE_HAS_NAME;
-        }
+        if (line->action_token && !token_match_string(line->action_token, action))
+                return 0;
 
-        if ((line->type & mask) == 0)
+        if (line->subsystem_token && !token_match_string(line->subsystem_token, subsystem))
                 return 0;
 
         event->esc = ESCAPE_UNSET;
@@ -2311,6 +2492,9 @@ static int udev_rule_apply_line_to_event(
         DEVICE_TRACE_POINT(rules_apply_line, event->dev, line->rule_file->filename, line->line_number);
 
         LIST_FOREACH_SAFE(tokens, token, next_token, line->tokens) {
+                if (token == line->action_token || token == line->subsystem_token)
+                        continue; /* already checked above */
+
                 line->current_token = token;
 
                 if (token_is_for_parents(token)) {
@@ -2343,6 +2527,9 @@ int udev_rules_apply_to_event(
                 int timeout_signal,
                 Hashmap *properties_list) {
 
+        UdevRuleLineType mask = LINE_HAS_GOTO | LINE_UPDATE_SOMETHING;
+        const char *subsystem = NULL;
+        sd_device_action_t action;
         UdevRuleFile *file;
         UdevRuleLine *next_line;
         int r;
@@ -2350,10 +2537,29 @@ int udev_rules_apply_to_event(
         assert(rules);
         assert(event);
 
+        /* Look up everything the lines are filtered on only once, rather than for each line */
+        r = sd_device_get_action(event->dev, &action);
+        if (r < 0)
+                return r;
+
+        if (action != SD_DEVICE_REMOVE) {
+                if (sd_device_get_devnum(event->dev, NULL) >= 0)
+                        mask |= LINE_HAS_DEVLINK;
+
+                if (sd_device_get_ifindex(event->dev, NULL) >= 0)
+                        mask |= LINE_HAS_NAME;
+        }
+
+        r = sd_device_get_subsystem(event->dev, &subsystem);
+        if (r < 0 && r != -ENOENT)
+                return log_device_error_errno(event->dev, r, "Failed to get subsystem: %m");
+
         LIST_FOREACH(rule_files, file, rules->rule_files) {
                 rules->current_file = file;
                 LIST_FOREACH_SAFE(rule_lines, file->current_line, next_line, file->rule_lines) {
-                        r = udev_rule_apply_line_to_event(rules, event, timeout_usec, timeout_signal, properties_list, &next_line);
+                        r = udev_rule_apply_line_to_event(rules, event, mask,
+                                                          device_action_to_string(action), subsystem,
+                                                          timeout_usec, timeout_signal, properties_list, &next_line);
                         if (r < 0)
                                 return r;
                 }
@@ -174,18 +174,30 @@ int settle_main(int argc, char *argv[], void *userdata) {
 
         deadline = now(CLOCK_MONOTONIC) + arg_timeout;
 
+        /* Warn before waiting, the daemon might well keep us busy until the queue is empty */
+        (void) emit_deprecation_warning();
+
         /* guarantee that the udev daemon isn't pre-processing */
         if (getuid() == 0) {
                 _cleanup_(udev_ctrl_unrefp) struct udev_ctrl *uctrl = NULL;
 
                 if (udev_ctrl_new(&uctrl) >= 0) {
-                        r = udev_ctrl_send_ping(uctrl);
+                        /* Without --exit-if-exists, ask the daemon to keep the connection open until its
+                         * queue is empty, so that we don't need to watch the queue file at all. Daemons
+                         * which don't know the message reply right away, and the checks below still
+                         * apply. */
+                        if (arg_exists)
+                                r = udev_ctrl_send_ping(uctrl);
+                        else
+                                r = udev_ctrl_send_wait_queue_empty(uctrl);
                         if (r < 0) {
                                 log_debug_errno(r, "Failed to connect to udev daemon: %m");
                                 return 0;
                         }
 
-                        r = udev_ctrl_wait(uctrl, MAX(5 * USEC_PER_SEC, arg_timeout));
+                        r = udev_ctrl_wait(uctrl, arg_exists ? MAX(5 * USEC_PER_SEC, arg_timeout) : arg_timeout);
+                        if (r == -ETIMEDOUT && !arg_exists)
+                                return r;
                         if (r < 0)
                                 return log_error_errno(r, "Failed to wait for daemon to reply: %m");
                 }
@@ -197,8 +209,6 @@ int settle_main(int argc, char *argv[], void *userdata) {
                 return 0;
         }
 
-        (void) emit_deprecation_warning();
-
         for (;;) {
                 if (arg_exists && access(arg_exists, F_OK) >= 0)
                         return 0;
@@ -94,12 +94,19 @@ typedef struct Manager {
         struct udev_ctrl *ctrl;
         int worker_watch[2];
 
+        /* Control connections of clients waiting for the queue to become empty */
+        int *queue_waiters;
+        size_t n_queue_waiters;
+
         /* used by udev-watch */
         int inotify_fd;
         sd_event_source *inotify_event;
 
         sd_event_source *kill_workers_event;
 
+        /* Queued events indexed by the keys they may block other events on, see event_index_keys(). */
+        Hashmap *event_index;
+
         usec_t last_usec;
 
         bool stop_exec_queue;
@@ -112,6 +119,9 @@ enum event_state {
         EVENT_RUNNING,
 };
 
+typedef struct EventIndexBucket EventIndexBucket;
+typedef struct EventIndexEntry EventIndexEntry;
+
 struct event {
         Manager *manager;
         struct worker *worker;
@@ -123,12 +133,27 @@ struct event {
         uint64_t seqnum;
         uint64_t delaying_seqnum;
 
+        EventIndexEntry *index_entries;
+        size_t n_index_entries;
+
         sd_event_source *timeout_warning_event;
         sd_event_source *timeout_event;
 
         LIST_FIELDS(struct event, event);
 };
 
+/* All queued events with the same index key, in queue order, and hence ordered by seqnum */
+struct EventIndexBucket {
+        char *key;
+        LIST_HEAD(EventIndexEntry, entries);
+};
+
+struct EventIndexEntry {
+        struct event *event;
+        EventIndexBucket *bucket;
+        LIST_FIELDS(EventIndexEntry, entries);
+};
+
 static void event_queue_cleanup(Manager *manager, enum event_state type);
 
 enum worker_state {
@@ -151,12 +176,191 @@ struct worker {
 struct worker_message {
 };
 
+static EventIndexBucket* event_index_bucket_free(EventIndexBucket *b) {
+        if (!b)
+                return NULL;
+
+        assert(LIST_IS_EMPTY(b->entries));
+
+        free(b->key);
+        return mfree(b);
+}
+
+DEFINE_PRIVATE_HASH_OPS_WITH_VALUE_DESTRUCTOR(event_index_hash_ops, char, string_hash_func, string_compare_func,
+                                              EventIndexBucket, event_index_bucket_free);
+
+static int event_index_keys(struct event *event, bool lookup, char ***ret) {
+        _cleanup_strv_free_ char **keys = NULL;
+        const char *subsystem = NULL, *devpath, *devpath_old = NULL;
+        dev_t devnum = makedev(0, 0);
+        int r, ifindex = 0;
+
+        assert(event);
+        assert(ret);
+
+        /* An event has to wait for an earlier one, if both are about the same device node or network
+         * interface, if the earlier one is about the same device path or the old device path of a renamed
+         * device, or if the device paths are parent and child of each other. The keys an event is indexed
+         * under (lookup == false) are chosen so that looking up the keys of a later event (lookup == true)
+         * finds exactly the events it has to wait for:
+         *
+         *   devpath:<path>   - indexed by the own path, looked up by the own path, old path and all parents
+         *   children:<path>  - indexed by all parent paths, looked up by the own path
+         *   devnum:<b|c>:<maj>:<min>, ifindex:<n> - both ways */
+
+        r = sd_device_get_subsystem(event->dev, &subsystem);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        r = sd_device_get_devpath(event->dev, &devpath);
+        if (r < 0)
+                return r;
+
+        r = sd_device_get_devnum(event->dev, &devnum);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        r = sd_device_get_ifindex(event->dev, &ifindex);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        if (lookup) {
+                r = sd_device_get_property_value(event->dev, "DEVPATH_OLD", &devpath_old);
+                if (r < 0 && r != -ENOENT)
+                        return r;
+        }
+
+        r = strv_extendf(&keys, "devpath:%s", devpath);
+        if (r < 0)
+                return r;
+
+        if (lookup) {
+                r = strv_extendf(&keys, "children:%s", devpath);
+                if (r < 0)
+                        return r;
+        }
+
+        if (devpath_old) {
+                r = strv_extendf(&keys, "devpath:%s", devpath_old);
+                if (r < 0)
+                        return r;
+        }
+
+        for (const char *p = strrchr(devpath, '/'); p && p > devpath; p = memrchr(devpath, '/', p - devpath)) {
+                r = strv_extendf(&keys, "%s:%.*s", lookup ? "devpath" : "children", (int) (p - devpath), devpath);
+                if (r < 0)
+                        return r;
+        }
+
+        if (major(devnum) != 0) {
+                r = strv_extendf(&keys, "devnum:%c:%u:%u", streq_ptr(subsystem, "block") ? 'b' : 'c',
+                                 major(devnum), minor(devnum));
+                if (r < 0)
+                        return r;
+        }
+
+        if (ifindex > 0) {
+                r = strv_extendf(&keys, "ifindex:%i", ifindex);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = TAKE_PTR(keys);
+        return 0;
+}
+
+static void event_index_remove(struct event *event) {
+        assert(event);
+
+        for (size_t i = 0; i < event->n_index_entries; i++) {
+                EventIndexEntry *e = event->index_entries + i;
+                EventIndexBucket *b = e->bucket;
+
+                if (!b)
+                        continue;
+
+                LIST_REMOVE(entries, b->entries, e);
+                if (LIST_IS_EMPTY(b->entries))
+                        event_index_bucket_free(hashmap_remove(event->manager->event_index, b->key));
+        }
+
+        event->index_entries = mfree(event->index_entries);
+        event->n_index_entries = 0;
+}
+
+static int event_index_add(struct event *event) {
+        _cleanup_strv_free_ char **keys = NULL;
+        Manager *manager;
+        size_t n;
+        char **k;
+        int r;
+
+        assert(event);
+        assert(event->manager);
+        assert(!event->index_entries);
+
+        manager = event->manager;
+
+        r = event_index_keys(event, false, &keys);
+        if (r < 0)
+                return r;
+
+        n = strv_length(keys);
+        event->index_entries = new0(EventIndexEntry, n);
+        if (!event->index_entries)
+                return -ENOMEM;
+        event->n_index_entries = n;
+
+        r = hashmap_ensure_allocated(&manager->event_index, &event_index_hash_ops);
+        if (r < 0)
+                goto fail;
+
+        n = 0;
+        STRV_FOREACH(k, keys) {
+                EventIndexEntry *e = event->index_entries + n++;
+                EventIndexBucket *b;
+
+                b = hashmap_get(manager->event_index, *k);
+                if (!b) {
+                        b = new0(EventIndexBucket, 1);
+                        if (!b) {
+                                r = -ENOMEM;
+                                goto fail;
+                        }
+
+                        b->key = strdup(*k);
+                        if (!b->key) {
+                                event_index_bucket_free(b);
+                                r = -ENOMEM;
+                                goto fail;
+                        }
+
+                        r = hashmap_put(manager->event_index, b->key, b);
+                        if (r < 0) {
+                                event_index_bucket_free(b);
+                                goto fail;
+                        }
+                }
+
+                e->event = event;
+                e->bucket = b;
+                LIST_APPEND(entries, b->entries, e);
+        }
+
+        return 0;
+
+fail:
+        event_index_remove(event);
+        return r;
+}
+
 static void event_free(struct event *event) {
         if (!event)
                 return;
 
         assert(event->manager);
 
+        event_index_remove(event);
         LIST_REMOVE(event, event->manager->events, event);
         sd_device_unref(event->dev);
         sd_device_unref(event->dev_kernel);
@@ -273,6 +477,14 @@ static void worker_attach_event(struct worker *worker, struct event *event) {
                                           on_event_timeout, event);
 }
 
+static void manager_close_queue_waiters(Manager *manager) {
+        assert(manager);
+
+        close_many(manager->queue_waiters, manager->n_queue_waiters);
+        manager->queue_waiters = mfree(manager->queue_waiters);
+        manager->n_queue_waiters = 0;
+}
+
 static void manager_clear_for_worker(Manager *manager) {
         assert(manager);
 
@@ -286,6 +498,7 @@ static void manager_clear_for_worker(Manager *manager) {
 
         manager->monitor = sd_device_monitor_unref(manager->monitor);
         manager->ctrl = udev_ctrl_unref(manager->ctrl);
+        manager_close_queue_waiters(manager);
 
         manager->worker_watch[READ_END] = safe_close(manager->worker_watch[READ_END]);
 }
@@ -305,6 +518,7 @@ static Manager* manager_free(Manager *manager) {
 
         hashmap_free_free_free(manager->properties);
         udev_rules_free(manager->rules);
+        hashmap_free(manager->event_index);
 
         safe_close(manager->inotify_fd);
         safe_close_pair(manager->worker_watch);
@@ -721,6 +935,14 @@ static int event_queue_insert(Manager *manager, sd_device *dev) {
                 .state = EVENT_QUEUED,
         };
 
+        r = event_index_add(event);
+        if (r < 0) {
+                sd_device_unref(event->dev);
+                sd_device_unref(event->dev_kernel);
+                free(event);
+                return r;
+        }
+
         if (LIST_IS_EMPTY(manager->events)) {
                 r = touch("/run/udev/queue");
                 if (r < 0)
@@ -755,112 +977,44 @@ static void manager_kill_workers(Manager *manager, bool force) {
 
 /* lookup event for identical, parent, child device */
 static int is_device_busy(Manager *manager, struct event *event) {
-        const char *subsystem, *devpath, *devpath_old = NULL;
-        dev_t devnum = makedev(0, 0);
-        struct event *loop_event;
-        size_t devpath_len;
-        int r, ifindex = 0;
-        bool is_block;
-
-        r = sd_device_get_subsystem(event->dev, &subsystem);
-        if (r < 0)
-                return r;
+        _cleanup_strv_free_ char **keys = NULL;
+        struct event *blocker = NULL;
+        char **k;
+        int r;
 
-        is_block = streq(subsystem, "block");
+        assert(manager);
+        assert(event);
 
-        r = sd_device_get_devpath(event->dev, &devpath);
+        r = event_index_keys(event, true, &keys);
         if (r < 0)
                 return r;
 
-        devpath_len = strlen(devpath);
-
-        r = sd_device_get_property_value(event->dev, "DEVPATH_OLD", &devpath_old);
-        if (r < 0 && r != -ENOENT)
-                return r;
-
-        r = sd_device_get_devnum(event->dev, &devnum);
-        if (r < 0 && r != -ENOENT)
-                return r;
-
-        r = sd_device_get_ifindex(event->dev, &ifindex);
-        if (r < 0 && r != -ENOENT)
-                return r;
+        /* check if queue contains events we depend on. Each bucket is ordered by seqnum, hence only its
+         * first entry is of interest. */
+        STRV_FOREACH(k, keys) {
+                EventIndexBucket *b;
 
-        /* check if queue contains events we depend on */
-        LIST_FOREACH(event, loop_event, manager->events) {
-                size_t loop_devpath_len, common;
-                const char *loop_devpath;
-
-                /* we already found a later event, earlier cannot block us, no need to check again */
-                if (loop_event->seqnum < event->delaying_seqnum)
+                b = hashmap_get(manager->event_index, *k);
+                if (!b)
                         continue;
 
-                /* event we checked earlier still exists, no need to check again */
-                if (loop_event->seqnum == event->delaying_seqnum)
-                        return true;
-
-                /* found ourself, no later event can block us */
-                if (loop_event->seqnum >= event->seqnum)
-                        break;
-
-                /* check major/minor */
-                if (major(devnum) != 0) {
-                        const char *s;
-                        dev_t d;
-
-                        if (sd_device_get_subsystem(loop_event->dev, &s) < 0)
-                                continue;
-
-                        if (sd_device_get_devnum(loop_event->dev, &d) >= 0 &&
-                            devnum == d && is_block == streq(s, "block"))
-                                goto set_delaying_seqnum;
-                }
-
-                /* check network device ifindex */
-                if (ifindex > 0) {
-                        int i;
-
-                        if (sd_device_get_ifindex(loop_event->dev, &i) >= 0 &&
-                            ifindex == i)
-                                goto set_delaying_seqnum;
-                }
-
-                if (sd_device_get_devpath(loop_event->dev, &loop_devpath) < 0)
-                        continue;
-
-                /* check our old name */
-                if (devpath_old && streq(devpath_old, loop_devpath))
-                        goto set_delaying_seqnum;
-
-                loop_devpath_len = strlen(loop_devpath);
-
-                /* compare devpath */
-                common = MIN(devpath_len, loop_devpath_len);
-
-                /* one devpath is contained in the other? */
-                if (!strneq(devpath, loop_devpath, common))
+                if (b->entries->event->seqnum >= event->seqnum)
                         continue;
 
-                /* identical device event found */
-                if (devpath_len == loop_devpath_len)
-                        goto set_delaying_seqnum;
-
-                /* parent device event found */
-                if (devpath[common] == '/')
-                        goto set_delaying_seqnum;
-
-                /* child device event found */
-                if (loop_devpath[common] == '/')
-                        goto set_delaying_seqnum;
+                if (!blocker || b->entries->event->seqnum < blocker->seqnum)
+                        blocker = b->entries->event;
         }
 
-        return false;
+        if (!blocker)
+                return false;
 
-set_delaying_seqnum:
-        log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
-                         event->seqnum, loop_event->seqnum);
+        /* Only log when the event that blocks us changes, this is called on every queue run */
+        if (event->delaying_seqnum != blocker->seqnum) {
+                log_device_debug(event->dev, "SEQNUM=%" PRIu64 " blocked by SEQNUM=%" PRIu64,
+                                 event->seqnum, blocker->seqnum);
+                event->delaying_seqnum = blocker->seqnum;
+        }
 
-        event->delaying_seqnum = loop_event->seqnum;
         return true;
 }
 
@@ -875,6 +1029,7 @@ static void manager_exit(Manager *manager) {
 
         /* close sources of new events and discard buffered events */
         manager->ctrl = udev_ctrl_unref(manager->ctrl);
+        manager_close_queue_waiters(manager);
 
         manager->inotify_event = sd_event_source_unref(manager->inotify_event);
         manager->inotify_fd = safe_close(manager->inotify_fd);
@@ -896,7 +1051,14 @@ static void manager_reload(Manager *manager) {
                   "STATUS=Flushing configuration...");
 
         manager_kill_workers(manager, false);
-        manager->rules = udev_rules_free(manager->rules);
+
+        /* Re-parsing all rules, and resolving all user and group names in them again, is expensive. If
+         * none of the files that went into the current rules changed, keep them. */
+        if (udev_rules_sources_unmodified(manager->rules))
+                log_debug("Rules files and user/group databases are unchanged, keeping parsed rules.");
+        else
+                manager->rules = udev_rules_free(manager->rules);
+
         udev_builtin_exit();
 
         sd_notifyf(false,
@@ -1164,6 +1326,26 @@ static int on_ctrl_msg(struct udev_ctrl *uctrl, enum udev_ctrl_msg_type type, co
                 log_debug("Received udev control message (EXIT)");
                 manager_exit(manager);
                 break;
+        case UDEV_CTRL_WAIT_QUEUE_EMPTY: {
+                int fd;
+
+                log_debug("Received udev control message (WAIT_QUEUE_EMPTY)");
+
+                /* Keep the connection open until the queue is empty, see on_post(). */
+                if (!GREEDY_REALLOC(manager->queue_waiters, manager->n_queue_waiters + 1)) {
+                        log_oom();
+                        return 1;
+                }
+
+                fd = udev_ctrl_take_connection(uctrl);
+                if (fd < 0) {
+                        log_debug_errno(fd, "Failed to take over control connection, ignoring: %m");
+                        return 1;
+                }
+
+                manager->queue_waiters[manager->n_queue_waiters++] = fd;
+                break;
+        }
         default:
                 log_debug("Received unknown udev control message, ignoring");
         }
@@ -1424,7 +1606,13 @@ static int on_post(sd_event_source *s, void *userdata) {
         if (!LIST_IS_EMPTY(manager->events))
                 return 1;
 
-        /* There are no pending events. Let's cleanup idle process. */
+        /* There are no pending events. Let's wake up everyone who waits for that. */
+        if (manager->n_queue_waiters > 0) {
+                log_debug("Event queue is empty, notifying %zu waiting client(s).", manager->n_queue_waiters);
+                manager_close_queue_waiters(manager);
+        }
+
+        /* Let's cleanup idle process. */
 
         if (!hashmap_isempty(manager->workers)) {
                 /* There are idle workers */